@@ -107,7 +107,7 @@ namespace DirectXGame
 
 				if (mMain->Render())
 				{
-					mDeviceResources->Present();
+					mMain->Present();
 				}
 			}
 			else
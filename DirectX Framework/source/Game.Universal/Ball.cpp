@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Ball.h"
+#include "GameRules.h"
 
 using namespace DirectX;
 using namespace DX;
@@ -62,6 +63,8 @@ namespace DirectXGame
 
 	void Ball::CheckForFieldCollision()
 	{
+		DX_PROFILE_ZONE("Ball::CheckForFieldCollision");
+
 		auto field = mBallManager.ActiveField();
 		const auto& fieldPosition = field->Position();
 		const auto& fieldSize = field->Size();
@@ -88,7 +91,7 @@ namespace DirectXGame
 			updatedPosition.x = rightSide - mRadius;
 			hasCollidedWithField = true;
 		}
-		else if (position.y - mRadius <= -40)
+		else if (position.y - mRadius <= GameRules::BallBottomZone)
 		{
 			//Checking to see if the ball has collided with the bar
 			float barCollision = mBarManager.HandleBallCollision(position, mRadius, mVelocity.x);
@@ -100,7 +103,7 @@ namespace DirectXGame
 				hasCollidedWithField = true;
 			}
 		}
-		else if (position.y + mRadius >= 22)
+		else if (position.y + mRadius >= GameRules::ChunkZone)
 		{
 			//Checking to see if the ball has collided with a chunk
 			float chunkCollision = mChunkManager.HandleBallCollision(position, mRadius);
@@ -119,7 +122,7 @@ namespace DirectXGame
 			}
 		}
 		
-		if (position.y - mRadius <= -60)
+		if (position.y - mRadius <= GameRules::BallLostY)
 		{
 			mBallManager.BallOffscreen();
 		}
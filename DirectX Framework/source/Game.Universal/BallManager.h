@@ -14,15 +14,17 @@ namespace DirectXGame
 	class BallManager final : public DX::DrawableGameComponent
 	{
 	public:
-		BallManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, ChunkManager& chunkManager, BarManager& barManager);
+		BallManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, const std::shared_ptr<DX::D3D11RenderBackend>& renderBackend, const std::shared_ptr<DX::PipelineCache>& pipelineCache, ChunkManager& chunkManager, BarManager& barManager);
 
 		std::shared_ptr<Field> ActiveField() const;
 		void SetActiveField(const std::shared_ptr<Field>& field);
 
+		std::shared_ptr<Ball> ActiveBall() const;
+
 		virtual void CreateDeviceDependentResources() override;
 		virtual void ReleaseDeviceDependentResources() override;
 		virtual void Update(const DX::StepTimer& timer) override;
-		virtual void Render(const DX::StepTimer& timer) override;
+		virtual void RecordDraws(const DX::StepTimer& timer, DX::RenderCommandList& commandList) override;
 
 		void IncreaseBallVelocity();
 		void DecreaseBallVelocity();
@@ -32,22 +34,15 @@ namespace DirectXGame
 		void BallOffscreen();
 
 	private:
-		void InitializeLineVertices();
 		void InitializeTriangleVertices();
 		void InitializeBall();
-		void DrawSolidBall(const Ball& ball);
-
-		static const std::uint32_t CircleResolution;
-		static const std::uint32_t LineCircleVertexCount;
-		static const std::uint32_t SolidCircleVertexCount;
+		void DrawSolidBall(const Ball& ball, DX::RenderCommandList& commandList);
 
-		Microsoft::WRL::ComPtr<ID3D11VertexShader> mVertexShader;
-		Microsoft::WRL::ComPtr<ID3D11PixelShader> mPixelShader;
-		Microsoft::WRL::ComPtr<ID3D11InputLayout> mInputLayout;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mLineVertexBuffer;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> mTriangleVertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mVSCBufferPerObject;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mPSCBufferPerObject;
+		std::shared_ptr<DX::D3D11RenderBackend> mRenderBackend;
+		std::shared_ptr<DX::PipelineCache> mPipelineCache;
+		std::shared_ptr<const DX::PipelineCache::Pipeline> mPipeline;
+		DX::MeshHandle mTriangleMesh;
 
 		bool mLoadingComplete;
 		bool mBallLaunched;
@@ -55,8 +50,6 @@ namespace DirectXGame
 		std::shared_ptr<Field> mActiveField;
 		ChunkManager& mChunkManager;
 		BarManager& mBarManager;
-
-		const DirectX::XMFLOAT2 mInitialVelocity = DirectX::XMFLOAT2(17.0f, 17.0f);
 	};
 }
 
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Bar.h"
+#include "GameRules.h"
 
 using namespace DirectX;
 using namespace DX;
@@ -34,7 +35,7 @@ namespace DirectXGame
 
 	const float& Bar::Width() const
 	{
-		return mWidth;
+		return GameRules::BarHalfWidth;
 	}
 
 	const XMFLOAT4& Bar::Color() const
@@ -75,15 +76,15 @@ namespace DirectXGame
 		XMFLOAT2 updatedPosition = position;
 		bool hasCollidedWithField = false;
 
-		if (position.x - mWidth <= mFieldLeftSide)
+		if (position.x - GameRules::BarHalfWidth <= GameRules::BarLeftLimit)
 		{
-			updatedPosition.x = mFieldLeftSide + mWidth;
+			updatedPosition.x = GameRules::BarLeftLimit + GameRules::BarHalfWidth;
 			hasCollidedWithField = true;
 		}
 
-		if (position.x + mWidth >= mFieldRightSide)
+		if (position.x + GameRules::BarHalfWidth >= GameRules::BarRightLimit)
 		{
-			updatedPosition.x = mFieldRightSide - mWidth;
+			updatedPosition.x = GameRules::BarRightLimit - GameRules::BarHalfWidth;
 			hasCollidedWithField = true;
 		}
 
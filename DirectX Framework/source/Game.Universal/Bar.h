@@ -47,10 +47,6 @@ namespace DirectXGame
 		float mRadius;
 		DirectX::XMFLOAT4 mColor;
 		DirectX::XMFLOAT2 mVelocity;
-
-		const float mWidth = 4.0f;
-		const float mFieldRightSide = 40.0f;
-		const float mFieldLeftSide = -52.0f;
 	};
 }
 
@@ -0,0 +1,35 @@
+#include "pch.h"
+#include "BarAutopilot.h"
+
+namespace DirectXGame
+{
+	float BarAutopilot::PredictLandingX(const State& state)
+	{
+		return GameRules::PredictLandingX(ToAutopilotState(state));
+	}
+
+	BarAutopilot::Command BarAutopilot::Decide(const State& state)
+	{
+		return GameRules::DecideAutopilot(ToAutopilotState(state));
+	}
+
+	GameRules::AutopilotState BarAutopilot::ToAutopilotState(const State& state)
+	{
+		GameRules::AutopilotState autopilotState;
+		autopilotState.BallX = state.BallPosition.x;
+		autopilotState.BallY = state.BallPosition.y;
+		autopilotState.BallVelocityX = state.BallVelocity.x;
+		autopilotState.BallVelocityY = state.BallVelocity.y;
+		autopilotState.BallRadius = state.BallRadius;
+		autopilotState.BarX = state.BarX;
+
+		// Center the bar's catch span under the landing point.
+		autopilotState.AimX = state.BarWidth / 2.0f;
+		autopilotState.CatchY = state.CatchY;
+		autopilotState.FieldLeft = state.FieldLeft;
+		autopilotState.FieldRight = state.FieldRight;
+		autopilotState.FieldTop = state.FieldTop;
+
+		return autopilotState;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "GameRules.h"
+#include <DirectXMath.h>
+
+namespace DirectXGame
+{
+	// Steers the bar toward the point where the ball will next reach the bar's catch line, centering the bar under it.
+	// The prediction and the decision are GameRules's, shared with the headless simulations; this class feeds them the
+	// live game's state.
+	class BarAutopilot final
+	{
+	public:
+		typedef GameRules::AutopilotCommand Command;
+
+		// Everything the autopilot needs to know about one game, in the game's world units.
+		struct State
+		{
+			DirectX::XMFLOAT2 BallPosition;
+			DirectX::XMFLOAT2 BallVelocity;
+			float BallRadius;
+			float BarX;			// Left edge of the bar's catch span
+			float BarWidth;		// Width of the bar's catch span
+			float CatchY;		// Ball center height at which the bar catches it
+			float FieldLeft;
+			float FieldRight;
+			float FieldTop;
+		};
+
+		// Returns the ball's x coordinate when it next descends to CatchY, bouncing off the side walls and, when the ball
+		// is rising, off the top of the field.
+		static float PredictLandingX(const State& state);
+
+		static Command Decide(const State& state);
+
+		BarAutopilot() = delete;
+		BarAutopilot(const BarAutopilot&) = delete;
+		BarAutopilot& operator=(const BarAutopilot&) = delete;
+		BarAutopilot(BarAutopilot&&) = delete;
+		BarAutopilot& operator=(BarAutopilot&&) = delete;
+		~BarAutopilot() = default;
+
+	private:
+		static GameRules::AutopilotState ToAutopilotState(const State& state);
+	};
+}
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "BarManager.h"
 #include "Bar.h"
+#include "ParticleManager.h"
+#include "GameRules.h"
 
 using namespace std;
 using namespace DirectX;
@@ -8,13 +10,19 @@ using namespace DX;
 
 namespace DirectXGame
 {
-	const uint32_t BarManager::CircleResolution = 32;
-	const uint32_t BarManager::SolidCircleVertexCount = (BarManager::CircleResolution + 1) * 2;
+	namespace
+	{
+		// The bar's rectangle with rounded corners at every level, built by the compiler.
+		constexpr float CornerRadius = 0.75f;
+		constexpr ShapeMeshes::RoundedRects RectMeshes = ShapeMeshes::MakeRoundedRects(0.0f, -40.0f, 8.0f, -38.0f, CornerRadius);
+		static_assert(sizeof(ShapeVertex) == sizeof(VertexPosition), "Shape vertices are uploaded as VertexPosition.");
+	}
 
-	BarManager::BarManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera) :
-		DrawableGameComponent(deviceResources, camera), mLoadingComplete(false)
+	BarManager::BarManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera, const shared_ptr<D3D11RenderBackend>& renderBackend, const shared_ptr<PipelineCache>& pipelineCache,
+		ParticleManager& particleManager) :
+		DrawableGameComponent(deviceResources, camera), mRenderBackend(renderBackend), mPipelineCache(pipelineCache),
+		mTriangleMesh(RenderCommandList::InvalidMesh), mLoadingComplete(false), mParticleManager(particleManager)
 	{
-		CreateDeviceDependentResources();
 	}
 
 	std::shared_ptr<Field> BarManager::ActiveField() const
@@ -29,69 +37,18 @@ namespace DirectXGame
 
 	void BarManager::CreateDeviceDependentResources()
 	{
-		auto loadVSTask = ReadDataAsync(L"ShapeRendererVS.cso");
-		auto loadPSTask = ReadDataAsync(L"ShapeRendererPS.cso");
-
-		// After the vertex shader file is loaded, create the shader and input layout.
-		auto createVSTask = loadVSTask.then([this](const std::vector<byte>& fileData) {
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateVertexShader(
-					&fileData[0],
-					fileData.size(),
-					nullptr,
-					mVertexShader.ReleaseAndGetAddressOf()
-				)
-			);
-
-			// Create an input layout
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateInputLayout(
-					VertexPosition::InputElements,
-					VertexPosition::InputElementCount,
-					&fileData[0],
-					fileData.size(),
-					mInputLayout.ReleaseAndGetAddressOf()
-				)
-			);
-
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4X4), D3D11_BIND_CONSTANT_BUFFER);
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateBuffer(
-					&constantBufferDesc,
-					nullptr,
-					mVSCBufferPerObject.ReleaseAndGetAddressOf()
-				)
-			);
-		});
+		const PipelineCache::Description description = { L"ShapeRendererVS.cso", L"ShapeRendererPS.cso", VertexPosition::InputElements, VertexPosition::InputElementCount,
+			D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, sizeof(XMFLOAT4X4), sizeof(XMFLOAT4) };
 
-		// After the pixel shader file is loaded, create the shader and constant buffer.
-		auto createPSTask = loadPSTask.then([this](const std::vector<byte>& fileData) {
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreatePixelShader(
-					&fileData[0],
-					fileData.size(),
-					nullptr,
-					mPixelShader.ReleaseAndGetAddressOf()
-				)
-			);
-
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4), D3D11_BIND_CONSTANT_BUFFER);
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateBuffer(
-					&constantBufferDesc,
-					nullptr,
-					mPSCBufferPerObject.ReleaseAndGetAddressOf()
-				)
-			);
-		});
-
-		auto createVerticesAndBallsTask = (createPSTask && createVSTask).then([this]() {
+		// The shape shaders are shared with the other managers; the cache loads them once.
+		mPipelineCache->GetPipelineAsync(description).then([this](const shared_ptr<const PipelineCache::Pipeline>& pipeline) {
+			mPipeline = pipeline;
 			InitializeTriangleVertices();
 			InitializeBar();
-		});
 
-		// Once the cube is loaded, the object is ready to be rendered.
-		createVerticesAndBallsTask.then([this]() {
+			const D3D11RenderBackend::Mesh triangleMesh = { mTriangleVertexBuffer, sizeof(VertexPosition) };
+			mTriangleMesh = mRenderBackend->CreateMesh(triangleMesh);
+
 			mLoadingComplete = true;
 		});
 	}
@@ -99,20 +56,21 @@ namespace DirectXGame
 	void BarManager::ReleaseDeviceDependentResources()
 	{
 		mLoadingComplete = false;
-		mVertexShader.Reset();
-		mPixelShader.Reset();
-		mInputLayout.Reset();
 		mTriangleVertexBuffer.Reset();
-		mVSCBufferPerObject.Reset();
-		mPSCBufferPerObject.Reset();
+		mPipeline.reset();
+		mRenderBackend->ReleaseMesh(mTriangleMesh);
 	}
 
 	void BarManager::Update(const StepTimer& timer)
 	{
 		mBar->Update(timer);
+
+		// Once the bar has moved, so RecordDraws only reads its world matrix.
+		const Transform2D* transform = &mBar->Transform();
+		Transform2D::UpdateWorldMatrices(&transform, 1);
 	}
 
-	void BarManager::Render(const StepTimer & timer)
+	void BarManager::RecordDraws(const StepTimer& timer, RenderCommandList& commandList)
 	{
 		UNREFERENCED_PARAMETER(timer);
 
@@ -122,16 +80,11 @@ namespace DirectXGame
 			return;
 		}
 
-		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
-		direct3DDeviceContext->IASetInputLayout(mInputLayout.Get());
-
-		direct3DDeviceContext->VSSetShader(mVertexShader.Get(), nullptr, 0);
-		direct3DDeviceContext->PSSetShader(mPixelShader.Get(), nullptr, 0);
+		commandList.SetLayer(ShapeLayer);
+		commandList.SetPipeline(mPipeline->Handle);
+		commandList.SetMesh(mTriangleMesh);
 
-		direct3DDeviceContext->VSSetConstantBuffers(0, 1, mVSCBufferPerObject.GetAddressOf());
-		direct3DDeviceContext->PSSetConstantBuffers(0, 1, mPSCBufferPerObject.GetAddressOf());
-
-		DrawBar(*mBar);
+		DrawBar(*mBar, commandList);
 	}
 
 	void BarManager::MoveRight()
@@ -158,13 +111,18 @@ namespace DirectXGame
 
 	float BarManager::HandleBallCollision(const DirectX::XMFLOAT2& ballPosition, const float& ballRadius, float& ballXVelocity)
 	{
+		DX_PROFILE_ZONE("BarManager::HandleBallCollision");
+
 		float hitPosition = 0.0f;
 
-		if ((ballPosition.y - ballRadius + 57) <= mBar->Position().y)
+		if ((ballPosition.y - ballRadius + GameRules::BarCatchOffset) <= mBar->Position().y)
 		{
-			if (mBar->Position().x <= (ballPosition.x - ballRadius) && (ballPosition.x + ballRadius) <= (mBar->Position().x + (mBar->Width() * 2)))
+			if (mBar->Position().x <= (ballPosition.x - ballRadius) && (ballPosition.x + ballRadius) <= (mBar->Position().x + GameRules::BarCatchWidth))
 			{
-				hitPosition = mBar->Position().y - 54;
+				hitPosition = mBar->Position().y - GameRules::BarReboundOffset;
+
+				// From where the ball meets the top of the bar's quad.
+				mParticleManager.EmitBounce(XMFLOAT2(ballPosition.x, mBar->Position().y - 38.0f * mBar->Radius()));
 
 				if (ballPosition.x <= (mBar->Position().x + mBar->Width()) && ballXVelocity > 0)
 				{
@@ -182,9 +140,11 @@ namespace DirectXGame
 
 	bool BarManager::HandlePowerupCollision(const DirectX::XMFLOAT2& powerupPosition, const float& powerupWidth)
 	{
+		DX_PROFILE_ZONE("BarManager::HandlePowerupCollision");
+
 		float powerupCenterX = powerupPosition.x + (powerupWidth / 2);
 
-		if (mBar->Position().x <= powerupCenterX && powerupCenterX <= (mBar->Position().x + mBarWidth))
+		if (mBar->Position().x <= powerupCenterX && powerupCenterX <= (mBar->Position().x + GameRules::BarCatchWidth))
 		{
 			return true;
 		}
@@ -194,88 +154,62 @@ namespace DirectXGame
 
 	const std::int32_t BarManager::BarUpperY() const
 	{
-		return mBarY;
+		return static_cast<int32_t>(GameRules::BarY);
 	}
 
 	const std::int32_t BarManager::BarLowerY() const
 	{
-		return (mBarY - mBarHeight);
+		return static_cast<int32_t>(GameRules::BarY - GameRules::BarHeight);
 	}
 
-	void BarManager::IncreaseBarVelocity()
+	const XMFLOAT2& BarManager::BarPosition() const
 	{
-		mBar->SetVelocity(XMFLOAT2((mBar->Velocity().x + 30), mBar->Velocity().y));
+		return mBar->Position();
 	}
 
-	void BarManager::DecreaseBarVelocity()
+	// Width of the span, starting at the bar's x position, that the ball must be entirely within to be caught.
+	float BarManager::BarCatchWidth() const
 	{
-		mBar->SetVelocity(XMFLOAT2((mBar->Velocity().x - 5), mBar->Velocity().y));
+		return GameRules::BarCatchWidth;
 	}
 
-	void BarManager::DrawBar(const Bar & bar)
+	// Height the bottom of the ball must reach for the bar to catch it (see HandleBallCollision).
+	float BarManager::CatchLineY() const
 	{
-		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
-		direct3DDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+		return mBar->Position().y - GameRules::BarCatchOffset;
+	}
 
-		static const UINT stride = sizeof(VertexPosition);
-		static const UINT offset = 0;
-		direct3DDeviceContext->IASetVertexBuffers(0, 1, mTriangleVertexBuffer.GetAddressOf(), &stride, &offset);
+	void BarManager::IncreaseBarVelocity()
+	{
+		mBar->SetVelocity(XMFLOAT2((mBar->Velocity().x + GameRules::PowerupBarSpeedIncrease), mBar->Velocity().y));
+	}
 
-		const XMMATRIX wvp = XMMatrixTranspose(XMMatrixScaling(bar.Radius(), bar.Radius(), bar.Radius()) * bar.Transform().WorldMatrix() * mCamera->ViewProjectionMatrix());
-		direct3DDeviceContext->UpdateSubresource(mVSCBufferPerObject.Get(), 0, nullptr, reinterpret_cast<const float*>(wvp.r), 0, 0);
+	void BarManager::DecreaseBarVelocity()
+	{
+		mBar->SetVelocity(XMFLOAT2((mBar->Velocity().x - GameRules::PowerupBarSpeedDecrease), mBar->Velocity().y));
+	}
 
-		direct3DDeviceContext->UpdateSubresource(mPSCBufferPerObject.Get(), 0, nullptr, &bar.Color(), 0, 0);
+	void BarManager::DrawBar(const Bar& bar, RenderCommandList& commandList)
+	{
+		XMFLOAT4X4 wvp;
+		XMStoreFloat4x4(&wvp, XMMatrixTranspose(XMMatrixScaling(bar.Radius(), bar.Radius(), bar.Radius()) * bar.Transform().WorldMatrix() * mCamera->ViewProjectionMatrix()));
+		commandList.SetConstants(ShaderStage::Vertex, wvp);
+		commandList.SetConstants(ShaderStage::Pixel, bar.Color());
 
-		direct3DDeviceContext->Draw(SolidCircleVertexCount, 0);
+		// The corners are scaled with the rest of the shape.
+		const ShapeLod lod = ShapeMeshes::RoundedRectLod(ShapeMeshes::SelectRoundedRectLod(CornerRadius * bar.Radius() * PixelsPerWorldUnit()));
+		commandList.Draw(lod.VertexCount, lod.StartVertex);
 	}
 
 	void BarManager::InitializeTriangleVertices()
 	{
-		vector<VertexPosition> vertices;
-		vertices.reserve(4);
-
-		//Top left vertex
-		VertexPosition topLeft;
-		topLeft.Position.x = 0;
-		topLeft.Position.y = -38;
-		topLeft.Position.z = 0.0f;
-		topLeft.Position.w = 1.0f;
-
-		//Top right vertex
-		VertexPosition topRight;
-		topRight.Position.x = 8;
-		topRight.Position.y = -38;
-		topRight.Position.z = 0.0f;
-		topRight.Position.w = 1.0f;
-
-		//Bottom right vertex
-		VertexPosition bottomLeft;
-		bottomLeft.Position.x = 8;
-		bottomLeft.Position.y = -40;
-		bottomLeft.Position.z = 0.0f;
-		bottomLeft.Position.w = 1.0f;
-
-		//Bottom left vertex
-		VertexPosition bottomRight;
-		bottomRight.Position.x = 0;
-		bottomRight.Position.y = -40;
-		bottomRight.Position.z = 0.0f;
-		bottomRight.Position.w = 1.0f;
-
-		vertices.push_back(topLeft);
-		vertices.push_back(topRight);
-		vertices.push_back(bottomRight);
-		vertices.push_back(bottomLeft);
-
-		assert(vertices.size() == 4);
-
 		D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
-		vertexBufferDesc.ByteWidth = sizeof(VertexPosition) * static_cast<uint32_t>(vertices.size());
+		vertexBufferDesc.ByteWidth = sizeof(RectMeshes);
 		vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
 		vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
 		D3D11_SUBRESOURCE_DATA vertexSubResourceData = { 0 };
-		vertexSubResourceData.pSysMem = &vertices[0];
+		vertexSubResourceData.pSysMem = &RectMeshes;
 		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&vertexBufferDesc, &vertexSubResourceData, mTriangleVertexBuffer.ReleaseAndGetAddressOf()));
 	}
 
@@ -284,8 +218,8 @@ namespace DirectXGame
 		const float rotation = 0.0f;
 		const float radius = 1.5f;
 		const XMFLOAT4 color(&Colors::CornflowerBlue[0]);
-		const XMFLOAT2 velocity(20, 0);
-		const XMFLOAT2 position(-(float)(mBarWidth / 2 + 2), 15);
+		const XMFLOAT2 velocity(GameRules::BarStartSpeed, 0);
+		const XMFLOAT2 position(GameRules::BarStartX, GameRules::BarY);
 
 		mBar = make_shared<Bar>(*this, Transform2D(position), radius, color, velocity);
 	}
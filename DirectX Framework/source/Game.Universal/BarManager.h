@@ -8,11 +8,13 @@ namespace DirectXGame
 {
 	class Bar;
 	class Field;
+	class ParticleManager;
 
 	class BarManager final : public DX::DrawableGameComponent
 	{
 	public:
-		BarManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera);
+		BarManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, const std::shared_ptr<DX::D3D11RenderBackend>& renderBackend, const std::shared_ptr<DX::PipelineCache>& pipelineCache,
+			ParticleManager& particleManager);
 
 		std::shared_ptr<Field> ActiveField() const;
 		void SetActiveField(const std::shared_ptr<Field>& field);
@@ -20,7 +22,7 @@ namespace DirectXGame
 		virtual void CreateDeviceDependentResources() override;
 		virtual void ReleaseDeviceDependentResources() override;
 		virtual void Update(const DX::StepTimer& timer) override;
-		virtual void Render(const DX::StepTimer& timer) override;
+		virtual void RecordDraws(const DX::StepTimer& timer, DX::RenderCommandList& commandList) override;
 
 		void MoveRight();
 		void MoveLeft();
@@ -31,30 +33,27 @@ namespace DirectXGame
 		const std::int32_t BarUpperY() const;
 		const std::int32_t BarLowerY() const;
 
+		const DirectX::XMFLOAT2& BarPosition() const;
+		float BarCatchWidth() const;
+		float CatchLineY() const;
+
 		void IncreaseBarVelocity();
 		void DecreaseBarVelocity();
 
 	private:
 		void InitializeTriangleVertices();
 		void InitializeBar();
-		void DrawBar(const Bar& bar);
-
-		static const std::uint32_t CircleResolution;
-		static const std::uint32_t SolidCircleVertexCount;
+		void DrawBar(const Bar& bar, DX::RenderCommandList& commandList);
 
-		Microsoft::WRL::ComPtr<ID3D11VertexShader> mVertexShader;
-		Microsoft::WRL::ComPtr<ID3D11PixelShader> mPixelShader;
-		Microsoft::WRL::ComPtr<ID3D11InputLayout> mInputLayout;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> mTriangleVertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mVSCBufferPerObject;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mPSCBufferPerObject;
+		std::shared_ptr<DX::D3D11RenderBackend> mRenderBackend;
+		std::shared_ptr<DX::PipelineCache> mPipelineCache;
+		std::shared_ptr<const DX::PipelineCache::Pipeline> mPipeline;
+		DX::MeshHandle mTriangleMesh;
 
 		bool mLoadingComplete;
 		std::shared_ptr<Bar> mBar;
 		std::shared_ptr<Field> mActiveField;
-
-		const std::int32_t mBarY = 15;
-		const std::int32_t mBarHeight = 2;
-		const std::int32_t mBarWidth = 8;
+		ParticleManager& mParticleManager;
 	};
 }
\ No newline at end of file
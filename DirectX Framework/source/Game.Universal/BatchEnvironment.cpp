@@ -0,0 +1,471 @@
+#include "BatchEnvironment.h"
+#include <algorithm>
+#include <bitset>
+
+#if !defined(DX_BATCH_ENVIRONMENT_SCALAR) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define DX_BATCH_ENVIRONMENT_SSE2
+#include <emmintrin.h>
+#elif !defined(DX_BATCH_ENVIRONMENT_SCALAR) && (defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON))
+#define DX_BATCH_ENVIRONMENT_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace DirectXGame
+{
+	namespace
+	{
+		const uint64_t AllChunks = (static_cast<uint64_t>(1) << BatchEnvironment::ChunkCount) - 1;
+
+		static_assert(BatchEnvironment::None == static_cast<uint8_t>(GameRules::AutopilotCommand::None) &&
+			BatchEnvironment::MoveLeft == static_cast<uint8_t>(GameRules::AutopilotCommand::MoveLeft) &&
+			BatchEnvironment::MoveRight == static_cast<uint8_t>(GameRules::AutopilotCommand::MoveRight), "Actions are passed to GameRules::StepBar as they are");
+
+		inline uint32_t NextRandom(uint32_t& state)
+		{
+			// xorshift32
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		// Arrays handed to the four-wide helpers below are read and written at index i through i + 3.
+		struct Arrays
+		{
+			const uint8_t* Actions;
+			float* BallX;
+			float* BallY;
+			float* BallVelocityX;
+			float* BallVelocityY;
+			float* BarX;
+			float* BarVelocityX;
+			uint8_t* InChunkZone;
+			uint8_t* BallLost;
+		};
+
+		// GameRules::StepBar and StepBall for one environment. The chunks and the top of the field are handled afterwards,
+		// for the few environments whose ball is up there.
+		inline void StepOne(const Arrays& arrays, uint32_t i)
+		{
+			GameRules::PlayState state = { arrays.BallX[i], arrays.BallY[i], arrays.BallVelocityX[i], arrays.BallVelocityY[i], arrays.BarX[i], arrays.BarVelocityX[i] };
+			GameRules::StepBar(state, static_cast<GameRules::AutopilotCommand>(arrays.Actions[i]));
+			const GameRules::BallStepResult result = GameRules::StepBall(state);
+
+			arrays.BallX[i] = state.BallX;
+			arrays.BallY[i] = state.BallY;
+			arrays.BallVelocityX[i] = state.BallVelocityX;
+			arrays.BallVelocityY[i] = state.BallVelocityY;
+			arrays.BarX[i] = state.BarX;
+			arrays.BarVelocityX[i] = state.BarVelocityX;
+			arrays.InChunkZone[i] = (result.InChunkZone ? 1 : 0);
+			arrays.BallLost[i] = (result.Lost ? 1 : 0);
+		}
+
+		// Step4 is StepOne for four environments, with every branch of StepBar and StepBall turned into a mask and a select
+		// so all four lanes take the same path. The arithmetic is the same and in the same order, so each lane's result is
+		// StepOne's, bit for bit. The compilers don't do this themselves: the branches in StepBall keep the scalar loop
+		// from vectorizing.
+#if defined(DX_BATCH_ENVIRONMENT_SSE2)
+		inline __m128 Select(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+		}
+
+		inline void Step4(const Arrays& arrays, uint32_t i)
+		{
+			const __m128 signBit = _mm_set1_ps(-0.0f);
+			const __m128 seconds = _mm_set1_ps(GameRules::StepSeconds);
+			const __m128 radius = _mm_set1_ps(GameRules::BallRadius);
+			const __m128 halfWidth = _mm_set1_ps(GameRules::BarHalfWidth);
+
+			// GameRules::StepBar
+			const __m128i action = _mm_setr_epi32(arrays.Actions[i], arrays.Actions[i + 1], arrays.Actions[i + 2], arrays.Actions[i + 3]);
+			const __m128 moveRight = _mm_castsi128_ps(_mm_cmpeq_epi32(action, _mm_set1_epi32(BatchEnvironment::MoveRight)));
+			const __m128 moveLeft = _mm_castsi128_ps(_mm_cmpeq_epi32(action, _mm_set1_epi32(BatchEnvironment::MoveLeft)));
+			const __m128 moving = _mm_or_ps(moveRight, moveLeft);
+
+			const __m128 barVelocityX = _mm_loadu_ps(arrays.BarVelocityX + i);
+			const __m128 barSpeed = _mm_andnot_ps(signBit, barVelocityX);
+			const __m128 barVelocity = Select(moveRight, barSpeed, Select(moveLeft, _mm_xor_ps(barSpeed, signBit), barVelocityX));
+			const __m128 barX = _mm_loadu_ps(arrays.BarX + i);
+			__m128 bar = _mm_add_ps(barX, _mm_mul_ps(barVelocity, seconds));
+			bar = Select(_mm_cmple_ps(_mm_sub_ps(bar, halfWidth), _mm_set1_ps(GameRules::BarLeftLimit)), _mm_set1_ps(GameRules::BarLeftLimit + GameRules::BarHalfWidth), bar);
+			bar = Select(_mm_cmpge_ps(_mm_add_ps(bar, halfWidth), _mm_set1_ps(GameRules::BarRightLimit)), _mm_set1_ps(GameRules::BarRightLimit - GameRules::BarHalfWidth), bar);
+			bar = Select(moving, bar, barX);
+			_mm_storeu_ps(arrays.BarX + i, bar);
+			_mm_storeu_ps(arrays.BarVelocityX + i, barVelocity);
+
+			// GameRules::StepBall
+			__m128 velocityX = _mm_loadu_ps(arrays.BallVelocityX + i);
+			__m128 velocityY = _mm_loadu_ps(arrays.BallVelocityY + i);
+			__m128 x = _mm_add_ps(_mm_loadu_ps(arrays.BallX + i), _mm_mul_ps(velocityX, seconds));
+			__m128 y = _mm_add_ps(_mm_loadu_ps(arrays.BallY + i), _mm_mul_ps(velocityY, seconds));
+
+			const __m128 leftWall = _mm_cmple_ps(_mm_sub_ps(x, radius), _mm_set1_ps(GameRules::FieldLeft));
+			const __m128 rightWall = _mm_andnot_ps(leftWall, _mm_cmpge_ps(_mm_add_ps(x, radius), _mm_set1_ps(GameRules::FieldRight)));
+			const __m128 sideWall = _mm_or_ps(leftWall, rightWall);
+			const __m128 bottom = _mm_andnot_ps(sideWall, _mm_cmple_ps(_mm_sub_ps(y, radius), _mm_set1_ps(GameRules::BallBottomZone)));
+			const __m128 top = _mm_andnot_ps(_mm_or_ps(sideWall, bottom), _mm_cmpge_ps(_mm_add_ps(y, radius), _mm_set1_ps(GameRules::ChunkZone)));
+			const __m128 lost = _mm_cmple_ps(_mm_sub_ps(y, radius), _mm_set1_ps(GameRules::BallLostY));
+
+			x = Select(leftWall, _mm_set1_ps(GameRules::FieldLeft + GameRules::BallRadius), Select(rightWall, _mm_set1_ps(GameRules::FieldRight - GameRules::BallRadius), x));
+			velocityX = _mm_xor_ps(velocityX, _mm_and_ps(sideWall, signBit));
+
+			const __m128 caught = _mm_and_ps(_mm_and_ps(bottom, _mm_cmple_ps(_mm_add_ps(_mm_sub_ps(y, radius), _mm_set1_ps(GameRules::BarCatchOffset)), _mm_set1_ps(GameRules::BarY))),
+				_mm_and_ps(_mm_cmple_ps(bar, _mm_sub_ps(x, radius)), _mm_cmple_ps(_mm_add_ps(x, radius), _mm_add_ps(bar, _mm_set1_ps(GameRules::BarCatchWidth)))));
+			const __m128 leftHalf = _mm_cmple_ps(x, _mm_add_ps(bar, halfWidth));
+			const __m128 turn = _mm_and_ps(caught, _mm_or_ps(_mm_and_ps(leftHalf, _mm_cmpgt_ps(velocityX, _mm_setzero_ps())),
+				_mm_andnot_ps(leftHalf, _mm_cmplt_ps(velocityX, _mm_setzero_ps()))));
+			velocityX = _mm_xor_ps(velocityX, _mm_and_ps(turn, signBit));
+			velocityY = _mm_xor_ps(velocityY, _mm_and_ps(caught, signBit));
+			y = Select(caught, _mm_set1_ps(GameRules::BarY - GameRules::BarReboundOffset), y);
+
+			_mm_storeu_ps(arrays.BallX + i, x);
+			_mm_storeu_ps(arrays.BallY + i, y);
+			_mm_storeu_ps(arrays.BallVelocityX + i, velocityX);
+			_mm_storeu_ps(arrays.BallVelocityY + i, velocityY);
+
+			const int topBits = _mm_movemask_ps(top);
+			const int lostBits = _mm_movemask_ps(lost);
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				arrays.InChunkZone[i + lane] = static_cast<uint8_t>((topBits >> lane) & 1);
+				arrays.BallLost[i + lane] = static_cast<uint8_t>((lostBits >> lane) & 1);
+			}
+		}
+#elif defined(DX_BATCH_ENVIRONMENT_NEON)
+		inline void Step4(const Arrays& arrays, uint32_t i)
+		{
+			const float32x4_t seconds = vdupq_n_f32(GameRules::StepSeconds);
+			const float32x4_t radius = vdupq_n_f32(GameRules::BallRadius);
+			const float32x4_t halfWidth = vdupq_n_f32(GameRules::BarHalfWidth);
+
+			// GameRules::StepBar
+			const uint32_t actions[4] = { arrays.Actions[i], arrays.Actions[i + 1], arrays.Actions[i + 2], arrays.Actions[i + 3] };
+			const uint32x4_t action = vld1q_u32(actions);
+			const uint32x4_t moveRight = vceqq_u32(action, vdupq_n_u32(BatchEnvironment::MoveRight));
+			const uint32x4_t moveLeft = vceqq_u32(action, vdupq_n_u32(BatchEnvironment::MoveLeft));
+			const uint32x4_t moving = vorrq_u32(moveRight, moveLeft);
+
+			const float32x4_t barVelocityX = vld1q_f32(arrays.BarVelocityX + i);
+			const float32x4_t barSpeed = vabsq_f32(barVelocityX);
+			const float32x4_t barVelocity = vbslq_f32(moveRight, barSpeed, vbslq_f32(moveLeft, vnegq_f32(barSpeed), barVelocityX));
+			const float32x4_t barX = vld1q_f32(arrays.BarX + i);
+			float32x4_t bar = vaddq_f32(barX, vmulq_f32(barVelocity, seconds));
+			bar = vbslq_f32(vcleq_f32(vsubq_f32(bar, halfWidth), vdupq_n_f32(GameRules::BarLeftLimit)), vdupq_n_f32(GameRules::BarLeftLimit + GameRules::BarHalfWidth), bar);
+			bar = vbslq_f32(vcgeq_f32(vaddq_f32(bar, halfWidth), vdupq_n_f32(GameRules::BarRightLimit)), vdupq_n_f32(GameRules::BarRightLimit - GameRules::BarHalfWidth), bar);
+			bar = vbslq_f32(moving, bar, barX);
+			vst1q_f32(arrays.BarX + i, bar);
+			vst1q_f32(arrays.BarVelocityX + i, barVelocity);
+
+			// GameRules::StepBall
+			float32x4_t velocityX = vld1q_f32(arrays.BallVelocityX + i);
+			float32x4_t velocityY = vld1q_f32(arrays.BallVelocityY + i);
+			float32x4_t x = vaddq_f32(vld1q_f32(arrays.BallX + i), vmulq_f32(velocityX, seconds));
+			float32x4_t y = vaddq_f32(vld1q_f32(arrays.BallY + i), vmulq_f32(velocityY, seconds));
+
+			const uint32x4_t leftWall = vcleq_f32(vsubq_f32(x, radius), vdupq_n_f32(GameRules::FieldLeft));
+			const uint32x4_t rightWall = vbicq_u32(vcgeq_f32(vaddq_f32(x, radius), vdupq_n_f32(GameRules::FieldRight)), leftWall);
+			const uint32x4_t sideWall = vorrq_u32(leftWall, rightWall);
+			const uint32x4_t bottom = vbicq_u32(vcleq_f32(vsubq_f32(y, radius), vdupq_n_f32(GameRules::BallBottomZone)), sideWall);
+			const uint32x4_t top = vbicq_u32(vcgeq_f32(vaddq_f32(y, radius), vdupq_n_f32(GameRules::ChunkZone)), vorrq_u32(sideWall, bottom));
+			const uint32x4_t lost = vcleq_f32(vsubq_f32(y, radius), vdupq_n_f32(GameRules::BallLostY));
+
+			x = vbslq_f32(leftWall, vdupq_n_f32(GameRules::FieldLeft + GameRules::BallRadius), vbslq_f32(rightWall, vdupq_n_f32(GameRules::FieldRight - GameRules::BallRadius), x));
+			velocityX = vbslq_f32(sideWall, vnegq_f32(velocityX), velocityX);
+
+			const uint32x4_t caught = vandq_u32(vandq_u32(bottom, vcleq_f32(vaddq_f32(vsubq_f32(y, radius), vdupq_n_f32(GameRules::BarCatchOffset)), vdupq_n_f32(GameRules::BarY))),
+				vandq_u32(vcleq_f32(bar, vsubq_f32(x, radius)), vcleq_f32(vaddq_f32(x, radius), vaddq_f32(bar, vdupq_n_f32(GameRules::BarCatchWidth)))));
+			const uint32x4_t leftHalf = vcleq_f32(x, vaddq_f32(bar, halfWidth));
+			const uint32x4_t turn = vandq_u32(caught, vorrq_u32(vandq_u32(leftHalf, vcgtq_f32(velocityX, vdupq_n_f32(0.0f))),
+				vbicq_u32(vcltq_f32(velocityX, vdupq_n_f32(0.0f)), leftHalf)));
+			velocityX = vbslq_f32(turn, vnegq_f32(velocityX), velocityX);
+			velocityY = vbslq_f32(caught, vnegq_f32(velocityY), velocityY);
+			y = vbslq_f32(caught, vdupq_n_f32(GameRules::BarY - GameRules::BarReboundOffset), y);
+
+			vst1q_f32(arrays.BallX + i, x);
+			vst1q_f32(arrays.BallY + i, y);
+			vst1q_f32(arrays.BallVelocityX + i, velocityX);
+			vst1q_f32(arrays.BallVelocityY + i, velocityY);
+
+			uint32_t topLanes[4];
+			uint32_t lostLanes[4];
+			vst1q_u32(topLanes, top);
+			vst1q_u32(lostLanes, lost);
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				arrays.InChunkZone[i + lane] = static_cast<uint8_t>(topLanes[lane] & 1);
+				arrays.BallLost[i + lane] = static_cast<uint8_t>(lostLanes[lane] & 1);
+			}
+		}
+#else
+		inline void Step4(const Arrays& arrays, uint32_t i)
+		{
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				StepOne(arrays, i + lane);
+			}
+		}
+#endif
+	}
+
+	BatchEnvironment::BatchEnvironment(uint32_t environmentCount, uint32_t threadCount, uint32_t seed) :
+		mEnvironmentCount(environmentCount),
+		mBallX(environmentCount), mBallY(environmentCount), mBallVelocityX(environmentCount), mBallVelocityY(environmentCount),
+		mBarX(environmentCount), mBarVelocityX(environmentCount), mChunkMasks(environmentCount), mEpisodeSteps(environmentCount),
+		mRandomStates(environmentCount), mInChunkZone(environmentCount), mBallLost(environmentCount),
+		mStepArguments(), mResetting(false), mPartitionCount(0), mGeneration(0), mPendingPartitions(0), mShuttingDown(false)
+	{
+		for (uint32_t i = 0; i < environmentCount; ++i)
+		{
+			// Any non-zero state works for xorshift; spread the seeds so neighbouring environments diverge immediately.
+			mRandomStates[i] = (seed + i) * 2654435761U | 1;
+		}
+
+		if (threadCount == 0)
+		{
+			threadCount = max(thread::hardware_concurrency(), 1U);
+		}
+
+		mPartitionCount = max(min(threadCount, environmentCount), 1U);
+
+		// The calling thread runs partition zero.
+		mWorkers.reserve(mPartitionCount - 1);
+		for (uint32_t partition = 1; partition < mPartitionCount; ++partition)
+		{
+			mWorkers.emplace_back(&BatchEnvironment::WorkerMain, this, partition);
+		}
+
+		ResetRange(0, mEnvironmentCount);
+	}
+
+	BatchEnvironment::~BatchEnvironment()
+	{
+		{
+			lock_guard<mutex> lock(mMutex);
+			mShuttingDown = true;
+		}
+
+		mWorkAvailable.notify_all();
+
+		for (auto& worker : mWorkers)
+		{
+			worker.join();
+		}
+	}
+
+	uint32_t BatchEnvironment::EnvironmentCount() const
+	{
+		return mEnvironmentCount;
+	}
+
+	uint32_t BatchEnvironment::ThreadCount() const
+	{
+		return mPartitionCount;
+	}
+
+	void BatchEnvironment::Reset(float* observations)
+	{
+		mStepArguments.Actions = nullptr;
+		mStepArguments.Observations = observations;
+		mStepArguments.Rewards = nullptr;
+		mStepArguments.Done = nullptr;
+		mResetting = true;
+
+		Dispatch();
+	}
+
+	void BatchEnvironment::Step(const uint8_t* actions, float* observations, float* rewards, uint8_t* done)
+	{
+		mStepArguments.Actions = actions;
+		mStepArguments.Observations = observations;
+		mStepArguments.Rewards = rewards;
+		mStepArguments.Done = done;
+		mResetting = false;
+
+		Dispatch();
+	}
+
+	const uint64_t* BatchEnvironment::ChunkMasks() const
+	{
+		return mChunkMasks.data();
+	}
+
+	void BatchEnvironment::StepRange(uint32_t begin, uint32_t end)
+	{
+		float* rewards = mStepArguments.Rewards;
+		uint8_t* done = mStepArguments.Done;
+
+		// Bar and ball movement, walls and the bar, four environments at a time and the rest one by one.
+		const Arrays arrays = { mStepArguments.Actions, mBallX.data(), mBallY.data(), mBallVelocityX.data(), mBallVelocityY.data(),
+			mBarX.data(), mBarVelocityX.data(), mInChunkZone.data(), mBallLost.data() };
+		uint32_t first = begin;
+		for (; first + 4 <= end; first += 4)
+		{
+			Step4(arrays, first);
+		}
+
+		for (; first < end; ++first)
+		{
+			StepOne(arrays, first);
+		}
+
+		fill(rewards + begin, rewards + end, 0.0f);
+
+		// Chunks and the top of the field, only for the few environments whose ball is up there.
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			if (mInChunkZone[i] == 0)
+			{
+				continue;
+			}
+
+			GameRules::PlayState state = { mBallX[i], mBallY[i], mBallVelocityX[i], mBallVelocityY[i], mBarX[i], mBarVelocityX[i] };
+			if (GameRules::StepChunks(state, mChunkMasks[i]) != GameRules::NoChunk)
+			{
+				rewards[i] = 1.0f;
+			}
+
+			mBallY[i] = state.BallY;
+			mBallVelocityY[i] = state.BallVelocityY;
+		}
+
+		// Episode ends: a lost ball, a cleared wall or the step limit. Finished environments are reset in place.
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const bool lost = (mBallLost[i] != 0);
+			const bool cleared = (mChunkMasks[i] == 0);
+			const bool truncated = (++mEpisodeSteps[i] >= MaxEpisodeSteps);
+
+			if (lost)
+			{
+				rewards[i] -= 1.0f;
+			}
+
+			done[i] = (lost || cleared || truncated ? 1 : 0);
+			if (done[i] != 0)
+			{
+				ResetEnvironment(i);
+			}
+		}
+
+		WriteObservations(begin, end);
+	}
+
+	void BatchEnvironment::ResetRange(uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			ResetEnvironment(i);
+		}
+
+		if (mStepArguments.Observations != nullptr)
+		{
+			WriteObservations(begin, end);
+		}
+	}
+
+	void BatchEnvironment::ResetEnvironment(uint32_t index)
+	{
+		// The ball starts on the bar as in BallManager::InitializeBall and is launched immediately, toward a random side.
+		const bool launchLeft = ((NextRandom(mRandomStates[index]) & 1) != 0);
+
+		mBallX[index] = GameRules::BallStartX;
+		mBallY[index] = GameRules::BallStartY;
+		mBallVelocityX[index] = (launchLeft ? -GameRules::BallLaunchSpeed : GameRules::BallLaunchSpeed);
+		mBallVelocityY[index] = GameRules::BallLaunchSpeed;
+		mBarX[index] = GameRules::BarStartX;
+		mBarVelocityX[index] = GameRules::BarStartSpeed;
+		mChunkMasks[index] = AllChunks;
+		mEpisodeSteps[index] = 0;
+	}
+
+	void BatchEnvironment::WriteObservations(uint32_t begin, uint32_t end)
+	{
+		float* observations = mStepArguments.Observations;
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			float* observation = observations + static_cast<size_t>(i) * ObservationSize;
+			observation[BallX] = mBallX[i];
+			observation[BallY] = mBallY[i];
+			observation[BallVelocityX] = mBallVelocityX[i];
+			observation[BallVelocityY] = mBallVelocityY[i];
+			observation[BarX] = mBarX[i];
+			observation[BarVelocityX] = mBarVelocityX[i];
+			observation[ChunksRemaining] = static_cast<float>(bitset<64>(mChunkMasks[i]).count()) / ChunkCount;
+			observation[EpisodeProgress] = static_cast<float>(mEpisodeSteps[i]) / MaxEpisodeSteps;
+		}
+	}
+
+	void BatchEnvironment::Dispatch()
+	{
+		if (mPartitionCount > 1)
+		{
+			{
+				lock_guard<mutex> lock(mMutex);
+				++mGeneration;
+				mPendingPartitions = mPartitionCount - 1;
+			}
+
+			mWorkAvailable.notify_all();
+		}
+
+		RunPartition(0);
+
+		if (mPartitionCount > 1)
+		{
+			unique_lock<mutex> lock(mMutex);
+			mWorkComplete.wait(lock, [this]() { return mPendingPartitions == 0; });
+		}
+	}
+
+	void BatchEnvironment::RunPartition(uint32_t partition)
+	{
+		const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(mEnvironmentCount) * partition / mPartitionCount);
+		const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(mEnvironmentCount) * (partition + 1) / mPartitionCount);
+
+		if (mResetting)
+		{
+			ResetRange(begin, end);
+		}
+		else
+		{
+			StepRange(begin, end);
+		}
+	}
+
+	void BatchEnvironment::WorkerMain(uint32_t partition)
+	{
+		uint64_t completedGeneration = 0;
+
+		for (;;)
+		{
+			{
+				unique_lock<mutex> lock(mMutex);
+				mWorkAvailable.wait(lock, [&]() { return mShuttingDown || mGeneration != completedGeneration; });
+				if (mShuttingDown)
+				{
+					return;
+				}
+
+				completedGeneration = mGeneration;
+			}
+
+			RunPartition(partition);
+
+			bool lastPartition;
+			{
+				lock_guard<mutex> lock(mMutex);
+				lastPartition = (--mPendingPartitions == 0);
+			}
+
+			if (lastPartition)
+			{
+				mWorkComplete.notify_one();
+			}
+		}
+	}
+}
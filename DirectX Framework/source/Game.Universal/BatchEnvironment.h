@@ -0,0 +1,118 @@
+#pragma once
+
+#include "GameRules.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DirectXGame
+{
+	// Steps many independent, headless copies of the game in lockstep for agent training and evaluation.
+	// Each environment follows the ball, bar, wall and chunk rules in GameRules, as Ball, BarManager and ChunkManager play
+	// them at a fixed 60 Hz step. State is stored as structure-of-arrays and the bar and ball step runs four environments at
+	// a time with SSE2 or NEON, falling back to one at a time elsewhere or when DX_BATCH_ENVIRONMENT_SCALAR is defined. The
+	// environments are split across a persistent pool of worker threads. This file only depends on the C++ standard
+	// library so it can be built for headless (non-Windows) training hosts.
+	class BatchEnvironment final
+	{
+	public:
+		enum Action : std::uint8_t
+		{
+			None,
+			MoveLeft,
+			MoveRight
+		};
+
+		// Observation layout, in floats per environment.
+		enum Observation : std::uint32_t
+		{
+			BallX,
+			BallY,
+			BallVelocityX,
+			BallVelocityY,
+			BarX,
+			BarVelocityX,
+			ChunksRemaining,	// Fraction of the wall still standing
+			EpisodeProgress,	// Fraction of MaxEpisodeSteps elapsed
+			ObservationSize
+		};
+
+		static const std::uint32_t ChunkRows = GameRules::ChunkRows;
+		static const std::uint32_t ChunkColumns = GameRules::ChunkColumns;
+		static const std::uint32_t ChunkCount = GameRules::ChunkCount;
+
+		// Episodes that neither lose the ball nor clear the wall are cut off (and reported done) after five minutes.
+		static const std::uint32_t MaxEpisodeSteps = 60 * 60 * 5;
+
+		// A thread count of zero uses one thread per hardware thread.
+		BatchEnvironment(std::uint32_t environmentCount, std::uint32_t threadCount = 0, std::uint32_t seed = 1);
+		BatchEnvironment(const BatchEnvironment&) = delete;
+		BatchEnvironment& operator=(const BatchEnvironment&) = delete;
+		BatchEnvironment(BatchEnvironment&&) = delete;
+		BatchEnvironment& operator=(BatchEnvironment&&) = delete;
+		~BatchEnvironment();
+
+		std::uint32_t EnvironmentCount() const;
+		std::uint32_t ThreadCount() const;
+
+		// Resets every environment and writes EnvironmentCount() * ObservationSize floats to observations.
+		void Reset(float* observations);
+
+		// Advances every environment by one step. Environments that finish are reset in place; their reward and done flag
+		// describe the finished episode while their observation is the first of the new one. All output arrays are
+		// caller-provided: observations holds EnvironmentCount() * ObservationSize floats, rewards and done one entry each.
+		// Rewards are +1 per chunk broken and -1 for losing the ball.
+		void Step(const std::uint8_t* actions, float* observations, float* rewards, std::uint8_t* done);
+
+		// One bit per chunk (bit row * ChunkColumns + column, row 0 at the top); set while the chunk is standing.
+		const std::uint64_t* ChunkMasks() const;
+
+	private:
+		struct StepArguments
+		{
+			const std::uint8_t* Actions;
+			float* Observations;
+			float* Rewards;
+			std::uint8_t* Done;
+		};
+
+		void StepRange(std::uint32_t begin, std::uint32_t end);
+		void ResetRange(std::uint32_t begin, std::uint32_t end);
+		void ResetEnvironment(std::uint32_t index);
+		void WriteObservations(std::uint32_t begin, std::uint32_t end);
+
+		// Runs the current step or reset over every environment, split across the worker threads and the calling thread.
+		void Dispatch();
+		void RunPartition(std::uint32_t partition);
+		void WorkerMain(std::uint32_t partition);
+
+		std::uint32_t mEnvironmentCount;
+
+		// Structure-of-arrays game state.
+		std::vector<float> mBallX;
+		std::vector<float> mBallY;
+		std::vector<float> mBallVelocityX;
+		std::vector<float> mBallVelocityY;
+		std::vector<float> mBarX;
+		std::vector<float> mBarVelocityX;
+		std::vector<std::uint64_t> mChunkMasks;
+		std::vector<std::uint32_t> mEpisodeSteps;
+		std::vector<std::uint32_t> mRandomStates;
+		std::vector<std::uint8_t> mInChunkZone;
+		std::vector<std::uint8_t> mBallLost;
+
+		StepArguments mStepArguments;
+		bool mResetting;
+
+		std::vector<std::thread> mWorkers;
+		std::uint32_t mPartitionCount;
+		std::mutex mMutex;
+		std::condition_variable mWorkAvailable;
+		std::condition_variable mWorkComplete;
+		std::uint64_t mGeneration;
+		std::uint32_t mPendingPartitions;
+		bool mShuttingDown;
+	};
+}
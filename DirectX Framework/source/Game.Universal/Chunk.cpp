@@ -8,7 +8,7 @@ namespace DirectXGame
 {
 	Chunk::Chunk(ChunkManager& chunkManager, const DX::Transform2D& transform, float radius, const DirectX::XMFLOAT4& color, const DirectX::XMFLOAT2& velocity) :
 		mChunkManager(chunkManager), mTransform(transform), mRadius(radius),
-		mColor(color), mVelocity(velocity)
+		mColor(color), mVelocity(velocity), mDestroyed(false)
 	{
 	}
 
@@ -62,4 +62,14 @@ namespace DirectXGame
 
 		mTransform.SetPosition(position);
 	}
+
+	void Chunk::DestroyChunk()
+	{
+		mDestroyed = true;
+	}
+
+	const bool Chunk::Destroyed() const
+	{
+		return mDestroyed;
+	}
 }
\ No newline at end of file
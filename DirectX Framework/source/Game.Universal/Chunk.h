@@ -38,12 +38,16 @@ namespace DirectXGame
 
 		void Update(const DX::StepTimer& timer);
 
+		void DestroyChunk();
+		const bool Destroyed() const;
+
 	private:
 		ChunkManager& mChunkManager;
 		DX::Transform2D mTransform;
 		float mRadius;
 		DirectX::XMFLOAT4 mColor;
 		DirectX::XMFLOAT2 mVelocity;
+		bool mDestroyed;
 
 		const float mWidth = 4.0f;
 		const float mFieldRightSide = 40.0f;
@@ -1,22 +1,42 @@
 #include "pch.h"
 #include "ChunkManager.h"
 #include "Chunk.h"
+#include "GameRules.h"
+#include "ParticleManager.h"
+#include <algorithm>
+#include <cfloat>
 
 using namespace std;
 using namespace DirectX;
 using namespace DX;
+using namespace Microsoft::WRL;
 
 namespace DirectXGame
 {
-	const uint32_t ChunkManager::CircleResolution = 32;
-	const uint32_t ChunkManager::SolidCircleVertexCount = (ChunkManager::CircleResolution + 1) * 2;
+	const uint32_t ChunkManager::ChunkVertexCount = 4;
+	const XMFLOAT4 ChunkManager::ChunkObjectBounds(0.0f, -40.0f, 6.0f, -38.0f);
 
-	ChunkManager::ChunkManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera, 
-		ScoreManager& scoreManager, PowerupManager& powerupManager) :
-		DrawableGameComponent(deviceResources, camera), mLoadingComplete(false), 
-		mScoreManager(scoreManager), mPowerupManager(powerupManager)
+	const D3D11_INPUT_ELEMENT_DESC ChunkManager::ChunkInstance::InputElements[] =
 	{
-		CreateDeviceDependentResources();
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "BLENDINDICES", 0, DXGI_FORMAT_R32_UINT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	};
+
+	ChunkManager::ChunkManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera, const shared_ptr<D3D11RenderBackend>& renderBackend, const shared_ptr<PipelineCache>& pipelineCache, 
+		ScoreManager& scoreManager, PowerupManager& powerupManager, ParticleManager& particleManager) :
+		DrawableGameComponent(deviceResources, camera), mRenderBackend(renderBackend), mPipelineCache(pipelineCache),
+		mChunkMesh(RenderCommandList::InvalidMesh), mLayerQuadMesh(RenderCommandList::InvalidMesh), mLoadingComplete(false),
+		mInstancesDirty(true), mChunkCullerDirty(true), mCBufferPerFrame(), mScoreManager(scoreManager), mPowerupManager(powerupManager), mParticleManager(particleManager)
+	{
+		assert(mChunkColors.size() <= PaletteSize);
+		for (size_t i = 0; i < mChunkColors.size(); ++i)
+		{
+			mCBufferPerFrame.Palette[i] = mChunkColors[i];
+		}
+		mInstances.reserve(GameRules::ChunkCount);
+		mChunkCullBounds.reserve(GameRules::ChunkCount);
+		mVisibleChunks.reserve(GameRules::ChunkCount);
 	}
 
 	std::shared_ptr<Field> ChunkManager::ActiveField() const
@@ -31,69 +51,30 @@ namespace DirectXGame
 
 	void ChunkManager::CreateDeviceDependentResources()
 	{
-		auto loadVSTask = ReadDataAsync(L"ShapeRendererVS.cso");
-		auto loadPSTask = ReadDataAsync(L"ShapeRendererPS.cso");
-
-		// After the vertex shader file is loaded, create the shader and input layout.
-		auto createVSTask = loadVSTask.then([this](const std::vector<byte>& fileData) {
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateVertexShader(
-					&fileData[0],
-					fileData.size(),
-					nullptr,
-					mVertexShader.ReleaseAndGetAddressOf()
-				)
-			);
-
-			// Create an input layout
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateInputLayout(
-					VertexPosition::InputElements,
-					VertexPosition::InputElementCount,
-					&fileData[0],
-					fileData.size(),
-					mInputLayout.ReleaseAndGetAddressOf()
-				)
-			);
-
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4X4), D3D11_BIND_CONSTANT_BUFFER);
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateBuffer(
-					&constantBufferDesc,
-					nullptr,
-					mVSCBufferPerObject.ReleaseAndGetAddressOf()
-				)
-			);
-		});
+		const PipelineCache::Description description = { L"ShapeRendererInstancedVS.cso", L"ShapeRendererInstancedPS.cso", ChunkInstance::InputElements, ChunkInstance::InputElementCount,
+			D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, sizeof(CBufferPerFrame), 0 };
 
-		// After the pixel shader file is loaded, create the shader and constant buffer.
-		auto createPSTask = loadPSTask.then([this](const std::vector<byte>& fileData) {
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreatePixelShader(
-					&fileData[0],
-					fileData.size(),
-					nullptr,
-					mPixelShader.ReleaseAndGetAddressOf()
-				)
-			);
-
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4), D3D11_BIND_CONSTANT_BUFFER);
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateBuffer(
-					&constantBufferDesc,
-					nullptr,
-					mPSCBufferPerObject.ReleaseAndGetAddressOf()
-				)
-			);
-		});
+		// The layer quad is in world space, so the shared shape vertex shader places it with the view-projection matrix.
+		const PipelineCache::Description layerDescription = { L"ShapeRendererVS.cso", L"BrickLayerPS.cso", VertexPosition::InputElements, VertexPosition::InputElementCount,
+			D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, sizeof(XMFLOAT4X4), 0 };
 
-		auto createVerticesAndBallsTask = (createPSTask && createVSTask).then([this]() {
+		// Colors come from the vertex shader's palette, so the pixel shader has no constants.
+		(mPipelineCache->GetPipelineAsync(description) && mPipelineCache->GetPipelineAsync(layerDescription)).then([this](const vector<shared_ptr<const PipelineCache::Pipeline>>& pipelines) {
+			mPipeline = pipelines[0];
+			mLayerPipeline = pipelines[1];
 			InitializeTriangleVertices();
+			InitializeInstanceBuffer();
 			InitializeChunks();
-		});
+			InitializeLayerQuad();
 
-		// Once the cube is loaded, the object is ready to be rendered.
-		createVerticesAndBallsTask.then([this]() {
+			const D3D11RenderBackend::Mesh chunkMesh = { mTriangleVertexBuffer, sizeof(VertexPosition), mInstanceBuffer, sizeof(ChunkInstance) };
+			mChunkMesh = mRenderBackend->CreateMesh(chunkMesh);
+
+			const D3D11RenderBackend::Mesh layerQuadMesh = { mLayerQuadVertexBuffer, sizeof(VertexPosition), nullptr, 0 };
+			mLayerQuadMesh = mRenderBackend->CreateMesh(layerQuadMesh);
+
+			// The new instance buffer starts out empty.
+			mInstancesDirty = true;
 			mLoadingComplete = true;
 		});
 	}
@@ -101,23 +82,36 @@ namespace DirectXGame
 	void ChunkManager::ReleaseDeviceDependentResources()
 	{
 		mLoadingComplete = false;
-		mVertexShader.Reset();
-		mPixelShader.Reset();
-		mInputLayout.Reset();
 		mTriangleVertexBuffer.Reset();
-		mVSCBufferPerObject.Reset();
-		mPSCBufferPerObject.Reset();
+		mInstanceBuffer.Reset();
+		mLayerQuadVertexBuffer.Reset();
+		mPipeline.reset();
+		mLayerPipeline.reset();
+		mRenderBackend->ReleaseMesh(mChunkMesh);
+		mRenderBackend->ReleaseMesh(mLayerQuadMesh);
+		ReleaseBrickLayer();
 	}
 
 	void ChunkManager::Update(const StepTimer& timer)
 	{
 		for (const auto& chunk : mChunks)
 		{
-			chunk->Update(timer);
+			if (!chunk->Destroyed())
+			{
+				chunk->Update(timer);
+
+				// Instances hold positions, so a moving chunk needs them rewritten and the layer redrawn.
+				if (chunk->Velocity().x != 0.0f || chunk->Velocity().y != 0.0f)
+				{
+					mInstancesDirty = true;
+					mBrickLayer.Invalidate();
+					mChunkCullerDirty = true;
+				}
+			}
 		}
 	}
 
-	void ChunkManager::Render(const StepTimer & timer)
+	void ChunkManager::RecordOffscreenDraws(const StepTimer& timer, RenderCommandList& commandList)
 	{
 		UNREFERENCED_PARAMETER(timer);
 
@@ -127,51 +121,154 @@ namespace DirectXGame
 			return;
 		}
 
-		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
-		direct3DDeviceContext->IASetInputLayout(mInputLayout.Get());
+		const D3D11_VIEWPORT viewport = mDeviceResources->GetScreenViewport();
+		const uint32_t width = static_cast<uint32_t>(viewport.Width);
+		const uint32_t height = static_cast<uint32_t>(viewport.Height);
+		if (width == 0 || height == 0)
+		{
+			return;
+		}
 
-		direct3DDeviceContext->VSSetShader(mVertexShader.Get(), nullptr, 0);
-		direct3DDeviceContext->PSSetShader(mPixelShader.Get(), nullptr, 0);
+		if (width != mBrickLayer.Width() || height != mBrickLayer.Height())
+		{
+			CreateBrickLayer(width, height);
+		}
 
-		direct3DDeviceContext->VSSetConstantBuffers(0, 1, mVSCBufferPerObject.GetAddressOf());
-		direct3DDeviceContext->PSSetConstantBuffers(0, 1, mPSCBufferPerObject.GetAddressOf());
+		XMStoreFloat4x4(&mCBufferPerFrame.ViewProjection, XMMatrixTranspose(mCamera->ViewProjectionMatrix()));
+		if (mBrickLayer.SetViewProjection(&mCBufferPerFrame.ViewProjection._11))
+		{
+			// Which chunks are visible changes with the camera.
+			mInstancesDirty = true;
+		}
 
-		for (const auto& chunk : mChunks)
+		commandList.SetLayer(BrickLayer);
+		if (mBrickLayer.NeedsUpdate())
 		{
-			DrawChunk(*chunk);
+			RecordBrickLayerUpdate(commandList);
 		}
 	}
 
-	void ChunkManager::DrawChunk(const Chunk & chunk)
+	void ChunkManager::RecordDraws(const StepTimer& timer, RenderCommandList& commandList)
+	{
+		UNREFERENCED_PARAMETER(timer);
+
+		// The layer is sized and brought up to date by RecordOffscreenDraws.
+		if (!mLoadingComplete || mBrickLayer.Width() == 0 || mInstances.empty())
+		{
+			return;
+		}
+
+		commandList.SetLayer(BrickLayer);
+		mBrickLayer.RecordComposite(commandList, mLayerPipeline->Handle, mLayerQuadMesh, 4);
+	}
+
+	void ChunkManager::RecordBrickLayerUpdate(RenderCommandList& commandList)
+	{
+		mBrickLayer.BeginUpdate(commandList);
+		commandList.SetPipeline(mPipeline->Handle);
+		commandList.SetMesh(mChunkMesh);
+
+		if (mInstancesDirty)
+		{
+			RebuildInstances();
+			commandList.UpdateInstances(mInstances.data(), static_cast<uint32_t>(mInstances.size()));
+			mInstancesDirty = false;
+		}
+
+		commandList.SetConstants(ShaderStage::Vertex, mCBufferPerFrame);
+		mBrickLayer.EndUpdate(commandList, ChunkVertexCount, static_cast<uint32_t>(mInstances.size()));
+	}
+
+	void ChunkManager::CreateBrickLayer(uint32_t width, uint32_t height)
+	{
+		ReleaseBrickLayer();
+
+		ID3D11Device* device = mDeviceResources->GetD3DDevice();
+		CD3D11_TEXTURE2D_DESC textureDesc(DXGI_FORMAT_B8G8R8A8_UNORM, width, height, 1, 1, D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE);
+		ComPtr<ID3D11Texture2D> texture;
+		ThrowIfFailed(device->CreateTexture2D(&textureDesc, nullptr, texture.GetAddressOf()));
+
+		D3D11RenderBackend::RenderTarget renderTarget;
+		ThrowIfFailed(device->CreateRenderTargetView(texture.Get(), nullptr, renderTarget.RenderTargetView.GetAddressOf()));
+		ThrowIfFailed(device->CreateShaderResourceView(texture.Get(), nullptr, renderTarget.ShaderResourceView.GetAddressOf()));
+		renderTarget.Width = width;
+		renderTarget.Height = height;
+
+		mBrickLayer.SetTarget(mRenderBackend->CreateRenderTarget(renderTarget), width, height);
+	}
+
+	void ChunkManager::ReleaseBrickLayer()
 	{
-		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
-		direct3DDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+		RenderTargetHandle target = mBrickLayer.Target();
+		mRenderBackend->ReleaseRenderTarget(target);
+		mBrickLayer.SetTarget(target, 0, 0);
+	}
 
-		static const UINT stride = sizeof(VertexPosition);
-		static const UINT offset = 0;
-		direct3DDeviceContext->IASetVertexBuffers(0, 1, mTriangleVertexBuffer.GetAddressOf(), &stride, &offset);
+	XMFLOAT4 ChunkManager::ChunkBounds(const Chunk& chunk) const
+	{
+		const XMFLOAT2& position = chunk.Position();
+		const float scale = chunk.Radius();
 
-		const XMMATRIX wvp = XMMatrixTranspose(XMMatrixScaling(chunk.Radius(), chunk.Radius(), chunk.Radius()) * chunk.Transform().WorldMatrix() * mCamera->ViewProjectionMatrix());
-		direct3DDeviceContext->UpdateSubresource(mVSCBufferPerObject.Get(), 0, nullptr, reinterpret_cast<const float*>(wvp.r), 0, 0);
+		return XMFLOAT4(position.x + ChunkObjectBounds.x * scale, position.y + ChunkObjectBounds.y * scale,
+			position.x + ChunkObjectBounds.z * scale, position.y + ChunkObjectBounds.w * scale);
+	}
 
-		direct3DDeviceContext->UpdateSubresource(mPSCBufferPerObject.Get(), 0, nullptr, &chunk.Color(), 0, 0);
+	void ChunkManager::RebuildInstances()
+	{
+		if (mChunkCullerDirty)
+		{
+			mChunkCullBounds.clear();
+			for (const auto& chunk : mChunks)
+			{
+				const XMFLOAT4 bounds = ChunkBounds(*chunk);
+				const CullBounds cullBounds = { bounds.x, bounds.y, bounds.z, bounds.w };
+				mChunkCullBounds.push_back(cullBounds);
+			}
+
+			mChunkCuller.Build(mChunkCullBounds.data(), static_cast<uint32_t>(mChunkCullBounds.size()));
+			mChunkCullerDirty = false;
+		}
 
-		direct3DDeviceContext->Draw(SolidCircleVertexCount, 0);
+		const XMFLOAT4& view = mCamera->VisibleBounds();
+		mChunkCuller.Cull(CullBounds{ view.x, view.y, view.z, view.w }, mVisibleChunks);
+
+		mInstances.clear();
+		for (const uint32_t i : mVisibleChunks)
+		{
+			const Chunk& chunk = *mChunks[i];
+			if (!chunk.Destroyed())
+			{
+				const ChunkInstance instance = { chunk.Position(), chunk.Radius(), mChunkPaletteIndices[i] };
+				mInstances.push_back(instance);
+			}
+		}
 	}
 
 	float ChunkManager::HandleBallCollision(const XMFLOAT2& ballPosition, const float& ballRadius)
 	{
+		DX_PROFILE_ZONE("ChunkManager::HandleBallCollision");
+
 		float hitPosition = 0.0f;
 
 		for (auto it = mChunks.begin(); it != mChunks.end(); ++it)
 		{
-			if ((ballPosition.y + ballRadius + 57) >= ((*it)->Position().y - mChunkHeight))
+			if ((*it)->Destroyed())
 			{
-				if (((*it)->Position().x) <= ballPosition.x && ballPosition.x <= ((*it)->Position().x + mChunkWidth))
+				continue;
+			}
+
+			if ((ballPosition.y + ballRadius + GameRules::ChunkCatchOffset) >= ((*it)->Position().y - GameRules::ChunkHeight))
+			{
+				if (((*it)->Position().x) <= ballPosition.x && ballPosition.x <= ((*it)->Position().x + GameRules::ChunkWidth))
 				{
-					hitPosition = ((*it)->Position().y - mChunkHeight) - 58;
-					mPowerupManager.PowerupSpawnCheck(XMFLOAT2(((*it)->Position().x + 2), ((*it)->Position().y - mChunkHeight)));
-					mChunks.erase(it);
+					hitPosition = ((*it)->Position().y - GameRules::ChunkHeight) - GameRules::ChunkReboundOffset;
+					mPowerupManager.PowerupSpawnCheck(XMFLOAT2(((*it)->Position().x + GameRules::PowerupSpawnOffsetX), ((*it)->Position().y - GameRules::ChunkHeight)));
+					// Destroyed chunks stay in place rather than being erased so that breaking one never frees memory mid-game.
+					(*it)->DestroyChunk();
+					mInstancesDirty = true;
+					const XMFLOAT4 bounds = ChunkBounds(**it);
+					mBrickLayer.Invalidate(CachedLayer::Bounds{ bounds.x, bounds.y, bounds.z, bounds.w });
+					mParticleManager.EmitBrickBreak(XMFLOAT2((bounds.x + bounds.z) * 0.5f, (bounds.y + bounds.w) * 0.5f), (*it)->Color());
 					mScoreManager.IncrementScore();
 					break;
 				}
@@ -186,6 +283,11 @@ namespace DirectXGame
 		mScoreManager.SetGameOver();
 	}
 
+	const ViewCuller& ChunkManager::ChunkCuller() const
+	{
+		return mChunkCuller;
+	}
+
 	void ChunkManager::InitializeTriangleVertices()
 	{
 		vector<VertexPosition> vertices;
@@ -236,29 +338,69 @@ namespace DirectXGame
 		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&vertexBufferDesc, &vertexSubResourceData, mTriangleVertexBuffer.ReleaseAndGetAddressOf()));
 	}
 
+	void ChunkManager::InitializeLayerQuad()
+	{
+		XMFLOAT4 wallBounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (const auto& chunk : mChunks)
+		{
+			const XMFLOAT4 bounds = ChunkBounds(*chunk);
+			wallBounds.x = min(wallBounds.x, bounds.x);
+			wallBounds.y = min(wallBounds.y, bounds.y);
+			wallBounds.z = max(wallBounds.z, bounds.z);
+			wallBounds.w = max(wallBounds.w, bounds.w);
+		}
+
+		// Same winding as the chunk quad.
+		const VertexPosition vertices[] =
+		{
+			VertexPosition(XMFLOAT4(wallBounds.x, wallBounds.w, 0.0f, 1.0f)),
+			VertexPosition(XMFLOAT4(wallBounds.z, wallBounds.w, 0.0f, 1.0f)),
+			VertexPosition(XMFLOAT4(wallBounds.x, wallBounds.y, 0.0f, 1.0f)),
+			VertexPosition(XMFLOAT4(wallBounds.z, wallBounds.y, 0.0f, 1.0f))
+		};
+
+		D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
+		vertexBufferDesc.ByteWidth = sizeof(vertices);
+		vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA vertexSubResourceData = { 0 };
+		vertexSubResourceData.pSysMem = vertices;
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&vertexBufferDesc, &vertexSubResourceData, mLayerQuadVertexBuffer.ReleaseAndGetAddressOf()));
+	}
+
+	void ChunkManager::InitializeInstanceBuffer()
+	{
+		CD3D11_BUFFER_DESC instanceBufferDesc(sizeof(ChunkInstance) * GameRules::ChunkCount, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&instanceBufferDesc, nullptr, mInstanceBuffer.ReleaseAndGetAddressOf()));
+	}
+
 	void ChunkManager::InitializeChunks()
 	{
 		const float rotation = 0.0f;
-		const float radius = 1.5f;
+		const float radius = GameRules::ChunkScale;
 		const XMFLOAT2 velocity(0, 0);
-		float originalX = -45.0f;
-		XMFLOAT2 position(originalX, 97);
+		float originalX = GameRules::ChunkLeft;
+		XMFLOAT2 position(originalX, GameRules::ChunkTopRowY);
 		int colorIndex = 0;
 
-		if (mChunks.size() < mNumChunks)
+		if (mChunks.size() < GameRules::ChunkCount)
 		{
-			for (uint32_t i = 1; i <= mNumChunks; ++i)
+			for (uint32_t i = 1; i <= GameRules::ChunkCount; ++i)
 			{
 				mChunks.emplace(mChunks.begin(), make_shared<Chunk>(*this, position, radius, mChunkColors[colorIndex], velocity));
+				mChunkPaletteIndices.emplace(mChunkPaletteIndices.begin(), static_cast<uint32_t>(colorIndex));
 
-				if (i % 10 == 0)
+				if (i % GameRules::ChunkColumns == 0)
 				{
 					colorIndex += 1;
-					position = XMFLOAT2(originalX - mChunkWidth, (position.y - mChunkHeight));
+					position = XMFLOAT2(originalX - GameRules::ChunkWidth, (position.y - GameRules::ChunkHeight));
 				}
 
-				position = XMFLOAT2((position.x + mChunkWidth), position.y);
+				position = XMFLOAT2((position.x + GameRules::ChunkWidth), position.y);
 			}
+
+			mChunkCullerDirty = true;
 		}
 	}
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-#pragma once
+﻿#pragma once
 
 #include "DrawableGameComponent.h"
 #include <DirectXMath.h>
@@ -11,12 +11,22 @@ namespace DirectXGame
 	class Field;
 	class ScoreManager;
 	class PowerupManager;
+	class ParticleManager;
 
+	// Owns the wall of chunks. The whole wall is drawn with one instanced draw: each standing chunk is an instance carrying its
+	// offset, scale and palette index, and the instance buffer is only rewritten when the set of standing chunks changes.
+	// The wall is static between hits, so it is drawn into a CachedLayer the size of the back buffer and composited each frame
+	// with one quad over the wall's bounds. A destroyed chunk only clears and redraws its own rectangle of the layer; the whole
+	// layer is redrawn when it is created, when the camera changes or when a chunk moves. The wall is laid out by GameRules. Only chunks inside the camera's
+	// view become instances; they are culled against a grid of the chunks' bounds, rebuilt when a chunk moves.
 	class ChunkManager final : public DX::DrawableGameComponent
 	{
 	public:
-		ChunkManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, 
-			ScoreManager& scoreManager, PowerupManager& powerupManager);
+		// Number of colors the instanced shader can index; keep in sync with ShapeRendererInstancedVS.hlsl.
+		static const std::uint32_t PaletteSize = 8;
+
+		ChunkManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, const std::shared_ptr<DX::D3D11RenderBackend>& renderBackend, const std::shared_ptr<DX::PipelineCache>& pipelineCache, 
+			ScoreManager& scoreManager, PowerupManager& powerupManager, ParticleManager& particleManager);
 
 		std::shared_ptr<Field> ActiveField() const;
 		void SetActiveField(const std::shared_ptr<Field>& field);
@@ -24,35 +34,74 @@ namespace DirectXGame
 		virtual void CreateDeviceDependentResources() override;
 		virtual void ReleaseDeviceDependentResources() override;
 		virtual void Update(const DX::StepTimer& timer) override;
-		virtual void Render(const DX::StepTimer& timer) override;
+		virtual void RecordOffscreenDraws(const DX::StepTimer& timer, DX::RenderCommandList& commandList) override;
+		virtual void RecordDraws(const DX::StepTimer& timer, DX::RenderCommandList& commandList) override;
 
 		float HandleBallCollision(const DirectX::XMFLOAT2& ballPosition, const float& ballRadius);
 		void GameOver();
 
+		const DX::ViewCuller& ChunkCuller() const;
+
 	private:
+		// Per-instance input, in vertex buffer slot 1. Rotation is not carried; chunks are never rotated.
+		struct ChunkInstance
+		{
+			DirectX::XMFLOAT2 Offset;
+			float Scale;
+			std::uint32_t PaletteIndex;
+
+			// Includes the per-vertex VertexPosition element in slot 0.
+			static const int InputElementCount = 3;
+			static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+		};
+
+		struct CBufferPerFrame
+		{
+			DirectX::XMFLOAT4X4 ViewProjection;
+			DirectX::XMFLOAT4 Palette[PaletteSize];
+		};
+
 		void InitializeTriangleVertices();
+		void InitializeInstanceBuffer();
 		void InitializeChunks();
-		void DrawChunk(const Chunk& chunk);
+		void InitializeLayerQuad();
+		void RebuildInstances();
+		void CreateBrickLayer(std::uint32_t width, std::uint32_t height);
+		void RecordBrickLayerUpdate(DX::RenderCommandList& commandList);
+		void ReleaseBrickLayer();
 
-		static const std::uint32_t CircleResolution;
-		static const std::uint32_t SolidCircleVertexCount;
+		// Bounds are world-space (left, bottom, right, top).
+		DirectX::XMFLOAT4 ChunkBounds(const Chunk& chunk) const;
+
+		static const std::uint32_t ChunkVertexCount;
+		static const DirectX::XMFLOAT4 ChunkObjectBounds;	// Of the quad built by InitializeTriangleVertices
 
-		Microsoft::WRL::ComPtr<ID3D11VertexShader> mVertexShader;
-		Microsoft::WRL::ComPtr<ID3D11PixelShader> mPixelShader;
-		Microsoft::WRL::ComPtr<ID3D11InputLayout> mInputLayout;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> mTriangleVertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mVSCBufferPerObject;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mPSCBufferPerObject;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mInstanceBuffer;
+		std::shared_ptr<DX::D3D11RenderBackend> mRenderBackend;
+		std::shared_ptr<DX::PipelineCache> mPipelineCache;
+		std::shared_ptr<const DX::PipelineCache::Pipeline> mPipeline;
+		DX::MeshHandle mChunkMesh;
+
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mLayerQuadVertexBuffer;
+		std::shared_ptr<const DX::PipelineCache::Pipeline> mLayerPipeline;
+		DX::MeshHandle mLayerQuadMesh;
+		DX::CachedLayer mBrickLayer;
 
 		bool mLoadingComplete;
 		std::vector<std::shared_ptr<Chunk>> mChunks;
+		std::vector<std::uint32_t> mChunkPaletteIndices;	// Parallel to mChunks
+		std::vector<ChunkInstance> mInstances;
+		bool mInstancesDirty;
+		DX::ViewCuller mChunkCuller;
+		std::vector<DX::CullBounds> mChunkCullBounds;		// Parallel to mChunks
+		std::vector<std::uint32_t> mVisibleChunks;
+		bool mChunkCullerDirty;
+		CBufferPerFrame mCBufferPerFrame;
 		std::shared_ptr<Field> mActiveField;
 		ScoreManager& mScoreManager;
 		PowerupManager& mPowerupManager;
-
-		const uint32_t mNumChunks = 60;
-		const int32_t mChunkHeight = 3;
-		const float mChunkWidth = 9.0f;
+		ParticleManager& mParticleManager;
 
 		const std::vector <DirectX::XMFLOAT4> mChunkColors =
 		{
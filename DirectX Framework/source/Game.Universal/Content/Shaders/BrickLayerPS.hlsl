@@ -0,0 +1,16 @@
+Texture2D BrickLayer;
+
+struct VS_OUTPUT
+{
+	float4 Position: SV_Position;
+};
+
+// The layer matches the back buffer pixel for pixel, so it is read without filtering. Bricks are opaque and everything else
+// in the layer is cleared to transparent, so uncovered pixels are dropped rather than blended.
+float4 main(VS_OUTPUT IN) : SV_TARGET
+{
+	float4 color = BrickLayer.Load(int3(IN.Position.xy, 0));
+	clip(color.a - 0.5f);
+
+	return color;
+}
\ No newline at end of file
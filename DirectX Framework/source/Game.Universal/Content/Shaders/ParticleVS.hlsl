@@ -0,0 +1,28 @@
+cbuffer CBufferPerFrame
+{
+	float4x4 ViewProjection;
+}
+
+struct VS_INPUT
+{
+	float4 ObjectPosition: POSITION;
+	float3 InstancePositionRadius: TEXCOORD0;
+	float4 Color: COLOR0;
+};
+
+struct VS_OUTPUT
+{
+	float4 Position: SV_Position;
+	float4 Color: COLOR;
+};
+
+VS_OUTPUT main(VS_INPUT IN)
+{
+	VS_OUTPUT OUT = (VS_OUTPUT)0;
+
+	float4 worldPosition = float4(IN.ObjectPosition.xy * IN.InstancePositionRadius.z + IN.InstancePositionRadius.xy, IN.ObjectPosition.zw);
+	OUT.Position = mul(worldPosition, ViewProjection);
+	OUT.Color = IN.Color;
+
+	return OUT;
+}
@@ -0,0 +1,32 @@
+// Keep PaletteSize in sync with ChunkManager::PaletteSize.
+#define PaletteSize 8
+
+cbuffer CBufferPerFrame
+{
+	float4x4 ViewProjection;
+	float4 Palette[PaletteSize];
+}
+
+struct VS_INPUT
+{
+	float4 ObjectPosition: POSITION;
+	float3 InstanceOffsetScale: TEXCOORD0;
+	uint PaletteIndex: BLENDINDICES0;
+};
+
+struct VS_OUTPUT
+{
+	float4 Position: SV_Position;
+	float4 Color: COLOR;
+};
+
+VS_OUTPUT main(VS_INPUT IN)
+{
+	VS_OUTPUT OUT = (VS_OUTPUT)0;
+
+	float4 worldPosition = float4(IN.ObjectPosition.xy * IN.InstanceOffsetScale.z + IN.InstanceOffsetScale.xy, IN.ObjectPosition.zw);
+	OUT.Position = mul(worldPosition, ViewProjection);
+	OUT.Color = Palette[IN.PaletteIndex % PaletteSize];
+
+	return OUT;
+}
@@ -0,0 +1,37 @@
+cbuffer CBufferPerFrame
+{
+	float4x4 ViewProjection;
+}
+
+struct VS_INPUT
+{
+	float4 ObjectPosition: POSITION;
+	float2 TextureCoordinates : TEXCOORD0;
+	float2 InstancePosition : TEXCOORD1;
+	float2 InstanceScale : TEXCOORD2;
+	float4 InstanceUVRect : TEXCOORD3;
+	float InstanceRotation : TEXCOORD4;
+};
+
+struct VS_OUTPUT
+{
+	float4 Position: SV_Position;
+	float2 TextureCoordinates : TEXCOORD;
+};
+
+VS_OUTPUT main(VS_INPUT IN)
+{
+	VS_OUTPUT OUT = (VS_OUTPUT)0;
+
+	// Scale, rotate about the center, then translate; the same order as Transform2D::WorldMatrix.
+	float2 scaledPosition = IN.ObjectPosition.xy * IN.InstanceScale;
+	float sine;
+	float cosine;
+	sincos(IN.InstanceRotation, sine, cosine);
+	float2 worldPosition = float2(scaledPosition.x * cosine - scaledPosition.y * sine, scaledPosition.x * sine + scaledPosition.y * cosine) + IN.InstancePosition;
+
+	OUT.Position = mul(float4(worldPosition, IN.ObjectPosition.zw), ViewProjection);
+	OUT.TextureCoordinates = lerp(IN.InstanceUVRect.xy, IN.InstanceUVRect.zw, IN.TextureCoordinates);
+
+	return OUT;
+}
\ No newline at end of file
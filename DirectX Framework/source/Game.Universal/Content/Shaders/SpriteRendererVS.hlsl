@@ -1,7 +1,6 @@
 cbuffer CBufferPerObject
 {
 	float4x4 WorldViewProjection;
-	float4x4 TextureTransform;
 }
 
 struct VS_INPUT
@@ -21,7 +20,7 @@ VS_OUTPUT main(VS_INPUT IN)
 	VS_OUTPUT OUT = (VS_OUTPUT)0;
 
 	OUT.Position = mul(IN.ObjectPosition, WorldViewProjection);
-	OUT.TextureCoordinates = mul(float4(IN.TextureCoordinates, 0, 1), TextureTransform).xy;
+	OUT.TextureCoordinates = IN.TextureCoordinates;
 
 	return OUT;
 }
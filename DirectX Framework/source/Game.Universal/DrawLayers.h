@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace DirectXGame
+{
+	// The order the managers' draws are submitted in once the frame's command list is state-sorted; see
+	// DX::RenderCommandList::SetLayer. Draws within a layer may be reordered.
+	enum DrawLayer : std::uint16_t
+	{
+		BrickLayer,		// The cached brick layer, which covers the whole field
+		ShapeLayer,		// The bar, ball and powerups, drawn over it
+		ParticleLayer	// Brick, bounce and catch particles, blended over everything
+	};
+}
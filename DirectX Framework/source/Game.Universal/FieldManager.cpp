@@ -9,11 +9,15 @@ using namespace DX;
 
 namespace DirectXGame
 {
-	FieldManager::FieldManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera) :
-		DrawableGameComponent(deviceResources, camera),
+	FieldManager::FieldManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera, const shared_ptr<PipelineCache>& pipelineCache) :
+		DrawableGameComponent(deviceResources, camera), mPipelineCache(pipelineCache),
 		mLoadingComplete(false), mIndexCount(0)
 	{
-		CreateDeviceDependentResources();
+		// Create the field up front; the other managers hold on to it, so it must survive device loss.
+		const XMFLOAT2 position = Vector2Helper::Zero;
+		const XMFLOAT2 size(90, 80);
+		const XMFLOAT4 color(&Colors::AntiqueWhite[0]);
+		mActiveField = make_shared<Field>(position, size, color);
 	}
 
 	shared_ptr<Field> FieldManager::ActiveField() const
@@ -28,69 +32,12 @@ namespace DirectXGame
 
 	void FieldManager::CreateDeviceDependentResources()
 	{
-		// Create a field
-		const XMFLOAT2 position = Vector2Helper::Zero;
-		const XMFLOAT2 size(90, 80);
-		const XMFLOAT4 color(&Colors::AntiqueWhite[0]);
-		mActiveField = make_shared<Field>(position, size, color);		
-
-		auto loadVSTask = ReadDataAsync(L"ShapeRendererVS.cso");
-		auto loadPSTask = ReadDataAsync(L"ShapeRendererPS.cso");
-
-		// After the vertex shader file is loaded, create the shader and input layout.
-		auto createVSTask = loadVSTask.then([this](const vector<byte>& fileData) {
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateVertexShader(
-					&fileData[0],
-					fileData.size(),
-					nullptr,
-					mVertexShader.ReleaseAndGetAddressOf()
-				)
-			);
-
-			// Create an input layout
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateInputLayout(
-					VertexPosition::InputElements,
-					VertexPosition::InputElementCount,
-					&fileData[0],
-					fileData.size(),
-					mInputLayout.ReleaseAndGetAddressOf()
-				)
-			);
-
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4X4), D3D11_BIND_CONSTANT_BUFFER);
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateBuffer(
-					&constantBufferDesc,
-					nullptr,
-					mVSCBufferPerObject.ReleaseAndGetAddressOf()
-				)
-			);
-		});
+		const PipelineCache::Description description = { L"ShapeRendererVS.cso", L"ShapeRendererPS.cso", VertexPosition::InputElements, VertexPosition::InputElementCount,
+			D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP, sizeof(XMFLOAT4X4), sizeof(XMFLOAT4) };
 
-		// After the pixel shader file is loaded, create the shader and constant buffer.
-		auto createPSTask = loadPSTask.then([this](const vector<byte>& fileData) {
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreatePixelShader(
-					&fileData[0],
-					fileData.size(),
-					nullptr,
-					mPixelShader.ReleaseAndGetAddressOf()
-				)
-			);
-
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4), D3D11_BIND_CONSTANT_BUFFER);
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateBuffer(
-					&constantBufferDesc,
-					nullptr,
-					mPSCBufferPerObject.ReleaseAndGetAddressOf()
-				)
-			);
-		});
+		mPipelineCache->GetPipelineAsync(description).then([this](const shared_ptr<const PipelineCache::Pipeline>& pipeline) {
+			mPipeline = pipeline;
 
-		(createPSTask && createVSTask).then([this]() {
 			// Create a vertex buffer for rendering a box
 			D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
 			const uint32_t boxVertexCount = 4;
@@ -123,13 +70,9 @@ namespace DirectXGame
 	void FieldManager::ReleaseDeviceDependentResources()
 	{
 		mLoadingComplete = false;
-		mVertexShader.Reset();
-		mPixelShader.Reset();
-		mInputLayout.Reset();
-		mVertexBuffer.Reset();
 		mVertexBuffer.Reset();
-		mVSCBufferPerObject.Reset();
-		mPSCBufferPerObject.Reset();
+		mIndexBuffer.Reset();
+		mPipeline.reset();
 	}
 
 	void FieldManager::Render(const StepTimer & timer)
@@ -164,7 +107,7 @@ namespace DirectXGame
 		direct3DDeviceContext->Map(mVertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, NULL, &mappedSubResource);
 		memcpy(mappedSubResource.pData, vertices, sizeof(VertexPosition) * vertexCount);
 		direct3DDeviceContext->Unmap(mVertexBuffer.Get(), 0);
-		direct3DDeviceContext->UpdateSubresource(mPSCBufferPerObject.Get(), 0, nullptr, &field.Color(), 0, 0);
+		direct3DDeviceContext->UpdateSubresource(mPipeline->Resources.PixelConstantBuffer.Get(), 0, nullptr, &field.Color(), 0, 0);
 
 		direct3DDeviceContext->DrawIndexed(mIndexCount, 0, 0);
 	}
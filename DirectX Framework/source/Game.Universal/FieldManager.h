@@ -16,7 +16,7 @@ namespace DirectXGame
 	class FieldManager final : public DX::DrawableGameComponent
 	{
 	public:
-		FieldManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera);
+		FieldManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, const std::shared_ptr<DX::PipelineCache>& pipelineCache);
 				
 		std::shared_ptr<Field> ActiveField() const;
 		void SetActiveField(const std::shared_ptr<Field>& field);
@@ -28,16 +28,10 @@ namespace DirectXGame
 	private:
 		void DrawField(const Field& field);
 
-		static const std::uint32_t CircleResolution;
-		static const std::uint32_t CircleVertexCount;
-
-		Microsoft::WRL::ComPtr<ID3D11VertexShader> mVertexShader;
-		Microsoft::WRL::ComPtr<ID3D11PixelShader> mPixelShader;
-		Microsoft::WRL::ComPtr<ID3D11InputLayout> mInputLayout;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> mVertexBuffer;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> mIndexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mVSCBufferPerObject;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mPSCBufferPerObject;
+		std::shared_ptr<DX::PipelineCache> mPipelineCache;
+		std::shared_ptr<const DX::PipelineCache::Pipeline> mPipeline;
 		bool mLoadingComplete;
 		std::uint32_t mIndexCount;
 		std::shared_ptr<Field> mActiveField;
@@ -1,10 +1,12 @@
 ﻿#include "pch.h"
 #include "GameMain.h"
+#include <fstream>
 
 using namespace DX;
 using namespace std;
 using namespace DirectX;
 using namespace Windows::Foundation;
+using namespace Windows::Storage;
 using namespace Windows::System::Threading;
 using namespace Windows::ApplicationModel::Core;
 using namespace Windows::UI::Core;
@@ -12,9 +14,17 @@ using namespace Concurrency;
 
 namespace DirectXGame
 {
+	const uint64_t GameMain::ZeroAllocationWarmupFrames = 300;
+	const double GameMain::AttractModeDelaySeconds = 10.0;
+	const uint32_t GameMain::CaptureFramesPerSecond = 60;
+	const wstring GameMain::FontFilename = L"Content\\Fonts\\dejavu_sans_32"; // Baked from DejaVu Sans by FontBaker
+
 	// Loads and initializes application assets when the application is loaded.
 	GameMain::GameMain(const shared_ptr<DX::DeviceResources>& deviceResources) :
-		mDeviceResources(deviceResources)
+		mDeviceResources(deviceResources), mRenderBackend(make_shared<D3D11RenderBackend>(deviceResources)), mPipelineCache(make_shared<PipelineCache>(deviceResources, mRenderBackend)),
+		mAssetLoader(make_shared<AssetLoader>(ToUtf8(ApplicationData::Current->LocalFolder->Path->Data()))), mTextOverlay(make_shared<TextOverlay>(deviceResources, mAssetLoader, FontFilename)),
+		mFrameStatistics(make_shared<DX::FrameStatistics>()), mLastPresentTimestamp(0),
+		mAutopilotEnabled(false), mAttractMode(false), mIdleSeconds(0.0)
 	{
 		// Register to be notified if the Device is lost or recreated
 		mDeviceResources->RegisterDeviceNotify(this);
@@ -35,23 +45,30 @@ namespace DirectXGame
 		mGamePad = make_shared<GamePadComponent>(mDeviceResources);
 		mComponents.push_back(mGamePad);
 
-		auto fieldManager = make_shared<FieldManager>(mDeviceResources, camera);
+		auto fieldManager = make_shared<FieldManager>(mDeviceResources, camera, mPipelineCache);
 		mComponents.push_back(fieldManager);
 
-		mScoreManager = make_shared<ScoreManager>(mDeviceResources);
+		mScoreManager = make_shared<ScoreManager>(mDeviceResources, mTextOverlay);
+
+		mParticleManager = make_shared<ParticleManager>(mDeviceResources, camera, mRenderBackend, mPipelineCache);
 
-		mBarManager = make_shared<BarManager>(mDeviceResources, camera);
+		mBarManager = make_shared<BarManager>(mDeviceResources, camera, mRenderBackend, mPipelineCache, *mParticleManager);
 		mBarManager->SetActiveField(fieldManager->ActiveField());
 
-		auto powerupManager = make_shared<PowerupManager>(mDeviceResources, camera, *mBarManager);
+		auto powerupManager = make_shared<PowerupManager>(mDeviceResources, camera, mRenderBackend, mPipelineCache, *mBarManager, *mParticleManager);
 		powerupManager->SetActiveField(fieldManager->ActiveField());
 		mComponents.push_back(powerupManager);
 
-		auto chunkManager = make_shared<ChunkManager>(mDeviceResources, camera, *mScoreManager, *powerupManager);
-		chunkManager->SetActiveField(fieldManager->ActiveField());
-		mComponents.push_back(chunkManager);
+		mChunkManager = make_shared<ChunkManager>(mDeviceResources, camera, mRenderBackend, mPipelineCache, *mScoreManager, *powerupManager, *mParticleManager);
+		mChunkManager->SetActiveField(fieldManager->ActiveField());
+		mComponents.push_back(mChunkManager);
+
+		mComponents.push_back(mParticleManager);
+
+		auto fpsTextRenderer = make_shared<FpsTextRenderer>(mDeviceResources, mTextOverlay, mFrameStatistics);
+		mComponents.push_back(fpsTextRenderer);
 
-		mBallManager = make_shared<BallManager>(mDeviceResources, camera, *chunkManager, *mBarManager);
+		mBallManager = make_shared<BallManager>(mDeviceResources, camera, mRenderBackend, mPipelineCache, *mChunkManager, *mBarManager);
 		mBallManager->SetActiveField(fieldManager->ActiveField());
 
 		powerupManager->SetBallManager(mBallManager);
@@ -79,11 +96,18 @@ namespace DirectXGame
 	// Updates the application state once per frame.
 	void GameMain::Update()
 	{
+		const int64_t updateStart = Profiler::Timestamp();
+		AllocationTracker::BeginTick();
+		mFrameArena.BeginFrame();
+
 		// Update scene objects.
 		mTimer.Tick([&]()
 		{
+			DX_PROFILE_ZONE("GameMain::Update");
+
 			for (auto& component : mComponents)
 			{
+				DX_PROFILE_ZONE(typeid(*component).name());
 				component->Update(mTimer);
 			}
 
@@ -91,17 +115,52 @@ namespace DirectXGame
 				mMouse->WasButtonPressedThisFrame(MouseButtons::Middle) ||
 				mGamePad->WasButtonPressedThisFrame(GamePadButtons::Back))
 			{
+				WriteDiagnostics();
 				CoreApplication::Exit();
 			}
 
+			//Autopilot toggle, for soak runs and benchmarks
+			if (mKeyboard->WasKeyPressedThisFrame(Keys::P) || mGamePad->WasButtonPressedThisFrame(GamePadButtons::Y))
+			{
+				mAutopilotEnabled = !mAutopilotEnabled;
+				mAttractMode = false;
+			}
+
+			//Frame capture toggle: records the screen to Capture.y4m in the local folder
+			if (mKeyboard->WasKeyPressedThisFrame(Keys::F9))
+			{
+				ToggleFrameCapture();
+			}
+
 			//Bar movement
-			if (mKeyboard->IsKeyHeldDown(Keys::D) || mGamePad->CurrentState().IsLeftThumbStickRight())
+			bool moveRight = (mKeyboard->IsKeyHeldDown(Keys::D) || mGamePad->CurrentState().IsLeftThumbStickRight());
+			bool moveLeft = (mKeyboard->IsKeyHeldDown(Keys::A) || mGamePad->CurrentState().IsLeftThumbStickLeft());
+
+			if (moveRight || moveLeft)
+			{
+				// A player taking the bar ends attract mode.
+				mIdleSeconds = 0.0;
+				if (mAttractMode)
+				{
+					mAttractMode = false;
+					mAutopilotEnabled = false;
+				}
+			}
+			else if (mAutopilotEnabled && mBallManager->LaunchedBall())
+			{
+				// The autopilot steers through the same calls as the keyboard and gamepad.
+				const BarAutopilot::Command command = AutopilotCommand();
+				moveRight = (command == BarAutopilot::Command::MoveRight);
+				moveLeft = (command == BarAutopilot::Command::MoveLeft);
+			}
+
+			if (moveRight)
 			{
 				mBarManager->MoveRight();
 				mBarManager->Update(mTimer);
 			}
 
-			if (mKeyboard->IsKeyHeldDown(Keys::A) || mGamePad->CurrentState().IsLeftThumbStickLeft())
+			if (moveLeft)
 			{
 				mBarManager->MoveLeft();
 				mBarManager->Update(mTimer);
@@ -109,23 +168,39 @@ namespace DirectXGame
 
 			if (mKeyboard->WasKeyPressedThisFrame(Keys::Space) && !mBallManager->LaunchedBall())
 			{
-				mBallManager->LaunchBall();
-				mScoreManager->SetBallLaunched();
+				LaunchBall();
 			}
 
 			if (mGamePad->WasButtonPressedThisFrame(GamePadButtons::A) && !mBallManager->LaunchedBall())
 			{
-				mBallManager->LaunchBall();
-				mScoreManager->SetBallLaunched();
+				LaunchBall();
 			}
 
-			mScoreManager->Update(mTimer);
+			//Attract mode: after idling on the launch screen, launch the ball and let the autopilot play
+			if (!mBallManager->LaunchedBall())
+			{
+				mIdleSeconds += mTimer.GetElapsedSeconds();
+				if (mIdleSeconds >= AttractModeDelaySeconds)
+				{
+					mAttractMode = true;
+					mAutopilotEnabled = true;
+					LaunchBall();
+				}
+			}
+
+			{
+				DX_PROFILE_ZONE("ScoreManager::Update");
+				mScoreManager->Update(mTimer);
+			}
 
 			if (!mScoreManager->IsGameOver())
 			{
+				DX_PROFILE_ZONE("BallManager::Update");
 				mBallManager->Update(mTimer);
 			}
 		});
+
+		mFrameStatistics->Record(DX::FrameStatistics::Metric::Update, updateStart, Profiler::Timestamp());
 	}
 
 	// Renders the current frame according to the current application state.
@@ -135,9 +210,13 @@ namespace DirectXGame
 		// Don't try to render anything before the first Update.
 		if (mTimer.GetFrameCount() == 0)
 		{
+			EndAllocationTick();
 			return false;
 		}
 
+		DX_PROFILE_ZONE("GameMain::Render");
+		const int64_t renderStart = Profiler::Timestamp();
+
 		auto context = mDeviceResources->GetD3DDeviceContext();
 
 		// Reset the viewport to target the whole screen.
@@ -152,29 +231,123 @@ namespace DirectXGame
 		context->ClearRenderTargetView(mDeviceResources->GetBackBufferRenderTargetView(), DirectX::Colors::Black);
 		context->ClearDepthStencilView(mDeviceResources->GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
+		// Gather this frame's visible drawables into frame-transient storage.
+		vector<DrawableGameComponent*, ArenaAllocator<DrawableGameComponent*>> drawableComponents{ ArenaAllocator<DrawableGameComponent*>(mFrameArena.Current()) };
+		drawableComponents.reserve(mComponents.size());
 		for (auto& component : mComponents)
 		{
-			auto drawableComponent = dynamic_pointer_cast<DrawableGameComponent>(component);
+			auto drawableComponent = dynamic_cast<DrawableGameComponent*>(component.get());
 			if (drawableComponent != nullptr && drawableComponent->Visible())
 			{
-				drawableComponent->Render(mTimer);
+				drawableComponents.push_back(drawableComponent);
 			}
 		}
 
-		mBarManager->Render(mTimer);
-		mBallManager->Render(mTimer);
-		mScoreManager->Render(mTimer);
+		// Geometry is recorded first, sorted by state and executed as one command list; the text overlays queued by the
+		// components' Render follow on top of it, in one sprite batch. Offscreen draws, such as the brick layer's update,
+		// go ahead of every back buffer draw, so the render target switches around them can't split the layers.
+		mRenderCommands.Clear();
+		{
+			DX_PROFILE_ZONE("RecordOffscreenDraws");
+			for (DrawableGameComponent* drawableComponent : drawableComponents)
+			{
+				drawableComponent->RecordOffscreenDraws(mTimer, mRenderCommands);
+			}
+		}
+
+		for (DrawableGameComponent* drawableComponent : drawableComponents)
+		{
+			DX_PROFILE_ZONE(typeid(*drawableComponent).name());
+			drawableComponent->RecordDraws(mTimer, mRenderCommands);
+		}
+
+		{
+			DX_PROFILE_ZONE("BarManager::RecordDraws");
+			mBarManager->RecordDraws(mTimer, mRenderCommands);
+		}
+
+		{
+			DX_PROFILE_ZONE("BallManager::RecordDraws");
+			mBallManager->RecordDraws(mTimer, mRenderCommands);
+		}
+
+		{
+			DX_PROFILE_ZONE("DrawSorter::Sort");
+			mDrawSorter.Sort(mRenderCommands, mSortedRenderCommands);
+		}
+
+		mRenderBackend->Execute(mSortedRenderCommands);
+		mRenderBackend->EndFrame();
+
+		for (DrawableGameComponent* drawableComponent : drawableComponents)
+		{
+			DX_PROFILE_ZONE(typeid(*drawableComponent).name());
+			drawableComponent->Render(mTimer);
+		}
+
+		{
+			DX_PROFILE_ZONE("ScoreManager::Render");
+			mScoreManager->Render(mTimer);
+		}
+
+		{
+			DX_PROFILE_ZONE("TextOverlay::Render");
+			const int64_t textStart = Profiler::Timestamp();
+			mTextOverlay->Render(mTimer);
+			mFrameStatistics->Record(DX::FrameStatistics::Metric::Text, textStart, Profiler::Timestamp());
+		}
+
+		mFrameStatistics->Record(DX::FrameStatistics::Metric::Render, renderStart, Profiler::Timestamp());
+
+		// Captured after the text overlay, so recordings show the score and statistics too.
+		if (mFrameCapture != nullptr)
+		{
+			const int64_t captureStart = Profiler::Timestamp();
+			mFrameCapture->CaptureBackBuffer();
+			mFrameStatistics->Record(DX::FrameStatistics::Metric::Capture, captureStart, Profiler::Timestamp());
+		}
+
+		EndAllocationTick();
 
 		return true;
 	}
 
+	// Presents the rendered frame and records the present and whole-frame durations.
+	void GameMain::Present()
+	{
+		const int64_t presentStart = Profiler::Timestamp();
+
+		{
+			DX_PROFILE_ZONE("DeviceResources::Present");
+			mDeviceResources->Present();
+		}
+
+		const int64_t presentEnd = Profiler::Timestamp();
+		mFrameStatistics->Record(DX::FrameStatistics::Metric::Present, presentStart, presentEnd);
+
+		if (mLastPresentTimestamp != 0)
+		{
+			mFrameStatistics->Record(DX::FrameStatistics::Metric::Frame, mLastPresentTimestamp, presentEnd);
+		}
+
+		mLastPresentTimestamp = presentEnd;
+	}
+
 	// Notifies renderers that device resources need to be released.
 	void GameMain::OnDeviceLost()
 	{
+		mFrameCapture.reset();
+
 		for (auto& component : mComponents)
 		{
 			component->ReleaseDeviceDependentResources();
 		}
+
+		mBarManager->ReleaseDeviceDependentResources();
+		mBallManager->ReleaseDeviceDependentResources();
+		mTextOverlay->ReleaseDeviceDependentResources();
+		mPipelineCache->ReleaseDeviceDependentResources();
+		mRenderBackend->ReleaseDeviceDependentResources();
 	}
 
 	// Notifies renderers that device resources may now be recreated.
@@ -190,6 +363,112 @@ namespace DirectXGame
 			component->CreateDeviceDependentResources();
 		}
 
+		// The bar and ball are updated and drawn explicitly, outside the component list.
+		mBarManager->CreateDeviceDependentResources();
+		mBallManager->CreateDeviceDependentResources();
+		mTextOverlay->CreateDeviceDependentResources();
+
 		CreateWindowSizeDependentResources();
 	}
+
+	// Gathers the ball, bar and field state the autopilot steers from.
+	BarAutopilot::Command GameMain::AutopilotCommand() const
+	{
+		const auto ball = mBallManager->ActiveBall();
+		const auto field = mBallManager->ActiveField();
+		const XMFLOAT2& fieldPosition = field->Position();
+		const XMFLOAT2& fieldSize = field->Size();
+
+		BarAutopilot::State state;
+		state.BallPosition = ball->Transform().Position();
+		state.BallVelocity = ball->Velocity();
+		state.BallRadius = ball->Radius();
+		state.BarX = mBarManager->BarPosition().x;
+		state.BarWidth = mBarManager->BarCatchWidth();
+		state.CatchY = mBarManager->CatchLineY() + ball->Radius();
+		state.FieldLeft = fieldPosition.x - (fieldSize.x / 2.0f);
+		state.FieldRight = fieldPosition.x + (fieldSize.x / 2.0f);
+		state.FieldTop = fieldPosition.y + (fieldSize.y / 2.0f);
+
+		return BarAutopilot::Decide(state);
+	}
+
+	// Every launch, by the player or by attract mode, restarts the idle time, so time spent on the launch screen before one
+	// launch doesn't count toward the next attract mode.
+	void GameMain::LaunchBall()
+	{
+		mBallManager->LaunchBall();
+		mScoreManager->SetBallLaunched();
+		mIdleSeconds = 0.0;
+	}
+
+	// Closes the allocation tick opened by Update. With DX_ZERO_ALLOCATION_TICKS defined, a steady-state tick that allocates
+	// is a failure: the offending call sites are written to the allocation report and the game stops.
+	void GameMain::EndAllocationTick()
+	{
+		const AllocationTracker::Counters tick = AllocationTracker::EndTick();
+
+#if defined(DX_ZERO_ALLOCATION_TICKS)
+		if (AllocationTracker::ZeroAllocationTicks())
+		{
+			if (tick.Allocations > 0)
+			{
+				WriteDiagnostics();
+				throw ref new Platform::FailureException(L"A steady-state tick allocated memory. See AllocationReport.txt.");
+			}
+		}
+		else if (mTimer.GetFrameCount() >= ZeroAllocationWarmupFrames)
+		{
+			AllocationTracker::SetZeroAllocationTicks(true);
+		}
+#else
+		UNREFERENCED_PARAMETER(tick);
+#endif
+	}
+
+	// Starts recording live play, dropping frames rather than holding up the game if the encoder falls behind, or finishes
+	// the recording in progress.
+	void GameMain::ToggleFrameCapture()
+	{
+		if (mFrameCapture != nullptr)
+		{
+			mFrameCapture.reset();
+			return;
+		}
+
+		const wstring localFolder(ApplicationData::Current->LocalFolder->Path->Data());
+		mFrameCapture = make_unique<D3D11FrameCapture>(mDeviceResources, ToUtf8(localFolder + L"\\Capture.y4m"), FrameCapture::Format::Y4m, CaptureFramesPerSecond);
+	}
+
+	// Writes frame statistics, allocation and profiling data to the application's local folder.
+	void GameMain::WriteDiagnostics()
+	{
+		// Diagnostics can be written from inside a tick; writing them must not count against zero-allocation ticks.
+		AllocationTracker::SetZeroAllocationTicks(false);
+
+		const wstring localFolder(ApplicationData::Current->LocalFolder->Path->Data());
+		mFrameStatistics->WriteReport(localFolder + L"\\FrameStatistics.txt");
+		mPipelineCache->WriteReport(localFolder + L"\\PipelineCache.txt");
+		mRenderBackend->WriteReport(localFolder + L"\\RenderBackend.txt");
+
+		ofstream drawSorterStream(localFolder + L"\\DrawSorter.txt", ios::out | ios::trunc);
+		mDrawSorter.WriteReport(drawSorterStream);
+
+		ofstream viewCullingStream(localFolder + L"\\ViewCulling.txt", ios::out | ios::trunc);
+		mChunkManager->ChunkCuller().WriteReport(viewCullingStream);
+
+		ofstream textStream(localFolder + L"\\Text.txt", ios::out | ios::trunc);
+		mTextOverlay->WriteReport(textStream);
+
+		ofstream particleStream(localFolder + L"\\Particles.txt", ios::out | ios::trunc);
+		mParticleManager->Particles().WriteReport(particleStream);
+
+#if DX_ALLOCATION_TRACKING_ENABLED
+		AllocationTracker::WriteReport(localFolder + L"\\AllocationReport.txt");
+#endif
+
+#if DX_PROFILING_ENABLED
+		Profiler::WriteChromeTrace(localFolder + L"\\GameTrace.json");
+#endif
+	}
 }
\ No newline at end of file
@@ -2,11 +2,21 @@
 
 #include "StepTimer.h"
 #include "DeviceResources.h"
+#include "FrameArena.h"
+#include "RenderCommandList.h"
+#include "DrawSorter.h"
+#include "BarAutopilot.h"
 #include <vector>
 #include <memory>
 
 namespace DX
 {
+	class D3D11RenderBackend;
+	class D3D11FrameCapture;
+	class PipelineCache;
+	class AssetLoader;
+	class TextOverlay;
+	class FrameStatistics;
 	class GameComponent;
 	class MouseComponent;
 	class KeyboardComponent;
@@ -24,22 +34,50 @@ namespace DirectXGame
 		void CreateWindowSizeDependentResources();
 		void Update();
 		bool Render();
+		void Present();
 
 		virtual void OnDeviceLost();
 		virtual void OnDeviceRestored();
 
 	private:
 		void IntializeResources();
+		BarAutopilot::Command AutopilotCommand() const;
+		void LaunchBall();
+		void EndAllocationTick();
+		void WriteDiagnostics();
+		void ToggleFrameCapture();
+
+		static const std::uint64_t ZeroAllocationWarmupFrames;
+		static const double AttractModeDelaySeconds;
+		static const std::uint32_t CaptureFramesPerSecond;
+		static const std::wstring FontFilename;
 
 		std::shared_ptr<DX::DeviceResources> mDeviceResources;
 		std::vector<std::shared_ptr<DX::GameComponent>> mComponents;
 		DX::StepTimer mTimer;
+		DX::FrameArena mFrameArena;
+		std::shared_ptr<DX::D3D11RenderBackend> mRenderBackend;
+		std::shared_ptr<DX::PipelineCache> mPipelineCache;
+		std::shared_ptr<DX::AssetLoader> mAssetLoader;
+		std::shared_ptr<DX::TextOverlay> mTextOverlay;
+		DX::RenderCommandList mRenderCommands;
+		DX::DrawSorter mDrawSorter;
+		DX::RenderCommandList mSortedRenderCommands;
+		std::shared_ptr<DX::FrameStatistics> mFrameStatistics;
+		std::unique_ptr<DX::D3D11FrameCapture> mFrameCapture;
+		std::int64_t mLastPresentTimestamp;
 		std::shared_ptr<DX::KeyboardComponent> mKeyboard;
 		std::shared_ptr<DX::MouseComponent> mMouse;
 		std::shared_ptr<DX::GamePadComponent> mGamePad;
 
 		std::shared_ptr<BarManager> mBarManager;
 		std::shared_ptr<BallManager> mBallManager;
+		std::shared_ptr<ChunkManager> mChunkManager;
 		std::shared_ptr<ScoreManager> mScoreManager;
+		std::shared_ptr<ParticleManager> mParticleManager;
+
+		bool mAutopilotEnabled;
+		bool mAttractMode;
+		double mIdleSeconds;
 	};
 }
\ No newline at end of file
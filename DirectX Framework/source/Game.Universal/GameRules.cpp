@@ -0,0 +1,47 @@
+#include "GameRules.h"
+
+namespace DirectXGame
+{
+	// Out-of-class definitions, for the constants bound to references (std::min, std::max and the like).
+	constexpr float GameRules::StepSeconds;
+	constexpr float GameRules::FieldLeft;
+	constexpr float GameRules::FieldRight;
+	constexpr float GameRules::FieldTop;
+	constexpr float GameRules::BallRadius;
+	constexpr float GameRules::BallStartX;
+	constexpr float GameRules::BallStartY;
+	constexpr float GameRules::BallLaunchSpeed;
+	constexpr float GameRules::BallBottomZone;
+	constexpr float GameRules::BallLostY;
+	constexpr float GameRules::ChunkZone;
+	constexpr float GameRules::BarY;
+	constexpr float GameRules::BarStartX;
+	constexpr float GameRules::BarStartSpeed;
+	constexpr float GameRules::BarCatchWidth;
+	constexpr float GameRules::BarHalfWidth;
+	constexpr float GameRules::BarLeftLimit;
+	constexpr float GameRules::BarRightLimit;
+	constexpr float GameRules::BarCatchOffset;
+	constexpr float GameRules::BarReboundOffset;
+	constexpr float GameRules::BarHeight;
+	constexpr float GameRules::ChunkLeft;
+	constexpr float GameRules::ChunkTopRowY;
+	constexpr float GameRules::ChunkWidth;
+	constexpr float GameRules::ChunkHeight;
+	constexpr float GameRules::ChunkScale;
+	constexpr float GameRules::ChunkCatchOffset;
+	constexpr float GameRules::ChunkReboundOffset;
+	constexpr float GameRules::PowerupSpawnOffsetX;
+	constexpr float GameRules::PowerupWidth;
+	constexpr float GameRules::PowerupHeight;
+	constexpr float GameRules::PowerupFallSpeed;
+	constexpr float GameRules::PowerupBallSpeedStep;
+	constexpr float GameRules::PowerupBarSpeedIncrease;
+	constexpr float GameRules::PowerupBarSpeedDecrease;
+	constexpr float GameRules::AutopilotDeadZone;
+	constexpr float GameRules::CatchY;
+	const std::uint32_t GameRules::ChunkRows;
+	const std::uint32_t GameRules::ChunkColumns;
+	const std::uint32_t GameRules::ChunkCount;
+	const std::int32_t GameRules::NoChunk;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+
+namespace DirectXGame
+{
+	// The game's rules in world units, as FieldManager, Ball, BallManager, Bar, BarManager, ChunkManager and PowerupManager
+	// play them at a fixed 60 Hz step, one step of play under them, and the autopilot that steers the bar by them. The
+	// headless simulations (BatchEnvironment and the tools) and BarAutopilot share this one copy. This file only depends
+	// on the C++ standard library so it can be built for headless (non-Windows) hosts.
+	class GameRules final
+	{
+	public:
+		static constexpr float StepSeconds = 1.0f / 60.0f;
+
+		static constexpr float FieldLeft = -45.0f;
+		static constexpr float FieldRight = 45.0f;
+		static constexpr float FieldTop = 40.0f;
+
+		static constexpr float BallRadius = 1.5f;
+		static constexpr float BallStartX = 0.0f;
+		static constexpr float BallStartY = -52.5f;
+		static constexpr float BallLaunchSpeed = 17.0f;
+		static constexpr float BallBottomZone = -40.0f;		// Bottom of the ball at which the bar is checked
+		static constexpr float BallLostY = -60.0f;			// Bottom of the ball at which the game is over
+		static constexpr float ChunkZone = 22.0f;			// Top of the ball at which chunks are checked
+
+		static constexpr float BarY = 15.0f;
+		static constexpr float BarStartX = -6.0f;
+		static constexpr float BarStartSpeed = 20.0f;
+		static constexpr float BarCatchWidth = 8.0f;
+		static constexpr float BarHalfWidth = 4.0f;
+		static constexpr float BarLeftLimit = -52.0f;
+		static constexpr float BarRightLimit = 40.0f;
+		static constexpr float BarCatchOffset = 57.0f;
+		static constexpr float BarReboundOffset = 54.0f;
+		static constexpr float BarHeight = 2.0f;			// Between BarManager's BarUpperY and BarLowerY
+
+		static const std::uint32_t ChunkRows = 6;
+		static const std::uint32_t ChunkColumns = 10;
+		static const std::uint32_t ChunkCount = ChunkRows * ChunkColumns;
+		static constexpr float ChunkLeft = -45.0f;
+		static constexpr float ChunkTopRowY = 97.0f;
+		static constexpr float ChunkWidth = 9.0f;
+		static constexpr float ChunkHeight = 3.0f;
+		static constexpr float ChunkScale = 1.5f;			// Of the chunk quad, which is 6 x 2 units unscaled
+		static constexpr float ChunkCatchOffset = 57.0f;
+		static constexpr float ChunkReboundOffset = 58.0f;
+
+		static constexpr float PowerupSpawnOffsetX = 2.0f;
+		static constexpr float PowerupWidth = 3.0f;
+		static constexpr float PowerupHeight = 2.0f;
+		static constexpr float PowerupFallSpeed = 10.0f;
+		static constexpr float PowerupBallSpeedStep = 5.0f;		// FasterBall and SlowerBall, along each axis
+		static constexpr float PowerupBarSpeedIncrease = 30.0f;	// FasterBar
+		static constexpr float PowerupBarSpeedDecrease = 5.0f;	// SlowerBar
+
+		// The bar's input for a step, from the player or the autopilot.
+		enum class AutopilotCommand
+		{
+			None,
+			MoveLeft,
+			MoveRight
+		};
+
+		// One game's ball and bar, as the headless simulations step them.
+		struct PlayState
+		{
+			float BallX;
+			float BallY;
+			float BallVelocityX;
+			float BallVelocityY;
+			float BarX;			// Left edge of the bar's catch span
+			float BarVelocityX;
+		};
+
+		// What StepBall found, besides the bounces it already applied.
+		struct BallStepResult
+		{
+			bool Caught;		// The bar caught the ball
+			bool InChunkZone;	// The ball is up among the chunks; StepChunks handles them and the top of the field
+			bool Lost;			// The ball fell past BallLostY, which ends the game
+		};
+
+		static const std::int32_t NoChunk = -1;
+
+		// Everything the autopilot needs to know about one game.
+		struct AutopilotState
+		{
+			float BallX;
+			float BallY;
+			float BallVelocityX;
+			float BallVelocityY;
+			float BallRadius;
+			float BarX;			// Left edge of the bar's catch span
+			float AimX;			// Point on the bar, measured from BarX, to line up with the landing point
+			float CatchY;		// Ball center height at which the bar catches it
+			float FieldLeft;
+			float FieldRight;
+			float FieldTop;
+		};
+
+		// Distance from the target within which the bar is left alone, so it doesn't oscillate around it.
+		static constexpr float AutopilotDeadZone = 1.0f;
+
+		// Ball center height at which the bar catches it, under these rules.
+		static constexpr float CatchY = BarY - BarCatchOffset + BallRadius;
+
+		// Returns the ball's x coordinate when it next descends to CatchY, bouncing off the side walls and, when the ball
+		// is rising, off the top of the field. The landing point is predicted in closed form by unfolding the ball's path
+		// across the side walls, so a decision costs a handful of arithmetic operations and touches no game objects. Inline,
+		// since the simulations make one decision per game per step.
+		static float PredictLandingX(const AutopilotState& state);
+
+		// Moves the bar toward lining up AimX with the landing point.
+		static AutopilotCommand DecideAutopilot(const AutopilotState& state);
+
+		// Moves the bar for one step, as MoveLeft/MoveRight and Bar::Update do: a command turns the bar's velocity toward
+		// it, and the bar only moves while a command is given.
+		static void StepBar(PlayState& state, AutopilotCommand command);
+
+		// Moves the ball for one step and bounces it off the side walls and the bar, as Ball::Update,
+		// Ball::CheckForFieldCollision and BarManager::HandleBallCollision do.
+		static BallStepResult StepBall(PlayState& state);
+
+		// For a ball in the chunk zone, breaks the first standing chunk it touches in ChunkManager::HandleBallCollision's
+		// order, clears it from chunkMask and bounces the ball off it, returning its index (row * ChunkColumns + column).
+		// Otherwise bounces the ball off the top of the field if it got there and returns NoChunk.
+		static std::int32_t StepChunks(PlayState& state, std::uint64_t& chunkMask);
+
+		// Folds x into [minX, maxX] as if it had bounced back and forth between the two.
+		static float ReflectIntoRange(float x, float minX, float maxX);
+
+		GameRules() = delete;
+		GameRules(const GameRules&) = delete;
+		GameRules& operator=(const GameRules&) = delete;
+		GameRules(GameRules&&) = delete;
+		GameRules& operator=(GameRules&&) = delete;
+		~GameRules() = default;
+	};
+}
+
+#include "GameRules.inl"
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace DirectXGame
+{
+	inline float GameRules::PredictLandingX(const AutopilotState& state)
+	{
+		if (state.BallVelocityY == 0.0f)
+		{
+			return state.BallX;
+		}
+
+		// Time until the ball is back down at the catch line. A rising ball first travels up to the top of the field and back.
+		float time;
+		if (state.BallVelocityY < 0.0f)
+		{
+			time = (state.BallY - state.CatchY) / -state.BallVelocityY;
+		}
+		else
+		{
+			const float ceiling = state.FieldTop - state.BallRadius;
+			time = ((ceiling - state.BallY) + (ceiling - state.CatchY)) / state.BallVelocityY;
+		}
+
+		// Travel in a straight line as if the walls weren't there, then fold the result back into the field.
+		const float unfoldedX = state.BallX + state.BallVelocityX * time;
+
+		return ReflectIntoRange(unfoldedX, state.FieldLeft + state.BallRadius, state.FieldRight - state.BallRadius);
+	}
+
+	inline GameRules::AutopilotCommand GameRules::DecideAutopilot(const AutopilotState& state)
+	{
+		const float landingX = PredictLandingX(state);
+
+		const float targetBarX = landingX - state.AimX;
+		const float offset = targetBarX - state.BarX;
+
+		if (offset > AutopilotDeadZone)
+		{
+			return AutopilotCommand::MoveRight;
+		}
+
+		if (offset < -AutopilotDeadZone)
+		{
+			return AutopilotCommand::MoveLeft;
+		}
+
+		return AutopilotCommand::None;
+	}
+
+	inline void GameRules::StepBar(PlayState& state, AutopilotCommand command)
+	{
+		if (command == AutopilotCommand::None)
+		{
+			return;
+		}
+
+		const float speed = std::fabs(state.BarVelocityX);
+		state.BarVelocityX = (command == AutopilotCommand::MoveRight ? speed : -speed);
+
+		float barX = state.BarX + state.BarVelocityX * StepSeconds;
+		if (barX - BarHalfWidth <= BarLeftLimit)
+		{
+			barX = BarLeftLimit + BarHalfWidth;
+		}
+
+		if (barX + BarHalfWidth >= BarRightLimit)
+		{
+			barX = BarRightLimit - BarHalfWidth;
+		}
+
+		state.BarX = barX;
+	}
+
+	inline GameRules::BallStepResult GameRules::StepBall(PlayState& state)
+	{
+		BallStepResult result = { false, false, false };
+
+		const float x = state.BallX + state.BallVelocityX * StepSeconds;
+		const float y = state.BallY + state.BallVelocityY * StepSeconds;
+		state.BallX = x;
+		state.BallY = y;
+
+		// The checks are exclusive, in the same order as Ball::CheckForFieldCollision.
+		if (x - BallRadius <= FieldLeft)
+		{
+			state.BallVelocityX = -state.BallVelocityX;
+			state.BallX = FieldLeft + BallRadius;
+		}
+		else if (x + BallRadius >= FieldRight)
+		{
+			state.BallVelocityX = -state.BallVelocityX;
+			state.BallX = FieldRight - BallRadius;
+		}
+		else if (y - BallRadius <= BallBottomZone)
+		{
+			// BarManager::HandleBallCollision; the side of the bar that is hit turns the ball back toward that side.
+			const float barX = state.BarX;
+			if (y - BallRadius + BarCatchOffset <= BarY && barX <= x - BallRadius && x + BallRadius <= barX + BarCatchWidth)
+			{
+				const bool leftHalf = (x <= barX + BarHalfWidth);
+				if ((leftHalf && state.BallVelocityX > 0.0f) || (!leftHalf && state.BallVelocityX < 0.0f))
+				{
+					state.BallVelocityX = -state.BallVelocityX;
+				}
+
+				state.BallVelocityY = -state.BallVelocityY;
+				state.BallY = BarY - BarReboundOffset;
+				result.Caught = true;
+			}
+		}
+		else if (y + BallRadius >= ChunkZone)
+		{
+			result.InChunkZone = true;
+		}
+
+		// Ball::Update tests the position it moved to, before any bounce.
+		result.Lost = (y - BallRadius <= BallLostY);
+
+		return result;
+	}
+
+	inline std::int32_t GameRules::StepChunks(PlayState& state, std::uint64_t& chunkMask)
+	{
+		const float x = state.BallX;
+		const float y = state.BallY;
+
+		// Only the chunks in the column under the ball, or on either side of it when it is on a boundary, can be touched;
+		// the neighbours are tested exactly rather than trusting the rounding of the division.
+		const std::int32_t column = static_cast<std::int32_t>(std::floor((x - ChunkLeft) / ChunkWidth));
+		const std::int32_t rightColumn = std::min(column + 1, static_cast<std::int32_t>(ChunkColumns) - 1);
+		const std::int32_t leftColumn = std::max(column - 1, 0);
+
+		// ChunkManager::HandleBallCollision visits the bottom row first and, within a row, the rightmost chunk first.
+		for (std::int32_t row = ChunkRows - 1; row >= 0; --row)
+		{
+			const float chunkY = ChunkTopRowY - static_cast<float>(row) * ChunkHeight;
+			if (y + BallRadius + ChunkCatchOffset < chunkY - ChunkHeight)
+			{
+				// Rows above this one are higher still.
+				break;
+			}
+
+			for (std::int32_t candidate = rightColumn; candidate >= leftColumn; --candidate)
+			{
+				const float chunkX = ChunkLeft + static_cast<float>(candidate) * ChunkWidth;
+				const std::int32_t chunk = row * static_cast<std::int32_t>(ChunkColumns) + candidate;
+				const std::uint64_t bit = static_cast<std::uint64_t>(1) << chunk;
+				if ((chunkMask & bit) != 0 && chunkX <= x && x <= chunkX + ChunkWidth)
+				{
+					chunkMask &= ~bit;
+					state.BallVelocityY = -state.BallVelocityY;
+					state.BallY = (chunkY - ChunkHeight) - ChunkReboundOffset;
+					return chunk;
+				}
+			}
+		}
+
+		if (y + BallRadius >= FieldTop)
+		{
+			state.BallVelocityY = -state.BallVelocityY;
+			state.BallY = FieldTop - BallRadius;
+		}
+
+		return NoChunk;
+	}
+
+	inline float GameRules::ReflectIntoRange(float x, float minX, float maxX)
+	{
+		const float width = maxX - minX;
+		if (width <= 0.0f)
+		{
+			return minX;
+		}
+
+		// Positions repeat every two widths; the second half of each period is the mirrored pass.
+		float phase = std::fmod(x - minX, 2.0f * width);
+		if (phase < 0.0f)
+		{
+			phase += 2.0f * width;
+		}
+
+		return (phase <= width ? minX + phase : maxX - (phase - width));
+	}
+}
@@ -2,12 +2,11 @@
 #include "MoodySprite.h"
 
 using namespace DX;
-using namespace DirectX;
 
 namespace DirectXGame
 {
-	MoodySprite::MoodySprite(uint32_t spriteIndex, const Transform2D & transform, Moods mood, const XMFLOAT4X4& textureTransform) :
-		mSpriteIndex(spriteIndex), mTransform(transform), mMood(mood), mTextureTransform(textureTransform)
+	MoodySprite::MoodySprite(uint32_t spriteIndex, const Transform2D & transform, Moods mood) :
+		mTransform(transform), mMood(mood), mSpriteIndex(spriteIndex)
 	{
 	}
 
@@ -40,14 +39,4 @@ namespace DirectXGame
 	{
 		mMood = mood;
 	}
-
-	const XMFLOAT4X4& MoodySprite::TextureTransform() const
-	{
-		return mTextureTransform;
-	}
-
-	void MoodySprite::SetTextureTransform(const XMFLOAT4X4& transform)
-	{
-		mTextureTransform = transform;
-	}
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "Transform2D.h"
-#include "MatrixHelper.h"
 
 namespace DirectXGame
 {
@@ -16,7 +15,7 @@ namespace DirectXGame
 			Angry
 		};
 
-		MoodySprite(std::uint32_t spriteIndex, const DX::Transform2D& transform, Moods mood = Moods::Neutral, const DirectX::XMFLOAT4X4& textureTransform = DX::MatrixHelper::Identity);
+		MoodySprite(std::uint32_t spriteIndex, const DX::Transform2D& transform, Moods mood = Moods::Neutral);
 
 		std::uint32_t SpriteIndex() const;
 		void SetSpriteIndex(const std::uint32_t spriteIndex);
@@ -27,11 +26,7 @@ namespace DirectXGame
 		Moods Mood() const;
 		void SetMood(const Moods mood);
 
-		const DirectX::XMFLOAT4X4& TextureTransform() const;
-		void SetTextureTransform(const DirectX::XMFLOAT4X4& transform);
-
 	private:
-		DirectX::XMFLOAT4X4 mTextureTransform;
 		DX::Transform2D mTransform;		
 		Moods mMood;
 		std::uint32_t mSpriteIndex;
@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "ParticleManager.h"
+#include <DirectXPackedVector.h>
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace DX;
+
+namespace DirectXGame
+{
+	const D3D11_INPUT_ELEMENT_DESC ParticleManager::InputElements[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	};
+
+	ParticleManager::ParticleManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera, const shared_ptr<D3D11RenderBackend>& renderBackend, const shared_ptr<PipelineCache>& pipelineCache) :
+		DrawableGameComponent(deviceResources, camera), mRenderBackend(renderBackend), mPipelineCache(pipelineCache),
+		mParticleMesh(RenderCommandList::InvalidMesh), mLoadingComplete(false), mParticles(Capacity), mInstances(Capacity)
+	{
+		// Pieces fall back towards the bar and slow down in the air.
+		mParticles.SetGravity(0.0f, -60.0f);
+		mParticles.SetDrag(1.5f);
+	}
+
+	void ParticleManager::CreateDeviceDependentResources()
+	{
+		// The pixel shader passes the vertex shader's color through, so the instanced shape pixel shader is shared.
+		const PipelineCache::Description description = { L"ParticleVS.cso", L"ShapeRendererInstancedPS.cso", InputElements, InputElementCount,
+			D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, sizeof(XMFLOAT4X4), 0, true };
+
+		mPipelineCache->GetPipelineAsync(description).then([this](const shared_ptr<const PipelineCache::Pipeline>& pipeline) {
+			mPipeline = pipeline;
+			InitializeTriangleVertices();
+			InitializeInstanceBuffer();
+
+			const D3D11RenderBackend::Mesh particleMesh = { mTriangleVertexBuffer, sizeof(VertexPosition), mInstanceBuffer, sizeof(ParticleInstance) };
+			mParticleMesh = mRenderBackend->CreateMesh(particleMesh);
+
+			mLoadingComplete = true;
+		});
+	}
+
+	void ParticleManager::ReleaseDeviceDependentResources()
+	{
+		mLoadingComplete = false;
+		mTriangleVertexBuffer.Reset();
+		mInstanceBuffer.Reset();
+		mPipeline.reset();
+		mRenderBackend->ReleaseMesh(mParticleMesh);
+	}
+
+	void ParticleManager::Update(const StepTimer& timer)
+	{
+		DX_PROFILE_ZONE("ParticleSystem::Update");
+		mParticles.Update(static_cast<float>(timer.GetElapsedSeconds()));
+	}
+
+	void ParticleManager::RecordDraws(const StepTimer& timer, RenderCommandList& commandList)
+	{
+		UNREFERENCED_PARAMETER(timer);
+
+		// Loading is asynchronous. Only draw geometry after it's loaded.
+		if (!mLoadingComplete)
+		{
+			return;
+		}
+
+		const uint32_t instanceCount = mParticles.WriteInstances(mInstances.data(), Capacity);
+		if (instanceCount == 0)
+		{
+			return;
+		}
+
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixTranspose(mCamera->ViewProjectionMatrix()));
+
+		commandList.SetLayer(ParticleLayer);
+		commandList.SetPipeline(mPipeline->Handle);
+		commandList.SetMesh(mParticleMesh);
+		commandList.UpdateInstances(mInstances.data(), instanceCount);
+		commandList.SetConstants(ShaderStage::Vertex, viewProjection);
+		commandList.DrawInstanced(4, instanceCount);
+	}
+
+	void ParticleManager::EmitBrickBreak(const XMFLOAT2& center, const XMFLOAT4& color)
+	{
+		ParticleBurst burst = {};
+		burst.Position[0] = center.x;
+		burst.Position[1] = center.y;
+		burst.Count = 24;
+		burst.Spread = XM_2PI;
+		burst.MinSpeed = 8.0f;
+		burst.MaxSpeed = 30.0f;
+		burst.MinLifetime = 0.4f;
+		burst.MaxLifetime = 0.9f;
+		burst.Radius = 0.6f;
+		burst.Color = PackColor(color);
+		mParticles.Emit(burst);
+	}
+
+	void ParticleManager::EmitBounce(const XMFLOAT2& position)
+	{
+		// Sparks up off the bar.
+		ParticleBurst burst = {};
+		burst.Position[0] = position.x;
+		burst.Position[1] = position.y;
+		burst.Count = 10;
+		burst.Direction = XM_PIDIV2;
+		burst.Spread = XM_PI * 0.6f;
+		burst.MinSpeed = 10.0f;
+		burst.MaxSpeed = 25.0f;
+		burst.MinLifetime = 0.2f;
+		burst.MaxLifetime = 0.4f;
+		burst.Radius = 0.35f;
+		burst.Color = PackColor(XMFLOAT4(1.0f, 1.0f, 1.0f, 0.8f));
+		mParticles.Emit(burst);
+	}
+
+	void ParticleManager::EmitCatch(const XMFLOAT2& position, const XMFLOAT4& color)
+	{
+		ParticleBurst burst = {};
+		burst.Position[0] = position.x;
+		burst.Position[1] = position.y;
+		burst.Count = 16;
+		burst.Direction = XM_PIDIV2;
+		burst.Spread = XM_PI;
+		burst.MinSpeed = 6.0f;
+		burst.MaxSpeed = 18.0f;
+		burst.MinLifetime = 0.3f;
+		burst.MaxLifetime = 0.6f;
+		burst.Radius = 0.45f;
+		burst.Color = PackColor(color);
+		mParticles.Emit(burst);
+	}
+
+	const ParticleSystem& ParticleManager::Particles() const
+	{
+		return mParticles;
+	}
+
+	uint32_t ParticleManager::PackColor(const XMFLOAT4& color)
+	{
+		// Red in the lowest byte, as R8G8B8A8_UNORM reads it.
+		XMUBYTEN4 packed;
+		XMStoreUByteN4(&packed, XMLoadFloat4(&color));
+		return packed.v;
+	}
+
+	void ParticleManager::InitializeTriangleVertices()
+	{
+		// A quad from -1 to 1, scaled by each particle's radius, in the chunk quad's winding.
+		const VertexPosition vertices[] =
+		{
+			VertexPosition(XMFLOAT4(-1.0f, 1.0f, 0.0f, 1.0f)),
+			VertexPosition(XMFLOAT4(1.0f, 1.0f, 0.0f, 1.0f)),
+			VertexPosition(XMFLOAT4(-1.0f, -1.0f, 0.0f, 1.0f)),
+			VertexPosition(XMFLOAT4(1.0f, -1.0f, 0.0f, 1.0f))
+		};
+
+		D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
+		vertexBufferDesc.ByteWidth = sizeof(vertices);
+		vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA vertexSubResourceData = { 0 };
+		vertexSubResourceData.pSysMem = vertices;
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&vertexBufferDesc, &vertexSubResourceData, mTriangleVertexBuffer.ReleaseAndGetAddressOf()));
+	}
+
+	void ParticleManager::InitializeInstanceBuffer()
+	{
+		CD3D11_BUFFER_DESC instanceBufferDesc(sizeof(ParticleInstance) * Capacity, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&instanceBufferDesc, nullptr, mInstanceBuffer.ReleaseAndGetAddressOf()));
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "DrawableGameComponent.h"
+#include "ParticleSystem.h"
+#include <DirectXMath.h>
+#include <vector>
+
+namespace DirectXGame
+{
+	// Owns the particles thrown off by breaking bricks, ball bounces off the bar and caught powerups. The managers that
+	// detect those events emit bursts into one DX::ParticleSystem, and every live particle is drawn with one alpha-blended
+	// instanced draw over the rest of the scene, each instance a quad carrying its position, faded radius and color.
+	// The pool holds Capacity particles and drops what doesn't fit, so a combo never allocates and a frame's instances
+	// fit in the command list's preallocated data.
+	class ParticleManager final : public DX::DrawableGameComponent
+	{
+	public:
+		static const std::uint32_t Capacity = 2048;
+
+		ParticleManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, const std::shared_ptr<DX::D3D11RenderBackend>& renderBackend, const std::shared_ptr<DX::PipelineCache>& pipelineCache);
+
+		virtual void CreateDeviceDependentResources() override;
+		virtual void ReleaseDeviceDependentResources() override;
+		virtual void Update(const DX::StepTimer& timer) override;
+		virtual void RecordDraws(const DX::StepTimer& timer, DX::RenderCommandList& commandList) override;
+
+		// Positions are in world space.
+		void EmitBrickBreak(const DirectX::XMFLOAT2& center, const DirectX::XMFLOAT4& color);
+		void EmitBounce(const DirectX::XMFLOAT2& position);
+		void EmitCatch(const DirectX::XMFLOAT2& position, const DirectX::XMFLOAT4& color);
+
+		const DX::ParticleSystem& Particles() const;
+
+	private:
+		// Includes the per-vertex VertexPosition element in slot 0; DX::ParticleInstance is slot 1.
+		static const int InputElementCount = 3;
+		static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+
+		static std::uint32_t PackColor(const DirectX::XMFLOAT4& color);
+
+		void InitializeTriangleVertices();
+		void InitializeInstanceBuffer();
+
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mTriangleVertexBuffer;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mInstanceBuffer;
+		std::shared_ptr<DX::D3D11RenderBackend> mRenderBackend;
+		std::shared_ptr<DX::PipelineCache> mPipelineCache;
+		std::shared_ptr<const DX::PipelineCache::Pipeline> mPipeline;
+		DX::MeshHandle mParticleMesh;
+
+		bool mLoadingComplete;
+		DX::ParticleSystem mParticles;
+		std::vector<DX::ParticleInstance> mInstances;		// Capacity long, rewritten each frame
+	};
+}
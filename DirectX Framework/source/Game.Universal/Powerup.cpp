@@ -8,7 +8,7 @@ namespace DirectXGame
 {
 	Powerup::Powerup(PowerupManager& powerupManager, const DX::Transform2D& transform, float radius, const DirectX::XMFLOAT4& color, 
 		const DirectX::XMFLOAT2& velocity, PowerupType type) :
-		mPowerupManager(powerupManager), mTransform(transform), mRadius(radius),
+		mPowerupManager(&powerupManager), mTransform(transform), mRadius(radius),
 		mColor(color), mVelocity(velocity), mType(type), mActivated(false)
 	{
 	}
@@ -27,6 +27,7 @@ namespace DirectXGame
 
 		Powerup(PowerupManager& powerupManager, const DX::Transform2D& transform, float radius, const DirectX::XMFLOAT4& color, 
 			const DirectX::XMFLOAT2& velocity, PowerupType type);
+		// Movable, so PowerupManager can recycle the slots of powerups that have fallen out of play.
 		Powerup(const Powerup&) = default;
 		Powerup& operator=(const Powerup&) = delete;
 		Powerup(Powerup&&) = default;
@@ -52,16 +53,12 @@ namespace DirectXGame
 		const bool Activated() const;
 
 	private:
-		PowerupManager& mPowerupManager;
+		PowerupManager* mPowerupManager;
 		DX::Transform2D mTransform;
 		float mRadius;
 		DirectX::XMFLOAT4 mColor;
 		DirectX::XMFLOAT2 mVelocity;
 		PowerupType mType;
 		bool mActivated;
-
-		const float mWidth = 3.0f;
-		const float mFieldRightSide = 40.0f;
-		const float mFieldLeftSide = -52.0f;
 	};
 }
@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "ChunkManager.h"
 #include "Chunk.h"
+#include "ParticleManager.h"
+#include "GameRules.h"
+#include <algorithm>
 
 using namespace std;
 using namespace DirectX;
@@ -8,15 +11,25 @@ using namespace DX;
 
 namespace DirectXGame
 {
-	const uint32_t PowerupManager::CircleResolution = 32;
-	const uint32_t PowerupManager::SolidCircleVertexCount = (PowerupManager::CircleResolution + 1) * 2;
+	namespace
+	{
+		// A powerup's rectangle with rounded corners at every level, built by the compiler.
+		constexpr float CornerRadius = 0.75f;
+		constexpr ShapeMeshes::RoundedRects RectMeshes = ShapeMeshes::MakeRoundedRects(0.0f, -40.0f, 3.0f, -38.0f, CornerRadius);
+		static_assert(sizeof(ShapeVertex) == sizeof(VertexPosition), "Shape vertices are uploaded as VertexPosition.");
+	}
 
-	PowerupManager::PowerupManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera,
-		BarManager& barManager) :
-		DrawableGameComponent(deviceResources, camera), mLoadingComplete(false), 
-		mBarManager(barManager)
+	const uint32_t PowerupManager::MaxPowerups = 64;
+
+	PowerupManager::PowerupManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera, const shared_ptr<D3D11RenderBackend>& renderBackend, const shared_ptr<PipelineCache>& pipelineCache,
+		BarManager& barManager, ParticleManager& particleManager) :
+		DrawableGameComponent(deviceResources, camera), mRenderBackend(renderBackend), mPipelineCache(pipelineCache),
+		mTriangleMesh(RenderCommandList::InvalidMesh), mLoadingComplete(false), mGenerator(random_device()()),
+		mBarManager(barManager), mParticleManager(particleManager)
 	{
-		CreateDeviceDependentResources();
+		// Powerups are stored by value in preallocated storage so spawning one mid-game never allocates.
+		mPowerups.reserve(MaxPowerups);
+		mPowerupTransforms.reserve(MaxPowerups);
 	}
 
 	std::shared_ptr<Field> PowerupManager::ActiveField() const
@@ -31,68 +44,17 @@ namespace DirectXGame
 
 	void PowerupManager::CreateDeviceDependentResources()
 	{
-		auto loadVSTask = ReadDataAsync(L"ShapeRendererVS.cso");
-		auto loadPSTask = ReadDataAsync(L"ShapeRendererPS.cso");
-
-		// After the vertex shader file is loaded, create the shader and input layout.
-		auto createVSTask = loadVSTask.then([this](const std::vector<byte>& fileData) {
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateVertexShader(
-					&fileData[0],
-					fileData.size(),
-					nullptr,
-					mVertexShader.ReleaseAndGetAddressOf()
-				)
-			);
-
-			// Create an input layout
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateInputLayout(
-					VertexPosition::InputElements,
-					VertexPosition::InputElementCount,
-					&fileData[0],
-					fileData.size(),
-					mInputLayout.ReleaseAndGetAddressOf()
-				)
-			);
-
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4X4), D3D11_BIND_CONSTANT_BUFFER);
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateBuffer(
-					&constantBufferDesc,
-					nullptr,
-					mVSCBufferPerObject.ReleaseAndGetAddressOf()
-				)
-			);
-		});
+		const PipelineCache::Description description = { L"ShapeRendererVS.cso", L"ShapeRendererPS.cso", VertexPosition::InputElements, VertexPosition::InputElementCount,
+			D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, sizeof(XMFLOAT4X4), sizeof(XMFLOAT4) };
 
-		// After the pixel shader file is loaded, create the shader and constant buffer.
-		auto createPSTask = loadPSTask.then([this](const std::vector<byte>& fileData) {
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreatePixelShader(
-					&fileData[0],
-					fileData.size(),
-					nullptr,
-					mPixelShader.ReleaseAndGetAddressOf()
-				)
-			);
-
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4), D3D11_BIND_CONSTANT_BUFFER);
-			ThrowIfFailed(
-				mDeviceResources->GetD3DDevice()->CreateBuffer(
-					&constantBufferDesc,
-					nullptr,
-					mPSCBufferPerObject.ReleaseAndGetAddressOf()
-				)
-			);
-		});
-
-		auto createVerticesAndBallsTask = (createPSTask && createVSTask).then([this]() {
+		// The shape shaders are shared with the other managers; the cache loads them once.
+		mPipelineCache->GetPipelineAsync(description).then([this](const shared_ptr<const PipelineCache::Pipeline>& pipeline) {
+			mPipeline = pipeline;
 			InitializeTriangleVertices();
-		});
 
-		// Once the cube is loaded, the object is ready to be rendered.
-		createVerticesAndBallsTask.then([this]() {
+			const D3D11RenderBackend::Mesh triangleMesh = { mTriangleVertexBuffer, sizeof(VertexPosition) };
+			mTriangleMesh = mRenderBackend->CreateMesh(triangleMesh);
+
 			mLoadingComplete = true;
 		});
 	}
@@ -100,46 +62,46 @@ namespace DirectXGame
 	void PowerupManager::ReleaseDeviceDependentResources()
 	{
 		mLoadingComplete = false;
-		mVertexShader.Reset();
-		mPixelShader.Reset();
-		mInputLayout.Reset();
 		mTriangleVertexBuffer.Reset();
-		mVSCBufferPerObject.Reset();
-		mPSCBufferPerObject.Reset();
+		mPipeline.reset();
+		mRenderBackend->ReleaseMesh(mTriangleMesh);
 	}
 
 	void PowerupManager::Update(const StepTimer& timer)
 	{
-		for (const auto& powerup : mPowerups)
+		for (auto& powerup : mPowerups)
 		{
-			powerup->Update(timer);
+			powerup.Update(timer);
 		}
 
 		for (auto it = mPowerups.begin(); it != mPowerups.end(); ++it)
 		{
 			//If the powerup is within the range of the bar, check for collision
-			if (((*it)->Position().y + mPowerupHeight) <= mBarManager.BarUpperY())
+			if ((it->Position().y + GameRules::PowerupHeight) <= mBarManager.BarUpperY())
 			{
-				if (mBarManager.HandlePowerupCollision((*it)->Position(), mPowerupWidth))
+				if (mBarManager.HandlePowerupCollision(it->Position(), GameRules::PowerupWidth))
 				{
-					if (!(*it)->Activated())
+					if (!it->Activated())
 					{
-						(*it)->ActivatePowerup();
+						it->ActivatePowerup();
+
+						// From the center of the powerup's quad, in its color.
+						mParticleManager.EmitCatch(XMFLOAT2(it->Position().x + 1.5f * it->Radius(), it->Position().y - 39.0f * it->Radius()), it->Color());
 
 						//Trigger the appropriate powerup effect
-						if ((*it)->Type() == Powerup::FasterBar)
+						if (it->Type() == Powerup::FasterBar)
 						{
 							mBarManager.IncreaseBarVelocity();
 						}
-						else if ((*it)->Type() == Powerup::SlowerBar)
+						else if (it->Type() == Powerup::SlowerBar)
 						{
 							mBarManager.DecreaseBarVelocity();
 						}
-						else if ((*it)->Type() == Powerup::FasterBall)
+						else if (it->Type() == Powerup::FasterBall)
 						{
 							mBallManager->IncreaseBallVelocity();
 						}
-						else if ((*it)->Type() == Powerup::SlowerBall)
+						else if (it->Type() == Powerup::SlowerBall)
 						{
 							mBallManager->DecreaseBallVelocity();
 						}
@@ -148,16 +110,22 @@ namespace DirectXGame
 			}
 		}
 
-		for (auto it = mPowerups.begin(); it != mPowerups.end(); ++it)
+		// Below 0 a powerup can no longer be caught and is past the bottom of the screen, so its slot goes back to the
+		// reserved storage for the next spawn.
+		mPowerups.erase(remove_if(mPowerups.begin(), mPowerups.end(), [](const Powerup& powerup) { return powerup.Position().y <= 0; }), mPowerups.end());
+
+		// The falling powerups' world matrices are recomputed together, four at a time, rather than one by one as RecordDraws
+		// reads them.
+		mPowerupTransforms.clear();
+		for (const auto& powerup : mPowerups)
 		{
-			if ((*it)->Position().y <= 0)
-			{
-				(*it)->ActivatePowerup();
-			}
+			mPowerupTransforms.push_back(&powerup.Transform());
 		}
+
+		Transform2D::UpdateWorldMatrices(mPowerupTransforms.data(), mPowerupTransforms.size());
 	}
 
-	void PowerupManager::Render(const StepTimer & timer)
+	void PowerupManager::RecordDraws(const StepTimer& timer, RenderCommandList& commandList)
 	{
 		UNREFERENCED_PARAMETER(timer);
 
@@ -167,36 +135,26 @@ namespace DirectXGame
 			return;
 		}
 
-		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
-		direct3DDeviceContext->IASetInputLayout(mInputLayout.Get());
-
-		direct3DDeviceContext->VSSetShader(mVertexShader.Get(), nullptr, 0);
-		direct3DDeviceContext->PSSetShader(mPixelShader.Get(), nullptr, 0);
-
-		direct3DDeviceContext->VSSetConstantBuffers(0, 1, mVSCBufferPerObject.GetAddressOf());
-		direct3DDeviceContext->PSSetConstantBuffers(0, 1, mPSCBufferPerObject.GetAddressOf());
+		commandList.SetLayer(ShapeLayer);
+		commandList.SetPipeline(mPipeline->Handle);
+		commandList.SetMesh(mTriangleMesh);
 
 		for (const auto& powerup : mPowerups)
 		{
-			DrawPowerup(*powerup);
+			DrawPowerup(powerup, commandList);
 		}
 	}
 
-	void PowerupManager::DrawPowerup(const Powerup & powerup)
+	void PowerupManager::DrawPowerup(const Powerup& powerup, RenderCommandList& commandList)
 	{
-		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
-		direct3DDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-
-		static const UINT stride = sizeof(VertexPosition);
-		static const UINT offset = 0;
-		direct3DDeviceContext->IASetVertexBuffers(0, 1, mTriangleVertexBuffer.GetAddressOf(), &stride, &offset);
-
-		const XMMATRIX wvp = XMMatrixTranspose(XMMatrixScaling(powerup.Radius(), powerup.Radius(), powerup.Radius()) * powerup.Transform().WorldMatrix() * mCamera->ViewProjectionMatrix());
-		direct3DDeviceContext->UpdateSubresource(mVSCBufferPerObject.Get(), 0, nullptr, reinterpret_cast<const float*>(wvp.r), 0, 0);
-
-		direct3DDeviceContext->UpdateSubresource(mPSCBufferPerObject.Get(), 0, nullptr, &powerup.Color(), 0, 0);
-
-		direct3DDeviceContext->Draw(SolidCircleVertexCount, 0);
+		XMFLOAT4X4 wvp;
+		XMStoreFloat4x4(&wvp, XMMatrixTranspose(XMMatrixScaling(powerup.Radius(), powerup.Radius(), powerup.Radius()) * powerup.Transform().WorldMatrix() * mCamera->ViewProjectionMatrix()));
+		commandList.SetConstants(ShaderStage::Vertex, wvp);
+		commandList.SetConstants(ShaderStage::Pixel, powerup.Color());
+
+		// The corners are scaled with the rest of the shape.
+		const ShapeLod lod = ShapeMeshes::RoundedRectLod(ShapeMeshes::SelectRoundedRectLod(CornerRadius * powerup.Radius() * PixelsPerWorldUnit()));
+		commandList.Draw(lod.VertexCount, lod.StartVertex);
 	}
 
 	void PowerupManager::SetBallManager(std::shared_ptr<BallManager> ballManager)
@@ -207,11 +165,9 @@ namespace DirectXGame
 	void PowerupManager::PowerupSpawnCheck(const XMFLOAT2& chunkPosition)
 	{
 		//Probability check to see if a powerup should be spawned (.25 chance)
-		random_device device;
-		default_random_engine generator(device());
 		uniform_int_distribution<uint32_t> spawnDistribution(0, 3);
 
-		if (spawnDistribution(generator) == 0)
+		if (spawnDistribution(mGenerator) == 0)
 		{
 			SpawnPowerup(chunkPosition);
 		}
@@ -220,61 +176,21 @@ namespace DirectXGame
 	void PowerupManager::SpawnPowerup(const XMFLOAT2& chunkPosition)
 	{
 		//Randomly selecting powerup effect (& associated color)
-		random_device device;
-		default_random_engine generator(device());
 		uniform_int_distribution<uint32_t> powerupDistribution(0, 3);
-		uint32_t powerupSelection = powerupDistribution(generator);
+		uint32_t powerupSelection = powerupDistribution(mGenerator);
 
 		InitializePowerup(chunkPosition, mPossiblePowerups[powerupSelection].Type, mPossiblePowerups[powerupSelection].Color);
 	}
 
 	void PowerupManager::InitializeTriangleVertices()
 	{
-		vector<VertexPosition> vertices;
-		vertices.reserve(4);
-
-		//Top left vertex
-		VertexPosition topLeft;
-		topLeft.Position.x = 0;
-		topLeft.Position.y = -38;
-		topLeft.Position.z = 0.0f;
-		topLeft.Position.w = 1.0f;
-
-		//Top right vertex
-		VertexPosition topRight;
-		topRight.Position.x = 3;
-		topRight.Position.y = -38;
-		topRight.Position.z = 0.0f;
-		topRight.Position.w = 1.0f;
-
-		//Bottom right vertex
-		VertexPosition bottomLeft;
-		bottomLeft.Position.x = 3;
-		bottomLeft.Position.y = -40;
-		bottomLeft.Position.z = 0.0f;
-		bottomLeft.Position.w = 1.0f;
-
-		//Bottom left vertex
-		VertexPosition bottomRight;
-		bottomRight.Position.x = 0;
-		bottomRight.Position.y = -40;
-		bottomRight.Position.z = 0.0f;
-		bottomRight.Position.w = 1.0f;
-
-		vertices.push_back(topLeft);
-		vertices.push_back(topRight);
-		vertices.push_back(bottomRight);
-		vertices.push_back(bottomLeft);
-
-		assert(vertices.size() == 4);
-
 		D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
-		vertexBufferDesc.ByteWidth = sizeof(VertexPosition) * static_cast<uint32_t>(vertices.size());
+		vertexBufferDesc.ByteWidth = sizeof(RectMeshes);
 		vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
 		vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
 		D3D11_SUBRESOURCE_DATA vertexSubResourceData = { 0 };
-		vertexSubResourceData.pSysMem = &vertices[0];
+		vertexSubResourceData.pSysMem = &RectMeshes;
 		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&vertexBufferDesc, &vertexSubResourceData, mTriangleVertexBuffer.ReleaseAndGetAddressOf()));
 	}
 
@@ -282,8 +198,13 @@ namespace DirectXGame
 	{
 		const float rotation = 0.0f;
 		const float radius = 1.5f;
-		const XMFLOAT2 velocity(0, -10);
+		const XMFLOAT2 velocity(0, -GameRules::PowerupFallSpeed);
 
-		mPowerups.emplace_back(make_shared<Powerup>(*this, position, radius, color, velocity, type));
+		// Every chunk can spawn at most one powerup and fallen ones are recycled, so the reserved capacity is only reached
+		// if more than a field's worth of chunks break while their powerups are still falling.
+		if (mPowerups.size() < MaxPowerups)
+		{
+			mPowerups.emplace_back(*this, position, radius, color, velocity, type);
+		}
 	}
 }
\ No newline at end of file
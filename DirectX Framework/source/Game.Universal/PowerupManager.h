@@ -4,6 +4,7 @@
 #include "DrawableGameComponent.h"
 #include <DirectXMath.h>
 #include <vector>
+#include <random>
 #include <DirectXColors.h>
 
 namespace DirectXGame
@@ -11,6 +12,7 @@ namespace DirectXGame
 	class Field;
 	class BarManager;
 	class BallManager;
+	class ParticleManager;
 
 	class PowerupManager final : public DX::DrawableGameComponent
 	{
@@ -26,8 +28,8 @@ namespace DirectXGame
 			};
 		};
 
-		PowerupManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera,
-			BarManager& barManager);
+		PowerupManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, const std::shared_ptr<DX::D3D11RenderBackend>& renderBackend, const std::shared_ptr<DX::PipelineCache>& pipelineCache,
+			BarManager& barManager, ParticleManager& particleManager);
 
 		std::shared_ptr<Field> ActiveField() const;
 		void SetActiveField(const std::shared_ptr<Field>& field);
@@ -35,7 +37,7 @@ namespace DirectXGame
 		virtual void CreateDeviceDependentResources() override;
 		virtual void ReleaseDeviceDependentResources() override;
 		virtual void Update(const DX::StepTimer& timer) override;
-		virtual void Render(const DX::StepTimer& timer) override;
+		virtual void RecordDraws(const DX::StepTimer& timer, DX::RenderCommandList& commandList) override;
 
 		void PowerupSpawnCheck(const DirectX::XMFLOAT2& chunkPosition);
 		void SetBallManager(std::shared_ptr<BallManager> ballManager);
@@ -45,27 +47,25 @@ namespace DirectXGame
 
 		void InitializeTriangleVertices();
 		void InitializePowerup(const DirectX::XMFLOAT2& position, Powerup::PowerupType type, const DirectX::XMFLOAT4& color);
-		void DrawPowerup(const Powerup& powerup);
+		void DrawPowerup(const Powerup& powerup, DX::RenderCommandList& commandList);
 
-		static const std::uint32_t CircleResolution;
-		static const std::uint32_t SolidCircleVertexCount;
+		static const std::uint32_t MaxPowerups;
 
-		Microsoft::WRL::ComPtr<ID3D11VertexShader> mVertexShader;
-		Microsoft::WRL::ComPtr<ID3D11PixelShader> mPixelShader;
-		Microsoft::WRL::ComPtr<ID3D11InputLayout> mInputLayout;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> mTriangleVertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mVSCBufferPerObject;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mPSCBufferPerObject;
+		std::shared_ptr<DX::D3D11RenderBackend> mRenderBackend;
+		std::shared_ptr<DX::PipelineCache> mPipelineCache;
+		std::shared_ptr<const DX::PipelineCache::Pipeline> mPipeline;
+		DX::MeshHandle mTriangleMesh;
 
 		bool mLoadingComplete;
-		std::vector<std::shared_ptr<Powerup>> mPowerups;
+		std::vector<Powerup> mPowerups;
+		std::vector<const DX::Transform2D*> mPowerupTransforms;	// Update's scratch, parallel to mPowerups
+		std::default_random_engine mGenerator;
 		std::shared_ptr<Field> mActiveField;
 		BarManager& mBarManager;
+		ParticleManager& mParticleManager;
 		std::shared_ptr<BallManager> mBallManager;
 
-		const int32_t mPowerupHeight = 2;
-		const float mPowerupWidth = 3.0f;
-
 		const std::vector <DirectX::XMFLOAT4> mChunkColors =
 		{
 			(DirectX::XMFLOAT4)DirectX::Colors::HotPink,
@@ -1,5 +1,7 @@
 #include "pch.h"
 #include "SpriteDemoManager.h"
+#include <cmath>
+#include <stdexcept>
 
 using namespace std;
 using namespace DX;
@@ -9,14 +11,16 @@ using namespace Microsoft::WRL;
 namespace DirectXGame
 {
 	const DirectX::XMFLOAT2 SpriteDemoManager::SpriteScale = XMFLOAT2(3.0f, 3.0f);
-	const uint32_t SpriteDemoManager::SpriteCount = 8; // Sprites are arranged horizontally within the sprite sheet
-	const uint32_t SpriteDemoManager::MoodCount = 4; // Moods are arranged vertically within the sprite sheet
-	const XMFLOAT2 SpriteDemoManager::UVScalingFactor = XMFLOAT2(1.0f / SpriteCount, 1.0f / MoodCount);
+	const uint32_t SpriteDemoManager::SpriteCount = 8; // Sprites are arranged horizontally within the source sprite sheet
+	const uint32_t SpriteDemoManager::MoodCount = 4; // Moods are arranged vertically within the source sprite sheet
 	const double SpriteDemoManager::MoodUpdateDelay = 0.5; // Delay between mood changes, in seconds
+	const wstring SpriteDemoManager::SpriteSheetFilename = L"Content\\Textures\\snoods_atlas.dds"; // BC3 with mips, converted from snoods_atlas.png by TextureConverter
+	const wstring SpriteDemoManager::SpriteAtlasFilename = L"Content\\Textures\\snoods_atlas.atlas";
+	const string SpriteDemoManager::SpriteAtlasPrefix = "snoods_default_"; // Images are named <prefix><sprite>_<mood>, after their cell in the source sheet
 
-	SpriteDemoManager::SpriteDemoManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera, uint32_t spriteRowCount, uint32_t spriteColumCount) :
-		DrawableGameComponent(deviceResources, camera),
-		mLoadingComplete(false), mIndexCount(0),
+	SpriteDemoManager::SpriteDemoManager(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<Camera>& camera, const shared_ptr<AssetLoader>& assetLoader, uint32_t spriteRowCount, uint32_t spriteColumCount) :
+		DrawableGameComponent(deviceResources, camera), mAssetLoader(assetLoader),
+		mSpriteBatchTarget(deviceResources), mSpriteSheetTexture(0), mLoadingComplete(false),
 		mSpriteRowCount(spriteRowCount), mSpriteColumnCount(spriteColumCount),
 		mPosition(0.0f, 0.0f), mRandomGenerator(mRandomDevice()),
 		mSpriteDistribution(0, SpriteCount - 1)
@@ -35,7 +39,13 @@ namespace DirectXGame
 
 	void SpriteDemoManager::CreateDeviceDependentResources()
 	{
-		auto loadVSTask = ReadDataAsync(L"SpriteRendererVS.cso");
+		// Start on the sprite sheet and its atlas table first; they load on the asset loader's threads while the shaders load.
+		// The sprite sheet is a DDS file already in the texture's format, so it goes to the device as it is mapped.
+		const wstring installedPath = wstring(Windows::ApplicationModel::Package::Current->InstalledLocation->Path->Data()) + L"\\";
+		const shared_future<AssetLoader::AssetPointer> loadSpriteSheet = mAssetLoader->LoadAsync(ToUtf8(installedPath + SpriteSheetFilename));
+		const shared_future<AssetLoader::AssetPointer> loadSpriteAtlas = mAssetLoader->LoadAsync(ToUtf8(installedPath + SpriteAtlasFilename));
+
+		auto loadVSTask = ReadDataAsync(L"SpriteBatchVS.cso");
 		auto loadPSTask = ReadDataAsync(L"SpriteRendererPS.cso");
 
 		// After the vertex shader file is loaded, create the shader and input layout.
@@ -52,20 +62,20 @@ namespace DirectXGame
 			// Create an input layout
 			ThrowIfFailed(
 				mDeviceResources->GetD3DDevice()->CreateInputLayout(
-					VertexPositionTexture::InputElements,
-					VertexPositionTexture::InputElementCount,
+					D3D11SpriteBatchTarget::InputElements,
+					D3D11SpriteBatchTarget::InputElementCount,
 					&fileData[0],
 					fileData.size(),
 					mInputLayout.ReleaseAndGetAddressOf()
 				)
 			);
 
-			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(VSCBufferPerObject), D3D11_BIND_CONSTANT_BUFFER);
+			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4X4), D3D11_BIND_CONSTANT_BUFFER);
 			ThrowIfFailed(
 				mDeviceResources->GetD3DDevice()->CreateBuffer(
 					&constantBufferDesc,
 					nullptr,
-					mVSCBufferPerObject.ReleaseAndGetAddressOf()
+					mVSCBufferPerFrame.ReleaseAndGetAddressOf()
 				)
 			);
 		});
@@ -107,9 +117,12 @@ namespace DirectXGame
 			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBlendState(&blendStateDesc, mAlphaBlending.ReleaseAndGetAddressOf()));
 		});
 
-		auto loadSpriteSheetAndCreateSpritesTask = (createPSTask && createVSTask).then([this]() {
-			ThrowIfFailed(CreateWICTextureFromFile(mDeviceResources->GetD3DDevice(), L"Content\\Textures\\snoods_default.png", nullptr, mSpriteSheet.ReleaseAndGetAddressOf()));			
-			InitializeVertices();
+		auto loadSpriteSheetAndCreateSpritesTask = (createPSTask && createVSTask).then([this, loadSpriteSheet, loadSpriteAtlas]() {
+			DX_PROFILE_ZONE("SpriteDemoManager::LoadSpriteSheet");
+			LoadSpriteAtlas(loadSpriteAtlas.get());
+			CreateSpriteSheet(loadSpriteSheet.get());
+			mSpriteBatchTarget.CreateDeviceDependentResources();
+			mSpriteSheetTexture = mSpriteBatchTarget.AddTexture(mSpriteSheet);
 			InitializeSprites();
 		});
 
@@ -120,17 +133,72 @@ namespace DirectXGame
 		});
 	}
 
+	// Looks up every sprite and mood in the atlas table once, so drawing a sprite is an index into mSpriteAtlasEntries.
+	void SpriteDemoManager::LoadSpriteAtlas(const AssetLoader::AssetPointer& table)
+	{
+		mSpriteAtlas = make_unique<TextureAtlas>(table);
+		if (mSpriteAtlas->PageCount() != 1)
+		{
+			throw runtime_error("SpriteDemoManager: the sprite atlas must fit on one page");
+		}
+
+		mSpriteAtlasEntries.assign(SpriteCount * MoodCount, nullptr);
+		for (uint32_t sprite = 0; sprite < SpriteCount; ++sprite)
+		{
+			for (uint32_t mood = 0; mood < MoodCount; ++mood)
+			{
+				const string name = SpriteAtlasPrefix + to_string(sprite) + "_" + to_string(mood);
+				const TextureAtlas::Entry* entry = mSpriteAtlas->Find(name);
+				if (entry == nullptr)
+				{
+					throw runtime_error("SpriteDemoManager: the sprite atlas has no " + name);
+				}
+
+				mSpriteAtlasEntries[sprite * MoodCount + mood] = entry;
+			}
+		}
+	}
+
+	void SpriteDemoManager::CreateSpriteSheet(const AssetLoader::AssetPointer& file)
+	{
+		DdsTexture::Description texture;
+		if (!DdsTexture::Parse(file->Data(), file->Size(), texture))
+		{
+			throw runtime_error("SpriteDemoManager: the sprite sheet isn't a supported DDS texture");
+		}
+
+		const TextureAtlas::Page& page = mSpriteAtlas->GetPage(0);
+		if (texture.Width != page.Width || texture.Height != page.Height)
+		{
+			throw runtime_error("SpriteDemoManager: the sprite sheet doesn't match its atlas table");
+		}
+
+		const UINT mipCount = static_cast<UINT>(texture.Mips.size());
+		CD3D11_TEXTURE2D_DESC textureDesc(static_cast<DXGI_FORMAT>(texture.Format), texture.Width, texture.Height, 1, mipCount, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+
+		vector<D3D11_SUBRESOURCE_DATA> textureSubResourceData(mipCount);
+		for (UINT mip = 0; mip < mipCount; ++mip)
+		{
+			textureSubResourceData[mip].pSysMem = file->Data() + texture.Mips[mip].Offset;
+			textureSubResourceData[mip].SysMemPitch = texture.Mips[mip].RowPitch;
+			textureSubResourceData[mip].SysMemSlicePitch = texture.Mips[mip].SlicePitch;
+		}
+
+		ComPtr<ID3D11Texture2D> spriteSheet;
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateTexture2D(&textureDesc, textureSubResourceData.data(), spriteSheet.GetAddressOf()));
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateShaderResourceView(spriteSheet.Get(), nullptr, mSpriteSheet.ReleaseAndGetAddressOf()));
+	}
+
 	void SpriteDemoManager::ReleaseDeviceDependentResources()
 	{
 		mLoadingComplete = false;
 		mVertexShader.Reset();
 		mPixelShader.Reset();
 		mInputLayout.Reset();
-		mVertexBuffer.Reset();
-		mIndexBuffer.Reset();
-		mVSCBufferPerObject.Reset();
+		mVSCBufferPerFrame.Reset();
 		mSpriteSheet.Reset();
 		mTextureSampler.Reset();
+		mSpriteBatchTarget.ReleaseDeviceDependentResources();
 	}
 
 	void SpriteDemoManager::Update(const StepTimer& timer)
@@ -165,76 +233,51 @@ namespace DirectXGame
 		}
 
 		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
-		direct3DDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 		direct3DDeviceContext->IASetInputLayout(mInputLayout.Get());
 
-		static const UINT stride = sizeof(VertexPositionTexture);
-		static const UINT offset = 0;
-		direct3DDeviceContext->IASetVertexBuffers(0, 1, mVertexBuffer.GetAddressOf(), &stride, &offset);
-		direct3DDeviceContext->IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-
 		direct3DDeviceContext->VSSetShader(mVertexShader.Get(), nullptr, 0);
 		direct3DDeviceContext->PSSetShader(mPixelShader.Get(), nullptr, 0);
-		direct3DDeviceContext->VSSetConstantBuffers(0, 1, mVSCBufferPerObject.GetAddressOf());
-		direct3DDeviceContext->PSSetShaderResources(0, 1, mSpriteSheet.GetAddressOf());
+
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixTranspose(mCamera->ViewProjectionMatrix()));
+		direct3DDeviceContext->UpdateSubresource(mVSCBufferPerFrame.Get(), 0, nullptr, &viewProjection, 0, 0);
+		direct3DDeviceContext->VSSetConstantBuffers(0, 1, mVSCBufferPerFrame.GetAddressOf());
+
 		direct3DDeviceContext->PSSetSamplers(0, 1, mTextureSampler.GetAddressOf());
 		direct3DDeviceContext->OMSetBlendState(mAlphaBlending.Get(), 0, 0xFFFFFFFF);
 
-		for (const auto& sprite : mSprites)
+		const XMFLOAT4& view = mCamera->VisibleBounds();
+		mSpriteCuller.Cull(CullBounds{ view.x, view.y, view.z, view.w }, mVisibleSprites);
+
+		mSpriteBatchTarget.Bind();
+		mSpriteBatch.Begin(mSpriteBatchTarget);
+
+		for (const uint32_t i : mVisibleSprites)
 		{
-			DrawSprite(*sprite);
+			DrawSprite(*mSprites[i]);
 		}
+
+		mSpriteBatch.End();
 	}
 
-	void SpriteDemoManager::DrawSprite(MoodySprite& sprite)
+	const ViewCuller& SpriteDemoManager::SpriteCuller() const
 	{
-		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
-		
-		const XMMATRIX wvp = XMMatrixTranspose(sprite.Transform().WorldMatrix() * mCamera->ViewProjectionMatrix());
-		XMStoreFloat4x4(&mVSCBufferPerObjectData.WorldViewProjection, wvp);
-		XMMATRIX textureTransform = XMLoadFloat4x4(&sprite.TextureTransform());
-		XMStoreFloat4x4(&mVSCBufferPerObjectData.TextureTransform, XMMatrixTranspose(textureTransform));		 
-		direct3DDeviceContext->UpdateSubresource(mVSCBufferPerObject.Get(), 0, nullptr, &mVSCBufferPerObjectData, 0, 0);
-
-		direct3DDeviceContext->DrawIndexed(mIndexCount, 0, 0);
+		return mSpriteCuller;
 	}
 
-	void SpriteDemoManager::InitializeVertices()
+	void SpriteDemoManager::DrawSprite(const MoodySprite& sprite)
 	{
-		VertexPositionTexture vertices[] = 
-		{
-			VertexPositionTexture(XMFLOAT4(-1.0f, -1.0f, 0.0f, 1.0f), XMFLOAT2(0.0f, 1.0f)),
-			VertexPositionTexture(XMFLOAT4(-1.0f, 1.0f, 0.0f, 1.0f), XMFLOAT2(0.0f, 0.0f)),
-			VertexPositionTexture(XMFLOAT4(1.0f, 1.0f, 0.0f, 1.0f), XMFLOAT2(1.0f, 0.0f)),
-			VertexPositionTexture(XMFLOAT4(1.0f, -1.0f, 0.0f, 1.0f), XMFLOAT2(1.0f, 1.0f)),
-		};
-
-		D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
-		vertexBufferDesc.ByteWidth = sizeof(VertexPositionTexture) * ARRAYSIZE(vertices);
-		vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-		vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-
-		D3D11_SUBRESOURCE_DATA vertexSubResourceData = { 0 };
-		vertexSubResourceData.pSysMem = vertices;
-		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&vertexBufferDesc, &vertexSubResourceData, mVertexBuffer.ReleaseAndGetAddressOf()));
-
-		// Create and index buffer
-		const uint32_t indices[] =
+		const Transform2D& transform = sprite.Transform();
+		const TextureAtlas::Entry& entry = *mSpriteAtlasEntries[sprite.SpriteIndex() * MoodCount + static_cast<uint32_t>(sprite.Mood())];
+		const SpriteInstance instance =
 		{
-			0, 1, 2,
-			0, 2, 3
+			{ transform.Position().x, transform.Position().y },
+			{ transform.Scale().x, transform.Scale().y },
+			{ entry.U0, entry.V0, entry.U1, entry.V1 },
+			transform.Rotation()
 		};
 
-		mIndexCount = ARRAYSIZE(indices);
-
-		D3D11_BUFFER_DESC indexBufferDesc = { 0 };
-		indexBufferDesc.ByteWidth = sizeof(uint32_t) * mIndexCount;
-		indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-		indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-
-		D3D11_SUBRESOURCE_DATA indexSubResourceData = { 0 };
-		indexSubResourceData.pSysMem = indices;
-		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&indexBufferDesc, &indexSubResourceData, mIndexBuffer.ReleaseAndGetAddressOf()));
+		mSpriteBatch.Draw(mSpriteSheetTexture, instance);
 	}
 
 	void SpriteDemoManager::InitializeSprites()
@@ -252,16 +295,25 @@ namespace DirectXGame
 				mSprites.push_back(move(sprite));
 			}
 		}
+
+		// Sprites don't move. A sprite spans -1..1 scaled, so its rotated bounds lie within the scale's length of its center.
+		vector<CullBounds> bounds;
+		bounds.reserve(mSprites.size());
+		for (const auto& sprite : mSprites)
+		{
+			const Transform2D& transform = sprite->Transform();
+			const float extent = sqrt(transform.Scale().x * transform.Scale().x + transform.Scale().y * transform.Scale().y);
+			const CullBounds spriteBounds = { transform.Position().x - extent, transform.Position().y - extent, transform.Position().x + extent, transform.Position().y + extent };
+			bounds.push_back(spriteBounds);
+		}
+
+		mSpriteCuller.Build(bounds.data(), static_cast<uint32_t>(bounds.size()));
 	}
 
 	void SpriteDemoManager::ChangeMood(MoodySprite& sprite)
 	{
-		MoodySprite::Moods mood = GetRandomMood();
-
-		XMFLOAT4X4 textureTransform;
-		XMMATRIX textureTransformMatrix = XMMatrixScaling(UVScalingFactor.x, UVScalingFactor.y, 0) * XMMatrixTranslation(UVScalingFactor.x * sprite.SpriteIndex(), UVScalingFactor.y * static_cast<uint32_t>(mood), 0.0f);
-		XMStoreFloat4x4(&textureTransform, textureTransformMatrix);
-		sprite.SetTextureTransform(textureTransform);
+		// The sprite's UVs are looked up from its sprite index and mood when it's drawn.
+		sprite.SetMood(GetRandomMood());
 	}
 
 	MoodySprite::Moods SpriteDemoManager::GetRandomMood()
@@ -9,10 +9,14 @@ namespace DirectXGame
 {
 	class MoodySprite;
 
+	// Draws a grid of sprites from one texture atlas through a sprite batch, so the whole grid costs one instanced draw per
+	// batch buffer's worth of sprites instead of a constant buffer update and draw per sprite. Sprites outside the camera's
+	// view are culled first. Each sprite's UVs come from the atlas's table, built offline by AtlasBuilder, and the atlas
+	// itself is a BC3 DDS file with its mips, converted offline by TextureConverter.
 	class SpriteDemoManager final : public DX::DrawableGameComponent
 	{
 	public:
-		SpriteDemoManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, std::uint32_t spriteRowCount = 1, std::uint32_t spriteColumCount = 8);
+		SpriteDemoManager(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::Camera>& camera, const std::shared_ptr<DX::AssetLoader>& assetLoader, std::uint32_t spriteRowCount = 1, std::uint32_t spriteColumCount = 8);
 
 		const DirectX::XMFLOAT2& Position() const;
 		void SetPositon(const DirectX::XMFLOAT2& position);
@@ -22,47 +26,42 @@ namespace DirectXGame
 		virtual void Update(const DX::StepTimer& timer) override;
 		virtual void Render(const DX::StepTimer& timer) override;
 
+		const DX::ViewCuller& SpriteCuller() const;
+
 		static const DirectX::XMFLOAT2 SpriteScale;
 
 	private:
-		struct VSCBufferPerObject
-		{
-			DirectX::XMFLOAT4X4 WorldViewProjection;
-			DirectX::XMFLOAT4X4 TextureTransform;
-
-			VSCBufferPerObject() :
-				WorldViewProjection(DX::MatrixHelper::Identity), TextureTransform(DX::MatrixHelper::Identity)
-			{ };
-
-			VSCBufferPerObject(const DirectX::XMFLOAT4X4& wvp, const DirectX::XMFLOAT4X4& textureTransform) :
-				WorldViewProjection(wvp), TextureTransform(textureTransform)
-			{ }
-		};
-
-		void DrawSprite(MoodySprite& sprite);
-		void InitializeVertices();
+		void DrawSprite(const MoodySprite& sprite);
 		void InitializeSprites();
 		void ChangeMood(MoodySprite& sprite);
 		MoodySprite::Moods GetRandomMood();
+		void LoadSpriteAtlas(const DX::AssetLoader::AssetPointer& table);
+		void CreateSpriteSheet(const DX::AssetLoader::AssetPointer& file);
 
 		static const std::uint32_t SpriteCount;
 		static const std::uint32_t MoodCount;
-		static const DirectX::XMFLOAT2 UVScalingFactor;
 		static const double MoodUpdateDelay;
+		static const std::wstring SpriteSheetFilename;
+		static const std::wstring SpriteAtlasFilename;
+		static const std::string SpriteAtlasPrefix;
 
 		Microsoft::WRL::ComPtr<ID3D11VertexShader> mVertexShader;
 		Microsoft::WRL::ComPtr<ID3D11PixelShader> mPixelShader;
 		Microsoft::WRL::ComPtr<ID3D11InputLayout> mInputLayout;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mVertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mIndexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer> mVSCBufferPerObject;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mVSCBufferPerFrame;
 		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mSpriteSheet;
+		std::shared_ptr<DX::AssetLoader> mAssetLoader;
 		Microsoft::WRL::ComPtr<ID3D11SamplerState> mTextureSampler;
 		Microsoft::WRL::ComPtr<ID3D11BlendState> mAlphaBlending;
-		VSCBufferPerObject mVSCBufferPerObjectData;
+		DX::D3D11SpriteBatchTarget mSpriteBatchTarget;
+		DX::SpriteBatch mSpriteBatch;
+		DX::SpriteTextureHandle mSpriteSheetTexture;
+		std::unique_ptr<DX::TextureAtlas> mSpriteAtlas;
+		std::vector<const DX::TextureAtlas::Entry*> mSpriteAtlasEntries;	// By sprite index * MoodCount + mood
 		bool mLoadingComplete;
 		std::vector<std::shared_ptr<MoodySprite>> mSprites;
-		std::uint32_t mIndexCount;
+		DX::ViewCuller mSpriteCuller;
+		std::vector<std::uint32_t> mVisibleSprites;
 		std::uint32_t mSpriteRowCount;
 		std::uint32_t mSpriteColumnCount;
 		DirectX::XMFLOAT2 mPosition;
@@ -29,13 +29,37 @@
 // Library
 #include "ColorHelper.h"
 #include "DirectXHelper.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "RenderCommandList.h"
+#include "RenderBackend.h"
+#include "ConstantBufferRing.h"
+#include "DrawSorter.h"
+#include "ViewCuller.h"
+#include "CachedLayer.h"
+#include "ShapeMeshes.h"
+#include "ParticleSystem.h"
+#include "D3D11RenderBackend.h"
+#include "SpriteBatch.h"
+#include "D3D11SpriteBatchTarget.h"
+#include "PipelineCache.h"
+#include "AssetLoader.h"
+#include "TextureAtlas.h"
+#include "DdsTexture.h"
+#include "FrameCapture.h"
+#include "D3D11FrameCapture.h"
 #include "VectorHelper.h"
 #include "MatrixHelper.h"
 #include "DeviceResources.h"
 #include "GameComponent.h"
 #include "DrawableGameComponent.h"
 #include "DirectXHelper.h"
+#include "GlyphFont.h"
+#include "GlyphText.h"
+#include "TextOverlay.h"
 #include "FpsTextRenderer.h"
+#include "FrameStatistics.h"
 #include "Camera.h"
 #include "OrthographicCamera.h"
 #include "Transform2D.h"
@@ -45,6 +69,7 @@
 #include "GamePadComponent.h"
 
 // Local
+#include "DrawLayers.h"
 #include "Ball.h"
 #include "BallManager.h"
 #include "Field.h"
@@ -54,9 +79,11 @@
 
 #include "Bar.h"
 #include "BarManager.h"
+#include "BarAutopilot.h"
 #include "Chunk.h"
 #include "ChunkManager.h"
 
 #include "ScoreManager.h"
 #include "Powerup.h"
 #include "PowerupManager.h"
+#include "ParticleManager.h"
@@ -0,0 +1,263 @@
+#include "AllocationTracker.h"
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <codecvt>
+#include <locale>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_ReturnAddress)
+#define DX_RETURN_ADDRESS() _ReturnAddress()
+#define DX_NOINLINE __declspec(noinline)
+extern "C" IMAGE_DOS_HEADER __ImageBase;
+#else
+#define DX_RETURN_ADDRESS() __builtin_return_address(0)
+#define DX_NOINLINE __attribute__((noinline))
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	thread_local AllocationTracker::ThreadState AllocationTracker::sThreadState = {};
+	AllocationTracker::TickSummary AllocationTracker::sTicks = {};
+	bool AllocationTracker::sZeroAllocationTicks = false;
+	uint64_t AllocationTracker::sViolationCount = 0;
+	AllocationTracker::Violation AllocationTracker::sViolations[AllocationTracker::MaxViolations];
+
+	AllocationTracker::Counters AllocationTracker::ThreadCounters()
+	{
+		return sThreadState.Totals;
+	}
+
+	uint64_t AllocationTracker::ThreadAllocationCount()
+	{
+		return sThreadState.Totals.Allocations;
+	}
+
+	void AllocationTracker::BeginTick()
+	{
+		sThreadState.TickStart = sThreadState.Totals;
+		sThreadState.InTick = true;
+	}
+
+	AllocationTracker::Counters AllocationTracker::EndTick()
+	{
+		sThreadState.InTick = false;
+
+		Counters tick;
+		tick.Allocations = sThreadState.Totals.Allocations - sThreadState.TickStart.Allocations;
+		tick.Deallocations = sThreadState.Totals.Deallocations - sThreadState.TickStart.Deallocations;
+		tick.BytesAllocated = sThreadState.Totals.BytesAllocated - sThreadState.TickStart.BytesAllocated;
+
+		++sTicks.TickCount;
+		sTicks.Allocations += tick.Allocations;
+		if (tick.Allocations > 0)
+		{
+			++sTicks.AllocatingTickCount;
+			if (tick.Allocations > sTicks.MaxTickAllocations)
+			{
+				sTicks.MaxTickAllocations = tick.Allocations;
+			}
+		}
+
+		return tick;
+	}
+
+	AllocationTracker::TickSummary AllocationTracker::Ticks()
+	{
+		return sTicks;
+	}
+
+	bool AllocationTracker::ZeroAllocationTicks()
+	{
+		return sZeroAllocationTicks;
+	}
+
+	void AllocationTracker::SetZeroAllocationTicks(bool enabled)
+	{
+		sZeroAllocationTicks = enabled;
+	}
+
+	uint64_t AllocationTracker::ViolationCount()
+	{
+		return sViolationCount;
+	}
+
+	bool AllocationTracker::WriteReport(const wstring& filename)
+	{
+#if defined(_WIN32)
+		ofstream stream(filename, ios::out | ios::trunc);
+#else
+		ofstream stream(wstring_convert<codecvt_utf8<wchar_t>>().to_bytes(filename), ios::out | ios::trunc);
+#endif
+		if (!stream.good())
+		{
+			return false;
+		}
+
+#if defined(_MSC_VER)
+		const uintptr_t imageBase = reinterpret_cast<uintptr_t>(&__ImageBase);
+#else
+		const uintptr_t imageBase = 0;
+#endif
+
+		stream << "ticks\t" << sTicks.TickCount << '\n'
+			<< "allocating_ticks\t" << sTicks.AllocatingTickCount << '\n'
+			<< "tick_allocations\t" << sTicks.Allocations << '\n'
+			<< "max_tick_allocations\t" << sTicks.MaxTickAllocations << '\n'
+			<< "violations\t" << sViolationCount << '\n';
+
+		// Call sites are image-relative so they can be resolved against the executable's symbols.
+		stream << "tick\tzone\tbytes\tcall_site\n";
+		const uint64_t retainedCount = (sViolationCount < MaxViolations ? sViolationCount : MaxViolations);
+		for (uint64_t i = 0; i < retainedCount; ++i)
+		{
+			const Violation& violation = sViolations[i];
+			stream << violation.Tick << '\t' << (violation.Zone != nullptr ? violation.Zone : "(none)") << '\t' << violation.Size
+				<< "\timage+0x" << hex << (reinterpret_cast<uintptr_t>(violation.CallSite) - imageBase) << dec << '\n';
+		}
+
+		return stream.good();
+	}
+
+	const char* AllocationTracker::CurrentZone()
+	{
+		return sThreadState.Zone;
+	}
+
+	const char* AllocationTracker::SetCurrentZone(const char* zone)
+	{
+		const char* previousZone = sThreadState.Zone;
+		sThreadState.Zone = zone;
+
+		return previousZone;
+	}
+
+	void AllocationTracker::RecordAllocation(size_t size, const void* callSite)
+	{
+		ThreadState& state = sThreadState;
+		++state.Totals.Allocations;
+		state.Totals.BytesAllocated += size;
+
+		if (state.InTick && sZeroAllocationTicks)
+		{
+			if (sViolationCount < MaxViolations)
+			{
+				Violation& violation = sViolations[sViolationCount];
+				violation.Tick = sTicks.TickCount;
+				violation.Zone = state.Zone;
+				violation.CallSite = callSite;
+				violation.Size = size;
+			}
+
+			++sViolationCount;
+		}
+	}
+
+	void AllocationTracker::RecordDeallocation()
+	{
+		++sThreadState.Totals.Deallocations;
+	}
+}
+
+#if DX_ALLOCATION_TRACKING_ENABLED
+
+// Replacement global allocation operators. They are kept out of line so the return address is the allocating call site.
+DX_NOINLINE void* operator new(size_t size)
+{
+	void* memory = malloc(size != 0 ? size : 1);
+	if (memory == nullptr)
+	{
+		throw bad_alloc();
+	}
+
+	DX::AllocationTracker::RecordAllocation(size, DX_RETURN_ADDRESS());
+	return memory;
+}
+
+DX_NOINLINE void* operator new[](size_t size)
+{
+	void* memory = malloc(size != 0 ? size : 1);
+	if (memory == nullptr)
+	{
+		throw bad_alloc();
+	}
+
+	DX::AllocationTracker::RecordAllocation(size, DX_RETURN_ADDRESS());
+	return memory;
+}
+
+DX_NOINLINE void* operator new(size_t size, const nothrow_t&) noexcept
+{
+	void* memory = malloc(size != 0 ? size : 1);
+	if (memory != nullptr)
+	{
+		DX::AllocationTracker::RecordAllocation(size, DX_RETURN_ADDRESS());
+	}
+
+	return memory;
+}
+
+DX_NOINLINE void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+	void* memory = malloc(size != 0 ? size : 1);
+	if (memory != nullptr)
+	{
+		DX::AllocationTracker::RecordAllocation(size, DX_RETURN_ADDRESS());
+	}
+
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	if (memory != nullptr)
+	{
+		DX::AllocationTracker::RecordDeallocation();
+		free(memory);
+	}
+}
+
+void operator delete[](void* memory) noexcept
+{
+	if (memory != nullptr)
+	{
+		DX::AllocationTracker::RecordDeallocation();
+		free(memory);
+	}
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	operator delete[](memory);
+}
+
+void operator delete(void* memory, const nothrow_t&) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete[](void* memory, const nothrow_t&) noexcept
+{
+	operator delete[](memory);
+}
+
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Allocation tracking replaces the global operator new/delete in debug builds. Release builds only get it when
+// DX_ALLOCATION_TRACKING_ENABLED is defined in the project's preprocessor definitions; otherwise every counter stays at zero.
+#if !defined(DX_ALLOCATION_TRACKING_ENABLED)
+#if defined(_DEBUG)
+#define DX_ALLOCATION_TRACKING_ENABLED 1
+#else
+#define DX_ALLOCATION_TRACKING_ENABLED 0
+#endif
+#endif
+
+// DX_ZERO_ALLOCATION_TICKS turns any allocation made by a steady-state game loop tick into a failure.
+#if defined(DX_ZERO_ALLOCATION_TICKS) && !DX_ALLOCATION_TRACKING_ENABLED
+#error DX_ZERO_ALLOCATION_TICKS requires DX_ALLOCATION_TRACKING_ENABLED.
+#endif
+
+namespace DX
+{
+	// Counts global operator new/delete calls per thread and attributes them to game loop ticks and profiling zones.
+	// In zero-allocation-tick mode every allocation made inside a tick is recorded with its call site so it can be reported.
+	class AllocationTracker final
+	{
+	public:
+		struct Counters
+		{
+			std::uint64_t Allocations;
+			std::uint64_t Deallocations;
+			std::uint64_t BytesAllocated;
+		};
+
+		struct TickSummary
+		{
+			std::uint64_t TickCount;
+			std::uint64_t AllocatingTickCount;
+			std::uint64_t Allocations;
+			std::uint64_t MaxTickAllocations;
+		};
+
+		// An allocation made inside a tick while zero-allocation ticks are enforced.
+		struct Violation
+		{
+			std::uint64_t Tick;
+			const char* Zone;
+			const void* CallSite;
+			std::size_t Size;
+		};
+
+		// Number of violations retained for the report; later ones are only counted.
+		static const std::uint32_t MaxViolations = 64;
+
+		static Counters ThreadCounters();
+		static std::uint64_t ThreadAllocationCount();
+
+		// Ticks are tracked on the thread that calls BeginTick (the game loop thread).
+		static void BeginTick();
+		static Counters EndTick();
+		static TickSummary Ticks();
+
+		static bool ZeroAllocationTicks();
+		static void SetZeroAllocationTicks(bool enabled);
+		static std::uint64_t ViolationCount();
+
+		// Writes the tick summary and the recorded violations, with call sites relative to the executable image.
+		static bool WriteReport(const std::wstring& filename);
+
+		// The innermost profiling zone of the calling thread, used to label violations.
+		static const char* CurrentZone();
+		static const char* SetCurrentZone(const char* zone);
+
+		// Called by the replacement allocation operators. Must not allocate.
+		static void RecordAllocation(std::size_t size, const void* callSite);
+		static void RecordDeallocation();
+
+		AllocationTracker() = delete;
+		AllocationTracker(const AllocationTracker&) = delete;
+		AllocationTracker& operator=(const AllocationTracker&) = delete;
+		AllocationTracker(AllocationTracker&&) = delete;
+		AllocationTracker& operator=(AllocationTracker&&) = delete;
+		~AllocationTracker() = default;
+
+	private:
+		struct ThreadState
+		{
+			Counters Totals;
+			Counters TickStart;
+			const char* Zone;
+			bool InTick;
+		};
+
+		static thread_local ThreadState sThreadState;
+		static TickSummary sTicks;
+		static bool sZeroAllocationTicks;
+		static std::uint64_t sViolationCount;
+		static Violation sViolations[MaxViolations];
+	};
+}
@@ -0,0 +1,603 @@
+#include "AssetLoader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+#if defined(_WIN32)
+		wstring Widen(const string& utf8)
+		{
+			if (utf8.empty())
+			{
+				return wstring();
+			}
+
+			const int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+			wstring wide(static_cast<size_t>(length), L'\0');
+			MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), &wide[0], length);
+			return wide;
+		}
+#endif
+
+		void CreateDirectoryIfMissing(const string& path)
+		{
+#if defined(_WIN32)
+			CreateDirectoryW(Widen(path).c_str(), nullptr);
+#else
+			mkdir(path.c_str(), 0755);
+#endif
+		}
+
+		FILE* OpenForWriting(const string& path)
+		{
+#if defined(_WIN32)
+			FILE* file = nullptr;
+			return (_wfopen_s(&file, Widen(path).c_str(), L"wb") == 0 ? file : nullptr);
+#else
+			return fopen(path.c_str(), "wb");
+#endif
+		}
+
+		void RemoveFile(const string& path)
+		{
+#if defined(_WIN32)
+			DeleteFileW(Widen(path).c_str());
+#else
+			unlink(path.c_str());
+#endif
+		}
+
+		// Replaces target with source in one step, so readers never see a partially written cache entry.
+		bool ReplaceFile(const string& source, const string& target)
+		{
+#if defined(_WIN32)
+			return (MoveFileExW(Widen(source).c_str(), Widen(target).c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+			return (rename(source.c_str(), target.c_str()) == 0);
+#endif
+		}
+
+		unsigned long ProcessId()
+		{
+#if defined(_WIN32)
+			return GetCurrentProcessId();
+#else
+			return static_cast<unsigned long>(getpid());
+#endif
+		}
+
+		inline uint64_t RotateLeft(uint64_t value, int bits)
+		{
+			return (value << bits) | (value >> (64 - bits));
+		}
+	}
+
+	AssetData::AssetData() :
+		mMapping(nullptr), mMappingSize(0), mData(nullptr), mSize(0)
+	{
+	}
+
+	AssetData::~AssetData()
+	{
+		if (mMapping != nullptr)
+		{
+#if defined(_WIN32)
+			UnmapViewOfFile(mMapping);
+#else
+			munmap(mMapping, mMappingSize);
+#endif
+		}
+	}
+
+	const uint8_t* AssetData::Data() const
+	{
+		return mData;
+	}
+
+	size_t AssetData::Size() const
+	{
+		return mSize;
+	}
+
+	bool AssetData::Mapped() const
+	{
+		return (mMapping != nullptr || (mParent != nullptr && mParent->Mapped()));
+	}
+
+	const uint32_t AssetLoader::CacheMagic = 0x43545844;	// "DXTC"
+	const uint32_t AssetLoader::CacheFileVersion = 2;
+
+	AssetLoader::AssetLoader(const string& cacheDirectory, uint32_t threadCount) :
+		mCacheDirectory(cacheDirectory), mTotals(), mTemporaryFileIndex(0), mShuttingDown(false)
+	{
+		static_assert(sizeof(CacheHeader) == 64, "Cache entries keep their pixels 64-byte aligned within the file.");
+
+		if (!mCacheDirectory.empty())
+		{
+			CreateDirectoryIfMissing(mCacheDirectory);
+		}
+
+		if (threadCount == 0)
+		{
+			threadCount = max(thread::hardware_concurrency(), 1U);
+		}
+
+		mWorkers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; ++i)
+		{
+			mWorkers.emplace_back(&AssetLoader::WorkerMain, this);
+		}
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		{
+			lock_guard<mutex> lock(mJobsMutex);
+			mShuttingDown = true;
+		}
+
+		mJobAvailable.notify_all();
+		for (auto& worker : mWorkers)
+		{
+			worker.join();
+		}
+	}
+
+	shared_future<AssetLoader::AssetPointer> AssetLoader::LoadAsync(const string& path)
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		auto found = mPendingFiles.find(path);
+		if (found != mPendingFiles.end())
+		{
+			++mTotals.SharedRequests;
+			return found->second;
+		}
+
+		auto result = make_shared<promise<AssetPointer>>();
+		shared_future<AssetPointer> load = result->get_future().share();
+		mPendingFiles.emplace(path, load);
+
+		Enqueue([this, path, result]() {
+			try
+			{
+				result->set_value(ReadAsset(path));
+			}
+			catch (...)
+			{
+				result->set_exception(current_exception());
+			}
+
+			lock_guard<mutex> lock(mMutex);
+			mPendingFiles.erase(path);
+		});
+
+		return load;
+	}
+
+	shared_future<AssetLoader::TexturePointer> AssetLoader::LoadTextureAsync(const string& path, uint32_t decoderVersion, const Decoder& decoder)
+	{
+		const string key = path + '|' + to_string(decoderVersion);
+
+		lock_guard<mutex> lock(mMutex);
+
+		auto found = mPendingTextures.find(key);
+		if (found != mPendingTextures.end())
+		{
+			++mTotals.SharedRequests;
+			return found->second;
+		}
+
+		auto result = make_shared<promise<TexturePointer>>();
+		shared_future<TexturePointer> load = result->get_future().share();
+		mPendingTextures.emplace(key, load);
+
+		Enqueue([this, path, key, decoderVersion, decoder, result]() {
+			try
+			{
+				result->set_value(LoadTexture(path, decoderVersion, decoder));
+			}
+			catch (...)
+			{
+				result->set_exception(current_exception());
+			}
+
+			lock_guard<mutex> lock(mMutex);
+			mPendingTextures.erase(key);
+		});
+
+		return load;
+	}
+
+	uint32_t AssetLoader::ThreadCount() const
+	{
+		return static_cast<uint32_t>(mWorkers.size());
+	}
+
+	AssetLoader::Counters AssetLoader::Totals() const
+	{
+		lock_guard<mutex> lock(mMutex);
+		return mTotals;
+	}
+
+	uint64_t AssetLoader::HashContent(const uint8_t* data, size_t size)
+	{
+		const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+		const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+
+		// Four independent lanes so the multiplies overlap, then a 64-bit finalizer.
+		uint64_t lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+		size_t offset = 0;
+		for (; offset + 32 <= size; offset += 32)
+		{
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				uint64_t word;
+				memcpy(&word, data + offset + lane * 8, sizeof(word));
+				lanes[lane] = RotateLeft(lanes[lane] + word * prime2, 31) * prime1;
+			}
+		}
+
+		uint64_t hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18) + static_cast<uint64_t>(size);
+		for (; offset < size; ++offset)
+		{
+			hash = RotateLeft(hash ^ (data[offset] * prime1), 11) * prime2;
+		}
+
+		hash ^= hash >> 33;
+		hash *= prime2;
+		hash ^= hash >> 29;
+		hash *= prime1;
+		hash ^= hash >> 32;
+
+		return hash;
+	}
+
+	void AssetLoader::Enqueue(function<void()>&& job)
+	{
+		{
+			lock_guard<mutex> lock(mJobsMutex);
+			mJobs.push_back(move(job));
+		}
+
+		mJobAvailable.notify_one();
+	}
+
+	void AssetLoader::WorkerMain()
+	{
+		for (;;)
+		{
+			function<void()> job;
+
+			{
+				unique_lock<mutex> lock(mJobsMutex);
+				mJobAvailable.wait(lock, [this]() { return (mShuttingDown || !mJobs.empty()); });
+
+				// Finish queued work before shutting down so every future is satisfied.
+				if (mJobs.empty())
+				{
+					return;
+				}
+
+				job = move(mJobs.front());
+				mJobs.pop_front();
+			}
+
+			job();
+		}
+	}
+
+	AssetLoader::AssetPointer AssetLoader::TryReadAsset(const string& path)
+	{
+		shared_ptr<AssetData> asset(new AssetData());
+		size_t size = 0;
+
+#if defined(_WIN32)
+		HANDLE file = CreateFile2(Widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return nullptr;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		size = static_cast<size_t>(fileSize.QuadPart);
+		if (size >= MapThreshold)
+		{
+			HANDLE mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+			if (mapping != nullptr)
+			{
+				asset->mMapping = MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+				asset->mMappingSize = size;
+				CloseHandle(mapping);
+			}
+		}
+
+		if (asset->mMapping == nullptr)
+		{
+			asset->mBuffer.resize(size);
+
+			size_t offset = 0;
+			while (offset < size)
+			{
+				OVERLAPPED overlapped = {};
+				overlapped.Offset = static_cast<DWORD>(offset);
+				overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+
+				const DWORD chunk = static_cast<DWORD>(min<size_t>(size - offset, 1U << 30));
+				DWORD bytesRead = 0;
+				if (!ReadFile(file, asset->mBuffer.data() + offset, chunk, &bytesRead, &overlapped) || bytesRead == 0)
+				{
+					CloseHandle(file);
+					return nullptr;
+				}
+
+				offset += bytesRead;
+			}
+		}
+
+		CloseHandle(file);
+#else
+		const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file < 0)
+		{
+			return nullptr;
+		}
+
+		struct stat status;
+		if (fstat(file, &status) != 0)
+		{
+			close(file);
+			return nullptr;
+		}
+
+		size = static_cast<size_t>(status.st_size);
+		if (size >= MapThreshold)
+		{
+			void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapping != MAP_FAILED)
+			{
+				asset->mMapping = mapping;
+				asset->mMappingSize = size;
+			}
+		}
+
+		if (asset->mMapping == nullptr)
+		{
+			asset->mBuffer.resize(size);
+
+			size_t offset = 0;
+			while (offset < size)
+			{
+				const ssize_t bytesRead = pread(file, asset->mBuffer.data() + offset, size - offset, static_cast<off_t>(offset));
+				if (bytesRead < 0 && errno == EINTR)
+				{
+					continue;
+				}
+
+				if (bytesRead <= 0)
+				{
+					close(file);
+					return nullptr;
+				}
+
+				offset += static_cast<size_t>(bytesRead);
+			}
+		}
+
+		close(file);
+#endif
+
+		asset->mData = (asset->mMapping != nullptr ? static_cast<const uint8_t*>(asset->mMapping) : asset->mBuffer.data());
+		asset->mSize = size;
+
+		lock_guard<mutex> lock(mMutex);
+		++mTotals.FileReads;
+		mTotals.BytesRead += size;
+		if (asset->mMapping != nullptr)
+		{
+			++mTotals.MappedFiles;
+		}
+
+		return asset;
+	}
+
+	AssetLoader::AssetPointer AssetLoader::ReadAsset(const string& path)
+	{
+		AssetPointer asset = TryReadAsset(path);
+		if (asset == nullptr)
+		{
+			throw runtime_error("AssetLoader: can't read " + path);
+		}
+
+		return asset;
+	}
+
+	AssetLoader::TexturePointer AssetLoader::LoadTexture(const string& path, uint32_t decoderVersion, const Decoder& decoder)
+	{
+		const AssetPointer source = ReadAsset(path);
+		const uint64_t contentHash = HashContent(source->Data(), source->Size());
+
+		string cachePath;
+		if (!mCacheDirectory.empty())
+		{
+			cachePath = CachePath(contentHash, decoderVersion);
+
+			TexturePointer cached = ReadCacheEntry(cachePath, contentHash, source->Size(), decoderVersion);
+			if (cached != nullptr)
+			{
+				lock_guard<mutex> lock(mMutex);
+				++mTotals.CacheHits;
+				return cached;
+			}
+		}
+
+		DecodedImage image = {};
+		if (!decoder(source->Data(), source->Size(), image))
+		{
+			throw runtime_error("AssetLoader: can't decode " + path);
+		}
+
+		// A single level is trimmed to its rows; a mip chain keeps everything the decoder packed.
+		const uint32_t mipCount = max(image.MipCount, 1U);
+		const uint64_t firstLevelBytes = static_cast<uint64_t>(image.RowPitch) * image.Height;
+		if (image.Pixels.size() < firstLevelBytes)
+		{
+			throw runtime_error("AssetLoader: decoder returned too few pixels for " + path);
+		}
+
+		const uint64_t pixelBytes = (mipCount > 1 ? image.Pixels.size() : firstLevelBytes);
+
+		bool cacheWritten = false;
+		if (!cachePath.empty())
+		{
+			CacheHeader header = {};
+			header.Magic = CacheMagic;
+			header.FileVersion = CacheFileVersion;
+			header.ContentHash = contentHash;
+			header.SourceSize = source->Size();
+			header.DecoderVersion = decoderVersion;
+			header.Width = image.Width;
+			header.Height = image.Height;
+			header.RowPitch = image.RowPitch;
+			header.Format = image.Format;
+			header.MipCount = mipCount;
+			header.PixelBytes = pixelBytes;
+
+			image.Pixels.resize(static_cast<size_t>(pixelBytes));
+			cacheWritten = WriteCacheEntry(cachePath, header, image.Pixels);
+		}
+
+		shared_ptr<AssetData> pixels(new AssetData());
+		pixels->mBuffer = move(image.Pixels);
+		pixels->mData = pixels->mBuffer.data();
+		pixels->mSize = pixels->mBuffer.size();
+
+		shared_ptr<Texture> texture = make_shared<Texture>();
+		texture->Width = image.Width;
+		texture->Height = image.Height;
+		texture->RowPitch = image.RowPitch;
+		texture->Format = image.Format;
+		texture->MipCount = mipCount;
+		texture->Pixels = pixels;
+		texture->FromCache = false;
+
+		lock_guard<mutex> lock(mMutex);
+		++mTotals.Decodes;
+		if (!cachePath.empty())
+		{
+			++mTotals.CacheMisses;
+		}
+
+		if (cacheWritten)
+		{
+			++mTotals.CacheWrites;
+		}
+
+		return texture;
+	}
+
+	string AssetLoader::CachePath(uint64_t contentHash, uint32_t decoderVersion) const
+	{
+		char name[48];
+		snprintf(name, sizeof(name), "/%016llx-%u.dtex", static_cast<unsigned long long>(contentHash), decoderVersion);
+		return mCacheDirectory + name;
+	}
+
+	AssetLoader::TexturePointer AssetLoader::ReadCacheEntry(const string& cachePath, uint64_t contentHash, uint64_t sourceSize, uint32_t decoderVersion)
+	{
+		AssetPointer entry = TryReadAsset(cachePath);
+		if (entry == nullptr || entry->Size() < sizeof(CacheHeader))
+		{
+			return nullptr;
+		}
+
+		CacheHeader header;
+		memcpy(&header, entry->Data(), sizeof(header));
+
+		// Anything that doesn't match exactly is treated as a miss and rewritten.
+		const uint64_t pixelBytes = entry->Size() - sizeof(CacheHeader);
+		const uint64_t firstLevelBytes = static_cast<uint64_t>(header.RowPitch) * header.Height;
+		if (header.Magic != CacheMagic || header.FileVersion != CacheFileVersion || header.ContentHash != contentHash ||
+			header.SourceSize != sourceSize || header.DecoderVersion != decoderVersion || header.PixelBytes != pixelBytes ||
+			header.MipCount == 0 || (header.MipCount == 1 ? firstLevelBytes != pixelBytes : firstLevelBytes > pixelBytes))
+		{
+			return nullptr;
+		}
+
+		shared_ptr<AssetData> pixels(new AssetData());
+		pixels->mParent = entry;
+		pixels->mData = entry->Data() + sizeof(CacheHeader);
+		pixels->mSize = static_cast<size_t>(pixelBytes);
+
+		shared_ptr<Texture> texture = make_shared<Texture>();
+		texture->Width = header.Width;
+		texture->Height = header.Height;
+		texture->RowPitch = header.RowPitch;
+		texture->Format = header.Format;
+		texture->MipCount = header.MipCount;
+		texture->Pixels = pixels;
+		texture->FromCache = true;
+
+		return texture;
+	}
+
+	bool AssetLoader::WriteCacheEntry(const string& cachePath, const CacheHeader& header, const vector<uint8_t>& pixels)
+	{
+		// Write under a unique name and move it into place, so concurrent loaders and crashed runs never leave a torn entry.
+		uint64_t temporaryIndex;
+		{
+			lock_guard<mutex> lock(mMutex);
+			temporaryIndex = mTemporaryFileIndex++;
+		}
+
+		const string temporaryPath = cachePath + ".tmp" + to_string(ProcessId()) + '.' + to_string(temporaryIndex);
+		FILE* file = OpenForWriting(temporaryPath);
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		bool written = (fwrite(&header, sizeof(header), 1, file) == 1);
+		if (written && !pixels.empty())
+		{
+			written = (fwrite(pixels.data(), pixels.size(), 1, file) == 1);
+		}
+
+		written = (fclose(file) == 0) && written;
+		if (!written || !ReplaceFile(temporaryPath, cachePath))
+		{
+			RemoveFile(temporaryPath);
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	// The bytes of a loaded file or cache entry. Large files are mapped rather than copied, so the data stays valid for as
+	// long as any reference to it is held.
+	class AssetData final
+	{
+	public:
+		AssetData(const AssetData&) = delete;
+		AssetData& operator=(const AssetData&) = delete;
+		AssetData(AssetData&&) = delete;
+		AssetData& operator=(AssetData&&) = delete;
+		~AssetData();
+
+		const std::uint8_t* Data() const;
+		std::size_t Size() const;
+		bool Mapped() const;
+
+	private:
+		friend class AssetLoader;
+
+		AssetData();
+
+		std::vector<std::uint8_t> mBuffer;
+		std::shared_ptr<const AssetData> mParent;	// Set for views into another asset, such as the pixels of a cache entry
+		void* mMapping;						// Base of the mapped view; null when the data lives in mBuffer
+		std::size_t mMappingSize;
+		const std::uint8_t* mData;
+		std::size_t mSize;
+	};
+
+	// Loads files on a pool of worker threads using the platform's mapped and positional reads. Requests for a file that is
+	// already being loaded share the pending result. Textures are decoded by a caller-supplied decoder and the decoded pixels
+	// are written to an on-disk cache keyed by a hash of the source file's contents, so later runs map the cached pixels
+	// instead of decoding again. This file only depends on the C++ standard library and the OS file APIs, so it builds for
+	// both the game and headless tools.
+	class AssetLoader final
+	{
+	public:
+		typedef std::shared_ptr<const AssetData> AssetPointer;
+
+		// Decoder output. Format is a DXGI_FORMAT value; the loader only stores it. Width, Height and RowPitch describe the
+		// first level. A decoder that produces a mip chain sets MipCount and packs the levels into Pixels, largest first, in
+		// whatever layout its format uses; the loader keeps all of Pixels for them. Zero means one level.
+		struct DecodedImage
+		{
+			std::uint32_t Width;
+			std::uint32_t Height;
+			std::uint32_t RowPitch;
+			std::uint32_t Format;
+			std::uint32_t MipCount;
+			std::vector<std::uint8_t> Pixels;
+		};
+
+		struct Texture
+		{
+			std::uint32_t Width;
+			std::uint32_t Height;
+			std::uint32_t RowPitch;
+			std::uint32_t Format;
+			std::uint32_t MipCount;		// At least one
+			AssetPointer Pixels;
+			bool FromCache;
+		};
+
+		typedef std::shared_ptr<const Texture> TexturePointer;
+
+		// Returns false if the data can't be decoded. Called on a worker thread.
+		typedef std::function<bool(const std::uint8_t* data, std::size_t size, DecodedImage& image)> Decoder;
+
+		struct Counters
+		{
+			std::uint64_t FileReads;
+			std::uint64_t MappedFiles;
+			std::uint64_t BytesRead;
+			std::uint64_t SharedRequests;		// Requests that joined a load already in flight
+			std::uint64_t CacheHits;
+			std::uint64_t CacheMisses;
+			std::uint64_t CacheWrites;
+			std::uint64_t Decodes;
+		};
+
+		// Files at least this large are mapped; smaller ones are read into memory, which is cheaper than setting up a view.
+		static const std::size_t MapThreshold = 64 * 1024;
+
+		// An empty cache directory disables the decoded-texture cache. A thread count of zero uses one thread per hardware
+		// thread.
+		explicit AssetLoader(const std::string& cacheDirectory = std::string(), std::uint32_t threadCount = 0);
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		AssetLoader(AssetLoader&&) = delete;
+		AssetLoader& operator=(AssetLoader&&) = delete;
+		~AssetLoader();
+
+		// Paths are UTF-8. Failures are reported through the future as std::runtime_error.
+		std::shared_future<AssetPointer> LoadAsync(const std::string& path);
+
+		// Bump decoderVersion whenever the decoder's output changes; it is part of the cache key.
+		std::shared_future<TexturePointer> LoadTextureAsync(const std::string& path, std::uint32_t decoderVersion, const Decoder& decoder);
+
+		std::uint32_t ThreadCount() const;
+		Counters Totals() const;
+
+		// 64-bit hash of a block of memory. Used for cache keys; not cryptographic.
+		static std::uint64_t HashContent(const std::uint8_t* data, std::size_t size);
+
+	private:
+		struct CacheHeader
+		{
+			std::uint32_t Magic;
+			std::uint32_t FileVersion;
+			std::uint64_t ContentHash;
+			std::uint64_t SourceSize;
+			std::uint32_t DecoderVersion;
+			std::uint32_t Width;
+			std::uint32_t Height;
+			std::uint32_t RowPitch;
+			std::uint32_t Format;
+			std::uint32_t MipCount;
+			std::uint32_t Reserved[2];
+			std::uint64_t PixelBytes;
+		};
+
+		static const std::uint32_t CacheMagic;
+		static const std::uint32_t CacheFileVersion;
+
+		void Enqueue(std::function<void()>&& job);
+		void WorkerMain();
+
+		// TryReadAsset returns null if the file can't be opened; ReadAsset throws.
+		AssetPointer TryReadAsset(const std::string& path);
+		AssetPointer ReadAsset(const std::string& path);
+		TexturePointer LoadTexture(const std::string& path, std::uint32_t decoderVersion, const Decoder& decoder);
+		std::string CachePath(std::uint64_t contentHash, std::uint32_t decoderVersion) const;
+		TexturePointer ReadCacheEntry(const std::string& cachePath, std::uint64_t contentHash, std::uint64_t sourceSize, std::uint32_t decoderVersion);
+		bool WriteCacheEntry(const std::string& cachePath, const CacheHeader& header, const std::vector<std::uint8_t>& pixels);
+
+		std::string mCacheDirectory;
+		std::map<std::string, std::shared_future<AssetPointer>> mPendingFiles;
+		std::map<std::string, std::shared_future<TexturePointer>> mPendingTextures;
+		Counters mTotals;
+		std::uint64_t mTemporaryFileIndex;
+		mutable std::mutex mMutex;
+
+		std::vector<std::thread> mWorkers;
+		std::deque<std::function<void()>> mJobs;
+		std::mutex mJobsMutex;
+		std::condition_variable mJobAvailable;
+		bool mShuttingDown;
+	};
+}
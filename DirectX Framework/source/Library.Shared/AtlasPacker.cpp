@@ -0,0 +1,277 @@
+#include "AtlasPacker.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		uint32_t NextPowerOfTwo(uint32_t value)
+		{
+			uint32_t powerOfTwo = 1;
+			while (powerOfTwo < value)
+			{
+				powerOfTwo <<= 1;
+			}
+
+			return powerOfTwo;
+		}
+	}
+
+	AtlasPacker::AtlasPacker(uint32_t maxPageSize, uint32_t padding) :
+		mMaxPageSize(NextPowerOfTwo(maxPageSize)), mPadding(padding), mImages(nullptr)
+	{
+	}
+
+	bool AtlasPacker::Pack(const Size* images, uint32_t count)
+	{
+		mImages = images;
+		mPages.clear();
+		mPlacements.assign(count, Placement{ 0, 0, 0 });
+
+		// Largest side first, then largest other side, is the order MaxRects packs tightest with.
+		vector<uint32_t> remaining(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (images[i].Width + 2 * mPadding > mMaxPageSize || images[i].Height + 2 * mPadding > mMaxPageSize)
+			{
+				mPlacements.clear();
+				return false;
+			}
+
+			remaining[i] = i;
+		}
+
+		stable_sort(remaining.begin(), remaining.end(), [images](uint32_t left, uint32_t right) {
+			const uint32_t leftLong = max(images[left].Width, images[left].Height);
+			const uint32_t rightLong = max(images[right].Width, images[right].Height);
+			if (leftLong != rightLong)
+			{
+				return leftLong > rightLong;
+			}
+
+			return min(images[left].Width, images[left].Height) > min(images[right].Width, images[right].Height);
+		});
+
+		vector<uint32_t> unplaced;
+		while (!remaining.empty())
+		{
+			// Start at the smallest power-of-two page that holds the largest image and could hold the total area.
+			uint64_t area = 0;
+			Size page = { 1, 1 };
+			for (const uint32_t image : remaining)
+			{
+				const uint32_t width = images[image].Width + 2 * mPadding;
+				const uint32_t height = images[image].Height + 2 * mPadding;
+				area += static_cast<uint64_t>(width) * height;
+				page.Width = max(page.Width, NextPowerOfTwo(width));
+				page.Height = max(page.Height, NextPowerOfTwo(height));
+			}
+
+			while (static_cast<uint64_t>(page.Width) * page.Height < area && (page.Width < mMaxPageSize || page.Height < mMaxPageSize))
+			{
+				(page.Width <= page.Height && page.Width < mMaxPageSize ? page.Width : page.Height) <<= 1;
+			}
+
+			const uint32_t pageIndex = static_cast<uint32_t>(mPages.size());
+			while (!PackPage(page, pageIndex, remaining, false, unplaced))
+			{
+				if (page.Width == mMaxPageSize && page.Height == mMaxPageSize)
+				{
+					// Fill the largest page as far as it goes and carry the rest to the next one.
+					PackPage(page, pageIndex, remaining, true, unplaced);
+					break;
+				}
+
+				(page.Width <= page.Height && page.Width < mMaxPageSize ? page.Width : page.Height) <<= 1;
+			}
+
+			mPages.push_back(page);
+			remaining.swap(unplaced);
+		}
+
+		return true;
+	}
+
+	const vector<AtlasPacker::Size>& AtlasPacker::Pages() const
+	{
+		return mPages;
+	}
+
+	const vector<AtlasPacker::Placement>& AtlasPacker::Placements() const
+	{
+		return mPlacements;
+	}
+
+	double AtlasPacker::Occupancy() const
+	{
+		uint64_t pageArea = 0;
+		for (const Size& page : mPages)
+		{
+			pageArea += static_cast<uint64_t>(page.Width) * page.Height;
+		}
+
+		uint64_t imageArea = 0;
+		for (uint32_t i = 0; i < mPlacements.size(); ++i)
+		{
+			imageArea += static_cast<uint64_t>(mImages[i].Width) * mImages[i].Height;
+		}
+
+		return (pageArea > 0 ? static_cast<double>(imageArea) / static_cast<double>(pageArea) : 0.0);
+	}
+
+	void AtlasPacker::CopyWithExtrusion(const uint8_t* image, uint32_t width, uint32_t height, uint32_t imagePitch,
+		uint8_t* page, uint32_t pagePitch, uint32_t x, uint32_t y, uint32_t padding)
+	{
+		if (width == 0 || height == 0)
+		{
+			return;
+		}
+
+		// Each destination row, padding included, is its source row with the first and last pixels repeated; the rows of
+		// padding above and below repeat the first and last rows.
+		for (uint32_t row = 0; row < height + 2 * padding; ++row)
+		{
+			const uint32_t sourceRow = (row < padding ? 0 : min(row - padding, height - 1));
+			const uint8_t* source = image + static_cast<size_t>(sourceRow) * imagePitch;
+			uint8_t* destination = page + static_cast<size_t>(y + row - padding) * pagePitch + static_cast<size_t>(x - padding) * 4;
+
+			for (uint32_t column = 0; column < padding; ++column)
+			{
+				memcpy(destination + column * 4, source, 4);
+			}
+
+			memcpy(destination + padding * 4, source, static_cast<size_t>(width) * 4);
+
+			for (uint32_t column = 0; column < padding; ++column)
+			{
+				memcpy(destination + (padding + width + column) * 4, source + (width - 1) * 4, 4);
+			}
+		}
+	}
+
+	bool AtlasPacker::PackPage(const Size& page, uint32_t pageIndex, const vector<uint32_t>& order, bool partial, vector<uint32_t>& unplaced)
+	{
+		unplaced.clear();
+		mFreeRectangles.clear();
+		mFreeRectangles.push_back(Rectangle{ 0, 0, page.Width, page.Height });
+
+		for (const uint32_t image : order)
+		{
+			const uint32_t width = mImages[image].Width + 2 * mPadding;
+			const uint32_t height = mImages[image].Height + 2 * mPadding;
+
+			// Best short side fit: the free rectangle that leaves the least on the image's tighter side, then the other.
+			size_t best = mFreeRectangles.size();
+			uint32_t bestShortSide = numeric_limits<uint32_t>::max();
+			uint32_t bestLongSide = numeric_limits<uint32_t>::max();
+			for (size_t i = 0; i < mFreeRectangles.size(); ++i)
+			{
+				const Rectangle& free = mFreeRectangles[i];
+				if (width <= free.Width && height <= free.Height)
+				{
+					const uint32_t leftoverWidth = free.Width - width;
+					const uint32_t leftoverHeight = free.Height - height;
+					const uint32_t shortSide = min(leftoverWidth, leftoverHeight);
+					const uint32_t longSide = max(leftoverWidth, leftoverHeight);
+					if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+					{
+						best = i;
+						bestShortSide = shortSide;
+						bestLongSide = longSide;
+					}
+				}
+			}
+
+			if (best == mFreeRectangles.size())
+			{
+				if (!partial)
+				{
+					return false;
+				}
+
+				unplaced.push_back(image);
+				continue;
+			}
+
+			const Rectangle used = { mFreeRectangles[best].X, mFreeRectangles[best].Y, width, height };
+			mPlacements[image] = Placement{ pageIndex, used.X + mPadding, used.Y + mPadding };
+			SplitFreeRectangles(used);
+			PruneFreeRectangles();
+		}
+
+		return true;
+	}
+
+	// Removes each free rectangle the used one overlaps and collects the up to four maximal free rectangles around it.
+	void AtlasPacker::SplitFreeRectangles(const Rectangle& used)
+	{
+		mSplitRectangles.clear();
+		for (size_t i = 0; i < mFreeRectangles.size();)
+		{
+			const Rectangle free = mFreeRectangles[i];
+			if (used.X >= free.X + free.Width || used.X + used.Width <= free.X || used.Y >= free.Y + free.Height || used.Y + used.Height <= free.Y)
+			{
+				++i;
+				continue;
+			}
+
+			if (used.X > free.X)
+			{
+				mSplitRectangles.push_back(Rectangle{ free.X, free.Y, used.X - free.X, free.Height });
+			}
+
+			if (used.X + used.Width < free.X + free.Width)
+			{
+				mSplitRectangles.push_back(Rectangle{ used.X + used.Width, free.Y, free.X + free.Width - (used.X + used.Width), free.Height });
+			}
+
+			if (used.Y > free.Y)
+			{
+				mSplitRectangles.push_back(Rectangle{ free.X, free.Y, free.Width, used.Y - free.Y });
+			}
+
+			if (used.Y + used.Height < free.Y + free.Height)
+			{
+				mSplitRectangles.push_back(Rectangle{ free.X, used.Y + used.Height, free.Width, free.Y + free.Height - (used.Y + used.Height) });
+			}
+
+			mFreeRectangles[i] = mFreeRectangles.back();
+			mFreeRectangles.pop_back();
+		}
+	}
+
+	// Adds the rectangles split off the used one that don't lie inside another free rectangle. The free rectangles that
+	// survived the split can't lie inside a new one, because each new one lies inside a free rectangle the split removed.
+	void AtlasPacker::PruneFreeRectangles()
+	{
+		const auto contains = [](const Rectangle& outer, const Rectangle& inner) {
+			return inner.X >= outer.X && inner.Y >= outer.Y && inner.X + inner.Width <= outer.X + outer.Width && inner.Y + inner.Height <= outer.Y + outer.Height;
+		};
+
+		const size_t survivors = mFreeRectangles.size();
+		for (size_t i = 0; i < mSplitRectangles.size(); ++i)
+		{
+			const Rectangle& candidate = mSplitRectangles[i];
+			bool contained = false;
+			for (size_t j = 0; j < survivors && !contained; ++j)
+			{
+				contained = contains(mFreeRectangles[j], candidate);
+			}
+
+			// Of two identical new rectangles, keep the first.
+			for (size_t j = 0; j < mSplitRectangles.size() && !contained; ++j)
+			{
+				contained = (j != i && contains(mSplitRectangles[j], candidate) && (j < i || !contains(candidate, mSplitRectangles[j])));
+			}
+
+			if (!contained)
+			{
+				mFreeRectangles.push_back(candidate);
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Packs images into power-of-two atlas pages with the MaxRects algorithm, placing each image, largest first, in the free
+	// rectangle it fits most tightly (best short side fit). Each page starts at the smallest power-of-two size that could
+	// hold what is left and grows until everything fits or it reaches the largest page size; whatever doesn't fit then goes
+	// on another page. Every image keeps a border of padding pixels of its own, which CopyWithExtrusion fills with the
+	// image's edge pixels so that filtering at the image's edges doesn't pick up its neighbors.
+	//
+	// An offline tool; AtlasBuilder runs it. This file only depends on the C++ standard library.
+	class AtlasPacker final
+	{
+	public:
+		struct Size
+		{
+			std::uint32_t Width;
+			std::uint32_t Height;
+		};
+
+		// Where an image went: the top left of the image itself, inside its padding.
+		struct Placement
+		{
+			std::uint32_t Page;
+			std::uint32_t X;
+			std::uint32_t Y;
+		};
+
+		static const std::uint32_t DefaultMaxPageSize = 4096;
+		static const std::uint32_t DefaultPadding = 2;
+
+		explicit AtlasPacker(std::uint32_t maxPageSize = DefaultMaxPageSize, std::uint32_t padding = DefaultPadding);
+
+		// Replaces the pages and placements; image i goes to Placements()[i]. Returns false, placing nothing, if an image
+		// and its padding are larger than the largest page.
+		bool Pack(const Size* images, std::uint32_t count);
+
+		const std::vector<Size>& Pages() const;
+		const std::vector<Placement>& Placements() const;
+
+		// The images' area, without padding, over the pages' area.
+		double Occupancy() const;
+
+		// Copies a 32-bit image into a page at x, y and extrudes its edge pixels padding pixels outward. Pitches are in bytes.
+		static void CopyWithExtrusion(const std::uint8_t* image, std::uint32_t width, std::uint32_t height, std::uint32_t imagePitch,
+			std::uint8_t* page, std::uint32_t pagePitch, std::uint32_t x, std::uint32_t y, std::uint32_t padding);
+
+	private:
+		struct Rectangle
+		{
+			std::uint32_t X;
+			std::uint32_t Y;
+			std::uint32_t Width;
+			std::uint32_t Height;
+		};
+
+		// Packs the images in order onto one page. When partial is false, gives up at the first image that doesn't fit;
+		// otherwise skips it and leaves it in unplaced.
+		bool PackPage(const Size& page, std::uint32_t pageIndex, const std::vector<std::uint32_t>& order, bool partial, std::vector<std::uint32_t>& unplaced);
+		void SplitFreeRectangles(const Rectangle& used);
+		void PruneFreeRectangles();
+
+		std::uint32_t mMaxPageSize;
+		std::uint32_t mPadding;
+		const Size* mImages;
+		std::vector<Size> mPages;
+		std::vector<Placement> mPlacements;
+		std::vector<Rectangle> mFreeRectangles;
+		std::vector<Rectangle> mSplitRectangles;	// Split off the last used rectangle, before pruning
+	};
+}
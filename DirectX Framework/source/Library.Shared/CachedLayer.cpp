@@ -0,0 +1,166 @@
+#include "CachedLayer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		const float Transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		// Row-major after transposing back: clip = viewProjection * (x, y, 0, 1), divided by w.
+		void TransformPoint(const float* viewProjection, float x, float y, float& clipX, float& clipY)
+		{
+			const float w = viewProjection[12] * x + viewProjection[13] * y + viewProjection[15];
+			clipX = (viewProjection[0] * x + viewProjection[1] * y + viewProjection[3]) / w;
+			clipY = (viewProjection[4] * x + viewProjection[5] * y + viewProjection[7]) / w;
+		}
+	}
+
+	CachedLayer::CachedLayer() :
+		mTarget(RenderCommandList::BackBuffer), mWidth(0), mHeight(0), mViewProjection(), mDirty(true), mDirtyBounds(), mDirtyBoundsCount(0)
+	{
+	}
+
+	RenderTargetHandle CachedLayer::Target() const
+	{
+		return mTarget;
+	}
+
+	uint32_t CachedLayer::Width() const
+	{
+		return mWidth;
+	}
+
+	uint32_t CachedLayer::Height() const
+	{
+		return mHeight;
+	}
+
+	void CachedLayer::SetTarget(RenderTargetHandle target, uint32_t width, uint32_t height)
+	{
+		mTarget = target;
+		mWidth = width;
+		mHeight = height;
+		Invalidate();
+	}
+
+	bool CachedLayer::SetViewProjection(const float* viewProjection)
+	{
+		if (memcmp(viewProjection, mViewProjection, sizeof(mViewProjection)) == 0)
+		{
+			return false;
+		}
+
+		memcpy(mViewProjection, viewProjection, sizeof(mViewProjection));
+		Invalidate();
+		return true;
+	}
+
+	void CachedLayer::Invalidate()
+	{
+		mDirty = true;
+		mDirtyBoundsCount = 0;
+	}
+
+	void CachedLayer::Invalidate(const Bounds& bounds)
+	{
+		if (mDirty)
+		{
+			return;
+		}
+
+		if (mDirtyBoundsCount == MaxDirtyBounds)
+		{
+			Invalidate();
+			return;
+		}
+
+		mDirtyBounds[mDirtyBoundsCount++] = bounds;
+	}
+
+	bool CachedLayer::NeedsUpdate() const
+	{
+		return (mDirty || mDirtyBoundsCount > 0);
+	}
+
+	PixelRect CachedLayer::PixelBounds(const Bounds& bounds) const
+	{
+		// Without rotation two opposite corners are enough.
+		float left;
+		float bottom;
+		float right;
+		float top;
+		TransformPoint(mViewProjection, bounds.Left, bounds.Bottom, left, bottom);
+		TransformPoint(mViewProjection, bounds.Right, bounds.Top, right, top);
+
+		const float width = static_cast<float>(mWidth);
+		const float height = static_cast<float>(mHeight);
+		const float pixelLeft = floor((min(left, right) + 1.0f) * 0.5f * width);
+		const float pixelRight = ceil((max(left, right) + 1.0f) * 0.5f * width);
+		const float pixelTop = floor((1.0f - max(bottom, top)) * 0.5f * height);
+		const float pixelBottom = ceil((1.0f - min(bottom, top)) * 0.5f * height);
+
+		PixelRect rect;
+		rect.Left = static_cast<uint32_t>(min(max(pixelLeft, 0.0f), width));
+		rect.Top = static_cast<uint32_t>(min(max(pixelTop, 0.0f), height));
+		rect.Right = static_cast<uint32_t>(min(max(pixelRight, 0.0f), width));
+		rect.Bottom = static_cast<uint32_t>(min(max(pixelBottom, 0.0f), height));
+		return rect;
+	}
+
+	void CachedLayer::BeginUpdate(RenderCommandList& commandList) const
+	{
+		commandList.SetRenderTarget(mTarget);
+	}
+
+	void CachedLayer::EndUpdate(RenderCommandList& commandList, uint32_t vertexCount, uint32_t instanceCount)
+	{
+		if (mDirty)
+		{
+			commandList.ClearRenderTarget(Transparent);
+			if (instanceCount > 0)
+			{
+				commandList.DrawInstanced(vertexCount, instanceCount);
+			}
+		}
+		else
+		{
+			// All of the content is drawn again, but the scissor keeps only the pixels written to the changed rectangle, which
+			// also repaints whatever else overlaps it.
+			for (uint32_t i = 0; i < mDirtyBoundsCount; ++i)
+			{
+				const PixelRect rect = PixelBounds(mDirtyBounds[i]);
+				if (rect.Right <= rect.Left || rect.Bottom <= rect.Top)
+				{
+					continue;
+				}
+
+				commandList.ClearRenderTarget(Transparent, rect);
+				if (instanceCount > 0)
+				{
+					commandList.SetScissor(rect);
+					commandList.DrawInstanced(vertexCount, instanceCount);
+				}
+			}
+
+			commandList.ResetScissor();
+		}
+
+		commandList.SetRenderTarget(RenderCommandList::BackBuffer);
+		mDirty = false;
+		mDirtyBoundsCount = 0;
+	}
+
+	void CachedLayer::RecordComposite(RenderCommandList& commandList, PipelineHandle pipeline, MeshHandle mesh, uint32_t vertexCount) const
+	{
+		commandList.SetPipeline(pipeline);
+		commandList.SetMesh(mesh);
+		commandList.SetConstants(ShaderStage::Vertex, mViewProjection);
+		commandList.SetTexture(mTarget);
+		commandList.Draw(vertexCount);
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "RenderCommandList.h"
+#include <cstdint>
+
+namespace DX
+{
+	// Keeps content that rarely changes in an offscreen render target and composites it each frame with one quad. The layer
+	// tracks what needs redrawing: all of it after a new target or view-projection, or only the pixels under world-space
+	// rectangles that changed, which are cleared and redrawn with the content's draw scissored to each of them. The layer
+	// records commands but creates nothing; its owner creates the target, pipelines and meshes with its render backend.
+	// This file only depends on the C++ standard library.
+	class CachedLayer final
+	{
+	public:
+		// A world-space rectangle in the xy plane.
+		struct Bounds
+		{
+			float Left;
+			float Bottom;
+			float Right;
+			float Top;
+		};
+
+		// Changed rectangles kept between updates. Invalidating more than this redraws all of the layer, which is also about
+		// what that many scissored redraws of the whole content would cost.
+		static const std::uint32_t MaxDirtyBounds = 16;
+
+		CachedLayer();
+		CachedLayer(const CachedLayer&) = delete;
+		CachedLayer& operator=(const CachedLayer&) = delete;
+		CachedLayer(CachedLayer&&) = delete;
+		CachedLayer& operator=(CachedLayer&&) = delete;
+		~CachedLayer() = default;
+
+		// Starts out as RenderCommandList::BackBuffer, 0 x 0, until SetTarget.
+		RenderTargetHandle Target() const;
+		std::uint32_t Width() const;
+		std::uint32_t Height() const;
+
+		// Draws into target from now on; all of it is redrawn.
+		void SetTarget(RenderTargetHandle target, std::uint32_t width, std::uint32_t height);
+
+		// The sixteen floats of the matrix, transposed as the components upload it; it places both the content and the
+		// composite quad. Returns whether it changed, in which case all of the layer is redrawn.
+		bool SetViewProjection(const float* viewProjection);
+
+		void Invalidate();
+
+		// Redraws only the pixels under bounds; never allocates, falling back to Invalidate() past MaxDirtyBounds.
+		void Invalidate(const Bounds& bounds);
+		bool NeedsUpdate() const;
+
+		// The pixels of the layer a world rectangle touches, partly covered pixels included, clamped to the layer. The
+		// view-projection must not rotate or skew.
+		PixelRect PixelBounds(const Bounds& bounds) const;
+
+		// Binds the layer as the render target. Bind the content's pipeline, mesh and constants after it, then call
+		// EndUpdate with the content's draw.
+		void BeginUpdate(RenderCommandList& commandList) const;
+
+		// Clears what needs redrawing and draws instanceCount instances of vertexCount vertices over it, rebinds the back
+		// buffer and marks the layer up to date.
+		void EndUpdate(RenderCommandList& commandList, std::uint32_t vertexCount, std::uint32_t instanceCount);
+
+		// Draws the layer into the bound target through pipeline, whose pixel shader reads texture slot 0 at the pixel's
+		// own position, with mesh covering the content in world space.
+		void RecordComposite(RenderCommandList& commandList, PipelineHandle pipeline, MeshHandle mesh, std::uint32_t vertexCount) const;
+
+	private:
+		RenderTargetHandle mTarget;
+		std::uint32_t mWidth;
+		std::uint32_t mHeight;
+		float mViewProjection[16];
+		bool mDirty;							// All of the layer needs redrawing
+		Bounds mDirtyBounds[MaxDirtyBounds];	// Changed since the layer was last updated
+		std::uint32_t mDirtyBoundsCount;
+	};
+}
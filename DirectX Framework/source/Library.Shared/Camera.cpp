@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Camera.h"
+#include "MatrixHelper.h"
 
 using namespace std;
 using namespace DirectX;
@@ -11,7 +12,7 @@ namespace DX
 
 	Camera::Camera(const shared_ptr<DX::DeviceResources>& deviceResources, float nearPlaneDistance, float farPlaneDistance) :
 		GameComponent(deviceResources),
-		mNearPlaneDistance(nearPlaneDistance), mFarPlaneDistance(farPlaneDistance)
+		mNearPlaneDistance(nearPlaneDistance), mFarPlaneDistance(farPlaneDistance), mProjectionMatrix(MatrixHelper::Identity), mViewMatrixDirty(true)
 	{		
 		Reset();
 	}
@@ -78,10 +79,12 @@ namespace DX
 
 	XMMATRIX Camera::ViewProjectionMatrix() const
 	{
-		XMMATRIX viewMatrix = XMLoadFloat4x4(&mViewMatrix);
-		XMMATRIX projectionMatrix = XMLoadFloat4x4(&mProjectionMatrix);
+		return XMLoadFloat4x4(&mViewProjectionMatrix);
+	}
 
-		return XMMatrixMultiply(viewMatrix, projectionMatrix);
+	const XMFLOAT4& Camera::VisibleBounds() const
+	{
+		return mVisibleBounds;
 	}
 
 	void Camera::SetPosition(float x, float y, float z)
@@ -93,11 +96,13 @@ namespace DX
 	void Camera::SetPosition(FXMVECTOR position)
 	{
 		XMStoreFloat3(&mPosition, position);
+		mViewMatrixDirty = true;
 	}
 
 	void Camera::SetPosition(const XMFLOAT3& position)
 	{
 		mPosition = position;
+		mViewMatrixDirty = true;
 	}
 
 	void Camera::CreateDeviceDependentResources()
@@ -119,7 +124,10 @@ namespace DX
 	{
 		UNREFERENCED_PARAMETER(timer);
 
-		UpdateViewMatrix();
+		if (mViewMatrixDirty)
+		{
+			UpdateViewMatrix();
+		}
 	}
 
 	void Camera::UpdateViewMatrix()
@@ -130,6 +138,33 @@ namespace DX
 
 		XMMATRIX viewMatrix = XMMatrixLookToRH(eyePosition, direction, upDirection);
 		XMStoreFloat4x4(&mViewMatrix, viewMatrix);
+		mViewMatrixDirty = false;
+
+		UpdateViewProjectionMatrix();
+	}
+
+	void Camera::UpdateViewProjectionMatrix()
+	{
+		XMMATRIX viewMatrix = XMLoadFloat4x4(&mViewMatrix);
+		XMMATRIX projectionMatrix = XMLoadFloat4x4(&mProjectionMatrix);
+		XMMATRIX viewProjectionMatrix = XMMatrixMultiply(viewMatrix, projectionMatrix);
+		XMStoreFloat4x4(&mViewProjectionMatrix, viewProjectionMatrix);
+
+		// The corners of the clip-space rectangle, taken back to world space.
+		XMVECTOR determinant;
+		XMMATRIX inverseViewProjection = XMMatrixInverse(&determinant, viewProjectionMatrix);
+		XMVECTOR minimum = XMVector3TransformCoord(XMVectorSet(-1.0f, -1.0f, 0.0f, 1.0f), inverseViewProjection);
+		XMVECTOR maximum = minimum;
+		const float cornerX[3] = { 1.0f, -1.0f, 1.0f };
+		const float cornerY[3] = { -1.0f, 1.0f, 1.0f };
+		for (int i = 0; i < 3; ++i)
+		{
+			XMVECTOR corner = XMVector3TransformCoord(XMVectorSet(cornerX[i], cornerY[i], 0.0f, 1.0f), inverseViewProjection);
+			minimum = XMVectorMin(minimum, corner);
+			maximum = XMVectorMax(maximum, corner);
+		}
+
+		mVisibleBounds = XMFLOAT4(XMVectorGetX(minimum), XMVectorGetY(minimum), XMVectorGetX(maximum), XMVectorGetY(maximum));
 	}
 
 	void Camera::ApplyRotation(CXMMATRIX transform)
@@ -149,6 +184,7 @@ namespace DX
 		XMStoreFloat3(&mDirection, direction);
 		XMStoreFloat3(&mUp, up);
 		XMStoreFloat3(&mRight, right);
+		mViewMatrixDirty = true;
 	}
 
 	void Camera::ApplyRotation(const XMFLOAT4X4& transform)
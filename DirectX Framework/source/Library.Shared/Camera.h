@@ -30,14 +30,20 @@ namespace DX
 
 		DirectX::XMMATRIX ViewMatrix() const;
 		DirectX::XMMATRIX ProjectionMatrix() const;
+		// Cached; refreshed when the view or projection matrix is updated.
 		DirectX::XMMATRIX ViewProjectionMatrix() const;
 
+		// The world-space rectangle (left, bottom, right, top) in the xy plane that the camera sees, for an orthographic
+		// camera looking along z. Refreshed with the view-projection matrix.
+		const DirectX::XMFLOAT4& VisibleBounds() const;
+
 		virtual void SetPosition(float x, float y, float z);
 		virtual void SetPosition(DirectX::FXMVECTOR position);
 		virtual void SetPosition(const DirectX::XMFLOAT3& position);
 
 		virtual void CreateDeviceDependentResources() override;
 		virtual void Reset();
+		// Updates the view matrix if the position or orientation changed since it was last updated.
 		virtual void Update(const StepTimer& timer) override;
 		virtual void UpdateViewMatrix();
 		virtual void UpdateProjectionMatrix() = 0;
@@ -48,6 +54,9 @@ namespace DX
 		static const float DefaultFarPlaneDistance;
 
 	protected:
+		// Derived classes call this after writing mProjectionMatrix.
+		void UpdateViewProjectionMatrix();
+
 		float mNearPlaneDistance;
 		float mFarPlaneDistance;
 
@@ -58,5 +67,8 @@ namespace DX
 
 		DirectX::XMFLOAT4X4 mViewMatrix;
 		DirectX::XMFLOAT4X4 mProjectionMatrix;
+		DirectX::XMFLOAT4X4 mViewProjectionMatrix;
+		DirectX::XMFLOAT4 mVisibleBounds;
+		bool mViewMatrixDirty;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "ConstantBufferRing.h"
+#include "RenderCommandList.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace DX
+{
+	ConstantBufferRing::ConstantBufferRing(uint32_t capacity) :
+		mCapacity(AlignedSize(max(capacity, Alignment))), mHead(0), mCursor(0), mMapEnd(0), mNeedsDiscard(true), mTotals(), mFrame(), mLastFrame()
+	{
+	}
+
+	uint32_t ConstantBufferRing::Capacity() const
+	{
+		return mCapacity;
+	}
+
+	uint32_t ConstantBufferRing::AlignedSize(uint32_t size)
+	{
+		return (size + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	uint32_t ConstantBufferRing::BytesNeeded(const RenderCommandList& commandList)
+	{
+		uint32_t bytes = 0;
+		const RenderCommand* commands = commandList.Commands();
+		for (size_t i = 0; i < commandList.CommandCount(); ++i)
+		{
+			if (commands[i].Type == RenderCommandType::SetConstants)
+			{
+				bytes += AlignedSize(commands[i].DataSize);
+			}
+		}
+
+		return bytes;
+	}
+
+	ConstantBufferRing::Range ConstantBufferRing::Map(uint32_t bytes)
+	{
+		Range range;
+		range.Grew = false;
+
+		// Grown to hold at least two such lists, so a steady workload doesn't discard on every map.
+		if (2 * bytes > mCapacity)
+		{
+			while (mCapacity < 2 * bytes)
+			{
+				mCapacity *= 2;
+			}
+
+			range.Grew = true;
+			mNeedsDiscard = true;
+			++mFrame.Growths;
+		}
+
+		// Wrapping around discards, so ranges handed out earlier are never written while the GPU may still read them.
+		if (mNeedsDiscard || mHead + bytes > mCapacity)
+		{
+			mHead = 0;
+			mNeedsDiscard = false;
+			range.Mode = MapMode::Discard;
+			++mFrame.Discards;
+		}
+		else
+		{
+			range.Mode = MapMode::NoOverwrite;
+		}
+
+		range.Offset = mHead;
+		range.Size = bytes;
+		mCursor = mHead;
+		mMapEnd = mHead + bytes;
+		mHead = mMapEnd;
+		++mFrame.Maps;
+
+		return range;
+	}
+
+	uint32_t ConstantBufferRing::Allocate(uint32_t size)
+	{
+		const uint32_t offset = mCursor;
+		const uint32_t alignedSize = AlignedSize(size);
+		mCursor += alignedSize;
+
+		++mFrame.Allocations;
+		mFrame.BytesUploaded += size;
+		mFrame.PaddingBytes += alignedSize - size;
+
+		return offset;
+	}
+
+	void ConstantBufferRing::Unmap()
+	{
+		mCursor = mMapEnd;
+	}
+
+	void ConstantBufferRing::Reset()
+	{
+		mHead = 0;
+		mCursor = 0;
+		mMapEnd = 0;
+		mNeedsDiscard = true;
+	}
+
+	void ConstantBufferRing::EndFrame()
+	{
+		mFrame.Frames = 1;
+		mFrame.PeakFrameBytes = mFrame.BytesUploaded;
+		mFrame.PeakFrameMaps = mFrame.Maps;
+
+		mTotals.Frames += mFrame.Frames;
+		mTotals.Maps += mFrame.Maps;
+		mTotals.Discards += mFrame.Discards;
+		mTotals.Growths += mFrame.Growths;
+		mTotals.Allocations += mFrame.Allocations;
+		mTotals.BytesUploaded += mFrame.BytesUploaded;
+		mTotals.PaddingBytes += mFrame.PaddingBytes;
+		mTotals.PeakFrameBytes = max(mTotals.PeakFrameBytes, mFrame.PeakFrameBytes);
+		mTotals.PeakFrameMaps = max(mTotals.PeakFrameMaps, mFrame.PeakFrameMaps);
+
+		mLastFrame = mFrame;
+		mFrame = Counters();
+	}
+
+	const ConstantBufferRing::Counters& ConstantBufferRing::Totals() const
+	{
+		return mTotals;
+	}
+
+	const ConstantBufferRing::Counters& ConstantBufferRing::LastFrame() const
+	{
+		return mLastFrame;
+	}
+
+	void ConstantBufferRing::ResetCounters()
+	{
+		mTotals = Counters();
+		mFrame = Counters();
+		mLastFrame = Counters();
+	}
+}
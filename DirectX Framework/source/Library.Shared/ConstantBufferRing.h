@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+
+namespace DX
+{
+	class RenderCommandList;
+
+	// Sub-allocates per-draw constants from one large dynamic constant buffer. Each command list maps the buffer once for
+	// all of its constants: with no-overwrite while the list's constants fit after the ranges already handed out, or with
+	// discard (a fresh copy of the buffer from the driver) when they wrap around. Ranges are aligned to 256 bytes, the unit
+	// in which constant buffer offsets are bound. A list that needs more than half of the buffer grows it to hold two such
+	// lists, and the owner recreates the device buffer at the new capacity.
+	//
+	// Only the bookkeeping lives here; the owner does the mapping, copying and binding. This file only depends on the C++
+	// standard library.
+	class ConstantBufferRing final
+	{
+	public:
+		static const std::uint32_t Alignment = 256;
+		static const std::uint32_t DefaultCapacity = 64 * 1024;
+
+		enum class MapMode : std::uint8_t
+		{
+			Discard,
+			NoOverwrite
+		};
+
+		// Where a command list's constants go. Offset and Size are in bytes.
+		struct Range
+		{
+			std::uint32_t Offset;
+			std::uint32_t Size;
+			MapMode Mode;
+			bool Grew;						// The device buffer must be recreated at Capacity before mapping
+		};
+
+		struct Counters
+		{
+			std::uint64_t Frames;
+			std::uint64_t Maps;
+			std::uint64_t Discards;
+			std::uint64_t Growths;
+			std::uint64_t Allocations;
+			std::uint64_t BytesUploaded;	// Constants copied, before alignment
+			std::uint64_t PaddingBytes;		// Alignment padding between them
+			std::uint64_t PeakFrameBytes;	// The most bytes uploaded in one frame
+			std::uint64_t PeakFrameMaps;
+		};
+
+		explicit ConstantBufferRing(std::uint32_t capacity = DefaultCapacity);
+		ConstantBufferRing(const ConstantBufferRing&) = delete;
+		ConstantBufferRing& operator=(const ConstantBufferRing&) = delete;
+		ConstantBufferRing(ConstantBufferRing&&) = default;
+		ConstantBufferRing& operator=(ConstantBufferRing&&) = default;
+		~ConstantBufferRing() = default;
+
+		std::uint32_t Capacity() const;
+
+		static std::uint32_t AlignedSize(std::uint32_t size);
+
+		// The bytes a command list's SetConstants need, each rounded up to the alignment.
+		static std::uint32_t BytesNeeded(const RenderCommandList& commandList);
+
+		// Reserves bytes (a multiple of the alignment, at least one) for the allocations that follow, until Unmap.
+		Range Map(std::uint32_t bytes);
+
+		// Returns the offset of the next size bytes in the mapped range. The range must have room for them.
+		std::uint32_t Allocate(std::uint32_t size);
+
+		void Unmap();
+
+		// Forgets the buffer's contents, e.g. after the device buffer was recreated; the next map discards.
+		void Reset();
+
+		// Closes the frame's counts. Call once per frame, after its last map.
+		void EndFrame();
+
+		const Counters& Totals() const;
+		const Counters& LastFrame() const;
+		void ResetCounters();
+
+	private:
+		std::uint32_t mCapacity;
+		std::uint32_t mHead;				// Where the next map starts
+		std::uint32_t mCursor;				// Where the next allocation starts
+		std::uint32_t mMapEnd;
+		bool mNeedsDiscard;
+		Counters mTotals;
+		Counters mFrame;
+		Counters mLastFrame;
+	};
+}
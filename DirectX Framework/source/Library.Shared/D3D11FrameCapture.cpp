@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "D3D11FrameCapture.h"
+#include "DeviceResources.h"
+
+using namespace std;
+using namespace Microsoft::WRL;
+
+namespace DX
+{
+	namespace
+	{
+		ComPtr<ID3D11Texture2D> BackBufferTexture(const DeviceResources& deviceResources)
+		{
+			ComPtr<ID3D11Resource> resource;
+			deviceResources.GetBackBufferRenderTargetView()->GetResource(resource.GetAddressOf());
+
+			ComPtr<ID3D11Texture2D> texture;
+			ThrowIfFailed(resource.As(&texture));
+			return texture;
+		}
+	}
+
+	D3D11FrameCapture::D3D11FrameCapture(const shared_ptr<DeviceResources>& deviceResources, const string& path, FrameCapture::Format format, uint32_t framesPerSecond,
+		uint32_t slotCount, FrameCapture::QueuePolicy policy) :
+		mDeviceResources(deviceResources), mLayout(FrameCapture::PixelLayout::Bgra8), mCopiesFront(0), mCopiesCount(0)
+	{
+		D3D11_TEXTURE2D_DESC backBufferDesc;
+		BackBufferTexture(*mDeviceResources)->GetDesc(&backBufferDesc);
+		if (backBufferDesc.Format == DXGI_FORMAT_R8G8B8A8_UNORM || backBufferDesc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+		{
+			mLayout = FrameCapture::PixelLayout::Rgba8;
+		}
+
+		mCapture = make_unique<FrameCapture>(path, format, backBufferDesc.Width, backBufferDesc.Height, framesPerSecond, slotCount, policy);
+
+		CD3D11_TEXTURE2D_DESC stagingDesc(backBufferDesc.Format, backBufferDesc.Width, backBufferDesc.Height, 1, 1, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+		mStagingTextures.resize(mCapture->SlotCount());
+		for (auto& texture : mStagingTextures)
+		{
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateTexture2D(&stagingDesc, nullptr, texture.GetAddressOf()));
+		}
+
+		mMapped.assign(mStagingTextures.size(), 0);
+		mCopies.resize(mStagingTextures.size());
+	}
+
+	D3D11FrameCapture::~D3D11FrameCapture()
+	{
+		while (mCopiesCount > 0)
+		{
+			SubmitCopies(true);
+		}
+
+		mCapture->Flush();
+
+		ID3D11DeviceContext* context = mDeviceResources->GetD3DDeviceContext();
+		for (size_t slot = 0; slot < mStagingTextures.size(); ++slot)
+		{
+			if (mMapped[slot] != 0)
+			{
+				context->Unmap(mStagingTextures[slot].Get(), 0);
+			}
+		}
+	}
+
+	void D3D11FrameCapture::CaptureBackBuffer()
+	{
+		DX_PROFILE_ZONE("D3D11FrameCapture::CaptureBackBuffer");
+
+		// Copies older than this frame have usually landed. If every slot is still waiting on the GPU, the oldest is
+		// waited for so the encoder has a frame to give back.
+		SubmitCopies(mCopiesCount == mStagingTextures.size());
+
+		const ComPtr<ID3D11Texture2D> backBuffer = BackBufferTexture(*mDeviceResources);
+		D3D11_TEXTURE2D_DESC backBufferDesc;
+		backBuffer->GetDesc(&backBufferDesc);
+		if (backBufferDesc.Width != mCapture->Width() || backBufferDesc.Height != mCapture->Height())
+		{
+			return;
+		}
+
+		uint32_t slot;
+		if (!mCapture->Reserve(slot))
+		{
+			return;
+		}
+
+		ID3D11DeviceContext* context = mDeviceResources->GetD3DDeviceContext();
+		if (mMapped[slot] != 0)
+		{
+			context->Unmap(mStagingTextures[slot].Get(), 0);
+			mMapped[slot] = 0;
+		}
+
+		context->CopyResource(mStagingTextures[slot].Get(), backBuffer.Get());
+		mCopies[(mCopiesFront + mCopiesCount) % mCopies.size()] = slot;
+		++mCopiesCount;
+	}
+
+	FrameCapture::Counters D3D11FrameCapture::Totals() const
+	{
+		return mCapture->Totals();
+	}
+
+	void D3D11FrameCapture::SubmitCopies(bool wait)
+	{
+		ID3D11DeviceContext* context = mDeviceResources->GetD3DDeviceContext();
+		while (mCopiesCount > 0)
+		{
+			const uint32_t slot = mCopies[mCopiesFront];
+			D3D11_MAPPED_SUBRESOURCE mapped;
+			const HRESULT result = context->Map(mStagingTextures[slot].Get(), 0, D3D11_MAP_READ, (wait ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT), &mapped);
+			if (result == DXGI_ERROR_WAS_STILL_DRAWING)
+			{
+				break;
+			}
+
+			mCopiesFront = static_cast<uint32_t>((mCopiesFront + 1) % mCopies.size());
+			--mCopiesCount;
+			wait = false;
+
+			// A removed device can't give the copy back; the slot is released without a frame.
+			if (FAILED(result))
+			{
+				mCapture->Cancel(slot);
+				continue;
+			}
+
+			mMapped[slot] = 1;
+			mCapture->Submit(slot, static_cast<const uint8_t*>(mapped.pData), mapped.RowPitch, mLayout);
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "FrameCapture.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	class DeviceResources;
+
+	// Feeds the swap chain's back buffer to a FrameCapture. Each capture slot owns a staging texture: the back buffer is
+	// copied into it on the GPU, and on a later frame, once the copy has landed, the texture is mapped without waiting and
+	// its mapped pixels are handed to the encoder. A slot's texture is unmapped when the slot is next reused, so the render
+	// thread never reads the pixels itself. Frames drawn at a size other than the capture's (after a window resize) are
+	// skipped. Create and use it on the thread that owns the immediate context, and destroy it before the device is lost.
+	class D3D11FrameCapture final
+	{
+	public:
+		D3D11FrameCapture(const std::shared_ptr<DeviceResources>& deviceResources, const std::string& path, FrameCapture::Format format,
+			std::uint32_t framesPerSecond, std::uint32_t slotCount = FrameCapture::DefaultSlotCount,
+			FrameCapture::QueuePolicy policy = FrameCapture::QueuePolicy::DropNewest);
+		D3D11FrameCapture(const D3D11FrameCapture&) = delete;
+		D3D11FrameCapture& operator=(const D3D11FrameCapture&) = delete;
+		D3D11FrameCapture(D3D11FrameCapture&&) = delete;
+		D3D11FrameCapture& operator=(D3D11FrameCapture&&) = delete;
+
+		// Hands the copies still in flight to the encoder, waits for it and unmaps every staging texture.
+		~D3D11FrameCapture();
+
+		// Call once the frame is drawn, before Present.
+		void CaptureBackBuffer();
+
+		FrameCapture::Counters Totals() const;
+
+	private:
+		// Maps copies in submission order until one is still in flight on the GPU. With wait set, the oldest is waited for.
+		void SubmitCopies(bool wait);
+
+		std::shared_ptr<DeviceResources> mDeviceResources;
+		std::unique_ptr<FrameCapture> mCapture;
+		FrameCapture::PixelLayout mLayout;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> mStagingTextures;
+		std::vector<std::uint8_t> mMapped;
+		std::vector<std::uint32_t> mCopies;		// Ring of slots copied but not yet submitted, oldest first
+		std::uint32_t mCopiesFront;
+		std::uint32_t mCopiesCount;
+	};
+}
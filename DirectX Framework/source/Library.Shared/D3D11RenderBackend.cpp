@@ -0,0 +1,397 @@
+#include "pch.h"
+#include "D3D11RenderBackend.h"
+#include "DeviceResources.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace std;
+
+namespace DX
+{
+	D3D11RenderBackend::D3D11RenderBackend(const shared_ptr<DeviceResources>& deviceResources) :
+		mDeviceResources(deviceResources), mFeaturesChecked(false), mConstantBufferOffsetting(false),
+		mFrameVertices(0), mLastFrameVertices(0), mTotalVertices(0), mPeakFrameVertices(0)
+	{
+	}
+
+	PipelineHandle D3D11RenderBackend::CreatePipeline(const Pipeline& pipeline)
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		if (!mFreePipelines.empty())
+		{
+			const PipelineHandle handle = mFreePipelines.back();
+			mFreePipelines.pop_back();
+			mPipelines[handle] = pipeline;
+			return handle;
+		}
+
+		mPipelines.push_back(pipeline);
+		return static_cast<PipelineHandle>(mPipelines.size() - 1);
+	}
+
+	MeshHandle D3D11RenderBackend::CreateMesh(const Mesh& mesh)
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		if (!mFreeMeshes.empty())
+		{
+			const MeshHandle handle = mFreeMeshes.back();
+			mFreeMeshes.pop_back();
+			mMeshes[handle] = mesh;
+			return handle;
+		}
+
+		mMeshes.push_back(mesh);
+		return static_cast<MeshHandle>(mMeshes.size() - 1);
+	}
+
+	RenderTargetHandle D3D11RenderBackend::CreateRenderTarget(const RenderTarget& renderTarget)
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		if (!mFreeRenderTargets.empty())
+		{
+			const RenderTargetHandle handle = mFreeRenderTargets.back();
+			mFreeRenderTargets.pop_back();
+			mRenderTargets[handle] = renderTarget;
+			return handle;
+		}
+
+		mRenderTargets.push_back(renderTarget);
+		return static_cast<RenderTargetHandle>(mRenderTargets.size() - 1);
+	}
+
+	void D3D11RenderBackend::ReleasePipeline(PipelineHandle& pipeline)
+	{
+		if (pipeline == RenderCommandList::InvalidPipeline)
+		{
+			return;
+		}
+
+		lock_guard<mutex> lock(mMutex);
+		mPipelines[pipeline] = Pipeline();
+		mFreePipelines.push_back(pipeline);
+		pipeline = RenderCommandList::InvalidPipeline;
+	}
+
+	void D3D11RenderBackend::ReleaseMesh(MeshHandle& mesh)
+	{
+		if (mesh == RenderCommandList::InvalidMesh)
+		{
+			return;
+		}
+
+		lock_guard<mutex> lock(mMutex);
+		mMeshes[mesh] = Mesh();
+		mFreeMeshes.push_back(mesh);
+		mesh = RenderCommandList::InvalidMesh;
+	}
+
+	void D3D11RenderBackend::ReleaseRenderTarget(RenderTargetHandle& renderTarget)
+	{
+		if (renderTarget == RenderCommandList::BackBuffer)
+		{
+			return;
+		}
+
+		lock_guard<mutex> lock(mMutex);
+		mRenderTargets[renderTarget] = RenderTarget();
+		mFreeRenderTargets.push_back(renderTarget);
+		renderTarget = RenderCommandList::BackBuffer;
+	}
+
+	void D3D11RenderBackend::ReleaseDeviceDependentResources()
+	{
+		lock_guard<mutex> lock(mMutex);
+		mScissorState.Reset();
+		mConstantBuffer.Reset();
+		mConstantRing.Reset();
+		mFeaturesChecked = false;
+	}
+
+	void D3D11RenderBackend::Execute(const RenderCommandList& commandList)
+	{
+		DX_PROFILE_ZONE("D3D11RenderBackend::Execute");
+
+		lock_guard<mutex> lock(mMutex);
+
+		ID3D11DeviceContext3* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
+		const Pipeline* pipeline = nullptr;
+		const Mesh* mesh = nullptr;
+		ID3D11RenderTargetView* renderTargetView = mDeviceResources->GetBackBufferRenderTargetView();
+
+		const bool offsetConstants = UploadConstants(commandList);
+		mFrameVertices += commandList.VertexCount();
+		size_t constantIndex = 0;
+
+		const RenderCommand* commands = commandList.Commands();
+		for (size_t i = 0; i < commandList.CommandCount(); ++i)
+		{
+			const RenderCommand& command = commands[i];
+			switch (command.Type)
+			{
+			case RenderCommandType::SetPipeline:
+			{
+				pipeline = &mPipelines[command.Pipeline];
+				direct3DDeviceContext->IASetInputLayout(pipeline->InputLayout.Get());
+				direct3DDeviceContext->IASetPrimitiveTopology(pipeline->Topology);
+
+				direct3DDeviceContext->VSSetShader(pipeline->VertexShader.Get(), nullptr, 0);
+				direct3DDeviceContext->PSSetShader(pipeline->PixelShader.Get(), nullptr, 0);
+				direct3DDeviceContext->OMSetBlendState(pipeline->BlendState.Get(), nullptr, 0xFFFFFFFF);
+
+				if (!offsetConstants)
+				{
+					direct3DDeviceContext->VSSetConstantBuffers(0, 1, pipeline->VertexConstantBuffer.GetAddressOf());
+					direct3DDeviceContext->PSSetConstantBuffers(0, 1, pipeline->PixelConstantBuffer.GetAddressOf());
+				}
+				break;
+			}
+
+			case RenderCommandType::SetMesh:
+			{
+				mesh = &mMeshes[command.Mesh];
+				ID3D11Buffer* const vertexBuffers[] = { mesh->VertexBuffer.Get(), mesh->InstanceBuffer.Get() };
+				const UINT strides[] = { mesh->Stride, mesh->InstanceStride };
+				static const UINT offsets[] = { 0, 0 };
+				direct3DDeviceContext->IASetVertexBuffers(0, (mesh->InstanceBuffer != nullptr ? 2 : 1), vertexBuffers, strides, offsets);
+				break;
+			}
+
+			case RenderCommandType::SetConstants:
+			{
+				if (offsetConstants)
+				{
+					// Offsets and sizes are bound in 16-byte constants.
+					const UINT firstConstant = mConstantOffsets[constantIndex++] / 16;
+					const UINT constantCount = ConstantBufferRing::AlignedSize(command.DataSize) / 16;
+					if (command.Stage == ShaderStage::Vertex)
+					{
+						direct3DDeviceContext->VSSetConstantBuffers1(0, 1, mConstantBuffer.GetAddressOf(), &firstConstant, &constantCount);
+					}
+					else
+					{
+						direct3DDeviceContext->PSSetConstantBuffers1(0, 1, mConstantBuffer.GetAddressOf(), &firstConstant, &constantCount);
+					}
+					break;
+				}
+
+				ID3D11Buffer* constantBuffer = (command.Stage == ShaderStage::Vertex ? pipeline->VertexConstantBuffer.Get() : pipeline->PixelConstantBuffer.Get());
+				direct3DDeviceContext->UpdateSubresource(constantBuffer, 0, nullptr, commandList.Data(command), 0, 0);
+				break;
+			}
+
+			case RenderCommandType::UpdateInstances:
+			{
+				ID3D11Buffer* instanceBuffer = mesh->InstanceBuffer.Get();
+				D3D11_BUFFER_DESC instanceBufferDesc;
+				instanceBuffer->GetDesc(&instanceBufferDesc);
+
+				D3D11_MAPPED_SUBRESOURCE mappedInstances;
+				ThrowIfFailed(direct3DDeviceContext->Map(instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedInstances));
+				const UINT size = (command.DataSize < instanceBufferDesc.ByteWidth ? command.DataSize : instanceBufferDesc.ByteWidth);
+				memcpy(mappedInstances.pData, commandList.Data(command), size);
+				direct3DDeviceContext->Unmap(instanceBuffer, 0);
+				break;
+			}
+
+			case RenderCommandType::Draw:
+				direct3DDeviceContext->Draw(command.VertexCount, command.StartVertex);
+				break;
+
+			case RenderCommandType::DrawInstanced:
+				direct3DDeviceContext->DrawInstanced(command.VertexCount, command.InstanceCount, command.StartVertex, 0);
+				break;
+
+			case RenderCommandType::SetRenderTarget:
+			{
+				// A texture still bound for reading would be unbound by the runtime, with a warning from the debug layer.
+				ID3D11ShaderResourceView* const noTexture = nullptr;
+				direct3DDeviceContext->PSSetShaderResources(0, 1, &noTexture);
+
+				if (command.Target == RenderCommandList::BackBuffer)
+				{
+					renderTargetView = mDeviceResources->GetBackBufferRenderTargetView();
+					direct3DDeviceContext->OMSetRenderTargets(1, &renderTargetView, mDeviceResources->GetDepthStencilView());
+					const D3D11_VIEWPORT viewport = mDeviceResources->GetScreenViewport();
+					direct3DDeviceContext->RSSetViewports(1, &viewport);
+				}
+				else
+				{
+					const RenderTarget& renderTarget = mRenderTargets[command.Target];
+					renderTargetView = renderTarget.RenderTargetView.Get();
+					direct3DDeviceContext->OMSetRenderTargets(1, &renderTargetView, nullptr);
+					const CD3D11_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(renderTarget.Width), static_cast<float>(renderTarget.Height));
+					direct3DDeviceContext->RSSetViewports(1, &viewport);
+				}
+				break;
+			}
+
+			case RenderCommandType::ClearRenderTarget:
+			{
+				const float* color = reinterpret_cast<const float*>(commandList.Data(command));
+				if (command.DataSize > sizeof(float) * 4)
+				{
+					const PixelRect& rect = *reinterpret_cast<const PixelRect*>(commandList.Data(command) + sizeof(float) * 4);
+					const D3D11_RECT clearRect = { static_cast<LONG>(rect.Left), static_cast<LONG>(rect.Top), static_cast<LONG>(rect.Right), static_cast<LONG>(rect.Bottom) };
+					direct3DDeviceContext->ClearView(renderTargetView, color, &clearRect, 1);
+				}
+				else
+				{
+					direct3DDeviceContext->ClearRenderTargetView(renderTargetView, color);
+				}
+				break;
+			}
+
+			case RenderCommandType::SetScissor:
+			{
+				if (command.DataSize == 0)
+				{
+					direct3DDeviceContext->RSSetState(nullptr);
+					break;
+				}
+
+				if (mScissorState == nullptr)
+				{
+					CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
+					rasterizerDesc.ScissorEnable = TRUE;
+					ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateRasterizerState(&rasterizerDesc, mScissorState.ReleaseAndGetAddressOf()));
+				}
+
+				const PixelRect& rect = *reinterpret_cast<const PixelRect*>(commandList.Data(command));
+				const D3D11_RECT scissorRect = { static_cast<LONG>(rect.Left), static_cast<LONG>(rect.Top), static_cast<LONG>(rect.Right), static_cast<LONG>(rect.Bottom) };
+				direct3DDeviceContext->RSSetState(mScissorState.Get());
+				direct3DDeviceContext->RSSetScissorRects(1, &scissorRect);
+				break;
+			}
+
+			case RenderCommandType::SetTexture:
+				direct3DDeviceContext->PSSetShaderResources(0, 1, mRenderTargets[command.Target].ShaderResourceView.GetAddressOf());
+				break;
+			}
+		}
+	}
+
+	void D3D11RenderBackend::EndFrame()
+	{
+		lock_guard<mutex> lock(mMutex);
+		mConstantRing.EndFrame();
+
+		mLastFrameVertices = mFrameVertices;
+		mTotalVertices += mFrameVertices;
+		mPeakFrameVertices = max(mPeakFrameVertices, mFrameVertices);
+		mFrameVertices = 0;
+	}
+
+	ConstantBufferRing::Counters D3D11RenderBackend::ConstantBufferTotals() const
+	{
+		lock_guard<mutex> lock(mMutex);
+		return mConstantRing.Totals();
+	}
+
+	ConstantBufferRing::Counters D3D11RenderBackend::ConstantBufferLastFrame() const
+	{
+		lock_guard<mutex> lock(mMutex);
+		return mConstantRing.LastFrame();
+	}
+
+	uint64_t D3D11RenderBackend::LastFrameVertexCount() const
+	{
+		lock_guard<mutex> lock(mMutex);
+		return mLastFrameVertices;
+	}
+
+	bool D3D11RenderBackend::WriteReport(const wstring& filename) const
+	{
+		ofstream stream(filename, ios::out | ios::trunc);
+		if (!stream.good())
+		{
+			return false;
+		}
+
+		lock_guard<mutex> lock(mMutex);
+		const ConstantBufferRing::Counters& totals = mConstantRing.Totals();
+		const double frames = static_cast<double>(totals.Frames > 0 ? totals.Frames : 1);
+		stream.precision(3);
+		stream << fixed;
+		stream << "constant_buffer_offsetting\t" << (mConstantBufferOffsetting ? 1 : 0) << '\n';
+		stream << "constant_buffer_capacity\t" << mConstantRing.Capacity() << '\n';
+		stream << "frames\t" << totals.Frames << '\n';
+		stream << "maps\t" << totals.Maps << '\n';
+		stream << "discards\t" << totals.Discards << '\n';
+		stream << "growths\t" << totals.Growths << '\n';
+		stream << "allocations\t" << totals.Allocations << '\n';
+		stream << "bytes_uploaded\t" << totals.BytesUploaded << '\n';
+		stream << "padding_bytes\t" << totals.PaddingBytes << '\n';
+		stream << "maps_per_frame\t" << (totals.Maps / frames) << '\n';
+		stream << "bytes_per_frame\t" << (totals.BytesUploaded / frames) << '\n';
+		stream << "peak_frame_maps\t" << totals.PeakFrameMaps << '\n';
+		stream << "peak_frame_bytes\t" << totals.PeakFrameBytes << '\n';
+		stream << "vertices\t" << mTotalVertices << '\n';
+		stream << "vertices_per_frame\t" << (mTotalVertices / frames) << '\n';
+		stream << "last_frame_vertices\t" << mLastFrameVertices << '\n';
+		stream << "peak_frame_vertices\t" << mPeakFrameVertices << '\n';
+
+		return stream.good();
+	}
+
+	bool D3D11RenderBackend::UploadConstants(const RenderCommandList& commandList)
+	{
+		if (!mFeaturesChecked)
+		{
+			D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+			mConstantBufferOffsetting = SUCCEEDED(mDeviceResources->GetD3DDevice()->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+				options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+			mFeaturesChecked = true;
+		}
+
+		if (!mConstantBufferOffsetting)
+		{
+			return false;
+		}
+
+		mConstantOffsets.clear();
+		const uint32_t bytes = ConstantBufferRing::BytesNeeded(commandList);
+		if (bytes == 0)
+		{
+			return true;
+		}
+
+		if (mConstantBuffer == nullptr)
+		{
+			mConstantRing.Reset();
+		}
+
+		const ConstantBufferRing::Range range = mConstantRing.Map(bytes);
+		if (range.Grew || mConstantBuffer == nullptr)
+		{
+			const CD3D11_BUFFER_DESC constantBufferDesc(mConstantRing.Capacity(), D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&constantBufferDesc, nullptr, mConstantBuffer.ReleaseAndGetAddressOf()));
+		}
+
+		ID3D11DeviceContext3* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
+		D3D11_MAPPED_SUBRESOURCE mappedConstants;
+		const D3D11_MAP mapType = (range.Mode == ConstantBufferRing::MapMode::Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE);
+		ThrowIfFailed(direct3DDeviceContext->Map(mConstantBuffer.Get(), 0, mapType, 0, &mappedConstants));
+
+		// The buffer can't be bound for drawing while it is mapped, so every constant is copied before the first draw.
+		uint8_t* destination = static_cast<uint8_t*>(mappedConstants.pData);
+		const RenderCommand* commands = commandList.Commands();
+		for (size_t i = 0; i < commandList.CommandCount(); ++i)
+		{
+			const RenderCommand& command = commands[i];
+			if (command.Type == RenderCommandType::SetConstants)
+			{
+				const uint32_t offset = mConstantRing.Allocate(command.DataSize);
+				memcpy(destination + offset, commandList.Data(command), command.DataSize);
+				mConstantOffsets.push_back(offset);
+			}
+		}
+
+		direct3DDeviceContext->Unmap(mConstantBuffer.Get(), 0);
+		mConstantRing.Unmap();
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "ConstantBufferRing.h"
+#include "RenderBackend.h"
+#include "RenderCommandList.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	class DeviceResources;
+
+	// Executes command lists on the device's immediate context. Components register the D3D11 objects they create and
+	// record draws against the returned handles. Registration may happen on the loader threads while the render thread
+	// executes, so both are serialized.
+	//
+	// On devices that can bind constant buffers at an offset (Direct3D 11.1), per-draw constants are not written to the
+	// pipelines' own buffers. Each list's constants are copied into one shared dynamic buffer with a single map, and every
+	// SetConstants binds its slice of it. Other devices fall back to updating the pipeline's buffer for each SetConstants.
+	class D3D11RenderBackend final : public RenderBackend
+	{
+	public:
+		struct Pipeline
+		{
+			Microsoft::WRL::ComPtr<ID3D11VertexShader> VertexShader;
+			Microsoft::WRL::ComPtr<ID3D11PixelShader> PixelShader;
+			Microsoft::WRL::ComPtr<ID3D11InputLayout> InputLayout;
+			D3D11_PRIMITIVE_TOPOLOGY Topology;
+			Microsoft::WRL::ComPtr<ID3D11Buffer> VertexConstantBuffer;	// Bound to slot 0; target of Vertex SetConstants without offsetting
+			Microsoft::WRL::ComPtr<ID3D11Buffer> PixelConstantBuffer;	// Bound to slot 0; target of Pixel SetConstants without offsetting
+			Microsoft::WRL::ComPtr<ID3D11BlendState> BlendState;		// Optional; without one the pipeline draws opaque
+		};
+
+		struct Mesh
+		{
+			Microsoft::WRL::ComPtr<ID3D11Buffer> VertexBuffer;
+			UINT Stride;
+			Microsoft::WRL::ComPtr<ID3D11Buffer> InstanceBuffer;		// Optional; bound to slot 1. Must be dynamic with CPU write access.
+			UINT InstanceStride;
+		};
+
+		// An offscreen target and a view of the same texture for reading it back in a later pass.
+		struct RenderTarget
+		{
+			Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RenderTargetView;
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ShaderResourceView;
+			UINT Width;
+			UINT Height;
+		};
+
+		explicit D3D11RenderBackend(const std::shared_ptr<DeviceResources>& deviceResources);
+		D3D11RenderBackend(const D3D11RenderBackend&) = delete;
+		D3D11RenderBackend& operator=(const D3D11RenderBackend&) = delete;
+		D3D11RenderBackend(D3D11RenderBackend&&) = delete;
+		D3D11RenderBackend& operator=(D3D11RenderBackend&&) = delete;
+		~D3D11RenderBackend() = default;
+
+		PipelineHandle CreatePipeline(const Pipeline& pipeline);
+		MeshHandle CreateMesh(const Mesh& mesh);
+		RenderTargetHandle CreateRenderTarget(const RenderTarget& renderTarget);
+
+		// Drops the backend's references and resets the handle to invalid (BackBuffer for render targets). Released slots
+		// are reused.
+		void ReleasePipeline(PipelineHandle& pipeline);
+		void ReleaseMesh(MeshHandle& mesh);
+		void ReleaseRenderTarget(RenderTargetHandle& renderTarget);
+
+		// Drops the state objects the backend creates for itself; they are recreated on first use.
+		void ReleaseDeviceDependentResources();
+
+		// Constants must be set after SetPipeline and before the draws that read them.
+		virtual void Execute(const RenderCommandList& commandList) override;
+
+		// Closes the frame's constant buffer and vertex counts. Call once per frame, after the last Execute.
+		void EndFrame();
+
+		ConstantBufferRing::Counters ConstantBufferTotals() const;
+		ConstantBufferRing::Counters ConstantBufferLastFrame() const;
+
+		// Vertices drawn in the last frame, each instance's counted.
+		std::uint64_t LastFrameVertexCount() const;
+		bool WriteReport(const std::wstring& filename) const;
+
+	private:
+		// Copies the list's constants into the shared buffer, recording where each went. Returns false if the device
+		// can't bind constant buffers at an offset.
+		bool UploadConstants(const RenderCommandList& commandList);
+		std::shared_ptr<DeviceResources> mDeviceResources;
+		std::vector<Pipeline> mPipelines;
+		std::vector<Mesh> mMeshes;
+		std::vector<PipelineHandle> mFreePipelines;
+		std::vector<MeshHandle> mFreeMeshes;
+		std::vector<RenderTarget> mRenderTargets;
+		std::vector<RenderTargetHandle> mFreeRenderTargets;
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState> mScissorState;
+		ConstantBufferRing mConstantRing;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mConstantBuffer;
+		std::vector<std::uint32_t> mConstantOffsets;	// Per SetConstants of the list being executed, in bytes
+		bool mFeaturesChecked;
+		bool mConstantBufferOffsetting;
+		std::uint64_t mFrameVertices;			// Since the last EndFrame
+		std::uint64_t mLastFrameVertices;
+		std::uint64_t mTotalVertices;
+		std::uint64_t mPeakFrameVertices;
+		mutable std::mutex mMutex;
+	};
+}
@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "D3D11SpriteBatchTarget.h"
+#include "DeviceResources.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+namespace DX
+{
+	const D3D11_INPUT_ELEMENT_DESC D3D11SpriteBatchTarget::InputElements[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "TEXCOORD", 2, DXGI_FORMAT_R32G32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "TEXCOORD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "TEXCOORD", 4, DXGI_FORMAT_R32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	};
+
+	D3D11SpriteBatchTarget::D3D11SpriteBatchTarget(const shared_ptr<DeviceResources>& deviceResources, uint32_t instanceCapacity) :
+		mDeviceResources(deviceResources), mInstanceCapacity(instanceCapacity), mWriteOffset(instanceCapacity), mBoundTexture(NoTexture)
+	{
+	}
+
+	void D3D11SpriteBatchTarget::CreateDeviceDependentResources()
+	{
+		// A triangle strip over the unit quad.
+		const VertexPositionTexture vertices[] =
+		{
+			VertexPositionTexture(XMFLOAT4(-1.0f, -1.0f, 0.0f, 1.0f), XMFLOAT2(0.0f, 1.0f)),
+			VertexPositionTexture(XMFLOAT4(-1.0f, 1.0f, 0.0f, 1.0f), XMFLOAT2(0.0f, 0.0f)),
+			VertexPositionTexture(XMFLOAT4(1.0f, -1.0f, 0.0f, 1.0f), XMFLOAT2(1.0f, 1.0f)),
+			VertexPositionTexture(XMFLOAT4(1.0f, 1.0f, 0.0f, 1.0f), XMFLOAT2(1.0f, 0.0f)),
+		};
+
+		D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
+		vertexBufferDesc.ByteWidth = sizeof(VertexPositionTexture) * ARRAYSIZE(vertices);
+		vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA vertexSubResourceData = { 0 };
+		vertexSubResourceData.pSysMem = vertices;
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&vertexBufferDesc, &vertexSubResourceData, mQuadVertexBuffer.ReleaseAndGetAddressOf()));
+
+		CD3D11_BUFFER_DESC instanceBufferDesc(sizeof(SpriteInstance) * mInstanceCapacity, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&instanceBufferDesc, nullptr, mInstanceBuffer.ReleaseAndGetAddressOf()));
+
+		// Start out full so the first Map discards.
+		mWriteOffset = mInstanceCapacity;
+	}
+
+	void D3D11SpriteBatchTarget::ReleaseDeviceDependentResources()
+	{
+		mQuadVertexBuffer.Reset();
+		mInstanceBuffer.Reset();
+		mTextures.clear();
+	}
+
+	SpriteTextureHandle D3D11SpriteBatchTarget::AddTexture(const ComPtr<ID3D11ShaderResourceView>& texture)
+	{
+		mTextures.push_back(texture);
+		return static_cast<SpriteTextureHandle>(mTextures.size() - 1);
+	}
+
+	void D3D11SpriteBatchTarget::ClearTextures()
+	{
+		mTextures.clear();
+	}
+
+	void D3D11SpriteBatchTarget::Bind()
+	{
+		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
+		direct3DDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+		ID3D11Buffer* const vertexBuffers[] = { mQuadVertexBuffer.Get(), mInstanceBuffer.Get() };
+		static const UINT strides[] = { sizeof(VertexPositionTexture), sizeof(SpriteInstance) };
+		static const UINT offsets[] = { 0, 0 };
+		direct3DDeviceContext->IASetVertexBuffers(0, ARRAYSIZE(vertexBuffers), vertexBuffers, strides, offsets);
+
+		mBoundTexture = NoTexture;
+	}
+
+	SpriteInstance* D3D11SpriteBatchTarget::Map(uint32_t& capacity, uint32_t& firstInstance)
+	{
+		// Instances before the write offset may still be in use by the GPU, so they are only overwritten after a discard.
+		D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+		if (mWriteOffset >= mInstanceCapacity)
+		{
+			mapType = D3D11_MAP_WRITE_DISCARD;
+			mWriteOffset = 0;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mappedInstances;
+		ThrowIfFailed(mDeviceResources->GetD3DDeviceContext()->Map(mInstanceBuffer.Get(), 0, mapType, 0, &mappedInstances));
+
+		capacity = mInstanceCapacity - mWriteOffset;
+		firstInstance = mWriteOffset;
+		return reinterpret_cast<SpriteInstance*>(mappedInstances.pData) + mWriteOffset;
+	}
+
+	void D3D11SpriteBatchTarget::Unmap(uint32_t instanceCount)
+	{
+		mDeviceResources->GetD3DDeviceContext()->Unmap(mInstanceBuffer.Get(), 0);
+		mWriteOffset += instanceCount;
+	}
+
+	void D3D11SpriteBatchTarget::DrawBatch(SpriteTextureHandle texture, uint32_t firstInstance, uint32_t instanceCount)
+	{
+		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
+
+		if (texture != mBoundTexture)
+		{
+			direct3DDeviceContext->PSSetShaderResources(0, 1, mTextures[texture].GetAddressOf());
+			mBoundTexture = texture;
+		}
+
+		direct3DDeviceContext->DrawInstanced(4, instanceCount, 0, firstInstance);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "SpriteBatch.h"
+#include <memory>
+#include <vector>
+
+namespace DX
+{
+	class DeviceResources;
+
+	// Feeds a SpriteBatch from a dynamic instance buffer used as a ring: each Map appends after the instances already
+	// written this frame without waiting on the GPU, and the buffer is only discarded once it wraps. The unit quad is bound
+	// to slot 0 and the instances to slot 1; callers bind the shaders, input layout, sampler, blend state and constants.
+	class D3D11SpriteBatchTarget final : public SpriteBatchTarget
+	{
+	public:
+		static const std::uint32_t DefaultInstanceCapacity = 64 * 1024;
+
+		// The quad's VertexPositionTexture elements followed by the SpriteInstance elements.
+		static const int InputElementCount = 6;
+		static const D3D11_INPUT_ELEMENT_DESC InputElements[InputElementCount];
+
+		explicit D3D11SpriteBatchTarget(const std::shared_ptr<DeviceResources>& deviceResources, std::uint32_t instanceCapacity = DefaultInstanceCapacity);
+		D3D11SpriteBatchTarget(const D3D11SpriteBatchTarget&) = delete;
+		D3D11SpriteBatchTarget& operator=(const D3D11SpriteBatchTarget&) = delete;
+		D3D11SpriteBatchTarget(D3D11SpriteBatchTarget&&) = delete;
+		D3D11SpriteBatchTarget& operator=(D3D11SpriteBatchTarget&&) = delete;
+		~D3D11SpriteBatchTarget() = default;
+
+		void CreateDeviceDependentResources();
+		void ReleaseDeviceDependentResources();
+
+		SpriteTextureHandle AddTexture(const Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& texture);
+		void ClearTextures();
+
+		// Binds the quad and instance buffers and the primitive topology. Call before SpriteBatch::Begin.
+		void Bind();
+
+		virtual SpriteInstance* Map(std::uint32_t& capacity, std::uint32_t& firstInstance) override;
+		virtual void Unmap(std::uint32_t instanceCount) override;
+		virtual void DrawBatch(SpriteTextureHandle texture, std::uint32_t firstInstance, std::uint32_t instanceCount) override;
+
+	private:
+		static const SpriteTextureHandle NoTexture = 0xFFFFFFFF;
+
+		std::shared_ptr<DeviceResources> mDeviceResources;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mQuadVertexBuffer;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mInstanceBuffer;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> mTextures;
+		std::uint32_t mInstanceCapacity;
+		std::uint32_t mWriteOffset;
+		SpriteTextureHandle mBoundTexture;
+	};
+}
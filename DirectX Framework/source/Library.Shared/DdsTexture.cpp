@@ -0,0 +1,242 @@
+#include "DdsTexture.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		const uint32_t Magic = 0x20534444;			// "DDS "
+		const uint32_t FourCCDX10 = 0x30315844;		// "DX10"
+		const uint32_t FourCCDXT1 = 0x31545844;		// "DXT1"
+		const uint32_t FourCCDXT5 = 0x35545844;		// "DXT5"
+
+		const uint32_t HeaderCaps = 0x1;
+		const uint32_t HeaderHeight = 0x2;
+		const uint32_t HeaderWidth = 0x4;
+		const uint32_t HeaderPitch = 0x8;
+		const uint32_t HeaderPixelFormat = 0x1000;
+		const uint32_t HeaderMipMapCount = 0x20000;
+		const uint32_t HeaderLinearSize = 0x80000;
+		const uint32_t PixelFormatFourCC = 0x4;
+		const uint32_t PixelFormatRgb = 0x40;
+		const uint32_t CapsComplex = 0x8;
+		const uint32_t CapsTexture = 0x1000;
+		const uint32_t CapsMipMap = 0x400000;
+		const uint32_t ResourceDimensionTexture2D = 3;
+
+		struct PixelFormat
+		{
+			uint32_t Size;
+			uint32_t Flags;
+			uint32_t FourCC;
+			uint32_t RgbBitCount;
+			uint32_t RBitMask;
+			uint32_t GBitMask;
+			uint32_t BBitMask;
+			uint32_t ABitMask;
+		};
+
+		struct Header
+		{
+			uint32_t Size;
+			uint32_t Flags;
+			uint32_t Height;
+			uint32_t Width;
+			uint32_t PitchOrLinearSize;
+			uint32_t Depth;
+			uint32_t MipMapCount;
+			uint32_t Reserved1[11];
+			PixelFormat Format;
+			uint32_t Caps;
+			uint32_t Caps2;
+			uint32_t Caps3;
+			uint32_t Caps4;
+			uint32_t Reserved2;
+		};
+
+		struct HeaderDX10
+		{
+			uint32_t DxgiFormat;
+			uint32_t ResourceDimension;
+			uint32_t MiscFlag;
+			uint32_t ArraySize;
+			uint32_t MiscFlags2;
+		};
+
+		static_assert(sizeof(PixelFormat) == 32 && sizeof(Header) == 124 && sizeof(HeaderDX10) == 20, "DDS headers are part of the file format");
+
+		bool Supported(uint32_t format)
+		{
+			switch (format)
+			{
+			case DdsTexture::R8G8B8A8UNorm:
+			case DdsTexture::R8G8B8A8UNormSrgb:
+			case DdsTexture::BC1UNorm:
+			case DdsTexture::BC1UNormSrgb:
+			case DdsTexture::BC3UNorm:
+			case DdsTexture::BC3UNormSrgb:
+				return true;
+
+			default:
+				return false;
+			}
+		}
+	}
+
+	bool DdsTexture::Parse(const uint8_t* data, size_t size, Description& description)
+	{
+		uint32_t magic;
+		Header header;
+		if (size < sizeof(magic) + sizeof(header))
+		{
+			return false;
+		}
+
+		memcpy(&magic, data, sizeof(magic));
+		memcpy(&header, data + sizeof(magic), sizeof(header));
+		if (magic != Magic || header.Size != sizeof(Header) || header.Format.Size != sizeof(PixelFormat) || header.Width == 0 || header.Height == 0)
+		{
+			return false;
+		}
+
+		size_t offset = sizeof(magic) + sizeof(header);
+		uint32_t format = 0;
+		if ((header.Format.Flags & PixelFormatFourCC) != 0 && header.Format.FourCC == FourCCDX10)
+		{
+			HeaderDX10 headerDX10;
+			if (size < offset + sizeof(headerDX10))
+			{
+				return false;
+			}
+
+			memcpy(&headerDX10, data + offset, sizeof(headerDX10));
+			offset += sizeof(headerDX10);
+			if (headerDX10.ResourceDimension != ResourceDimensionTexture2D || headerDX10.ArraySize != 1)
+			{
+				return false;
+			}
+
+			format = headerDX10.DxgiFormat;
+		}
+		else if ((header.Format.Flags & PixelFormatFourCC) != 0)
+		{
+			format = (header.Format.FourCC == FourCCDXT1 ? static_cast<uint32_t>(BC1UNorm) : (header.Format.FourCC == FourCCDXT5 ? static_cast<uint32_t>(BC3UNorm) : 0));
+		}
+		else if ((header.Format.Flags & PixelFormatRgb) != 0 && header.Format.RgbBitCount == 32 && header.Format.RBitMask == 0x000000FF &&
+			header.Format.GBitMask == 0x0000FF00 && header.Format.BBitMask == 0x00FF0000)
+		{
+			format = R8G8B8A8UNorm;
+		}
+
+		if (!Supported(format))
+		{
+			return false;
+		}
+
+		// A full chain of a w x h texture has floor(log2(max(w, h))) + 1 levels; a missing count means one level.
+		uint32_t fullChain = 1;
+		while ((max(header.Width, header.Height) >> fullChain) != 0)
+		{
+			++fullChain;
+		}
+
+		const uint32_t mipCount = ((header.Flags & HeaderMipMapCount) != 0 && header.MipMapCount > 0 ? header.MipMapCount : 1);
+		if (mipCount > fullChain)
+		{
+			return false;
+		}
+
+		description.Format = format;
+		description.Width = header.Width;
+		description.Height = header.Height;
+		description.Mips.clear();
+		for (uint32_t mip = 0; mip < mipCount; ++mip)
+		{
+			MipLevel level = Level(format, max(header.Width >> mip, 1u), max(header.Height >> mip, 1u));
+			level.Offset = offset;
+			if (size - offset < level.SlicePitch)
+			{
+				return false;
+			}
+
+			offset += level.SlicePitch;
+			description.Mips.push_back(level);
+		}
+
+		return true;
+	}
+
+	vector<uint8_t> DdsTexture::Serialize(uint32_t format, uint32_t width, uint32_t height, const vector<vector<uint8_t>>& mips)
+	{
+		const MipLevel top = Level(format, width, height);
+
+		Header header = {};
+		header.Size = sizeof(Header);
+		header.Flags = HeaderCaps | HeaderHeight | HeaderWidth | HeaderPixelFormat | HeaderMipMapCount | (BlockCompressed(format) ? HeaderLinearSize : HeaderPitch);
+		header.Height = height;
+		header.Width = width;
+		header.PitchOrLinearSize = (BlockCompressed(format) ? top.SlicePitch : top.RowPitch);
+		header.Depth = 1;
+		header.MipMapCount = static_cast<uint32_t>(mips.size());
+		header.Format.Size = sizeof(PixelFormat);
+		header.Format.Flags = PixelFormatFourCC;
+		header.Format.FourCC = FourCCDX10;
+		header.Caps = CapsTexture | (mips.size() > 1 ? CapsComplex | CapsMipMap : 0);
+
+		HeaderDX10 headerDX10 = {};
+		headerDX10.DxgiFormat = format;
+		headerDX10.ResourceDimension = ResourceDimensionTexture2D;
+		headerDX10.ArraySize = 1;
+
+		size_t size = sizeof(Magic) + sizeof(header) + sizeof(headerDX10);
+		for (const vector<uint8_t>& mip : mips)
+		{
+			size += mip.size();
+		}
+
+		vector<uint8_t> file(size);
+		uint8_t* destination = file.data();
+		memcpy(destination, &Magic, sizeof(Magic));
+		destination += sizeof(Magic);
+		memcpy(destination, &header, sizeof(header));
+		destination += sizeof(header);
+		memcpy(destination, &headerDX10, sizeof(headerDX10));
+		destination += sizeof(headerDX10);
+		for (const vector<uint8_t>& mip : mips)
+		{
+			if (!mip.empty())
+			{
+				memcpy(destination, mip.data(), mip.size());
+				destination += mip.size();
+			}
+		}
+
+		return file;
+	}
+
+	bool DdsTexture::BlockCompressed(uint32_t format)
+	{
+		return (format == BC1UNorm || format == BC1UNormSrgb || format == BC3UNorm || format == BC3UNormSrgb);
+	}
+
+	DdsTexture::MipLevel DdsTexture::Level(uint32_t format, uint32_t width, uint32_t height)
+	{
+		MipLevel level = { width, height, 0, 0, 0 };
+		if (BlockCompressed(format))
+		{
+			const uint32_t blockBytes = (format == BC1UNorm || format == BC1UNormSrgb ? 8 : 16);
+			level.RowPitch = ((width + 3) / 4) * blockBytes;
+			level.SlicePitch = level.RowPitch * ((height + 3) / 4);
+		}
+		else
+		{
+			level.RowPitch = width * 4;
+			level.SlicePitch = level.RowPitch * height;
+		}
+
+		return level;
+	}
+}
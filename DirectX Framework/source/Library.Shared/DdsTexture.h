@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Reads and writes DDS files holding one 2D texture and its mip chain, in R8G8B8A8, BC1 or BC3. Parse only locates the
+	// levels in the file's bytes, so a loaded or mapped DDS file goes to CreateTexture2D as is: loading a texture is a read
+	// and the driver's copy, with no decoding. Serialize always writes the DX10 header extension; Parse also reads the
+	// legacy DXT1 and DXT5 headers. This file only depends on the C++ standard library.
+	class DdsTexture final
+	{
+	public:
+		// DXGI_FORMAT values.
+		enum Format : std::uint32_t
+		{
+			R8G8B8A8UNorm = 28,
+			R8G8B8A8UNormSrgb = 29,
+			BC1UNorm = 71,
+			BC1UNormSrgb = 72,
+			BC3UNorm = 77,
+			BC3UNormSrgb = 78
+		};
+
+		struct MipLevel
+		{
+			std::uint32_t Width;
+			std::uint32_t Height;
+			std::uint32_t RowPitch;		// Bytes per row of pixels, or of 4 x 4 blocks
+			std::uint32_t SlicePitch;	// Bytes in the level
+			std::size_t Offset;			// From the start of the file
+		};
+
+		struct Description
+		{
+			std::uint32_t Format;
+			std::uint32_t Width;
+			std::uint32_t Height;
+			std::vector<MipLevel> Mips;
+		};
+
+		// Returns false if data isn't a 2D DDS texture in a supported format, or is shorter than its mip chain.
+		static bool Parse(const std::uint8_t* data, std::size_t size, Description& description);
+
+		// Writes a DDS file from levels laid out as Parse reports them: rows of pixels or blocks, tightly packed, largest
+		// level first.
+		static std::vector<std::uint8_t> Serialize(std::uint32_t format, std::uint32_t width, std::uint32_t height, const std::vector<std::vector<std::uint8_t>>& mips);
+
+		static bool BlockCompressed(std::uint32_t format);
+		static MipLevel Level(std::uint32_t format, std::uint32_t width, std::uint32_t height);
+
+		DdsTexture() = delete;
+		DdsTexture(const DdsTexture&) = delete;
+		DdsTexture(DdsTexture&&) = delete;
+		DdsTexture& operator=(const DdsTexture&) = delete;
+		DdsTexture& operator=(DdsTexture&&) = delete;
+	};
+}
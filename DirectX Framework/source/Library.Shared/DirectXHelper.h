@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <ppltasks.h>	// For create_task
+#include "Profiler.h"
 
 namespace DX
 {
@@ -26,6 +27,8 @@ namespace DX
 			return FileIO::ReadBufferAsync(file);
 		}).then([] (Streams::IBuffer^ fileBuffer) -> std::vector<byte> 
 		{
+			DX_PROFILE_ZONE("ReadDataAsync");
+
 			std::vector<byte> returnBuffer;
 			returnBuffer.resize(fileBuffer->Length);
 			Streams::DataReader::FromBuffer(fileBuffer)->ReadBytes(Platform::ArrayReference<byte>(returnBuffer.data(), fileBuffer->Length));
@@ -33,6 +36,20 @@ namespace DX
 		});
 	}
 
+	// Converts a UTF-16 string, such as a WinRT path, to UTF-8 for the portable file APIs.
+	inline std::string ToUtf8(const std::wstring& text)
+	{
+		if (text.empty())
+		{
+			return std::string();
+		}
+
+		const int length = WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+		std::string utf8(static_cast<size_t>(length), '\0');
+		WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &utf8[0], length, nullptr, nullptr);
+		return utf8;
+	}
+
 	// Converts a length in device-independent pixels (DIPs) to a length in physical pixels.
 	inline float ConvertDipsToPixels(float dips, float dpi)
 	{
@@ -0,0 +1,315 @@
+#include "DrawSorter.h"
+#include <cstring>
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		enum StateChange
+		{
+			PipelineChange,
+			MeshChange,
+			TextureChange,
+			ConstantUpdate,
+			StateChangeCount
+		};
+
+		void CountStateChanges(const RenderCommandList& commandList, uint64_t (&changes)[StateChangeCount])
+		{
+			const RenderCommand* commands = commandList.Commands();
+			for (size_t i = 0; i < commandList.CommandCount(); ++i)
+			{
+				switch (commands[i].Type)
+				{
+				case RenderCommandType::SetPipeline:
+					++changes[PipelineChange];
+					break;
+
+				case RenderCommandType::SetMesh:
+					++changes[MeshChange];
+					break;
+
+				case RenderCommandType::SetTexture:
+					++changes[TextureChange];
+					break;
+
+				case RenderCommandType::SetConstants:
+					++changes[ConstantUpdate];
+					break;
+
+				default:
+					break;
+				}
+			}
+		}
+	}
+
+	DrawSorter::DrawSorter() :
+		mBoundPipeline(RenderCommandList::InvalidPipeline), mBoundTexture(RenderCommandList::BackBuffer), mBoundConstants(), mTotals(), mLastSort()
+	{
+	}
+
+	uint64_t DrawSorter::SortKey(uint16_t layer, PipelineHandle pipeline, RenderTargetHandle texture, MeshHandle mesh)
+	{
+		return (static_cast<uint64_t>(layer) << 48) | (static_cast<uint64_t>(pipeline & 0xFFFF) << 32) | (static_cast<uint64_t>(texture & 0xFFFF) << 16) |
+			static_cast<uint64_t>(mesh & 0xFFFF);
+	}
+
+	void DrawSorter::Sort(const RenderCommandList& source, RenderCommandList& sorted)
+	{
+		// The sorted commands reference the source's data at the same offsets.
+		sorted.Clear();
+		sorted.mData.assign(source.mData.begin(), source.mData.end());
+		mPackets.clear();
+		mInstanceUpdates.clear();
+		mBoundPipeline = RenderCommandList::InvalidPipeline;
+		mBoundTexture = RenderCommandList::BackBuffer;
+		mBoundConstants[0] = nullptr;
+		mBoundConstants[1] = nullptr;
+
+		const uint64_t segmentsBefore = mTotals.Segments;
+		const uint64_t drawsBefore = mTotals.Draws;
+
+		// The state each draw is recorded with, as a backend would see it.
+		PipelineHandle pipeline = RenderCommandList::InvalidPipeline;
+		MeshHandle mesh = RenderCommandList::InvalidMesh;
+		RenderTargetHandle texture = RenderCommandList::BackBuffer;
+		const RenderCommand* constants[2] = {};
+
+		const RenderCommand* commands = source.Commands();
+		for (size_t i = 0; i < source.CommandCount(); ++i)
+		{
+			const RenderCommand& command = commands[i];
+			switch (command.Type)
+			{
+			case RenderCommandType::SetPipeline:
+				pipeline = command.Pipeline;
+				texture = RenderCommandList::BackBuffer;
+				break;
+
+			case RenderCommandType::SetMesh:
+				mesh = command.Mesh;
+				break;
+
+			case RenderCommandType::SetTexture:
+				texture = command.Target;
+				break;
+
+			case RenderCommandType::SetConstants:
+				constants[static_cast<uint32_t>(command.Stage)] = &command;
+				break;
+
+			case RenderCommandType::UpdateInstances:
+			{
+				for (const Packet& packet : mPackets)
+				{
+					if (packet.Mesh == mesh)
+					{
+						FlushSegment(sorted);
+						break;
+					}
+				}
+
+				const InstanceUpdate update = { mesh, &command };
+				mInstanceUpdates.push_back(update);
+				break;
+			}
+
+			case RenderCommandType::Draw:
+			case RenderCommandType::DrawInstanced:
+			{
+				const Packet packet = { &command, pipeline, mesh, texture, constants[0], constants[1] };
+				mPackets.push_back(packet);
+				break;
+			}
+
+			case RenderCommandType::SetRenderTarget:
+				FlushSegment(sorted);
+				sorted.SetRenderTarget(command.Target);
+				texture = RenderCommandList::BackBuffer;
+				mBoundTexture = RenderCommandList::BackBuffer;
+				break;
+
+			case RenderCommandType::ClearRenderTarget:
+			case RenderCommandType::SetScissor:
+				FlushSegment(sorted);
+				sorted.mCommands.push_back(command);
+				break;
+			}
+		}
+
+		FlushSegment(sorted);
+
+		uint64_t before[StateChangeCount] = {};
+		uint64_t after[StateChangeCount] = {};
+		CountStateChanges(source, before);
+		CountStateChanges(sorted, after);
+
+		Counters counters = {};
+		counters.Lists = 1;
+		counters.Draws = mTotals.Draws - drawsBefore;
+		counters.Segments = mTotals.Segments - segmentsBefore;
+		counters.PipelineChangesAvoided = static_cast<int64_t>(before[PipelineChange]) - static_cast<int64_t>(after[PipelineChange]);
+		counters.MeshChangesAvoided = static_cast<int64_t>(before[MeshChange]) - static_cast<int64_t>(after[MeshChange]);
+		counters.TextureChangesAvoided = static_cast<int64_t>(before[TextureChange]) - static_cast<int64_t>(after[TextureChange]);
+		counters.ConstantUpdatesAvoided = static_cast<int64_t>(before[ConstantUpdate]) - static_cast<int64_t>(after[ConstantUpdate]);
+		for (uint32_t i = 0; i < StateChangeCount; ++i)
+		{
+			counters.StateChangesBefore += before[i];
+			counters.StateChangesAfter += after[i];
+		}
+
+		// Draws and segments were added to the totals as they were flushed.
+		mLastSort = counters;
+		++mTotals.Lists;
+		mTotals.StateChangesBefore += counters.StateChangesBefore;
+		mTotals.StateChangesAfter += counters.StateChangesAfter;
+		mTotals.PipelineChangesAvoided += counters.PipelineChangesAvoided;
+		mTotals.MeshChangesAvoided += counters.MeshChangesAvoided;
+		mTotals.TextureChangesAvoided += counters.TextureChangesAvoided;
+		mTotals.ConstantUpdatesAvoided += counters.ConstantUpdatesAvoided;
+	}
+
+	const DrawSorter::Counters& DrawSorter::Totals() const
+	{
+		return mTotals;
+	}
+
+	const DrawSorter::Counters& DrawSorter::LastSort() const
+	{
+		return mLastSort;
+	}
+
+	void DrawSorter::ResetCounters()
+	{
+		mTotals = Counters();
+		mLastSort = Counters();
+	}
+
+	void DrawSorter::WriteReport(ostream& stream) const
+	{
+		stream << "lists\t" << mTotals.Lists << '\n';
+		stream << "draws\t" << mTotals.Draws << '\n';
+		stream << "segments\t" << mTotals.Segments << '\n';
+		stream << "state_changes_before\t" << mTotals.StateChangesBefore << '\n';
+		stream << "state_changes_after\t" << mTotals.StateChangesAfter << '\n';
+		stream << "pipeline_changes_avoided\t" << mTotals.PipelineChangesAvoided << '\n';
+		stream << "mesh_changes_avoided\t" << mTotals.MeshChangesAvoided << '\n';
+		stream << "texture_changes_avoided\t" << mTotals.TextureChangesAvoided << '\n';
+		stream << "constant_updates_avoided\t" << mTotals.ConstantUpdatesAvoided << '\n';
+	}
+
+	void DrawSorter::FlushSegment(RenderCommandList& sorted)
+	{
+		for (const InstanceUpdate& update : mInstanceUpdates)
+		{
+			sorted.SetMesh(update.Mesh);
+			sorted.mCommands.push_back(*update.Update);
+		}
+
+		mInstanceUpdates.clear();
+
+		if (mPackets.empty())
+		{
+			return;
+		}
+
+		RadixSort();
+
+		for (const uint32_t index : mOrder)
+		{
+			const Packet& packet = mPackets[index];
+			if (packet.Pipeline != mBoundPipeline)
+			{
+				sorted.SetPipeline(packet.Pipeline);
+				mBoundPipeline = packet.Pipeline;
+				mBoundConstants[0] = nullptr;
+				mBoundConstants[1] = nullptr;
+			}
+
+			sorted.SetMesh(packet.Mesh);
+
+			// Draws recorded without a texture don't sample one, so whatever is bound can stay.
+			if (packet.Texture != RenderCommandList::BackBuffer && packet.Texture != mBoundTexture)
+			{
+				sorted.SetTexture(packet.Texture);
+				mBoundTexture = packet.Texture;
+			}
+
+			const RenderCommand* constants[2] = { packet.VertexConstants, packet.PixelConstants };
+			for (uint32_t stage = 0; stage < 2; ++stage)
+			{
+				if (constants[stage] != nullptr && constants[stage] != mBoundConstants[stage])
+				{
+					sorted.mCommands.push_back(*constants[stage]);
+					mBoundConstants[stage] = constants[stage];
+				}
+			}
+
+			sorted.mCommands.push_back(*packet.Draw);
+			++sorted.mDrawCount;
+			sorted.mVertexCount += static_cast<uint64_t>(packet.Draw->VertexCount) * (packet.Draw->Type == RenderCommandType::DrawInstanced ? packet.Draw->InstanceCount : 1);
+		}
+
+		++mTotals.Segments;
+		mTotals.Draws += mPackets.size();
+		mPackets.clear();
+	}
+
+	// Least significant byte first. Every byte's histogram is built in one pass over the keys, and bytes that are the same
+	// in every key (most of them, with few layers and handles) are skipped.
+	void DrawSorter::RadixSort()
+	{
+		const uint32_t count = static_cast<uint32_t>(mPackets.size());
+		mKeys.resize(count);
+		mKeysScratch.resize(count);
+		mOrder.resize(count);
+		mOrderScratch.resize(count);
+
+		uint32_t histograms[8][256];
+		memset(histograms, 0, sizeof(histograms));
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Packet& packet = mPackets[i];
+			const uint64_t key = SortKey(packet.Draw->Layer, packet.Pipeline, packet.Texture, packet.Mesh);
+			mKeys[i] = key;
+			mOrder[i] = i;
+
+			for (uint32_t byte = 0; byte < 8; ++byte)
+			{
+				++histograms[byte][(key >> (byte * 8)) & 0xFF];
+			}
+		}
+
+		for (uint32_t byte = 0; byte < 8; ++byte)
+		{
+			uint32_t (&histogram)[256] = histograms[byte];
+			const uint32_t shift = byte * 8;
+			if (histogram[(mKeys[0] >> shift) & 0xFF] == count)
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t& bucket : histogram)
+			{
+				const uint32_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}
+
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint32_t destination = histogram[(mKeys[i] >> shift) & 0xFF]++;
+				mKeysScratch[destination] = mKeys[i];
+				mOrderScratch[destination] = mOrder[i];
+			}
+
+			mKeys.swap(mKeysScratch);
+			mOrder.swap(mOrderScratch);
+		}
+	}
+}
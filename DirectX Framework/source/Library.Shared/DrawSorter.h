@@ -0,0 +1,94 @@
+#pragma once
+
+#include "RenderCommandList.h"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace DX
+{
+	// Reorders a recorded list's draws so draws sharing state are submitted together, and records the result into a second
+	// list for the backend. Every draw gets a 64-bit key (layer, pipeline, texture, mesh, from most to least significant)
+	// and the keys are radix sorted; the sort is stable, so draws with equal keys keep their recorded order. Each draw is
+	// submitted with the pipeline, mesh, texture and constants it was recorded with, and only the state that differs from
+	// the previous draw is bound.
+	//
+	// A draw's texture is the one set since its pipeline was bound; draws with none don't sample one, so they don't force a
+	// texture change. Render target changes, clears and scissor changes are barriers: draws are only sorted between them. Instance updates
+	// are submitted ahead of the draws they share a segment with, unless a draw before the update already reads the same
+	// mesh, which also starts a new segment.
+	class DrawSorter final
+	{
+	public:
+		struct Counters
+		{
+			std::uint64_t Lists;
+			std::uint64_t Draws;
+			std::uint64_t Segments;					// Runs of draws between barriers
+			std::uint64_t StateChangesBefore;		// Pipeline, mesh, texture and constant binds in the recorded lists
+			std::uint64_t StateChangesAfter;		// The same in the sorted lists
+			std::int64_t PipelineChangesAvoided;
+			std::int64_t MeshChangesAvoided;
+			std::int64_t TextureChangesAvoided;
+			std::int64_t ConstantUpdatesAvoided;
+		};
+
+		DrawSorter();
+		DrawSorter(const DrawSorter&) = delete;
+		DrawSorter& operator=(const DrawSorter&) = delete;
+		DrawSorter(DrawSorter&&) = default;
+		DrawSorter& operator=(DrawSorter&&) = default;
+		~DrawSorter() = default;
+
+		// Handles are truncated to 16 bits; the handles a backend hands out stay well below that.
+		static std::uint64_t SortKey(std::uint16_t layer, PipelineHandle pipeline, RenderTargetHandle texture, MeshHandle mesh);
+
+		// Clears sorted and records source's commands into it in sorted order. Source's constants and instance data are
+		// copied over in one block rather than per command. The sorter keeps its scratch storage, so a steady frame sorts
+		// without allocating.
+		void Sort(const RenderCommandList& source, RenderCommandList& sorted);
+
+		const Counters& Totals() const;
+		const Counters& LastSort() const;
+		void ResetCounters();
+
+		void WriteReport(std::ostream& stream) const;
+
+	private:
+		// A draw with the state it was recorded with. Constants point at the SetConstants commands in the source list.
+		struct Packet
+		{
+			const RenderCommand* Draw;
+			PipelineHandle Pipeline;
+			MeshHandle Mesh;
+			RenderTargetHandle Texture;
+			const RenderCommand* VertexConstants;
+			const RenderCommand* PixelConstants;
+		};
+
+		struct InstanceUpdate
+		{
+			MeshHandle Mesh;
+			const RenderCommand* Update;
+		};
+
+		void FlushSegment(RenderCommandList& sorted);
+		void RadixSort();
+
+		std::vector<Packet> mPackets;
+		std::vector<InstanceUpdate> mInstanceUpdates;
+		std::vector<std::uint64_t> mKeys;
+		std::vector<std::uint64_t> mKeysScratch;
+		std::vector<std::uint32_t> mOrder;
+		std::vector<std::uint32_t> mOrderScratch;
+
+		// What the sorted list has bound. Constants are bound again after every pipeline change, since a backend without
+		// constant buffer offsetting binds the pipeline's own buffers.
+		PipelineHandle mBoundPipeline;
+		RenderTargetHandle mBoundTexture;
+		const RenderCommand* mBoundConstants[2];
+
+		Counters mTotals;
+		Counters mLastSort;
+	};
+}
@@ -37,6 +37,30 @@ namespace DX
 		mCamera = camera;
 	}
 
+	void DrawableGameComponent::RecordOffscreenDraws(const StepTimer& timer, RenderCommandList& commandList)
+	{
+		UNREFERENCED_PARAMETER(timer);
+		UNREFERENCED_PARAMETER(commandList);
+	}
+
+	void DrawableGameComponent::RecordDraws(const StepTimer& timer, RenderCommandList& commandList)
+	{
+		UNREFERENCED_PARAMETER(timer);
+		UNREFERENCED_PARAMETER(commandList);
+	}
+
+	float DrawableGameComponent::PixelsPerWorldUnit() const
+	{
+		if (mCamera == nullptr)
+		{
+			return 0.0f;
+		}
+
+		const DirectX::XMFLOAT4& visibleBounds = mCamera->VisibleBounds();
+		const float visibleHeight = visibleBounds.w - visibleBounds.y;
+		return (visibleHeight > 0.0f ? mDeviceResources->GetScreenViewport().Height / visibleHeight : 0.0f);
+	}
+
 	void DrawableGameComponent::Render(const StepTimer& timer)
 	{
 		UNREFERENCED_PARAMETER(timer);
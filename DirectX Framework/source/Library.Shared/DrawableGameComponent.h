@@ -6,6 +6,7 @@
 namespace DX
 {
     class Camera;
+    class RenderCommandList;
 
     class DrawableGameComponent : public GameComponent
     {
@@ -24,9 +25,22 @@ namespace DX
 		std::shared_ptr<Camera> GetCamera();
 		void SetCamera(const std::shared_ptr<Camera>& camera);
 
+        // Appends the draws into this component's own render targets to the frame's command list. Every component's are
+        // recorded before any component's RecordDraws: a render target switch is a barrier the DrawSorter doesn't sort
+        // across, so back buffer draws recorded ahead of it would end up under whatever is drawn after it.
+        virtual void RecordOffscreenDraws(const DX::StepTimer& timer, RenderCommandList& commandList);
+
+        // Appends this component's geometry to the frame's command list; the list is executed before any Render call.
+        virtual void RecordDraws(const DX::StepTimer& timer, RenderCommandList& commandList);
+
+        // Draws directly, for work that doesn't go through the command list (e.g. Direct2D text).
         virtual void Render(const DX::StepTimer& timer);
 
     protected:
+        // Screen pixels per world unit, from the camera's visible height and the screen viewport's. Zero before both are set
+        // up. For an orthographic camera this sizes anything in the world on screen, as shape levels of detail need.
+        float PixelsPerWorldUnit() const;
+
         bool mVisible;
 		std::shared_ptr<Camera> mCamera;
     };
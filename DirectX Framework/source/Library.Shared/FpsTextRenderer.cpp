@@ -1,125 +1,59 @@
 ﻿#include "pch.h"
 #include "FpsTextRenderer.h"
 #include "DirectXHelper.h"
-
-using namespace Microsoft::WRL;
+#include "FrameStatistics.h"
+#include "TextOverlay.h"
+#include <cstdio>
 
 namespace DX
 {
-	// Initializes D2D resources used for text rendering.
-	FpsTextRenderer::FpsTextRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
+	// Reserves enough room for the FPS line and one line per metric so updating the text never allocates.
+	FpsTextRenderer::FpsTextRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<TextOverlay>& textOverlay, const std::shared_ptr<FrameStatistics>& frameStatistics) :
 		DrawableGameComponent(deviceResources),
-		m_text(L"")
+		mTextOverlay(textOverlay), mFrameStatistics(frameStatistics), mText(GlyphText::Alignment::Right, 512),
+		mLastWindowGeneration(UINT32_MAX), mLastFramesPerSecond(UINT32_MAX)
 	{
-		ZeroMemory(&m_textMetrics, sizeof(DWRITE_TEXT_METRICS));
-
-		// Create device independent resources
-		ComPtr<IDWriteTextFormat> textFormat;
-		DX::ThrowIfFailed(
-			mDeviceResources->GetDWriteFactory()->CreateTextFormat(
-				L"Segoe UI",
-				nullptr,
-				DWRITE_FONT_WEIGHT_LIGHT,
-				DWRITE_FONT_STYLE_NORMAL,
-				DWRITE_FONT_STRETCH_NORMAL,
-				32.0f,
-				L"en-US",
-				&textFormat
-			)
-		);
-
-		DX::ThrowIfFailed(
-			textFormat.As(&m_textFormat)
-		);
-
-		DX::ThrowIfFailed(
-			m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR)
-		);
-
-		DX::ThrowIfFailed(
-			mDeviceResources->GetD2DFactory()->CreateDrawingStateBlock(&m_stateBlock)
-		);
-
-		CreateDeviceDependentResources();
 	}
 
 	// Updates the text to be displayed.
 	void FpsTextRenderer::Update(const StepTimer& timer)
 	{
-		// Update display text.
+		// Only rebuild the text when the value shown would change.
 		uint32 fps = timer.GetFramesPerSecond();
+		uint32_t windowGeneration = (mFrameStatistics != nullptr ? mFrameStatistics->WindowGeneration() : 0);
+		if (fps == mLastFramesPerSecond && windowGeneration == mLastWindowGeneration)
+		{
+			return;
+		}
 
-		m_text = (fps > 0) ? std::to_wstring(fps) + L" FPS" : L" - FPS";
+		mLastFramesPerSecond = fps;
+		mLastWindowGeneration = windowGeneration;
 
-		ComPtr<IDWriteTextLayout> textLayout;
-		DX::ThrowIfFailed(
-			mDeviceResources->GetDWriteFactory()->CreateTextLayout(
-				m_text.c_str(),
-				(uint32)m_text.length(),
-				m_textFormat.Get(),
-				240.0f, // Max width of the input text.
-				50.0f, // Max height of the input text.
-				&textLayout
-			)
-		);
+		char text[512];
+		int length = (fps > 0 ? snprintf(text, sizeof(text), "%u FPS", fps) : snprintf(text, sizeof(text), " - FPS"));
 
-		DX::ThrowIfFailed(
-			textLayout.As(&m_textLayout)
-		);
+		if (mFrameStatistics != nullptr)
+		{
+			// One line per metric: p50 / p99 / p99.9 / max over the sliding window, in milliseconds.
+			static const FrameStatistics::Metric metrics[] = { FrameStatistics::Metric::Frame, FrameStatistics::Metric::Update, FrameStatistics::Metric::Render, FrameStatistics::Metric::Text, FrameStatistics::Metric::Present };
+			for (FrameStatistics::Metric metric : metrics)
+			{
+				const FrameStatistics::Summary summary = mFrameStatistics->WindowSummary(metric);
+
+				length += snprintf(text + length, sizeof(text) - length, "\n%s %.2f / %.2f / %.2f / %.2f ms", FrameStatistics::MetricName(metric), summary.P50, summary.P99, summary.P999, summary.Max);
+			}
+		}
 
-		DX::ThrowIfFailed(
-			m_textLayout->GetMetrics(&m_textMetrics)
-		);
+		// The overlay lays the text out again when it is next drawn.
+		mText.SetText(text);
 	}
 
-	// Renders a frame to the screen.
+	// Queues the text on the bottom right corner.
 	void FpsTextRenderer::Render(const StepTimer& timer)
 	{
 		UNREFERENCED_PARAMETER(timer);
 
-		ID2D1DeviceContext* context = mDeviceResources->GetD2DDeviceContext();
 		Windows::Foundation::Size logicalSize = mDeviceResources->GetLogicalSize();
-
-		context->SaveDrawingState(m_stateBlock.Get());
-		context->BeginDraw();
-
-		// Position on the bottom right corner
-		D2D1::Matrix3x2F screenTranslation = D2D1::Matrix3x2F::Translation(
-			logicalSize.Width - m_textMetrics.layoutWidth,
-			logicalSize.Height - m_textMetrics.height
-		);
-
-		context->SetTransform(screenTranslation * mDeviceResources->GetOrientationTransform2D());
-
-		DX::ThrowIfFailed(
-			m_textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_TRAILING)
-		);
-
-		context->DrawTextLayout(
-			D2D1::Point2F(0.f, 0.f),
-			m_textLayout.Get(),
-			m_whiteBrush.Get()
-		);
-
-		// Ignore D2DERR_RECREATE_TARGET here. This error indicates that the device
-		// is lost. It will be handled during the next call to Present.
-		HRESULT hr = context->EndDraw();
-		if (hr != D2DERR_RECREATE_TARGET)
-		{
-			DX::ThrowIfFailed(hr);
-		}
-
-		context->RestoreDrawingState(m_stateBlock.Get());
-	}
-
-	void FpsTextRenderer::CreateDeviceDependentResources()
-	{
-		DX::ThrowIfFailed(
-			mDeviceResources->GetD2DDeviceContext()->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_whiteBrush)
-		);
-	}
-	void FpsTextRenderer::ReleaseDeviceDependentResources()
-	{
-		m_whiteBrush.Reset();
+		mTextOverlay->Draw(mText, logicalSize.Width, logicalSize.Height, (mFrameStatistics != nullptr ? 16.0f : 32.0f), 1.0f, 1.0f);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,89 @@
+#include "FrameArena.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace DX
+{
+	LinearArena::LinearArena(size_t capacity) :
+		mBuffer(new uint8_t[capacity]), mCapacity(capacity), mOffset(0), mOverflowSize(0), mHighWaterMark(0)
+	{
+	}
+
+	void LinearArena::Reset()
+	{
+		const size_t used = Used();
+		mHighWaterMark = max(mHighWaterMark, used);
+
+		if (!mOverflowBlocks.empty())
+		{
+			// Grow so that the next frame with the same workload fits in a single buffer.
+			size_t capacity = max(mCapacity, static_cast<size_t>(1));
+			while (capacity < mHighWaterMark)
+			{
+				capacity *= 2;
+			}
+
+			mOverflowBlocks.clear();
+			mOverflowSize = 0;
+			mBuffer.reset(new uint8_t[capacity]);
+			mCapacity = capacity;
+		}
+
+		mOffset = 0;
+	}
+
+	size_t LinearArena::Capacity() const
+	{
+		return mCapacity;
+	}
+
+	size_t LinearArena::Used() const
+	{
+		return mOffset + mOverflowSize;
+	}
+
+	size_t LinearArena::HighWaterMark() const
+	{
+		return max(mHighWaterMark, Used());
+	}
+
+	void* LinearArena::AllocateOverflow(size_t size, size_t alignment)
+	{
+		// Each overflow allocation gets its own block, padded so it can be aligned within it.
+		const size_t blockSize = size + alignment - 1;
+		mOverflowBlocks.emplace_back(new uint8_t[blockSize]);
+		mOverflowSize += blockSize;
+
+		const uintptr_t base = reinterpret_cast<uintptr_t>(mOverflowBlocks.back().get());
+		const uintptr_t aligned = (base + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	FrameArena::FrameArena(size_t capacityPerFrame) :
+		mArenas{ LinearArena(capacityPerFrame), LinearArena(capacityPerFrame) }, mFrameIndex(0)
+	{
+	}
+
+	void FrameArena::BeginFrame()
+	{
+		++mFrameIndex;
+		Current().Reset();
+	}
+
+	LinearArena& FrameArena::Current()
+	{
+		return mArenas[mFrameIndex % FrameCount];
+	}
+
+	LinearArena& FrameArena::Previous()
+	{
+		return mArenas[(mFrameIndex + 1) % FrameCount];
+	}
+
+	uint64_t FrameArena::FrameIndex() const
+	{
+		return mFrameIndex;
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace DX
+{
+	// Bump allocator for transient data. Allocations are never freed individually; Reset releases everything at once.
+	// When the buffer runs out, allocations spill into overflow blocks and the next Reset grows the buffer to the high-water
+	// mark, so a steady workload stops touching the heap after its first frames. This file only depends on the C++
+	// standard library.
+	class LinearArena final
+	{
+	public:
+		static const std::size_t DefaultCapacity = 64 * 1024;
+
+		explicit LinearArena(std::size_t capacity = DefaultCapacity);
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+		LinearArena(LinearArena&&) = default;
+		LinearArena& operator=(LinearArena&&) = default;
+		~LinearArena() = default;
+
+		void* Allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+		template <typename T>
+		T* Allocate(std::size_t count = 1);
+
+		void Reset();
+
+		std::size_t Capacity() const;
+		std::size_t Used() const;
+		std::size_t HighWaterMark() const;
+
+	private:
+		void* AllocateOverflow(std::size_t size, std::size_t alignment);
+
+		std::unique_ptr<std::uint8_t[]> mBuffer;
+		std::size_t mCapacity;
+		std::size_t mOffset;
+		std::vector<std::unique_ptr<std::uint8_t[]>> mOverflowBlocks;
+		std::size_t mOverflowSize;
+		std::size_t mHighWaterMark;
+	};
+
+	// A pair of linear arenas used on alternating frames. Data allocated during frame N stays valid until BeginFrame is
+	// called for frame N + 2, so a reader that trails the writer by one frame (e.g. a render thread) never sees it reset.
+	class FrameArena final
+	{
+	public:
+		static const std::uint32_t FrameCount = 2;
+
+		explicit FrameArena(std::size_t capacityPerFrame = LinearArena::DefaultCapacity);
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+		FrameArena(FrameArena&&) = delete;
+		FrameArena& operator=(FrameArena&&) = delete;
+		~FrameArena() = default;
+
+		// Switches to the other arena and resets it. Call once at the start of every tick.
+		void BeginFrame();
+
+		LinearArena& Current();
+		LinearArena& Previous();
+		std::uint64_t FrameIndex() const;
+
+	private:
+		LinearArena mArenas[FrameCount];
+		std::uint64_t mFrameIndex;
+	};
+
+	// STL allocator adapter over a LinearArena. Deallocation is a no-op; memory is reclaimed when the arena is reset,
+	// so containers using it must not outlive the frame they were created in.
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		explicit ArenaAllocator(LinearArena& arena);
+
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other);
+
+		T* allocate(std::size_t count);
+		void deallocate(T* pointer, std::size_t count);
+
+		LinearArena& Arena() const;
+
+	private:
+		LinearArena* mArena;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs);
+
+	template <typename T, typename U>
+	bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs);
+}
+
+#include "FrameArena.inl"
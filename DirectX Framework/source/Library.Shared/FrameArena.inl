@@ -0,0 +1,67 @@
+#pragma once
+
+namespace DX
+{
+	template <typename T>
+	inline T* LinearArena::Allocate(std::size_t count)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	inline void* LinearArena::Allocate(std::size_t size, std::size_t alignment)
+	{
+		const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(mBuffer.get());
+		const std::uintptr_t aligned = (base + mOffset + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+		const std::size_t end = static_cast<std::size_t>(aligned - base) + size;
+
+		if (end > mCapacity)
+		{
+			return AllocateOverflow(size, alignment);
+		}
+
+		mOffset = end;
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	template <typename T>
+	inline ArenaAllocator<T>::ArenaAllocator(LinearArena& arena) :
+		mArena(&arena)
+	{
+	}
+
+	template <typename T>
+	template <typename U>
+	inline ArenaAllocator<T>::ArenaAllocator(const ArenaAllocator<U>& other) :
+		mArena(&other.Arena())
+	{
+	}
+
+	template <typename T>
+	inline T* ArenaAllocator<T>::allocate(std::size_t count)
+	{
+		return mArena->Allocate<T>(count);
+	}
+
+	template <typename T>
+	inline void ArenaAllocator<T>::deallocate(T*, std::size_t)
+	{
+	}
+
+	template <typename T>
+	inline LinearArena& ArenaAllocator<T>::Arena() const
+	{
+		return *mArena;
+	}
+
+	template <typename T, typename U>
+	inline bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+	{
+		return &lhs.Arena() == &rhs.Arena();
+	}
+
+	template <typename T, typename U>
+	inline bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+}
@@ -0,0 +1,440 @@
+#include "FrameCapture.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		const uint32_t MaxStoredBlock = 65535;
+
+#if defined(_WIN32)
+		wstring Widen(const string& utf8)
+		{
+			if (utf8.empty())
+			{
+				return wstring();
+			}
+
+			const int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+			wstring wide(static_cast<size_t>(length), L'\0');
+			MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), &wide[0], length);
+			return wide;
+		}
+#endif
+
+		FILE* OpenForWriting(const string& path)
+		{
+#if defined(_WIN32)
+			FILE* file = nullptr;
+			return (_wfopen_s(&file, Widen(path).c_str(), L"wb") == 0 ? file : nullptr);
+#else
+			return fopen(path.c_str(), "wb");
+#endif
+		}
+
+		// Red, green and blue of a pixel, whichever way round they are stored.
+		inline void Channels(const uint8_t* pixel, FrameCapture::PixelLayout layout, uint32_t& red, uint32_t& green, uint32_t& blue)
+		{
+			const bool bgra = (layout == FrameCapture::PixelLayout::Bgra8);
+			red = pixel[bgra ? 2 : 0];
+			green = pixel[1];
+			blue = pixel[bgra ? 0 : 2];
+		}
+
+		// BT.601 studio range in 8.8 fixed point.
+		inline uint8_t Luma(uint32_t red, uint32_t green, uint32_t blue)
+		{
+			return static_cast<uint8_t>(((66 * red + 129 * green + 25 * blue + 128) >> 8) + 16);
+		}
+
+		inline uint8_t BlueDifference(int32_t red, int32_t green, int32_t blue)
+		{
+			return static_cast<uint8_t>(((-38 * red - 74 * green + 112 * blue + 128) >> 8) + 128);
+		}
+
+		inline uint8_t RedDifference(int32_t red, int32_t green, int32_t blue)
+		{
+			return static_cast<uint8_t>(((112 * red - 94 * green - 18 * blue + 128) >> 8) + 128);
+		}
+
+		const uint32_t* CrcTable()
+		{
+			struct Table
+			{
+				uint32_t Entries[256];
+
+				Table()
+				{
+					for (uint32_t i = 0; i < 256; ++i)
+					{
+						uint32_t value = i;
+						for (int bit = 0; bit < 8; ++bit)
+						{
+							value = ((value & 1) != 0 ? 0xEDB88320U ^ (value >> 1) : value >> 1);
+						}
+
+						Entries[i] = value;
+					}
+				}
+			};
+
+			static const Table table;
+			return table.Entries;
+		}
+
+		uint32_t Crc32(const uint8_t* data, size_t size)
+		{
+			const uint32_t* table = CrcTable();
+			uint32_t crc = 0xFFFFFFFFU;
+			for (size_t i = 0; i < size; ++i)
+			{
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			}
+
+			return crc ^ 0xFFFFFFFFU;
+		}
+
+		// Sums are reduced every 5552 bytes, the longest run that can't overflow 32 bits.
+		uint32_t Adler32(const uint8_t* data, size_t size)
+		{
+			uint32_t low = 1;
+			uint32_t high = 0;
+			while (size > 0)
+			{
+				const size_t run = min<size_t>(size, 5552);
+				for (size_t i = 0; i < run; ++i)
+				{
+					low += data[i];
+					high += low;
+				}
+
+				low %= 65521;
+				high %= 65521;
+				data += run;
+				size -= run;
+			}
+
+			return (high << 16) | low;
+		}
+
+		void AppendBigEndian(vector<uint8_t>& buffer, uint32_t value)
+		{
+			const uint8_t bytes[4] = { static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) };
+			buffer.insert(buffer.end(), bytes, bytes + 4);
+		}
+
+		void StoreBigEndian(uint8_t* destination, uint32_t value)
+		{
+			destination[0] = static_cast<uint8_t>(value >> 24);
+			destination[1] = static_cast<uint8_t>(value >> 16);
+			destination[2] = static_cast<uint8_t>(value >> 8);
+			destination[3] = static_cast<uint8_t>(value);
+		}
+
+		void AppendChunk(vector<uint8_t>& buffer, const char* type, const uint8_t* data, uint32_t size)
+		{
+			AppendBigEndian(buffer, size);
+			const size_t start = buffer.size();
+			buffer.insert(buffer.end(), type, type + 4);
+			buffer.insert(buffer.end(), data, data + size);
+			AppendBigEndian(buffer, Crc32(&buffer[start], size + 4));
+		}
+	}
+
+	FrameCapture::FrameCapture(const string& path, Format format, uint32_t width, uint32_t height, uint32_t framesPerSecond, uint32_t slotCount, QueuePolicy policy) :
+		mPath(path), mFormat(format), mWidth(width), mHeight(height), mPolicy(policy), mStream(nullptr), mSlots(max(slotCount, 1U)), mQueue(max(slotCount, 1U)),
+		mQueueFront(0), mQueueCount(0), mTotals(), mShuttingDown(false)
+	{
+		for (Slot& slot : mSlots)
+		{
+			slot = { nullptr, 0, PixelLayout::Rgba8, SlotState::Free };
+		}
+
+		if (mFormat == Format::Y4m)
+		{
+			mStream = OpenForWriting(mPath);
+			if (mStream == nullptr)
+			{
+				throw runtime_error("FrameCapture: can't create " + mPath);
+			}
+
+			// C420jpeg places chroma between the luma samples, which is what averaging each 2x2 block gives.
+			char header[128];
+			const int length = snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", mWidth, mHeight, max(framesPerSecond, 1U));
+			mTotals.BytesWritten += fwrite(header, 1, static_cast<size_t>(length), mStream);
+		}
+
+		mEncoder = thread(&FrameCapture::EncoderMain, this);
+	}
+
+	FrameCapture::~FrameCapture()
+	{
+		{
+			lock_guard<mutex> lock(mMutex);
+			mShuttingDown = true;
+		}
+
+		mFrameQueued.notify_one();
+		mEncoder.join();
+
+		if (mStream != nullptr)
+		{
+			fclose(mStream);
+		}
+	}
+
+	uint32_t FrameCapture::Width() const
+	{
+		return mWidth;
+	}
+
+	uint32_t FrameCapture::Height() const
+	{
+		return mHeight;
+	}
+
+	uint32_t FrameCapture::SlotCount() const
+	{
+		return static_cast<uint32_t>(mSlots.size());
+	}
+
+	bool FrameCapture::Reserve(uint32_t& slot)
+	{
+		unique_lock<mutex> lock(mMutex);
+		++mTotals.FramesOffered;
+
+		auto freeSlot = [this]() { return find_if(mSlots.begin(), mSlots.end(), [](const Slot& candidate) { return candidate.State == SlotState::Free; }); };
+		auto found = freeSlot();
+		if (found == mSlots.end())
+		{
+			// Only queued frames come back on their own; if the caller holds every slot, waiting would never end.
+			if (mPolicy == QueuePolicy::DropNewest || mQueueCount == 0)
+			{
+				++mTotals.FramesDropped;
+				return false;
+			}
+
+			++mTotals.BlockedReservations;
+			mSlotFreed.wait(lock, [&]() { found = freeSlot(); return found != mSlots.end(); });
+		}
+
+		found->State = SlotState::Reserved;
+		slot = static_cast<uint32_t>(found - mSlots.begin());
+		return true;
+	}
+
+	void FrameCapture::Submit(uint32_t slot, const uint8_t* pixels, uint32_t rowPitch, PixelLayout layout)
+	{
+		{
+			lock_guard<mutex> lock(mMutex);
+			Slot& reserved = mSlots[slot];
+			reserved.Pixels = pixels;
+			reserved.RowPitch = rowPitch;
+			reserved.Layout = layout;
+			reserved.State = SlotState::Queued;
+
+			mQueue[(mQueueFront + mQueueCount) % mQueue.size()] = slot;
+			++mQueueCount;
+			++mTotals.FramesQueued;
+		}
+
+		mFrameQueued.notify_one();
+	}
+
+	void FrameCapture::Cancel(uint32_t slot)
+	{
+		{
+			lock_guard<mutex> lock(mMutex);
+			mSlots[slot].State = SlotState::Free;
+		}
+
+		mSlotFreed.notify_all();
+	}
+
+	void FrameCapture::Flush()
+	{
+		unique_lock<mutex> lock(mMutex);
+		mSlotFreed.wait(lock, [this]() { return mTotals.FramesEncoded + mTotals.WriteErrors == mTotals.FramesQueued; });
+	}
+
+	FrameCapture::Counters FrameCapture::Totals() const
+	{
+		lock_guard<mutex> lock(mMutex);
+		return mTotals;
+	}
+
+	void FrameCapture::EncoderMain()
+	{
+		for (;;)
+		{
+			uint32_t slot;
+			uint64_t frameIndex;
+			{
+				unique_lock<mutex> lock(mMutex);
+				mFrameQueued.wait(lock, [this]() { return mShuttingDown || mQueueCount > 0; });
+				if (mQueueCount == 0)
+				{
+					return;
+				}
+
+				slot = mQueue[mQueueFront];
+				frameIndex = mTotals.FramesEncoded + mTotals.WriteErrors;
+			}
+
+			// The slot stays queued, and its pixels untouched, until it is encoded.
+			const bool written = (mFormat == Format::Y4m ? EncodeY4m(mSlots[slot]) : EncodePng(mSlots[slot], frameIndex));
+
+			{
+				lock_guard<mutex> lock(mMutex);
+				mSlots[slot].State = SlotState::Free;
+				mQueueFront = static_cast<uint32_t>((mQueueFront + 1) % mQueue.size());
+				--mQueueCount;
+				++(written ? mTotals.FramesEncoded : mTotals.WriteErrors);
+				mTotals.BytesWritten += (written ? mEncodeBuffer.size() : 0);
+			}
+
+			mSlotFreed.notify_all();
+		}
+	}
+
+	bool FrameCapture::EncodeY4m(const Slot& slot)
+	{
+		static const char FrameHeader[] = "FRAME\n";
+		const size_t headerSize = sizeof(FrameHeader) - 1;
+		const uint32_t chromaWidth = (mWidth + 1) / 2;
+		const uint32_t chromaHeight = (mHeight + 1) / 2;
+		const size_t lumaSize = static_cast<size_t>(mWidth) * mHeight;
+		const size_t chromaSize = static_cast<size_t>(chromaWidth) * chromaHeight;
+
+		mEncodeBuffer.resize(headerSize + lumaSize + 2 * chromaSize);
+		memcpy(mEncodeBuffer.data(), FrameHeader, headerSize);
+		uint8_t* const luma = &mEncodeBuffer[headerSize];
+		uint8_t* const blueDifference = luma + lumaSize;
+		uint8_t* const redDifference = blueDifference + chromaSize;
+
+		// Chroma comes from the average color of each 2x2 block; odd edges repeat their last row or column.
+		mChromaSums.resize(static_cast<size_t>(chromaWidth) * 3);
+		for (uint32_t chromaY = 0; chromaY < chromaHeight; ++chromaY)
+		{
+			fill(mChromaSums.begin(), mChromaSums.end(), static_cast<uint16_t>(0));
+			for (uint32_t pair = 0; pair < 2; ++pair)
+			{
+				const uint32_t y = min(chromaY * 2 + pair, mHeight - 1);
+				const uint8_t* row = slot.Pixels + static_cast<size_t>(y) * slot.RowPitch;
+				uint8_t* lumaRow = luma + static_cast<size_t>(y) * mWidth;
+				for (uint32_t x = 0; x < mWidth; ++x)
+				{
+					uint32_t red;
+					uint32_t green;
+					uint32_t blue;
+					Channels(row + static_cast<size_t>(x) * 4, slot.Layout, red, green, blue);
+					lumaRow[x] = Luma(red, green, blue);
+
+					uint16_t* sums = &mChromaSums[static_cast<size_t>(x / 2) * 3];
+					const uint32_t weight = ((x & 1) == 0 && x + 1 == mWidth ? 2 : 1);
+					sums[0] = static_cast<uint16_t>(sums[0] + red * weight);
+					sums[1] = static_cast<uint16_t>(sums[1] + green * weight);
+					sums[2] = static_cast<uint16_t>(sums[2] + blue * weight);
+				}
+			}
+
+			for (uint32_t chromaX = 0; chromaX < chromaWidth; ++chromaX)
+			{
+				const uint16_t* sums = &mChromaSums[static_cast<size_t>(chromaX) * 3];
+				const int32_t red = (sums[0] + 2) / 4;
+				const int32_t green = (sums[1] + 2) / 4;
+				const int32_t blue = (sums[2] + 2) / 4;
+				const size_t index = static_cast<size_t>(chromaY) * chromaWidth + chromaX;
+				blueDifference[index] = BlueDifference(red, green, blue);
+				redDifference[index] = RedDifference(red, green, blue);
+			}
+		}
+
+		return (fwrite(mEncodeBuffer.data(), 1, mEncodeBuffer.size(), mStream) == mEncodeBuffer.size());
+	}
+
+	bool FrameCapture::EncodePng(const Slot& slot, uint64_t frameIndex)
+	{
+		static const uint8_t Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+		// IHDR: 8-bit RGB, no interlacing.
+		uint8_t header[13];
+		StoreBigEndian(header, mWidth);
+		StoreBigEndian(header + 4, mHeight);
+		header[8] = 8;
+		header[9] = 2;
+		header[10] = header[11] = header[12] = 0;
+
+		// Image data: each row is filter type 0 followed by its RGB bytes, wrapped in a zlib stream of stored blocks.
+		const size_t rowSize = 1 + static_cast<size_t>(mWidth) * 3;
+		mRawImage.resize(rowSize * mHeight);
+		for (uint32_t y = 0; y < mHeight; ++y)
+		{
+			const uint8_t* source = slot.Pixels + static_cast<size_t>(y) * slot.RowPitch;
+			uint8_t* row = &mRawImage[y * rowSize];
+			row[0] = 0;
+			for (uint32_t x = 0; x < mWidth; ++x)
+			{
+				uint32_t red;
+				uint32_t green;
+				uint32_t blue;
+				Channels(source + static_cast<size_t>(x) * 4, slot.Layout, red, green, blue);
+				row[1 + x * 3] = static_cast<uint8_t>(red);
+				row[2 + x * 3] = static_cast<uint8_t>(green);
+				row[3 + x * 3] = static_cast<uint8_t>(blue);
+			}
+		}
+
+		const size_t rawSize = mRawImage.size();
+		const size_t blockCount = max<size_t>((rawSize + MaxStoredBlock - 1) / MaxStoredBlock, 1);
+		const size_t zlibSize = 2 + rawSize + blockCount * 5 + 4;
+
+		mEncodeBuffer.clear();
+		mEncodeBuffer.reserve(sizeof(Signature) + 25 + 12 + zlibSize + 12);
+		mEncodeBuffer.insert(mEncodeBuffer.end(), Signature, Signature + sizeof(Signature));
+		AppendChunk(mEncodeBuffer, "IHDR", header, static_cast<uint32_t>(sizeof(header)));
+
+		AppendBigEndian(mEncodeBuffer, static_cast<uint32_t>(zlibSize));
+		const size_t chunkStart = mEncodeBuffer.size();
+		const uint8_t idat[] = { 'I', 'D', 'A', 'T', 0x78, 0x01 };
+		mEncodeBuffer.insert(mEncodeBuffer.end(), idat, idat + sizeof(idat));
+		for (size_t offset = 0, i = 0; i < blockCount; ++i)
+		{
+			const uint32_t length = static_cast<uint32_t>(min<size_t>(rawSize - offset, MaxStoredBlock));
+			const uint8_t blockHeader[] = { static_cast<uint8_t>(i + 1 == blockCount ? 1 : 0), static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8),
+				static_cast<uint8_t>(~length), static_cast<uint8_t>(~length >> 8) };
+			mEncodeBuffer.insert(mEncodeBuffer.end(), blockHeader, blockHeader + sizeof(blockHeader));
+			mEncodeBuffer.insert(mEncodeBuffer.end(), mRawImage.begin() + static_cast<ptrdiff_t>(offset), mRawImage.begin() + static_cast<ptrdiff_t>(offset + length));
+			offset += length;
+		}
+
+		AppendBigEndian(mEncodeBuffer, Adler32(mRawImage.data(), rawSize));
+		AppendBigEndian(mEncodeBuffer, Crc32(&mEncodeBuffer[chunkStart], mEncodeBuffer.size() - chunkStart));
+		AppendChunk(mEncodeBuffer, "IEND", nullptr, 0);
+
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "%06llu.png", static_cast<unsigned long long>(frameIndex));
+		FILE* file = OpenForWriting(mPath + suffix);
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const bool written = (fwrite(mEncodeBuffer.data(), 1, mEncodeBuffer.size(), file) == mEncodeBuffer.size());
+		return (fclose(file) == 0 && written);
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	// Encodes captured frames on a background thread so recording doesn't stall the render thread. Frames pass through a
+	// fixed set of slots: the render thread reserves a slot, fills the storage it keeps for that slot (a mapped staging
+	// texture, a swapped-out CPU framebuffer) and submits a pointer to the pixels, which must stay valid until the slot is
+	// free again. Nothing is copied on the render thread, so a frame costs it a reservation and a queue push. When every
+	// slot is busy the policy either blocks until the encoder frees one or drops the frame.
+	//
+	// Y4m output is one 4:2:0 stream (BT.601 studio range) that video tools read directly. PNG output is one RGB file per
+	// frame, numbered from zero, written with uncompressed deflate blocks so the encoder keeps up without a compression
+	// library; recompress offline if size matters. This file only depends on the C++ standard library and the OS file APIs.
+	class FrameCapture final
+	{
+	public:
+		enum class Format : std::uint8_t
+		{
+			Y4m,			// path is the stream file
+			PngSequence		// path is a prefix; frames are written to <path>000000.png, <path>000001.png, ...
+		};
+
+		enum class PixelLayout : std::uint8_t
+		{
+			Rgba8,			// SoftwareRenderBackend surfaces
+			Bgra8			// DXGI_FORMAT_B8G8R8A8_UNORM swap chains
+		};
+
+		enum class QueuePolicy : std::uint8_t
+		{
+			Block,			// Recording replays: every frame is encoded, and the render thread waits for the encoder if it must
+			DropNewest		// Recording live play: frames are dropped rather than ever holding up the frame
+		};
+
+		struct Counters
+		{
+			std::uint64_t FramesOffered;		// Reserve calls
+			std::uint64_t FramesQueued;
+			std::uint64_t FramesEncoded;
+			std::uint64_t FramesDropped;
+			std::uint64_t BlockedReservations;	// Reserve calls that had to wait for the encoder
+			std::uint64_t BytesWritten;
+			std::uint64_t WriteErrors;
+		};
+
+		static const std::uint32_t DefaultSlotCount = 4;
+
+		// Throws std::runtime_error if a Y4m stream can't be created. Paths are UTF-8.
+		FrameCapture(const std::string& path, Format format, std::uint32_t width, std::uint32_t height, std::uint32_t framesPerSecond,
+			std::uint32_t slotCount = DefaultSlotCount, QueuePolicy policy = QueuePolicy::DropNewest);
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+		FrameCapture(FrameCapture&&) = delete;
+		FrameCapture& operator=(FrameCapture&&) = delete;
+
+		// Encodes every frame already submitted, then closes the output.
+		~FrameCapture();
+
+		std::uint32_t Width() const;
+		std::uint32_t Height() const;
+		std::uint32_t SlotCount() const;
+
+		// Returns false when the frame is dropped. A slot is only handed out once the encoder is done with its last frame.
+		bool Reserve(std::uint32_t& slot);
+
+		// Queues the frame in a reserved slot. Rows are rowPitch bytes apart.
+		void Submit(std::uint32_t slot, const std::uint8_t* pixels, std::uint32_t rowPitch, PixelLayout layout);
+
+		// Returns a reserved slot without queueing a frame.
+		void Cancel(std::uint32_t slot);
+
+		// Waits until every submitted frame has been encoded.
+		void Flush();
+
+		Counters Totals() const;
+
+	private:
+		enum class SlotState : std::uint8_t
+		{
+			Free,
+			Reserved,
+			Queued
+		};
+
+		struct Slot
+		{
+			const std::uint8_t* Pixels;
+			std::uint32_t RowPitch;
+			PixelLayout Layout;
+			SlotState State;
+		};
+
+		void EncoderMain();
+		bool EncodeY4m(const Slot& slot);
+		bool EncodePng(const Slot& slot, std::uint64_t frameIndex);
+
+		std::string mPath;
+		Format mFormat;
+		std::uint32_t mWidth;
+		std::uint32_t mHeight;
+		QueuePolicy mPolicy;
+		std::FILE* mStream;
+
+		// Slots in submission order form a ring; the encoder takes them from the front.
+		std::vector<Slot> mSlots;
+		std::vector<std::uint32_t> mQueue;
+		std::uint32_t mQueueFront;
+		std::uint32_t mQueueCount;
+		Counters mTotals;
+		mutable std::mutex mMutex;
+		std::condition_variable mFrameQueued;
+		std::condition_variable mSlotFreed;
+		bool mShuttingDown;
+
+		// Encoder thread only.
+		std::vector<std::uint8_t> mEncodeBuffer;
+		std::vector<std::uint8_t> mRawImage;
+		std::vector<std::uint16_t> mChromaSums;
+
+		std::thread mEncoder;
+	};
+}
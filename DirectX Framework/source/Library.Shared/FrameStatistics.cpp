@@ -0,0 +1,162 @@
+#include "FrameStatistics.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <codecvt>
+#include <locale>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	FrameStatistics::FrameStatistics() :
+		mTicksPerSecond(Profiler::TimestampFrequency()), mMicrosecondsPerTick(1000000.0 / Profiler::TimestampFrequency()),
+		mWindowStart(Profiler::Timestamp()), mCurrentWindow(0), mWindowGeneration(0)
+	{
+	}
+
+	void FrameStatistics::Record(Metric metric, int64_t start, int64_t end)
+	{
+		if (end - mWindowStart >= mTicksPerSecond)
+		{
+			AdvanceWindow(end);
+		}
+
+		const uint32_t microseconds = static_cast<uint32_t>((end - start) * mMicrosecondsPerTick);
+		mMetrics[static_cast<uint32_t>(metric)].Windows[mCurrentWindow].Record(microseconds);
+	}
+
+	FrameStatistics::Summary FrameStatistics::WindowSummary(Metric metric) const
+	{
+		const MetricHistograms& histograms = mMetrics[static_cast<uint32_t>(metric)];
+
+		FrameTimeHistogram window;
+		for (const auto& histogram : histograms.Windows)
+		{
+			window.Add(histogram);
+		}
+
+		return Summarize(window);
+	}
+
+	FrameStatistics::Summary FrameStatistics::SessionSummary(Metric metric) const
+	{
+		const MetricHistograms& histograms = mMetrics[static_cast<uint32_t>(metric)];
+
+		// The session histogram is folded in once per second; include the window still being recorded.
+		FrameTimeHistogram session(histograms.Session);
+		session.Add(histograms.Windows[mCurrentWindow]);
+
+		return Summarize(session);
+	}
+
+	uint32_t FrameStatistics::WindowGeneration() const
+	{
+		return mWindowGeneration;
+	}
+
+	bool FrameStatistics::WriteReport(const wstring& filename) const
+	{
+#if defined(_WIN32)
+		ofstream stream(filename, ios::out | ios::trunc);
+#else
+		ofstream stream(wstring_convert<codecvt_utf8<wchar_t>>().to_bytes(filename), ios::out | ios::trunc);
+#endif
+		if (!stream.good())
+		{
+			return false;
+		}
+
+		stream.precision(3);
+		stream << fixed;
+		stream << "metric\tcount\tp50_ms\tp90_ms\tp99_ms\tp99.9_ms\tmax_ms\n";
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(Metric::Count); ++i)
+		{
+			const Metric metric = static_cast<Metric>(i);
+			const Summary summary = SessionSummary(metric);
+
+			stream << MetricName(metric) << '\t' << summary.Count << '\t' << summary.P50 << '\t' << summary.P90 << '\t'
+				<< summary.P99 << '\t' << summary.P999 << '\t' << summary.Max << '\n';
+		}
+
+		return stream.good();
+	}
+
+	const char* FrameStatistics::MetricName(Metric metric)
+	{
+		switch (metric)
+		{
+		case Metric::Update:
+			return "update";
+
+		case Metric::Render:
+			return "render";
+
+		case Metric::Present:
+			return "present";
+
+		case Metric::Frame:
+			return "frame";
+
+		case Metric::Capture:
+			return "capture";
+
+		case Metric::Text:
+			return "text";
+
+		default:
+			return "unknown";
+		}
+	}
+
+	void FrameStatistics::AdvanceWindow(int64_t timestamp)
+	{
+		// After a gap (a suspend, a breakpoint, a long load) every second that passed without frames is an empty window, so
+		// the frames before the gap expire on time. Past WindowCount of them all of the windows are empty.
+		const int64_t elapsedWindows = (timestamp - mWindowStart) / mTicksPerSecond;
+		const uint32_t clearedWindows = static_cast<uint32_t>(min<int64_t>(elapsedWindows, WindowCount));
+
+		// Folding and clearing touch every bucket, so histograms with nothing in them are skipped; most metrics record a
+		// sample or two a frame and some (capture, text) usually none.
+		for (auto& histograms : mMetrics)
+		{
+			if (histograms.Windows[mCurrentWindow].Count() > 0)
+			{
+				histograms.Session.Add(histograms.Windows[mCurrentWindow]);
+			}
+
+			for (uint32_t i = 1; i <= clearedWindows; ++i)
+			{
+				FrameTimeHistogram& window = histograms.Windows[(mCurrentWindow + i) % WindowCount];
+				if (window.Count() > 0)
+				{
+					window.Clear();
+				}
+			}
+		}
+
+		// Windows stay aligned to whole seconds from the first one, however late the frame that advances them.
+		mCurrentWindow = (mCurrentWindow + clearedWindows) % WindowCount;
+		mWindowStart += elapsedWindows * mTicksPerSecond;
+		mWindowGeneration += static_cast<uint32_t>(elapsedWindows);
+	}
+
+	FrameStatistics::Summary FrameStatistics::Summarize(const FrameTimeHistogram& histogram)
+	{
+		const double millisecondsPerMicrosecond = 0.001;
+
+		Summary summary;
+		summary.Count = histogram.Count();
+		summary.P50 = histogram.ValueAtPercentile(50.0) * millisecondsPerMicrosecond;
+		summary.P90 = histogram.ValueAtPercentile(90.0) * millisecondsPerMicrosecond;
+		summary.P99 = histogram.ValueAtPercentile(99.0) * millisecondsPerMicrosecond;
+		summary.P999 = histogram.ValueAtPercentile(99.9) * millisecondsPerMicrosecond;
+		summary.Max = histogram.Max() * millisecondsPerMicrosecond;
+
+		return summary;
+	}
+}
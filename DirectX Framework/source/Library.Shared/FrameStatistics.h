@@ -0,0 +1,77 @@
+#pragma once
+
+#include "FrameTimeHistogram.h"
+#include <cstdint>
+#include <string>
+
+namespace DX
+{
+	// Tracks per-frame update, render, present, whole-frame and frame capture durations over a sliding window of recent
+	// seconds and over the whole session, and reports percentiles for each. Timestamps come from DX::Profiler; like it, this
+	// file only depends on the C++ standard library and the OS timer.
+	class FrameStatistics final
+	{
+	public:
+		enum class Metric
+		{
+			Update,
+			Render,
+			Present,
+			Frame,
+			Capture,
+			Text,
+			Count
+		};
+
+		struct Summary
+		{
+			std::uint64_t Count;
+			double P50;
+			double P90;
+			double P99;
+			double P999;
+			double Max;
+		};
+
+		// Number of one-second sub-windows summarized by the sliding window.
+		static const std::uint32_t WindowCount = 10;
+
+		FrameStatistics();
+		FrameStatistics(const FrameStatistics&) = delete;
+		FrameStatistics& operator=(const FrameStatistics&) = delete;
+		FrameStatistics(FrameStatistics&&) = delete;
+		FrameStatistics& operator=(FrameStatistics&&) = delete;
+		~FrameStatistics() = default;
+
+		// Records a duration given as start and end timestamps from Profiler::Timestamp.
+		void Record(Metric metric, std::int64_t start, std::int64_t end);
+
+		// Summaries are reported in milliseconds.
+		Summary WindowSummary(Metric metric) const;
+		Summary SessionSummary(Metric metric) const;
+
+		// Advances by one for every second the sliding window moves on, including seconds in which nothing was recorded.
+		std::uint32_t WindowGeneration() const;
+
+		bool WriteReport(const std::wstring& filename) const;
+
+		static const char* MetricName(Metric metric);
+
+	private:
+		struct MetricHistograms
+		{
+			FrameTimeHistogram Windows[WindowCount];
+			FrameTimeHistogram Session;
+		};
+
+		void AdvanceWindow(std::int64_t timestamp);
+		static Summary Summarize(const FrameTimeHistogram& histogram);
+
+		MetricHistograms mMetrics[static_cast<std::uint32_t>(Metric::Count)];
+		std::int64_t mTicksPerSecond;
+		double mMicrosecondsPerTick;
+		std::int64_t mWindowStart;
+		std::uint32_t mCurrentWindow;
+		std::uint32_t mWindowGeneration;
+	};
+}
@@ -0,0 +1,124 @@
+#include "FrameTimeHistogram.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		inline uint32_t MostSignificantBit(uint32_t value)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanReverse(&index, value);
+			return index;
+#else
+			return 31 - __builtin_clz(value);
+#endif
+		}
+	}
+
+	FrameTimeHistogram::FrameTimeHistogram()
+	{
+		Clear();
+	}
+
+	void FrameTimeHistogram::Record(uint32_t microseconds)
+	{
+		++mCounts[BucketIndex(microseconds)];
+		++mCount;
+
+		if (microseconds > mMax)
+		{
+			mMax = microseconds;
+		}
+	}
+
+	void FrameTimeHistogram::Add(const FrameTimeHistogram& other)
+	{
+		for (uint32_t i = 0; i < BucketCount; ++i)
+		{
+			mCounts[i] += other.mCounts[i];
+		}
+
+		mCount += other.mCount;
+		mMax = max(mMax, other.mMax);
+	}
+
+	void FrameTimeHistogram::Clear()
+	{
+		memset(mCounts, 0, sizeof(mCounts));
+		mCount = 0;
+		mMax = 0;
+	}
+
+	uint64_t FrameTimeHistogram::Count() const
+	{
+		return mCount;
+	}
+
+	uint32_t FrameTimeHistogram::Max() const
+	{
+		return mMax;
+	}
+
+	uint32_t FrameTimeHistogram::ValueAtPercentile(double percentile) const
+	{
+		if (mCount == 0)
+		{
+			return 0;
+		}
+
+		// Rank of the requested sample, 1-based and rounded up so that p100 is the last sample.
+		const double clampedPercentile = min(max(percentile, 0.0), 100.0);
+		const uint64_t rank = max(static_cast<uint64_t>(clampedPercentile / 100.0 * mCount + 0.999999), static_cast<uint64_t>(1));
+
+		uint64_t cumulativeCount = 0;
+		for (uint32_t i = 0; i < BucketCount; ++i)
+		{
+			cumulativeCount += mCounts[i];
+			if (cumulativeCount >= rank)
+			{
+				return min(BucketUpperBound(i), mMax);
+			}
+		}
+
+		return mMax;
+	}
+
+	uint32_t FrameTimeHistogram::BucketIndex(uint32_t microseconds)
+	{
+		if (microseconds < LinearBucketCount)
+		{
+			return microseconds;
+		}
+
+		const uint32_t maxValue = (1U << MaxValueBits) - 1;
+		const uint32_t value = min(microseconds, maxValue);
+
+		// Keep the top SubBucketBits + 1 bits; the leading one selects the magnitude, the rest select the sub-bucket.
+		const uint32_t shift = MostSignificantBit(value) - SubBucketBits;
+		const uint32_t subBucket = (value >> shift) - SubBucketCount;
+
+		return LinearBucketCount + (shift - 1) * SubBucketCount + subBucket;
+	}
+
+	uint32_t FrameTimeHistogram::BucketUpperBound(uint32_t index)
+	{
+		if (index < LinearBucketCount)
+		{
+			return index;
+		}
+
+		const uint32_t shift = (index - LinearBucketCount) / SubBucketCount + 1;
+		const uint32_t subBucket = (index - LinearBucketCount) % SubBucketCount + SubBucketCount;
+
+		return ((subBucket + 1) << shift) - 1;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace DX
+{
+	// Fixed-size, log-linear histogram of durations in microseconds (in the style of HdrHistogram).
+	// Values below 64us are recorded exactly; larger values keep 5 significant bits (about 3% precision).
+	// Recording never allocates. This file only depends on the C++ standard library.
+	class FrameTimeHistogram final
+	{
+	public:
+		static const std::uint32_t SubBucketBits = 5;
+		static const std::uint32_t SubBucketCount = 1 << SubBucketBits;
+		static const std::uint32_t LinearBucketCount = SubBucketCount * 2;
+		static const std::uint32_t MaxValueBits = 24; // Values are clamped to roughly 16.7 seconds
+		static const std::uint32_t BucketCount = LinearBucketCount + (MaxValueBits - SubBucketBits - 1) * SubBucketCount;
+
+		FrameTimeHistogram();
+
+		void Record(std::uint32_t microseconds);
+		void Add(const FrameTimeHistogram& other);
+		void Clear();
+
+		std::uint64_t Count() const;
+		std::uint32_t Max() const;
+
+		// Returns the upper bound of the bucket containing the requested percentile (0-100), in microseconds.
+		std::uint32_t ValueAtPercentile(double percentile) const;
+
+		static std::uint32_t BucketIndex(std::uint32_t microseconds);
+		static std::uint32_t BucketUpperBound(std::uint32_t index);
+
+	private:
+		std::uint32_t mCounts[BucketCount];
+		std::uint64_t mCount;
+		std::uint32_t mMax;
+	};
+}
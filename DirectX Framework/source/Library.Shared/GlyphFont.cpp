@@ -0,0 +1,106 @@
+#include "GlyphFont.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DX
+{
+	const uint32_t GlyphFont::Magic = 0x46475844;	// "DXGF"
+	const uint32_t GlyphFont::FileVersion = 1;
+
+	static_assert(sizeof(GlyphFont::Header) == 48 && sizeof(GlyphFont::Glyph) == 40, "the glyph table's layout is part of its file format");
+
+	GlyphFont::GlyphFont(const AssetLoader::AssetPointer& data) :
+		mData(data), mHeader(nullptr), mGlyphs(nullptr), mFallback(nullptr)
+	{
+		if (mData == nullptr || mData->Size() < sizeof(Header))
+		{
+			throw runtime_error("GlyphFont: the table is too small");
+		}
+
+		const uint8_t* bytes = mData->Data();
+		if (reinterpret_cast<uintptr_t>(bytes) % alignof(Glyph) != 0)
+		{
+			throw runtime_error("GlyphFont: the table is misaligned");
+		}
+
+		mHeader = reinterpret_cast<const Header*>(bytes);
+		if (mHeader->Magic != Magic || mHeader->FileVersion != FileVersion)
+		{
+			throw runtime_error("GlyphFont: not a glyph table, or from another version of FontBaker");
+		}
+
+		if (sizeof(Header) + static_cast<uint64_t>(mHeader->GlyphCount) * sizeof(Glyph) != mData->Size() || mHeader->GlyphCount == 0 ||
+			mHeader->TextureWidth == 0 || mHeader->TextureHeight == 0 || !(mHeader->LineHeight > 0.0f))
+		{
+			throw runtime_error("GlyphFont: the table's size doesn't match its header");
+		}
+
+		mGlyphs = reinterpret_cast<const Glyph*>(bytes + sizeof(Header));
+		mFallback = Lookup('?');
+	}
+
+	float GlyphFont::PixelSize() const
+	{
+		return mHeader->PixelSize;
+	}
+
+	float GlyphFont::LineHeight() const
+	{
+		return mHeader->LineHeight;
+	}
+
+	float GlyphFont::Ascent() const
+	{
+		return mHeader->Ascent;
+	}
+
+	uint32_t GlyphFont::TextureWidth() const
+	{
+		return mHeader->TextureWidth;
+	}
+
+	uint32_t GlyphFont::TextureHeight() const
+	{
+		return mHeader->TextureHeight;
+	}
+
+	const GlyphFont::Glyph* GlyphFont::Find(char character) const
+	{
+		const Glyph* glyph = Lookup(static_cast<uint8_t>(character));
+		return (glyph != nullptr ? glyph : mFallback);
+	}
+
+	const GlyphFont::Glyph* GlyphFont::Lookup(uint32_t character) const
+	{
+		// Characters below the first wrap around to large indices, so one comparison covers both ends of the range.
+		const uint32_t index = character - mHeader->FirstCharacter;
+		return (index < mHeader->GlyphCount ? &mGlyphs[index] : nullptr);
+	}
+
+	vector<uint8_t> GlyphFont::Serialize(uint32_t firstCharacter, const vector<Glyph>& glyphs, uint32_t textureWidth, uint32_t textureHeight,
+		float pixelSize, float lineHeight, float ascent)
+	{
+		if (glyphs.empty())
+		{
+			throw runtime_error("GlyphFont: a glyph table needs at least one glyph");
+		}
+
+		Header header = {};
+		header.Magic = Magic;
+		header.FileVersion = FileVersion;
+		header.FirstCharacter = firstCharacter;
+		header.GlyphCount = static_cast<uint32_t>(glyphs.size());
+		header.TextureWidth = textureWidth;
+		header.TextureHeight = textureHeight;
+		header.PixelSize = pixelSize;
+		header.LineHeight = lineHeight;
+		header.Ascent = ascent;
+
+		vector<uint8_t> table(sizeof(Header) + glyphs.size() * sizeof(Glyph));
+		memcpy(table.data(), &header, sizeof(header));
+		memcpy(table.data() + sizeof(header), glyphs.data(), glyphs.size() * sizeof(Glyph));
+		return table;
+	}
+}
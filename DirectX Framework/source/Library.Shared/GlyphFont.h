@@ -0,0 +1,79 @@
+#pragma once
+
+#include "AssetLoader.h"
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// The glyph table of a bitmap font baked into a texture atlas: for each character of a contiguous range, where its
+	// bitmap is in the atlas and how it sits on the baseline. FontBaker writes the table next to the atlas texture. At run
+	// time the table is used in place, straight from the loaded file, so looking a glyph up is an index. Metrics are in
+	// pixels at the size the font was baked at, with y down. This file only depends on the C++ standard library and the
+	// AssetLoader.
+	//
+	// File layout, little-endian: a Header, then GlyphCount Glyphs for the characters FirstCharacter onwards.
+	class GlyphFont final
+	{
+	public:
+		struct Header
+		{
+			std::uint32_t Magic;
+			std::uint32_t FileVersion;
+			std::uint32_t FirstCharacter;
+			std::uint32_t GlyphCount;
+			std::uint32_t TextureWidth;
+			std::uint32_t TextureHeight;
+			float PixelSize;			// Em size the font was baked at
+			float LineHeight;			// Baseline to baseline
+			float Ascent;				// Top of a line to its baseline
+			std::uint32_t Reserved[3];
+		};
+
+		struct Glyph
+		{
+			float U0;					// Top left and bottom right of the bitmap, excluding its padding
+			float V0;
+			float U1;
+			float V1;
+			float Left;					// From the pen position on the baseline to the bitmap's top left
+			float Top;
+			float Width;				// Of the bitmap; zero for blanks such as the space
+			float Height;
+			float Advance;				// To the next pen position
+			std::uint32_t Reserved;
+		};
+
+		static const std::uint32_t Magic;
+		static const std::uint32_t FileVersion;
+
+		// Throws std::runtime_error if data isn't a well-formed table. The table holds a reference to data.
+		explicit GlyphFont(const AssetLoader::AssetPointer& data);
+		GlyphFont(const GlyphFont&) = delete;
+		GlyphFont& operator=(const GlyphFont&) = delete;
+		GlyphFont(GlyphFont&&) = default;
+		GlyphFont& operator=(GlyphFont&&) = default;
+		~GlyphFont() = default;
+
+		float PixelSize() const;
+		float LineHeight() const;
+		float Ascent() const;
+		std::uint32_t TextureWidth() const;
+		std::uint32_t TextureHeight() const;
+
+		// Returns the fallback glyph, '?', for characters outside the table, or null if the table doesn't have one either.
+		const Glyph* Find(char character) const;
+
+		// Builds a table for the characters firstCharacter onwards. Throws std::runtime_error for an empty glyph list.
+		static std::vector<std::uint8_t> Serialize(std::uint32_t firstCharacter, const std::vector<Glyph>& glyphs, std::uint32_t textureWidth,
+			std::uint32_t textureHeight, float pixelSize, float lineHeight, float ascent);
+
+	private:
+		const Glyph* Lookup(std::uint32_t character) const;
+
+		AssetLoader::AssetPointer mData;
+		const Header* mHeader;
+		const Glyph* mGlyphs;
+		const Glyph* mFallback;
+	};
+}
@@ -0,0 +1,143 @@
+#include "GlyphText.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace DX
+{
+	GlyphText::GlyphText(Alignment alignment, uint32_t capacity) :
+		mAlignment(alignment), mFont(nullptr), mChanged(true), mWidth(0.0f), mHeight(0.0f)
+	{
+		mText.reserve(capacity);
+		mGlyphs.reserve(capacity);
+	}
+
+	bool GlyphText::SetText(const char* text)
+	{
+		if (strcmp(mText.c_str(), text) == 0)
+		{
+			return false;
+		}
+
+		mText.assign(text);
+		mChanged = true;
+		return true;
+	}
+
+	const string& GlyphText::Text() const
+	{
+		return mText;
+	}
+
+	bool GlyphText::Layout(const GlyphFont& font)
+	{
+		if (!mChanged && mFont == &font)
+		{
+			return false;
+		}
+
+		mFont = &font;
+		mChanged = false;
+		mGlyphs.clear();
+		mWidth = 0.0f;
+
+		// Right-aligned lines are laid out ending at zero, then the whole block is moved right by its width.
+		uint32_t lineCount = 1;
+		size_t lineStart = 0;
+		float pen = 0.0f;
+		float baseline = font.Ascent();
+		const auto endLine = [this, &lineStart, &pen]() {
+			if (mAlignment == Alignment::Right)
+			{
+				for (size_t i = lineStart; i < mGlyphs.size(); ++i)
+				{
+					mGlyphs[i].Position[0] -= pen;
+				}
+			}
+
+			mWidth = max(mWidth, pen);
+			lineStart = mGlyphs.size();
+			pen = 0.0f;
+		};
+
+		for (const char character : mText)
+		{
+			if (character == '\n')
+			{
+				endLine();
+				baseline += font.LineHeight();
+				++lineCount;
+				continue;
+			}
+
+			const GlyphFont::Glyph* glyph = font.Find(character);
+			if (glyph == nullptr)
+			{
+				continue;
+			}
+
+			if (glyph->Width > 0.0f && glyph->Height > 0.0f)
+			{
+				const float left = floor(pen + glyph->Left + 0.5f);
+				const float top = floor(baseline + glyph->Top + 0.5f);
+				SpriteInstance quad;
+				quad.Position[0] = left + glyph->Width * 0.5f;
+				quad.Position[1] = top + glyph->Height * 0.5f;
+				quad.Scale[0] = glyph->Width * 0.5f;
+				quad.Scale[1] = glyph->Height * -0.5f;
+				quad.UVRect[0] = glyph->U0;
+				quad.UVRect[1] = glyph->V0;
+				quad.UVRect[2] = glyph->U1;
+				quad.UVRect[3] = glyph->V1;
+				quad.Rotation = 0.0f;
+				mGlyphs.push_back(quad);
+			}
+
+			pen += glyph->Advance;
+		}
+
+		endLine();
+		mHeight = static_cast<float>(lineCount) * font.LineHeight();
+		if (mAlignment == Alignment::Right)
+		{
+			for (SpriteInstance& quad : mGlyphs)
+			{
+				quad.Position[0] += mWidth;
+			}
+		}
+
+		return true;
+	}
+
+	float GlyphText::Width() const
+	{
+		return mWidth;
+	}
+
+	float GlyphText::Height() const
+	{
+		return mHeight;
+	}
+
+	uint32_t GlyphText::GlyphCount() const
+	{
+		return static_cast<uint32_t>(mGlyphs.size());
+	}
+
+	void GlyphText::Draw(SpriteBatch& batch, SpriteTextureHandle texture, float x, float y, float scale) const
+	{
+		x = floor(x + 0.5f);
+		y = floor(y + 0.5f);
+		for (const SpriteInstance& glyph : mGlyphs)
+		{
+			SpriteInstance quad = glyph;
+			quad.Position[0] = x + glyph.Position[0] * scale;
+			quad.Position[1] = y + glyph.Position[1] * scale;
+			quad.Scale[0] = glyph.Scale[0] * scale;
+			quad.Scale[1] = glyph.Scale[1] * scale;
+			batch.Draw(texture, quad);
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "GlyphFont.h"
+#include "SpriteBatch.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	// A block of text laid out as glyph quads from a GlyphFont, ready to go into a SpriteBatch with the font's atlas. The
+	// layout is only redone when the text or the font changes, so drawing text that stays the same, such as a score between
+	// points, is a copy of its quads. Lines break at '\n' and are aligned to the block's left or right edge; glyphs are
+	// placed on whole pixels, without kerning.
+	//
+	// Positions are in pixels with y down. The quads' y scale is negative, so the top of each glyph's bitmap stays at the
+	// top under a projection that flips y to clip space. This file only depends on the C++ standard library.
+	class GlyphText final
+	{
+	public:
+		enum class Alignment
+		{
+			Left,
+			Right
+		};
+
+		static const std::uint32_t DefaultCapacity = 64;
+
+		// Setting and laying out text of up to capacity characters doesn't allocate.
+		explicit GlyphText(Alignment alignment = Alignment::Left, std::uint32_t capacity = DefaultCapacity);
+		GlyphText(const GlyphText&) = delete;
+		GlyphText& operator=(const GlyphText&) = delete;
+		GlyphText(GlyphText&&) = default;
+		GlyphText& operator=(GlyphText&&) = default;
+		~GlyphText() = default;
+
+		// Returns false, keeping the layout, if the text is already text.
+		bool SetText(const char* text);
+		const std::string& Text() const;
+
+		// Lays the text out in font if the text or the font changed since the last layout. Returns whether it did.
+		bool Layout(const GlyphFont& font);
+
+		// The size of the block as last laid out, at the font's baked size.
+		float Width() const;
+		float Height() const;
+		std::uint32_t GlyphCount() const;
+
+		// Draws the last layout with the block's top left at x, y, rounded to whole pixels, and scale times the baked size.
+		void Draw(SpriteBatch& batch, SpriteTextureHandle texture, float x, float y, float scale = 1.0f) const;
+
+	private:
+		Alignment mAlignment;
+		std::string mText;
+		const GlyphFont* mFont;
+		bool mChanged;
+		std::vector<SpriteInstance> mGlyphs;
+		float mWidth;
+		float mHeight;
+	};
+}
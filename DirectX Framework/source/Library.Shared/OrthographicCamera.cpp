@@ -45,5 +45,6 @@ namespace DX
     {
 		XMMATRIX projectionMatrix = XMMatrixOrthographicRH(mViewWidth, mViewHeight, mNearPlaneDistance, mFarPlaneDistance);
         XMStoreFloat4x4(&mProjectionMatrix, projectionMatrix);
+		UpdateViewProjectionMatrix();
     }
 }
@@ -0,0 +1,348 @@
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if !defined(DX_PARTICLE_SYSTEM_SCALAR) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define DX_PARTICLE_SYSTEM_SSE2
+#include <emmintrin.h>
+#elif !defined(DX_PARTICLE_SYSTEM_SCALAR) && (defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON))
+#define DX_PARTICLE_SYSTEM_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		// Arrays handed to the four-wide helpers below are read and written at index i through i + 3.
+		struct Arrays
+		{
+			float* PositionX;
+			float* PositionY;
+			float* VelocityX;
+			float* VelocityY;
+			float* Life;
+		};
+
+		struct Constants
+		{
+			float Seconds;
+			float Damping;
+			float GravityX;
+			float GravityY;
+		};
+
+		inline void IntegrateOne(const Arrays& arrays, const Constants& constants, uint32_t i)
+		{
+			arrays.VelocityX[i] = arrays.VelocityX[i] * constants.Damping + constants.GravityX;
+			arrays.VelocityY[i] = arrays.VelocityY[i] * constants.Damping + constants.GravityY;
+			arrays.PositionX[i] += arrays.VelocityX[i] * constants.Seconds;
+			arrays.PositionY[i] += arrays.VelocityY[i] * constants.Seconds;
+			arrays.Life[i] -= constants.Seconds;
+		}
+
+		inline float LifeFraction(float life, float inverseLifetime)
+		{
+			return min(max(life * inverseLifetime, 0.0f), 1.0f);
+		}
+
+		inline void WriteOne(ParticleInstance& instance, float x, float y, float radius, uint32_t color, float fraction)
+		{
+			instance.Position[0] = x;
+			instance.Position[1] = y;
+			instance.Radius = radius * fraction;
+			const uint32_t alpha = static_cast<uint32_t>(static_cast<float>(color >> 24) * fraction + 0.5f);
+			instance.Color = (color & 0x00FFFFFF) | (alpha << 24);
+		}
+
+		// Integrate4 damps and accelerates the velocity before it moves the particle (semi-implicit Euler), as IntegrateOne
+		// does; gravity in constants is already scaled by the step. DeadBits returns one bit per lane whose life ran out,
+		// lane 0 in bit 0.
+#if defined(DX_PARTICLE_SYSTEM_SSE2)
+		inline void Integrate4(const Arrays& arrays, const Constants& constants, uint32_t i)
+		{
+			const __m128 seconds = _mm_set1_ps(constants.Seconds);
+			const __m128 damping = _mm_set1_ps(constants.Damping);
+			const __m128 velocityX = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(arrays.VelocityX + i), damping), _mm_set1_ps(constants.GravityX));
+			const __m128 velocityY = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(arrays.VelocityY + i), damping), _mm_set1_ps(constants.GravityY));
+			_mm_storeu_ps(arrays.VelocityX + i, velocityX);
+			_mm_storeu_ps(arrays.VelocityY + i, velocityY);
+			_mm_storeu_ps(arrays.PositionX + i, _mm_add_ps(_mm_loadu_ps(arrays.PositionX + i), _mm_mul_ps(velocityX, seconds)));
+			_mm_storeu_ps(arrays.PositionY + i, _mm_add_ps(_mm_loadu_ps(arrays.PositionY + i), _mm_mul_ps(velocityY, seconds)));
+			_mm_storeu_ps(arrays.Life + i, _mm_sub_ps(_mm_loadu_ps(arrays.Life + i), seconds));
+		}
+
+		inline uint32_t DeadBits(const float* life)
+		{
+			return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(life), _mm_setzero_ps())));
+		}
+
+		// Four instances at once: the attributes are faded, then transposed from arrays into structures.
+		inline void Write4(ParticleInstance* instances, const float* x, const float* y, const float* radius, const uint32_t* color, const float* life, const float* inverseLifetime)
+		{
+			const __m128 fraction = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(life), _mm_loadu_ps(inverseLifetime)), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+			const __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(color));
+			const __m128 alpha = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(colors, 24)), fraction), _mm_set1_ps(0.5f));
+			const __m128i faded = _mm_or_si128(_mm_and_si128(colors, _mm_set1_epi32(0x00FFFFFF)), _mm_slli_epi32(_mm_cvttps_epi32(alpha), 24));
+
+			__m128 row0 = _mm_loadu_ps(x);
+			__m128 row1 = _mm_loadu_ps(y);
+			__m128 row2 = _mm_mul_ps(_mm_loadu_ps(radius), fraction);
+			__m128 row3 = _mm_castsi128_ps(faded);
+			_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+			float* destination = reinterpret_cast<float*>(instances);
+			_mm_storeu_ps(destination, row0);
+			_mm_storeu_ps(destination + 4, row1);
+			_mm_storeu_ps(destination + 8, row2);
+			_mm_storeu_ps(destination + 12, row3);
+		}
+#elif defined(DX_PARTICLE_SYSTEM_NEON)
+		inline void Integrate4(const Arrays& arrays, const Constants& constants, uint32_t i)
+		{
+			const float32x4_t seconds = vdupq_n_f32(constants.Seconds);
+			const float32x4_t damping = vdupq_n_f32(constants.Damping);
+			const float32x4_t velocityX = vmlaq_f32(vdupq_n_f32(constants.GravityX), vld1q_f32(arrays.VelocityX + i), damping);
+			const float32x4_t velocityY = vmlaq_f32(vdupq_n_f32(constants.GravityY), vld1q_f32(arrays.VelocityY + i), damping);
+			vst1q_f32(arrays.VelocityX + i, velocityX);
+			vst1q_f32(arrays.VelocityY + i, velocityY);
+			vst1q_f32(arrays.PositionX + i, vmlaq_f32(vld1q_f32(arrays.PositionX + i), velocityX, seconds));
+			vst1q_f32(arrays.PositionY + i, vmlaq_f32(vld1q_f32(arrays.PositionY + i), velocityY, seconds));
+			vst1q_f32(arrays.Life + i, vsubq_f32(vld1q_f32(arrays.Life + i), seconds));
+		}
+
+		inline uint32_t DeadBits(const float* life)
+		{
+			static const uint32_t bits[4] = { 1, 2, 4, 8 };
+			const uint32x4_t laneBits = vandq_u32(vcleq_f32(vld1q_f32(life), vdupq_n_f32(0.0f)), vld1q_u32(bits));
+			const uint32x2_t sums = vadd_u32(vget_low_u32(laneBits), vget_high_u32(laneBits));
+			return vget_lane_u32(sums, 0) | vget_lane_u32(sums, 1);
+		}
+
+		inline void Write4(ParticleInstance* instances, const float* x, const float* y, const float* radius, const uint32_t* color, const float* life, const float* inverseLifetime)
+		{
+			const float32x4_t fraction = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(life), vld1q_f32(inverseLifetime)), vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+			const uint32x4_t colors = vld1q_u32(color);
+			const float32x4_t alpha = vmlaq_f32(vdupq_n_f32(0.5f), vcvtq_f32_u32(vshrq_n_u32(colors, 24)), fraction);
+			const uint32x4_t faded = vorrq_u32(vandq_u32(colors, vdupq_n_u32(0x00FFFFFF)), vshlq_n_u32(vcvtq_u32_f32(alpha), 24));
+
+			float32x4x4_t rows;
+			rows.val[0] = vld1q_f32(x);
+			rows.val[1] = vld1q_f32(y);
+			rows.val[2] = vmulq_f32(vld1q_f32(radius), fraction);
+			rows.val[3] = vreinterpretq_f32_u32(faded);
+			vst4q_f32(reinterpret_cast<float*>(instances), rows);
+		}
+#else
+		inline void Integrate4(const Arrays& arrays, const Constants& constants, uint32_t i)
+		{
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				IntegrateOne(arrays, constants, i + lane);
+			}
+		}
+
+		inline uint32_t DeadBits(const float* life)
+		{
+			uint32_t bits = 0;
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				bits |= (life[lane] <= 0.0f ? 1u : 0u) << lane;
+			}
+
+			return bits;
+		}
+
+		inline void Write4(ParticleInstance* instances, const float* x, const float* y, const float* radius, const uint32_t* color, const float* life, const float* inverseLifetime)
+		{
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				WriteOne(instances[lane], x[lane], y[lane], radius[lane], color[lane], LifeFraction(life[lane], inverseLifetime[lane]));
+			}
+		}
+#endif
+	}
+
+	ParticleSystem::ParticleSystem(uint32_t capacity, uint32_t seed) :
+		mCapacity(capacity), mLiveCount(0), mGravity(), mDrag(0.0f), mRandomState(seed != 0 ? seed : 1),
+		mPositionX(capacity), mPositionY(capacity), mVelocityX(capacity), mVelocityY(capacity),
+		mLife(capacity), mInverseLifetime(capacity), mRadius(capacity), mColor(capacity),
+		mTotals(), mLastUpdate(), mPending()
+	{
+		if (capacity == 0)
+		{
+			throw invalid_argument("ParticleSystem: capacity must be at least one");
+		}
+	}
+
+	void ParticleSystem::SetGravity(float x, float y)
+	{
+		mGravity[0] = x;
+		mGravity[1] = y;
+	}
+
+	void ParticleSystem::SetDrag(float drag)
+	{
+		mDrag = max(drag, 0.0f);
+	}
+
+	uint32_t ParticleSystem::Emit(const ParticleBurst& burst)
+	{
+		const uint32_t count = min(burst.Count, mCapacity - mLiveCount);
+		mPending.Emitted += count;
+		mPending.Dropped += burst.Count - count;
+
+		for (uint32_t k = 0; k < count; ++k)
+		{
+			const float direction = burst.Direction + (Random() - 0.5f) * burst.Spread;
+			const float speed = burst.MinSpeed + (burst.MaxSpeed - burst.MinSpeed) * Random();
+			const float lifetime = burst.MinLifetime + (burst.MaxLifetime - burst.MinLifetime) * Random();
+
+			// A particle without a lifetime is retired by the next update without being drawn.
+			const uint32_t i = mLiveCount++;
+			mPositionX[i] = burst.Position[0];
+			mPositionY[i] = burst.Position[1];
+			mVelocityX[i] = cos(direction) * speed;
+			mVelocityY[i] = sin(direction) * speed;
+			mLife[i] = max(lifetime, 0.0f);
+			mInverseLifetime[i] = (lifetime > 0.0f ? 1.0f / lifetime : 0.0f);
+			mRadius[i] = burst.Radius;
+			mColor[i] = burst.Color;
+		}
+
+		return count;
+	}
+
+	void ParticleSystem::Update(float seconds)
+	{
+		const Arrays arrays = { mPositionX.data(), mPositionY.data(), mVelocityX.data(), mVelocityY.data(), mLife.data() };
+		const Constants constants = { seconds, max(1.0f - mDrag * seconds, 0.0f), mGravity[0] * seconds, mGravity[1] * seconds };
+
+		const uint32_t groupEnd = mLiveCount & ~3u;
+		for (uint32_t i = 0; i < groupEnd; i += 4)
+		{
+			Integrate4(arrays, constants, i);
+		}
+
+		for (uint32_t i = groupEnd; i < mLiveCount; ++i)
+		{
+			IntegrateOne(arrays, constants, i);
+		}
+
+		const uint32_t liveBefore = mLiveCount;
+		Retire();
+
+		Counters counters = mPending;
+		counters.Updates = 1;
+		counters.Expired = liveBefore - mLiveCount;
+		counters.Live = mLiveCount;
+		mPending = Counters();
+
+		mLastUpdate = counters;
+		mTotals.Updates += counters.Updates;
+		mTotals.Emitted += counters.Emitted;
+		mTotals.Dropped += counters.Dropped;
+		mTotals.Expired += counters.Expired;
+		mTotals.Live += counters.Live;
+	}
+
+	void ParticleSystem::Clear()
+	{
+		mLiveCount = 0;
+	}
+
+	uint32_t ParticleSystem::Capacity() const
+	{
+		return mCapacity;
+	}
+
+	uint32_t ParticleSystem::LiveCount() const
+	{
+		return mLiveCount;
+	}
+
+	uint32_t ParticleSystem::WriteInstances(ParticleInstance* instances, uint32_t capacity) const
+	{
+		const uint32_t count = min(capacity, mLiveCount);
+		const uint32_t groupEnd = count & ~3u;
+		for (uint32_t i = 0; i < groupEnd; i += 4)
+		{
+			Write4(instances + i, &mPositionX[i], &mPositionY[i], &mRadius[i], &mColor[i], &mLife[i], &mInverseLifetime[i]);
+		}
+
+		for (uint32_t i = groupEnd; i < count; ++i)
+		{
+			WriteOne(instances[i], mPositionX[i], mPositionY[i], mRadius[i], mColor[i], LifeFraction(mLife[i], mInverseLifetime[i]));
+		}
+
+		return count;
+	}
+
+	const ParticleSystem::Counters& ParticleSystem::Totals() const
+	{
+		return mTotals;
+	}
+
+	const ParticleSystem::Counters& ParticleSystem::LastUpdate() const
+	{
+		return mLastUpdate;
+	}
+
+	void ParticleSystem::ResetCounters()
+	{
+		mTotals = Counters();
+		mLastUpdate = Counters();
+	}
+
+	void ParticleSystem::WriteReport(ostream& stream) const
+	{
+		stream << "updates\t" << mTotals.Updates << '\n';
+		stream << "emitted\t" << mTotals.Emitted << '\n';
+		stream << "dropped\t" << mTotals.Dropped << '\n';
+		stream << "expired\t" << mTotals.Expired << '\n';
+		stream << "live\t" << mTotals.Live << '\n';
+	}
+
+	float ParticleSystem::Random()
+	{
+		// xorshift32; the top 24 bits make a float in [0, 1).
+		mRandomState ^= mRandomState << 13;
+		mRandomState ^= mRandomState >> 17;
+		mRandomState ^= mRandomState << 5;
+		return static_cast<float>(mRandomState >> 8) * (1.0f / 16777216.0f);
+	}
+
+	void ParticleSystem::Retire()
+	{
+		// Most groups of four have no dead particle and are skipped whole. A dead particle is overwritten by the last live
+		// one, which is then checked in its place.
+		uint32_t i = 0;
+		while (i < mLiveCount)
+		{
+			if (i + 4 <= mLiveCount && DeadBits(&mLife[i]) == 0)
+			{
+				i += 4;
+				continue;
+			}
+
+			if (mLife[i] > 0.0f)
+			{
+				++i;
+				continue;
+			}
+
+			const uint32_t last = --mLiveCount;
+			mPositionX[i] = mPositionX[last];
+			mPositionY[i] = mPositionY[last];
+			mVelocityX[i] = mVelocityX[last];
+			mVelocityY[i] = mVelocityY[last];
+			mLife[i] = mLife[last];
+			mInverseLifetime[i] = mInverseLifetime[last];
+			mRadius[i] = mRadius[last];
+			mColor[i] = mColor[last];
+		}
+	}
+}
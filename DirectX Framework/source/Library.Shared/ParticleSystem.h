@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+namespace DX
+{
+	// One particle as ParticleVS.hlsl reads it from the instance buffer: the center and half size of its quad, and its
+	// color as RGBA8 with red in the lowest byte.
+	struct ParticleInstance
+	{
+		float Position[2];
+		float Radius;
+		std::uint32_t Color;
+	};
+
+	static_assert(std::is_trivially_copyable<ParticleInstance>::value && sizeof(ParticleInstance) == 16, "ParticleInstance must match the shader's instance layout.");
+
+	// A burst of particles from one point, such as a brick breaking. Each particle leaves in a random direction within
+	// Spread of Direction, at a random speed and with a random lifetime between the bounds. Its radius and opacity fall
+	// from Radius and the color's alpha to zero over its life.
+	struct ParticleBurst
+	{
+		float Position[2];
+		std::uint32_t Count;
+		float Direction;		// Radians counterclockwise from +x
+		float Spread;			// Radians across the whole cone; 2 pi for every direction
+		float MinSpeed;			// Units per second
+		float MaxSpeed;
+		float MinLifetime;		// Seconds
+		float MaxLifetime;
+		float Radius;
+		std::uint32_t Color;	// RGBA8, red in the lowest byte
+	};
+
+	// Simulates particles in a fixed pool stored as separate arrays per attribute: positions, velocities, remaining life,
+	// inverse lifetime, radius and color. Live particles are kept packed at the front of the arrays, so integration and
+	// instance writing stream through them four at a time: SSE2 on x86 and x64, NEON on ARM, and plain C++ elsewhere or
+	// when DX_PARTICLE_SYSTEM_SCALAR is defined. A particle that dies is replaced by the last live one.
+	//
+	// Emitting into a full pool drops the particles that don't fit, so a large combo never allocates. This file only
+	// depends on the C++ standard library.
+	class ParticleSystem final
+	{
+	public:
+		struct Counters
+		{
+			std::uint64_t Updates;
+			std::uint64_t Emitted;
+			std::uint64_t Dropped;		// Emitted into a full pool
+			std::uint64_t Expired;
+			std::uint64_t Live;			// After each update, summed over updates
+		};
+
+		static const std::uint32_t DefaultCapacity = 4096;
+
+		explicit ParticleSystem(std::uint32_t capacity = DefaultCapacity, std::uint32_t seed = 1);
+		ParticleSystem(const ParticleSystem&) = delete;
+		ParticleSystem& operator=(const ParticleSystem&) = delete;
+		ParticleSystem(ParticleSystem&&) = default;
+		ParticleSystem& operator=(ParticleSystem&&) = default;
+		~ParticleSystem() = default;
+
+		// Acceleration applied to every particle, in units per second squared, and the fraction of its velocity a particle
+		// loses per second.
+		void SetGravity(float x, float y);
+		void SetDrag(float drag);
+
+		// Returns the number of particles emitted, which is less than the burst's count when the pool fills up.
+		std::uint32_t Emit(const ParticleBurst& burst);
+
+		// Advances every particle by seconds and retires the ones whose life ran out.
+		void Update(float seconds);
+		void Clear();
+
+		std::uint32_t Capacity() const;
+		std::uint32_t LiveCount() const;
+
+		// Writes up to capacity live particles, faded by their remaining life, and returns how many were written.
+		std::uint32_t WriteInstances(ParticleInstance* instances, std::uint32_t capacity) const;
+
+		// The last update's counters include the emits since the update before it.
+		const Counters& Totals() const;
+		const Counters& LastUpdate() const;
+		void ResetCounters();
+
+		void WriteReport(std::ostream& stream) const;
+
+	private:
+		float Random();
+		void Retire();
+
+		std::uint32_t mCapacity;
+		std::uint32_t mLiveCount;
+		float mGravity[2];
+		float mDrag;
+		std::uint32_t mRandomState;
+
+		std::vector<float> mPositionX;
+		std::vector<float> mPositionY;
+		std::vector<float> mVelocityX;
+		std::vector<float> mVelocityY;
+		std::vector<float> mLife;				// Seconds left
+		std::vector<float> mInverseLifetime;	// So the fraction of life left is a multiply
+		std::vector<float> mRadius;				// At emission
+		std::vector<std::uint32_t> mColor;		// At emission
+
+		Counters mTotals;
+		Counters mLastUpdate;
+		Counters mPending;		// Emits since the last update
+	};
+}
@@ -0,0 +1,230 @@
+#include "pch.h"
+#include "PipelineCache.h"
+#include "DeviceResources.h"
+#include <fstream>
+
+using namespace std;
+using namespace Microsoft::WRL;
+using namespace Concurrency;
+
+namespace DX
+{
+	PipelineCache::PipelineCache(const shared_ptr<DeviceResources>& deviceResources, const shared_ptr<D3D11RenderBackend>& renderBackend) :
+		mDeviceResources(deviceResources), mRenderBackend(renderBackend), mTotals(), mFirstRequestTimestamp(0), mLastReadyTimestamp(0)
+	{
+	}
+
+	task<shared_ptr<const PipelineCache::Pipeline>> PipelineCache::GetPipelineAsync(const Description& description)
+	{
+		const Key key = MakeKey(description);
+
+		lock_guard<mutex> lock(mMutex);
+		if (mTotals.PipelineRequests++ == 0)
+		{
+			mFirstRequestTimestamp = Profiler::Timestamp();
+		}
+
+		auto found = mPipelines.find(key);
+		if (found != mPipelines.end())
+		{
+			PipelineEntry& entry = found->second;
+			if (entry.Loading)
+			{
+				++mTotals.PipelineHits;
+				return entry.Load;
+			}
+
+			shared_ptr<const Pipeline> pipeline = entry.Loaded.lock();
+			if (pipeline != nullptr)
+			{
+				++mTotals.PipelineHits;
+				return task_from_result(pipeline);
+			}
+		}
+
+		auto vertexShaderTask = GetVertexShaderAsync(description.VertexShader);
+		auto pixelShaderTask = GetPixelShaderAsync(description.PixelShader);
+
+		PipelineEntry& entry = mPipelines[key];
+		entry.Loading = true;
+		entry.Loaded.reset();
+
+		// The shader tasks come from ReadDataAsync, so their continuations are apartment-aware: they are marshaled back to the
+		// calling UI thread and run once it returns to its message loop, never inline here. CreatePipeline therefore can't
+		// take the lock before this function releases it, and it registers the pipeline with the render backend on the
+		// thread that renders.
+		entry.Load = vertexShaderTask.then([this, pixelShaderTask, key, description](const VertexShader& vertexShader) {
+			return pixelShaderTask.then([this, vertexShader, key, description](const ComPtr<ID3D11PixelShader>& pixelShader) {
+				return CreatePipeline(key, description, vertexShader, pixelShader);
+			});
+		});
+
+		return entry.Load;
+	}
+
+	void PipelineCache::ReleaseDeviceDependentResources()
+	{
+		lock_guard<mutex> lock(mMutex);
+		mVertexShaders.clear();
+		mPixelShaders.clear();
+		mPipelines.clear();
+	}
+
+	PipelineCache::Counters PipelineCache::Totals() const
+	{
+		lock_guard<mutex> lock(mMutex);
+		Counters totals = mTotals;
+
+		totals.LoadMilliseconds = (mLastReadyTimestamp - mFirstRequestTimestamp) * 1000.0 / Profiler::TimestampFrequency();
+		totals.LivePipelines = 0;
+		for (const auto& entry : mPipelines)
+		{
+			if (!entry.second.Loaded.expired())
+			{
+				++totals.LivePipelines;
+			}
+		}
+
+		return totals;
+	}
+
+	bool PipelineCache::WriteReport(const wstring& filename) const
+	{
+		ofstream stream(filename, ios::out | ios::trunc);
+		if (!stream.good())
+		{
+			return false;
+		}
+
+		const Counters totals = Totals();
+		stream.precision(3);
+		stream << fixed;
+		stream << "shader_file_loads\t" << totals.ShaderFileLoads << '\n';
+		stream << "device_objects_created\t" << totals.DeviceObjectsCreated << '\n';
+		stream << "pipeline_requests\t" << totals.PipelineRequests << '\n';
+		stream << "pipeline_hits\t" << totals.PipelineHits << '\n';
+		stream << "live_pipelines\t" << totals.LivePipelines << '\n';
+		stream << "load_ms\t" << totals.LoadMilliseconds << '\n';
+
+		return stream.good();
+	}
+
+	PipelineCache::Key PipelineCache::MakeKey(const Description& description)
+	{
+		return Key(description.VertexShader, description.PixelShader, description.InputElements, description.InputElementCount,
+			static_cast<uint32_t>(description.Topology), description.VertexConstantBufferSize, description.PixelConstantBufferSize, description.AlphaBlend);
+	}
+
+	task<PipelineCache::VertexShader> PipelineCache::GetVertexShaderAsync(const wstring& filename)
+	{
+		auto found = mVertexShaders.find(filename);
+		if (found != mVertexShaders.end())
+		{
+			return found->second;
+		}
+
+		++mTotals.ShaderFileLoads;
+		auto createTask = ReadDataAsync(filename).then([this](const vector<byte>& fileData) {
+			VertexShader vertexShader;
+			vertexShader.Bytecode = make_shared<const vector<byte>>(fileData);
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateVertexShader(&fileData[0], fileData.size(), nullptr, vertexShader.Shader.ReleaseAndGetAddressOf()));
+
+			lock_guard<mutex> lock(mMutex);
+			++mTotals.DeviceObjectsCreated;
+
+			return vertexShader;
+		});
+
+		mVertexShaders.emplace(filename, createTask);
+		return createTask;
+	}
+
+	task<ComPtr<ID3D11PixelShader>> PipelineCache::GetPixelShaderAsync(const wstring& filename)
+	{
+		auto found = mPixelShaders.find(filename);
+		if (found != mPixelShaders.end())
+		{
+			return found->second;
+		}
+
+		++mTotals.ShaderFileLoads;
+		auto createTask = ReadDataAsync(filename).then([this](const vector<byte>& fileData) {
+			ComPtr<ID3D11PixelShader> pixelShader;
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreatePixelShader(&fileData[0], fileData.size(), nullptr, pixelShader.ReleaseAndGetAddressOf()));
+
+			lock_guard<mutex> lock(mMutex);
+			++mTotals.DeviceObjectsCreated;
+
+			return pixelShader;
+		});
+
+		mPixelShaders.emplace(filename, createTask);
+		return createTask;
+	}
+
+	shared_ptr<const PipelineCache::Pipeline> PipelineCache::CreatePipeline(const Key& key, const Description& description, const VertexShader& vertexShader, const ComPtr<ID3D11PixelShader>& pixelShader)
+	{
+		DX_PROFILE_ZONE("PipelineCache::CreatePipeline");
+
+		ID3D11Device* device = mDeviceResources->GetD3DDevice();
+		uint32_t objectsCreated = 1;
+
+		D3D11RenderBackend::Pipeline resources;
+		resources.VertexShader = vertexShader.Shader;
+		resources.PixelShader = pixelShader;
+		resources.Topology = description.Topology;
+		ThrowIfFailed(device->CreateInputLayout(description.InputElements, description.InputElementCount, vertexShader.Bytecode->data(), vertexShader.Bytecode->size(), resources.InputLayout.ReleaseAndGetAddressOf()));
+
+		if (description.VertexConstantBufferSize > 0)
+		{
+			CD3D11_BUFFER_DESC constantBufferDesc(description.VertexConstantBufferSize, D3D11_BIND_CONSTANT_BUFFER);
+			ThrowIfFailed(device->CreateBuffer(&constantBufferDesc, nullptr, resources.VertexConstantBuffer.ReleaseAndGetAddressOf()));
+			++objectsCreated;
+		}
+
+		if (description.PixelConstantBufferSize > 0)
+		{
+			CD3D11_BUFFER_DESC constantBufferDesc(description.PixelConstantBufferSize, D3D11_BIND_CONSTANT_BUFFER);
+			ThrowIfFailed(device->CreateBuffer(&constantBufferDesc, nullptr, resources.PixelConstantBuffer.ReleaseAndGetAddressOf()));
+			++objectsCreated;
+		}
+
+		if (description.AlphaBlend)
+		{
+			D3D11_BLEND_DESC blendStateDesc = { 0 };
+			blendStateDesc.RenderTarget[0].BlendEnable = true;
+			blendStateDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+			blendStateDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+			blendStateDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+			blendStateDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+			blendStateDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+			blendStateDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+			blendStateDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+			ThrowIfFailed(device->CreateBlendState(&blendStateDesc, resources.BlendState.ReleaseAndGetAddressOf()));
+			++objectsCreated;
+		}
+
+		// The last holder to let go hands the slot back to the backend.
+		shared_ptr<D3D11RenderBackend> renderBackend = mRenderBackend;
+		shared_ptr<const Pipeline> pipeline(new Pipeline{ mRenderBackend->CreatePipeline(resources), resources }, [renderBackend](const Pipeline* released) {
+			PipelineHandle handle = released->Handle;
+			renderBackend->ReleasePipeline(handle);
+			delete released;
+		});
+
+		lock_guard<mutex> lock(mMutex);
+		mTotals.DeviceObjectsCreated += objectsCreated;
+		mLastReadyTimestamp = Profiler::Timestamp();
+
+		// Drop the cache's strong reference held by the load task; from here on only holders keep the pipeline alive.
+		auto found = mPipelines.find(key);
+		if (found != mPipelines.end() && found->second.Loading)
+		{
+			found->second.Loading = false;
+			found->second.Loaded = pipeline;
+			found->second.Load = task<shared_ptr<const Pipeline>>();
+		}
+
+		return pipeline;
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "D3D11RenderBackend.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace DX
+{
+	class DeviceResources;
+
+	// Loads each compiled shader once and shares the pipelines built from it. Every request for the same description,
+	// concurrent or later, gets the same pipeline: one set of device objects and one render backend handle. The cache only
+	// keeps weak references to finished pipelines, so a pipeline and its backend slot are released when the last component
+	// holding it lets go. Shader objects live until ReleaseDeviceDependentResources.
+	class PipelineCache final
+	{
+	public:
+		struct Description
+		{
+			std::wstring VertexShader;							// Compiled shader files in the package
+			std::wstring PixelShader;
+			const D3D11_INPUT_ELEMENT_DESC* InputElements;		// Must have static storage; part of the key by address
+			std::uint32_t InputElementCount;
+			D3D11_PRIMITIVE_TOPOLOGY Topology;
+			std::uint32_t VertexConstantBufferSize;				// In bytes; zero for no constant buffer
+			std::uint32_t PixelConstantBufferSize;
+			bool AlphaBlend;									// Source over destination by source alpha; false when left out
+		};
+
+		// The constant buffers are shared by every holder. That is safe because SetConstants rewrites them before each draw.
+		struct Pipeline
+		{
+			PipelineHandle Handle;
+			D3D11RenderBackend::Pipeline Resources;
+		};
+
+		struct Counters
+		{
+			std::uint32_t ShaderFileLoads;
+			std::uint32_t DeviceObjectsCreated;		// Shaders, input layouts, constant buffers and blend states
+			std::uint32_t PipelineRequests;
+			std::uint32_t PipelineHits;				// Requests served by a pipeline already loaded or loading
+			std::uint32_t LivePipelines;
+			double LoadMilliseconds;				// From the first request to the most recent pipeline becoming ready
+		};
+
+		PipelineCache(const std::shared_ptr<DeviceResources>& deviceResources, const std::shared_ptr<D3D11RenderBackend>& renderBackend);
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache& operator=(const PipelineCache&) = delete;
+		PipelineCache(PipelineCache&&) = delete;
+		PipelineCache& operator=(PipelineCache&&) = delete;
+		~PipelineCache() = default;
+
+		Concurrency::task<std::shared_ptr<const Pipeline>> GetPipelineAsync(const Description& description);
+
+		// Forgets every shader and pipeline. Pipelines already handed out stay valid until their holders release them.
+		void ReleaseDeviceDependentResources();
+
+		Counters Totals() const;
+		bool WriteReport(const std::wstring& filename) const;
+
+	private:
+		struct VertexShader
+		{
+			Microsoft::WRL::ComPtr<ID3D11VertexShader> Shader;
+			std::shared_ptr<const std::vector<byte>> Bytecode;		// Kept for input layout creation
+		};
+
+		struct PipelineEntry
+		{
+			Concurrency::task<std::shared_ptr<const Pipeline>> Load;	// Only held while loading
+			std::weak_ptr<const Pipeline> Loaded;
+			bool Loading;
+		};
+
+		typedef std::tuple<std::wstring, std::wstring, const D3D11_INPUT_ELEMENT_DESC*, std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t, bool> Key;
+
+		static Key MakeKey(const Description& description);
+
+		// Both expect mMutex to be held.
+		Concurrency::task<VertexShader> GetVertexShaderAsync(const std::wstring& filename);
+		Concurrency::task<Microsoft::WRL::ComPtr<ID3D11PixelShader>> GetPixelShaderAsync(const std::wstring& filename);
+
+		std::shared_ptr<const Pipeline> CreatePipeline(const Key& key, const Description& description, const VertexShader& vertexShader, const Microsoft::WRL::ComPtr<ID3D11PixelShader>& pixelShader);
+
+		std::shared_ptr<DeviceResources> mDeviceResources;
+		std::shared_ptr<D3D11RenderBackend> mRenderBackend;
+		std::map<std::wstring, Concurrency::task<VertexShader>> mVertexShaders;
+		std::map<std::wstring, Concurrency::task<Microsoft::WRL::ComPtr<ID3D11PixelShader>>> mPixelShaders;
+		std::map<Key, PipelineEntry> mPipelines;
+		Counters mTotals;
+		std::int64_t mFirstRequestTimestamp;
+		std::int64_t mLastReadyTimestamp;
+		mutable std::mutex mMutex;
+	};
+}
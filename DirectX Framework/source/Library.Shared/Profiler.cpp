@@ -0,0 +1,244 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <chrono>
+#include <codecvt>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DX_PROFILER_TSC 1
+#endif
+#include <functional>
+#include <locale>
+#include <thread>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	thread_local Profiler::ThreadBuffer* Profiler::sThreadBuffer = nullptr;
+
+	namespace
+	{
+		void Open(ofstream& stream, const wstring& filename)
+		{
+#if defined(_WIN32)
+			stream.open(filename, ios::out | ios::trunc);
+#else
+			stream.open(wstring_convert<codecvt_utf8<wchar_t>>().to_bytes(filename), ios::out | ios::trunc);
+#endif
+		}
+
+		void WriteEscaped(ofstream& stream, const char* text)
+		{
+			for (const char* c = text; *c != '\0'; ++c)
+			{
+				if (*c == '"' || *c == '\\')
+				{
+					stream << '\\';
+				}
+
+				stream << *c;
+			}
+		}
+	}
+
+	int64_t Profiler::Timestamp()
+	{
+#if defined(_WIN32)
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+
+		return counter.QuadPart;
+#elif defined(DX_PROFILER_TSC)
+		// The time stamp counter is invariant on every CPU the game targets and costs half a steady clock read.
+		return static_cast<int64_t>(__rdtsc());
+#else
+		return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	int64_t Profiler::TimestampFrequency()
+	{
+#if defined(_WIN32)
+		static const int64_t sFrequency = []()
+		{
+			LARGE_INTEGER frequency;
+			QueryPerformanceFrequency(&frequency);
+			return frequency.QuadPart;
+		}();
+
+		return sFrequency;
+#elif defined(DX_PROFILER_TSC)
+		// Calibrated once against the steady clock.
+		static const int64_t sFrequency = []()
+		{
+			const chrono::steady_clock::time_point clockStart = chrono::steady_clock::now();
+			const int64_t start = Timestamp();
+			this_thread::sleep_for(chrono::milliseconds(20));
+			const int64_t end = Timestamp();
+			const chrono::steady_clock::duration elapsed = chrono::steady_clock::now() - clockStart;
+
+			return static_cast<int64_t>((end - start) / chrono::duration<double>(elapsed).count());
+		}();
+
+		return sFrequency;
+#else
+		return 1000000000;
+#endif
+	}
+
+	void Profiler::RecordZone(const char* name, int64_t start, int64_t end, uint32_t allocations)
+	{
+		ThreadBuffer& buffer = CurrentThreadBuffer();
+		const uint32_t index = buffer.WriteIndex.load(memory_order_relaxed);
+
+		Zone& zone = buffer.Zones[index & (ZonesPerThread - 1)];
+		zone.Name = name;
+		zone.Start = start;
+		zone.End = end;
+		zone.Allocations = allocations;
+
+		buffer.WriteIndex.store(index + 1, memory_order_release);
+	}
+
+	bool Profiler::WriteChromeTrace(const wstring& filename)
+	{
+		ofstream stream;
+		Open(stream, filename);
+		if (!stream.good())
+		{
+			return false;
+		}
+
+		lock_guard<mutex> lock(ThreadBuffersMutex());
+		const uint32_t capacity = ZonesPerThread;
+
+		// Timestamps are written relative to the earliest retained zone, in microseconds.
+		int64_t baseTimestamp = INT64_MAX;
+		for (const ThreadBuffer* entry : ThreadBuffers())
+		{
+			const ThreadBuffer& buffer = *entry;
+			const uint32_t count = min(buffer.WriteIndex.load(memory_order_acquire), capacity);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				baseTimestamp = min(baseTimestamp, buffer.Zones[i].Start);
+			}
+		}
+
+		const double microsecondsPerTick = 1000000.0 / TimestampFrequency();
+		bool firstEvent = true;
+
+		stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		stream.precision(3);
+		stream << fixed;
+
+		for (const ThreadBuffer* entry : ThreadBuffers())
+		{
+			const ThreadBuffer& buffer = *entry;
+			const uint32_t writeIndex = buffer.WriteIndex.load(memory_order_acquire);
+			const uint32_t count = min(writeIndex, capacity);
+
+			// Walk the ring from the oldest retained zone to the newest.
+			for (uint32_t i = writeIndex - count; i != writeIndex; ++i)
+			{
+				const Zone& zone = buffer.Zones[i & (ZonesPerThread - 1)];
+
+				stream << (firstEvent ? "\n" : ",\n") << "{\"name\":\"";
+				WriteEscaped(stream, zone.Name);
+				stream << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.ThreadId
+					<< ",\"ts\":" << (zone.Start - baseTimestamp) * microsecondsPerTick
+					<< ",\"dur\":" << (zone.End - zone.Start) * microsecondsPerTick;
+
+				if (zone.Allocations > 0)
+				{
+					stream << ",\"args\":{\"allocations\":" << zone.Allocations << "}";
+				}
+
+				stream << "}";
+
+				firstEvent = false;
+			}
+		}
+
+		stream << "\n]}\n";
+
+		return stream.good();
+	}
+
+	void Profiler::Clear()
+	{
+		lock_guard<mutex> lock(ThreadBuffersMutex());
+
+		for (ThreadBuffer* buffer : ThreadBuffers())
+		{
+			buffer->WriteIndex.store(0, memory_order_release);
+		}
+	}
+
+	double Profiler::MeasureZoneOverhead(uint32_t iterations)
+	{
+		ThreadBuffer& buffer = CurrentThreadBuffer();
+
+		const int64_t start = Timestamp();
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			ProfileZone zone("Profiler::MeasureZoneOverhead");
+		}
+		const int64_t end = Timestamp();
+
+		// The calibration zones have overwritten this thread's ring; discard them so they don't pollute the trace.
+		buffer.WriteIndex.store(0, memory_order_release);
+
+		return (end - start) * (1000000000.0 / TimestampFrequency()) / max(iterations, 1U);
+	}
+
+	Profiler::ThreadBuffer& Profiler::CurrentThreadBuffer()
+	{
+		if (sThreadBuffer == nullptr)
+		{
+			sThreadBuffer = CreateThreadBuffer();
+		}
+
+		return *sThreadBuffer;
+	}
+
+	Profiler::ThreadBuffer* Profiler::CreateThreadBuffer()
+	{
+		ThreadBuffer* buffer = new ThreadBuffer();
+#if defined(_WIN32)
+		buffer->ThreadId = GetCurrentThreadId();
+#else
+		buffer->ThreadId = static_cast<uint32_t>(hash<thread::id>()(this_thread::get_id()));
+#endif
+		buffer->WriteIndex.store(0, memory_order_relaxed);
+
+		lock_guard<mutex> lock(ThreadBuffersMutex());
+		ThreadBuffers().push_back(buffer);
+
+		return buffer;
+	}
+
+	mutex& Profiler::ThreadBuffersMutex()
+	{
+		static mutex sMutex;
+		return sMutex;
+	}
+
+	// Buffers are never freed so zones recorded by worker threads that have since exited can still be exported.
+	vector<Profiler::ThreadBuffer*>& Profiler::ThreadBuffers()
+	{
+		static vector<ThreadBuffer*> sBuffers;
+		return sBuffers;
+	}
+}
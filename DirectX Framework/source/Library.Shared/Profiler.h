@@ -0,0 +1,111 @@
+#pragma once
+
+#include "AllocationTracker.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Profiling zones are compiled into debug builds. Release builds only get them when DX_PROFILING_ENABLED is defined
+// in the project's preprocessor definitions; otherwise DX_PROFILE_ZONE expands to nothing.
+#if !defined(DX_PROFILING_ENABLED)
+#if defined(_DEBUG)
+#define DX_PROFILING_ENABLED 1
+#else
+#define DX_PROFILING_ENABLED 0
+#endif
+#endif
+
+namespace DX
+{
+	// Collects scoped timing zones into per-thread ring buffers and exports them as Chrome trace-event JSON
+	// (loadable by chrome://tracing and Perfetto). Timestamps come from the performance counter on Windows and the steady
+	// clock elsewhere; this file only depends on the C++ standard library and the OS timer.
+	class Profiler final
+	{
+	public:
+		struct Zone
+		{
+			const char* Name;
+			std::int64_t Start;
+			std::int64_t End;
+			std::uint32_t Allocations;
+		};
+
+		// Number of zones retained per thread. Must be a power of two; older zones are overwritten.
+		static const std::uint32_t ZonesPerThread = 8192;
+
+		static std::int64_t Timestamp();
+		static std::int64_t TimestampFrequency();
+		static void RecordZone(const char* name, std::int64_t start, std::int64_t end, std::uint32_t allocations = 0);
+
+		// Writes every retained zone of every thread to the specified file.
+		static bool WriteChromeTrace(const std::wstring& filename);
+		static void Clear();
+
+		// Times a large number of empty zones on the calling thread and returns the average cost of one zone, in nanoseconds.
+		// Zones previously recorded on the calling thread are discarded.
+		static double MeasureZoneOverhead(std::uint32_t iterations = 100000);
+
+		Profiler() = delete;
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler(Profiler&&) = delete;
+		Profiler& operator=(Profiler&&) = delete;
+		~Profiler() = default;
+
+	private:
+		struct ThreadBuffer
+		{
+			std::uint32_t ThreadId;
+			std::atomic<std::uint32_t> WriteIndex;
+			Zone Zones[ZonesPerThread];
+		};
+
+		static ThreadBuffer& CurrentThreadBuffer();
+		static ThreadBuffer* CreateThreadBuffer();
+		static std::mutex& ThreadBuffersMutex();
+		static std::vector<ThreadBuffer*>& ThreadBuffers();
+
+		static thread_local ThreadBuffer* sThreadBuffer;
+	};
+
+	// Records the lifetime of the enclosing scope as a profiling zone, along with the number of allocations made on the thread
+	// while it was open. The name must outlive the profiler (string literals, type names).
+	class ProfileZone final
+	{
+	public:
+		explicit ProfileZone(const char* name) :
+			mName(name), mParentZone(AllocationTracker::SetCurrentZone(name)),
+			mAllocations(AllocationTracker::ThreadAllocationCount()), mStart(Profiler::Timestamp())
+		{
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+		ProfileZone(ProfileZone&&) = delete;
+		ProfileZone& operator=(ProfileZone&&) = delete;
+
+		~ProfileZone()
+		{
+			const std::int64_t end = Profiler::Timestamp();
+			Profiler::RecordZone(mName, mStart, end, static_cast<std::uint32_t>(AllocationTracker::ThreadAllocationCount() - mAllocations));
+			AllocationTracker::SetCurrentZone(mParentZone);
+		}
+
+	private:
+		const char* mName;
+		const char* mParentZone;
+		std::uint64_t mAllocations;
+		std::int64_t mStart;
+	};
+}
+
+#if DX_PROFILING_ENABLED
+#define DX_PROFILE_CONCAT_INNER(a, b) a##b
+#define DX_PROFILE_CONCAT(a, b) DX_PROFILE_CONCAT_INNER(a, b)
+#define DX_PROFILE_ZONE(name) DX::ProfileZone DX_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define DX_PROFILE_ZONE(name) ((void)0)
+#endif
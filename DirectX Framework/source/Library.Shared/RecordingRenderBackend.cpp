@@ -0,0 +1,186 @@
+#include "RecordingRenderBackend.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace DX
+{
+	RecordingRenderBackend::RecordingRenderBackend() :
+		mTotals(), mLastExecution(), mNextPipeline(0), mNextMesh(0), mBackBuffer()
+	{
+	}
+
+	PipelineHandle RecordingRenderBackend::CreatePipeline()
+	{
+		return mNextPipeline++;
+	}
+
+	MeshHandle RecordingRenderBackend::CreateMesh()
+	{
+		return mNextMesh++;
+	}
+
+	RenderTargetHandle RecordingRenderBackend::CreateRenderTarget(uint32_t width, uint32_t height)
+	{
+		const PixelRect rect = { 0, 0, width, height };
+		mRenderTargets.push_back(rect);
+		return static_cast<RenderTargetHandle>(mRenderTargets.size() - 1);
+	}
+
+	void RecordingRenderBackend::SetBackBufferSize(uint32_t width, uint32_t height)
+	{
+		mBackBuffer.Right = width;
+		mBackBuffer.Bottom = height;
+	}
+
+	PixelRect RecordingRenderBackend::RenderTargetRect(RenderTargetHandle target) const
+	{
+		return (target == RenderCommandList::BackBuffer ? mBackBuffer : mRenderTargets[target]);
+	}
+
+	void RecordingRenderBackend::Execute(const RenderCommandList& commandList)
+	{
+		Counters counters = {};
+		counters.Executions = 1;
+		counters.Commands = commandList.CommandCount();
+
+		mDraws.clear();
+
+		// Constants and instance data are copied out in full so the records stay valid after the list is cleared.
+		mConstantData.assign(commandList.Data(), commandList.Data() + commandList.DataBytes());
+
+		DrawRecord state = { RenderCommandList::InvalidPipeline, RenderCommandList::InvalidMesh, 0, 0, 0, NoConstants, NoConstants, RenderCommandList::BackBuffer, NoConstants,
+			RenderCommandList::BackBuffer, 0 };
+
+		const RenderCommand* commands = commandList.Commands();
+		for (size_t i = 0; i < commandList.CommandCount(); ++i)
+		{
+			const RenderCommand& command = commands[i];
+			switch (command.Type)
+			{
+			case RenderCommandType::SetPipeline:
+				state.Pipeline = command.Pipeline;
+				++counters.PipelineChanges;
+				break;
+
+			case RenderCommandType::SetMesh:
+				state.Mesh = command.Mesh;
+				++counters.MeshChanges;
+				break;
+
+			case RenderCommandType::SetConstants:
+				(command.Stage == ShaderStage::Vertex ? state.VertexConstants : state.PixelConstants) = command.DataOffset;
+				++counters.ConstantUpdates;
+				counters.ConstantBytes += command.DataSize;
+				break;
+
+			case RenderCommandType::UpdateInstances:
+				++counters.InstanceUpdates;
+				counters.InstanceBytes += command.DataSize;
+				break;
+
+			case RenderCommandType::Draw:
+				state.VertexCount = command.VertexCount;
+				state.StartVertex = command.StartVertex;
+				state.InstanceCount = 1;
+				state.Layer = command.Layer;
+				mDraws.push_back(state);
+				++counters.Draws;
+				++counters.Instances;
+				counters.Vertices += command.VertexCount;
+				break;
+
+			case RenderCommandType::DrawInstanced:
+				state.VertexCount = command.VertexCount;
+				state.StartVertex = command.StartVertex;
+				state.InstanceCount = command.InstanceCount;
+				state.Layer = command.Layer;
+				mDraws.push_back(state);
+				++counters.Draws;
+				counters.Instances += command.InstanceCount;
+				counters.Vertices += static_cast<uint64_t>(command.VertexCount) * command.InstanceCount;
+				break;
+
+			case RenderCommandType::SetRenderTarget:
+				state.RenderTarget = command.Target;
+				state.Texture = RenderCommandList::BackBuffer;
+				++counters.RenderTargetChanges;
+				break;
+
+			case RenderCommandType::ClearRenderTarget:
+			{
+				PixelRect rect = RenderTargetRect(state.RenderTarget);
+				if (command.DataSize > sizeof(float) * 4)
+				{
+					const PixelRect& cleared = *reinterpret_cast<const PixelRect*>(commandList.Data(command) + sizeof(float) * 4);
+					rect.Left = max(rect.Left, cleared.Left);
+					rect.Top = max(rect.Top, cleared.Top);
+					rect.Right = min(rect.Right, cleared.Right);
+					rect.Bottom = min(rect.Bottom, cleared.Bottom);
+				}
+
+				++counters.Clears;
+				if (rect.Right > rect.Left && rect.Bottom > rect.Top)
+				{
+					counters.ClearedPixels += static_cast<uint64_t>(rect.Right - rect.Left) * (rect.Bottom - rect.Top);
+				}
+				break;
+			}
+
+			case RenderCommandType::SetScissor:
+				state.Scissor = (command.DataSize > 0 ? command.DataOffset : NoConstants);
+				++counters.ScissorChanges;
+				break;
+
+			case RenderCommandType::SetTexture:
+				state.Texture = command.Target;
+				++counters.TextureBinds;
+				break;
+			}
+		}
+
+		mLastExecution = counters;
+		mTotals.Executions += counters.Executions;
+		mTotals.Commands += counters.Commands;
+		mTotals.PipelineChanges += counters.PipelineChanges;
+		mTotals.MeshChanges += counters.MeshChanges;
+		mTotals.ConstantUpdates += counters.ConstantUpdates;
+		mTotals.ConstantBytes += counters.ConstantBytes;
+		mTotals.InstanceUpdates += counters.InstanceUpdates;
+		mTotals.InstanceBytes += counters.InstanceBytes;
+		mTotals.Draws += counters.Draws;
+		mTotals.Instances += counters.Instances;
+		mTotals.Vertices += counters.Vertices;
+		mTotals.RenderTargetChanges += counters.RenderTargetChanges;
+		mTotals.Clears += counters.Clears;
+		mTotals.ClearedPixels += counters.ClearedPixels;
+		mTotals.ScissorChanges += counters.ScissorChanges;
+		mTotals.TextureBinds += counters.TextureBinds;
+	}
+
+	const RecordingRenderBackend::Counters& RecordingRenderBackend::Totals() const
+	{
+		return mTotals;
+	}
+
+	const RecordingRenderBackend::Counters& RecordingRenderBackend::LastExecution() const
+	{
+		return mLastExecution;
+	}
+
+	void RecordingRenderBackend::ResetCounters()
+	{
+		mTotals = Counters();
+		mLastExecution = Counters();
+	}
+
+	const vector<RecordingRenderBackend::DrawRecord>& RecordingRenderBackend::Draws() const
+	{
+		return mDraws;
+	}
+
+	const uint8_t* RecordingRenderBackend::ConstantData(uint32_t offset) const
+	{
+		return mConstantData.data() + offset;
+	}
+}
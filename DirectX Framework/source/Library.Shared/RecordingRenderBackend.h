@@ -0,0 +1,91 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "RenderCommandList.h"
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Backend that draws nothing. It counts what it is given and keeps the draws of the last executed list, with the
+	// state and constants each one would have used, so recorded frames can be inspected and checked without a GPU.
+	class RecordingRenderBackend final : public RenderBackend
+	{
+	public:
+		struct Counters
+		{
+			std::uint64_t Executions;
+			std::uint64_t Commands;
+			std::uint64_t PipelineChanges;
+			std::uint64_t MeshChanges;
+			std::uint64_t ConstantUpdates;
+			std::uint64_t ConstantBytes;
+			std::uint64_t InstanceUpdates;
+			std::uint64_t InstanceBytes;
+			std::uint64_t Draws;
+			std::uint64_t Instances;
+			std::uint64_t Vertices;
+			std::uint64_t RenderTargetChanges;
+			std::uint64_t Clears;
+			std::uint64_t ClearedPixels;
+			std::uint64_t ScissorChanges;
+			std::uint64_t TextureBinds;
+		};
+
+		// Constant offsets index ConstantData(); NoConstants means the stage had none set before the draw. Scissor is the
+		// offset of the draw's PixelRect in the same data, or NoConstants when the scissor test was off. Texture is BackBuffer
+		// when no texture is bound; binding a render target unbinds it. Draws that are not instanced record an InstanceCount
+		// of one.
+		struct DrawRecord
+		{
+			PipelineHandle Pipeline;
+			MeshHandle Mesh;
+			std::uint32_t VertexCount;
+			std::uint32_t StartVertex;
+			std::uint32_t InstanceCount;
+			std::uint32_t VertexConstants;
+			std::uint32_t PixelConstants;
+			RenderTargetHandle RenderTarget;
+			std::uint32_t Scissor;
+			RenderTargetHandle Texture;
+			std::uint16_t Layer;
+		};
+
+		static const std::uint32_t NoConstants = 0xFFFFFFFF;
+
+		RecordingRenderBackend();
+		RecordingRenderBackend(const RecordingRenderBackend&) = delete;
+		RecordingRenderBackend& operator=(const RecordingRenderBackend&) = delete;
+		RecordingRenderBackend(RecordingRenderBackend&&) = delete;
+		RecordingRenderBackend& operator=(RecordingRenderBackend&&) = delete;
+		~RecordingRenderBackend() = default;
+
+		// Handles are handed out in sequence; the recording backend has no resources behind them.
+		PipelineHandle CreatePipeline();
+		MeshHandle CreateMesh();
+
+		// The size is used to count the pixels cleared. Set the back buffer's size with SetBackBufferSize.
+		RenderTargetHandle CreateRenderTarget(std::uint32_t width, std::uint32_t height);
+		void SetBackBufferSize(std::uint32_t width, std::uint32_t height);
+		PixelRect RenderTargetRect(RenderTargetHandle target) const;
+
+		virtual void Execute(const RenderCommandList& commandList) override;
+
+		const Counters& Totals() const;
+		const Counters& LastExecution() const;
+		void ResetCounters();
+
+		const std::vector<DrawRecord>& Draws() const;
+		const std::uint8_t* ConstantData(std::uint32_t offset) const;
+
+	private:
+		Counters mTotals;
+		Counters mLastExecution;
+		std::vector<DrawRecord> mDraws;
+		std::vector<std::uint8_t> mConstantData;
+		PipelineHandle mNextPipeline;
+		MeshHandle mNextMesh;
+		std::vector<PixelRect> mRenderTargets;
+		PixelRect mBackBuffer;
+	};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace DX
+{
+	class RenderCommandList;
+
+	// Consumes recorded command lists. Backends issue the pipeline and mesh handles the lists refer to.
+	class RenderBackend
+	{
+	public:
+		RenderBackend() = default;
+		RenderBackend(const RenderBackend&) = delete;
+		RenderBackend& operator=(const RenderBackend&) = delete;
+		RenderBackend(RenderBackend&&) = delete;
+		RenderBackend& operator=(RenderBackend&&) = delete;
+		virtual ~RenderBackend() = default;
+
+		virtual void Execute(const RenderCommandList& commandList) = 0;
+	};
+}
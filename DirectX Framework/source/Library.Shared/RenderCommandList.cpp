@@ -0,0 +1,25 @@
+#include "RenderCommandList.h"
+
+using namespace std;
+
+namespace DX
+{
+	RenderCommandList::RenderCommandList(size_t commandCapacity, size_t dataCapacity) :
+		mCurrentPipeline(InvalidPipeline), mCurrentMesh(InvalidMesh), mCurrentRenderTarget(BackBuffer), mCurrentLayer(0), mDrawCount(0), mVertexCount(0)
+	{
+		mCommands.reserve(commandCapacity);
+		mData.reserve(dataCapacity);
+	}
+
+	void RenderCommandList::Clear()
+	{
+		mCommands.clear();
+		mData.clear();
+		mCurrentPipeline = InvalidPipeline;
+		mCurrentMesh = InvalidMesh;
+		mCurrentRenderTarget = BackBuffer;
+		mCurrentLayer = 0;
+		mDrawCount = 0;
+		mVertexCount = 0;
+	}
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace DX
+{
+	// Backend-issued handles for a pipeline (shaders, input layout, topology and per-object constant buffers), a mesh
+	// (vertex buffer and stride, plus an optional per-instance buffer) and an offscreen render target that can also be read
+	// as a texture.
+	typedef std::uint32_t PipelineHandle;
+	typedef std::uint32_t MeshHandle;
+	typedef std::uint32_t RenderTargetHandle;
+
+	enum class ShaderStage : std::uint8_t
+	{
+		Vertex,
+		Pixel
+	};
+
+	enum class RenderCommandType : std::uint8_t
+	{
+		SetPipeline,
+		SetMesh,
+		SetConstants,
+		UpdateInstances,
+		Draw,
+		DrawInstanced,
+		SetRenderTarget,
+		ClearRenderTarget,
+		SetScissor,
+		SetTexture
+	};
+
+	// A rectangle of render target pixels; Right and Bottom are exclusive.
+	struct PixelRect
+	{
+		std::uint32_t Left;
+		std::uint32_t Top;
+		std::uint32_t Right;
+		std::uint32_t Bottom;
+	};
+
+	// One recorded command. Per-draw constants and instance data are copied into the owning list and referenced by offset,
+	// so commands are plain data that can be copied, sorted or handed to another thread.
+	struct RenderCommand
+	{
+		RenderCommandType Type;
+		ShaderStage Stage;					// SetConstants
+		std::uint16_t Layer;				// Draw and DrawInstanced; see RenderCommandList::SetLayer
+		union
+		{
+			PipelineHandle Pipeline;		// SetPipeline
+			MeshHandle Mesh;				// SetMesh
+			RenderTargetHandle Target;		// SetRenderTarget and SetTexture
+			std::uint32_t DataOffset;		// SetConstants, UpdateInstances, ClearRenderTarget and SetScissor, into RenderCommandList::Data
+			std::uint32_t VertexCount;		// Draw and DrawInstanced
+		};
+		union
+		{
+			std::uint32_t DataSize;			// As DataOffset, in bytes. A SetScissor with no data turns the scissor test off.
+			std::uint32_t StartVertex;		// Draw and DrawInstanced
+		};
+		std::uint32_t InstanceCount;		// DrawInstanced
+	};
+
+	static_assert(std::is_trivially_copyable<RenderCommand>::value, "RenderCommand must stay plain data.");
+	static_assert(sizeof(RenderCommand) == 16, "RenderCommand should stay compact.");
+
+	class DrawSorter;
+
+	// Draw work recorded by DrawableGameComponents and consumed by a RenderBackend. Binding the pipeline or mesh that is
+	// already bound is dropped at record time. Clear keeps the storage, so a steady frame records without allocating.
+	class RenderCommandList final
+	{
+	public:
+		static const PipelineHandle InvalidPipeline = 0xFFFFFFFF;
+		static const MeshHandle InvalidMesh = 0xFFFFFFFF;
+		static const RenderTargetHandle BackBuffer = 0xFFFFFFFF;	// The swap chain's target, bound when a list starts
+		static const std::uint32_t DataAlignment = 16;
+
+		static const std::size_t DefaultCommandCapacity = 1024;
+		static const std::size_t DefaultDataCapacity = 64 * 1024;
+
+		explicit RenderCommandList(std::size_t commandCapacity = DefaultCommandCapacity, std::size_t dataCapacity = DefaultDataCapacity);
+		RenderCommandList(const RenderCommandList&) = delete;
+		RenderCommandList& operator=(const RenderCommandList&) = delete;
+		RenderCommandList(RenderCommandList&&) = default;
+		RenderCommandList& operator=(RenderCommandList&&) = default;
+		~RenderCommandList() = default;
+
+		void SetPipeline(PipelineHandle pipeline);
+		void SetMesh(MeshHandle mesh);
+
+		// Copies size bytes into the list; the backend uploads them to the stage's per-object constant buffer.
+		void SetConstants(ShaderStage stage, const void* data, std::uint32_t size);
+
+		template <typename T>
+		void SetConstants(ShaderStage stage, const T& data);
+
+		// Copies size bytes of per-instance data into the list; the backend writes them to the start of the bound mesh's
+		// instance buffer. That buffer keeps its contents between frames, so upload only when the instances change.
+		void UpdateInstances(const void* data, std::uint32_t size);
+
+		template <typename T>
+		void UpdateInstances(const T* instances, std::uint32_t count);
+
+		// Draws that follow are tagged with layer. Layers are drawn in increasing order when the list is state-sorted (see
+		// DrawSorter), which only reorders draws within a layer. Clear resets the layer to zero.
+		void SetLayer(std::uint16_t layer);
+
+		void Draw(std::uint32_t vertexCount, std::uint32_t startVertex = 0);
+		void DrawInstanced(std::uint32_t vertexCount, std::uint32_t instanceCount, std::uint32_t startVertex = 0);
+
+		// Draws that follow go to target, with the viewport covering all of it. Binding the target that is already bound is
+		// dropped like SetPipeline and SetMesh. Rebind BackBuffer (and reset the scissor) before returning from RecordDraws.
+		void SetRenderTarget(RenderTargetHandle target);
+
+		// Clears the bound render target, or only rect of it. Clears ignore the scissor.
+		void ClearRenderTarget(const float (&color)[4]);
+		void ClearRenderTarget(const float (&color)[4], const PixelRect& rect);
+
+		// Limits draws to rect of the bound render target until ResetScissor.
+		void SetScissor(const PixelRect& rect);
+		void ResetScissor();
+
+		// Binds an offscreen target's pixels to pixel shader texture slot 0. The target can't be read while it is bound for
+		// drawing; SetRenderTarget unbinds the texture. Set it after SetPipeline, even if the pipeline was already bound.
+		void SetTexture(RenderTargetHandle target);
+
+		void Clear();
+
+		const RenderCommand* Commands() const;
+		std::size_t CommandCount() const;
+		std::size_t DrawCount() const;
+
+		// Vertices the list's draws process, each instance's counted.
+		std::uint64_t VertexCount() const;
+
+		const std::uint8_t* Data() const;
+		const std::uint8_t* Data(const RenderCommand& command) const;
+		std::size_t DataBytes() const;
+
+	private:
+		// Copies a list's data in one block and reuses its commands' offsets, rather than copying each command's data.
+		friend class DrawSorter;
+
+		std::uint32_t AppendData(const void* data, std::uint32_t size);
+
+		std::vector<RenderCommand> mCommands;
+		std::vector<std::uint8_t> mData;
+		PipelineHandle mCurrentPipeline;
+		MeshHandle mCurrentMesh;
+		RenderTargetHandle mCurrentRenderTarget;
+		std::uint16_t mCurrentLayer;
+		std::size_t mDrawCount;
+		std::uint64_t mVertexCount;
+	};
+}
+
+#include "RenderCommandList.inl"
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstring>
+
+namespace DX
+{
+	inline void RenderCommandList::SetPipeline(PipelineHandle pipeline)
+	{
+		if (pipeline == mCurrentPipeline)
+		{
+			return;
+		}
+
+		RenderCommand command = {};
+		command.Type = RenderCommandType::SetPipeline;
+		command.Pipeline = pipeline;
+		mCommands.push_back(command);
+
+		mCurrentPipeline = pipeline;
+	}
+
+	inline void RenderCommandList::SetMesh(MeshHandle mesh)
+	{
+		if (mesh == mCurrentMesh)
+		{
+			return;
+		}
+
+		RenderCommand command = {};
+		command.Type = RenderCommandType::SetMesh;
+		command.Mesh = mesh;
+		mCommands.push_back(command);
+
+		mCurrentMesh = mesh;
+	}
+
+	inline std::uint32_t RenderCommandList::AppendData(const void* data, std::uint32_t size)
+	{
+		const std::size_t offset = (mData.size() + DataAlignment - 1) & ~static_cast<std::size_t>(DataAlignment - 1);
+		mData.resize(offset + size);
+		if (size > 0)
+		{
+			std::memcpy(&mData[offset], data, size);
+		}
+
+		return static_cast<std::uint32_t>(offset);
+	}
+
+	inline void RenderCommandList::SetConstants(ShaderStage stage, const void* data, std::uint32_t size)
+	{
+		RenderCommand command = {};
+		command.Type = RenderCommandType::SetConstants;
+		command.Stage = stage;
+		command.DataOffset = AppendData(data, size);
+		command.DataSize = size;
+		mCommands.push_back(command);
+	}
+
+	template <typename T>
+	inline void RenderCommandList::SetConstants(ShaderStage stage, const T& data)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Constants are copied byte for byte.");
+		SetConstants(stage, &data, static_cast<std::uint32_t>(sizeof(T)));
+	}
+
+	inline void RenderCommandList::UpdateInstances(const void* data, std::uint32_t size)
+	{
+		RenderCommand command = {};
+		command.Type = RenderCommandType::UpdateInstances;
+		command.DataOffset = AppendData(data, size);
+		command.DataSize = size;
+		mCommands.push_back(command);
+	}
+
+	template <typename T>
+	inline void RenderCommandList::UpdateInstances(const T* instances, std::uint32_t count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Instances are copied byte for byte.");
+		UpdateInstances(static_cast<const void*>(instances), static_cast<std::uint32_t>(sizeof(T) * count));
+	}
+
+	inline void RenderCommandList::SetLayer(std::uint16_t layer)
+	{
+		mCurrentLayer = layer;
+	}
+
+	inline void RenderCommandList::Draw(std::uint32_t vertexCount, std::uint32_t startVertex)
+	{
+		RenderCommand command = {};
+		command.Type = RenderCommandType::Draw;
+		command.Layer = mCurrentLayer;
+		command.VertexCount = vertexCount;
+		command.StartVertex = startVertex;
+		mCommands.push_back(command);
+
+		++mDrawCount;
+		mVertexCount += vertexCount;
+	}
+
+	inline void RenderCommandList::DrawInstanced(std::uint32_t vertexCount, std::uint32_t instanceCount, std::uint32_t startVertex)
+	{
+		RenderCommand command = {};
+		command.Type = RenderCommandType::DrawInstanced;
+		command.Layer = mCurrentLayer;
+		command.VertexCount = vertexCount;
+		command.StartVertex = startVertex;
+		command.InstanceCount = instanceCount;
+		mCommands.push_back(command);
+
+		++mDrawCount;
+		mVertexCount += static_cast<std::uint64_t>(vertexCount) * instanceCount;
+	}
+
+	inline void RenderCommandList::SetRenderTarget(RenderTargetHandle target)
+	{
+		if (target == mCurrentRenderTarget)
+		{
+			return;
+		}
+
+		RenderCommand command = {};
+		command.Type = RenderCommandType::SetRenderTarget;
+		command.Target = target;
+		mCommands.push_back(command);
+
+		mCurrentRenderTarget = target;
+	}
+
+	inline void RenderCommandList::ClearRenderTarget(const float (&color)[4])
+	{
+		RenderCommand command = {};
+		command.Type = RenderCommandType::ClearRenderTarget;
+		command.DataOffset = AppendData(color, static_cast<std::uint32_t>(sizeof(color)));
+		command.DataSize = static_cast<std::uint32_t>(sizeof(color));
+		mCommands.push_back(command);
+	}
+
+	inline void RenderCommandList::ClearRenderTarget(const float (&color)[4], const PixelRect& rect)
+	{
+		static_assert(sizeof(color) == sizeof(PixelRect), "The rectangle follows the color directly.");
+
+		RenderCommand command = {};
+		command.Type = RenderCommandType::ClearRenderTarget;
+		command.DataOffset = AppendData(color, static_cast<std::uint32_t>(sizeof(color)));
+		AppendData(&rect, static_cast<std::uint32_t>(sizeof(rect)));
+		command.DataSize = static_cast<std::uint32_t>(sizeof(color) + sizeof(rect));
+		mCommands.push_back(command);
+	}
+
+	inline void RenderCommandList::SetScissor(const PixelRect& rect)
+	{
+		RenderCommand command = {};
+		command.Type = RenderCommandType::SetScissor;
+		command.DataOffset = AppendData(&rect, static_cast<std::uint32_t>(sizeof(rect)));
+		command.DataSize = static_cast<std::uint32_t>(sizeof(rect));
+		mCommands.push_back(command);
+	}
+
+	inline void RenderCommandList::ResetScissor()
+	{
+		RenderCommand command = {};
+		command.Type = RenderCommandType::SetScissor;
+		mCommands.push_back(command);
+	}
+
+	inline void RenderCommandList::SetTexture(RenderTargetHandle target)
+	{
+		RenderCommand command = {};
+		command.Type = RenderCommandType::SetTexture;
+		command.Target = target;
+		mCommands.push_back(command);
+	}
+
+	inline const RenderCommand* RenderCommandList::Commands() const
+	{
+		return mCommands.data();
+	}
+
+	inline std::size_t RenderCommandList::CommandCount() const
+	{
+		return mCommands.size();
+	}
+
+	inline std::size_t RenderCommandList::DrawCount() const
+	{
+		return mDrawCount;
+	}
+
+	inline std::uint64_t RenderCommandList::VertexCount() const
+	{
+		return mVertexCount;
+	}
+
+	inline const std::uint8_t* RenderCommandList::Data() const
+	{
+		return mData.data();
+	}
+
+	inline const std::uint8_t* RenderCommandList::Data(const RenderCommand& command) const
+	{
+		return mData.data() + command.DataOffset;
+	}
+
+	inline std::size_t RenderCommandList::DataBytes() const
+	{
+		return mData.size();
+	}
+}
@@ -0,0 +1,85 @@
+#include "ShapeMeshes.h"
+#include <cstddef>
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		using ShapeTessellation::Detail::Cosine;
+		using ShapeTessellation::Detail::Pi;
+		using ShapeTessellation::Detail::Sqrt2;
+
+		const ShapeLod CircleLods[ShapeMeshes::LodCount] =
+		{
+			{ offsetof(ShapeMeshes::Circles, Lod0) / sizeof(ShapeVertex), 8 },
+			{ offsetof(ShapeMeshes::Circles, Lod1) / sizeof(ShapeVertex), 16 },
+			{ offsetof(ShapeMeshes::Circles, Lod2) / sizeof(ShapeVertex), 32 },
+			{ offsetof(ShapeMeshes::Circles, Lod3) / sizeof(ShapeVertex), 64 }
+		};
+
+		const ShapeLod RoundedRectLods[ShapeMeshes::LodCount] =
+		{
+			{ offsetof(ShapeMeshes::RoundedRects, Lod0) / sizeof(ShapeVertex), 4 },
+			{ offsetof(ShapeMeshes::RoundedRects, Lod1) / sizeof(ShapeVertex), 12 },
+			{ offsetof(ShapeMeshes::RoundedRects, Lod2) / sizeof(ShapeVertex), 20 },
+			{ offsetof(ShapeMeshes::RoundedRects, Lod3) / sizeof(ShapeVertex), 36 }
+		};
+
+		// A chord across an arc of a radians falls 1 - cos(a / 2) of the radius inside it; a square corner sticks out
+		// sqrt 2 - 1 of the radius past its quarter circle.
+		constexpr float CircleErrors[ShapeMeshes::LodCount] =
+		{
+			static_cast<float>(1.0 - Cosine(Pi / 8)), static_cast<float>(1.0 - Cosine(Pi / 16)), static_cast<float>(1.0 - Cosine(Pi / 32)), static_cast<float>(1.0 - Cosine(Pi / 64))
+		};
+
+		constexpr float RoundedRectErrors[ShapeMeshes::LodCount] =
+		{
+			static_cast<float>(Sqrt2 - 1.0), static_cast<float>(1.0 - Cosine(Pi / 8)), static_cast<float>(1.0 - Cosine(Pi / 16)), static_cast<float>(1.0 - Cosine(Pi / 32))
+		};
+
+		uint32_t SelectLod(const float (&errors)[ShapeMeshes::LodCount], float screenRadius, float tolerance)
+		{
+			uint32_t lod = 0;
+			while (lod + 1 < ShapeMeshes::LodCount && errors[lod] * screenRadius > tolerance)
+			{
+				++lod;
+			}
+
+			return lod;
+		}
+	}
+
+	const float ShapeMeshes::DefaultTolerance = 0.5f;
+
+	ShapeLod ShapeMeshes::CircleLod(uint32_t lod)
+	{
+		return CircleLods[lod < LodCount ? lod : LodCount - 1];
+	}
+
+	ShapeLod ShapeMeshes::RoundedRectLod(uint32_t lod)
+	{
+		return RoundedRectLods[lod < LodCount ? lod : LodCount - 1];
+	}
+
+	float ShapeMeshes::CircleError(uint32_t lod, float screenRadius)
+	{
+		return CircleErrors[lod < LodCount ? lod : LodCount - 1] * screenRadius;
+	}
+
+	float ShapeMeshes::RoundedRectError(uint32_t lod, float screenCornerRadius)
+	{
+		return RoundedRectErrors[lod < LodCount ? lod : LodCount - 1] * screenCornerRadius;
+	}
+
+	uint32_t ShapeMeshes::SelectCircleLod(float screenRadius, float tolerance)
+	{
+		return SelectLod(CircleErrors, screenRadius, tolerance);
+	}
+
+	uint32_t ShapeMeshes::SelectRoundedRectLod(float screenCornerRadius, float tolerance)
+	{
+		return SelectLod(RoundedRectErrors, screenCornerRadius, tolerance);
+	}
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+namespace DX
+{
+	// One vertex of a shape mesh, laid out as VertexPosition: x, y, z and w.
+	struct ShapeVertex
+	{
+		float Position[4];
+	};
+
+	template <std::uint32_t N>
+	struct ShapeMesh
+	{
+		static_assert(N >= 3, "A shape mesh needs at least one triangle.");
+
+		ShapeVertex Vertices[N];
+	};
+
+	// Where one level of detail lies in the vertex buffer made from a set of meshes.
+	struct ShapeLod
+	{
+		std::uint32_t StartVertex;
+		std::uint32_t VertexCount;
+	};
+
+	// Convex shapes tessellated by the compiler. A shape is a triangle strip over its outline alone, visited from both ends
+	// towards the far side (0, N - 1, 1, N - 2, ...), so N outline points make N - 2 triangles with no center vertex. The
+	// first triangle is clockwise seen from +z, front facing under the default rasterizer state with a y-up camera.
+	// Written as C++11 constexpr functions, one return statement each, so the v140 toolset can evaluate them.
+	namespace ShapeTessellation
+	{
+		namespace Detail
+		{
+			constexpr double Pi = 3.14159265358979323846;
+			constexpr double Sqrt2 = 1.41421356237309504880;
+
+			constexpr double ReduceAngle(double radians)
+			{
+				return (radians > Pi ? ReduceAngle(radians - 2.0 * Pi) : (radians < -Pi ? ReduceAngle(radians + 2.0 * Pi) : radians));
+			}
+
+			// Taylor series to fourteen terms; the first one left out is below 1e-16 for angles within pi.
+			constexpr double SineSeries(double squared, double term, int power, int termsLeft)
+			{
+				return (termsLeft == 0 ? 0.0 : term + SineSeries(squared, -term * squared / ((power + 1) * (power + 2)), power + 2, termsLeft - 1));
+			}
+
+			constexpr double Sine(double radians)
+			{
+				return SineSeries(ReduceAngle(radians) * ReduceAngle(radians), ReduceAngle(radians), 1, 14);
+			}
+
+			constexpr double Cosine(double radians)
+			{
+				return Sine(radians + 0.5 * Pi);
+			}
+
+			constexpr std::uint32_t StripIndex(std::uint32_t vertex, std::uint32_t pointCount)
+			{
+				return (vertex % 2 == 0 ? vertex / 2 : pointCount - (vertex + 1) / 2);
+			}
+
+			constexpr ShapeVertex Vertex(double x, double y)
+			{
+				return ShapeVertex{ { static_cast<float>(x), static_cast<float>(y), 0.0f, 1.0f } };
+			}
+
+			constexpr ShapeVertex CirclePoint(std::uint32_t point, std::uint32_t segments)
+			{
+				return Vertex(Cosine(2.0 * Pi * point / segments), Sine(2.0 * Pi * point / segments));
+			}
+
+			// Corner 0 is the top right, then counterclockwise. A corner without segments is the rectangle's own corner,
+			// which is where its arc's middle point would be at sqrt 2 times the radius.
+			constexpr double CornerAngle(std::uint32_t corner, std::uint32_t step, std::uint32_t cornerSegments)
+			{
+				return 0.5 * Pi * (corner + (cornerSegments == 0 ? 0.5 : static_cast<double>(step) / cornerSegments));
+			}
+
+			constexpr ShapeVertex CornerPoint(std::uint32_t corner, std::uint32_t step, std::uint32_t cornerSegments, double left, double bottom, double right, double top,
+				double radius)
+			{
+				return Vertex((corner == 0 || corner == 3 ? right - radius : left + radius) + radius * (cornerSegments == 0 ? Sqrt2 : 1.0) * Cosine(CornerAngle(corner, step, cornerSegments)),
+					(corner < 2 ? top - radius : bottom + radius) + radius * (cornerSegments == 0 ? Sqrt2 : 1.0) * Sine(CornerAngle(corner, step, cornerSegments)));
+			}
+
+			template <std::uint32_t Segments, std::uint32_t... Vertices>
+			constexpr ShapeMesh<Segments> Circle(std::integer_sequence<std::uint32_t, Vertices...>)
+			{
+				return ShapeMesh<Segments>{ { CirclePoint(StripIndex(Vertices, Segments), Segments)... } };
+			}
+
+			template <std::uint32_t CornerSegments, std::uint32_t... Vertices>
+			constexpr ShapeMesh<4 * (CornerSegments + 1)> RoundedRect(std::integer_sequence<std::uint32_t, Vertices...>, double left, double bottom, double right, double top,
+				double radius)
+			{
+				return ShapeMesh<4 * (CornerSegments + 1)>{ { CornerPoint(StripIndex(Vertices, 4 * (CornerSegments + 1)) / (CornerSegments + 1),
+					StripIndex(Vertices, 4 * (CornerSegments + 1)) % (CornerSegments + 1), CornerSegments, left, bottom, right, top, radius)... } };
+			}
+		}
+
+		// A unit circle around the origin with Segments sides.
+		template <std::uint32_t Segments>
+		constexpr ShapeMesh<Segments> Circle()
+		{
+			return Detail::Circle<Segments>(std::make_integer_sequence<std::uint32_t, Segments>());
+		}
+
+		// A rectangle whose corners are quarter circles of radius, each CornerSegments sides; square with none.
+		template <std::uint32_t CornerSegments>
+		constexpr ShapeMesh<4 * (CornerSegments + 1)> RoundedRect(float left, float bottom, float right, float top, float radius)
+		{
+			return Detail::RoundedRect<CornerSegments>(std::make_integer_sequence<std::uint32_t, 4 * (CornerSegments + 1)>(), left, bottom, right, top, radius);
+		}
+	}
+
+	// The levels of detail the shape managers draw with, coarse to fine. Each set's meshes lie back to back, so a whole set
+	// is one vertex buffer and a level is a start vertex and count in it. A draw picks the coarsest level whose outline
+	// stays within a tolerance of the true shape at its size on screen. This file only depends on the C++ standard library.
+	class ShapeMeshes final
+	{
+	public:
+		static const std::uint32_t LodCount = 4;
+		static const float DefaultTolerance;		// In pixels
+
+		struct Circles
+		{
+			ShapeMesh<8> Lod0;
+			ShapeMesh<16> Lod1;
+			ShapeMesh<32> Lod2;
+			ShapeMesh<64> Lod3;
+		};
+
+		// Corners of none, 2, 4 and 8 segments.
+		struct RoundedRects
+		{
+			ShapeMesh<4> Lod0;
+			ShapeMesh<12> Lod1;
+			ShapeMesh<20> Lod2;
+			ShapeMesh<36> Lod3;
+		};
+
+		static constexpr Circles MakeCircles()
+		{
+			return Circles{ ShapeTessellation::Circle<8>(), ShapeTessellation::Circle<16>(), ShapeTessellation::Circle<32>(), ShapeTessellation::Circle<64>() };
+		}
+
+		static constexpr RoundedRects MakeRoundedRects(float left, float bottom, float right, float top, float cornerRadius)
+		{
+			return RoundedRects{ ShapeTessellation::RoundedRect<0>(left, bottom, right, top, cornerRadius), ShapeTessellation::RoundedRect<2>(left, bottom, right, top, cornerRadius),
+				ShapeTessellation::RoundedRect<4>(left, bottom, right, top, cornerRadius), ShapeTessellation::RoundedRect<8>(left, bottom, right, top, cornerRadius) };
+		}
+
+		ShapeMeshes() = delete;
+
+		static ShapeLod CircleLod(std::uint32_t lod);
+		static ShapeLod RoundedRectLod(std::uint32_t lod);
+
+		// How far, in pixels, a level's outline strays from the true shape when the circle's radius or the corners' radius
+		// covers screenRadius pixels. Segments cut inside the arcs; square corners stick out past them.
+		static float CircleError(std::uint32_t lod, float screenRadius);
+		static float RoundedRectError(std::uint32_t lod, float screenCornerRadius);
+
+		static std::uint32_t SelectCircleLod(float screenRadius, float tolerance = DefaultTolerance);
+		static std::uint32_t SelectRoundedRectLod(float screenCornerRadius, float tolerance = DefaultTolerance);
+	};
+
+	static_assert(sizeof(ShapeMeshes::Circles) == (8 + 16 + 32 + 64) * sizeof(ShapeVertex), "A set of meshes must be one run of vertices.");
+	static_assert(sizeof(ShapeMeshes::RoundedRects) == (4 + 12 + 20 + 36) * sizeof(ShapeVertex), "A set of meshes must be one run of vertices.");
+}
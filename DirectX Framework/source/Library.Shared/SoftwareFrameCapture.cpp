@@ -0,0 +1,42 @@
+#include "SoftwareFrameCapture.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace DX
+{
+	SoftwareFrameCapture::SoftwareFrameCapture(SoftwareRenderBackend& backend, const string& path, FrameCapture::Format format, uint32_t framesPerSecond,
+		uint32_t slotCount, FrameCapture::QueuePolicy policy) :
+		mBackend(backend), mFramebuffers(max(slotCount, 1U)), mCapture(path, format, backend.Width(), backend.Height(), framesPerSecond, slotCount, policy)
+	{
+		// Sized up front so swapping a slot's buffer in as the next back buffer never allocates on the render thread.
+		for (auto& framebuffer : mFramebuffers)
+		{
+			framebuffer.assign(static_cast<size_t>(backend.RowPitch()) * backend.Height(), 0);
+		}
+	}
+
+	bool SoftwareFrameCapture::CaptureBackBuffer()
+	{
+		uint32_t slot;
+		if (!mCapture.Reserve(slot))
+		{
+			return false;
+		}
+
+		vector<uint32_t>& framebuffer = mFramebuffers[slot];
+		mBackend.SwapBackBuffer(framebuffer);
+		mCapture.Submit(slot, reinterpret_cast<const uint8_t*>(framebuffer.data()), mBackend.RowPitch() * static_cast<uint32_t>(sizeof(uint32_t)), FrameCapture::PixelLayout::Rgba8);
+		return true;
+	}
+
+	void SoftwareFrameCapture::Flush()
+	{
+		mCapture.Flush();
+	}
+
+	FrameCapture::Counters SoftwareFrameCapture::Totals() const
+	{
+		return mCapture.Totals();
+	}
+}
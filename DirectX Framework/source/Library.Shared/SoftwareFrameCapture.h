@@ -0,0 +1,39 @@
+#pragma once
+
+#include "FrameCapture.h"
+#include "SoftwareRenderBackend.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	// Feeds a SoftwareRenderBackend's back buffer to a FrameCapture without copying: each capture slot owns a framebuffer,
+	// and a captured frame is swapped out of the back buffer into its slot's framebuffer. The back buffer is left holding
+	// an older frame, so clear or redraw all of it before the next capture. Defaults to blocking, for rendering replays
+	// headless where every frame matters more than the frame rate. This file only depends on the C++ standard library.
+	class SoftwareFrameCapture final
+	{
+	public:
+		SoftwareFrameCapture(SoftwareRenderBackend& backend, const std::string& path, FrameCapture::Format format, std::uint32_t framesPerSecond,
+			std::uint32_t slotCount = FrameCapture::DefaultSlotCount, FrameCapture::QueuePolicy policy = FrameCapture::QueuePolicy::Block);
+		SoftwareFrameCapture(const SoftwareFrameCapture&) = delete;
+		SoftwareFrameCapture& operator=(const SoftwareFrameCapture&) = delete;
+		SoftwareFrameCapture(SoftwareFrameCapture&&) = delete;
+		SoftwareFrameCapture& operator=(SoftwareFrameCapture&&) = delete;
+		~SoftwareFrameCapture() = default;
+
+		// Call once the frame is drawn. Returns false if the frame was dropped.
+		bool CaptureBackBuffer();
+
+		// Waits until every captured frame has been encoded.
+		void Flush();
+
+		FrameCapture::Counters Totals() const;
+
+	private:
+		SoftwareRenderBackend& mBackend;
+		std::vector<std::vector<std::uint32_t>> mFramebuffers;
+		FrameCapture mCapture;	// Declared last so the encoder stops before the framebuffers go away
+	};
+}
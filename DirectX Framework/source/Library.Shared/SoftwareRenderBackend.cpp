@@ -0,0 +1,1226 @@
+#include "SoftwareRenderBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if !defined(DX_SOFTWARE_RASTERIZER_SCALAR) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define DX_SOFTWARE_RASTERIZER_SSE2
+#include <emmintrin.h>
+#elif !defined(DX_SOFTWARE_RASTERIZER_SCALAR) && (defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON))
+#define DX_SOFTWARE_RASTERIZER_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		const int32_t SubpixelBits = 4;
+		const int32_t SubpixelScale = 1 << SubpixelBits;
+		const float GuardBand = 8192.0f;	// Vertices are clamped to this many pixels from the origin so edge steps fit in 32 bits
+		const int32_t EdgeSaturation = 1 << 30;
+		const uint32_t PaletteSize = 8;		// Keep in sync with ShapeRendererInstancedVS.hlsl
+
+		// Four 32-bit lanes, one per pixel of a horizontal run. Masks are all ones in the lanes that pass.
+#if defined(DX_SOFTWARE_RASTERIZER_SSE2)
+		struct Int4 { __m128i V; };
+		struct Float4 { __m128 V; };
+
+		inline Int4 Splat(int32_t value) { return { _mm_set1_epi32(value) }; }
+		inline Int4 Set(int32_t x, int32_t y, int32_t z, int32_t w) { return { _mm_setr_epi32(x, y, z, w) }; }
+		inline Int4 Add(Int4 lhs, Int4 rhs) { return { _mm_add_epi32(lhs.V, rhs.V) }; }
+		inline Int4 And(Int4 lhs, Int4 rhs) { return { _mm_and_si128(lhs.V, rhs.V) }; }
+		inline Int4 Or(Int4 lhs, Int4 rhs) { return { _mm_or_si128(lhs.V, rhs.V) }; }
+		inline Int4 NotNegative(Int4 value) { return { _mm_cmpgt_epi32(value.V, _mm_set1_epi32(-1)) }; }
+		inline Int4 Less(Int4 lhs, Int4 rhs) { return { _mm_cmplt_epi32(lhs.V, rhs.V) }; }
+		inline uint32_t LaneBits(Int4 mask) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(mask.V))); }
+
+		inline Int4 Load(const uint32_t* source) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)) }; }
+
+		inline void StoreMasked(uint32_t* destination, Int4 mask, Int4 value)
+		{
+			__m128i* address = reinterpret_cast<__m128i*>(destination);
+			const __m128i existing = _mm_loadu_si128(address);
+			_mm_storeu_si128(address, _mm_or_si128(_mm_and_si128(mask.V, value.V), _mm_andnot_si128(mask.V, existing)));
+		}
+
+		inline Float4 Splat(float value) { return { _mm_set1_ps(value) }; }
+		inline Float4 Set(float x, float y, float z, float w) { return { _mm_setr_ps(x, y, z, w) }; }
+		inline Float4 Add(Float4 lhs, Float4 rhs) { return { _mm_add_ps(lhs.V, rhs.V) }; }
+		inline Float4 Multiply(Float4 lhs, Float4 rhs) { return { _mm_mul_ps(lhs.V, rhs.V) }; }
+		inline Float4 Clamp(Float4 value, Float4 low, Float4 high) { return { _mm_min_ps(_mm_max_ps(value.V, low.V), high.V) }; }
+		inline Int4 Truncate(Float4 value) { return { _mm_cvttps_epi32(value.V) }; }
+		inline void Store(int32_t* destination, Int4 value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), value.V); }
+#elif defined(DX_SOFTWARE_RASTERIZER_NEON)
+		struct Int4 { int32x4_t V; };
+		struct Float4 { float32x4_t V; };
+
+		inline Int4 Splat(int32_t value) { return { vdupq_n_s32(value) }; }
+		inline Int4 Set(int32_t x, int32_t y, int32_t z, int32_t w) { const int32_t values[4] = { x, y, z, w }; return { vld1q_s32(values) }; }
+		inline Int4 Add(Int4 lhs, Int4 rhs) { return { vaddq_s32(lhs.V, rhs.V) }; }
+		inline Int4 And(Int4 lhs, Int4 rhs) { return { vandq_s32(lhs.V, rhs.V) }; }
+		inline Int4 Or(Int4 lhs, Int4 rhs) { return { vorrq_s32(lhs.V, rhs.V) }; }
+		inline Int4 NotNegative(Int4 value) { return { vreinterpretq_s32_u32(vcgeq_s32(value.V, vdupq_n_s32(0))) }; }
+		inline Int4 Less(Int4 lhs, Int4 rhs) { return { vreinterpretq_s32_u32(vcltq_s32(lhs.V, rhs.V)) }; }
+
+		inline uint32_t LaneBits(Int4 mask)
+		{
+			static const uint32_t bits[4] = { 1, 2, 4, 8 };
+			const uint32x4_t laneBits = vandq_u32(vreinterpretq_u32_s32(mask.V), vld1q_u32(bits));
+			const uint32x2_t sums = vadd_u32(vget_low_u32(laneBits), vget_high_u32(laneBits));
+			return vget_lane_u32(sums, 0) | vget_lane_u32(sums, 1);
+		}
+
+		inline Int4 Load(const uint32_t* source) { return { vreinterpretq_s32_u32(vld1q_u32(source)) }; }
+
+		inline void StoreMasked(uint32_t* destination, Int4 mask, Int4 value)
+		{
+			const uint32x4_t existing = vld1q_u32(destination);
+			vst1q_u32(destination, vbslq_u32(vreinterpretq_u32_s32(mask.V), vreinterpretq_u32_s32(value.V), existing));
+		}
+
+		inline Float4 Splat(float value) { return { vdupq_n_f32(value) }; }
+		inline Float4 Set(float x, float y, float z, float w) { const float values[4] = { x, y, z, w }; return { vld1q_f32(values) }; }
+		inline Float4 Add(Float4 lhs, Float4 rhs) { return { vaddq_f32(lhs.V, rhs.V) }; }
+		inline Float4 Multiply(Float4 lhs, Float4 rhs) { return { vmulq_f32(lhs.V, rhs.V) }; }
+		inline Float4 Clamp(Float4 value, Float4 low, Float4 high) { return { vminq_f32(vmaxq_f32(value.V, low.V), high.V) }; }
+		inline Int4 Truncate(Float4 value) { return { vcvtq_s32_f32(value.V) }; }
+		inline void Store(int32_t* destination, Int4 value) { vst1q_s32(destination, value.V); }
+#else
+		struct Int4 { int32_t V[4]; };
+		struct Float4 { float V[4]; };
+
+		inline Int4 Splat(int32_t value) { return { { value, value, value, value } }; }
+		inline Int4 Set(int32_t x, int32_t y, int32_t z, int32_t w) { return { { x, y, z, w } }; }
+		inline Int4 Add(Int4 lhs, Int4 rhs) { return { { lhs.V[0] + rhs.V[0], lhs.V[1] + rhs.V[1], lhs.V[2] + rhs.V[2], lhs.V[3] + rhs.V[3] } }; }
+		inline Int4 And(Int4 lhs, Int4 rhs) { return { { lhs.V[0] & rhs.V[0], lhs.V[1] & rhs.V[1], lhs.V[2] & rhs.V[2], lhs.V[3] & rhs.V[3] } }; }
+		inline Int4 Or(Int4 lhs, Int4 rhs) { return { { lhs.V[0] | rhs.V[0], lhs.V[1] | rhs.V[1], lhs.V[2] | rhs.V[2], lhs.V[3] | rhs.V[3] } }; }
+		inline Int4 NotNegative(Int4 value) { return { { -(value.V[0] >= 0), -(value.V[1] >= 0), -(value.V[2] >= 0), -(value.V[3] >= 0) } }; }
+		inline Int4 Less(Int4 lhs, Int4 rhs) { return { { -(lhs.V[0] < rhs.V[0]), -(lhs.V[1] < rhs.V[1]), -(lhs.V[2] < rhs.V[2]), -(lhs.V[3] < rhs.V[3]) } }; }
+		inline uint32_t LaneBits(Int4 mask) { return (mask.V[0] & 1) | ((mask.V[1] & 1) << 1) | ((mask.V[2] & 1) << 2) | ((mask.V[3] & 1) << 3); }
+
+		inline Int4 Load(const uint32_t* source) { return { { static_cast<int32_t>(source[0]), static_cast<int32_t>(source[1]), static_cast<int32_t>(source[2]), static_cast<int32_t>(source[3]) } }; }
+
+		inline void StoreMasked(uint32_t* destination, Int4 mask, Int4 value)
+		{
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				if (mask.V[lane] != 0)
+				{
+					destination[lane] = static_cast<uint32_t>(value.V[lane]);
+				}
+			}
+		}
+
+		inline Float4 Splat(float value) { return { { value, value, value, value } }; }
+		inline Float4 Set(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+		inline Float4 Add(Float4 lhs, Float4 rhs) { return { { lhs.V[0] + rhs.V[0], lhs.V[1] + rhs.V[1], lhs.V[2] + rhs.V[2], lhs.V[3] + rhs.V[3] } }; }
+		inline Float4 Multiply(Float4 lhs, Float4 rhs) { return { { lhs.V[0] * rhs.V[0], lhs.V[1] * rhs.V[1], lhs.V[2] * rhs.V[2], lhs.V[3] * rhs.V[3] } }; }
+		inline float Clamp(float value, float low, float high) { return min(max(value, low), high); }
+		inline Float4 Clamp(Float4 value, Float4 low, Float4 high) { return { { Clamp(value.V[0], low.V[0], high.V[0]), Clamp(value.V[1], low.V[1], high.V[1]), Clamp(value.V[2], low.V[2], high.V[2]), Clamp(value.V[3], low.V[3], high.V[3]) } }; }
+		inline Int4 Truncate(Float4 value) { return { { static_cast<int32_t>(value.V[0]), static_cast<int32_t>(value.V[1]), static_cast<int32_t>(value.V[2]), static_cast<int32_t>(value.V[3]) } }; }
+		inline void Store(int32_t* destination, Int4 value) { memcpy(destination, value.V, sizeof(value.V)); }
+#endif
+
+		const uint32_t LaneCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+		uint32_t PackColor(const float* rgba)
+		{
+			uint32_t packed = 0;
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				const float value = min(max(rgba[channel], 0.0f), 1.0f);
+				packed |= static_cast<uint32_t>(value * 255.0f + 0.5f) << (channel * 8);
+			}
+
+			return packed;
+		}
+
+		// x / 255, rounded, for x up to 255 * 255 in each 16-bit half.
+		inline uint32_t DivideBy255(uint32_t x)
+		{
+			x += 0x00800080;
+			return ((x + ((x >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+		}
+
+		// Source over destination by source alpha, two channels per multiply.
+		inline uint32_t Blend(uint32_t source, uint32_t destination)
+		{
+			const uint32_t alpha = source >> 24;
+			if (alpha == 255)
+			{
+				return source;
+			}
+
+			if (alpha == 0)
+			{
+				return destination;
+			}
+
+			const uint32_t inverse = 255 - alpha;
+			const uint32_t redBlue = DivideBy255((source & 0x00FF00FF) * alpha + (destination & 0x00FF00FF) * inverse);
+			const uint32_t green = DivideBy255(((source >> 8) & 0xFF) * alpha + ((destination >> 8) & 0xFF) * inverse);
+			const uint32_t resultAlpha = alpha + DivideBy255((destination >> 24) * inverse);
+			return redBlue | (green << 8) | (resultAlpha << 24);
+		}
+
+		// Lerps all four channels, weight in 1/256ths of the way from first to second.
+		inline uint32_t Lerp(uint32_t first, uint32_t second, uint32_t weight)
+		{
+			const uint32_t redBlue = ((((first & 0x00FF00FF) * (256 - weight) + (second & 0x00FF00FF) * weight + 0x00800080) >> 8) & 0x00FF00FF);
+			const uint32_t alphaGreen = ((((first >> 8) & 0x00FF00FF) * (256 - weight) + ((second >> 8) & 0x00FF00FF) * weight + 0x00800080) & 0xFF00FF00);
+			return redBlue | alphaGreen;
+		}
+
+		// Bilinear filtering of texels rows pitch apart. Coordinates are in 1/256ths of a texel, already clamped to the
+		// texture, and the fraction is the weight.
+		inline uint32_t SampleBilinear(const uint32_t* texels, uint32_t pitch, uint32_t lastX, uint32_t lastY, uint32_t fixedX, uint32_t fixedY)
+		{
+			const uint32_t x0 = fixedX >> 8;
+			const uint32_t y0 = fixedY >> 8;
+			const uint32_t x1 = min(x0 + 1, lastX);
+			const uint32_t* row0 = texels + static_cast<size_t>(y0) * pitch;
+			const uint32_t* row1 = texels + static_cast<size_t>(min(y0 + 1, lastY)) * pitch;
+
+			const uint32_t weightX = fixedX & 0xFF;
+			return Lerp(Lerp(row0[x0], row0[x1], weightX), Lerp(row1[x0], row1[x1], weightX), fixedY & 0xFF);
+		}
+
+		// Blend for four pixels, each by its own source alpha, rounding exactly as the scalar version does.
+#if defined(DX_SOFTWARE_RASTERIZER_SSE2)
+		inline __m128i DivideBy255(__m128i x)
+		{
+			x = _mm_add_epi16(x, _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+		}
+
+		inline __m128i BlendHalf(__m128i source, __m128i destination)
+		{
+			// Alpha broadcast to the pixel's four channels; the alpha channel itself is weighted by 255 instead.
+			const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128i sourceWeight = _mm_max_epi16(alpha, _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255));
+			const __m128i destinationWeight = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+			return DivideBy255(_mm_add_epi16(_mm_mullo_epi16(source, sourceWeight), _mm_mullo_epi16(destination, destinationWeight)));
+		}
+
+		inline Int4 Blend(Int4 source, Int4 destination)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i low = BlendHalf(_mm_unpacklo_epi8(source.V, zero), _mm_unpacklo_epi8(destination.V, zero));
+			const __m128i high = BlendHalf(_mm_unpackhi_epi8(source.V, zero), _mm_unpackhi_epi8(destination.V, zero));
+			return { _mm_packus_epi16(low, high) };
+		}
+#elif defined(DX_SOFTWARE_RASTERIZER_NEON)
+		inline uint8x8_t BlendHalf(uint8x8_t source, uint8x8_t destination, uint8x8_t sourceWeight, uint8x8_t destinationWeight)
+		{
+			uint16x8_t x = vmlal_u8(vmull_u8(source, sourceWeight), destination, destinationWeight);
+			x = vaddq_u16(x, vdupq_n_u16(128));
+			return vshrn_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+		}
+
+		inline Int4 Blend(Int4 source, Int4 destination)
+		{
+			// Alpha broadcast to the pixel's four bytes; the alpha channel itself is weighted by 255 instead.
+			const uint32x4_t alpha = vmulq_n_u32(vshrq_n_u32(vreinterpretq_u32_s32(source.V), 24), 0x01010101);
+			const uint8x16_t sourceWeight = vreinterpretq_u8_u32(vorrq_u32(alpha, vdupq_n_u32(0xFF000000)));
+			const uint8x16_t destinationWeight = vmvnq_u8(vreinterpretq_u8_u32(alpha));
+			const uint8x16_t sourceBytes = vreinterpretq_u8_s32(source.V);
+			const uint8x16_t destinationBytes = vreinterpretq_u8_s32(destination.V);
+			const uint8x8_t low = BlendHalf(vget_low_u8(sourceBytes), vget_low_u8(destinationBytes), vget_low_u8(sourceWeight), vget_low_u8(destinationWeight));
+			const uint8x8_t high = BlendHalf(vget_high_u8(sourceBytes), vget_high_u8(destinationBytes), vget_high_u8(sourceWeight), vget_high_u8(destinationWeight));
+			return { vreinterpretq_s32_u8(vcombine_u8(low, high)) };
+		}
+#else
+		inline Int4 Blend(Int4 source, Int4 destination)
+		{
+			Int4 result;
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				result.V[lane] = static_cast<int32_t>(Blend(static_cast<uint32_t>(source.V[lane]), static_cast<uint32_t>(destination.V[lane])));
+			}
+
+			return result;
+		}
+#endif
+
+		// Multiplies a row vector by a matrix stored transposed, as mul(position, matrix) does in the shaders.
+		void Transform(const float* matrix, float x, float y, float z, float w, float (&clip)[4])
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				const float* row = matrix + column * 4;
+				clip[column] = x * row[0] + y * row[1] + z * row[2] + w * row[3];
+			}
+		}
+
+		int32_t Snap(float coordinate)
+		{
+			const float clamped = min(max(coordinate, -GuardBand), GuardBand);
+			return static_cast<int32_t>(floor(clamped * SubpixelScale + 0.5f));
+		}
+
+		int32_t FloorDivide(int32_t value, int32_t divisor)
+		{
+			return (value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor));
+		}
+
+		int32_t Saturate(int64_t value)
+		{
+			return static_cast<int32_t>(min<int64_t>(max<int64_t>(value, -EdgeSaturation), EdgeSaturation));
+		}
+	}
+
+	SoftwareRenderBackend::SoftwareRenderBackend(uint32_t width, uint32_t height, uint32_t threadCount) :
+		mBackBuffer(MakeSurface(width, height)), mTarget(&mBackBuffer), mScissor(), mScissorEnabled(false), mSpriteViewProjection(), mTileColumns(0),
+		mTileRows(0), mThreadCount(0), mGeneration(0), mPendingWorkers(0), mShuttingDown(false), mTotals()
+	{
+		mSpriteViewProjection[0] = mSpriteViewProjection[5] = mSpriteViewProjection[10] = mSpriteViewProjection[15] = 1.0f;
+		SetTarget(mBackBuffer);
+
+		if (threadCount == 0)
+		{
+			threadCount = max(thread::hardware_concurrency(), 1U);
+		}
+
+		mThreadCount = threadCount;
+		mTileQueues.reset(new TileQueue[mThreadCount]);
+		mThreadTotals.resize(mThreadCount);
+
+		// The calling thread rasterizes as thread zero.
+		mWorkers.reserve(mThreadCount - 1);
+		for (uint32_t worker = 1; worker < mThreadCount; ++worker)
+		{
+			mWorkers.emplace_back(&SoftwareRenderBackend::WorkerMain, this, worker);
+		}
+	}
+
+	SoftwareRenderBackend::~SoftwareRenderBackend()
+	{
+		{
+			lock_guard<mutex> lock(mMutex);
+			mShuttingDown = true;
+		}
+
+		mWorkAvailable.notify_all();
+
+		for (auto& worker : mWorkers)
+		{
+			worker.join();
+		}
+	}
+
+	uint32_t SoftwareRenderBackend::ThreadCount() const
+	{
+		return mThreadCount;
+	}
+
+	PipelineHandle SoftwareRenderBackend::CreatePipeline(const Pipeline& pipeline)
+	{
+		PipelineState state;
+		state.Description = pipeline;
+		mPipelines.push_back(state);
+		return static_cast<PipelineHandle>(mPipelines.size() - 1);
+	}
+
+	MeshHandle SoftwareRenderBackend::CreateMesh(const Mesh& mesh)
+	{
+		MeshData data;
+		const uint8_t* vertices = static_cast<const uint8_t*>(mesh.Vertices);
+		data.Vertices.assign(vertices, vertices + static_cast<size_t>(mesh.VertexCount) * mesh.Stride);
+		data.VertexCount = mesh.VertexCount;
+		data.Stride = mesh.Stride;
+		data.Instances.resize(static_cast<size_t>(mesh.InstanceCapacity) * mesh.InstanceStride);
+		data.InstanceStride = mesh.InstanceStride;
+		mMeshes.push_back(move(data));
+		return static_cast<MeshHandle>(mMeshes.size() - 1);
+	}
+
+	RenderTargetHandle SoftwareRenderBackend::CreateRenderTarget(uint32_t width, uint32_t height)
+	{
+		mSurfaces.push_back(MakeSurface(width, height));
+		SetTarget(mBackBuffer);
+		return static_cast<RenderTargetHandle>(mSurfaces.size() - 1);
+	}
+
+	SpriteTextureHandle SoftwareRenderBackend::CreateTexture(uint32_t width, uint32_t height, const uint8_t* pixels, uint32_t rowPitch)
+	{
+		Surface surface = MakeSurface(width, height);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			memcpy(&surface.Pixels[static_cast<size_t>(y) * surface.Pitch], pixels + static_cast<size_t>(y) * rowPitch, width * sizeof(uint32_t));
+		}
+
+		mSurfaces.push_back(move(surface));
+		SetTarget(mBackBuffer);
+		return static_cast<SpriteTextureHandle>(mSurfaces.size() - 1);
+	}
+
+	void SoftwareRenderBackend::SetSpriteViewProjection(const float (&viewProjection)[16])
+	{
+		memcpy(mSpriteViewProjection, viewProjection, sizeof(mSpriteViewProjection));
+	}
+
+	void SoftwareRenderBackend::Execute(const RenderCommandList& commandList)
+	{
+		++mTotals.Executions;
+		SetTarget(mBackBuffer);
+		mScissorEnabled = false;
+
+		PipelineState* pipeline = nullptr;
+		MeshData* mesh = nullptr;
+		const Surface* texture = nullptr;
+
+		const RenderCommand* commands = commandList.Commands();
+		for (size_t i = 0; i < commandList.CommandCount(); ++i)
+		{
+			const RenderCommand& command = commands[i];
+			switch (command.Type)
+			{
+			case RenderCommandType::SetPipeline:
+				pipeline = &mPipelines[command.Pipeline];
+				break;
+
+			case RenderCommandType::SetMesh:
+				mesh = &mMeshes[command.Mesh];
+				break;
+
+			case RenderCommandType::SetConstants:
+			{
+				vector<uint8_t>& constants = (command.Stage == ShaderStage::Vertex ? pipeline->VertexConstants : pipeline->PixelConstants);
+				constants.assign(commandList.Data(command), commandList.Data(command) + command.DataSize);
+				break;
+			}
+
+			case RenderCommandType::UpdateInstances:
+			{
+				const size_t size = min<size_t>(command.DataSize, mesh->Instances.size());
+				if (size > 0)
+				{
+					memcpy(mesh->Instances.data(), commandList.Data(command), size);
+				}
+				break;
+			}
+
+			case RenderCommandType::Draw:
+				DrawMesh(*pipeline, *mesh, texture, command.VertexCount, command.StartVertex, 1);
+				++mTotals.Draws;
+				break;
+
+			case RenderCommandType::DrawInstanced:
+				DrawMesh(*pipeline, *mesh, texture, command.VertexCount, command.StartVertex, command.InstanceCount);
+				++mTotals.Draws;
+				break;
+
+			case RenderCommandType::SetRenderTarget:
+				SetTarget(SurfaceFor(command.Target));
+				texture = nullptr;
+				break;
+
+			case RenderCommandType::ClearRenderTarget:
+			{
+				float color[4];
+				memcpy(color, commandList.Data(command), sizeof(color));
+				const uint32_t packed = PackColor(color);
+
+				PixelRect rect = { 0, 0, mTarget->Width, mTarget->Height };
+				if (command.DataSize > sizeof(color))
+				{
+					memcpy(&rect, commandList.Data(command) + sizeof(color), sizeof(rect));
+				}
+
+				DrawClear(rect, packed);
+				break;
+			}
+
+			case RenderCommandType::SetScissor:
+				mScissorEnabled = (command.DataSize > 0);
+				if (mScissorEnabled)
+				{
+					memcpy(&mScissor, commandList.Data(command), sizeof(mScissor));
+				}
+				break;
+
+			case RenderCommandType::SetTexture:
+				texture = &SurfaceFor(command.Target);
+				break;
+			}
+		}
+
+		Flush();
+	}
+
+	SpriteInstance* SoftwareRenderBackend::Map(uint32_t& capacity, uint32_t& firstInstance)
+	{
+		if (mSpriteInstances.empty())
+		{
+			mSpriteInstances.resize(DefaultSpriteCapacity);
+		}
+
+		capacity = static_cast<uint32_t>(mSpriteInstances.size());
+		firstInstance = 0;
+		return mSpriteInstances.data();
+	}
+
+	void SoftwareRenderBackend::Unmap(uint32_t instanceCount)
+	{
+		// Sprites are drawn straight from the mapped storage.
+		(void)instanceCount;
+	}
+
+	void SoftwareRenderBackend::DrawBatch(SpriteTextureHandle texture, uint32_t firstInstance, uint32_t instanceCount)
+	{
+		// The unit quad as D3D11SpriteBatchTarget builds it: position, then texture coordinates, in strip order.
+		static const float Quad[4][4] =
+		{
+			{ -1.0f, -1.0f, 0.0f, 1.0f },
+			{ -1.0f, 1.0f, 0.0f, 0.0f },
+			{ 1.0f, -1.0f, 1.0f, 1.0f },
+			{ 1.0f, 1.0f, 1.0f, 0.0f }
+		};
+
+		Surface& target = *mTarget;
+		const bool scissorEnabled = mScissorEnabled;
+		SetTarget(mBackBuffer);
+		mScissorEnabled = false;
+
+		const Fill fill = { ShaderType::Textured, 0, true, (texture < mSurfaces.size() ? &mSurfaces[texture] : nullptr) };
+		const float width = static_cast<float>(mBackBuffer.Width);
+		const float height = static_cast<float>(mBackBuffer.Height);
+
+		for (uint32_t i = 0; i < instanceCount; ++i)
+		{
+			const SpriteInstance& sprite = mSpriteInstances[firstInstance + i];
+			const float sine = sin(sprite.Rotation);
+			const float cosine = cos(sprite.Rotation);
+
+			ScreenVertex vertices[4];
+			for (int corner = 0; corner < 4; ++corner)
+			{
+				const float scaledX = Quad[corner][0] * sprite.Scale[0];
+				const float scaledY = Quad[corner][1] * sprite.Scale[1];
+				float clip[4];
+				Transform(mSpriteViewProjection, scaledX * cosine - scaledY * sine + sprite.Position[0], scaledX * sine + scaledY * cosine + sprite.Position[1], 0.0f, 1.0f, clip);
+
+				ScreenVertex& vertex = vertices[corner];
+				vertex.Visible = (clip[3] > 0.0f);
+				vertex.X = (vertex.Visible ? (clip[0] / clip[3] + 1.0f) * 0.5f * width : 0.0f);
+				vertex.Y = (vertex.Visible ? (1.0f - clip[1] / clip[3]) * 0.5f * height : 0.0f);
+				vertex.U = sprite.UVRect[0] + (sprite.UVRect[2] - sprite.UVRect[0]) * Quad[corner][2];
+				vertex.V = sprite.UVRect[1] + (sprite.UVRect[3] - sprite.UVRect[1]) * Quad[corner][3];
+			}
+
+			DrawPrimitives(PrimitiveType::TriangleStrip, vertices, 4, fill);
+		}
+
+		mTotals.Sprites += instanceCount;
+		Flush();
+		SetTarget(target);
+		mScissorEnabled = scissorEnabled;
+	}
+
+	uint32_t SoftwareRenderBackend::Width(RenderTargetHandle target) const
+	{
+		return SurfaceFor(target).Width;
+	}
+
+	uint32_t SoftwareRenderBackend::Height(RenderTargetHandle target) const
+	{
+		return SurfaceFor(target).Height;
+	}
+
+	uint32_t SoftwareRenderBackend::RowPitch(RenderTargetHandle target) const
+	{
+		return SurfaceFor(target).Pitch;
+	}
+
+	const uint32_t* SoftwareRenderBackend::Pixels(RenderTargetHandle target) const
+	{
+		return SurfaceFor(target).Pixels.data();
+	}
+
+	void SoftwareRenderBackend::SwapBackBuffer(vector<uint32_t>& pixels)
+	{
+		pixels.resize(mBackBuffer.Pixels.size());
+		mBackBuffer.Pixels.swap(pixels);
+	}
+
+	const SoftwareRenderBackend::Counters& SoftwareRenderBackend::Totals() const
+	{
+		return mTotals;
+	}
+
+	void SoftwareRenderBackend::ResetCounters()
+	{
+		mTotals = Counters();
+	}
+
+	SoftwareRenderBackend::Surface SoftwareRenderBackend::MakeSurface(uint32_t width, uint32_t height)
+	{
+		Surface surface;
+		surface.Width = width;
+		surface.Height = height;
+		surface.Pitch = (width + 3) & ~3U;
+		surface.Pixels.assign(static_cast<size_t>(surface.Pitch) * height, 0);
+		return surface;
+	}
+
+	SoftwareRenderBackend::Surface& SoftwareRenderBackend::SurfaceFor(RenderTargetHandle target)
+	{
+		return (target == RenderCommandList::BackBuffer ? mBackBuffer : mSurfaces[target]);
+	}
+
+	const SoftwareRenderBackend::Surface& SoftwareRenderBackend::SurfaceFor(RenderTargetHandle target) const
+	{
+		return (target == RenderCommandList::BackBuffer ? mBackBuffer : mSurfaces[target]);
+	}
+
+	void SoftwareRenderBackend::DrawMesh(const PipelineState& pipeline, const MeshData& mesh, const Surface* texture, uint32_t vertexCount, uint32_t startVertex,
+		uint32_t instanceCount)
+	{
+		// Without a matrix the vertex shader would read zeros and every vertex would land behind the eye.
+		const vector<uint8_t>& vertexConstants = pipeline.VertexConstants;
+		if (vertexConstants.size() < sizeof(float) * 16)
+		{
+			return;
+		}
+
+		float matrix[16];
+		memcpy(matrix, vertexConstants.data(), sizeof(matrix));
+
+		const ShaderType shader = pipeline.Description.Shader;
+		Fill fill = { shader, 0, pipeline.Description.AlphaBlend, texture };
+		if (shader == ShaderType::SolidColor && pipeline.PixelConstants.size() >= sizeof(float) * 4)
+		{
+			float color[4];
+			memcpy(color, pipeline.PixelConstants.data(), sizeof(color));
+			fill.Color = PackColor(color);
+		}
+
+		const float width = static_cast<float>(mTarget->Width);
+		const float height = static_cast<float>(mTarget->Height);
+		const bool textured = (shader == ShaderType::Textured && mesh.Stride >= sizeof(float) * 6);
+		mScreenVertices.resize(vertexCount);
+
+		for (uint32_t instance = 0; instance < instanceCount; ++instance)
+		{
+			float offset[2] = { 0.0f, 0.0f };
+			float scale = 1.0f;
+			if (shader == ShaderType::PaletteInstanced || shader == ShaderType::ColorInstanced)
+			{
+				// Offset and scale, then the palette index, as ChunkManager::ChunkInstance lays them out, or the color, as
+				// ParticleInstance does.
+				const size_t instanceOffset = static_cast<size_t>(instance) * mesh.InstanceStride;
+				if (mesh.InstanceStride < sizeof(float) * 4 || instanceOffset + mesh.InstanceStride > mesh.Instances.size())
+				{
+					break;
+				}
+
+				uint32_t paletteIndexOrColor;
+				memcpy(offset, &mesh.Instances[instanceOffset], sizeof(offset));
+				memcpy(&scale, &mesh.Instances[instanceOffset + sizeof(offset)], sizeof(scale));
+				memcpy(&paletteIndexOrColor, &mesh.Instances[instanceOffset + sizeof(offset) + sizeof(scale)], sizeof(paletteIndexOrColor));
+
+				if (shader == ShaderType::ColorInstanced)
+				{
+					fill.Color = paletteIndexOrColor;
+				}
+				else
+				{
+					float color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+					const size_t colorOffset = sizeof(matrix) + (paletteIndexOrColor % PaletteSize) * sizeof(color);
+					if (colorOffset + sizeof(color) <= vertexConstants.size())
+					{
+						memcpy(color, &vertexConstants[colorOffset], sizeof(color));
+					}
+
+					fill.Color = PackColor(color);
+				}
+			}
+
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				// Reads past the end of the vertex buffer return zeros, as they do on the GPU.
+				float attributes[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+				const uint32_t index = startVertex + i;
+				if (index < mesh.VertexCount)
+				{
+					memcpy(attributes, &mesh.Vertices[static_cast<size_t>(index) * mesh.Stride], (textured ? sizeof(float) * 6 : sizeof(float) * 4));
+				}
+
+				float clip[4];
+				Transform(matrix, attributes[0] * scale + offset[0], attributes[1] * scale + offset[1], attributes[2], attributes[3], clip);
+
+				ScreenVertex& vertex = mScreenVertices[i];
+				vertex.Visible = (clip[3] > 0.0f);
+				vertex.X = (vertex.Visible ? (clip[0] / clip[3] + 1.0f) * 0.5f * width : 0.0f);
+				vertex.Y = (vertex.Visible ? (1.0f - clip[1] / clip[3]) * 0.5f * height : 0.0f);
+				vertex.U = attributes[4];
+				vertex.V = attributes[5];
+			}
+
+			DrawPrimitives(pipeline.Description.Topology, mScreenVertices.data(), vertexCount, fill);
+		}
+	}
+
+	void SoftwareRenderBackend::DrawPrimitives(PrimitiveType topology, const ScreenVertex* vertices, uint32_t vertexCount, const Fill& fill)
+	{
+		switch (topology)
+		{
+		case PrimitiveType::TriangleList:
+			for (uint32_t i = 0; i + 2 < vertexCount; i += 3)
+			{
+				DrawTriangle(vertices[i], vertices[i + 1], vertices[i + 2], fill);
+			}
+			break;
+
+		case PrimitiveType::TriangleStrip:
+			// Odd triangles are flipped so the whole strip keeps the first triangle's winding.
+			for (uint32_t i = 0; i + 2 < vertexCount; ++i)
+			{
+				if ((i & 1) == 0)
+				{
+					DrawTriangle(vertices[i], vertices[i + 1], vertices[i + 2], fill);
+				}
+				else
+				{
+					DrawTriangle(vertices[i + 1], vertices[i], vertices[i + 2], fill);
+				}
+			}
+			break;
+
+		case PrimitiveType::LineStrip:
+			for (uint32_t i = 0; i + 1 < vertexCount; ++i)
+			{
+				DrawLine(vertices[i], vertices[i + 1], fill.Color);
+			}
+			break;
+		}
+	}
+
+	void SoftwareRenderBackend::DrawTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, const Fill& fill)
+	{
+		if (!a.Visible || !b.Visible || !c.Visible)
+		{
+			++mTotals.CulledTriangles;
+			return;
+		}
+
+		Triangle triangle;
+		int32_t (&x)[3] = triangle.X;
+		int32_t (&y)[3] = triangle.Y;
+		x[0] = Snap(a.X);
+		x[1] = Snap(b.X);
+		x[2] = Snap(c.X);
+		y[0] = Snap(a.Y);
+		y[1] = Snap(b.Y);
+		y[2] = Snap(c.Y);
+
+		// Clockwise on screen (y down) is front facing, as with the default rasterizer state.
+		const int64_t area = static_cast<int64_t>(x[1] - x[0]) * (y[2] - y[0]) - static_cast<int64_t>(y[1] - y[0]) * (x[2] - x[0]);
+		if (area <= 0)
+		{
+			++mTotals.CulledTriangles;
+			return;
+		}
+
+		const bool textured = (fill.Shader == ShaderType::Textured || fill.Shader == ShaderType::LayerComposite);
+		if (textured && (fill.Texture == nullptr || fill.Texture->Width == 0 || fill.Texture->Height == 0))
+		{
+			return;
+		}
+
+		++mTotals.Triangles;
+
+		// Pixels whose centers could be inside, clipped to the target and scissor.
+		const PixelRect clip = ClipRect();
+		const int32_t minX = max(FloorDivide(min(min(x[0], x[1]), x[2]) - SubpixelScale / 2 + SubpixelScale - 1, SubpixelScale), static_cast<int32_t>(clip.Left));
+		const int32_t maxX = min(FloorDivide(max(max(x[0], x[1]), x[2]) - SubpixelScale / 2, SubpixelScale) + 1, static_cast<int32_t>(clip.Right));
+		const int32_t minY = max(FloorDivide(min(min(y[0], y[1]), y[2]) - SubpixelScale / 2 + SubpixelScale - 1, SubpixelScale), static_cast<int32_t>(clip.Top));
+		const int32_t maxY = min(FloorDivide(max(max(y[0], y[1]), y[2]) - SubpixelScale / 2, SubpixelScale) + 1, static_cast<int32_t>(clip.Bottom));
+		if (minX >= maxX || minY >= maxY)
+		{
+			return;
+		}
+
+		triangle.Bounds = { static_cast<uint32_t>(minX), static_cast<uint32_t>(minY), static_cast<uint32_t>(maxX), static_cast<uint32_t>(maxY) };
+		triangle.Shading = fill;
+
+		// Texture coordinates are interpolated linearly in screen space; every pipeline here is orthographic.
+		triangle.OriginX = static_cast<float>(x[0]) / SubpixelScale;
+		triangle.OriginY = static_cast<float>(y[0]) / SubpixelScale;
+		triangle.U = a.U;
+		triangle.V = a.V;
+		const float abx = static_cast<float>(x[1] - x[0]) / SubpixelScale;
+		const float aby = static_cast<float>(y[1] - y[0]) / SubpixelScale;
+		const float acx = static_cast<float>(x[2] - x[0]) / SubpixelScale;
+		const float acy = static_cast<float>(y[2] - y[0]) / SubpixelScale;
+		const float determinant = abx * acy - aby * acx;
+		triangle.DuDx = ((b.U - a.U) * acy - (c.U - a.U) * aby) / determinant;
+		triangle.DuDy = ((c.U - a.U) * abx - (b.U - a.U) * acx) / determinant;
+		triangle.DvDx = ((b.V - a.V) * acy - (c.V - a.V) * aby) / determinant;
+		triangle.DvDy = ((c.V - a.V) * abx - (b.V - a.V) * acx) / determinant;
+
+		const uint32_t index = static_cast<uint32_t>(mTriangles.size());
+		mTriangles.push_back(triangle);
+
+		// Tiles inside the bounds are skipped when one edge misses all of their pixels: the pixel center furthest along
+		// the edge's inward normal is tested, with the same bias the rasterizer uses.
+		for (uint32_t tileY = triangle.Bounds.Top / TileSize; tileY * TileSize < triangle.Bounds.Bottom; ++tileY)
+		{
+			for (uint32_t tileX = triangle.Bounds.Left / TileSize; tileX * TileSize < triangle.Bounds.Right; ++tileX)
+			{
+				const int64_t left = max(static_cast<int32_t>(tileX * TileSize), minX);
+				const int64_t top = max(static_cast<int32_t>(tileY * TileSize), minY);
+				const int64_t right = min(static_cast<int32_t>((tileX + 1) * TileSize), maxX) - 1;
+				const int64_t bottom = min(static_cast<int32_t>((tileY + 1) * TileSize), maxY) - 1;
+
+				bool covered = true;
+				for (int k = 0; k < 3 && covered; ++k)
+				{
+					const int next = (k + 1) % 3;
+					const int64_t dx = x[next] - x[k];
+					const int64_t dy = y[next] - y[k];
+					const bool topLeft = (dy < 0 || (dy == 0 && dx > 0));
+					const int64_t pixelX = (dy < 0 ? right : left) * SubpixelScale + SubpixelScale / 2;
+					const int64_t pixelY = (dx > 0 ? bottom : top) * SubpixelScale + SubpixelScale / 2;
+					covered = (dx * (pixelY - y[k]) - dy * (pixelX - x[k]) - (topLeft ? 0 : 1) >= 0);
+				}
+
+				if (covered)
+				{
+					Bin(BinEntryType::Triangle, index, tileX, tileY);
+				}
+			}
+		}
+	}
+
+	void SoftwareRenderBackend::DrawLine(const ScreenVertex& a, const ScreenVertex& b, uint32_t color)
+	{
+		if (!a.Visible || !b.Visible)
+		{
+			return;
+		}
+
+		++mTotals.Lines;
+
+		// Binned by the pixels between the end points, widened by one so rounding along the line can't escape them.
+		const Line line = { a, b, color, ClipRect() };
+		const float fromX = min(max(a.X, -GuardBand), GuardBand);
+		const float fromY = min(max(a.Y, -GuardBand), GuardBand);
+		const float toX = min(max(b.X, -GuardBand), GuardBand);
+		const float toY = min(max(b.Y, -GuardBand), GuardBand);
+		const int32_t left = max(static_cast<int32_t>(floor(min(fromX, toX))) - 1, static_cast<int32_t>(line.Clip.Left));
+		const int32_t top = max(static_cast<int32_t>(floor(min(fromY, toY))) - 1, static_cast<int32_t>(line.Clip.Top));
+		const int32_t right = min(static_cast<int32_t>(floor(max(fromX, toX))) + 2, static_cast<int32_t>(line.Clip.Right));
+		const int32_t bottom = min(static_cast<int32_t>(floor(max(fromY, toY))) + 2, static_cast<int32_t>(line.Clip.Bottom));
+		if (left >= right || top >= bottom)
+		{
+			return;
+		}
+
+		const uint32_t index = static_cast<uint32_t>(mLines.size());
+		mLines.push_back(line);
+		for (uint32_t tileY = static_cast<uint32_t>(top) / TileSize; tileY * TileSize < static_cast<uint32_t>(bottom); ++tileY)
+		{
+			for (uint32_t tileX = static_cast<uint32_t>(left) / TileSize; tileX * TileSize < static_cast<uint32_t>(right); ++tileX)
+			{
+				Bin(BinEntryType::Line, index, tileX, tileY);
+			}
+		}
+	}
+
+	void SoftwareRenderBackend::DrawClear(const PixelRect& rect, uint32_t color)
+	{
+		const Clear clear = { { rect.Left, rect.Top, min(rect.Right, mTarget->Width), min(rect.Bottom, mTarget->Height) }, color };
+		if (clear.Rect.Left >= clear.Rect.Right || clear.Rect.Top >= clear.Rect.Bottom)
+		{
+			return;
+		}
+
+		const uint32_t index = static_cast<uint32_t>(mClears.size());
+		mClears.push_back(clear);
+		for (uint32_t tileY = clear.Rect.Top / TileSize; tileY * TileSize < clear.Rect.Bottom; ++tileY)
+		{
+			for (uint32_t tileX = clear.Rect.Left / TileSize; tileX * TileSize < clear.Rect.Right; ++tileX)
+			{
+				Bin(BinEntryType::Clear, index, tileX, tileY);
+			}
+		}
+	}
+
+	void SoftwareRenderBackend::SetTarget(Surface& target)
+	{
+		Flush();
+
+		mTarget = &target;
+		mTileColumns = (target.Width + TileSize - 1) / TileSize;
+		mTileRows = (target.Height + TileSize - 1) / TileSize;
+		if (mBins.size() < static_cast<size_t>(mTileColumns) * mTileRows)
+		{
+			mBins.resize(static_cast<size_t>(mTileColumns) * mTileRows);
+		}
+	}
+
+	PixelRect SoftwareRenderBackend::ClipRect() const
+	{
+		PixelRect clip = { 0, 0, mTarget->Width, mTarget->Height };
+		if (mScissorEnabled)
+		{
+			clip.Left = max(clip.Left, mScissor.Left);
+			clip.Top = max(clip.Top, mScissor.Top);
+			clip.Right = min(clip.Right, mScissor.Right);
+			clip.Bottom = min(clip.Bottom, mScissor.Bottom);
+		}
+
+		return clip;
+	}
+
+	void SoftwareRenderBackend::Bin(BinEntryType type, uint32_t index, uint32_t tileX, uint32_t tileY)
+	{
+		const uint32_t tile = tileY * mTileColumns + tileX;
+		vector<uint32_t>& bin = mBins[tile];
+		if (bin.empty())
+		{
+			mActiveTiles.push_back(tile);
+		}
+
+		bin.push_back((static_cast<uint32_t>(type) << 30) | index);
+		++mTotals.BinEntries;
+	}
+
+	void SoftwareRenderBackend::Flush()
+	{
+		if (!mActiveTiles.empty())
+		{
+			++mTotals.Passes;
+
+			// In screen order, so each thread's share of the tiles starts out as one band of the target.
+			sort(mActiveTiles.begin(), mActiveTiles.end());
+			const uint64_t tileCount = mActiveTiles.size();
+			for (uint32_t worker = 0; worker < mThreadCount; ++worker)
+			{
+				mTileQueues[worker].Next.store(static_cast<uint32_t>(tileCount * worker / mThreadCount), memory_order_relaxed);
+				mTileQueues[worker].End = static_cast<uint32_t>(tileCount * (worker + 1) / mThreadCount);
+			}
+
+			if (mThreadCount > 1)
+			{
+				{
+					lock_guard<mutex> lock(mMutex);
+					++mGeneration;
+					mPendingWorkers = mThreadCount - 1;
+				}
+
+				mWorkAvailable.notify_all();
+			}
+
+			RunTiles(0);
+
+			if (mThreadCount > 1)
+			{
+				unique_lock<mutex> lock(mMutex);
+				mWorkComplete.wait(lock, [this]() { return mPendingWorkers == 0; });
+			}
+
+			for (Counters& totals : mThreadTotals)
+			{
+				mTotals.PixelsShaded += totals.PixelsShaded;
+				mTotals.TilesRasterized += totals.TilesRasterized;
+				mTotals.StolenTiles += totals.StolenTiles;
+				totals = Counters();
+			}
+
+			for (uint32_t tile : mActiveTiles)
+			{
+				mBins[tile].clear();
+			}
+
+			mActiveTiles.clear();
+		}
+
+		mTriangles.clear();
+		mLines.clear();
+		mClears.clear();
+	}
+
+	void SoftwareRenderBackend::RunTiles(uint32_t thread)
+	{
+		Surface& target = *mTarget;
+		Counters totals = Counters();
+
+		for (uint32_t offset = 0; offset < mThreadCount; ++offset)
+		{
+			TileQueue& queue = mTileQueues[(thread + offset) % mThreadCount];
+			for (uint32_t next = queue.Next.fetch_add(1, memory_order_relaxed); next < queue.End; next = queue.Next.fetch_add(1, memory_order_relaxed))
+			{
+				const uint32_t tile = mActiveTiles[next];
+				const uint32_t tileX = (tile % mTileColumns) * TileSize;
+				const uint32_t tileY = (tile / mTileColumns) * TileSize;
+				const PixelRect rect = { tileX, tileY, min(tileX + TileSize, target.Width), min(tileY + TileSize, target.Height) };
+
+				for (uint32_t entry : mBins[tile])
+				{
+					const uint32_t index = entry & 0x3FFFFFFFU;
+					switch (static_cast<BinEntryType>(entry >> 30))
+					{
+					case BinEntryType::Triangle:
+						RasterizeTriangle(mTriangles[index], rect, target, totals);
+						break;
+
+					case BinEntryType::Line:
+						RasterizeLine(mLines[index], rect, target, totals);
+						break;
+
+					case BinEntryType::Clear:
+					{
+						const Clear& clear = mClears[index];
+						const uint32_t left = max(rect.Left, clear.Rect.Left);
+						const uint32_t right = min(rect.Right, clear.Rect.Right);
+						for (uint32_t row = max(rect.Top, clear.Rect.Top); row < min(rect.Bottom, clear.Rect.Bottom); ++row)
+						{
+							uint32_t* pixels = &target.Pixels[static_cast<size_t>(row) * target.Pitch];
+							fill(pixels + left, pixels + right, clear.Color);
+						}
+						break;
+					}
+					}
+				}
+
+				++totals.TilesRasterized;
+				totals.StolenTiles += (offset != 0 ? 1 : 0);
+			}
+		}
+
+		mThreadTotals[thread] = totals;
+	}
+
+	void SoftwareRenderBackend::WorkerMain(uint32_t thread)
+	{
+		uint64_t completedGeneration = 0;
+
+		for (;;)
+		{
+			{
+				unique_lock<mutex> lock(mMutex);
+				mWorkAvailable.wait(lock, [&]() { return mShuttingDown || mGeneration != completedGeneration; });
+				if (mShuttingDown)
+				{
+					return;
+				}
+
+				completedGeneration = mGeneration;
+			}
+
+			RunTiles(thread);
+
+			bool lastWorker;
+			{
+				lock_guard<mutex> lock(mMutex);
+				lastWorker = (--mPendingWorkers == 0);
+			}
+
+			if (lastWorker)
+			{
+				mWorkComplete.notify_one();
+			}
+		}
+	}
+
+	void SoftwareRenderBackend::RasterizeTriangle(const Triangle& triangle, const PixelRect& tile, Surface& target, Counters& totals)
+	{
+		const int32_t (&x)[3] = triangle.X;
+		const int32_t (&y)[3] = triangle.Y;
+		const Fill& fill = triangle.Shading;
+		const int32_t minX = static_cast<int32_t>(max(triangle.Bounds.Left, tile.Left));
+		const int32_t minY = static_cast<int32_t>(max(triangle.Bounds.Top, tile.Top));
+		const int32_t maxX = static_cast<int32_t>(min(triangle.Bounds.Right, tile.Right));
+		const int32_t maxY = static_cast<int32_t>(min(triangle.Bounds.Bottom, tile.Bottom));
+		if (minX >= maxX || minY >= maxY)
+		{
+			return;
+		}
+
+		// Edge k runs from vertex k to vertex k + 1 and is positive inside. Pixels exactly on an edge belong to the triangle
+		// only for top and left edges; the others are biased by one so the test is always "not negative". Edges are
+		// evaluated from absolute positions, so a pixel gets the same result whichever tile it is rasterized in.
+		const int32_t startX = minX & ~3;
+		int64_t rowEdges[3];
+		int32_t stepX[3];
+		int64_t stepY[3];
+		Int4 laneSteps[3];
+		Int4 groupSteps[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			const int next = (k + 1) % 3;
+			const int64_t dx = x[next] - x[k];
+			const int64_t dy = y[next] - y[k];
+			const bool topLeft = (dy < 0 || (dy == 0 && dx > 0));
+
+			const int64_t pixelX = static_cast<int64_t>(startX) * SubpixelScale + SubpixelScale / 2;
+			const int64_t pixelY = static_cast<int64_t>(minY) * SubpixelScale + SubpixelScale / 2;
+			rowEdges[k] = dx * (pixelY - y[k]) - dy * (pixelX - x[k]) - (topLeft ? 0 : 1);
+			stepX[k] = static_cast<int32_t>(-dy * SubpixelScale);
+			stepY[k] = dx * SubpixelScale;
+			laneSteps[k] = Set(0, stepX[k], 2 * stepX[k], 3 * stepX[k]);
+			groupSteps[k] = Splat(4 * stepX[k]);
+		}
+
+		// Sampling works in 1/256ths of a texel, offset by half a texel to texel centers and rounded to nearest. Clamping
+		// there is clamped addressing.
+		const bool textured = (fill.Shader == ShaderType::Textured || fill.Shader == ShaderType::LayerComposite);
+		const uint32_t* const texels = (textured ? fill.Texture->Pixels.data() : nullptr);
+		const uint32_t texelPitch = (textured ? fill.Texture->Pitch : 0);
+		const uint32_t lastTexelX = (textured ? fill.Texture->Width - 1 : 0);
+		const uint32_t lastTexelY = (textured ? fill.Texture->Height - 1 : 0);
+		const float texelsU = (fill.Shader == ShaderType::Textured ? static_cast<float>(fill.Texture->Width) * 256.0f : 0.0f);
+		const float texelsV = (fill.Shader == ShaderType::Textured ? static_cast<float>(fill.Texture->Height) * 256.0f : 0.0f);
+		const Float4 laneTexelsU = Multiply(Set(0.0f, 1.0f, 2.0f, 3.0f), Splat(triangle.DuDx * texelsU));
+		const Float4 laneTexelsV = Multiply(Set(0.0f, 1.0f, 2.0f, 3.0f), Splat(triangle.DvDx * texelsV));
+		const Float4 lowestTexel = Splat(0.0f);
+		const Float4 lastTexelU = Splat(max(texelsU - 256.0f, 0.0f) + 0.5f);
+		const Float4 lastTexelV = Splat(max(texelsV - 256.0f, 0.0f) + 0.5f);
+
+		const Int4 laneIndices = Set(0, 1, 2, 3);
+		const Int4 columnEnd = Splat(maxX);
+		const Int4 color = Splat(static_cast<int32_t>(fill.Color));
+		uint64_t pixelsShaded = 0;
+
+		const int64_t groupCount = (maxX - startX + 3) / 4;
+
+		for (int32_t row = minY; row < maxY; ++row)
+		{
+			// Edges step in 32-bit lanes across the row when its values fit, which is all but huge triangles. Otherwise each
+			// group starts again from the saturated 64-bit value; saturation keeps the sign, and only the sign matters.
+			uint32_t* pixels = &target.Pixels[static_cast<size_t>(row) * target.Pitch];
+			int64_t wideEdges[3] = { rowEdges[0], rowEdges[1], rowEdges[2] };
+			bool narrow = true;
+			Int4 edges[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				const int64_t rowEnd = rowEdges[k] + 4 * groupCount * stepX[k];
+				narrow &= (rowEdges[k] > -EdgeSaturation && rowEdges[k] < EdgeSaturation && rowEnd > -EdgeSaturation && rowEnd < EdgeSaturation);
+				edges[k] = Add(Splat(Saturate(rowEdges[k])), laneSteps[k]);
+			}
+
+			for (int32_t column = startX; column < maxX; column += 4)
+			{
+				if (!narrow)
+				{
+					for (int k = 0; k < 3; ++k)
+					{
+						edges[k] = Add(Splat(Saturate(wideEdges[k])), laneSteps[k]);
+						wideEdges[k] += 4 * static_cast<int64_t>(stepX[k]);
+					}
+				}
+
+				Int4 mask = NotNegative(Or(Or(edges[0], edges[1]), edges[2]));
+				if (column < minX || column + 4 > maxX)
+				{
+					mask = And(mask, And(NotNegative(Add(Splat(column - minX), laneIndices)), Less(Add(Splat(column), laneIndices), columnEnd)));
+				}
+
+				for (int k = 0; k < 3; ++k)
+				{
+					edges[k] = Add(edges[k], groupSteps[k]);
+				}
+
+				const uint32_t lanes = LaneBits(mask);
+				if (lanes == 0)
+				{
+					continue;
+				}
+
+				pixelsShaded += LaneCounts[lanes];
+				uint32_t* const group = pixels + column;
+				switch (fill.Shader)
+				{
+				case ShaderType::SolidColor:
+				case ShaderType::PaletteInstanced:
+				case ShaderType::ColorInstanced:
+					StoreMasked(group, mask, (fill.AlphaBlend ? Blend(color, Load(group)) : color));
+					break;
+
+				case ShaderType::Textured:
+				{
+					// Lanes outside the triangle sample too; their coordinates are clamped like the rest.
+					const float centerX = static_cast<float>(column) + 0.5f - triangle.OriginX;
+					const float centerY = static_cast<float>(row) + 0.5f - triangle.OriginY;
+					const float u = (triangle.U + triangle.DuDx * centerX + triangle.DuDy * centerY) * texelsU - 127.5f;
+					const float v = (triangle.V + triangle.DvDx * centerX + triangle.DvDy * centerY) * texelsV - 127.5f;
+					int32_t texelX[4];
+					int32_t texelY[4];
+					Store(texelX, Truncate(Clamp(Add(Splat(u), laneTexelsU), lowestTexel, lastTexelU)));
+					Store(texelY, Truncate(Clamp(Add(Splat(v), laneTexelsV), lowestTexel, lastTexelV)));
+
+					int32_t samples[4];
+					for (int lane = 0; lane < 4; ++lane)
+					{
+						samples[lane] = static_cast<int32_t>(SampleBilinear(texels, texelPitch, lastTexelX, lastTexelY, static_cast<uint32_t>(texelX[lane]),
+							static_cast<uint32_t>(texelY[lane])));
+					}
+
+					const Int4 source = Set(samples[0], samples[1], samples[2], samples[3]);
+					StoreMasked(group, mask, (fill.AlphaBlend ? Blend(source, Load(group)) : source));
+					break;
+				}
+
+				case ShaderType::LayerComposite:
+					for (uint32_t lane = 0; lane < 4; ++lane)
+					{
+						const uint32_t layerX = static_cast<uint32_t>(column) + lane;
+						const uint32_t layerY = static_cast<uint32_t>(row);
+						if ((lanes & (1U << lane)) != 0 && layerX < fill.Texture->Width && layerY < fill.Texture->Height)
+						{
+							const uint32_t texel = fill.Texture->Pixels[static_cast<size_t>(layerY) * fill.Texture->Pitch + layerX];
+							if ((texel >> 24) >= 128)
+							{
+								group[lane] = (fill.AlphaBlend ? Blend(texel, group[lane]) : texel);
+							}
+						}
+					}
+					break;
+				}
+			}
+
+			for (int k = 0; k < 3; ++k)
+			{
+				rowEdges[k] += stepY[k];
+			}
+		}
+
+		totals.PixelsShaded += pixelsShaded;
+	}
+
+	void SoftwareRenderBackend::RasterizeLine(const Line& line, const PixelRect& tile, Surface& target, Counters& totals)
+	{
+		// One pixel per step along the major axis, leaving the end pixel to the next segment of the strip. Every tile the
+		// line was binned to walks the whole line and writes only its own pixels.
+		const ScreenVertex& a = line.From;
+		const ScreenVertex& b = line.To;
+		const float dx = b.X - a.X;
+		const float dy = b.Y - a.Y;
+		const uint32_t steps = max(static_cast<uint32_t>(ceil(max(fabs(dx), fabs(dy)))), 1U);
+		const float stepX = dx / static_cast<float>(steps);
+		const float stepY = dy / static_cast<float>(steps);
+
+		const int32_t left = static_cast<int32_t>(max(line.Clip.Left, tile.Left));
+		const int32_t top = static_cast<int32_t>(max(line.Clip.Top, tile.Top));
+		const int32_t right = static_cast<int32_t>(min(line.Clip.Right, tile.Right));
+		const int32_t bottom = static_cast<int32_t>(min(line.Clip.Bottom, tile.Bottom));
+
+		for (uint32_t i = 0; i < steps; ++i)
+		{
+			const float pointX = min(max(a.X + stepX * static_cast<float>(i), -GuardBand), GuardBand);
+			const float pointY = min(max(a.Y + stepY * static_cast<float>(i), -GuardBand), GuardBand);
+			const int32_t pixelX = static_cast<int32_t>(floor(pointX));
+			const int32_t pixelY = static_cast<int32_t>(floor(pointY));
+			if (pixelX >= left && pixelX < right && pixelY >= top && pixelY < bottom)
+			{
+				target.Pixels[static_cast<size_t>(pixelY) * target.Pitch + pixelX] = line.Color;
+				++totals.PixelsShaded;
+			}
+		}
+	}
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "RenderCommandList.h"
+#include "SpriteBatch.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	// Rasterizes command lists and sprite batches on the CPU into RGBA8 surfaces, so frames can be rendered, compared and
+	// timed without a GPU. There are no shaders: each pipeline names the fixed function that stands in for one of the game's
+	// shader pairs. Coverage is decided by exact edge functions on a 1/16 pixel grid with Direct3D's top-left rule and back
+	// faces culled, four pixels at a time: SSE2 on x86 and x64, NEON on ARM, and plain C++ elsewhere or when
+	// DX_SOFTWARE_RASTERIZER_SCALAR is defined. This file only depends on the C++ standard library.
+	//
+	// Draws are set up on the calling thread and binned into TileSize x TileSize screen tiles. The tiles are rasterized when
+	// the render target changes and at the end of each Execute and DrawBatch, spread across the calling thread and a pool of
+	// workers that steal tiles from each other. Each tile is rasterized by one thread in submission order, so no pixel is
+	// ever shared between threads and the output is identical for every thread count.
+	class SoftwareRenderBackend final : public RenderBackend, public SpriteBatchTarget
+	{
+	public:
+		enum class ShaderType : std::uint8_t
+		{
+			SolidColor,			// ShapeRendererVS/PS: vertex constants are the world-view-projection matrix, pixel constants the color
+			PaletteInstanced,	// ShapeRendererInstancedVS/PS: view-projection and palette; instances carry offset, scale and palette index
+			Textured,			// SpriteRendererVS/PS: VertexPositionTexture, world-view-projection, bilinear clamped sampling of slot 0
+			LayerComposite,		// ShapeRendererVS with BrickLayerPS: copies slot 0 texel for texel, dropping mostly transparent texels
+			ColorInstanced		// ParticleVS with ShapeRendererInstancedPS: view-projection; instances carry offset, scale and an RGBA8 color
+		};
+
+		enum class PrimitiveType : std::uint8_t
+		{
+			TriangleList,
+			TriangleStrip,
+			LineStrip
+		};
+
+		// Matrices in constants are transposed, as the D3D11 components upload them.
+		struct Pipeline
+		{
+			ShaderType Shader;
+			PrimitiveType Topology;
+			bool AlphaBlend;	// Source over destination by source alpha
+		};
+
+		// Vertices are copied. Each starts with a float4 position; Textured reads two texture coordinates right after it.
+		struct Mesh
+		{
+			const void* Vertices;
+			std::uint32_t VertexCount;
+			std::uint32_t Stride;
+			std::uint32_t InstanceCapacity;
+			std::uint32_t InstanceStride;
+		};
+
+		struct Counters
+		{
+			std::uint64_t Executions;
+			std::uint64_t Draws;
+			std::uint64_t Triangles;			// Set up for rasterization
+			std::uint64_t CulledTriangles;		// Back-facing, degenerate or with a vertex behind the eye
+			std::uint64_t Lines;
+			std::uint64_t Sprites;
+			std::uint64_t PixelsShaded;
+			std::uint64_t Passes;				// Binned work rasterized at once
+			std::uint64_t BinEntries;			// A triangle, line or clear counts once for every tile it may touch
+			std::uint64_t TilesRasterized;
+			std::uint64_t StolenTiles;			// Taken from another thread's share; depends on scheduling
+		};
+
+		static const std::uint32_t DefaultSpriteCapacity = 4096;
+		static const std::uint32_t TileSize = 64;
+
+		// The back buffer, addressed as RenderCommandList::BackBuffer, starts out cleared to transparent black. Tiles are
+		// rasterized on threadCount threads, including the calling thread; zero uses one per hardware thread.
+		SoftwareRenderBackend(std::uint32_t width, std::uint32_t height, std::uint32_t threadCount = 1);
+		SoftwareRenderBackend(const SoftwareRenderBackend&) = delete;
+		SoftwareRenderBackend& operator=(const SoftwareRenderBackend&) = delete;
+		SoftwareRenderBackend(SoftwareRenderBackend&&) = delete;
+		SoftwareRenderBackend& operator=(SoftwareRenderBackend&&) = delete;
+		~SoftwareRenderBackend();
+
+		std::uint32_t ThreadCount() const;
+
+		PipelineHandle CreatePipeline(const Pipeline& pipeline);
+		MeshHandle CreateMesh(const Mesh& mesh);
+
+		// Render targets and textures are both surfaces and share one set of handles, so a render target can be drawn as a
+		// sprite texture and a texture can be bound with SetTexture. Texture pixels are RGBA8 rows rowPitch bytes apart.
+		RenderTargetHandle CreateRenderTarget(std::uint32_t width, std::uint32_t height);
+		SpriteTextureHandle CreateTexture(std::uint32_t width, std::uint32_t height, const std::uint8_t* pixels, std::uint32_t rowPitch);
+
+		// Sprites are alpha blended into the back buffer with this (transposed) view-projection matrix.
+		void SetSpriteViewProjection(const float (&viewProjection)[16]);
+
+		virtual void Execute(const RenderCommandList& commandList) override;
+
+		virtual SpriteInstance* Map(std::uint32_t& capacity, std::uint32_t& firstInstance) override;
+		virtual void Unmap(std::uint32_t instanceCount) override;
+		virtual void DrawBatch(SpriteTextureHandle texture, std::uint32_t firstInstance, std::uint32_t instanceCount) override;
+
+		// Pixels are RGBA8 with red in the lowest byte; rows are RowPitch pixels apart.
+		std::uint32_t Width(RenderTargetHandle target = RenderCommandList::BackBuffer) const;
+		std::uint32_t Height(RenderTargetHandle target = RenderCommandList::BackBuffer) const;
+		std::uint32_t RowPitch(RenderTargetHandle target = RenderCommandList::BackBuffer) const;
+		const std::uint32_t* Pixels(RenderTargetHandle target = RenderCommandList::BackBuffer) const;
+
+		// Exchanges the back buffer's pixels with pixels, resized to fit, so a finished frame can be handed off without a
+		// copy. The back buffer then holds whatever pixels held, as a flip-discard swap chain does after Present.
+		void SwapBackBuffer(std::vector<std::uint32_t>& pixels);
+
+		const Counters& Totals() const;
+		void ResetCounters();
+
+	private:
+		// Rows are padded to a multiple of four pixels so every four-pixel step stays inside its row.
+		struct Surface
+		{
+			std::uint32_t Width;
+			std::uint32_t Height;
+			std::uint32_t Pitch;
+			std::vector<std::uint32_t> Pixels;
+		};
+
+		struct PipelineState
+		{
+			Pipeline Description;
+			std::vector<std::uint8_t> VertexConstants;
+			std::vector<std::uint8_t> PixelConstants;
+		};
+
+		struct MeshData
+		{
+			std::vector<std::uint8_t> Vertices;
+			std::uint32_t VertexCount;
+			std::uint32_t Stride;
+			std::vector<std::uint8_t> Instances;
+			std::uint32_t InstanceStride;
+		};
+
+		// Screen position in pixels, texture coordinates, and whether the vertex was in front of the eye.
+		struct ScreenVertex
+		{
+			float X;
+			float Y;
+			float U;
+			float V;
+			bool Visible;
+		};
+
+		struct Fill
+		{
+			ShaderType Shader;
+			std::uint32_t Color;		// SolidColor and PaletteInstanced
+			bool AlphaBlend;
+			const Surface* Texture;		// Textured and LayerComposite
+		};
+
+		// A front-facing triangle in 1/16 pixels, with the pixels it may cover and its texture coordinate planes.
+		struct Triangle
+		{
+			std::int32_t X[3];
+			std::int32_t Y[3];
+			PixelRect Bounds;
+			float OriginX;
+			float OriginY;
+			float U;
+			float V;
+			float DuDx;
+			float DuDy;
+			float DvDx;
+			float DvDy;
+			Fill Shading;
+		};
+
+		struct Line
+		{
+			ScreenVertex From;
+			ScreenVertex To;
+			std::uint32_t Color;
+			PixelRect Clip;
+		};
+
+		struct Clear
+		{
+			PixelRect Rect;
+			std::uint32_t Color;
+		};
+
+		// Bin entries hold the kind of primitive in their top two bits and its index below.
+		enum class BinEntryType : std::uint32_t
+		{
+			Triangle,
+			Line,
+			Clear
+		};
+
+		// Each thread starts on its own contiguous run of tiles and steals from the others' runs when it is done. Padded to
+		// a cache line so threads don't contend on each other's counters.
+		struct TileQueue
+		{
+			std::atomic<std::uint32_t> Next;
+			std::uint32_t End;
+			std::uint8_t Padding[56];
+		};
+
+		static Surface MakeSurface(std::uint32_t width, std::uint32_t height);
+		Surface& SurfaceFor(RenderTargetHandle target);
+		const Surface& SurfaceFor(RenderTargetHandle target) const;
+
+		void DrawMesh(const PipelineState& pipeline, const MeshData& mesh, const Surface* texture, std::uint32_t vertexCount, std::uint32_t startVertex,
+			std::uint32_t instanceCount);
+		void DrawPrimitives(PrimitiveType topology, const ScreenVertex* vertices, std::uint32_t vertexCount, const Fill& fill);
+		void DrawTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, const Fill& fill);
+		void DrawLine(const ScreenVertex& a, const ScreenVertex& b, std::uint32_t color);
+		void DrawClear(const PixelRect& rect, std::uint32_t color);
+
+		void SetTarget(Surface& target);
+		PixelRect ClipRect() const;
+		void Bin(BinEntryType type, std::uint32_t index, std::uint32_t tileX, std::uint32_t tileY);
+		void Flush();
+		void RunTiles(std::uint32_t thread);
+		void WorkerMain(std::uint32_t thread);
+
+		static void RasterizeTriangle(const Triangle& triangle, const PixelRect& tile, Surface& target, Counters& totals);
+		static void RasterizeLine(const Line& line, const PixelRect& tile, Surface& target, Counters& totals);
+
+		std::vector<PipelineState> mPipelines;
+		std::vector<MeshData> mMeshes;
+		std::vector<Surface> mSurfaces;
+		Surface mBackBuffer;
+
+		// Execution state. Sprites always draw to the back buffer, unclipped.
+		Surface* mTarget;
+		PixelRect mScissor;
+		bool mScissorEnabled;
+		std::vector<ScreenVertex> mScreenVertices;
+
+		std::vector<SpriteInstance> mSpriteInstances;
+		float mSpriteViewProjection[16];
+
+		// Work binned for mTarget since the last flush. Bins are kept between flushes so their storage is reused.
+		std::vector<Triangle> mTriangles;
+		std::vector<Line> mLines;
+		std::vector<Clear> mClears;
+		std::vector<std::vector<std::uint32_t>> mBins;
+		std::uint32_t mTileColumns;
+		std::uint32_t mTileRows;
+		std::vector<std::uint32_t> mActiveTiles;
+
+		std::uint32_t mThreadCount;
+		std::unique_ptr<TileQueue[]> mTileQueues;
+		std::vector<Counters> mThreadTotals;
+		std::vector<std::thread> mWorkers;
+		std::mutex mMutex;
+		std::condition_variable mWorkAvailable;
+		std::condition_variable mWorkComplete;
+		std::uint64_t mGeneration;
+		std::uint32_t mPendingWorkers;
+		bool mShuttingDown;
+
+		Counters mTotals;
+	};
+}
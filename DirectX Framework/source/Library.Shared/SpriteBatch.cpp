@@ -0,0 +1,57 @@
+#include "SpriteBatch.h"
+
+using namespace std;
+
+namespace DX
+{
+	SpriteBatch::SpriteBatch() :
+		mTarget(nullptr), mInstances(nullptr), mCapacity(0), mCount(0), mFirstInstance(0), mStatistics()
+	{
+	}
+
+	void SpriteBatch::Begin(SpriteBatchTarget& target)
+	{
+		mTarget = &target;
+		mInstances = nullptr;
+		mCapacity = 0;
+		mCount = 0;
+		mBatches.clear();
+		mStatistics = Statistics();
+	}
+
+	void SpriteBatch::End()
+	{
+		Flush();
+		mTarget = nullptr;
+	}
+
+	void SpriteBatch::Map()
+	{
+		mInstances = mTarget->Map(mCapacity, mFirstInstance);
+		mCount = 0;
+		++mStatistics.Maps;
+	}
+
+	void SpriteBatch::Flush()
+	{
+		// Nothing is mapped until the first sprite arrives, so an empty Begin/End pair never touches the target.
+		if (mInstances == nullptr)
+		{
+			return;
+		}
+
+		mTarget->Unmap(mCount);
+		mStatistics.Sprites += mCount;
+
+		for (const Batch& batch : mBatches)
+		{
+			mTarget->DrawBatch(batch.Texture, batch.FirstInstance, batch.InstanceCount);
+		}
+
+		mStatistics.Draws += mBatches.size();
+		mBatches.clear();
+		mInstances = nullptr;
+		mCapacity = 0;
+		mCount = 0;
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Target-issued handle for a texture that sprites are drawn from.
+	typedef std::uint32_t SpriteTextureHandle;
+
+	// One sprite as the sprite batch shader consumes it: a unit quad spanning -1..1, scaled, rotated about its center and
+	// moved to Position, textured with the UVRect part of its texture.
+	struct SpriteInstance
+	{
+		float Position[2];
+		float Scale[2];
+		float UVRect[4];	// Left, top, right, bottom
+		float Rotation;		// Radians, counterclockwise
+	};
+
+	static_assert(sizeof(SpriteInstance) == 9 * sizeof(float), "SpriteInstance must match the sprite batch input layout.");
+
+	// Where a SpriteBatch writes its instances and issues its draws. Map hands out instance storage (a mapped dynamic
+	// buffer on the GPU); draws are only issued after the storage is unmapped.
+	class SpriteBatchTarget
+	{
+	public:
+		virtual ~SpriteBatchTarget() = default;
+
+		// Returns room for capacity (at least one) instances, the first of which is instance firstInstance of the buffer.
+		virtual SpriteInstance* Map(std::uint32_t& capacity, std::uint32_t& firstInstance) = 0;
+		virtual void Unmap(std::uint32_t instanceCount) = 0;
+		virtual void DrawBatch(SpriteTextureHandle texture, std::uint32_t firstInstance, std::uint32_t instanceCount) = 0;
+	};
+
+	// Collects sprites between Begin and End and draws them with one instanced draw per run of sprites sharing a texture.
+	// Sprites are written straight into the target's mapped storage; the batch only flushes early when that storage is
+	// full. Sprites draw in submission order, so callers get the fewest draws by grouping sprites by texture.
+	class SpriteBatch final
+	{
+	public:
+		struct Statistics
+		{
+			std::uint64_t Sprites;
+			std::uint64_t Draws;
+			std::uint64_t Maps;
+		};
+
+		SpriteBatch();
+		SpriteBatch(const SpriteBatch&) = delete;
+		SpriteBatch& operator=(const SpriteBatch&) = delete;
+		SpriteBatch(SpriteBatch&&) = default;
+		SpriteBatch& operator=(SpriteBatch&&) = default;
+		~SpriteBatch() = default;
+
+		void Begin(SpriteBatchTarget& target);
+		void Draw(SpriteTextureHandle texture, const SpriteInstance& sprite);
+		void End();
+
+		// Counts for the most recent Begin/End pair.
+		const Statistics& LastStatistics() const;
+
+	private:
+		struct Batch
+		{
+			SpriteTextureHandle Texture;
+			std::uint32_t FirstInstance;
+			std::uint32_t InstanceCount;
+		};
+
+		void Map();
+		void Flush();
+
+		SpriteBatchTarget* mTarget;
+		SpriteInstance* mInstances;
+		std::uint32_t mCapacity;
+		std::uint32_t mCount;
+		std::uint32_t mFirstInstance;
+		std::vector<Batch> mBatches;
+		Statistics mStatistics;
+	};
+}
+
+#include "SpriteBatch.inl"
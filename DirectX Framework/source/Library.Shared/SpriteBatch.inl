@@ -0,0 +1,27 @@
+#pragma once
+
+namespace DX
+{
+	inline void SpriteBatch::Draw(SpriteTextureHandle texture, const SpriteInstance& sprite)
+	{
+		if (mCount == mCapacity)
+		{
+			Flush();
+			Map();
+		}
+
+		if (mBatches.empty() || mBatches.back().Texture != texture)
+		{
+			const Batch batch = { texture, mFirstInstance + mCount, 0 };
+			mBatches.push_back(batch);
+		}
+
+		mInstances[mCount++] = sprite;
+		++mBatches.back().InstanceCount;
+	}
+
+	inline const SpriteBatch::Statistics& SpriteBatch::LastStatistics() const
+	{
+		return mStatistics;
+	}
+}
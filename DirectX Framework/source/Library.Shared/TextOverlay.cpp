@@ -0,0 +1,228 @@
+#include "pch.h"
+#include "TextOverlay.h"
+#include "DdsTexture.h"
+#include "DeviceResources.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+namespace DX
+{
+	namespace
+	{
+		// Part of the texture cache's key; bump it whenever DecodeFontTexture's output changes.
+		const uint32_t FontTextureDecoderVersion = 1;
+
+		// Unpacks the atlas's mip chain from its DDS file, levels packed as DdsTexture::Level lays them out. Block-compressed
+		// atlases are refused: the loader checks the first level as Height rows of RowPitch bytes, which blocks don't fill.
+		bool DecodeFontTexture(const uint8_t* data, size_t size, AssetLoader::DecodedImage& image)
+		{
+			DdsTexture::Description texture;
+			if (!DdsTexture::Parse(data, size, texture) || DdsTexture::BlockCompressed(texture.Format))
+			{
+				return false;
+			}
+
+			const DdsTexture::MipLevel& last = texture.Mips.back();
+			image.Width = texture.Width;
+			image.Height = texture.Height;
+			image.RowPitch = texture.Mips[0].RowPitch;
+			image.Format = texture.Format;
+			image.MipCount = static_cast<uint32_t>(texture.Mips.size());
+			image.Pixels.assign(data + texture.Mips[0].Offset, data + last.Offset + last.SlicePitch);
+			return true;
+		}
+	}
+
+	TextOverlay::TextOverlay(const shared_ptr<DX::DeviceResources>& deviceResources, const shared_ptr<AssetLoader>& assetLoader, const wstring& fontFilename) :
+		DrawableGameComponent(deviceResources), mAssetLoader(assetLoader), mFontFilename(fontFilename),
+		mSpriteBatchTarget(deviceResources), mFontTextureHandle(0), mLoadingComplete(false), mTotals(), mLastFrame()
+	{
+		// Room for every text a frame queues, so queuing never allocates.
+		mQueuedTexts.reserve(16);
+	}
+
+	void TextOverlay::CreateDeviceDependentResources()
+	{
+		// The atlas and its glyph table load on the asset loader's threads while the shaders load. The atlas is a DDS file
+		// in the texture's format, mips included; it goes through the loader's texture cache, so after the first run its
+		// levels are mapped from the cache entry and go to the device as they are.
+		const wstring fontPath = wstring(Windows::ApplicationModel::Package::Current->InstalledLocation->Path->Data()) + L"\\" + mFontFilename;
+		const shared_future<AssetLoader::TexturePointer> loadFontTexture = mAssetLoader->LoadTextureAsync(ToUtf8(fontPath + L".dds"), FontTextureDecoderVersion, DecodeFontTexture);
+		const shared_future<AssetLoader::AssetPointer> loadGlyphTable = mAssetLoader->LoadAsync(ToUtf8(fontPath + L".glyphs"));
+
+		auto loadVSTask = ReadDataAsync(L"SpriteBatchVS.cso");
+		auto loadPSTask = ReadDataAsync(L"SpriteRendererPS.cso");
+
+		auto createVSTask = loadVSTask.then([this](const vector<byte>& fileData) {
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateVertexShader(&fileData[0], fileData.size(), nullptr, mVertexShader.ReleaseAndGetAddressOf()));
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateInputLayout(D3D11SpriteBatchTarget::InputElements, D3D11SpriteBatchTarget::InputElementCount,
+				&fileData[0], fileData.size(), mInputLayout.ReleaseAndGetAddressOf()));
+
+			CD3D11_BUFFER_DESC constantBufferDesc(sizeof(XMFLOAT4X4), D3D11_BIND_CONSTANT_BUFFER);
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBuffer(&constantBufferDesc, nullptr, mVSCBufferPerFrame.ReleaseAndGetAddressOf()));
+		});
+
+		auto createPSTask = loadPSTask.then([this](const vector<byte>& fileData) {
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreatePixelShader(&fileData[0], fileData.size(), nullptr, mPixelShader.ReleaseAndGetAddressOf()));
+
+			// Trilinear, so text drawn below the baked size reads from the atlas's mips.
+			CD3D11_SAMPLER_DESC samplerStateDesc(D3D11_DEFAULT);
+			samplerStateDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateSamplerState(&samplerStateDesc, mTextureSampler.ReleaseAndGetAddressOf()));
+
+			D3D11_BLEND_DESC blendStateDesc = { 0 };
+			blendStateDesc.RenderTarget[0].BlendEnable = true;
+			blendStateDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+			blendStateDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+			blendStateDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+			blendStateDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+			blendStateDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+			blendStateDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+			blendStateDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+			ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateBlendState(&blendStateDesc, mAlphaBlending.ReleaseAndGetAddressOf()));
+		});
+
+		(createPSTask && createVSTask).then([this, loadFontTexture, loadGlyphTable]() {
+			DX_PROFILE_ZONE("TextOverlay::LoadFont");
+			mFont = make_unique<GlyphFont>(loadGlyphTable.get());
+			CreateFontTexture(loadFontTexture.get());
+			mSpriteBatchTarget.CreateDeviceDependentResources();
+			mFontTextureHandle = mSpriteBatchTarget.AddTexture(mFontTexture);
+			mLoadingComplete = true;
+		});
+	}
+
+	void TextOverlay::ReleaseDeviceDependentResources()
+	{
+		mLoadingComplete = false;
+		mVertexShader.Reset();
+		mPixelShader.Reset();
+		mInputLayout.Reset();
+		mVSCBufferPerFrame.Reset();
+		mFontTexture.Reset();
+		mTextureSampler.Reset();
+		mAlphaBlending.Reset();
+		mSpriteBatchTarget.ClearTextures();
+		mSpriteBatchTarget.ReleaseDeviceDependentResources();
+	}
+
+	void TextOverlay::Draw(GlyphText& text, float x, float y, float pixelSize, float anchorX, float anchorY)
+	{
+		const QueuedText queuedText = { &text, x, y, pixelSize, anchorX, anchorY };
+		mQueuedTexts.push_back(queuedText);
+	}
+
+	void TextOverlay::Render(const StepTimer& timer)
+	{
+		UNREFERENCED_PARAMETER(timer);
+
+		if (!mLoadingComplete || mQueuedTexts.empty())
+		{
+			mQueuedTexts.clear();
+			return;
+		}
+
+		ID3D11DeviceContext* direct3DDeviceContext = mDeviceResources->GetD3DDeviceContext();
+		direct3DDeviceContext->IASetInputLayout(mInputLayout.Get());
+		direct3DDeviceContext->VSSetShader(mVertexShader.Get(), nullptr, 0);
+		direct3DDeviceContext->PSSetShader(mPixelShader.Get(), nullptr, 0);
+
+		// Logical pixels, y down, to clip space, turned with the display as the Direct2D transform is.
+		const Windows::Foundation::Size logicalSize = mDeviceResources->GetLogicalSize();
+		const XMFLOAT4X4 orientation = mDeviceResources->GetOrientationTransform3D();
+		const XMMATRIX projection = XMMatrixOrthographicOffCenterLH(0.0f, logicalSize.Width, logicalSize.Height, 0.0f, 0.0f, 1.0f) * XMLoadFloat4x4(&orientation);
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixTranspose(projection));
+		direct3DDeviceContext->UpdateSubresource(mVSCBufferPerFrame.Get(), 0, nullptr, &viewProjection, 0, 0);
+		direct3DDeviceContext->VSSetConstantBuffers(0, 1, mVSCBufferPerFrame.GetAddressOf());
+
+		direct3DDeviceContext->PSSetSamplers(0, 1, mTextureSampler.GetAddressOf());
+		direct3DDeviceContext->OMSetBlendState(mAlphaBlending.Get(), 0, 0xFFFFFFFF);
+
+		Counters frame = {};
+		frame.Frames = 1;
+		mSpriteBatchTarget.Bind();
+		mSpriteBatch.Begin(mSpriteBatchTarget);
+		for (const QueuedText& queuedText : mQueuedTexts)
+		{
+			GlyphText& text = *queuedText.Text;
+			frame.Relayouts += (text.Layout(*mFont) ? 1 : 0);
+
+			const float scale = queuedText.PixelSize / mFont->PixelSize();
+			text.Draw(mSpriteBatch, mFontTextureHandle, queuedText.X - text.Width() * scale * queuedText.AnchorX, queuedText.Y - text.Height() * scale * queuedText.AnchorY, scale);
+			++frame.Texts;
+			frame.Glyphs += text.GlyphCount();
+		}
+
+		mSpriteBatch.End();
+		mQueuedTexts.clear();
+
+		frame.Draws = mSpriteBatch.LastStatistics().Draws;
+		mLastFrame = frame;
+		mTotals.Frames += frame.Frames;
+		mTotals.Texts += frame.Texts;
+		mTotals.Glyphs += frame.Glyphs;
+		mTotals.Relayouts += frame.Relayouts;
+		mTotals.Draws += frame.Draws;
+	}
+
+	const TextOverlay::Counters& TextOverlay::Totals() const
+	{
+		return mTotals;
+	}
+
+	const TextOverlay::Counters& TextOverlay::LastFrame() const
+	{
+		return mLastFrame;
+	}
+
+	void TextOverlay::ResetCounters()
+	{
+		mTotals = Counters();
+		mLastFrame = Counters();
+	}
+
+	void TextOverlay::WriteReport(ostream& stream) const
+	{
+		stream << "frames\t" << mTotals.Frames << '\n';
+		stream << "texts\t" << mTotals.Texts << '\n';
+		stream << "glyphs\t" << mTotals.Glyphs << '\n';
+		stream << "relayouts\t" << mTotals.Relayouts << '\n';
+		stream << "draws\t" << mTotals.Draws << '\n';
+	}
+
+	void TextOverlay::CreateFontTexture(const AssetLoader::TexturePointer& texture)
+	{
+		if (texture->Width != mFont->TextureWidth() || texture->Height != mFont->TextureHeight())
+		{
+			throw runtime_error("TextOverlay: the font atlas doesn't match its glyph table");
+		}
+
+		CD3D11_TEXTURE2D_DESC textureDesc(static_cast<DXGI_FORMAT>(texture->Format), texture->Width, texture->Height, 1, texture->MipCount, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+
+		// The levels follow one another in the decoded pixels, as DecodeFontTexture packed them.
+		vector<D3D11_SUBRESOURCE_DATA> textureSubResourceData(texture->MipCount);
+		size_t offset = 0;
+		for (UINT mip = 0; mip < texture->MipCount; ++mip)
+		{
+			const DdsTexture::MipLevel level = DdsTexture::Level(texture->Format, max(texture->Width >> mip, 1U), max(texture->Height >> mip, 1U));
+			if (offset + level.SlicePitch > texture->Pixels->Size())
+			{
+				throw runtime_error("TextOverlay: the font atlas is missing mip levels");
+			}
+
+			textureSubResourceData[mip].pSysMem = texture->Pixels->Data() + offset;
+			textureSubResourceData[mip].SysMemPitch = level.RowPitch;
+			textureSubResourceData[mip].SysMemSlicePitch = level.SlicePitch;
+			offset += level.SlicePitch;
+		}
+
+		ComPtr<ID3D11Texture2D> fontTexture;
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateTexture2D(&textureDesc, textureSubResourceData.data(), fontTexture.GetAddressOf()));
+		ThrowIfFailed(mDeviceResources->GetD3DDevice()->CreateShaderResourceView(fontTexture.Get(), nullptr, mFontTexture.ReleaseAndGetAddressOf()));
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "DrawableGameComponent.h"
+#include "AssetLoader.h"
+#include "D3D11SpriteBatchTarget.h"
+#include "GlyphFont.h"
+#include "GlyphText.h"
+#include "SpriteBatch.h"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	// Draws text over the frame as sprites from a glyph atlas baked offline by FontBaker. Components queue their GlyphTexts
+	// with Draw from their Render; the overlay's own Render, called after theirs, lays out the texts that changed and sends
+	// every queued glyph through one SpriteBatch, so all of a frame's text is one instanced draw and text that didn't
+	// change is never laid out again. Positions are in the window's logical pixels with y down, as Direct2D's are.
+	class TextOverlay final : public DrawableGameComponent
+	{
+	public:
+		struct Counters
+		{
+			std::uint64_t Frames;		// Renders with text queued
+			std::uint64_t Texts;
+			std::uint64_t Glyphs;
+			std::uint64_t Relayouts;
+			std::uint64_t Draws;
+		};
+
+		// Loads <fontFilename>.dds and <fontFilename>.glyphs, relative to the installed package, with the game's sprite batch
+		// shaders. Text queued before they have loaded isn't drawn.
+		TextOverlay(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<AssetLoader>& assetLoader, const std::wstring& fontFilename);
+		TextOverlay(const TextOverlay&) = delete;
+		TextOverlay& operator=(const TextOverlay&) = delete;
+		TextOverlay(TextOverlay&&) = delete;
+		TextOverlay& operator=(TextOverlay&&) = delete;
+		~TextOverlay() = default;
+
+		virtual void CreateDeviceDependentResources() override;
+		virtual void ReleaseDeviceDependentResources() override;
+		virtual void Render(const DX::StepTimer& timer) override;
+
+		// Queues text for this frame's Render, pixelSize pixels high per em, with the point anchorX, anchorY of its block
+		// (0, 0 for its top left, 1, 1 for its bottom right) at x, y. The text must live until then.
+		void Draw(GlyphText& text, float x, float y, float pixelSize, float anchorX = 0.0f, float anchorY = 0.0f);
+
+		const Counters& Totals() const;
+		const Counters& LastFrame() const;
+		void ResetCounters();
+
+		void WriteReport(std::ostream& stream) const;
+
+	private:
+		struct QueuedText
+		{
+			GlyphText* Text;
+			float X;
+			float Y;
+			float PixelSize;
+			float AnchorX;
+			float AnchorY;
+		};
+
+		void CreateFontTexture(const AssetLoader::TexturePointer& texture);
+
+		std::shared_ptr<AssetLoader> mAssetLoader;
+		std::wstring mFontFilename;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> mVertexShader;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> mPixelShader;
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> mInputLayout;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> mVSCBufferPerFrame;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mFontTexture;
+		Microsoft::WRL::ComPtr<ID3D11SamplerState> mTextureSampler;
+		Microsoft::WRL::ComPtr<ID3D11BlendState> mAlphaBlending;
+		D3D11SpriteBatchTarget mSpriteBatchTarget;
+		SpriteBatch mSpriteBatch;
+		SpriteTextureHandle mFontTextureHandle;
+		std::unique_ptr<GlyphFont> mFont;
+		bool mLoadingComplete;
+		std::vector<QueuedText> mQueuedTexts;
+		Counters mTotals;
+		Counters mLastFrame;
+	};
+}
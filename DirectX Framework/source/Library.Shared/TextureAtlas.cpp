@@ -0,0 +1,213 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DX
+{
+	const uint32_t TextureAtlas::Magic = 0x54415844;	// "DXAT"
+	const uint32_t TextureAtlas::FileVersion = 1;
+
+	static_assert(sizeof(TextureAtlas::Header) == 32 && sizeof(TextureAtlas::Page) == 16 && sizeof(TextureAtlas::Entry) == 40,
+		"the atlas table's layout is part of its file format");
+
+	TextureAtlas::TextureAtlas(const AssetLoader::AssetPointer& data) :
+		mData(data), mHeader(nullptr), mPages(nullptr), mEntries(nullptr), mNames(nullptr)
+	{
+		if (mData == nullptr || mData->Size() < sizeof(Header))
+		{
+			throw runtime_error("TextureAtlas: the table is too small");
+		}
+
+		// The table is read in place, so its entries' 64-bit hashes have to be aligned. Loaded and mapped files are.
+		const uint8_t* bytes = mData->Data();
+		if (reinterpret_cast<uintptr_t>(bytes) % alignof(Entry) != 0)
+		{
+			throw runtime_error("TextureAtlas: the table is misaligned");
+		}
+
+		mHeader = reinterpret_cast<const Header*>(bytes);
+		if (mHeader->Magic != Magic || mHeader->FileVersion != FileVersion)
+		{
+			throw runtime_error("TextureAtlas: not an atlas table, or from another version of AtlasBuilder");
+		}
+
+		const uint64_t pagesOffset = sizeof(Header);
+		const uint64_t entriesOffset = pagesOffset + static_cast<uint64_t>(mHeader->PageCount) * sizeof(Page);
+		const uint64_t namesOffset = entriesOffset + static_cast<uint64_t>(mHeader->EntryCount) * sizeof(Entry);
+		if (namesOffset + mHeader->NamesSize != mData->Size() || mHeader->NamesSize == 0 || bytes[mData->Size() - 1] != '\0')
+		{
+			throw runtime_error("TextureAtlas: the table's size doesn't match its header");
+		}
+
+		mPages = reinterpret_cast<const Page*>(bytes + pagesOffset);
+		mEntries = reinterpret_cast<const Entry*>(bytes + entriesOffset);
+		mNames = reinterpret_cast<const char*>(bytes + namesOffset);
+
+		for (uint32_t i = 0; i < mHeader->PageCount; ++i)
+		{
+			if (mPages[i].NameOffset >= mHeader->NamesSize)
+			{
+				throw runtime_error("TextureAtlas: a page's name is out of range");
+			}
+		}
+
+		for (uint32_t i = 0; i < mHeader->EntryCount; ++i)
+		{
+			const Entry& entry = mEntries[i];
+			if (entry.NameOffset >= mHeader->NamesSize || entry.Page >= mHeader->PageCount || (i > 0 && mEntries[i - 1].NameHash > entry.NameHash))
+			{
+				throw runtime_error("TextureAtlas: an entry is out of range or out of order");
+			}
+		}
+	}
+
+	uint32_t TextureAtlas::PageCount() const
+	{
+		return mHeader->PageCount;
+	}
+
+	const TextureAtlas::Page& TextureAtlas::GetPage(uint32_t index) const
+	{
+		return mPages[index];
+	}
+
+	uint32_t TextureAtlas::EntryCount() const
+	{
+		return mHeader->EntryCount;
+	}
+
+	const TextureAtlas::Entry& TextureAtlas::GetEntry(uint32_t index) const
+	{
+		return mEntries[index];
+	}
+
+	const char* TextureAtlas::Name(uint32_t nameOffset) const
+	{
+		return mNames + nameOffset;
+	}
+
+	const TextureAtlas::Entry* TextureAtlas::Find(const char* name) const
+	{
+		const uint64_t hash = HashName(name);
+		const Entry* end = mEntries + mHeader->EntryCount;
+		const Entry* entry = lower_bound(mEntries, end, hash, [](const Entry& candidate, uint64_t value) {
+			return candidate.NameHash < value;
+		});
+
+		// Serialize refuses colliding names, so a matching hash is the only candidate; the name check rejects images
+		// that aren't in the table but happen to share a hash with one that is.
+		if (entry != end && entry->NameHash == hash && strcmp(mNames + entry->NameOffset, name) == 0)
+		{
+			return entry;
+		}
+
+		return nullptr;
+	}
+
+	const TextureAtlas::Entry* TextureAtlas::Find(const string& name) const
+	{
+		return Find(name.c_str());
+	}
+
+	uint64_t TextureAtlas::HashName(const char* name)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (const char* character = name; *character != '\0'; ++character)
+		{
+			hash ^= static_cast<uint8_t>(*character);
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	vector<uint8_t> TextureAtlas::Serialize(const vector<PageDesc>& pages, const vector<EntryDesc>& entries)
+	{
+		string names;
+		vector<Page> pageRecords;
+		pageRecords.reserve(pages.size());
+		for (const PageDesc& page : pages)
+		{
+			const Page record = { page.Width, page.Height, static_cast<uint32_t>(names.size()), 0 };
+			pageRecords.push_back(record);
+			names.append(page.Name);
+			names.push_back('\0');
+		}
+
+		vector<Entry> entryRecords;
+		entryRecords.reserve(entries.size());
+		for (const EntryDesc& entry : entries)
+		{
+			if (entry.Page >= pages.size() || entry.X + entry.Width > pages[entry.Page].Width || entry.Y + entry.Height > pages[entry.Page].Height ||
+				pages[entry.Page].Width > UINT16_MAX || pages[entry.Page].Height > UINT16_MAX)
+			{
+				throw runtime_error("TextureAtlas: " + entry.Name + " is off its page");
+			}
+
+			const float pageWidth = static_cast<float>(pages[entry.Page].Width);
+			const float pageHeight = static_cast<float>(pages[entry.Page].Height);
+			Entry record;
+			record.NameHash = HashName(entry.Name.c_str());
+			record.NameOffset = static_cast<uint32_t>(names.size());
+			record.Page = static_cast<uint16_t>(entry.Page);
+			record.Reserved = 0;
+			record.U0 = static_cast<float>(entry.X) / pageWidth;
+			record.V0 = static_cast<float>(entry.Y) / pageHeight;
+			record.U1 = static_cast<float>(entry.X + entry.Width) / pageWidth;
+			record.V1 = static_cast<float>(entry.Y + entry.Height) / pageHeight;
+			record.X = static_cast<uint16_t>(entry.X);
+			record.Y = static_cast<uint16_t>(entry.Y);
+			record.Width = static_cast<uint16_t>(entry.Width);
+			record.Height = static_cast<uint16_t>(entry.Height);
+			entryRecords.push_back(record);
+			names.append(entry.Name);
+			names.push_back('\0');
+		}
+
+		sort(entryRecords.begin(), entryRecords.end(), [](const Entry& left, const Entry& right) {
+			return left.NameHash < right.NameHash;
+		});
+
+		for (size_t i = 1; i < entryRecords.size(); ++i)
+		{
+			if (entryRecords[i - 1].NameHash == entryRecords[i].NameHash)
+			{
+				throw runtime_error(string("TextureAtlas: ") + (names.c_str() + entryRecords[i].NameOffset) + " is a duplicate, or its name's hash collides");
+			}
+		}
+
+		if (names.empty())
+		{
+			names.push_back('\0');
+		}
+
+		Header header = {};
+		header.Magic = Magic;
+		header.FileVersion = FileVersion;
+		header.PageCount = static_cast<uint32_t>(pageRecords.size());
+		header.EntryCount = static_cast<uint32_t>(entryRecords.size());
+		header.NamesSize = static_cast<uint32_t>(names.size());
+
+		vector<uint8_t> table(sizeof(Header) + pageRecords.size() * sizeof(Page) + entryRecords.size() * sizeof(Entry) + names.size());
+		uint8_t* destination = table.data();
+		memcpy(destination, &header, sizeof(header));
+		destination += sizeof(header);
+		if (!pageRecords.empty())
+		{
+			memcpy(destination, pageRecords.data(), pageRecords.size() * sizeof(Page));
+			destination += pageRecords.size() * sizeof(Page);
+		}
+
+		if (!entryRecords.empty())
+		{
+			memcpy(destination, entryRecords.data(), entryRecords.size() * sizeof(Entry));
+			destination += entryRecords.size() * sizeof(Entry);
+		}
+
+		memcpy(destination, names.data(), names.size());
+		return table;
+	}
+}
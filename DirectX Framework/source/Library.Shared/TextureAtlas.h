@@ -0,0 +1,106 @@
+#pragma once
+
+#include "AssetLoader.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	// The table of a packed texture atlas: which page each named image is on and where, as normalized UVs and as pixels.
+	// AtlasBuilder writes the table next to the page images. At run time the table is used in place, straight from the
+	// loaded (and, when large, mapped) file, so looking an image up is a binary search over name hashes with no parsing or
+	// allocation. This file only depends on the C++ standard library and the AssetLoader.
+	//
+	// File layout, little-endian: a Header, PageCount Pages, EntryCount Entries sorted by NameHash, then NamesSize bytes of
+	// null-terminated UTF-8 names that the pages and entries point into.
+	class TextureAtlas final
+	{
+	public:
+		struct Header
+		{
+			std::uint32_t Magic;
+			std::uint32_t FileVersion;
+			std::uint32_t PageCount;
+			std::uint32_t EntryCount;
+			std::uint32_t NamesSize;
+			std::uint32_t Reserved[3];
+		};
+
+		struct Page
+		{
+			std::uint32_t Width;
+			std::uint32_t Height;
+			std::uint32_t NameOffset;	// The page image's file name, relative to the table
+			std::uint32_t Reserved;
+		};
+
+		struct Entry
+		{
+			std::uint64_t NameHash;
+			std::uint32_t NameOffset;
+			std::uint16_t Page;
+			std::uint16_t Reserved;
+			float U0;					// Top left and bottom right of the image, excluding its padding
+			float V0;
+			float U1;
+			float V1;
+			std::uint16_t X;
+			std::uint16_t Y;
+			std::uint16_t Width;
+			std::uint16_t Height;
+		};
+
+		// What the builder knows about a page or a placed image, for Serialize.
+		struct PageDesc
+		{
+			std::string Name;
+			std::uint32_t Width;
+			std::uint32_t Height;
+		};
+
+		struct EntryDesc
+		{
+			std::string Name;
+			std::uint32_t Page;
+			std::uint32_t X;
+			std::uint32_t Y;
+			std::uint32_t Width;
+			std::uint32_t Height;
+		};
+
+		static const std::uint32_t Magic;
+		static const std::uint32_t FileVersion;
+
+		// Throws std::runtime_error if data isn't a well-formed table. The table holds a reference to data.
+		explicit TextureAtlas(const AssetLoader::AssetPointer& data);
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+		TextureAtlas(TextureAtlas&&) = default;
+		TextureAtlas& operator=(TextureAtlas&&) = default;
+		~TextureAtlas() = default;
+
+		std::uint32_t PageCount() const;
+		const Page& GetPage(std::uint32_t index) const;
+		std::uint32_t EntryCount() const;
+		const Entry& GetEntry(std::uint32_t index) const;
+		const char* Name(std::uint32_t nameOffset) const;
+
+		// Returns null if there is no image of that name.
+		const Entry* Find(const char* name) const;
+		const Entry* Find(const std::string& name) const;
+
+		// 64-bit FNV-1a of a null-terminated name.
+		static std::uint64_t HashName(const char* name);
+
+		// Builds a table. Throws std::runtime_error for duplicate names, a bad page index or an image off its page.
+		static std::vector<std::uint8_t> Serialize(const std::vector<PageDesc>& pages, const std::vector<EntryDesc>& entries);
+
+	private:
+		AssetLoader::AssetPointer mData;
+		const Header* mHeader;
+		const Page* mPages;
+		const Entry* mEntries;
+		const char* mNames;
+	};
+}
@@ -0,0 +1,696 @@
+#include "TextureProcessor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#if !defined(DX_TEXTURE_PROCESSOR_SCALAR) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define DX_TEXTURE_PROCESSOR_SSE2
+#include <emmintrin.h>
+#elif !defined(DX_TEXTURE_PROCESSOR_SCALAR) && (defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON))
+#define DX_TEXTURE_PROCESSOR_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		// Filtering weights each texel by its alpha plus this, so fully transparent areas still average their colors.
+		const float AlphaBias = 1.0f / 4096.0f;
+
+		const uint32_t LinearToSrgbSize = 16384;
+
+		struct ConversionTables
+		{
+			float SrgbToLinear[256];
+			uint8_t LinearToSrgb[LinearToSrgbSize];
+		};
+
+		const ConversionTables& Tables()
+		{
+			static const ConversionTables tables = []() {
+				ConversionTables built;
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					const float srgb = static_cast<float>(i) / 255.0f;
+					built.SrgbToLinear[i] = (srgb <= 0.04045f ? srgb / 12.92f : pow((srgb + 0.055f) / 1.055f, 2.4f));
+				}
+
+				for (uint32_t i = 0; i < LinearToSrgbSize; ++i)
+				{
+					const float linear = static_cast<float>(i) / static_cast<float>(LinearToSrgbSize - 1);
+					const float srgb = (linear <= 0.0031308f ? linear * 12.92f : 1.055f * pow(linear, 1.0f / 2.4f) - 0.055f);
+					built.LinearToSrgb[i] = static_cast<uint8_t>(min(max(srgb, 0.0f), 1.0f) * 255.0f + 0.5f);
+				}
+
+				return built;
+			}();
+
+			return tables;
+		}
+
+		// A level as alpha-weighted colors and the weights: (r * w, g * w, b * w, w) per texel, w = alpha + AlphaBias.
+		void ToWeighted(const uint8_t* pixels, uint32_t count, bool srgb, vector<float>& weighted)
+		{
+			const ConversionTables& tables = Tables();
+			weighted.resize(static_cast<size_t>(count) * 4);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint8_t* pixel = pixels + static_cast<size_t>(i) * 4;
+				float* texel = &weighted[static_cast<size_t>(i) * 4];
+				const float weight = static_cast<float>(pixel[3]) / 255.0f + AlphaBias;
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					const float color = (srgb ? tables.SrgbToLinear[pixel[channel]] : static_cast<float>(pixel[channel]) / 255.0f);
+					texel[channel] = color * weight;
+				}
+
+				texel[3] = weight;
+			}
+		}
+
+		// Box filters 2 x 2 texels into one; odd edges repeat their last row or column.
+		void Downsample(const vector<float>& source, uint32_t sourceWidth, uint32_t sourceHeight, vector<float>& destination, uint32_t width, uint32_t height)
+		{
+			destination.resize(static_cast<size_t>(width) * height * 4);
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				const float* row0 = &source[static_cast<size_t>(min(2 * y, sourceHeight - 1)) * sourceWidth * 4];
+				const float* row1 = &source[static_cast<size_t>(min(2 * y + 1, sourceHeight - 1)) * sourceWidth * 4];
+				float* output = &destination[static_cast<size_t>(y) * width * 4];
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const size_t x0 = static_cast<size_t>(min(2 * x, sourceWidth - 1)) * 4;
+					const size_t x1 = static_cast<size_t>(min(2 * x + 1, sourceWidth - 1)) * 4;
+#if defined(DX_TEXTURE_PROCESSOR_SSE2)
+					const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)), _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+					_mm_storeu_ps(output + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#elif defined(DX_TEXTURE_PROCESSOR_NEON)
+					const float32x4_t sum = vaddq_f32(vaddq_f32(vld1q_f32(row0 + x0), vld1q_f32(row0 + x1)), vaddq_f32(vld1q_f32(row1 + x0), vld1q_f32(row1 + x1)));
+					vst1q_f32(output + x * 4, vmulq_n_f32(sum, 0.25f));
+#else
+					for (uint32_t channel = 0; channel < 4; ++channel)
+					{
+						output[x * 4 + channel] = (row0[x0 + channel] + row0[x1 + channel] + row1[x0 + channel] + row1[x1 + channel]) * 0.25f;
+					}
+#endif
+				}
+			}
+		}
+
+		// Divides the weights back out and quantizes. Colors are scaled to table indices (or to 8 bits, unless sRGB) four at
+		// a time; alpha is the weight less its bias.
+		void FromWeighted(const vector<float>& weighted, uint32_t count, bool srgb, uint8_t* pixels)
+		{
+			const ConversionTables& tables = Tables();
+			const float scale = (srgb ? static_cast<float>(LinearToSrgbSize - 1) : 255.0f);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const float* texel = &weighted[static_cast<size_t>(i) * 4];
+				uint8_t* pixel = pixels + static_cast<size_t>(i) * 4;
+				const float weight = texel[3];
+				int32_t scaled[4];
+#if defined(DX_TEXTURE_PROCESSOR_SSE2)
+				const __m128 color = _mm_div_ps(_mm_loadu_ps(texel), _mm_set1_ps(weight));
+				const __m128 clamped = _mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(scaled), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(scale)), _mm_set1_ps(0.5f))));
+#elif defined(DX_TEXTURE_PROCESSOR_NEON)
+				const float32x4_t color = vmulq_n_f32(vld1q_f32(texel), 1.0f / weight);
+				const float32x4_t clamped = vminq_f32(vmaxq_f32(color, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+				vst1q_s32(scaled, vcvtq_s32_f32(vaddq_f32(vmulq_n_f32(clamped, scale), vdupq_n_f32(0.5f))));
+#else
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					scaled[channel] = static_cast<int32_t>(min(max(texel[channel] / weight, 0.0f), 1.0f) * scale + 0.5f);
+				}
+#endif
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					pixel[channel] = (srgb ? tables.LinearToSrgb[scaled[channel]] : static_cast<uint8_t>(scaled[channel]));
+				}
+
+				pixel[3] = static_cast<uint8_t>(min(max(weight - AlphaBias, 0.0f), 1.0f) * 255.0f + 0.5f);
+			}
+		}
+
+		typedef uint8_t Texels[16][4];
+
+		// Reads the 4 x 4 block at bx, by; texels past the right or bottom edge repeat the edge.
+		void LoadBlock(const TextureProcessor::Image& image, uint32_t bx, uint32_t by, Texels& texels)
+		{
+			for (uint32_t y = 0; y < 4; ++y)
+			{
+				const uint32_t row = min(by * 4 + y, image.Height - 1);
+				for (uint32_t x = 0; x < 4; ++x)
+				{
+					const uint32_t column = min(bx * 4 + x, image.Width - 1);
+					memcpy(texels[y * 4 + x], &image.Pixels[(static_cast<size_t>(row) * image.Width + column) * 4], 4);
+				}
+			}
+		}
+
+		uint16_t Pack565(const float color[3])
+		{
+			const uint32_t r = static_cast<uint32_t>(min(max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+			const uint32_t g = static_cast<uint32_t>(min(max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+			const uint32_t b = static_cast<uint32_t>(min(max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void Unpack565(uint16_t packed, int32_t color[3])
+		{
+			const int32_t r = (packed >> 11) & 0x1F;
+			const int32_t g = (packed >> 5) & 0x3F;
+			const int32_t b = packed & 0x1F;
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+
+		// The block's palette; in three-color mode the fourth entry is transparent black.
+		void ColorPalette(uint16_t color0, uint16_t color1, bool fourColor, int32_t palette[4][3])
+		{
+			Unpack565(color0, palette[0]);
+			Unpack565(color1, palette[1]);
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				if (fourColor)
+				{
+					palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+					palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+				}
+				else
+				{
+					palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+					palette[3][channel] = 0;
+				}
+			}
+		}
+
+		// Picks each texel's nearest palette entry and returns the summed squared error. Transparent texels take index 3.
+		uint32_t ChooseIndices(const Texels& texels, uint32_t transparentMask, uint16_t color0, uint16_t color1, bool fourColor, uint8_t indices[16])
+		{
+			int32_t palette[4][3];
+			ColorPalette(color0, color1, fourColor, palette);
+			const uint32_t choices = (fourColor ? 4 : 3);
+
+			uint32_t error = 0;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				if ((transparentMask & (1u << i)) != 0)
+				{
+					indices[i] = 3;
+					continue;
+				}
+
+				uint32_t bestError = numeric_limits<uint32_t>::max();
+				for (uint32_t choice = 0; choice < choices; ++choice)
+				{
+					uint32_t distance = 0;
+					for (uint32_t channel = 0; channel < 3; ++channel)
+					{
+						const int32_t difference = static_cast<int32_t>(texels[i][channel]) - palette[choice][channel];
+						distance += static_cast<uint32_t>(difference * difference);
+					}
+
+					if (distance < bestError)
+					{
+						bestError = distance;
+						indices[i] = static_cast<uint8_t>(choice);
+					}
+				}
+
+				error += bestError;
+			}
+
+			return error;
+		}
+
+		// Least squares endpoints for the chosen indices: each texel is weight * endpoint0 + (1 - weight) * endpoint1.
+		bool RefineEndpoints(const Texels& texels, uint32_t transparentMask, const uint8_t indices[16], bool fourColor, float endpoint0[3], float endpoint1[3])
+		{
+			static const float FourColorWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+			static const float ThreeColorWeights[3] = { 1.0f, 0.0f, 0.5f };
+
+			float aa = 0.0f;
+			float ab = 0.0f;
+			float bb = 0.0f;
+			float ax[3] = {};
+			float bx[3] = {};
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				if ((transparentMask & (1u << i)) != 0)
+				{
+					continue;
+				}
+
+				const float a = (fourColor ? FourColorWeights[indices[i]] : ThreeColorWeights[indices[i]]);
+				const float b = 1.0f - a;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					ax[channel] += a * texels[i][channel];
+					bx[channel] += b * texels[i][channel];
+				}
+			}
+
+			const float determinant = aa * bb - ab * ab;
+			if (fabs(determinant) < 1.0e-6f)
+			{
+				return false;
+			}
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				endpoint0[channel] = (bb * ax[channel] - ab * bx[channel]) / determinant;
+				endpoint1[channel] = (aa * bx[channel] - ab * ax[channel]) / determinant;
+			}
+
+			return true;
+		}
+
+		// Writes 8 bytes: two 565 endpoints and sixteen 2-bit indices. Four-color mode needs color0 > color1, three-color
+		// mode color0 <= color1; swapping the endpoints swaps indices 0 and 1, and 2 and 3 in four-color mode.
+		void WriteColorBlock(uint16_t color0, uint16_t color1, bool fourColor, uint8_t indices[16], uint8_t* block)
+		{
+			if (fourColor && color0 < color1)
+			{
+				swap(color0, color1);
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					indices[i] ^= 1;
+				}
+			}
+			else if (fourColor && color0 == color1)
+			{
+				// Equal endpoints read as three-color mode; every entry but the last is the one color anyway.
+				memset(indices, 0, 16);
+			}
+			else if (!fourColor && color0 > color1)
+			{
+				swap(color0, color1);
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					indices[i] = (indices[i] < 2 ? static_cast<uint8_t>(indices[i] ^ 1) : indices[i]);
+				}
+			}
+
+			uint32_t packedIndices = 0;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				packedIndices |= static_cast<uint32_t>(indices[i]) << (2 * i);
+			}
+
+			block[0] = static_cast<uint8_t>(color0 & 0xFF);
+			block[1] = static_cast<uint8_t>(color0 >> 8);
+			block[2] = static_cast<uint8_t>(color1 & 0xFF);
+			block[3] = static_cast<uint8_t>(color1 >> 8);
+			memcpy(block + 4, &packedIndices, 4);
+		}
+
+		// BC1 blocks with texels under half alpha use three-color mode, with those texels transparent black. BC3 blocks are
+		// always four-color, and fit their colors without the fully transparent texels, whose colors are never seen.
+		void EncodeColorBlock(const Texels& texels, bool bc1, uint8_t* block)
+		{
+			uint32_t transparentMask = 0;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				transparentMask |= (texels[i][3] < (bc1 ? 128 : 1) ? 1u << i : 0u);
+			}
+
+			uint8_t indices[16];
+			if (transparentMask == 0xFFFF)
+			{
+				memset(indices, 3, sizeof(indices));
+				WriteColorBlock(0, 0, false, indices, block);
+				return;
+			}
+
+			const bool fourColor = (!bc1 || transparentMask == 0);
+
+			// The principal axis of the opaque texels' colors, by power iteration.
+			float mean[3] = {};
+			float count = 0.0f;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				if ((transparentMask & (1u << i)) == 0)
+				{
+					for (uint32_t channel = 0; channel < 3; ++channel)
+					{
+						const float value = texels[i][channel];
+						mean[channel] += value;
+					}
+
+					count += 1.0f;
+				}
+			}
+
+			float covariance[6] = {};
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				mean[channel] /= count;
+			}
+
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				if ((transparentMask & (1u << i)) == 0)
+				{
+					const float r = texels[i][0] - mean[0];
+					const float g = texels[i][1] - mean[1];
+					const float b = texels[i][2] - mean[2];
+					covariance[0] += r * r;
+					covariance[1] += r * g;
+					covariance[2] += r * b;
+					covariance[3] += g * g;
+					covariance[4] += g * b;
+					covariance[5] += b * b;
+				}
+			}
+
+			// Start from the covariance row of the channel that varies most: unlike the bounding box's diagonal, it can't be
+			// orthogonal to the axis (red against blue has the diagonal (1, 0, 1) and the axis (1, 0, -1)).
+			float axis[3] = { covariance[0], covariance[1], covariance[2] };
+			if (covariance[3] > covariance[0] && covariance[3] >= covariance[5])
+			{
+				axis[0] = covariance[1];
+				axis[1] = covariance[3];
+				axis[2] = covariance[4];
+			}
+			else if (covariance[5] > covariance[0] && covariance[5] > covariance[3])
+			{
+				axis[0] = covariance[2];
+				axis[1] = covariance[4];
+				axis[2] = covariance[5];
+			}
+
+			for (uint32_t iteration = 0; iteration < 8; ++iteration)
+			{
+				const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+				const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+				const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+				const float length = max(fabs(x), max(fabs(y), fabs(z)));
+				if (length < 1.0e-6f)
+				{
+					break;
+				}
+
+				axis[0] = x / length;
+				axis[1] = y / length;
+				axis[2] = z / length;
+			}
+
+			const float axisLength = sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+			float endpoint0[3] = { mean[0], mean[1], mean[2] };
+			float endpoint1[3] = { mean[0], mean[1], mean[2] };
+			if (axisLength > 1.0e-6f)
+			{
+				float lowest = numeric_limits<float>::max();
+				float highest = -numeric_limits<float>::max();
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					if ((transparentMask & (1u << i)) == 0)
+					{
+						const float projection = ((texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] + (texels[i][2] - mean[2]) * axis[2]) / axisLength;
+						lowest = min(lowest, projection);
+						highest = max(highest, projection);
+					}
+				}
+
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					endpoint0[channel] = mean[channel] + axis[channel] / axisLength * highest;
+					endpoint1[channel] = mean[channel] + axis[channel] / axisLength * lowest;
+				}
+			}
+
+			uint16_t color0 = Pack565(endpoint0);
+			uint16_t color1 = Pack565(endpoint1);
+			uint32_t error = ChooseIndices(texels, transparentMask, color0, color1, fourColor, indices);
+
+			if (error > 0 && RefineEndpoints(texels, transparentMask, indices, fourColor, endpoint0, endpoint1))
+			{
+				uint8_t refinedIndices[16];
+				const uint16_t refined0 = Pack565(endpoint0);
+				const uint16_t refined1 = Pack565(endpoint1);
+				const uint32_t refinedError = ChooseIndices(texels, transparentMask, refined0, refined1, fourColor, refinedIndices);
+				if (refinedError < error)
+				{
+					color0 = refined0;
+					color1 = refined1;
+					memcpy(indices, refinedIndices, sizeof(indices));
+				}
+			}
+
+			WriteColorBlock(color0, color1, fourColor, indices, block);
+		}
+
+		// Writes 8 bytes: the block's largest and smallest alpha, and sixteen 3-bit indices into the eight values between.
+		void EncodeAlphaBlock(const Texels& texels, uint8_t* block)
+		{
+			uint8_t alpha0 = 0;
+			uint8_t alpha1 = 255;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				alpha0 = max(alpha0, texels[i][3]);
+				alpha1 = min(alpha1, texels[i][3]);
+			}
+
+			int32_t palette[8] = { alpha0, alpha1 };
+			for (int32_t i = 1; i < 7; ++i)
+			{
+				palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+			}
+
+			uint64_t packedIndices = 0;
+			if (alpha0 != alpha1)
+			{
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					uint32_t bestIndex = 0;
+					int32_t bestError = numeric_limits<int32_t>::max();
+					for (uint32_t choice = 0; choice < 8; ++choice)
+					{
+						const int32_t error = abs(static_cast<int32_t>(texels[i][3]) - palette[choice]);
+						if (error < bestError)
+						{
+							bestError = error;
+							bestIndex = choice;
+						}
+					}
+
+					packedIndices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+				}
+			}
+
+			block[0] = alpha0;
+			block[1] = alpha1;
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				block[2 + i] = static_cast<uint8_t>(packedIndices >> (8 * i));
+			}
+		}
+
+		void DecodeColorBlock(const uint8_t* block, bool forceFourColor, Texels& texels)
+		{
+			const uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+			const uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+			const bool fourColor = (forceFourColor || color0 > color1);
+			int32_t palette[4][3];
+			ColorPalette(color0, color1, fourColor, palette);
+
+			uint32_t packedIndices;
+			memcpy(&packedIndices, block + 4, 4);
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				const uint32_t index = (packedIndices >> (2 * i)) & 3;
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					texels[i][channel] = static_cast<uint8_t>(palette[index][channel]);
+				}
+
+				texels[i][3] = (!fourColor && index == 3 ? 0 : 255);
+			}
+		}
+
+		void DecodeAlphaBlock(const uint8_t* block, Texels& texels)
+		{
+			const int32_t alpha0 = block[0];
+			const int32_t alpha1 = block[1];
+			int32_t palette[8] = { alpha0, alpha1 };
+			for (int32_t i = 1; i < 7; ++i)
+			{
+				// The six-value mode, with explicit 0 and 255, is read but never written.
+				palette[i + 1] = (alpha0 > alpha1 ? ((7 - i) * alpha0 + i * alpha1) / 7 : (i < 5 ? ((5 - i) * alpha0 + i * alpha1) / 5 : (i == 5 ? 0 : 255)));
+			}
+
+			uint64_t packedIndices = 0;
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				packedIndices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+			}
+
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				texels[i][3] = static_cast<uint8_t>(palette[(packedIndices >> (3 * i)) & 7]);
+			}
+		}
+
+		template <typename EncodeBlock>
+		void CompressBlocks(const TextureProcessor::Image& image, uint32_t blockBytes, vector<uint8_t>& blocks, uint32_t threadCount, EncodeBlock encodeBlock)
+		{
+			const uint32_t blocksWide = (image.Width + 3) / 4;
+			const uint32_t blocksHigh = (image.Height + 3) / 4;
+			blocks.resize(static_cast<size_t>(blocksWide) * blocksHigh * blockBytes);
+
+			const auto encodeRows = [&image, &blocks, blocksWide, blockBytes, &encodeBlock](uint32_t firstRow, uint32_t endRow) {
+				Texels texels;
+				for (uint32_t by = firstRow; by < endRow; ++by)
+				{
+					for (uint32_t bx = 0; bx < blocksWide; ++bx)
+					{
+						LoadBlock(image, bx, by, texels);
+						encodeBlock(texels, &blocks[(static_cast<size_t>(by) * blocksWide + bx) * blockBytes]);
+					}
+				}
+			};
+
+			if (threadCount == 0)
+			{
+				threadCount = max(thread::hardware_concurrency(), 1u);
+			}
+
+			threadCount = max(min(threadCount, blocksHigh), 1u);
+			vector<thread> workers;
+			for (uint32_t worker = 1; worker < threadCount; ++worker)
+			{
+				workers.emplace_back(encodeRows, blocksHigh * worker / threadCount, blocksHigh * (worker + 1) / threadCount);
+			}
+
+			encodeRows(0, blocksHigh / threadCount);
+			for (thread& worker : workers)
+			{
+				worker.join();
+			}
+		}
+
+		template <typename DecodeBlock>
+		void DecompressBlocks(const uint8_t* blocks, uint32_t blockBytes, uint32_t width, uint32_t height, TextureProcessor::Image& image, DecodeBlock decodeBlock)
+		{
+			image.Width = width;
+			image.Height = height;
+			image.Pixels.resize(static_cast<size_t>(width) * height * 4);
+
+			const uint32_t blocksWide = (width + 3) / 4;
+			const uint32_t blocksHigh = (height + 3) / 4;
+			Texels texels;
+			for (uint32_t by = 0; by < blocksHigh; ++by)
+			{
+				for (uint32_t bx = 0; bx < blocksWide; ++bx)
+				{
+					decodeBlock(blocks + (static_cast<size_t>(by) * blocksWide + bx) * blockBytes, texels);
+					for (uint32_t y = 0; y < 4 && by * 4 + y < height; ++y)
+					{
+						for (uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x)
+						{
+							memcpy(&image.Pixels[(static_cast<size_t>(by * 4 + y) * width + bx * 4 + x) * 4], texels[y * 4 + x], 4);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void TextureProcessor::GenerateMips(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, vector<Image>& mips)
+	{
+		mips.clear();
+		mips.push_back(Image{ width, height, vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * 4) });
+
+		vector<float> level;
+		vector<float> nextLevel;
+		ToWeighted(pixels, width * height, srgb, level);
+		while (width > 1 || height > 1)
+		{
+			const uint32_t nextWidth = max(width / 2, 1u);
+			const uint32_t nextHeight = max(height / 2, 1u);
+			Downsample(level, width, height, nextLevel, nextWidth, nextHeight);
+
+			Image mip = { nextWidth, nextHeight, vector<uint8_t>(static_cast<size_t>(nextWidth) * nextHeight * 4) };
+			FromWeighted(nextLevel, nextWidth * nextHeight, srgb, mip.Pixels.data());
+			mips.push_back(move(mip));
+
+			level.swap(nextLevel);
+			width = nextWidth;
+			height = nextHeight;
+		}
+	}
+
+	void TextureProcessor::CompressBC1(const Image& image, vector<uint8_t>& blocks, uint32_t threadCount)
+	{
+		CompressBlocks(image, 8, blocks, threadCount, [](const Texels& texels, uint8_t* block) {
+			EncodeColorBlock(texels, true, block);
+		});
+	}
+
+	void TextureProcessor::CompressBC3(const Image& image, vector<uint8_t>& blocks, uint32_t threadCount)
+	{
+		CompressBlocks(image, 16, blocks, threadCount, [](const Texels& texels, uint8_t* block) {
+			EncodeAlphaBlock(texels, block);
+			EncodeColorBlock(texels, false, block + 8);
+		});
+	}
+
+	void TextureProcessor::DecompressBC1(const uint8_t* blocks, uint32_t width, uint32_t height, Image& image)
+	{
+		DecompressBlocks(blocks, 8, width, height, image, [](const uint8_t* block, Texels& texels) {
+			DecodeColorBlock(block, false, texels);
+		});
+	}
+
+	void TextureProcessor::DecompressBC3(const uint8_t* blocks, uint32_t width, uint32_t height, Image& image)
+	{
+		DecompressBlocks(blocks, 16, width, height, image, [](const uint8_t* block, Texels& texels) {
+			DecodeColorBlock(block + 8, true, texels);
+			DecodeAlphaBlock(block, texels);
+		});
+	}
+
+	double TextureProcessor::Psnr(const Image& reference, const Image& image, bool alpha)
+	{
+		uint64_t squaredError = 0;
+		uint64_t samples = 0;
+		const size_t count = min(reference.Pixels.size(), image.Pixels.size()) / 4;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint8_t* expected = &reference.Pixels[i * 4];
+			const uint8_t* actual = &image.Pixels[i * 4];
+			if (alpha)
+			{
+				const int32_t difference = static_cast<int32_t>(expected[3]) - actual[3];
+				squaredError += static_cast<uint64_t>(difference * difference);
+				++samples;
+				continue;
+			}
+
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				const int32_t difference = (static_cast<int32_t>(expected[channel]) * expected[3] - static_cast<int32_t>(actual[channel]) * actual[3] + 127) / 255;
+				squaredError += static_cast<uint64_t>(difference * difference);
+				++samples;
+			}
+		}
+
+		if (squaredError == 0)
+		{
+			return numeric_limits<double>::infinity();
+		}
+
+		const double meanSquaredError = static_cast<double>(squaredError) / static_cast<double>(samples);
+		return 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Offline texture preprocessing: mip chain generation and BC1/BC3 block compression, for TextureConverter to write as
+	// DDS files the game uploads without decoding.
+	//
+	// Mips are box filtered in linear light: sRGB-encoded colors are decoded through a table, weighted by alpha so that
+	// transparent texels don't darken their neighbors' edges, averaged four at a time with SSE2 or NEON, and encoded back
+	// through a table. The whole chain is filtered from floating-point levels, so it is quantized once per level rather
+	// than compounding.
+	//
+	// The block encoders fit each block's endpoints along its colors' principal axis, refine them once by least squares,
+	// and keep whichever fit has the smaller error. BC3's alpha uses the eight-value mode between the block's extremes.
+	// Rows of blocks are spread over worker threads; the output doesn't depend on the thread count.
+	//
+	// This file only depends on the C++ standard library.
+	class TextureProcessor final
+	{
+	public:
+		// R8G8B8A8, rows tightly packed.
+		struct Image
+		{
+			std::uint32_t Width;
+			std::uint32_t Height;
+			std::vector<std::uint8_t> Pixels;
+		};
+
+		// Replaces mips with the full chain down to 1 x 1; mips[0] is a copy of the source. With srgb false, colors are
+		// filtered as they are.
+		static void GenerateMips(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, bool srgb, std::vector<Image>& mips);
+
+		// Replaces blocks with the image's 4 x 4 blocks, row by row; partial blocks at the right and bottom repeat the
+		// edge. BC1 uses its transparent mode for blocks with texels under half alpha; BC3 ignores the colors of fully
+		// transparent texels. A thread count of zero uses one thread per hardware thread.
+		static void CompressBC1(const Image& image, std::vector<std::uint8_t>& blocks, std::uint32_t threadCount = 0);
+		static void CompressBC3(const Image& image, std::vector<std::uint8_t>& blocks, std::uint32_t threadCount = 0);
+
+		static void DecompressBC1(const std::uint8_t* blocks, std::uint32_t width, std::uint32_t height, Image& image);
+		static void DecompressBC3(const std::uint8_t* blocks, std::uint32_t width, std::uint32_t height, Image& image);
+
+		// Peak signal-to-noise ratio in dB over the color channels, or over alpha alone. Colors are compared multiplied by
+		// their alpha, as they are seen when blended, so the colors of transparent texels don't count. Identical images
+		// give infinity.
+		static double Psnr(const Image& reference, const Image& image, bool alpha);
+
+		TextureProcessor() = delete;
+		TextureProcessor(const TextureProcessor&) = delete;
+		TextureProcessor(TextureProcessor&&) = delete;
+		TextureProcessor& operator=(const TextureProcessor&) = delete;
+		TextureProcessor& operator=(TextureProcessor&&) = delete;
+	};
+}
@@ -1,14 +1,100 @@
-#include "pch.h"
 #include "Transform2D.h"
 
+using namespace std;
 using namespace DirectX;
 
 namespace DX
 {
-	const Transform2D Transform2D::Identity = { Vector2Helper::Zero, 0.0f, Vector2Helper::One };
+	const Transform2D Transform2D::Identity = { XMFLOAT2(0.0f, 0.0f), 0.0f, XMFLOAT2(1.0f, 1.0f) };
 
 	Transform2D::Transform2D(const XMFLOAT2& position, float rotation, const XMFLOAT2& scale) :
-		mPosition(position), mRotation(rotation), mScale(scale)
+		mPosition(position), mRotation(rotation), mScale(scale), mWorldMatrixDirty(true)
 	{
+		const Transform2D* transform = this;
+		ComputeWorldMatrices(&transform, 1);
 	}
-}
\ No newline at end of file
+
+	template <typename TransformAt>
+	size_t Transform2D::UpdateDirtyWorldMatrices(size_t count, TransformAt transformAt)
+	{
+		const Transform2D* batch[4];
+		size_t batchCount = 0;
+		size_t updated = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Transform2D* transform = transformAt(i);
+			if (transform->mWorldMatrixDirty)
+			{
+				batch[batchCount++] = transform;
+				if (batchCount == 4)
+				{
+					ComputeWorldMatrices(batch, batchCount);
+					updated += batchCount;
+					batchCount = 0;
+				}
+			}
+		}
+
+		if (batchCount > 0)
+		{
+			ComputeWorldMatrices(batch, batchCount);
+			updated += batchCount;
+		}
+
+		return updated;
+	}
+
+	size_t Transform2D::UpdateWorldMatrices(Transform2D* transforms, size_t count)
+	{
+		return UpdateDirtyWorldMatrices(count, [transforms](size_t i) { return &transforms[i]; });
+	}
+
+	size_t Transform2D::UpdateWorldMatrices(const Transform2D* const* transforms, size_t count)
+	{
+		return UpdateDirtyWorldMatrices(count, [transforms](size_t i) { return transforms[i]; });
+	}
+
+	// Up to four transforms, one per vector lane. With rotation r and scale (x, y), scaling * rotation * translation is
+	//   [ x cos r   x sin r   0  0 ]
+	//   [ -y sin r  y cos r   0  0 ]
+	//   [ 0         0         1  0 ]
+	//   [ position            0  1 ]
+	// Unused lanes repeat the first transform. WorldMatrix goes through here too, so a matrix doesn't depend on whether
+	// it was computed alone or in a batch.
+	void Transform2D::ComputeWorldMatrices(const Transform2D* const* transforms, size_t count)
+	{
+		const Transform2D* lanes[4];
+		for (size_t lane = 0; lane < 4; ++lane)
+		{
+			lanes[lane] = transforms[lane < count ? lane : 0];
+		}
+
+		const XMVECTOR rotations = XMVectorSet(lanes[0]->mRotation, lanes[1]->mRotation, lanes[2]->mRotation, lanes[3]->mRotation);
+		const XMVECTOR scaleX = XMVectorSet(lanes[0]->mScale.x, lanes[1]->mScale.x, lanes[2]->mScale.x, lanes[3]->mScale.x);
+		const XMVECTOR scaleY = XMVectorSet(lanes[0]->mScale.y, lanes[1]->mScale.y, lanes[2]->mScale.y, lanes[3]->mScale.y);
+
+		XMVECTOR sines;
+		XMVECTOR cosines;
+		XMVectorSinCos(&sines, &cosines, rotations);
+
+		XMVECTORF32 m11;
+		XMVECTORF32 m12;
+		XMVECTORF32 m21;
+		XMVECTORF32 m22;
+		m11.v = XMVectorMultiply(scaleX, cosines);
+		m12.v = XMVectorMultiply(scaleX, sines);
+		m21.v = XMVectorNegate(XMVectorMultiply(scaleY, sines));
+		m22.v = XMVectorMultiply(scaleY, cosines);
+
+		for (size_t lane = 0; lane < count; ++lane)
+		{
+			const Transform2D& transform = *transforms[lane];
+			transform.mWorldMatrix = XMFLOAT4X4(
+				m11.f[lane], m12.f[lane], 0.0f, 0.0f,
+				m21.f[lane], m22.f[lane], 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				transform.mPosition.x, transform.mPosition.y, 0.0f, 1.0f);
+			transform.mWorldMatrixDirty = false;
+		}
+	}
+}
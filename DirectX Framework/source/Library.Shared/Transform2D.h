@@ -1,10 +1,14 @@
 #pragma once
 
 #include "VectorHelper.h"
+#include <cstddef>
 #include <DirectXMath.h>
 
 namespace DX
 {
+	// A position, rotation and scale in the xy plane. The world matrix is cached: the setters mark it dirty and it is
+	// recomputed the next time it's read, or for many transforms at once by UpdateWorldMatrices. Reading it isn't safe
+	// from several threads at once while it's dirty.
 	class Transform2D final
 	{
 	public:
@@ -25,13 +29,30 @@ namespace DX
 		DirectX::XMMATRIX ScalingMatrix() const;
 		void SetScale(const DirectX::XMFLOAT2& scale);
 
+		// Scaling, then rotation, then translation.
 		DirectX::XMMATRIX WorldMatrix() const;
+		bool WorldMatrixDirty() const;
+
+		// Recomputes the world matrices of the dirty transforms among count, four at a time: the four rotations' sines and
+		// cosines are computed together, and so are the scaled rotation terms. Returns how many were recomputed.
+		static std::size_t UpdateWorldMatrices(Transform2D* transforms, std::size_t count);
+
+		// The same, for transforms held by the objects they place. The cached matrix is mutable, so transforms reached
+		// through const references can be updated too.
+		static std::size_t UpdateWorldMatrices(const Transform2D* const* transforms, std::size_t count);
 
 	private:
+		template <typename TransformAt>
+		static std::size_t UpdateDirtyWorldMatrices(std::size_t count, TransformAt transformAt);
+
+		static void ComputeWorldMatrices(const Transform2D* const* transforms, std::size_t count);
+
 		DirectX::XMFLOAT2 mPosition;
 		float mRotation;
 		DirectX::XMFLOAT2 mScale;
+		mutable bool mWorldMatrixDirty;
+		mutable DirectX::XMFLOAT4X4 mWorldMatrix;
 	};
 }
 
-#include "Transform2D.inl"
\ No newline at end of file
+#include "Transform2D.inl"
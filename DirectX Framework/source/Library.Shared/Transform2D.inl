@@ -10,11 +10,13 @@ namespace DX
 	inline void Transform2D::SetPosition(const DirectX::XMFLOAT2& position)
 	{
 		mPosition = position;
+		mWorldMatrixDirty = true;
 	}
 
 	inline void Transform2D::SetPosition(const float x, const float y)
 	{
 		mPosition = DirectX::XMFLOAT2(x, y);
+		mWorldMatrixDirty = true;
 	}
 
 	inline DirectX::XMMATRIX Transform2D::TranslationMatrix() const
@@ -30,6 +32,7 @@ namespace DX
 	inline void Transform2D::SetRotation(const float rotation)
 	{
 		mRotation = rotation;
+		mWorldMatrixDirty = true;
 	}
 
 	inline DirectX::XMMATRIX Transform2D::RotationMatrix() const
@@ -50,10 +53,22 @@ namespace DX
 	inline void Transform2D::SetScale(const DirectX::XMFLOAT2& scale)
 	{
 		mScale = scale;
+		mWorldMatrixDirty = true;
 	}
 
 	inline DirectX::XMMATRIX Transform2D::WorldMatrix() const
 	{
-		return ScalingMatrix() * RotationMatrix() * TranslationMatrix();
+		if (mWorldMatrixDirty)
+		{
+			const Transform2D* transform = this;
+			ComputeWorldMatrices(&transform, 1);
+		}
+
+		return DirectX::XMLoadFloat4x4(&mWorldMatrix);
+	}
+
+	inline bool Transform2D::WorldMatrixDirty() const
+	{
+		return mWorldMatrixDirty;
 	}
 }
\ No newline at end of file
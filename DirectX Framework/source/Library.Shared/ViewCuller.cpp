@@ -0,0 +1,332 @@
+#include "ViewCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if !defined(DX_VIEW_CULLER_SCALAR) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define DX_VIEW_CULLER_SSE2
+#include <emmintrin.h>
+#elif !defined(DX_VIEW_CULLER_SCALAR) && (defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON))
+#define DX_VIEW_CULLER_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace DX
+{
+	namespace
+	{
+		// A lane passes when its object overlaps the view: left <= view right, right >= view left, and the same for y.
+		// Returns one bit per lane, lane 0 in bit 0.
+#if defined(DX_VIEW_CULLER_SSE2)
+		struct View4
+		{
+			__m128 Left;
+			__m128 Bottom;
+			__m128 Right;
+			__m128 Top;
+		};
+
+		inline View4 SplatView(const CullBounds& view)
+		{
+			return { _mm_set1_ps(view.Left), _mm_set1_ps(view.Bottom), _mm_set1_ps(view.Right), _mm_set1_ps(view.Top) };
+		}
+
+		inline uint32_t OverlapBits(const View4& view, const float* lefts, const float* bottoms, const float* rights, const float* tops)
+		{
+			const __m128 x = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(lefts), view.Right), _mm_cmpge_ps(_mm_loadu_ps(rights), view.Left));
+			const __m128 y = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(bottoms), view.Top), _mm_cmpge_ps(_mm_loadu_ps(tops), view.Bottom));
+			return static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(x, y)));
+		}
+#elif defined(DX_VIEW_CULLER_NEON)
+		struct View4
+		{
+			float32x4_t Left;
+			float32x4_t Bottom;
+			float32x4_t Right;
+			float32x4_t Top;
+		};
+
+		inline View4 SplatView(const CullBounds& view)
+		{
+			return { vdupq_n_f32(view.Left), vdupq_n_f32(view.Bottom), vdupq_n_f32(view.Right), vdupq_n_f32(view.Top) };
+		}
+
+		inline uint32_t OverlapBits(const View4& view, const float* lefts, const float* bottoms, const float* rights, const float* tops)
+		{
+			const uint32x4_t x = vandq_u32(vcleq_f32(vld1q_f32(lefts), view.Right), vcgeq_f32(vld1q_f32(rights), view.Left));
+			const uint32x4_t y = vandq_u32(vcleq_f32(vld1q_f32(bottoms), view.Top), vcgeq_f32(vld1q_f32(tops), view.Bottom));
+			static const uint32_t bits[4] = { 1, 2, 4, 8 };
+			const uint32x4_t laneBits = vandq_u32(vandq_u32(x, y), vld1q_u32(bits));
+			const uint32x2_t sums = vadd_u32(vget_low_u32(laneBits), vget_high_u32(laneBits));
+			return vget_lane_u32(sums, 0) | vget_lane_u32(sums, 1);
+		}
+#else
+		struct View4
+		{
+			CullBounds Bounds;
+		};
+
+		inline View4 SplatView(const CullBounds& view)
+		{
+			const View4 view4 = { view };
+			return view4;
+		}
+
+		inline uint32_t OverlapBits(const View4& view, const float* lefts, const float* bottoms, const float* rights, const float* tops)
+		{
+			uint32_t bits = 0;
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				const bool overlaps = (lefts[lane] <= view.Bounds.Right && rights[lane] >= view.Bounds.Left && bottoms[lane] <= view.Bounds.Top && tops[lane] >= view.Bounds.Bottom);
+				bits |= (overlaps ? 1u : 0u) << lane;
+			}
+
+			return bits;
+		}
+#endif
+
+		inline bool Overlaps(const CullBounds& bounds, const CullBounds& view)
+		{
+			return (bounds.Left <= view.Right && bounds.Right >= view.Left && bounds.Bottom <= view.Top && bounds.Top >= view.Bottom);
+		}
+
+		inline bool Contains(const CullBounds& view, const CullBounds& bounds)
+		{
+			return (bounds.Left >= view.Left && bounds.Right <= view.Right && bounds.Bottom >= view.Bottom && bounds.Top <= view.Top);
+		}
+
+		inline uint32_t ClampCell(float cell, uint32_t cellCount)
+		{
+			return static_cast<uint32_t>(min(max(cell, 0.0f), static_cast<float>(cellCount - 1)));
+		}
+	}
+
+	ViewCuller::ViewCuller(uint32_t objectsPerCell) :
+		mObjectsPerCell(max(objectsPerCell, 1u)), mObjectCount(0),
+		mOriginX(0.0f), mOriginY(0.0f), mInverseCellWidth(0.0f), mInverseCellHeight(0.0f), mMaxWidth(0.0f), mMaxHeight(0.0f),
+		mColumns(0), mRows(0), mTotals(), mLastCull()
+	{
+	}
+
+	void ViewCuller::Build(const CullBounds* bounds, uint32_t count)
+	{
+		mObjectCount = count;
+		mCells.clear();
+		mLefts.clear();
+		mBottoms.clear();
+		mRights.clear();
+		mTops.clear();
+		mIndices.clear();
+		mColumns = 0;
+		mRows = 0;
+		if (count == 0)
+		{
+			return;
+		}
+
+		float minX = bounds[0].Left;
+		float minY = bounds[0].Bottom;
+		float maxX = minX;
+		float maxY = minY;
+		mMaxWidth = 0.0f;
+		mMaxHeight = 0.0f;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const CullBounds& object = bounds[i];
+			minX = min(minX, object.Left);
+			minY = min(minY, object.Bottom);
+			maxX = max(maxX, object.Left);
+			maxY = max(maxY, object.Bottom);
+			mMaxWidth = max(mMaxWidth, object.Right - object.Left);
+			mMaxHeight = max(mMaxHeight, object.Top - object.Bottom);
+		}
+
+		// Square cells where the objects spread in both directions; a row or column of cells where they don't.
+		const float spanX = maxX - minX;
+		const float spanY = maxY - minY;
+		const double targetCells = ceil(static_cast<double>(count) / mObjectsPerCell);
+		if (spanX > 0.0f && spanY > 0.0f)
+		{
+			const double cellSize = sqrt(static_cast<double>(spanX) * spanY / targetCells);
+			mColumns = static_cast<uint32_t>(min(ceil(spanX / cellSize), targetCells)) + 1;
+			mRows = static_cast<uint32_t>(min(ceil(spanY / cellSize), targetCells)) + 1;
+		}
+		else
+		{
+			mColumns = (spanX > 0.0f ? static_cast<uint32_t>(targetCells) + 1 : 1);
+			mRows = (spanY > 0.0f ? static_cast<uint32_t>(targetCells) + 1 : 1);
+		}
+
+		mOriginX = minX;
+		mOriginY = minY;
+		mInverseCellWidth = (spanX > 0.0f ? static_cast<float>(mColumns - 1) / spanX : 0.0f);
+		mInverseCellHeight = (spanY > 0.0f ? static_cast<float>(mRows - 1) / spanY : 0.0f);
+
+		// Counting sort by cell; objects keep their order within a cell.
+		const float infinity = numeric_limits<float>::infinity();
+		const Cell emptyCell = { { infinity, infinity, -infinity, -infinity }, 0, 0 };
+		mCells.assign(static_cast<size_t>(mColumns) * mRows, emptyCell);
+		mCellOfObject.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const CullBounds& object = bounds[i];
+			const uint32_t column = ClampCell((object.Left - mOriginX) * mInverseCellWidth, mColumns);
+			const uint32_t row = ClampCell((object.Bottom - mOriginY) * mInverseCellHeight, mRows);
+			const uint32_t cellIndex = row * mColumns + column;
+			mCellOfObject[i] = cellIndex;
+
+			Cell& cell = mCells[cellIndex];
+			++cell.Count;
+			cell.Bounds.Left = min(cell.Bounds.Left, object.Left);
+			cell.Bounds.Bottom = min(cell.Bounds.Bottom, object.Bottom);
+			cell.Bounds.Right = max(cell.Bounds.Right, object.Right);
+			cell.Bounds.Top = max(cell.Bounds.Top, object.Top);
+		}
+
+		uint32_t offset = 0;
+		for (Cell& cell : mCells)
+		{
+			cell.First = offset;
+			offset += (cell.Count + 3) & ~3u;
+		}
+
+		// Padding lanes are empty rectangles, which overlap nothing.
+		mLefts.assign(offset, infinity);
+		mBottoms.assign(offset, infinity);
+		mRights.assign(offset, -infinity);
+		mTops.assign(offset, -infinity);
+		mIndices.assign(offset, 0);
+
+		for (Cell& cell : mCells)
+		{
+			cell.Count = 0;
+		}
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Cell& cell = mCells[mCellOfObject[i]];
+			const uint32_t slot = cell.First + cell.Count++;
+			mLefts[slot] = bounds[i].Left;
+			mBottoms[slot] = bounds[i].Bottom;
+			mRights[slot] = bounds[i].Right;
+			mTops[slot] = bounds[i].Top;
+			mIndices[slot] = i;
+		}
+	}
+
+	uint32_t ViewCuller::ObjectCount() const
+	{
+		return mObjectCount;
+	}
+
+	uint32_t ViewCuller::CellCount() const
+	{
+		return static_cast<uint32_t>(mCells.size());
+	}
+
+	void ViewCuller::Cull(const CullBounds& view, vector<uint32_t>& visible)
+	{
+		visible.clear();
+
+		Counters counters = {};
+		counters.Culls = 1;
+		counters.Objects = mObjectCount;
+
+		if (!mCells.empty() && view.Left <= view.Right && view.Bottom <= view.Top)
+		{
+			// Objects are filed by their bottom-left corner, so one filed up to the largest object's size left of or below
+			// the view can still reach into it.
+			const float firstColumn = (view.Left - mMaxWidth - mOriginX) * mInverseCellWidth;
+			const float lastColumn = (view.Right - mOriginX) * mInverseCellWidth;
+			const float firstRow = (view.Bottom - mMaxHeight - mOriginY) * mInverseCellHeight;
+			const float lastRow = (view.Top - mOriginY) * mInverseCellHeight;
+
+			if (lastColumn >= 0.0f && lastRow >= 0.0f && firstColumn < static_cast<float>(mColumns) && firstRow < static_cast<float>(mRows))
+			{
+				const uint32_t columnBegin = ClampCell(floor(firstColumn), mColumns);
+				const uint32_t columnEnd = ClampCell(lastColumn, mColumns) + 1;
+				const uint32_t rowBegin = ClampCell(floor(firstRow), mRows);
+				const uint32_t rowEnd = ClampCell(lastRow, mRows) + 1;
+				const View4 view4 = SplatView(view);
+
+				for (uint32_t row = rowBegin; row < rowEnd; ++row)
+				{
+					const Cell* cells = &mCells[static_cast<size_t>(row) * mColumns];
+					for (uint32_t column = columnBegin; column < columnEnd; ++column)
+					{
+						const Cell& cell = cells[column];
+						if (cell.Count == 0)
+						{
+							continue;
+						}
+
+						++counters.CellsTested;
+						if (!Overlaps(cell.Bounds, view))
+						{
+							continue;
+						}
+
+						const uint32_t* indices = &mIndices[cell.First];
+						if (Contains(view, cell.Bounds))
+						{
+							++counters.CellsInside;
+							visible.insert(visible.end(), indices, indices + cell.Count);
+							continue;
+						}
+
+						counters.ObjectsTested += cell.Count;
+						for (uint32_t i = 0; i < cell.Count; i += 4)
+						{
+							const uint32_t slot = cell.First + i;
+							uint32_t bits = OverlapBits(view4, &mLefts[slot], &mBottoms[slot], &mRights[slot], &mTops[slot]);
+							for (uint32_t lane = 0; bits != 0; ++lane, bits >>= 1)
+							{
+								if (bits & 1u)
+								{
+									visible.push_back(indices[i + lane]);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		counters.Visible = visible.size();
+		mLastCull = counters;
+		mTotals.Culls += counters.Culls;
+		mTotals.Objects += counters.Objects;
+		mTotals.Visible += counters.Visible;
+		mTotals.CellsTested += counters.CellsTested;
+		mTotals.CellsInside += counters.CellsInside;
+		mTotals.ObjectsTested += counters.ObjectsTested;
+	}
+
+	const ViewCuller::Counters& ViewCuller::Totals() const
+	{
+		return mTotals;
+	}
+
+	const ViewCuller::Counters& ViewCuller::LastCull() const
+	{
+		return mLastCull;
+	}
+
+	void ViewCuller::ResetCounters()
+	{
+		mTotals = Counters();
+		mLastCull = Counters();
+	}
+
+	void ViewCuller::WriteReport(ostream& stream) const
+	{
+		stream << "culls\t" << mTotals.Culls << '\n';
+		stream << "objects\t" << mTotals.Objects << '\n';
+		stream << "visible\t" << mTotals.Visible << '\n';
+		stream << "cells_tested\t" << mTotals.CellsTested << '\n';
+		stream << "cells_inside\t" << mTotals.CellsInside << '\n';
+		stream << "objects_tested\t" << mTotals.ObjectsTested << '\n';
+	}
+}
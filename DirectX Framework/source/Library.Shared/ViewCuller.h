@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace DX
+{
+	// A world-space axis-aligned rectangle in the xy plane. Right and Top are inclusive.
+	struct CullBounds
+	{
+		float Left;
+		float Bottom;
+		float Right;
+		float Top;
+	};
+
+	// Finds the objects whose bounds overlap a view rectangle. Build buckets the objects into a uniform grid by the
+	// bottom-left corner of their bounds; each cell keeps the union of its objects' bounds, and its objects' bounds in
+	// separate arrays of lefts, bottoms, rights and tops. Cull only visits the cells the view can reach: a cell outside the
+	// view is skipped, a cell inside it is accepted whole, and the objects of a cell on its edge are tested four at a time.
+	//
+	// Objects don't move once built; rebuild when they do. This file only depends on the C++ standard library.
+	class ViewCuller final
+	{
+	public:
+		struct Counters
+		{
+			std::uint64_t Culls;
+			std::uint64_t Objects;			// Built objects, summed over culls
+			std::uint64_t Visible;
+			std::uint64_t CellsTested;		// Non-empty cells the view could reach
+			std::uint64_t CellsInside;		// Of those, cells accepted without testing their objects
+			std::uint64_t ObjectsTested;	// Objects tested one by one, in cells on the view's edge
+		};
+
+		static const std::uint32_t DefaultObjectsPerCell = 64;
+
+		explicit ViewCuller(std::uint32_t objectsPerCell = DefaultObjectsPerCell);
+		ViewCuller(const ViewCuller&) = delete;
+		ViewCuller& operator=(const ViewCuller&) = delete;
+		ViewCuller(ViewCuller&&) = default;
+		ViewCuller& operator=(ViewCuller&&) = default;
+		~ViewCuller() = default;
+
+		// Replaces the objects; object i has bounds[i]. Cells are sized so that an average cell holds about objectsPerCell
+		// objects.
+		void Build(const CullBounds* bounds, std::uint32_t count);
+
+		std::uint32_t ObjectCount() const;
+		std::uint32_t CellCount() const;
+
+		// Replaces visible with the indices of the objects whose bounds overlap view, touching included. Indices come out
+		// cell by cell, not sorted.
+		void Cull(const CullBounds& view, std::vector<std::uint32_t>& visible);
+
+		const Counters& Totals() const;
+		const Counters& LastCull() const;
+		void ResetCounters();
+
+		void WriteReport(std::ostream& stream) const;
+
+	private:
+		struct Cell
+		{
+			CullBounds Bounds;				// Union of the cell's objects' bounds
+			std::uint32_t First;			// Into the per-object arrays, a multiple of four
+			std::uint32_t Count;
+		};
+
+		std::uint32_t mObjectsPerCell;
+		std::uint32_t mObjectCount;
+
+		// The grid covers the objects' bottom-left corners. An object reaches at most mMaxWidth right and mMaxHeight up.
+		float mOriginX;
+		float mOriginY;
+		float mInverseCellWidth;
+		float mInverseCellHeight;
+		float mMaxWidth;
+		float mMaxHeight;
+		std::uint32_t mColumns;
+		std::uint32_t mRows;
+		std::vector<Cell> mCells;
+
+		// Sorted by cell. Each cell's run is padded to a multiple of four with bounds that overlap nothing.
+		std::vector<float> mLefts;
+		std::vector<float> mBottoms;
+		std::vector<float> mRights;
+		std::vector<float> mTops;
+		std::vector<std::uint32_t> mIndices;
+
+		std::vector<std::uint32_t> mCellOfObject;	// Build's scratch
+
+		Counters mTotals;
+		Counters mLastCull;
+	};
+}
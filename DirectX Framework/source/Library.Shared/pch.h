@@ -33,6 +33,22 @@
 #include "Transform2D.h"
 #include "VertexDeclarations.h"
 #include "DirectXHelper.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "RenderCommandList.h"
+#include "RenderBackend.h"
+#include "ConstantBufferRing.h"
+#include "DrawSorter.h"
+#include "ViewCuller.h"
+#include "CachedLayer.h"
+#include "ShapeMeshes.h"
+#include "D3D11RenderBackend.h"
+#include "SpriteBatch.h"
+#include "D3D11SpriteBatchTarget.h"
+#include "PipelineCache.h"
+#include "FrameTimeHistogram.h"
+#include "FrameStatistics.h"
 #include "Camera.h"
 #include "OrthographicCamera.h"
 #include "KeyboardComponent.h"
@@ -0,0 +1,317 @@
+// Measures what the AssetLoader's decoded-texture cache saves at startup. A cold launch starts from an empty cache: every
+// PNG is read, decoded with libpng and written to the cache. Warm launches use a fresh loader over the same cache, the way
+// the next run of the game would, and should map the cached pixels without decoding anything. The pixels from both are
+// compared, a decoder's mip chain is checked to come back whole from the cache, and a single-threaded loader checks that
+// requests for a file already in flight share one read.
+//
+// Generates its test images (plus the game's sprite sheet, when run from this directory) under the data directory.
+// Needs libpng and POSIX file APIs, e.g. from this directory on Linux:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared AssetLoaderBenchmark.cpp ../../Library.Shared/AssetLoader.cpp -lpng
+//
+// Usage: AssetLoaderBenchmark [data directory] [image count] [image size]
+// Defaults to ./AssetLoaderBenchmarkData, 8 images of 1024x1024.
+
+#include "AssetLoader.h"
+#include <png.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	const uint32_t DecoderVersion = 1;
+	const uint32_t WarmLaunches = 5;
+	const uint32_t FormatR8G8B8A8UNorm = 28;	// DXGI_FORMAT_R8G8B8A8_UNORM
+	const uint32_t MipChainLevels = 4;
+	const char* const SpriteSheetPath = "../../Game.Universal/Content/Textures/snoods_default.png";
+
+	struct Launch
+	{
+		double Milliseconds;
+		AssetLoader::Counters Totals;
+		vector<uint64_t> PixelHashes;
+		uint32_t TexturesFromCache;
+	};
+
+	bool DecodePng(const uint8_t* data, size_t size, AssetLoader::DecodedImage& image)
+	{
+		png_image png;
+		memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+		if (!png_image_begin_read_from_memory(&png, data, size))
+		{
+			return false;
+		}
+
+		png.format = PNG_FORMAT_RGBA;
+		image.Width = png.width;
+		image.Height = png.height;
+		image.RowPitch = png.width * 4;
+		image.Format = FormatR8G8B8A8UNorm;
+		image.Pixels.resize(PNG_IMAGE_SIZE(png));
+
+		if (!png_image_finish_read(&png, nullptr, image.Pixels.data(), 0, nullptr))
+		{
+			png_image_free(&png);
+			return false;
+		}
+
+		return true;
+	}
+
+	// DecodePng plus a box-filtered mip chain, packed after the first level the way the game's DDS decoder packs its levels.
+	bool DecodePngWithMips(const uint8_t* data, size_t size, AssetLoader::DecodedImage& image)
+	{
+		if (!DecodePng(data, size, image))
+		{
+			return false;
+		}
+
+		image.MipCount = 1;
+		size_t source = 0;
+		uint32_t width = image.Width;
+		uint32_t height = image.Height;
+		while (width > 1 && height > 1 && image.MipCount < MipChainLevels)
+		{
+			const uint32_t mipWidth = width / 2;
+			const uint32_t mipHeight = height / 2;
+			const size_t destination = image.Pixels.size();
+			image.Pixels.resize(destination + static_cast<size_t>(mipWidth) * mipHeight * 4);
+			for (uint32_t y = 0; y < mipHeight; ++y)
+			{
+				for (uint32_t x = 0; x < mipWidth * 4; ++x)
+				{
+					const size_t top = source + static_cast<size_t>(y * 2) * width * 4 + (x / 4) * 8 + x % 4;
+					const uint32_t sum = image.Pixels[top] + image.Pixels[top + 4] + image.Pixels[top + width * 4] + image.Pixels[top + width * 4 + 4];
+					image.Pixels[destination + static_cast<size_t>(y) * mipWidth * 4 + x] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+
+			source = destination;
+			width = mipWidth;
+			height = mipHeight;
+			++image.MipCount;
+		}
+
+		return true;
+	}
+
+	// Smooth gradients with some noise, so the images compress about as well as real art.
+	bool WriteTestImage(const string& path, uint32_t size, uint32_t seed)
+	{
+		vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+		uint32_t random = seed * 2654435761U + 1;
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				random = random * 1664525U + 1013904223U;
+				const uint8_t noise = static_cast<uint8_t>((random >> 24) & 0x0F);
+				uint8_t* pixel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+				pixel[0] = static_cast<uint8_t>(((x * 255) / size + seed * 31 + noise) & 0xFF);
+				pixel[1] = static_cast<uint8_t>(((y * 255) / size + noise) & 0xFF);
+				pixel[2] = static_cast<uint8_t>((((x + y) * 127) / size + seed * 17) & 0xFF);
+				pixel[3] = 255;
+			}
+		}
+
+		png_image png;
+		memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+		png.width = size;
+		png.height = size;
+		png.format = PNG_FORMAT_RGBA;
+		return (png_image_write_to_file(&png, path.c_str(), 0, pixels.data(), 0, nullptr) != 0);
+	}
+
+	void ClearDirectory(const string& path)
+	{
+		DIR* directory = opendir(path.c_str());
+		if (directory == nullptr)
+		{
+			return;
+		}
+
+		while (dirent* entry = readdir(directory))
+		{
+			if (entry->d_name[0] != '.')
+			{
+				unlink((path + "/" + entry->d_name).c_str());
+			}
+		}
+
+		closedir(directory);
+	}
+
+	Launch RunLaunch(const string& cacheDirectory, const vector<string>& images)
+	{
+		Launch launch = {};
+		const auto start = chrono::high_resolution_clock::now();
+
+		{
+			AssetLoader loader(cacheDirectory);
+			vector<shared_future<AssetLoader::TexturePointer>> loads;
+			for (const string& image : images)
+			{
+				loads.push_back(loader.LoadTextureAsync(image, DecoderVersion, DecodePng));
+			}
+
+			for (auto& load : loads)
+			{
+				const AssetLoader::TexturePointer texture = load.get();
+				launch.PixelHashes.push_back(AssetLoader::HashContent(texture->Pixels->Data(), texture->Pixels->Size()));
+				launch.TexturesFromCache += (texture->FromCache ? 1 : 0);
+			}
+
+			launch.Totals = loader.Totals();
+		}
+
+		launch.Milliseconds = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+		return launch;
+	}
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const string dataDirectory = (argc > 1 ? argv[1] : "AssetLoaderBenchmarkData");
+	const uint32_t imageCount = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 8);
+	const uint32_t imageSize = (argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 1024);
+	const string cacheDirectory = dataDirectory + "/cache";
+
+	mkdir(dataDirectory.c_str(), 0755);
+
+	vector<string> images;
+	uint64_t sourceBytes = 0;
+	for (uint32_t i = 0; i < imageCount; ++i)
+	{
+		const string path = dataDirectory + "/image" + to_string(i) + ".png";
+		struct stat status;
+		if (stat(path.c_str(), &status) != 0 && !WriteTestImage(path, imageSize, i))
+		{
+			printf("Can't write %s\n", path.c_str());
+			return 1;
+		}
+
+		images.push_back(path);
+	}
+
+	if (access(SpriteSheetPath, R_OK) == 0)
+	{
+		images.push_back(SpriteSheetPath);
+	}
+
+	for (const string& image : images)
+	{
+		struct stat status;
+		stat(image.c_str(), &status);
+		sourceBytes += static_cast<uint64_t>(status.st_size);
+	}
+
+	const uint32_t textureCount = static_cast<uint32_t>(images.size());
+	printf("%u textures, %.1f MB of PNG, cache in %s\n\n", textureCount, static_cast<double>(sourceBytes) / (1024.0 * 1024.0), cacheDirectory.c_str());
+
+	ClearDirectory(cacheDirectory);
+	const Launch cold = RunLaunch(cacheDirectory, images);
+
+	vector<Launch> warm;
+	for (uint32_t i = 0; i < WarmLaunches; ++i)
+	{
+		warm.push_back(RunLaunch(cacheDirectory, images));
+	}
+
+	vector<double> warmTimes;
+	for (const Launch& launch : warm)
+	{
+		warmTimes.push_back(launch.Milliseconds);
+	}
+
+	sort(warmTimes.begin(), warmTimes.end());
+	const double warmMedian = warmTimes[warmTimes.size() / 2];
+
+	printf("launch    ms        decodes  cache hits  cache writes  file reads  mapped  MB read\n");
+	printf("cold      %-9.2f %-8llu %-11llu %-13llu %-11llu %-7llu %.1f\n", cold.Milliseconds,
+		static_cast<unsigned long long>(cold.Totals.Decodes), static_cast<unsigned long long>(cold.Totals.CacheHits),
+		static_cast<unsigned long long>(cold.Totals.CacheWrites), static_cast<unsigned long long>(cold.Totals.FileReads),
+		static_cast<unsigned long long>(cold.Totals.MappedFiles), static_cast<double>(cold.Totals.BytesRead) / (1024.0 * 1024.0));
+	printf("warm p50  %-9.2f %-8llu %-11llu %-13llu %-11llu %-7llu %.1f\n", warmMedian,
+		static_cast<unsigned long long>(warm[0].Totals.Decodes), static_cast<unsigned long long>(warm[0].Totals.CacheHits),
+		static_cast<unsigned long long>(warm[0].Totals.CacheWrites), static_cast<unsigned long long>(warm[0].Totals.FileReads),
+		static_cast<unsigned long long>(warm[0].Totals.MappedFiles), static_cast<double>(warm[0].Totals.BytesRead) / (1024.0 * 1024.0));
+	printf("\nwarm launches are %.1fx faster than cold\n", cold.Milliseconds / warmMedian);
+
+	bool passed = true;
+	passed &= Check(cold.Totals.Decodes == textureCount && cold.TexturesFromCache == 0, "cold launch decodes every texture");
+	passed &= Check(cold.Totals.CacheWrites == textureCount, "cold launch writes every texture to the cache");
+	for (const Launch& launch : warm)
+	{
+		passed &= Check(launch.Totals.Decodes == 0 && launch.TexturesFromCache == textureCount, "warm launch decodes nothing");
+		passed &= Check(launch.PixelHashes == cold.PixelHashes, "cached pixels match decoded pixels");
+	}
+
+	// A decoder's mip chain survives the cache whole: the warm load maps every level, not just the first.
+	{
+		const string mipCacheDirectory = dataDirectory + "/mipcache";
+		mkdir(mipCacheDirectory.c_str(), 0755);
+		ClearDirectory(mipCacheDirectory);
+
+		AssetLoader::TexturePointer decoded;
+		AssetLoader::TexturePointer cached;
+		{
+			AssetLoader loader(mipCacheDirectory);
+			decoded = loader.LoadTextureAsync(images[0], DecoderVersion, DecodePngWithMips).get();
+		}
+		{
+			AssetLoader loader(mipCacheDirectory);
+			cached = loader.LoadTextureAsync(images[0], DecoderVersion, DecodePngWithMips).get();
+		}
+
+		const size_t firstLevelBytes = static_cast<size_t>(decoded->RowPitch) * decoded->Height;
+		passed &= Check(decoded->MipCount == MipChainLevels && !decoded->FromCache && decoded->Pixels->Size() > firstLevelBytes, "a decoded mip chain keeps every level");
+		passed &= Check(cached->FromCache && cached->MipCount == decoded->MipCount && cached->Pixels->Size() == decoded->Pixels->Size() &&
+			memcmp(cached->Pixels->Data(), decoded->Pixels->Data(), decoded->Pixels->Size()) == 0, "a cached mip chain matches the decoded one");
+	}
+
+	// One worker busy with a texture: every request queued behind it for the same file must share a single read.
+	{
+		AssetLoader loader(string(), 1);
+		auto texture = loader.LoadTextureAsync(images[0], DecoderVersion, DecodePng);
+		vector<shared_future<AssetLoader::AssetPointer>> reads;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			reads.push_back(loader.LoadAsync(images[0]));
+		}
+
+		texture.wait();
+		bool sameData = true;
+		for (auto& read : reads)
+		{
+			sameData &= (read.get() == reads[0].get());
+		}
+
+		const AssetLoader::Counters totals = loader.Totals();
+		passed &= Check(sameData && totals.SharedRequests == 15 && totals.FileReads == 2, "in-flight requests share one read");
+	}
+
+	printf("%s\n", passed ? "All checks passed." : "Checks FAILED.");
+	return (passed ? 0 : 1);
+}
@@ -0,0 +1,512 @@
+// Packs PNG images into power-of-two texture atlas pages and writes the UV table the game loads them by. Each image is
+// placed with AtlasPacker's MaxRects packer, copied into its page and extruded into its padding, so linear filtering at
+// an image's edge repeats the edge instead of bleeding in a neighbor. The pages are written as <output>.png (or
+// <output>_<n>.png when there are several) and the table as <output>.atlas, which TextureAtlas reads in place.
+//
+// With --grid, each input is a sheet cut into a grid of equal cells, named <sheet>_<column>_<row>; otherwise each image
+// is named after its file, without the extension. The game's snoods atlas is built from its 8 x 4 sprite sheet with:
+//   AtlasBuilder --grid 8x4 ../../Game.Universal/Content/Textures/snoods_atlas ../../Game.Universal/Content/Textures/snoods_default.png
+//
+// With --benchmark, packs sets of random images instead, and reports pack time and occupancy. The checks:
+//   - every image lies inside a power-of-two page, and no two images' padded rectangles overlap;
+//   - extrusion leaves the image intact and fills its padding with the nearest edge pixels;
+//   - the table round-trips through the AssetLoader and TextureAtlas, finds every image and no others.
+//
+// Needs libpng, e.g. from this directory on Linux:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared AtlasBuilder.cpp ../../Library.Shared/AtlasPacker.cpp ../../Library.Shared/TextureAtlas.cpp ../../Library.Shared/AssetLoader.cpp -lpng
+//
+// Usage: AtlasBuilder [--padding N] [--max-size N] [--grid CxR] output input.png...
+//        AtlasBuilder --benchmark [data directory]
+// Defaults to 2 pixels of padding and 4096 x 4096 pages.
+
+#include "AtlasPacker.h"
+#include "TextureAtlas.h"
+#include <png.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	struct Image
+	{
+		string Name;
+		uint32_t Width;
+		uint32_t Height;
+		vector<uint8_t> Pixels;		// R8G8B8A8, tightly packed
+	};
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool ReadPng(const string& path, uint32_t& width, uint32_t& height, vector<uint8_t>& pixels)
+	{
+		png_image png;
+		memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+		if (!png_image_begin_read_from_file(&png, path.c_str()))
+		{
+			return false;
+		}
+
+		png.format = PNG_FORMAT_RGBA;
+		width = png.width;
+		height = png.height;
+		pixels.resize(PNG_IMAGE_SIZE(png));
+		if (!png_image_finish_read(&png, nullptr, pixels.data(), 0, nullptr))
+		{
+			png_image_free(&png);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool WritePng(const string& path, uint32_t width, uint32_t height, const vector<uint8_t>& pixels)
+	{
+		png_image png;
+		memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+		png.width = width;
+		png.height = height;
+		png.format = PNG_FORMAT_RGBA;
+		return (png_image_write_to_file(&png, path.c_str(), 0, pixels.data(), 0, nullptr) != 0);
+	}
+
+	bool WriteFile(const string& path, const vector<uint8_t>& data)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const bool written = (fwrite(data.data(), 1, data.size(), file) == data.size());
+		return (fclose(file) == 0 && written);
+	}
+
+	string FileName(const string& path)
+	{
+		const size_t slash = path.find_last_of("/\\");
+		return (slash == string::npos ? path : path.substr(slash + 1));
+	}
+
+	string Stem(const string& path)
+	{
+		const string name = FileName(path);
+		const size_t dot = name.find_last_of('.');
+		return (dot == string::npos ? name : name.substr(0, dot));
+	}
+
+	string PagePath(const string& output, uint32_t page, uint32_t pageCount)
+	{
+		return output + (pageCount == 1 ? string() : "_" + to_string(page)) + ".png";
+	}
+
+	// Cuts a sheet into columns x rows images, named <sheet>_<column>_<row>.
+	bool CutSheet(const string& path, uint32_t columns, uint32_t rows, vector<Image>& images)
+	{
+		uint32_t width;
+		uint32_t height;
+		vector<uint8_t> pixels;
+		if (!ReadPng(path, width, height, pixels) || width % columns != 0 || height % rows != 0)
+		{
+			return false;
+		}
+
+		const uint32_t cellWidth = width / columns;
+		const uint32_t cellHeight = height / rows;
+		for (uint32_t row = 0; row < rows; ++row)
+		{
+			for (uint32_t column = 0; column < columns; ++column)
+			{
+				Image image = { Stem(path) + "_" + to_string(column) + "_" + to_string(row), cellWidth, cellHeight, {} };
+				image.Pixels.resize(static_cast<size_t>(cellWidth) * cellHeight * 4);
+				for (uint32_t y = 0; y < cellHeight; ++y)
+				{
+					memcpy(&image.Pixels[static_cast<size_t>(y) * cellWidth * 4], &pixels[(static_cast<size_t>(row * cellHeight + y) * width + column * cellWidth) * 4],
+						static_cast<size_t>(cellWidth) * 4);
+				}
+
+				images.push_back(move(image));
+			}
+		}
+
+		return true;
+	}
+
+	// Copies the images into their pages and describes the pages and placements for the table.
+	void ComposePages(const AtlasPacker& packer, const vector<Image>& images, uint32_t padding, const string& output,
+		vector<vector<uint8_t>>& pages, vector<TextureAtlas::PageDesc>& pageDescs, vector<TextureAtlas::EntryDesc>& entryDescs)
+	{
+		const uint32_t pageCount = static_cast<uint32_t>(packer.Pages().size());
+		pages.clear();
+		pageDescs.clear();
+		for (uint32_t i = 0; i < pageCount; ++i)
+		{
+			const AtlasPacker::Size& size = packer.Pages()[i];
+			pages.emplace_back(static_cast<size_t>(size.Width) * size.Height * 4, static_cast<uint8_t>(0));
+			pageDescs.push_back(TextureAtlas::PageDesc{ FileName(PagePath(output, i, pageCount)), size.Width, size.Height });
+		}
+
+		entryDescs.clear();
+		for (size_t i = 0; i < images.size(); ++i)
+		{
+			const Image& image = images[i];
+			const AtlasPacker::Placement& placement = packer.Placements()[i];
+			const uint32_t pageWidth = packer.Pages()[placement.Page].Width;
+			AtlasPacker::CopyWithExtrusion(image.Pixels.data(), image.Width, image.Height, image.Width * 4, pages[placement.Page].data(), pageWidth * 4,
+				placement.X, placement.Y, padding);
+			entryDescs.push_back(TextureAtlas::EntryDesc{ image.Name, placement.Page, placement.X, placement.Y, image.Width, image.Height });
+		}
+	}
+
+	int Build(const string& output, const vector<string>& inputs, uint32_t columns, uint32_t rows, uint32_t padding, uint32_t maxPageSize)
+	{
+		vector<Image> images;
+		for (const string& input : inputs)
+		{
+			if (columns > 0)
+			{
+				if (!CutSheet(input, columns, rows, images))
+				{
+					printf("Can't read %s, or it doesn't divide into %u x %u cells\n", input.c_str(), columns, rows);
+					return 1;
+				}
+			}
+			else
+			{
+				Image image = { Stem(input), 0, 0, {} };
+				if (!ReadPng(input, image.Width, image.Height, image.Pixels))
+				{
+					printf("Can't read %s\n", input.c_str());
+					return 1;
+				}
+
+				images.push_back(move(image));
+			}
+		}
+
+		vector<AtlasPacker::Size> sizes;
+		for (const Image& image : images)
+		{
+			sizes.push_back(AtlasPacker::Size{ image.Width, image.Height });
+		}
+
+		AtlasPacker packer(maxPageSize, padding);
+		const auto start = chrono::steady_clock::now();
+		if (!packer.Pack(sizes.data(), static_cast<uint32_t>(sizes.size())))
+		{
+			printf("An image is larger than a %u x %u page\n", maxPageSize, maxPageSize);
+			return 1;
+		}
+
+		const double packMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+		vector<vector<uint8_t>> pages;
+		vector<TextureAtlas::PageDesc> pageDescs;
+		vector<TextureAtlas::EntryDesc> entryDescs;
+		ComposePages(packer, images, padding, output, pages, pageDescs, entryDescs);
+
+		try
+		{
+			const vector<uint8_t> table = TextureAtlas::Serialize(pageDescs, entryDescs);
+			for (uint32_t i = 0; i < pages.size(); ++i)
+			{
+				const string pagePath = PagePath(output, i, static_cast<uint32_t>(pages.size()));
+				if (!WritePng(pagePath, pageDescs[i].Width, pageDescs[i].Height, pages[i]))
+				{
+					printf("Can't write %s\n", pagePath.c_str());
+					return 1;
+				}
+
+				printf("%s: %u x %u\n", pagePath.c_str(), pageDescs[i].Width, pageDescs[i].Height);
+			}
+
+			if (!WriteFile(output + ".atlas", table))
+			{
+				printf("Can't write %s.atlas\n", output.c_str());
+				return 1;
+			}
+		}
+		catch (const runtime_error& error)
+		{
+			printf("%s\n", error.what());
+			return 1;
+		}
+
+		printf("%s.atlas: %zu images on %zu pages, %.1f%% occupied, packed in %.2f ms\n", output.c_str(), images.size(), pages.size(),
+			packer.Occupancy() * 100.0, packMilliseconds);
+		return 0;
+	}
+
+	// Every image within a power-of-two page, padding included, and no padded rectangles overlapping.
+	bool PlacementsValid(const AtlasPacker& packer, const vector<AtlasPacker::Size>& sizes, uint32_t padding, uint32_t maxPageSize)
+	{
+		vector<vector<uint8_t>> coverage;
+		for (const AtlasPacker::Size& page : packer.Pages())
+		{
+			if (page.Width > maxPageSize || page.Height > maxPageSize || (page.Width & (page.Width - 1)) != 0 || (page.Height & (page.Height - 1)) != 0)
+			{
+				return false;
+			}
+
+			coverage.emplace_back(static_cast<size_t>(page.Width) * page.Height, static_cast<uint8_t>(0));
+		}
+
+		for (size_t i = 0; i < sizes.size(); ++i)
+		{
+			const AtlasPacker::Placement& placement = packer.Placements()[i];
+			if (placement.Page >= packer.Pages().size() || placement.X < padding || placement.Y < padding)
+			{
+				return false;
+			}
+
+			const AtlasPacker::Size& page = packer.Pages()[placement.Page];
+			const uint32_t right = placement.X + sizes[i].Width + padding;
+			const uint32_t bottom = placement.Y + sizes[i].Height + padding;
+			if (right > page.Width || bottom > page.Height)
+			{
+				return false;
+			}
+
+			for (uint32_t y = placement.Y - padding; y < bottom; ++y)
+			{
+				for (uint32_t x = placement.X - padding; x < right; ++x)
+				{
+					uint8_t& covered = coverage[placement.Page][static_cast<size_t>(y) * page.Width + x];
+					if (covered != 0)
+					{
+						return false;
+					}
+
+					covered = 1;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool ExtrusionValid()
+	{
+		const uint32_t width = 5;
+		const uint32_t height = 3;
+		const uint32_t padding = 2;
+		vector<uint8_t> image(width * height * 4);
+		for (size_t i = 0; i < image.size(); ++i)
+		{
+			image[i] = static_cast<uint8_t>(i * 7 + 1);
+		}
+
+		const uint32_t pageSize = 16;
+		vector<uint8_t> page(pageSize * pageSize * 4, 0);
+		AtlasPacker::CopyWithExtrusion(image.data(), width, height, width * 4, page.data(), pageSize * 4, 4, 6, padding);
+
+		bool valid = true;
+		for (uint32_t y = 0; y < pageSize; ++y)
+		{
+			for (uint32_t x = 0; x < pageSize; ++x)
+			{
+				const uint8_t* pixel = &page[(y * pageSize + x) * 4];
+				const bool inside = (x + padding >= 4 && x < 4 + width + padding && y + padding >= 6 && y < 6 + height + padding);
+				if (inside)
+				{
+					const uint32_t sourceX = min(max(x, 4u), 4u + width - 1) - 4;
+					const uint32_t sourceY = min(max(y, 6u), 6u + height - 1) - 6;
+					valid &= (memcmp(pixel, &image[(sourceY * width + sourceX) * 4], 4) == 0);
+				}
+				else
+				{
+					valid &= (pixel[0] == 0 && pixel[1] == 0 && pixel[2] == 0 && pixel[3] == 0);
+				}
+			}
+		}
+
+		return valid;
+	}
+
+	int Benchmark(const string& dataDirectory)
+	{
+		const uint32_t padding = AtlasPacker::DefaultPadding;
+		const uint32_t maxPageSize = AtlasPacker::DefaultMaxPageSize;
+		bool passed = Check(ExtrusionValid(), "extrusion copies the image and repeats its edges into the padding");
+
+		mkdir(dataDirectory.c_str(), 0755);
+		AssetLoader loader(string(), 1);
+
+		// Sprite-like sets: mostly small, roughly square images with some larger and some long thin ones.
+		const uint32_t imageCounts[4] = { 32, 256, 2048, 8192 };
+		printf("%8s %10s %8s %12s %14s %14s\n", "images", "pack ms", "pages", "occupancy", "table bytes", "lookup ns");
+		for (const uint32_t imageCount : imageCounts)
+		{
+			mt19937 random(imageCount);
+			uniform_int_distribution<uint32_t> smallSide(8, 64);
+			uniform_int_distribution<uint32_t> largeSide(64, 256);
+			uniform_int_distribution<uint32_t> kind(0, 9);
+			vector<AtlasPacker::Size> sizes;
+			vector<Image> images;
+			for (uint32_t i = 0; i < imageCount; ++i)
+			{
+				const uint32_t imageKind = kind(random);
+				AtlasPacker::Size size = { smallSide(random), smallSide(random) };
+				if (imageKind == 0)
+				{
+					size = AtlasPacker::Size{ largeSide(random), largeSide(random) };
+				}
+				else if (imageKind == 1)
+				{
+					size = AtlasPacker::Size{ largeSide(random), smallSide(random) / 4 + 1 };
+				}
+
+				sizes.push_back(size);
+				images.push_back(Image{ "image_" + to_string(i), size.Width, size.Height, vector<uint8_t>(static_cast<size_t>(size.Width) * size.Height * 4, 0xFF) });
+			}
+
+			AtlasPacker packer(maxPageSize, padding);
+			const uint32_t runs = 5;
+			const auto start = chrono::steady_clock::now();
+			for (uint32_t run = 0; run < runs; ++run)
+			{
+				passed &= Check(packer.Pack(sizes.data(), imageCount), "every image fits on a page");
+			}
+
+			const double packMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / runs;
+			passed &= Check(PlacementsValid(packer, sizes, padding, maxPageSize), "placements are on power-of-two pages and don't overlap");
+
+			// Round-trip the table through a file, the way the game loads it; large tables are mapped.
+			vector<vector<uint8_t>> pages;
+			vector<TextureAtlas::PageDesc> pageDescs;
+			vector<TextureAtlas::EntryDesc> entryDescs;
+			const string output = dataDirectory + "/atlas" + to_string(imageCount);
+			ComposePages(packer, images, padding, output, pages, pageDescs, entryDescs);
+			const vector<uint8_t> table = TextureAtlas::Serialize(pageDescs, entryDescs);
+			passed &= Check(WriteFile(output + ".atlas", table), "the table is written");
+			const TextureAtlas atlas(loader.LoadAsync(output + ".atlas").get());
+
+			bool found = (atlas.EntryCount() == imageCount && atlas.PageCount() == packer.Pages().size());
+			for (uint32_t i = 0; i < imageCount && found; ++i)
+			{
+				const TextureAtlas::Entry* entry = atlas.Find(images[i].Name);
+				const AtlasPacker::Placement& placement = packer.Placements()[i];
+				const TextureAtlas::Page& page = atlas.GetPage(placement.Page);
+				found = (entry != nullptr && entry->Page == placement.Page && entry->X == placement.X && entry->Y == placement.Y &&
+					entry->Width == images[i].Width && entry->Height == images[i].Height && strcmp(atlas.Name(entry->NameOffset), images[i].Name.c_str()) == 0 &&
+					entry->U0 == static_cast<float>(placement.X) / static_cast<float>(page.Width) &&
+					entry->V1 == static_cast<float>(placement.Y + images[i].Height) / static_cast<float>(page.Height));
+			}
+
+			passed &= Check(found, "the table finds every image where it was placed");
+			passed &= Check(atlas.Find("image_") == nullptr && atlas.Find("image_" + to_string(imageCount)) == nullptr, "the table doesn't find images it doesn't have");
+
+			const uint32_t lookups = 1000000;
+			uintptr_t sink = 0;
+			const auto lookupStart = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < lookups; ++i)
+			{
+				sink += reinterpret_cast<uintptr_t>(atlas.Find(images[i % imageCount].Name));
+			}
+
+			const double lookupNanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - lookupStart).count() / lookups;
+			passed &= Check(sink != 0, "lookups");
+
+			printf("%8u %10.2f %8zu %11.1f%% %14zu %14.1f\n", imageCount, packMilliseconds, packer.Pages().size(), packer.Occupancy() * 100.0,
+				table.size(), lookupNanoseconds);
+		}
+
+		{
+			vector<TextureAtlas::PageDesc> pageDescs = { TextureAtlas::PageDesc{ "page.png", 64, 64 } };
+			vector<TextureAtlas::EntryDesc> entryDescs = { TextureAtlas::EntryDesc{ "a", 0, 0, 0, 8, 8 }, TextureAtlas::EntryDesc{ "a", 0, 8, 0, 8, 8 } };
+			bool threw = false;
+			try
+			{
+				TextureAtlas::Serialize(pageDescs, entryDescs);
+			}
+			catch (const runtime_error&)
+			{
+				threw = true;
+			}
+
+			passed &= Check(threw, "duplicate names are refused");
+
+			entryDescs.pop_back();
+			entryDescs[0].X = 60;
+			threw = false;
+			try
+			{
+				TextureAtlas::Serialize(pageDescs, entryDescs);
+			}
+			catch (const runtime_error&)
+			{
+				threw = true;
+			}
+
+			passed &= Check(threw, "images off their page are refused");
+
+			AtlasPacker packer(64, padding);
+			const AtlasPacker::Size tooLarge = { 62, 8 };
+			passed &= Check(!packer.Pack(&tooLarge, 1), "an image larger than a page is refused");
+		}
+
+		printf("%s\n", (passed ? "checks passed" : "checks FAILED"));
+		return (passed ? 0 : 1);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+	{
+		return Benchmark(argc > 2 ? argv[2] : "AtlasBuilderData");
+	}
+
+	uint32_t padding = AtlasPacker::DefaultPadding;
+	uint32_t maxPageSize = AtlasPacker::DefaultMaxPageSize;
+	uint32_t columns = 0;
+	uint32_t rows = 0;
+	int argument = 1;
+	for (; argument + 1 < argc && strncmp(argv[argument], "--", 2) == 0; argument += 2)
+	{
+		if (strcmp(argv[argument], "--padding") == 0)
+		{
+			padding = static_cast<uint32_t>(strtoul(argv[argument + 1], nullptr, 10));
+		}
+		else if (strcmp(argv[argument], "--max-size") == 0)
+		{
+			maxPageSize = static_cast<uint32_t>(strtoul(argv[argument + 1], nullptr, 10));
+		}
+		else if (strcmp(argv[argument], "--grid") == 0 && sscanf(argv[argument + 1], "%ux%u", &columns, &rows) == 2 && columns > 0 && rows > 0)
+		{
+		}
+		else
+		{
+			printf("Unknown option %s %s\n", argv[argument], argv[argument + 1]);
+			return 1;
+		}
+	}
+
+	if (argc - argument < 2)
+	{
+		printf("Usage: AtlasBuilder [--padding N] [--max-size N] [--grid CxR] output input.png...\n       AtlasBuilder --benchmark [data directory]\n");
+		return 1;
+	}
+
+	return Build(argv[argument], vector<string>(argv + argument + 1, argv + argc), columns, rows, padding, maxPageSize);
+}
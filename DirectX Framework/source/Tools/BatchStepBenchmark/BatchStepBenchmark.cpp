@@ -0,0 +1,190 @@
+// Measures BatchEnvironment throughput in environment steps per second, after checking its four-wide step against
+// stepping each environment one at a time through GameRules. The checks, over a random policy on an environment count
+// that is not a multiple of four, split over two threads:
+//   - every environment that carries on is where GameRules::StepBar, StepBall and StepChunks put it, bit for bit;
+//   - its chunks are the ones StepChunks left standing, and its reward is what the step earned;
+//   - every environment that finishes lost the ball, cleared the wall or reached MaxEpisodeSteps.
+// Builds with DX_BATCH_ENVIRONMENT_SCALAR defined check the one-at-a-time path against itself.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -pthread -I../../Game.Universal BatchStepBenchmark.cpp ../../Game.Universal/BatchEnvironment.cpp ../../Game.Universal/GameRules.cpp
+//   cl /O2 /EHsc /I..\..\Game.Universal BatchStepBenchmark.cpp ..\..\Game.Universal\BatchEnvironment.cpp ..\..\Game.Universal\GameRules.cpp
+//
+// Usage: BatchStepBenchmark [environments] [threads] [steps] [random|chase]
+// Returns non-zero if a check fails.
+
+#include "BatchEnvironment.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace DirectXGame;
+
+namespace
+{
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	uint8_t RandomAction(uint32_t& randomState)
+	{
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		return static_cast<uint8_t>(randomState % 3);
+	}
+
+	bool CheckAgainstGameRules()
+	{
+		const uint32_t environmentCount = 1027;
+		const uint32_t stepCount = 3000;
+
+		BatchEnvironment environments(environmentCount, 2);
+
+		vector<float> observations(static_cast<size_t>(environmentCount) * BatchEnvironment::ObservationSize);
+		vector<float> previousObservations(observations.size());
+		vector<uint64_t> previousChunkMasks(environmentCount);
+		vector<float> rewards(environmentCount);
+		vector<uint8_t> done(environmentCount);
+		vector<uint8_t> actions(environmentCount);
+		uint32_t randomState = 0x2545F491U;
+
+		environments.Reset(observations.data());
+
+		uint64_t mismatchedStates = 0;
+		uint64_t mismatchedChunks = 0;
+		uint64_t mismatchedRewards = 0;
+		uint64_t unexplainedEnds = 0;
+		uint64_t episodes = 0;
+		for (uint32_t step = 0; step < stepCount; ++step)
+		{
+			for (uint32_t i = 0; i < environmentCount; ++i)
+			{
+				actions[i] = RandomAction(randomState);
+			}
+
+			previousObservations = observations;
+			const uint64_t* chunkMasks = environments.ChunkMasks();
+			previousChunkMasks.assign(chunkMasks, chunkMasks + environmentCount);
+
+			environments.Step(actions.data(), observations.data(), rewards.data(), done.data());
+
+			for (uint32_t i = 0; i < environmentCount; ++i)
+			{
+				const float* before = &previousObservations[static_cast<size_t>(i) * BatchEnvironment::ObservationSize];
+				const float* after = &observations[static_cast<size_t>(i) * BatchEnvironment::ObservationSize];
+
+				GameRules::PlayState state = { before[BatchEnvironment::BallX], before[BatchEnvironment::BallY], before[BatchEnvironment::BallVelocityX],
+					before[BatchEnvironment::BallVelocityY], before[BatchEnvironment::BarX], before[BatchEnvironment::BarVelocityX] };
+				uint64_t chunkMask = previousChunkMasks[i];
+
+				GameRules::StepBar(state, static_cast<GameRules::AutopilotCommand>(actions[i]));
+				const GameRules::BallStepResult result = GameRules::StepBall(state);
+				const bool broke = (result.InChunkZone && GameRules::StepChunks(state, chunkMask) != GameRules::NoChunk);
+
+				const float reward = (broke ? 1.0f : 0.0f) - (result.Lost ? 1.0f : 0.0f);
+				mismatchedRewards += (rewards[i] != reward ? 1 : 0);
+
+				if (done[i] != 0)
+				{
+					const uint32_t episodeSteps = static_cast<uint32_t>(lround(before[BatchEnvironment::EpisodeProgress] * BatchEnvironment::MaxEpisodeSteps)) + 1;
+					unexplainedEnds += (result.Lost || chunkMask == 0 || episodeSteps >= BatchEnvironment::MaxEpisodeSteps ? 0 : 1);
+					++episodes;
+					continue;
+				}
+
+				const bool sameState = (after[BatchEnvironment::BallX] == state.BallX && after[BatchEnvironment::BallY] == state.BallY &&
+					after[BatchEnvironment::BallVelocityX] == state.BallVelocityX && after[BatchEnvironment::BallVelocityY] == state.BallVelocityY &&
+					after[BatchEnvironment::BarX] == state.BarX && after[BatchEnvironment::BarVelocityX] == state.BarVelocityX);
+				mismatchedStates += (sameState ? 0 : 1);
+				mismatchedChunks += (environments.ChunkMasks()[i] == chunkMask ? 0 : 1);
+			}
+		}
+
+		printf("checked %u environments over %u steps against GameRules, %llu episodes finished\n", environmentCount, stepCount, static_cast<unsigned long long>(episodes));
+
+		bool passed = true;
+		passed &= Check(mismatchedStates == 0, "ball and bar match stepping each environment through GameRules");
+		passed &= Check(mismatchedChunks == 0, "standing chunks match GameRules::StepChunks");
+		passed &= Check(mismatchedRewards == 0, "rewards match the chunks broken and balls lost");
+		passed &= Check(unexplainedEnds == 0, "episodes only end on a lost ball, a cleared wall or the step limit");
+		passed &= Check(episodes > 0, "the check covers finished episodes");
+
+		return passed;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool passed = CheckAgainstGameRules();
+
+	const uint32_t environmentCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 4096);
+	const uint32_t threadCount = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 0);
+	const uint32_t stepCount = (argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 2000);
+	const bool chase = (argc > 4 && strcmp(argv[4], "chase") == 0);
+
+	BatchEnvironment environments(environmentCount, threadCount);
+
+	vector<float> observations(static_cast<size_t>(environmentCount) * BatchEnvironment::ObservationSize);
+	vector<float> rewards(environmentCount);
+	vector<uint8_t> done(environmentCount);
+	vector<uint8_t> actions(environmentCount);
+	uint32_t randomState = 0x9E3779B9U;
+
+	environments.Reset(observations.data());
+
+	double totalReward = 0.0;
+	uint64_t episodes = 0;
+	double actionSeconds = 0.0;
+
+	const auto start = chrono::steady_clock::now();
+
+	for (uint32_t step = 0; step < stepCount; ++step)
+	{
+		const auto actionStart = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < environmentCount; ++i)
+		{
+			if (chase)
+			{
+				// Keep the middle of the bar under the ball.
+				const float* observation = &observations[static_cast<size_t>(i) * BatchEnvironment::ObservationSize];
+				const float offset = observation[BatchEnvironment::BallX] - (observation[BatchEnvironment::BarX] + 4.0f);
+				actions[i] = (offset > 1.0f ? BatchEnvironment::MoveRight : (offset < -1.0f ? BatchEnvironment::MoveLeft : BatchEnvironment::None));
+			}
+			else
+			{
+				actions[i] = RandomAction(randomState);
+			}
+		}
+		actionSeconds += chrono::duration<double>(chrono::steady_clock::now() - actionStart).count();
+
+		environments.Step(actions.data(), observations.data(), rewards.data(), done.data());
+
+		for (uint32_t i = 0; i < environmentCount; ++i)
+		{
+			totalReward += rewards[i];
+			episodes += done[i];
+		}
+	}
+
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	const double stepSeconds = seconds - actionSeconds;
+	const double environmentSteps = static_cast<double>(environmentCount) * stepCount;
+
+	printf("environments %u, threads %u, steps %u, policy %s\n", environmentCount, environments.ThreadCount(), stepCount, (chase ? "chase" : "random"));
+	printf("episodes finished %llu, mean reward per episode %.3f\n", static_cast<unsigned long long>(episodes), (episodes > 0 ? totalReward / static_cast<double>(episodes) : 0.0));
+	printf("%.1f M env-steps/s (Step only), %.1f M env-steps/s (including policy)\n", environmentSteps / stepSeconds / 1.0e6, environmentSteps / seconds / 1.0e6);
+
+	printf("%s\n", (passed ? "checks passed" : "checks FAILED"));
+	return (passed ? 0 : 1);
+}
@@ -0,0 +1,396 @@
+// Compares drawing the brick wall straight to the back buffer every frame (one instanced draw) against ChunkManager's
+// cached brick layer: the wall is drawn once into a CachedLayer, composited with one quad over the wall's bounds, and only
+// a destroyed brick's rectangle is cleared and redrawn. The wall is laid out by GameRules, as ChunkManager lays it out, and
+// both paths are recorded the way ChunkManager records them. Each list goes through the RecordingRenderBackend for draw
+// and clear counts and through the SoftwareRenderBackend, which rasterizes it with the game's pipelines. The software
+// backend gives the pixels shaded, and the checks:
+//   - the cached path puts exactly the same pixels on screen as the direct one, every frame and after every break;
+//   - the layer target is only bound on frames that update it, and the layer is up to date after them;
+//   - steady frames draw only the layer quad, and break frames redraw once inside the brick's rectangle;
+//   - the last frame breaks more bricks than CachedLayer keeps rectangles for, and the layer is redrawn whole, once.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared -I../../Game.Universal BrickLayerBenchmark.cpp ../../Library.Shared/CachedLayer.cpp ../../Library.Shared/RenderCommandList.cpp ../../Library.Shared/RecordingRenderBackend.cpp ../../Library.Shared/SoftwareRenderBackend.cpp ../../Game.Universal/GameRules.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared /I..\..\Game.Universal BrickLayerBenchmark.cpp ..\..\Library.Shared\CachedLayer.cpp ..\..\Library.Shared\RenderCommandList.cpp ..\..\Library.Shared\RecordingRenderBackend.cpp ..\..\Library.Shared\SoftwareRenderBackend.cpp ..\..\Game.Universal\GameRules.cpp
+//
+// Usage: BrickLayerBenchmark [frames] [frames between breaks] [width] [height]
+// Defaults to 600 frames, a break every 60 frames, 1920x1080.
+
+#include "CachedLayer.h"
+#include "GameRules.h"
+#include "RecordingRenderBackend.h"
+#include "RenderCommandList.h"
+#include "SoftwareRenderBackend.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+using namespace DirectXGame;
+
+namespace
+{
+	const uint32_t BrickVertexCount = 4;
+	const uint32_t LayerQuadVertexCount = 4;
+	const uint32_t PaletteSize = 8;					// ChunkManager::PaletteSize
+	const float ViewSize = 100.0f;					// OrthographicCamera's default view width and height
+	const float Black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	typedef SoftwareRenderBackend::ShaderType ShaderType;
+	typedef SoftwareRenderBackend::PrimitiveType PrimitiveType;
+
+	struct Vertex
+	{
+		float Position[4];
+	};
+
+	// ChunkManager::InitializeTriangleVertices: top left, top right, bottom left, bottom right.
+	const Vertex BrickVertices[BrickVertexCount] =
+	{
+		{ { 0.0f, -38.0f, 0.0f, 1.0f } },
+		{ { 6.0f, -38.0f, 0.0f, 1.0f } },
+		{ { 0.0f, -40.0f, 0.0f, 1.0f } },
+		{ { 6.0f, -40.0f, 0.0f, 1.0f } }
+	};
+
+	// Mirrors ChunkManager::ChunkInstance.
+	struct BrickInstance
+	{
+		float Offset[2];
+		float Scale;
+		uint32_t PaletteIndex;
+	};
+
+	// Mirrors ChunkManager::CBufferPerFrame.
+	struct InstancedConstants
+	{
+		float ViewProjection[16];
+		float Palette[PaletteSize][4];
+	};
+
+	// ChunkManager::mChunkColors, a row each.
+	const float BrickColors[][4] =
+	{
+		{ 1.0f, 0.412f, 0.706f, 1.0f },		// HotPink
+		{ 1.0f, 0.0f, 0.0f, 1.0f },			// Red
+		{ 1.0f, 0.647f, 0.0f, 1.0f },		// Orange
+		{ 1.0f, 1.0f, 0.0f, 1.0f },			// Yellow
+		{ 0.486f, 0.988f, 0.0f, 1.0f },		// LawnGreen
+		{ 0.529f, 0.808f, 0.980f, 1.0f }	// LightSkyBlue
+	};
+
+	struct Brick
+	{
+		BrickInstance Instance;
+		bool Destroyed;
+	};
+
+	// ChunkManager::InitializeChunks: rows of bricks from the top row down, colored by row.
+	vector<Brick> CreateWall()
+	{
+		vector<Brick> bricks(GameRules::ChunkCount);
+		for (uint32_t i = 0; i < GameRules::ChunkCount; ++i)
+		{
+			const uint32_t row = i / GameRules::ChunkColumns;
+			const uint32_t column = i % GameRules::ChunkColumns;
+			const BrickInstance instance = { { GameRules::ChunkLeft + GameRules::ChunkWidth * static_cast<float>(column), GameRules::ChunkTopRowY - GameRules::ChunkHeight * static_cast<float>(row) },
+				GameRules::ChunkScale, row };
+			bricks[i].Instance = instance;
+			bricks[i].Destroyed = false;
+		}
+
+		return bricks;
+	}
+
+	// ChunkManager::ChunkBounds.
+	CachedLayer::Bounds BrickBounds(const Brick& brick)
+	{
+		const BrickInstance& instance = brick.Instance;
+		const CachedLayer::Bounds bounds = { instance.Offset[0] + BrickVertices[0].Position[0] * instance.Scale, instance.Offset[1] + BrickVertices[2].Position[1] * instance.Scale,
+			instance.Offset[0] + BrickVertices[1].Position[0] * instance.Scale, instance.Offset[1] + BrickVertices[0].Position[1] * instance.Scale };
+		return bounds;
+	}
+
+	// The camera's projection of the 100x100 view, transposed like the constants ChunkManager uploads.
+	InstancedConstants CreateConstants()
+	{
+		InstancedConstants constants = {};
+		constants.ViewProjection[0] = 2.0f / ViewSize;
+		constants.ViewProjection[5] = 2.0f / ViewSize;
+		constants.ViewProjection[10] = 1.0f;
+		constants.ViewProjection[15] = 1.0f;
+		for (uint32_t i = 0; i < sizeof(BrickColors) / sizeof(BrickColors[0]); ++i)
+		{
+			memcpy(constants.Palette[i], BrickColors[i], sizeof(constants.Palette[i]));
+		}
+
+		return constants;
+	}
+
+	// The pipelines and meshes ChunkManager creates, on one software backend.
+	struct Scene
+	{
+		PipelineHandle BrickPipeline;
+		PipelineHandle LayerPipeline;
+		MeshHandle BrickMesh;
+		MeshHandle LayerQuadMesh;
+	};
+
+	// The layer quad covers the wall's bounds with the brick quad's winding, as ChunkManager::InitializeLayerQuad builds it.
+	Scene CreateScene(SoftwareRenderBackend& backend, const CachedLayer::Bounds& wallBounds)
+	{
+		const Vertex layerQuad[LayerQuadVertexCount] =
+		{
+			{ { wallBounds.Left, wallBounds.Top, 0.0f, 1.0f } },
+			{ { wallBounds.Right, wallBounds.Top, 0.0f, 1.0f } },
+			{ { wallBounds.Left, wallBounds.Bottom, 0.0f, 1.0f } },
+			{ { wallBounds.Right, wallBounds.Bottom, 0.0f, 1.0f } }
+		};
+
+		Scene scene;
+		scene.BrickPipeline = backend.CreatePipeline({ ShaderType::PaletteInstanced, PrimitiveType::TriangleStrip, false });
+		scene.LayerPipeline = backend.CreatePipeline({ ShaderType::LayerComposite, PrimitiveType::TriangleStrip, false });
+		scene.BrickMesh = backend.CreateMesh({ BrickVertices, BrickVertexCount, sizeof(Vertex), GameRules::ChunkCount, sizeof(BrickInstance) });
+		scene.LayerQuadMesh = backend.CreateMesh({ layerQuad, LayerQuadVertexCount, sizeof(Vertex), 0, 0 });
+		return scene;
+	}
+
+	void RebuildInstances(const vector<Brick>& bricks, vector<BrickInstance>& instances)
+	{
+		instances.clear();
+		for (const Brick& brick : bricks)
+		{
+			if (!brick.Destroyed)
+			{
+				instances.push_back(brick.Instance);
+			}
+		}
+	}
+
+	// The submission ChunkManager used before the layer: one instanced draw straight to the back buffer every frame.
+	void RecordDirect(RenderCommandList& commandList, const Scene& scene, const vector<Brick>& bricks, vector<BrickInstance>& instances, bool& instancesDirty,
+		const InstancedConstants& constants)
+	{
+		commandList.SetPipeline(scene.BrickPipeline);
+		commandList.SetMesh(scene.BrickMesh);
+
+		if (instancesDirty)
+		{
+			RebuildInstances(bricks, instances);
+			commandList.UpdateInstances(instances.data(), static_cast<uint32_t>(instances.size()));
+			instancesDirty = false;
+		}
+
+		if (instances.empty())
+		{
+			return;
+		}
+
+		commandList.SetConstants(ShaderStage::Vertex, constants);
+		commandList.DrawInstanced(BrickVertexCount, static_cast<uint32_t>(instances.size()));
+	}
+
+	// ChunkManager::RecordDraws and RecordBrickLayerUpdate, with the camera fixed.
+	void RecordCached(RenderCommandList& commandList, const Scene& scene, const vector<Brick>& bricks, CachedLayer& layer, vector<BrickInstance>& instances,
+		bool& instancesDirty, const InstancedConstants& constants)
+	{
+		if (layer.NeedsUpdate())
+		{
+			layer.BeginUpdate(commandList);
+			commandList.SetPipeline(scene.BrickPipeline);
+			commandList.SetMesh(scene.BrickMesh);
+
+			if (instancesDirty)
+			{
+				RebuildInstances(bricks, instances);
+				commandList.UpdateInstances(instances.data(), static_cast<uint32_t>(instances.size()));
+				instancesDirty = false;
+			}
+
+			commandList.SetConstants(ShaderStage::Vertex, constants);
+			layer.EndUpdate(commandList, BrickVertexCount, static_cast<uint32_t>(instances.size()));
+		}
+
+		if (instances.empty())
+		{
+			return;
+		}
+
+		layer.RecordComposite(commandList, scene.LayerPipeline, scene.LayerQuadMesh, LayerQuadVertexCount);
+	}
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool SameBackBuffer(const SoftwareRenderBackend& lhs, const SoftwareRenderBackend& rhs)
+	{
+		return memcmp(lhs.Pixels(), rhs.Pixels(), static_cast<size_t>(lhs.RowPitch()) * lhs.Height() * sizeof(uint32_t)) == 0;
+	}
+
+	// Per-frame cost of one path: draws, vertices and clears from the recording backend, pixels shaded from the software
+	// backend.
+	struct FrameCost
+	{
+		uint64_t Draws;
+		uint64_t Vertices;
+		uint64_t Clears;
+		uint64_t ClearedPixels;
+		uint64_t ShadedPixels;
+		uint32_t Frames;
+
+		void Add(const RecordingRenderBackend::Counters& counters, uint64_t shadedPixels)
+		{
+			Draws += counters.Draws;
+			Vertices += counters.Vertices;
+			Clears += counters.Clears;
+			ClearedPixels += counters.ClearedPixels;
+			ShadedPixels += shadedPixels;
+			++Frames;
+		}
+
+		void Print(const char* name) const
+		{
+			const double frames = static_cast<double>(max(Frames, 1U));
+			printf("%-26s %8.2f %10.1f %8.2f %14.0f %14.0f %14.0f\n", name, static_cast<double>(Draws) / frames, static_cast<double>(Vertices) / frames,
+				static_cast<double>(Clears) / frames, static_cast<double>(ClearedPixels) / frames, static_cast<double>(ShadedPixels) / frames,
+				static_cast<double>(ClearedPixels + ShadedPixels) / frames);
+		}
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t frameCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 600);
+	const uint32_t breakEvery = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 60);
+	const uint32_t width = (argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 1920);
+	const uint32_t height = (argc > 4 ? static_cast<uint32_t>(strtoul(argv[4], nullptr, 10)) : 1080);
+	if (frameCount == 0 || breakEvery == 0 || width == 0 || height == 0)
+	{
+		fprintf(stderr, "Frames, frames between breaks, width and height must be positive.\n");
+		return EXIT_FAILURE;
+	}
+
+	const InstancedConstants constants = CreateConstants();
+
+	vector<Brick> directBricks = CreateWall();
+	vector<Brick> cachedBricks = directBricks;
+
+	CachedLayer::Bounds wallBounds = BrickBounds(directBricks[0]);
+	for (const Brick& brick : directBricks)
+	{
+		const CachedLayer::Bounds bounds = BrickBounds(brick);
+		wallBounds.Left = min(wallBounds.Left, bounds.Left);
+		wallBounds.Bottom = min(wallBounds.Bottom, bounds.Bottom);
+		wallBounds.Right = max(wallBounds.Right, bounds.Right);
+		wallBounds.Top = max(wallBounds.Top, bounds.Top);
+	}
+
+	RecordingRenderBackend directRecording;
+	RecordingRenderBackend cachedRecording;
+	directRecording.SetBackBufferSize(width, height);
+	cachedRecording.SetBackBufferSize(width, height);
+	SoftwareRenderBackend directBackend(width, height);
+	SoftwareRenderBackend cachedBackend(width, height);
+	const Scene directScene = CreateScene(directBackend, wallBounds);
+	const Scene cachedScene = CreateScene(cachedBackend, wallBounds);
+
+	CachedLayer layer;
+	const RenderTargetHandle layerTarget = cachedRecording.CreateRenderTarget(width, height);
+	bool passed = Check(cachedBackend.CreateRenderTarget(width, height) == layerTarget, "both backends hand out the same handle");
+	layer.SetTarget(layerTarget, width, height);
+	layer.SetViewProjection(constants.ViewProjection);
+
+	vector<BrickInstance> directInstances;
+	vector<BrickInstance> cachedInstances;
+	bool directInstancesDirty = true;
+	bool cachedInstancesDirty = true;
+
+	// GameMain::Render clears the back buffer before the list executes; that clear is common to both paths and not counted.
+	RenderCommandList clearList;
+	clearList.ClearRenderTarget(Black);
+
+	RenderCommandList commandList;
+	FrameCost direct = {};
+	FrameCost cachedFirst = {};
+	FrameCost cachedSteady = {};
+	FrameCost cachedBreak = {};
+	FrameCost cachedOverflow = {};
+	FrameCost cachedAll = {};
+	bool identical = true;
+	bool upToDate = true;
+	uint32_t breaks = 0;
+
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		// Break bricks spread across the wall, keeping at least one standing, as ChunkManager::HandleBallCollision does. The
+		// last frame breaks more at once than the layer keeps rectangles for.
+		const bool overflow = (frame > 0 && frame + 1 == frameCount && breaks + CachedLayer::MaxDirtyBounds + 1 < directBricks.size());
+		const uint32_t breakCount = (overflow ? CachedLayer::MaxDirtyBounds + 1 : (frame > 0 && frame % breakEvery == 0 && breaks + 1 < directBricks.size() ? 1 : 0));
+		const bool broke = (breakCount > 0);
+		for (uint32_t i = 0; i < breakCount; ++i)
+		{
+			// Seven and the sixty bricks of the wall share no factor, so this visits every brick once.
+			const size_t index = (static_cast<size_t>(breaks) * 7) % directBricks.size();
+			directBricks[index].Destroyed = true;
+			directInstancesDirty = true;
+
+			cachedBricks[index].Destroyed = true;
+			cachedInstancesDirty = true;
+			layer.Invalidate(BrickBounds(cachedBricks[index]));
+			++breaks;
+		}
+
+		directBackend.Execute(clearList);
+		cachedBackend.Execute(clearList);
+		directBackend.ResetCounters();
+		cachedBackend.ResetCounters();
+
+		commandList.Clear();
+		RecordDirect(commandList, directScene, directBricks, directInstances, directInstancesDirty, constants);
+		directRecording.Execute(commandList);
+		directBackend.Execute(commandList);
+		direct.Add(directRecording.LastExecution(), directBackend.Totals().PixelsShaded);
+
+		commandList.Clear();
+		RecordCached(commandList, cachedScene, cachedBricks, layer, cachedInstances, cachedInstancesDirty, constants);
+		cachedRecording.Execute(commandList);
+		cachedBackend.Execute(commandList);
+		const RecordingRenderBackend::Counters& counters = cachedRecording.LastExecution();
+		const uint64_t shadedPixels = cachedBackend.Totals().PixelsShaded;
+		(frame == 0 ? cachedFirst : (overflow ? cachedOverflow : (broke ? cachedBreak : cachedSteady))).Add(counters, shadedPixels);
+		cachedAll.Add(counters, shadedPixels);
+
+		passed &= Check(counters.RenderTargetChanges == (frame == 0 || broke ? 2U : 0U), "the layer target is only bound when it changes");
+		upToDate &= !layer.NeedsUpdate();
+		identical &= SameBackBuffer(directBackend, cachedBackend);
+	}
+
+	printf("%u frames at %ux%u, a brick broken every %u frames (%u breaks)\n\n", frameCount, width, height, breakEvery, breaks);
+	printf("%-26s %8s %10s %8s %14s %14s %14s\n", "per frame", "draws", "vertices", "clears", "cleared px", "shaded px", "fill px");
+	direct.Print("direct, every frame");
+	cachedFirst.Print("cached, first frame");
+	cachedSteady.Print("cached, steady frames");
+	cachedBreak.Print("cached, break frames");
+	cachedOverflow.Print("cached, overflow frame");
+	cachedAll.Print("cached, every frame");
+
+	passed &= Check(identical, "the cached layer puts the same pixels on screen as drawing directly");
+	passed &= Check(upToDate, "the layer is up to date once recorded");
+	passed &= Check(cachedSteady.Frames == 0 || (cachedSteady.Draws == cachedSteady.Frames && cachedSteady.Clears == 0), "steady frames draw only the layer quad");
+	passed &= Check(cachedBreak.Frames == 0 || cachedBreak.Draws == 2 * cachedBreak.Frames, "break frames redraw once inside the brick's rectangle");
+	passed &= Check(cachedOverflow.Frames == 0 || (cachedOverflow.Draws == 2 && cachedOverflow.Clears == 1 &&
+		cachedOverflow.ClearedPixels == static_cast<uint64_t>(width) * height), "too many rectangles redraw the whole layer once");
+
+	printf(passed ? "checks passed\n" : "checks FAILED\n");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,304 @@
+// Compares the CPU cost of submitting the brick layer one draw per brick (per-brick matrix and color constants) against one
+// instanced draw (per-frame constants plus an instance buffer that is only rewritten when a brick is destroyed), and
+// checks what the RecordingRenderBackend receives for each.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -I../../Library.Shared BrickSubmissionBenchmark.cpp ../../Library.Shared/RenderCommandList.cpp ../../Library.Shared/RecordingRenderBackend.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared BrickSubmissionBenchmark.cpp ..\..\Library.Shared\RenderCommandList.cpp ..\..\Library.Shared\RecordingRenderBackend.cpp
+//
+// Usage: BrickSubmissionBenchmark [frames] [brick count...]
+// Defaults to 600 frames at 60 (the game's wall), 10000 and 100000 bricks.
+
+#include "RecordingRenderBackend.h"
+#include "RenderCommandList.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	const uint32_t BrickVertexCount = 4;
+	const uint32_t PaletteSize = 8;
+
+	struct Matrix
+	{
+		float M[4][4];
+	};
+
+	struct Color
+	{
+		float Rgba[4];
+	};
+
+	// Mirrors ChunkManager's per-instance input and per-frame constant buffer.
+	struct BrickInstance
+	{
+		float Offset[2];
+		float Scale;
+		uint32_t PaletteIndex;
+	};
+
+	struct BrickConstants
+	{
+		Matrix ViewProjection;
+		Color Palette[PaletteSize];
+	};
+
+	struct Brick
+	{
+		float X;
+		float Y;
+		float Scale;
+		uint32_t PaletteIndex;
+		bool Destroyed;
+	};
+
+	Matrix Multiply(const Matrix& lhs, const Matrix& rhs)
+	{
+		Matrix result;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				result.M[row][column] = lhs.M[row][0] * rhs.M[0][column] + lhs.M[row][1] * rhs.M[1][column] +
+					lhs.M[row][2] * rhs.M[2][column] + lhs.M[row][3] * rhs.M[3][column];
+			}
+		}
+
+		return result;
+	}
+
+	// Lays bricks out in 10-wide rows of 9x3 cells like the game's wall, continuing downward past six rows.
+	vector<Brick> CreateWall(uint32_t brickCount)
+	{
+		vector<Brick> bricks(brickCount);
+		for (uint32_t i = 0; i < brickCount; ++i)
+		{
+			const uint32_t row = i / 10;
+			bricks[i].X = -45.0f + 9.0f * static_cast<float>(i % 10);
+			bricks[i].Y = 97.0f - 3.0f * static_cast<float>(row);
+			bricks[i].Scale = 1.5f;
+			bricks[i].PaletteIndex = row % 6;
+			bricks[i].Destroyed = false;
+		}
+
+		return bricks;
+	}
+
+	// The submission ChunkManager used before instancing: world-view-projection and color constants and a draw per brick.
+	void RecordPerBrick(RenderCommandList& commandList, const vector<Brick>& bricks, const Matrix& viewProjection, const Color* palette)
+	{
+		commandList.Clear();
+		commandList.SetPipeline(0);
+		commandList.SetMesh(0);
+
+		for (const Brick& brick : bricks)
+		{
+			if (brick.Destroyed)
+			{
+				continue;
+			}
+
+			const Matrix world = { { { brick.Scale, 0, 0, 0 }, { 0, brick.Scale, 0, 0 }, { 0, 0, brick.Scale, 0 }, { brick.X, brick.Y, 0, 1 } } };
+			const Matrix wvp = Multiply(world, viewProjection);
+			commandList.SetConstants(ShaderStage::Vertex, wvp);
+			commandList.SetConstants(ShaderStage::Pixel, palette[brick.PaletteIndex]);
+			commandList.Draw(BrickVertexCount);
+		}
+	}
+
+	// ChunkManager's instanced submission.
+	void RecordInstanced(RenderCommandList& commandList, const vector<Brick>& bricks, vector<BrickInstance>& instances, bool& instancesDirty,
+		BrickConstants& constants, const Matrix& viewProjection)
+	{
+		commandList.Clear();
+		commandList.SetPipeline(1);
+		commandList.SetMesh(1);
+
+		if (instancesDirty)
+		{
+			instances.clear();
+			for (const Brick& brick : bricks)
+			{
+				if (!brick.Destroyed)
+				{
+					const BrickInstance instance = { { brick.X, brick.Y }, brick.Scale, brick.PaletteIndex };
+					instances.push_back(instance);
+				}
+			}
+
+			commandList.UpdateInstances(instances.data(), static_cast<uint32_t>(instances.size()));
+			instancesDirty = false;
+		}
+
+		if (instances.empty())
+		{
+			return;
+		}
+
+		constants.ViewProjection = viewProjection;
+		commandList.SetConstants(ShaderStage::Vertex, constants);
+		commandList.DrawInstanced(BrickVertexCount, static_cast<uint32_t>(instances.size()));
+	}
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	struct Result
+	{
+		double RecordNanoseconds;
+		double ExecuteNanoseconds;
+		uint64_t Draws;
+		uint64_t InstanceBytes;
+		uint32_t BreakFrames;
+	};
+
+	// Runs frameCount frames. When destroyEvery is nonzero, one brick is destroyed every destroyEvery frames until half the
+	// wall is gone, so every case still has bricks to draw.
+	template <typename RecordFunction>
+	Result Run(RecordFunction record, vector<Brick>& bricks, RenderCommandList& commandList, RecordingRenderBackend& backend, uint32_t frameCount,
+		uint32_t destroyEvery, bool& instancesDirty)
+	{
+		double recordSeconds = 0.0;
+		double executeSeconds = 0.0;
+		uint32_t nextDestroyed = 0;
+		uint32_t breakFrames = 0;
+		backend.ResetCounters();
+
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			if (destroyEvery != 0 && frame % destroyEvery == 0 && nextDestroyed < bricks.size() / 2)
+			{
+				// Break bricks spread across the wall so the rebuilt instance order changes throughout.
+				const size_t index = (static_cast<size_t>(nextDestroyed) * 7919) % bricks.size();
+				if (!bricks[index].Destroyed)
+				{
+					bricks[index].Destroyed = true;
+					instancesDirty = true;
+					++breakFrames;
+				}
+
+				++nextDestroyed;
+			}
+
+			const auto recordStart = chrono::steady_clock::now();
+			record();
+			const auto executeStart = chrono::steady_clock::now();
+			backend.Execute(commandList);
+			const auto executeEnd = chrono::steady_clock::now();
+
+			recordSeconds += chrono::duration<double>(executeStart - recordStart).count();
+			executeSeconds += chrono::duration<double>(executeEnd - executeStart).count();
+		}
+
+		const Result result = { recordSeconds / frameCount * 1.0e9, executeSeconds / frameCount * 1.0e9, backend.LastExecution().Draws, backend.Totals().InstanceBytes,
+			breakFrames };
+		return result;
+	}
+
+	uint32_t LiveBricks(const vector<Brick>& bricks)
+	{
+		uint32_t count = 0;
+		for (const Brick& brick : bricks)
+		{
+			count += (brick.Destroyed ? 0 : 1);
+		}
+
+		return count;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t frameCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 600);
+	vector<uint32_t> brickCounts;
+	for (int i = 2; i < argc; ++i)
+	{
+		brickCounts.push_back(static_cast<uint32_t>(strtoul(argv[i], nullptr, 10)));
+	}
+
+	if (brickCounts.empty())
+	{
+		brickCounts = { 60, 10000, 100000 };
+	}
+
+	if (frameCount == 0)
+	{
+		fprintf(stderr, "Frame count must be positive.\n");
+		return 1;
+	}
+
+	// An orthographic view-projection like the game camera's; the values only need to be representative.
+	const Matrix viewProjection = { { { 0.02f, 0, 0, 0 }, { 0, 0.02f, 0, 0 }, { 0, 0, 0.001f, 0 }, { 0, -0.5f, 0.5f, 1 } } };
+	const Color palette[PaletteSize] = { { { 1, 0.41f, 0.71f, 1 } }, { { 1, 0, 0, 1 } }, { { 1, 0.65f, 0, 1 } }, { { 1, 1, 0, 1 } },
+		{ { 0.49f, 0.99f, 0, 1 } }, { { 0.53f, 0.81f, 0.98f, 1 } } };
+
+	printf("%u frames per case; times are CPU ns per frame, execute is on the recording backend, uploaded KB is the run total\n\n", frameCount);
+	printf("%8s  %-22s %8s %12s %12s %14s\n", "bricks", "case", "draws", "record ns", "execute ns", "uploaded KB");
+
+	bool passed = true;
+	for (uint32_t brickCount : brickCounts)
+	{
+		RecordingRenderBackend backend;
+		RenderCommandList commandList;
+		vector<BrickInstance> instances;
+		instances.reserve(brickCount);
+		BrickConstants constants = {};
+		for (uint32_t i = 0; i < PaletteSize; ++i)
+		{
+			constants.Palette[i] = palette[i];
+		}
+
+		for (int destroying = 0; destroying < 2; ++destroying)
+		{
+			// Steady frames break nothing; the other case breaks a brick every frame, the worst case for the instance buffer.
+			const uint32_t destroyEvery = (destroying != 0 ? 1 : 0);
+			const char* suffix = (destroying != 0 ? "break 1/frame" : "steady");
+
+			vector<Brick> bricks = CreateWall(brickCount);
+			bool unused = false;
+			const Result perBrick = Run([&]() { RecordPerBrick(commandList, bricks, viewProjection, palette); },
+				bricks, commandList, backend, frameCount, destroyEvery, unused);
+			const uint32_t perBrickLive = LiveBricks(bricks);
+
+			passed &= Check(perBrick.Draws == perBrickLive, "per-brick path draws every standing brick");
+			passed &= Check(backend.LastExecution().Vertices == static_cast<uint64_t>(perBrickLive) * BrickVertexCount, "per-brick vertex count");
+
+			bricks = CreateWall(brickCount);
+			bool instancesDirty = true;
+			const Result instanced = Run([&]() { RecordInstanced(commandList, bricks, instances, instancesDirty, constants, viewProjection); },
+				bricks, commandList, backend, frameCount, destroyEvery, instancesDirty);
+			const uint32_t instancedLive = LiveBricks(bricks);
+
+			const RecordingRenderBackend::Counters& last = backend.LastExecution();
+			passed &= Check(instanced.Draws == (instancedLive > 0 ? 1u : 0u), "instanced path issues one draw");
+			passed &= Check(last.Instances == instancedLive, "instanced path draws every standing brick");
+			passed &= Check(last.Vertices == static_cast<uint64_t>(instancedLive) * BrickVertexCount, "instanced vertex count");
+			// The first frame uploads the initial wall; when breaking, that frame also breaks a brick.
+			passed &= Check(backend.Totals().InstanceUpdates == (destroying != 0 ? instanced.BreakFrames : 1), "instances are uploaded only when bricks break");
+			passed &= Check(backend.Draws().empty() || backend.Draws()[0].InstanceCount == instancedLive, "instanced draw record");
+
+			char label[64];
+			snprintf(label, sizeof(label), "per-brick, %s", suffix);
+			printf("%8u  %-22s %8llu %12.0f %12.0f %14s\n", brickCount, label, static_cast<unsigned long long>(perBrick.Draws),
+				perBrick.RecordNanoseconds, perBrick.ExecuteNanoseconds, "-");
+			snprintf(label, sizeof(label), "instanced, %s", suffix);
+			printf("%8u  %-22s %8llu %12.0f %12.0f %14.1f\n", brickCount, label, static_cast<unsigned long long>(instanced.Draws),
+				instanced.RecordNanoseconds, instanced.ExecuteNanoseconds, static_cast<double>(instanced.InstanceBytes) / 1024.0);
+		}
+	}
+
+	printf("\n%s\n", (passed ? "checks passed" : "checks FAILED"));
+	return (passed ? 0 : 1);
+}
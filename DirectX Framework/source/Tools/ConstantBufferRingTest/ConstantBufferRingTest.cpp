@@ -0,0 +1,252 @@
+// Checks the constant buffer ring that D3D11RenderBackend sub-allocates per-draw constants from, and measures what the
+// upload costs. A simulated device buffer stands in for the dynamic constant buffer: every map writes the list's constants
+// at the offsets the ring hands out, and every draw then reads its constants back from those offsets. The checks:
+//   - each range is 256-byte aligned, lies inside the mapped range and the buffer, and reads back what was recorded;
+//   - a no-overwrite map never touches bytes handed out since the last discard, which the GPU may still be reading;
+//   - every list is mapped exactly once, and a list that needs more than half of the buffer grows it;
+//   - the counters add up to what was recorded.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -I../../Library.Shared ConstantBufferRingTest.cpp ../../Library.Shared/ConstantBufferRing.cpp ../../Library.Shared/RenderCommandList.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared ConstantBufferRingTest.cpp ..\..\Library.Shared\ConstantBufferRing.cpp ..\..\Library.Shared\RenderCommandList.cpp
+//
+// Usage: ConstantBufferRingTest [draws per frame] [frames]
+
+#include "ConstantBufferRing.h"
+#include "RenderCommandList.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	// Matches what the shape managers upload per draw: a world-view-projection matrix and a color.
+	struct Matrix
+	{
+		float M[16];
+	};
+
+	struct Color
+	{
+		float Rgba[4];
+	};
+
+	// Stands in for the dynamic constant buffer. Discarding starts a new version of the contents; ranges handed out in the
+	// current version are tracked so a no-overwrite map can be checked against them.
+	struct SimulatedBuffer
+	{
+		vector<uint8_t> Storage;
+		uint32_t Versions;
+		vector<ConstantBufferRing::Range> LiveRanges;
+	};
+
+	// Records a frame the way the game does: the brick layer's per-frame constants, then per-object constants and a draw.
+	void RecordFrame(RenderCommandList& commandList, uint32_t frame, uint32_t drawCount)
+	{
+		Matrix wvp = {};
+		Color color = {};
+
+		commandList.Clear();
+		commandList.SetPipeline(0);
+		commandList.SetMesh(0);
+		wvp.M[0] = static_cast<float>(frame);
+		commandList.SetConstants(ShaderStage::Vertex, wvp);
+		commandList.Draw(4);
+
+		commandList.SetPipeline(1);
+		for (uint32_t i = 0; i < drawCount; ++i)
+		{
+			commandList.SetMesh(1 + (i % 3));
+
+			wvp.M[12] = static_cast<float>(i);
+			color.Rgba[0] = static_cast<float>(frame);
+			color.Rgba[1] = static_cast<float>(i);
+			commandList.SetConstants(ShaderStage::Vertex, wvp);
+			commandList.SetConstants(ShaderStage::Pixel, color);
+			commandList.Draw(66);
+		}
+	}
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool Overlaps(uint32_t offset, uint32_t size, const ConstantBufferRing::Range& range)
+	{
+		return (offset < range.Offset + range.Size && range.Offset < offset + size);
+	}
+
+	// Does what D3D11RenderBackend::UploadConstants does against the simulated buffer, then checks every SetConstants against
+	// what its draw would read back.
+	bool UploadAndVerify(ConstantBufferRing& ring, SimulatedBuffer& buffer, const RenderCommandList& commandList, vector<uint32_t>& offsets)
+	{
+		offsets.clear();
+		const uint32_t bytes = ConstantBufferRing::BytesNeeded(commandList);
+		if (bytes == 0)
+		{
+			return true;
+		}
+
+		bool passed = true;
+		const ConstantBufferRing::Range range = ring.Map(bytes);
+		if (range.Grew)
+		{
+			buffer.Storage.assign(ring.Capacity(), 0);
+		}
+
+		if (range.Mode == ConstantBufferRing::MapMode::Discard)
+		{
+			++buffer.Versions;
+			buffer.LiveRanges.clear();
+		}
+		else
+		{
+			for (const ConstantBufferRing::Range& live : buffer.LiveRanges)
+			{
+				passed &= Check(!Overlaps(range.Offset, range.Size, live), "no-overwrite maps don't touch ranges since the last discard");
+			}
+		}
+
+		passed &= Check(range.Size == bytes && range.Offset % ConstantBufferRing::Alignment == 0, "mapped range is aligned and sized");
+		passed &= Check(range.Offset + range.Size <= buffer.Storage.size(), "mapped range lies inside the buffer");
+		buffer.LiveRanges.push_back(range);
+
+		const RenderCommand* commands = commandList.Commands();
+		for (size_t i = 0; i < commandList.CommandCount(); ++i)
+		{
+			const RenderCommand& command = commands[i];
+			if (command.Type == RenderCommandType::SetConstants)
+			{
+				const uint32_t offset = ring.Allocate(command.DataSize);
+				passed &= Check(offset % ConstantBufferRing::Alignment == 0, "allocations are aligned");
+				passed &= Check(offset >= range.Offset && offset + ConstantBufferRing::AlignedSize(command.DataSize) <= range.Offset + range.Size,
+					"allocations lie inside the mapped range");
+				memcpy(&buffer.Storage[offset], commandList.Data(command), command.DataSize);
+				offsets.push_back(offset);
+			}
+		}
+
+		ring.Unmap();
+
+		// What each draw would read through its bound offset.
+		size_t constantIndex = 0;
+		for (size_t i = 0; i < commandList.CommandCount(); ++i)
+		{
+			const RenderCommand& command = commands[i];
+			if (command.Type == RenderCommandType::SetConstants)
+			{
+				passed &= Check(memcmp(&buffer.Storage[offsets[constantIndex++]], commandList.Data(command), command.DataSize) == 0,
+					"draws read back the constants they were recorded with");
+			}
+		}
+
+		return passed;
+	}
+
+	// Small frames, a spike past the buffer's capacity, then a steady workload of drawCount objects.
+	uint32_t DrawsForFrame(uint32_t frame, uint32_t drawCount)
+	{
+		if (frame < 200)
+		{
+			return 1 + (frame % 8);
+		}
+
+		if (frame == 200)
+		{
+			return 1000;
+		}
+
+		return drawCount;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t drawCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 64);
+	const uint32_t frameCount = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 100000);
+
+	ConstantBufferRing ring;
+	SimulatedBuffer buffer;
+	buffer.Storage.assign(ring.Capacity(), 0);
+	buffer.Versions = 0;
+	vector<uint32_t> offsets;
+	RenderCommandList commandList;
+
+	// Correctness pass: every frame is checked against the simulated buffer.
+	const uint32_t checkedFrames = (frameCount < 2000 ? frameCount : 2000);
+	const uint32_t initialCapacity = ring.Capacity();
+	uint64_t expectedAllocations = 0;
+	uint64_t expectedBytes = 0;
+	bool passed = true;
+	for (uint32_t frame = 0; frame < checkedFrames && passed; ++frame)
+	{
+		const uint32_t draws = DrawsForFrame(frame, drawCount);
+		RecordFrame(commandList, frame, draws);
+		passed &= UploadAndVerify(ring, buffer, commandList, offsets);
+		ring.EndFrame();
+
+		expectedAllocations += 1 + 2 * static_cast<uint64_t>(draws);
+		expectedBytes += sizeof(Matrix) + static_cast<uint64_t>(draws) * (sizeof(Matrix) + sizeof(Color));
+		passed &= Check(ring.LastFrame().Maps == 1, "each list is mapped once");
+	}
+
+	const ConstantBufferRing::Counters checkedTotals = ring.Totals();
+	passed &= Check(checkedTotals.Frames == checkedFrames, "frame count");
+	passed &= Check(checkedTotals.Allocations == expectedAllocations, "allocation count");
+	passed &= Check(checkedTotals.BytesUploaded == expectedBytes, "bytes uploaded");
+	passed &= Check(checkedFrames <= 200 || (checkedTotals.Growths >= 1 && ring.Capacity() > initialCapacity), "a large list grows the buffer");
+	passed &= Check(checkedTotals.Discards >= 1 && (checkedTotals.Maps < 2 || checkedTotals.Discards < checkedTotals.Maps), "most maps don't discard");
+
+	printf("checked %u frames: %llu maps, %llu discards, %llu growths, capacity %u bytes, %llu buffer versions\n", checkedFrames,
+		static_cast<unsigned long long>(checkedTotals.Maps), static_cast<unsigned long long>(checkedTotals.Discards),
+		static_cast<unsigned long long>(checkedTotals.Growths), ring.Capacity(), static_cast<unsigned long long>(buffer.Versions));
+
+	// Timing pass at the steady workload, without the checks.
+	RecordFrame(commandList, 0, drawCount);
+	ring.ResetCounters();
+	double uploadSeconds = 0.0;
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		const auto uploadStart = chrono::steady_clock::now();
+		const ConstantBufferRing::Range range = ring.Map(ConstantBufferRing::BytesNeeded(commandList));
+		if (range.Grew)
+		{
+			buffer.Storage.assign(ring.Capacity(), 0);
+		}
+
+		const RenderCommand* commands = commandList.Commands();
+		for (size_t i = 0; i < commandList.CommandCount(); ++i)
+		{
+			if (commands[i].Type == RenderCommandType::SetConstants)
+			{
+				memcpy(&buffer.Storage[ring.Allocate(commands[i].DataSize)], commandList.Data(commands[i]), commands[i].DataSize);
+			}
+		}
+
+		ring.Unmap();
+		ring.EndFrame();
+		uploadSeconds += chrono::duration<double>(chrono::steady_clock::now() - uploadStart).count();
+	}
+
+	const ConstantBufferRing::Counters& totals = ring.Totals();
+	const double frames = static_cast<double>(frameCount > 0 ? frameCount : 1);
+	printf("%u draws/frame, %u frames\n", drawCount, frameCount);
+	printf("per frame: %.2f maps, %.4f discards, %.0f bytes uploaded, %.0f padding bytes (was %u UpdateSubresource calls)\n",
+		static_cast<double>(totals.Maps) / frames, static_cast<double>(totals.Discards) / frames, static_cast<double>(totals.BytesUploaded) / frames,
+		static_cast<double>(totals.PaddingBytes) / frames, 1 + 2 * drawCount);
+	printf("upload:  %.2f ns/constant update\n", uploadSeconds / static_cast<double>(totals.Allocations > 0 ? totals.Allocations : 1) * 1.0e9);
+
+	printf("%s\n", (passed ? "checks passed" : "checks FAILED"));
+	return (passed ? 0 : 1);
+}
@@ -0,0 +1,517 @@
+// Measures what state-sorting a recorded frame costs and saves, and checks that the sorted list draws the same thing.
+// Frames are recorded in submission order with per-draw constants, then sorted by the DrawSorter; both lists are replayed
+// on the RecordingRenderBackend. The checks:
+//   - every draw appears once in the sorted list, with the pipeline, mesh, texture, render target, scissor and constants
+//     it was recorded with;
+//   - draws stay between the barriers (render target changes, clears, scissor changes) they were recorded between;
+//   - within a segment, keys never decrease and draws with equal keys keep their recorded order;
+//   - instance updates still reach the mesh before the draws that read it;
+//   - in a frame that redraws the brick layer, recorded as GameMain records it, the layer update draws first, then the
+//     composite, then the powerups, bar and ball over it, and the particles last.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -I../../Library.Shared DrawSortBenchmark.cpp ../../Library.Shared/DrawSorter.cpp ../../Library.Shared/RenderCommandList.cpp ../../Library.Shared/RecordingRenderBackend.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared DrawSortBenchmark.cpp ..\..\Library.Shared\DrawSorter.cpp ..\..\Library.Shared\RenderCommandList.cpp ..\..\Library.Shared\RecordingRenderBackend.cpp
+//
+// Usage: DrawSortBenchmark [draws per frame] [repetitions]
+// Defaults to 100000 draws sorted 50 times.
+
+#include "DrawSorter.h"
+#include "RecordingRenderBackend.h"
+#include "RenderCommandList.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	// Matches what the shape managers upload per draw: a world-view-projection matrix and a color.
+	struct Matrix
+	{
+		float M[16];
+	};
+
+	struct Color
+	{
+		float Rgba[4];
+	};
+
+	const uint32_t LayerCount = 4;
+	const uint32_t PipelineCount = 8;
+	const uint32_t TextureCount = 16;
+	const uint32_t MeshCount = 64;
+
+	struct Resources
+	{
+		vector<PipelineHandle> Pipelines;
+		vector<MeshHandle> Meshes;
+		vector<RenderTargetHandle> Textures;
+		RenderTargetHandle Offscreen;
+	};
+
+	Resources CreateResources(RecordingRenderBackend& backend)
+	{
+		Resources resources;
+		for (uint32_t i = 0; i < PipelineCount; ++i)
+		{
+			resources.Pipelines.push_back(backend.CreatePipeline());
+		}
+
+		for (uint32_t i = 0; i < MeshCount; ++i)
+		{
+			resources.Meshes.push_back(backend.CreateMesh());
+		}
+
+		for (uint32_t i = 0; i < TextureCount; ++i)
+		{
+			resources.Textures.push_back(backend.CreateRenderTarget(256, 256));
+		}
+
+		resources.Offscreen = backend.CreateRenderTarget(1024, 1024);
+		backend.SetBackBufferSize(1920, 1080);
+		return resources;
+	}
+
+	// Draws with random state, numbered through StartVertex so they can be matched up after sorting. Half of the pipelines
+	// sample a texture, and their draws bind one. Every so often the
+	// frame switches to an offscreen target and back, clears a rectangle, or sets a scissor, and a few meshes get new
+	// instance data before their draws.
+	void RecordRandomFrame(RenderCommandList& commandList, const Resources& resources, uint32_t drawCount, uint32_t seed)
+	{
+		mt19937 random(seed);
+		const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		const uint32_t instances[4] = { 1, 2, 3, 4 };
+		Matrix wvp = {};
+		Color color = {};
+
+		commandList.Clear();
+		for (uint32_t i = 0; i < drawCount; ++i)
+		{
+			const uint32_t event = random() % 4096;
+			if (event == 0)
+			{
+				commandList.SetRenderTarget(resources.Offscreen);
+			}
+			else if (event == 1)
+			{
+				commandList.SetRenderTarget(RenderCommandList::BackBuffer);
+			}
+			else if (event == 2)
+			{
+				const PixelRect rect = { 0, 0, 64, 64 };
+				commandList.ClearRenderTarget(clearColor, rect);
+			}
+			else if (event == 3)
+			{
+				const PixelRect rect = { 16, 16, 512, 512 };
+				commandList.SetScissor(rect);
+			}
+			else if (event == 4)
+			{
+				commandList.ResetScissor();
+			}
+
+			const uint32_t pipeline = random() % PipelineCount;
+			commandList.SetLayer(static_cast<uint16_t>(random() % LayerCount));
+			commandList.SetPipeline(resources.Pipelines[pipeline]);
+			commandList.SetMesh(resources.Meshes[random() % MeshCount]);
+			if (pipeline < PipelineCount / 2)
+			{
+				commandList.SetTexture(resources.Textures[random() % TextureCount]);
+			}
+
+			if (random() % 512 == 0)
+			{
+				commandList.UpdateInstances(instances, 4);
+			}
+
+			wvp.M[12] = static_cast<float>(i);
+			color.Rgba[0] = static_cast<float>(i);
+			commandList.SetConstants(ShaderStage::Vertex, wvp);
+			if (random() % 4 != 0)
+			{
+				commandList.SetConstants(ShaderStage::Pixel, color);
+			}
+
+			if (random() % 8 == 0)
+			{
+				commandList.DrawInstanced(6, 1 + random() % 16, i);
+			}
+			else
+			{
+				commandList.Draw(66, i);
+			}
+		}
+
+		commandList.ResetScissor();
+		commandList.SetRenderTarget(RenderCommandList::BackBuffer);
+	}
+
+	// The game's frame: the cached brick layer, then the powerups, bar and ball, which share the shape pipeline but each
+	// bring their own mesh.
+	void RecordGameFrame(RenderCommandList& commandList, const Resources& resources, uint32_t powerupCount)
+	{
+		Matrix wvp = {};
+		Color color = {};
+		uint32_t drawIndex = 0;
+
+		commandList.Clear();
+		commandList.SetLayer(0);
+		commandList.SetPipeline(resources.Pipelines[0]);
+		commandList.SetMesh(resources.Meshes[0]);
+		commandList.SetConstants(ShaderStage::Vertex, wvp);
+		commandList.SetTexture(resources.Offscreen);
+		commandList.Draw(4, drawIndex++);
+
+		commandList.SetLayer(1);
+		for (uint32_t i = 0; i < powerupCount + 2; ++i)
+		{
+			// Powerups first, then the bar and the ball, as the managers record them.
+			const uint32_t mesh = (i < powerupCount ? 1 : 2 + (i - powerupCount));
+			commandList.SetPipeline(resources.Pipelines[1]);
+			commandList.SetMesh(resources.Meshes[mesh]);
+			commandList.SetConstants(ShaderStage::Vertex, wvp);
+			commandList.SetConstants(ShaderStage::Pixel, color);
+			commandList.Draw(66, drawIndex++);
+		}
+	}
+
+	// Draw indices of the parts of a frame that redraws the brick layer.
+	struct LayerUpdateFrame
+	{
+		uint32_t LayerUpdateDraw;
+		uint32_t CompositeDraw;
+		uint32_t ParticleDraw;
+	};
+
+	// A frame in which the brick layer is redrawn, so ChunkManager binds its render target and the back buffer again.
+	// Both are barriers the sorter doesn't sort across, so GameMain records every component's offscreen draws first; the
+	// back buffer draws follow in component order, with the powerups ahead of ChunkManager's composite, and are placed
+	// by their layers alone.
+	LayerUpdateFrame RecordLayerUpdateFrame(RenderCommandList& commandList, const Resources& resources)
+	{
+		const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		const uint32_t instances[4] = { 1, 2, 3, 4 };
+		Matrix wvp = {};
+		Color color = {};
+		uint32_t drawIndex = 0;
+		LayerUpdateFrame frame = {};
+
+		auto recordShape = [&](uint32_t mesh)
+		{
+			commandList.SetLayer(1);
+			commandList.SetPipeline(resources.Pipelines[1]);
+			commandList.SetMesh(resources.Meshes[mesh]);
+			commandList.SetConstants(ShaderStage::Vertex, wvp);
+			commandList.SetConstants(ShaderStage::Pixel, color);
+			commandList.Draw(66, drawIndex++);
+		};
+
+		commandList.Clear();
+
+		// ChunkManager::RecordOffscreenDraws
+		commandList.SetLayer(0);
+		commandList.SetRenderTarget(resources.Offscreen);
+		commandList.SetPipeline(resources.Pipelines[2]);
+		commandList.SetMesh(resources.Meshes[3]);
+		commandList.SetConstants(ShaderStage::Vertex, wvp);
+		commandList.ClearRenderTarget(clearColor);
+		frame.LayerUpdateDraw = drawIndex;
+		commandList.DrawInstanced(6, 4, drawIndex++);
+		commandList.SetRenderTarget(RenderCommandList::BackBuffer);
+
+		// PowerupManager, ChunkManager and ParticleManager, then the bar and the ball.
+		recordShape(1);
+
+		commandList.SetLayer(0);
+		commandList.SetPipeline(resources.Pipelines[0]);
+		commandList.SetMesh(resources.Meshes[0]);
+		commandList.SetConstants(ShaderStage::Vertex, wvp);
+		commandList.SetTexture(resources.Offscreen);
+		frame.CompositeDraw = drawIndex;
+		commandList.Draw(4, drawIndex++);
+
+		commandList.SetLayer(2);
+		commandList.SetPipeline(resources.Pipelines[3]);
+		commandList.SetMesh(resources.Meshes[4]);
+		commandList.UpdateInstances(instances, 4);
+		commandList.SetConstants(ShaderStage::Vertex, wvp);
+		frame.ParticleDraw = drawIndex;
+		commandList.DrawInstanced(4, 4, drawIndex++);
+
+		recordShape(2);
+		recordShape(2);
+
+		return frame;
+	}
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool SameConstants(const RecordingRenderBackend& sourceBackend, uint32_t sourceOffset, const RecordingRenderBackend& sortedBackend, uint32_t sortedOffset, size_t size)
+	{
+		// A draw recorded before any constants were set for the stage doesn't read them.
+		if (sourceOffset == RecordingRenderBackend::NoConstants)
+		{
+			return true;
+		}
+
+		if (sortedOffset == RecordingRenderBackend::NoConstants)
+		{
+			return false;
+		}
+
+		return (memcmp(sourceBackend.ConstantData(sourceOffset), sortedBackend.ConstantData(sortedOffset), size) == 0);
+	}
+
+	// What the sorter must keep for each draw in the source list, by the draw's StartVertex. An instance update for a mesh
+	// already drawn in the segment starts a new segment. A draw's texture is the one set since its pipeline was bound.
+	struct SourceDraw
+	{
+		uint32_t Segment;
+		RenderTargetHandle Texture;
+	};
+
+	vector<SourceDraw> SourceDraws(const RenderCommandList& source)
+	{
+		vector<SourceDraw> draws;
+		vector<MeshHandle> segmentMeshes;
+		MeshHandle mesh = RenderCommandList::InvalidMesh;
+		RenderTargetHandle texture = RenderCommandList::BackBuffer;
+		uint32_t segment = 0;
+		const RenderCommand* commands = source.Commands();
+		for (size_t i = 0; i < source.CommandCount(); ++i)
+		{
+			const RenderCommand& command = commands[i];
+			switch (command.Type)
+			{
+			case RenderCommandType::SetRenderTarget:
+				texture = RenderCommandList::BackBuffer;
+				++segment;
+				segmentMeshes.clear();
+				break;
+
+			case RenderCommandType::ClearRenderTarget:
+			case RenderCommandType::SetScissor:
+				++segment;
+				segmentMeshes.clear();
+				break;
+
+			case RenderCommandType::SetPipeline:
+				texture = RenderCommandList::BackBuffer;
+				break;
+
+			case RenderCommandType::SetTexture:
+				texture = command.Target;
+				break;
+
+			case RenderCommandType::SetMesh:
+				mesh = command.Mesh;
+				break;
+
+			case RenderCommandType::UpdateInstances:
+				if (find(segmentMeshes.begin(), segmentMeshes.end(), mesh) != segmentMeshes.end())
+				{
+					++segment;
+					segmentMeshes.clear();
+				}
+				break;
+
+			case RenderCommandType::Draw:
+			case RenderCommandType::DrawInstanced:
+			{
+				if (draws.size() <= command.StartVertex)
+				{
+					draws.resize(command.StartVertex + 1);
+				}
+
+				const SourceDraw draw = { segment, texture };
+				draws[command.StartVertex] = draw;
+				segmentMeshes.push_back(mesh);
+				break;
+			}
+
+			default:
+				break;
+			}
+		}
+
+		return draws;
+	}
+
+	// Each list is replayed on its own backend; both were given the same resources.
+	bool Verify(const RenderCommandList& source, const RenderCommandList& sorted, RecordingRenderBackend& sourceBackend, RecordingRenderBackend& sortedBackend)
+	{
+		sourceBackend.Execute(source);
+		sortedBackend.Execute(sorted);
+
+		const vector<RecordingRenderBackend::DrawRecord>& sourceDraws = sourceBackend.Draws();
+		const vector<RecordingRenderBackend::DrawRecord>& sortedDraws = sortedBackend.Draws();
+		bool passed = Check(sourceDraws.size() == sortedDraws.size(), "the sorted list has every draw");
+		passed &= Check(sourceBackend.LastExecution().InstanceUpdates == sortedBackend.LastExecution().InstanceUpdates, "instance updates are kept");
+		passed &= Check(sourceBackend.LastExecution().Clears == sortedBackend.LastExecution().Clears, "clears are kept");
+		if (!passed)
+		{
+			return false;
+		}
+
+		vector<const RecordingRenderBackend::DrawRecord*> byIndex(sourceDraws.size(), nullptr);
+		for (const RecordingRenderBackend::DrawRecord& draw : sourceDraws)
+		{
+			byIndex[draw.StartVertex] = &draw;
+		}
+
+		const vector<SourceDraw> expected = SourceDraws(source);
+		vector<bool> seen(sourceDraws.size(), false);
+		for (size_t i = 0; i < sortedDraws.size() && passed; ++i)
+		{
+			const RecordingRenderBackend::DrawRecord& draw = sortedDraws[i];
+			passed &= Check(draw.StartVertex < byIndex.size() && !seen[draw.StartVertex], "each draw appears once");
+			if (!passed)
+			{
+				break;
+			}
+
+			seen[draw.StartVertex] = true;
+			const RecordingRenderBackend::DrawRecord& original = *byIndex[draw.StartVertex];
+			passed &= Check(draw.Pipeline == original.Pipeline && draw.Mesh == original.Mesh && draw.Layer == original.Layer &&
+				draw.VertexCount == original.VertexCount && draw.InstanceCount == original.InstanceCount, "draws keep their state");
+			passed &= Check(draw.RenderTarget == original.RenderTarget && SameConstants(sourceBackend, original.Scissor, sortedBackend, draw.Scissor, sizeof(PixelRect)),
+				"draws keep their render target and scissor");
+			const RenderTargetHandle texture = expected[draw.StartVertex].Texture;
+			passed &= Check(texture == RenderCommandList::BackBuffer || draw.Texture == texture, "draws keep their texture");
+			passed &= Check(SameConstants(sourceBackend, original.VertexConstants, sortedBackend, draw.VertexConstants, sizeof(Matrix)) &&
+				SameConstants(sourceBackend, original.PixelConstants, sortedBackend, draw.PixelConstants, sizeof(Color)), "draws keep their constants");
+
+			if (i > 0)
+			{
+				const RecordingRenderBackend::DrawRecord& previous = sortedDraws[i - 1];
+				const uint32_t segment = expected[draw.StartVertex].Segment;
+				const uint32_t previousSegment = expected[previous.StartVertex].Segment;
+				passed &= Check(previousSegment <= segment, "draws stay between their barriers");
+				if (previousSegment == segment)
+				{
+					const uint64_t key = DrawSorter::SortKey(draw.Layer, draw.Pipeline, texture, draw.Mesh);
+					const uint64_t previousKey = DrawSorter::SortKey(previous.Layer, previous.Pipeline, expected[previous.StartVertex].Texture, previous.Mesh);
+					passed &= Check(previousKey < key || (previousKey == key && previous.StartVertex < draw.StartVertex), "segments are sorted and stable");
+				}
+			}
+		}
+
+		return passed;
+	}
+
+	void PrintCounters(const char* name, const DrawSorter::Counters& counters)
+	{
+		printf("%-14s %8llu draws  %6llu segments  state changes %8llu -> %-8llu avoided: pipeline %lld, mesh %lld, texture %lld, constants %lld\n", name,
+			static_cast<unsigned long long>(counters.Draws), static_cast<unsigned long long>(counters.Segments),
+			static_cast<unsigned long long>(counters.StateChangesBefore), static_cast<unsigned long long>(counters.StateChangesAfter),
+			static_cast<long long>(counters.PipelineChangesAvoided), static_cast<long long>(counters.MeshChangesAvoided),
+			static_cast<long long>(counters.TextureChangesAvoided), static_cast<long long>(counters.ConstantUpdatesAvoided));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t drawCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 100000);
+	const uint32_t repetitions = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 50);
+
+	RecordingRenderBackend sourceBackend;
+	RecordingRenderBackend sortedBackend;
+	const Resources resources = CreateResources(sourceBackend);
+	CreateResources(sortedBackend);
+
+	RenderCommandList source(drawCount * 6 + 64, drawCount * 96 + 1024);
+	RenderCommandList sorted(drawCount * 6 + 64, drawCount * 96 + 1024);
+	DrawSorter sorter;
+	bool passed = true;
+
+	// The game's frame, with and without powerups on screen.
+	for (uint32_t powerups = 0; powerups <= 3; powerups += 3)
+	{
+		RecordGameFrame(source, resources, powerups);
+		sorter.Sort(source, sorted);
+		passed &= Verify(source, sorted, sourceBackend, sortedBackend);
+		PrintCounters(powerups == 0 ? "game" : "game+powerups", sorter.LastSort());
+	}
+
+	// A frame that redraws the brick layer, recorded in GameMain's order: every back buffer draw lands over the composite.
+	{
+		const LayerUpdateFrame frame = RecordLayerUpdateFrame(source, resources);
+		sorter.Sort(source, sorted);
+		passed &= Verify(source, sorted, sourceBackend, sortedBackend);
+
+		const vector<RecordingRenderBackend::DrawRecord>& draws = sortedBackend.Draws();
+		bool shapesBetween = (draws.size() == 6);
+		for (size_t i = 2; i + 1 < draws.size(); ++i)
+		{
+			const uint32_t draw = draws[i].StartVertex;
+			shapesBetween &= (draw != frame.LayerUpdateDraw && draw != frame.CompositeDraw && draw != frame.ParticleDraw);
+		}
+
+		passed &= Check(draws.size() == 6 && draws[0].StartVertex == frame.LayerUpdateDraw && draws[1].StartVertex == frame.CompositeDraw,
+			"the brick layer is redrawn, then composited ahead of the other back buffer draws");
+		passed &= Check(shapesBetween, "powerups, bar and ball draw over the composited bricks");
+		passed &= Check(!draws.empty() && draws.back().StartVertex == frame.ParticleDraw, "particles draw last");
+	}
+
+	// Random frames of every size up to a few hundred draws exercise the edge cases.
+	for (uint32_t draws = 0; draws < 300 && passed; draws += 7)
+	{
+		RecordRandomFrame(source, resources, draws, draws);
+		sorter.Sort(source, sorted);
+		passed &= Verify(source, sorted, sourceBackend, sortedBackend);
+	}
+
+	RecordRandomFrame(source, resources, drawCount, 12345);
+	sorter.Sort(source, sorted);
+	passed &= Verify(source, sorted, sourceBackend, sortedBackend);
+	PrintCounters("random", sorter.LastSort());
+
+	// Timing: the sorter against a stable comparison sort of the same keys.
+	sorter.ResetCounters();
+	const auto sortStart = chrono::steady_clock::now();
+	for (uint32_t i = 0; i < repetitions; ++i)
+	{
+		sorter.Sort(source, sorted);
+	}
+	const double sortSeconds = chrono::duration<double>(chrono::steady_clock::now() - sortStart).count() / repetitions;
+
+	vector<uint64_t> keys;
+	const vector<SourceDraw> sourceDraws = SourceDraws(source);
+	sourceBackend.Execute(source);
+	for (const RecordingRenderBackend::DrawRecord& draw : sourceBackend.Draws())
+	{
+		keys.push_back(DrawSorter::SortKey(draw.Layer, draw.Pipeline, sourceDraws[draw.StartVertex].Texture, draw.Mesh));
+	}
+
+	vector<uint64_t> scratch;
+	const auto stableStart = chrono::steady_clock::now();
+	for (uint32_t i = 0; i < repetitions; ++i)
+	{
+		scratch = keys;
+		stable_sort(scratch.begin(), scratch.end());
+	}
+	const double stableSeconds = chrono::duration<double>(chrono::steady_clock::now() - stableStart).count() / repetitions;
+
+	printf("\n%u draws, %zu commands recorded, %zu after sorting\n", drawCount, source.CommandCount(), sorted.CommandCount());
+	printf("sort and resubmit: %.3f ms (%.1f ns/draw)\n", sortSeconds * 1000.0, sortSeconds / (drawCount > 0 ? drawCount : 1) * 1.0e9);
+	printf("std::stable_sort of the keys alone: %.3f ms\n", stableSeconds * 1000.0);
+
+	printf("%s\n", (passed ? "checks passed" : "checks FAILED"));
+	return (passed ? 0 : 1);
+}
@@ -0,0 +1,512 @@
+// Bakes the printable ASCII characters of a TrueType font into a glyph atlas for GlyphFont and GlyphText, so the game
+// draws its score and statistics as sprites instead of laying text out with DirectWrite every time it changes. The
+// glyphs are rendered with FreeType at one pixel size, each with a transparent one-pixel border, packed with AtlasPacker
+// and written as <output>.dds (white R8G8B8A8 with coverage in alpha, with mips filtered by TextureProcessor) and
+// <output>.glyphs (the glyph table). The game's font is baked from DejaVu Sans, whose license allows it:
+//   FontBaker /usr/share/fonts/truetype/dejavu/DejaVuSans.ttf ../../Game.Universal/Content/Fonts/dejavu_sans_32
+//
+// With --benchmark, bakes the font and runs the text path on the CPU: the glyph table round-trips through the
+// AssetLoader, the game's score and statistics text is laid out and drawn into a SoftwareRenderBackend through one
+// SpriteBatch, and the cost of an unchanged frame, a changed value and drawing is reported. The checks:
+//   - every glyph round-trips, characters outside the table fall back to '?', and digits share one advance, so a changing
+//     number doesn't shift the text around it;
+//   - setting the same text again keeps the layout, and changing the text or the font redoes it;
+//   - lines break at '\n', right-aligned lines end at the block's right edge, and the block is a line height per line;
+//   - all the text goes out in one draw, and text drawn on whole pixels matches its glyphs' bitmaps composited directly.
+//
+// Needs FreeType, e.g. from this directory on Linux:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared -I/usr/include/freetype2 FontBaker.cpp ../../Library.Shared/GlyphFont.cpp ../../Library.Shared/GlyphText.cpp ../../Library.Shared/AssetLoader.cpp ../../Library.Shared/AtlasPacker.cpp ../../Library.Shared/TextureProcessor.cpp ../../Library.Shared/DdsTexture.cpp ../../Library.Shared/SpriteBatch.cpp ../../Library.Shared/SoftwareRenderBackend.cpp ../../Library.Shared/RenderCommandList.cpp -lfreetype
+//
+// Usage: FontBaker [--size N] [--padding N] font.ttf output
+//        FontBaker --benchmark [font.ttf]
+// Defaults to 32 pixels, 2 pixels between glyphs and, for the benchmark, the DejaVu Sans the game's font is baked from.
+
+#include "AssetLoader.h"
+#include "AtlasPacker.h"
+#include "DdsTexture.h"
+#include "GlyphFont.h"
+#include "GlyphText.h"
+#include "SoftwareRenderBackend.h"
+#include "SpriteBatch.h"
+#include "TextureProcessor.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	const char* const DefaultFontPath = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+	const uint32_t FirstCharacter = 32;
+	const uint32_t LastCharacter = 126;
+	const uint32_t DefaultPixelSize = 32;
+	const uint32_t DefaultPadding = 2;
+
+	struct BakedFont
+	{
+		TextureProcessor::Image Page;
+		vector<GlyphFont::Glyph> Glyphs;
+		float LineHeight;
+		float Ascent;
+	};
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool WriteFile(const string& path, const vector<uint8_t>& data)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const bool written = (fwrite(data.data(), 1, data.size(), file) == data.size());
+		return (fclose(file) == 0 && written);
+	}
+
+	// Renders every character with FreeType and packs the bitmaps onto one page. Throws std::runtime_error on failure.
+	BakedFont Bake(const string& fontPath, uint32_t pixelSize, uint32_t padding)
+	{
+		FT_Library library;
+		if (FT_Init_FreeType(&library) != 0)
+		{
+			throw runtime_error("FreeType didn't initialize");
+		}
+
+		FT_Face face;
+		if (FT_New_Face(library, fontPath.c_str(), 0, &face) != 0 || FT_Set_Pixel_Sizes(face, 0, pixelSize) != 0)
+		{
+			FT_Done_FreeType(library);
+			throw runtime_error("Can't load " + fontPath);
+		}
+
+		// Each bitmap gets a transparent border, so the quads drawn from it fade out inside their edges when scaled.
+		vector<TextureProcessor::Image> bitmaps;
+		vector<AtlasPacker::Size> sizes;
+		BakedFont font;
+		for (uint32_t character = FirstCharacter; character <= LastCharacter; ++character)
+		{
+			if (FT_Load_Char(face, character, FT_LOAD_RENDER) != 0)
+			{
+				FT_Done_Face(face);
+				FT_Done_FreeType(library);
+				throw runtime_error("Can't render character " + to_string(character));
+			}
+
+			const FT_GlyphSlot slot = face->glyph;
+			const FT_Bitmap& bitmap = slot->bitmap;
+			const bool blank = (bitmap.width == 0 || bitmap.rows == 0);
+			TextureProcessor::Image image = { (blank ? 0 : bitmap.width + 2), (blank ? 0 : bitmap.rows + 2), vector<uint8_t>() };
+			image.Pixels.assign(static_cast<size_t>(image.Width) * image.Height * 4, 255);
+			for (size_t i = 3; i < image.Pixels.size(); i += 4)
+			{
+				image.Pixels[i] = 0;
+			}
+
+			for (uint32_t y = 0; y < bitmap.rows; ++y)
+			{
+				for (uint32_t x = 0; x < bitmap.width; ++x)
+				{
+					image.Pixels[((static_cast<size_t>(y) + 1) * image.Width + x + 1) * 4 + 3] = bitmap.buffer[static_cast<ptrdiff_t>(y) * bitmap.pitch + x];
+				}
+			}
+
+			GlyphFont::Glyph glyph = {};
+			glyph.Left = static_cast<float>(slot->bitmap_left - 1);
+			glyph.Top = static_cast<float>(-slot->bitmap_top - 1);
+			glyph.Width = static_cast<float>(image.Width);
+			glyph.Height = static_cast<float>(image.Height);
+			glyph.Advance = static_cast<float>(slot->advance.x) / 64.0f;
+			font.Glyphs.push_back(glyph);
+
+			const AtlasPacker::Size size = { max(image.Width, 1u), max(image.Height, 1u) };
+			sizes.push_back(size);
+			bitmaps.push_back(move(image));
+		}
+
+		font.LineHeight = static_cast<float>(face->size->metrics.height) / 64.0f;
+		font.Ascent = static_cast<float>(face->size->metrics.ascender) / 64.0f;
+		FT_Done_Face(face);
+		FT_Done_FreeType(library);
+
+		AtlasPacker packer(AtlasPacker::DefaultMaxPageSize, padding);
+		if (!packer.Pack(sizes.data(), static_cast<uint32_t>(sizes.size())) || packer.Pages().size() != 1)
+		{
+			throw runtime_error("The glyphs don't fit on one page");
+		}
+
+		// Transparent white, so filtering at a glyph's edge fades its alpha without darkening its color.
+		const AtlasPacker::Size pageSize = packer.Pages()[0];
+		font.Page = { pageSize.Width, pageSize.Height, vector<uint8_t>(static_cast<size_t>(pageSize.Width) * pageSize.Height * 4, 255) };
+		for (size_t i = 3; i < font.Page.Pixels.size(); i += 4)
+		{
+			font.Page.Pixels[i] = 0;
+		}
+
+		const float width = static_cast<float>(pageSize.Width);
+		const float height = static_cast<float>(pageSize.Height);
+		for (size_t i = 0; i < bitmaps.size(); ++i)
+		{
+			const AtlasPacker::Placement& placement = packer.Placements()[i];
+			const TextureProcessor::Image& bitmap = bitmaps[i];
+			for (uint32_t y = 0; y < bitmap.Height; ++y)
+			{
+				memcpy(&font.Page.Pixels[((static_cast<size_t>(placement.Y) + y) * pageSize.Width + placement.X) * 4], &bitmap.Pixels[static_cast<size_t>(y) * bitmap.Width * 4], bitmap.Width * 4);
+			}
+
+			GlyphFont::Glyph& glyph = font.Glyphs[i];
+			glyph.U0 = static_cast<float>(placement.X) / width;
+			glyph.V0 = static_cast<float>(placement.Y) / height;
+			glyph.U1 = static_cast<float>(placement.X + bitmap.Width) / width;
+			glyph.V1 = static_cast<float>(placement.Y + bitmap.Height) / height;
+		}
+
+		return font;
+	}
+
+	vector<uint8_t> GlyphTable(const BakedFont& font, uint32_t pixelSize)
+	{
+		return GlyphFont::Serialize(FirstCharacter, font.Glyphs, font.Page.Width, font.Page.Height, static_cast<float>(pixelSize), font.LineHeight, font.Ascent);
+	}
+
+	int BakeFont(const string& fontPath, const string& output, uint32_t pixelSize, uint32_t padding)
+	{
+		BakedFont font;
+		try
+		{
+			font = Bake(fontPath, pixelSize, padding);
+		}
+		catch (const exception& error)
+		{
+			printf("%s\n", error.what());
+			return 1;
+		}
+
+		vector<TextureProcessor::Image> mips;
+		TextureProcessor::GenerateMips(font.Page.Pixels.data(), font.Page.Width, font.Page.Height, false, mips);
+		vector<vector<uint8_t>> levels;
+		for (TextureProcessor::Image& mip : mips)
+		{
+			levels.push_back(move(mip.Pixels));
+		}
+
+		const vector<uint8_t> texture = DdsTexture::Serialize(DdsTexture::R8G8B8A8UNorm, font.Page.Width, font.Page.Height, levels);
+		if (!WriteFile(output + ".dds", texture) || !WriteFile(output + ".glyphs", GlyphTable(font, pixelSize)))
+		{
+			printf("Can't write %s\n", output.c_str());
+			return 1;
+		}
+
+		printf("%s: %zu glyphs at %u pixels on a %u x %u page, %zu levels, %zu bytes\n", output.c_str(), font.Glyphs.size(), pixelSize,
+			font.Page.Width, font.Page.Height, levels.size(), texture.size());
+		return 0;
+	}
+
+	// Pixel coordinates (y down) of a width x height target to clip space, transposed as the D3D11 components upload it.
+	void PixelProjection(uint32_t width, uint32_t height, float (&matrix)[16])
+	{
+		memset(matrix, 0, sizeof(matrix));
+		matrix[0] = 2.0f / static_cast<float>(width);
+		matrix[3] = -1.0f;
+		matrix[5] = -2.0f / static_cast<float>(height);
+		matrix[7] = 1.0f;
+		matrix[10] = 1.0f;
+		matrix[15] = 1.0f;
+	}
+
+	// Composites each laid-out glyph's bitmap over black at whole pixels, as drawing it at scale 1 should.
+	vector<uint8_t> CompositeDirectly(const BakedFont& baked, const GlyphFont& font, const char* text, uint32_t width, uint32_t height, int32_t x, int32_t y)
+	{
+		vector<uint8_t> coverage(static_cast<size_t>(width) * height);
+		float pen = 0.0f;
+		for (const char* character = text; *character != '\0'; ++character)
+		{
+			const GlyphFont::Glyph& glyph = *font.Find(*character);
+			const int32_t left = x + static_cast<int32_t>(floor(pen + glyph.Left + 0.5f));
+			const int32_t top = y + static_cast<int32_t>(floor(font.Ascent() + glyph.Top + 0.5f));
+			const int32_t u = static_cast<int32_t>(glyph.U0 * static_cast<float>(baked.Page.Width) + 0.5f);
+			const int32_t v = static_cast<int32_t>(glyph.V0 * static_cast<float>(baked.Page.Height) + 0.5f);
+			for (int32_t row = 0; row < static_cast<int32_t>(glyph.Height); ++row)
+			{
+				for (int32_t column = 0; column < static_cast<int32_t>(glyph.Width); ++column)
+				{
+					const uint32_t alpha = baked.Page.Pixels[(static_cast<size_t>(v + row) * baked.Page.Width + static_cast<size_t>(u + column)) * 4 + 3];
+					uint8_t& destination = coverage[static_cast<size_t>(top + row) * width + static_cast<size_t>(left + column)];
+					destination = static_cast<uint8_t>((255 * alpha + destination * (255 - alpha) + 127) / 255);
+				}
+			}
+
+			pen += glyph.Advance;
+		}
+
+		return coverage;
+	}
+
+	bool Checks(const BakedFont& baked, const GlyphFont& font)
+	{
+		bool passed = true;
+
+		bool roundTrip = (font.TextureWidth() == baked.Page.Width && font.TextureHeight() == baked.Page.Height && font.LineHeight() == baked.LineHeight);
+		for (uint32_t character = FirstCharacter; character <= LastCharacter; ++character)
+		{
+			roundTrip &= (memcmp(font.Find(static_cast<char>(character)), &baked.Glyphs[character - FirstCharacter], sizeof(GlyphFont::Glyph)) == 0);
+		}
+
+		passed &= Check(roundTrip, "every glyph round-trips through the glyph table");
+		passed &= Check(font.Find('\x01') == font.Find('?') && font.Find('\x7F') == font.Find('?') && font.Find('\xE9') == font.Find('?'), "characters outside the table fall back to '?'");
+
+		bool sharedAdvance = true;
+		for (char digit = '1'; digit <= '9'; ++digit)
+		{
+			sharedAdvance &= (font.Find(digit)->Advance == font.Find('0')->Advance);
+		}
+
+		passed &= Check(sharedAdvance, "digits share one advance");
+
+		GlyphText text;
+		passed &= Check(text.SetText("1234") && text.Layout(font), "new text is laid out");
+		passed &= Check(!text.SetText("1234") && !text.Layout(font), "the same text keeps its layout");
+		passed &= Check(text.GlyphCount() == 4 && text.Width() == 4.0f * font.Find('0')->Advance && text.Height() == font.LineHeight(), "one line is as wide as its advances");
+		passed &= Check(text.SetText("1235") && text.Layout(font) && text.GlyphCount() == 4, "changed text is laid out again");
+
+		const vector<uint8_t> table = GlyphTable(baked, static_cast<uint32_t>(font.PixelSize()));
+		AssetLoader loader;
+		const string path = "FontBakerCheck.glyphs";
+		WriteFile(path, table);
+		GlyphFont otherFont(loader.LoadAsync(path).get());
+		remove(path.c_str());
+		passed &= Check(text.Layout(otherFont) && !text.Layout(otherFont), "a different font is laid out again");
+
+		// The block is as wide as its widest line, spaces included, and a line height per line, empty ones too.
+		GlyphText rightAligned(GlyphText::Alignment::Right);
+		rightAligned.SetText("1\n 22\n");
+		rightAligned.Layout(font);
+		passed &= Check(rightAligned.Width() == font.Find(' ')->Advance + 2.0f * font.Find('2')->Advance && rightAligned.Height() == 3.0f * font.LineHeight() &&
+			rightAligned.GlyphCount() == 3, "lines break at '\\n' and the block spans them");
+
+		SoftwareRenderBackend backend(256, 192);
+		SpriteBatch batch;
+		const SpriteTextureHandle texture = backend.CreateTexture(baked.Page.Width, baked.Page.Height, baked.Page.Pixels.data(), baked.Page.Width * 4);
+		float projection[16];
+		PixelProjection(256, 192, projection);
+		backend.SetSpriteViewProjection(projection);
+
+		const char* const digits = "0123456789";
+		GlyphText score;
+		score.SetText(digits);
+		score.Layout(font);
+		batch.Begin(backend);
+		score.Draw(batch, texture, 7.0f, 5.0f);
+		GlyphText sevens(GlyphText::Alignment::Right);
+		sevens.SetText("7\n77");
+		sevens.Layout(font);
+		sevens.Draw(batch, texture, 100.0f, 60.0f);
+		batch.End();
+		passed &= Check(batch.LastStatistics().Draws == 1 && batch.LastStatistics().Sprites == 13, "all the text goes out in one draw");
+
+		// Right-aligned, the first line's 7 is drawn right above the second line's last 7.
+		const uint32_t lineHeight = static_cast<uint32_t>(font.LineHeight());
+		const uint32_t secondSeven = 100 + static_cast<uint32_t>(font.Find('7')->Advance);
+		bool aligned = (font.LineHeight() == static_cast<float>(lineHeight));
+		uint32_t sevenInk = 0;
+		for (uint32_t y = 60; y < 60 + lineHeight; ++y)
+		{
+			for (uint32_t x = secondSeven; x < 256; ++x)
+			{
+				const uint32_t above = backend.Pixels()[static_cast<size_t>(y) * backend.RowPitch() + x];
+				aligned &= (above == backend.Pixels()[static_cast<size_t>(y + lineHeight) * backend.RowPitch() + x]);
+				sevenInk += ((above & 0xFF) > 128 ? 1 : 0);
+			}
+		}
+
+		passed &= Check(aligned && sevenInk > 10, "right-aligned lines end at the block's right edge");
+
+		// Against black, the drawn red channel is the glyphs' composited coverage.
+		const vector<uint8_t> expected = CompositeDirectly(baked, font, digits, 256, 128, 7, 5);
+		uint32_t largest = 0;
+		uint32_t inked = 0;
+		for (uint32_t y = 0; y < 50; ++y)
+		{
+			for (uint32_t x = 0; x < 256; ++x)
+			{
+				const uint32_t drawn = backend.Pixels()[static_cast<size_t>(y) * backend.RowPitch() + x] & 0xFF;
+				largest = max(largest, static_cast<uint32_t>(abs(static_cast<int32_t>(drawn) - expected[static_cast<size_t>(y) * 256 + x])));
+				inked += (drawn > 128 ? 1 : 0);
+			}
+		}
+
+		passed &= Check(largest <= 2 && inked > 100, "text drawn on whole pixels matches its glyphs' bitmaps");
+		return passed;
+	}
+
+	// The game's text: the score, and the frame statistics block FpsTextRenderer shows.
+	void Benchmark(const BakedFont& baked, const GlyphFont& font)
+	{
+		const uint32_t frames = 100000;
+		GlyphText score(GlyphText::Alignment::Right);
+		GlyphText statistics(GlyphText::Alignment::Right, 512);
+		const char* const statisticsText = "60 FPS\nframe 16.67 / 16.90 / 17.20 / 18.01 ms\nupdate 0.41 / 0.62 / 0.80 / 1.20 ms\n"
+			"render 1.10 / 1.52 / 1.90 / 2.31 ms\npresent 14.20 / 15.01 / 15.60 / 16.10 ms\ntext 0.01 / 0.01 / 0.02 / 0.03 ms";
+		statistics.SetText(statisticsText);
+		statistics.Layout(font);
+
+		char buffer[32];
+		auto start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			snprintf(buffer, sizeof(buffer), "%u", frame / 1000);
+			score.SetText(buffer);
+			score.Layout(font);
+		}
+
+		const double mostlyUnchanged = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+
+		start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			snprintf(buffer, sizeof(buffer), "%u", frame);
+			score.SetText(buffer);
+			score.Layout(font);
+		}
+
+		const double alwaysChanged = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+
+		start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames / 100; ++frame)
+		{
+			statistics.SetText(frame % 2 == 1 ? statisticsText : "60 FPS");
+			statistics.Layout(font);
+		}
+
+		const double statisticsRelayout = chrono::duration<double>(chrono::steady_clock::now() - start).count() / (frames / 100);
+
+		// Drawing into a ring as large as D3D11SpriteBatchTarget's, without rasterizing.
+		struct CountingTarget : SpriteBatchTarget
+		{
+			vector<SpriteInstance> Instances = vector<SpriteInstance>(64 * 1024);
+			uint32_t Written = 0;
+
+			virtual SpriteInstance* Map(uint32_t& capacity, uint32_t& firstInstance) override
+			{
+				if (Written == Instances.size())
+				{
+					Written = 0;
+				}
+
+				capacity = static_cast<uint32_t>(Instances.size()) - Written;
+				firstInstance = Written;
+				return &Instances[Written];
+			}
+
+			virtual void Unmap(uint32_t instanceCount) override
+			{
+				Written += instanceCount;
+			}
+
+			virtual void DrawBatch(SpriteTextureHandle, uint32_t, uint32_t) override
+			{
+			}
+		};
+
+		CountingTarget target;
+		SpriteBatch batch;
+		start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			batch.Begin(target);
+			score.Draw(batch, 0, 1500.0f, 200.0f);
+			statistics.Draw(batch, 0, 1920.0f - statistics.Width() * 0.5f, 1080.0f - statistics.Height() * 0.5f, 0.5f);
+			batch.End();
+		}
+
+		const double drawing = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+		const uint32_t glyphs = score.GlyphCount() + statistics.GlyphCount();
+
+		printf("font: %zu glyphs at %.0f pixels on a %u x %u page\n", baked.Glyphs.size(), font.PixelSize(), font.TextureWidth(), font.TextureHeight());
+		printf("score, changing once in 1000 frames: %.1f ns per frame\n", mostlyUnchanged * 1.0e9);
+		printf("score, changing every frame: %.1f ns per frame\n", alwaysChanged * 1.0e9);
+		printf("statistics block relayout (%u glyphs): %.2f us\n", statistics.GlyphCount(), statisticsRelayout * 1.0e6);
+		printf("drawing score and statistics (%u glyphs, %llu draw): %.2f us per frame, %.1f ns per glyph\n", glyphs,
+			static_cast<unsigned long long>(batch.LastStatistics().Draws), drawing * 1.0e6, drawing * 1.0e9 / glyphs);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+	{
+		const string fontPath = (argc > 2 ? argv[2] : DefaultFontPath);
+		BakedFont baked;
+		try
+		{
+			baked = Bake(fontPath, DefaultPixelSize, DefaultPadding);
+		}
+		catch (const exception& error)
+		{
+			printf("%s\n", error.what());
+			return 1;
+		}
+
+		const string path = "FontBakerBenchmark.glyphs";
+		if (!WriteFile(path, GlyphTable(baked, DefaultPixelSize)))
+		{
+			printf("Can't write %s\n", path.c_str());
+			return 1;
+		}
+
+		AssetLoader loader;
+		const GlyphFont font(loader.LoadAsync(path).get());
+		remove(path.c_str());
+
+		const bool passed = Checks(baked, font);
+		Benchmark(baked, font);
+		printf("%s\n", (passed ? "checks passed" : "checks FAILED"));
+		return (passed ? 0 : 1);
+	}
+
+	uint32_t pixelSize = DefaultPixelSize;
+	uint32_t padding = DefaultPadding;
+	int argument = 1;
+	for (; argument < argc && argv[argument][0] == '-'; ++argument)
+	{
+		if (strcmp(argv[argument], "--size") == 0 && argument + 1 < argc)
+		{
+			pixelSize = static_cast<uint32_t>(strtoul(argv[++argument], nullptr, 10));
+		}
+		else if (strcmp(argv[argument], "--padding") == 0 && argument + 1 < argc)
+		{
+			padding = static_cast<uint32_t>(strtoul(argv[++argument], nullptr, 10));
+		}
+		else
+		{
+			printf("Unknown option %s\n", argv[argument]);
+			return 1;
+		}
+	}
+
+	if (argc - argument != 2 || pixelSize == 0)
+	{
+		printf("Usage: FontBaker [--size N] [--padding N] font.ttf output\n       FontBaker --benchmark [font.ttf]\n");
+		return 1;
+	}
+
+	return BakeFont(argv[argument], argv[argument + 1], pixelSize, padding);
+}
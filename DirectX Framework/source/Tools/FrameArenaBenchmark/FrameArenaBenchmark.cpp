@@ -0,0 +1,338 @@
+// Measures the FrameArena against the heap for the game's per-frame allocation patterns, and checks the arena's
+// guarantees. Each pattern runs a frame at a time, once through ArenaAllocator on a FrameArena flipped every frame and
+// once through the default allocator (new and delete) or malloc and free:
+//   - components: GameMain::Render's list of visible drawables, reserved to the component count and filled;
+//   - strings: the score and statistics lines formatted each frame, longer than the small-string buffer;
+//   - candidates: a collision candidate list grown by push_back without a reserve, as many as there are bricks;
+//   - mixed: 64 raw blocks of 48 to 111 bytes, the size of small event records, against malloc and free.
+// The checks:
+//   - every allocation is aligned as asked and lies in storage no other live allocation uses;
+//   - data allocated in frame N is still intact during frame N + 1, and its storage is reused in frame N + 2;
+//   - a frame larger than the arena spills into overflow blocks, and the next reset grows the arena past it;
+//   - after their first frames the arena patterns make no heap allocations, counted by AllocationTracker;
+//   - each arena pattern is faster than its heap counterpart.
+//
+// Build with allocation tracking on, as debug builds of the game run, so heap allocations are counted.
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -DDX_ALLOCATION_TRACKING_ENABLED=1 -I../../Library.Shared FrameArenaBenchmark.cpp ../../Library.Shared/FrameArena.cpp ../../Library.Shared/AllocationTracker.cpp
+//   cl /O2 /EHsc /DDX_ALLOCATION_TRACKING_ENABLED=1 /I..\..\Library.Shared FrameArenaBenchmark.cpp ..\..\Library.Shared\FrameArena.cpp ..\..\Library.Shared\AllocationTracker.cpp
+//
+// Usage: FrameArenaBenchmark [frames]
+// Defaults to 200000.
+
+#include "AllocationTracker.h"
+#include "FrameArena.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	// GameMain's components, of which the field, particles, powerups, chunks and statistics text are drawn.
+	const uint32_t ComponentCount = 9;
+	const uint32_t VisibleComponentCount = 5;
+	const uint32_t BrickCount = 60;
+	const uint32_t MixedBlockCount = 64;
+	const uint32_t WarmUpFrames = 4;
+
+	struct Component
+	{
+		bool Visible;
+	};
+
+	struct Candidate
+	{
+		uint32_t Brick;
+		float Distance;
+	};
+
+	typedef basic_string<char, char_traits<char>, ArenaAllocator<char>> ArenaString;
+
+	// Kept outside the timed loops so the compiler can't drop the work.
+	volatile uint64_t sSink;
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	template <typename Vector>
+	void GatherComponents(Vector& drawables, Component* components)
+	{
+		drawables.reserve(ComponentCount);
+		for (uint32_t i = 0; i < ComponentCount; ++i)
+		{
+			if (components[i].Visible)
+			{
+				drawables.push_back(&components[i]);
+			}
+		}
+
+		sSink = drawables.size();
+	}
+
+	template <typename String>
+	void FormatStrings(String& score, String& statistics, uint32_t frame)
+	{
+		char digits[16];
+		snprintf(digits, sizeof(digits), "%u", frame * 10);
+		score += "Score: ";
+		score += digits;
+		score += "   Lives: 3   Level: 1";
+
+		snprintf(digits, sizeof(digits), "%u", 60 + frame % 7);
+		statistics += "FPS: ";
+		statistics += digits;
+		statistics += "   frame p50 16.667 ms   p99 17.407 ms   p99.9 33.791 ms";
+		sSink = score.size() + statistics.size();
+	}
+
+	template <typename Vector>
+	void GatherCandidates(Vector& candidates, uint32_t frame)
+	{
+		for (uint32_t brick = 0; brick < BrickCount; ++brick)
+		{
+			if ((brick + frame) % 3 != 0)
+			{
+				candidates.push_back(Candidate{ brick, static_cast<float>(brick) });
+			}
+		}
+
+		sSink = candidates.size();
+	}
+
+	uint32_t MixedSize(uint32_t block)
+	{
+		return 48 + (block * 37) % 64;
+	}
+
+	template <typename Function>
+	double TimeFrames(uint32_t frameCount, Function function)
+	{
+		const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			function(frame);
+		}
+
+		return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / frameCount;
+	}
+
+	// Heap allocations the calling thread made while the function ran.
+	template <typename Function>
+	uint64_t CountAllocations(Function function)
+	{
+		const uint64_t before = AllocationTracker::ThreadAllocationCount();
+		function();
+		return AllocationTracker::ThreadAllocationCount() - before;
+	}
+
+	bool CheckAlignment()
+	{
+		LinearArena arena(4096);
+		bool passed = true;
+		uintptr_t previousEnd = 0;
+		for (size_t alignment = 1; alignment <= 256; alignment *= 2)
+		{
+			for (size_t size = 1; size < 40; size += 13)
+			{
+				const uintptr_t address = reinterpret_cast<uintptr_t>(arena.Allocate(size, alignment));
+				passed &= Check(address % alignment == 0, "allocations are aligned");
+				passed &= Check(address >= previousEnd, "allocations don't overlap");
+				previousEnd = address + size;
+			}
+		}
+
+		// Past the end of the buffer the alignment still holds, in an overflow block.
+		const uintptr_t overflow = reinterpret_cast<uintptr_t>(arena.Allocate(8192, 64));
+		passed &= Check(overflow % 64 == 0 && arena.Used() > arena.Capacity(), "overflow allocations are aligned");
+		return passed;
+	}
+
+	bool CheckDoubleBuffering()
+	{
+		FrameArena frames(1024);
+		bool passed = true;
+
+		frames.BeginFrame();
+		uint32_t* first = frames.Current().Allocate<uint32_t>(64);
+		for (uint32_t i = 0; i < 64; ++i)
+		{
+			first[i] = 0xC0DE0000 + i;
+		}
+
+		// The next frame writes its own data; the previous frame's is still there for a reader one frame behind.
+		frames.BeginFrame();
+		uint32_t* second = frames.Current().Allocate<uint32_t>(64);
+		memset(second, 0xFF, 64 * sizeof(uint32_t));
+		bool intact = true;
+		for (uint32_t i = 0; i < 64; ++i)
+		{
+			intact &= (first[i] == 0xC0DE0000 + i);
+		}
+
+		passed &= Check(intact && second != first, "the previous frame's data survives one frame");
+		passed &= Check(&frames.Previous() != &frames.Current() && frames.Previous().Used() >= 64 * sizeof(uint32_t), "the previous arena is the one written last frame");
+
+		frames.BeginFrame();
+		uint32_t* third = frames.Current().Allocate<uint32_t>(64);
+		passed &= Check(third == first && frames.FrameIndex() == 3, "two frames later the storage is reused");
+		return passed;
+	}
+
+	bool CheckGrowth()
+	{
+		FrameArena frames(256);
+		bool passed = true;
+		for (uint32_t frame = 0; frame < 6; ++frame)
+		{
+			frames.BeginFrame();
+			const uint64_t allocations = CountAllocations([&]()
+			{
+				for (uint32_t block = 0; block < MixedBlockCount; ++block)
+				{
+					memset(frames.Current().Allocate(MixedSize(block), 16), static_cast<int>(block), MixedSize(block));
+				}
+			});
+
+			// Each arena overflows once, then fits its high-water mark.
+			if (frame < 2)
+			{
+				passed &= Check(allocations > 0 && frames.Current().Used() > frames.Current().Capacity(), "a large frame spills into overflow blocks");
+			}
+			else
+			{
+				passed &= Check(allocations == 0 && frames.Current().Used() <= frames.Current().Capacity(), "after growing, the frame fits the arena");
+			}
+		}
+
+		passed &= Check(frames.Current().HighWaterMark() <= frames.Current().Capacity(), "the arena grows past its high-water mark");
+		return passed;
+	}
+
+	// Runs one pattern both ways, checks the arena stops allocating and is faster, and reports both. Only operator new
+	// is counted, not malloc.
+	template <typename ArenaFrame, typename HeapFrame>
+	bool ComparePattern(const char* name, uint32_t frameCount, FrameArena& frames, ArenaFrame arenaFrame, HeapFrame heapFrame, bool heapCounted = true)
+	{
+		for (uint32_t frame = 0; frame < WarmUpFrames; ++frame)
+		{
+			frames.BeginFrame();
+			arenaFrame(frame);
+		}
+
+		const uint64_t arenaAllocations = CountAllocations([&]() { frames.BeginFrame(); arenaFrame(WarmUpFrames); });
+		const uint64_t heapAllocations = CountAllocations([&]() { heapFrame(WarmUpFrames); });
+
+		const double arenaTime = TimeFrames(frameCount, [&](uint32_t frame) { frames.BeginFrame(); arenaFrame(frame); });
+		const double heapTime = TimeFrames(frameCount, heapFrame);
+
+		printf("%-11s  arena %7.1f ns/frame, %llu heap allocations  heap %7.1f ns/frame, %llu heap allocations  %.1fx\n", name, arenaTime,
+			static_cast<unsigned long long>(arenaAllocations), heapTime, static_cast<unsigned long long>(heapAllocations), heapTime / arenaTime);
+
+		bool passed = Check(arenaAllocations == 0, "a steady arena frame makes no heap allocations");
+		passed &= Check(!heapCounted || heapAllocations > 0, "the heap pattern allocates");
+		passed &= Check(arenaTime < heapTime, "the arena is faster than the heap");
+		return passed;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t frameCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 200000);
+
+	bool passed = CheckAlignment();
+	passed &= CheckDoubleBuffering();
+	passed &= CheckGrowth();
+
+	Component components[ComponentCount];
+	for (uint32_t i = 0; i < ComponentCount; ++i)
+	{
+		components[i].Visible = (i >= ComponentCount - VisibleComponentCount);
+	}
+
+	FrameArena frames;
+
+	passed &= ComparePattern("components", frameCount, frames,
+		[&](uint32_t)
+		{
+			vector<Component*, ArenaAllocator<Component*>> drawables{ ArenaAllocator<Component*>(frames.Current()) };
+			GatherComponents(drawables, components);
+		},
+		[&](uint32_t)
+		{
+			vector<Component*> drawables;
+			GatherComponents(drawables, components);
+		});
+
+	passed &= ComparePattern("strings", frameCount, frames,
+		[&](uint32_t frame)
+		{
+			ArenaString score{ ArenaAllocator<char>(frames.Current()) };
+			ArenaString statistics{ ArenaAllocator<char>(frames.Current()) };
+			FormatStrings(score, statistics, frame);
+		},
+		[&](uint32_t frame)
+		{
+			string score;
+			string statistics;
+			FormatStrings(score, statistics, frame);
+		});
+
+	passed &= ComparePattern("candidates", frameCount, frames,
+		[&](uint32_t frame)
+		{
+			vector<Candidate, ArenaAllocator<Candidate>> candidates{ ArenaAllocator<Candidate>(frames.Current()) };
+			GatherCandidates(candidates, frame);
+		},
+		[&](uint32_t frame)
+		{
+			vector<Candidate> candidates;
+			GatherCandidates(candidates, frame);
+		});
+
+	void* blocks[MixedBlockCount];
+	passed &= ComparePattern("mixed", frameCount, frames,
+		[&](uint32_t)
+		{
+			uint64_t sum = 0;
+			for (uint32_t block = 0; block < MixedBlockCount; ++block)
+			{
+				blocks[block] = frames.Current().Allocate(MixedSize(block));
+				sum += reinterpret_cast<uintptr_t>(blocks[block]);
+			}
+
+			sSink = sum;
+		},
+		[&](uint32_t)
+		{
+			uint64_t sum = 0;
+			for (uint32_t block = 0; block < MixedBlockCount; ++block)
+			{
+				blocks[block] = malloc(MixedSize(block));
+				sum += reinterpret_cast<uintptr_t>(blocks[block]);
+			}
+
+			for (uint32_t block = 0; block < MixedBlockCount; ++block)
+			{
+				free(blocks[block]);
+			}
+
+			sSink = sum;
+		}, false);
+
+	printf(passed ? "checks passed\n" : "checks FAILED\n");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,420 @@
+// Measures what frame capture costs the render thread and checks what the encoder writes. Frames are drawn headless by
+// the SoftwareRenderBackend (a background that changes shade every frame and a red box that moves) and captured through
+// SoftwareFrameCapture, the same slot and encoder pipeline D3D11FrameCapture feeds from the swap chain:
+//   - every frame of a blocking Y4m recording must reach the stream, with the expected BT.601 samples;
+//   - every frame of a blocking PNG recording must be written, and one is decoded back and compared pixel for pixel;
+//   - a live recording paced at 60 Hz with the drop policy reports the render thread's cost per captured frame, which must
+//     stay under 0.2 ms at p99 when the encoder has a core of its own;
+//   - an unpaced recording with the drop policy must account for every frame as either encoded or dropped.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared FrameCaptureBenchmark.cpp ../../Library.Shared/FrameCapture.cpp ../../Library.Shared/SoftwareFrameCapture.cpp ../../Library.Shared/SoftwareRenderBackend.cpp ../../Library.Shared/RenderCommandList.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared FrameCaptureBenchmark.cpp ..\..\Library.Shared\FrameCapture.cpp ..\..\Library.Shared\SoftwareFrameCapture.cpp ..\..\Library.Shared\SoftwareRenderBackend.cpp ..\..\Library.Shared\RenderCommandList.cpp
+//
+// Usage: FrameCaptureBenchmark [output prefix] [frames] [width] [height]
+// Defaults to ./FrameCapture (FrameCapture.y4m, FrameCapture000000.png, ...), 180 frames at 1920x1080.
+
+#include "FrameCapture.h"
+#include "RenderCommandList.h"
+#include "SoftwareFrameCapture.h"
+#include "SoftwareRenderBackend.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	const uint32_t FramesPerSecond = 60;
+	const double BudgetMilliseconds = 0.2;
+	const uint32_t PngFrames = 6;
+
+	struct Box
+	{
+		uint32_t Left;
+		uint32_t Top;
+		uint32_t Size;
+	};
+
+	uint8_t Shade(uint32_t frame)
+	{
+		return static_cast<uint8_t>((frame * 3) & 0xFF);
+	}
+
+	Box BoxFor(uint32_t frame, uint32_t width, uint32_t height)
+	{
+		const uint32_t size = max(min(width, height) / 8, 2U);
+		return { (frame * 7) % (width - size + 1), (frame * 5) % (height - size + 1), size };
+	}
+
+	void DrawFrame(SoftwareRenderBackend& backend, RenderCommandList& commandList, uint32_t frame)
+	{
+		const float shade = static_cast<float>(Shade(frame)) / 255.0f;
+		const float background[4] = { shade, shade, shade, 1.0f };
+		const float red[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		const Box box = BoxFor(frame, backend.Width(), backend.Height());
+
+		commandList.Clear();
+		commandList.ClearRenderTarget(background);
+		commandList.ClearRenderTarget(red, { box.Left, box.Top, box.Left + box.Size, box.Top + box.Size });
+		backend.Execute(commandList);
+	}
+
+	// BT.601 studio range, as the Y4m stream is written.
+	uint8_t ExpectedLuma(uint32_t red, uint32_t green, uint32_t blue)
+	{
+		return static_cast<uint8_t>(((66 * red + 129 * green + 25 * blue + 128) >> 8) + 16);
+	}
+
+	bool ReadFile(const string& path, vector<uint8_t>& contents)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		contents.clear();
+		uint8_t buffer[64 * 1024];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			contents.insert(contents.end(), buffer, buffer + read);
+		}
+
+		fclose(file);
+		return true;
+	}
+
+	uint32_t BigEndian(const uint8_t* bytes)
+	{
+		return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+	}
+
+	uint32_t Crc32(const uint8_t* data, size_t size)
+	{
+		uint32_t crc = 0xFFFFFFFFU;
+		for (size_t i = 0; i < size; ++i)
+		{
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				crc = ((crc & 1) != 0 ? 0xEDB88320U ^ (crc >> 1) : crc >> 1);
+			}
+		}
+
+		return crc ^ 0xFFFFFFFFU;
+	}
+
+	// Reads back a PNG as FrameCapture writes it: 8-bit RGB, filter type 0, stored deflate blocks. Every chunk CRC and
+	// the zlib checksum are verified.
+	bool DecodeStoredPng(const vector<uint8_t>& file, uint32_t& width, uint32_t& height, vector<uint8_t>& rgb)
+	{
+		static const uint8_t Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		if (file.size() < sizeof(Signature) || memcmp(file.data(), Signature, sizeof(Signature)) != 0)
+		{
+			return false;
+		}
+
+		vector<uint8_t> zlib;
+		bool ended = false;
+		for (size_t offset = sizeof(Signature); offset + 12 <= file.size() && !ended;)
+		{
+			const uint32_t length = BigEndian(&file[offset]);
+			if (offset + 12 + length > file.size() || Crc32(&file[offset + 4], length + 4) != BigEndian(&file[offset + 8 + length]))
+			{
+				return false;
+			}
+
+			const uint8_t* type = &file[offset + 4];
+			const uint8_t* data = &file[offset + 8];
+			if (memcmp(type, "IHDR", 4) == 0)
+			{
+				width = BigEndian(data);
+				height = BigEndian(data + 4);
+				if (data[8] != 8 || data[9] != 2)
+				{
+					return false;
+				}
+			}
+			else if (memcmp(type, "IDAT", 4) == 0)
+			{
+				zlib.insert(zlib.end(), data, data + length);
+			}
+			else if (memcmp(type, "IEND", 4) == 0)
+			{
+				ended = true;
+			}
+
+			offset += 12 + length;
+		}
+
+		if (!ended || zlib.size() < 6 || ((zlib[0] << 8) | zlib[1]) % 31 != 0)
+		{
+			return false;
+		}
+
+		vector<uint8_t> raw;
+		size_t offset = 2;
+		for (bool last = false; !last;)
+		{
+			if (offset + 5 > zlib.size() || (zlib[offset] & 0x06) != 0)
+			{
+				return false;
+			}
+
+			last = ((zlib[offset] & 1) != 0);
+			const uint32_t length = zlib[offset + 1] | (static_cast<uint32_t>(zlib[offset + 2]) << 8);
+			const uint32_t complement = zlib[offset + 3] | (static_cast<uint32_t>(zlib[offset + 4]) << 8);
+			if ((length ^ 0xFFFF) != complement || offset + 5 + length > zlib.size())
+			{
+				return false;
+			}
+
+			raw.insert(raw.end(), zlib.begin() + static_cast<ptrdiff_t>(offset + 5), zlib.begin() + static_cast<ptrdiff_t>(offset + 5 + length));
+			offset += 5 + length;
+		}
+
+		uint32_t low = 1;
+		uint32_t high = 0;
+		for (uint8_t byte : raw)
+		{
+			low = (low + byte) % 65521;
+			high = (high + low) % 65521;
+		}
+
+		const size_t rowSize = 1 + static_cast<size_t>(width) * 3;
+		if (offset + 4 != zlib.size() || BigEndian(&zlib[offset]) != ((high << 16) | low) || raw.size() != rowSize * height)
+		{
+			return false;
+		}
+
+		rgb.resize(static_cast<size_t>(width) * height * 3);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			if (raw[y * rowSize] != 0)
+			{
+				return false;
+			}
+
+			memcpy(&rgb[static_cast<size_t>(y) * width * 3], &raw[y * rowSize + 1], static_cast<size_t>(width) * 3);
+		}
+
+		return true;
+	}
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	double Percentile(vector<double> values, double percentile)
+	{
+		if (values.empty())
+		{
+			return 0.0;
+		}
+
+		sort(values.begin(), values.end());
+		return values[min(static_cast<size_t>(percentile * static_cast<double>(values.size())), values.size() - 1)];
+	}
+
+	double Milliseconds(chrono::high_resolution_clock::time_point start, chrono::high_resolution_clock::time_point end)
+	{
+		return chrono::duration<double, milli>(end - start).count();
+	}
+
+	void PrintRun(const char* name, const FrameCapture::Counters& totals, double seconds)
+	{
+		printf("%-22s %-8llu %-8llu %-8llu %-8llu %-11.1f %.1f\n", name, static_cast<unsigned long long>(totals.FramesOffered),
+			static_cast<unsigned long long>(totals.FramesEncoded), static_cast<unsigned long long>(totals.FramesDropped),
+			static_cast<unsigned long long>(totals.BlockedReservations), static_cast<double>(totals.FramesEncoded) / seconds,
+			static_cast<double>(totals.BytesWritten) / (1024.0 * 1024.0));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const string prefix = (argc > 1 ? argv[1] : "FrameCapture");
+	const uint32_t frames = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 180);
+	const uint32_t width = (argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 1920);
+	const uint32_t height = (argc > 4 ? static_cast<uint32_t>(strtoul(argv[4], nullptr, 10)) : 1080);
+	const string streamPath = prefix + ".y4m";
+
+	SoftwareRenderBackend backend(width, height);
+	RenderCommandList commandList;
+	bool passed = true;
+
+	printf("%ux%u, %u frames\n\n", width, height, frames);
+	printf("run                    offered  encoded  dropped  blocked  encoded/s   MB written\n");
+
+	// Blocking Y4m: every frame reaches the stream.
+	{
+		const auto start = chrono::high_resolution_clock::now();
+		FrameCapture::Counters totals;
+		{
+			SoftwareFrameCapture capture(backend, streamPath, FrameCapture::Format::Y4m, FramesPerSecond);
+			for (uint32_t frame = 0; frame < frames; ++frame)
+			{
+				DrawFrame(backend, commandList, frame);
+				capture.CaptureBackBuffer();
+			}
+
+			capture.Flush();
+			totals = capture.Totals();
+		}
+
+		PrintRun("y4m, blocking", totals, Milliseconds(start, chrono::high_resolution_clock::now()) / 1000.0);
+		passed &= Check(totals.FramesEncoded == frames && totals.FramesDropped == 0 && totals.WriteErrors == 0, "blocking Y4m encodes every frame");
+
+		vector<uint8_t> stream;
+		const size_t lumaSize = static_cast<size_t>(width) * height;
+		const size_t frameSize = 6 + lumaSize + 2 * static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+		if (Check(ReadFile(streamPath, stream), "Y4m stream can be read back"))
+		{
+			const size_t header = static_cast<size_t>(find(stream.begin(), stream.end(), static_cast<uint8_t>('\n')) - stream.begin()) + 1;
+			passed &= Check(stream.size() == header + frames * frameSize, "Y4m stream holds every frame");
+			passed &= Check(header < stream.size() && memcmp(stream.data(), "YUV4MPEG2 ", 10) == 0, "Y4m stream has its header");
+
+			bool samplesMatch = (stream.size() == header + frames * frameSize);
+			for (uint32_t frame = 0; frame < frames && samplesMatch; frame += max(frames / 8, 1U))
+			{
+				const uint8_t* frameStart = &stream[header + frame * frameSize];
+				const uint8_t* luma = frameStart + 6;
+				const Box box = BoxFor(frame, width, height);
+				const uint32_t outsideX = (box.Left > 0 ? 0 : width - 1);
+				samplesMatch &= (memcmp(frameStart, "FRAME\n", 6) == 0);
+				samplesMatch &= (luma[static_cast<size_t>(box.Top + box.Size / 2) * width + box.Left + box.Size / 2] == ExpectedLuma(255, 0, 0));
+				samplesMatch &= (luma[static_cast<size_t>(box.Top) * width + outsideX] == ExpectedLuma(Shade(frame), Shade(frame), Shade(frame)));
+			}
+
+			passed &= Check(samplesMatch, "Y4m samples match the drawn frames");
+		}
+	}
+
+	// Blocking PNG: every frame is written, and the last decodes back to the drawn pixels.
+	{
+		const auto start = chrono::high_resolution_clock::now();
+		FrameCapture::Counters totals;
+		vector<uint32_t> lastFrame;
+		{
+			SoftwareFrameCapture capture(backend, prefix, FrameCapture::Format::PngSequence, FramesPerSecond);
+			for (uint32_t frame = 0; frame < PngFrames; ++frame)
+			{
+				DrawFrame(backend, commandList, frame);
+				lastFrame.assign(backend.Pixels(), backend.Pixels() + static_cast<size_t>(backend.RowPitch()) * height);
+				capture.CaptureBackBuffer();
+			}
+
+			capture.Flush();
+			totals = capture.Totals();
+		}
+
+		PrintRun("png, blocking", totals, Milliseconds(start, chrono::high_resolution_clock::now()) / 1000.0);
+		passed &= Check(totals.FramesEncoded == PngFrames && totals.WriteErrors == 0, "blocking PNG writes every frame");
+
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "%06u.png", PngFrames - 1);
+		vector<uint8_t> file;
+		vector<uint8_t> rgb;
+		uint32_t decodedWidth = 0;
+		uint32_t decodedHeight = 0;
+		if (Check(ReadFile(prefix + suffix, file), "last PNG can be read back") &&
+			Check(DecodeStoredPng(file, decodedWidth, decodedHeight, rgb), "last PNG is well formed") &&
+			Check(decodedWidth == width && decodedHeight == height, "last PNG has the frame's size"))
+		{
+			bool pixelsMatch = true;
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const uint32_t pixel = lastFrame[static_cast<size_t>(y) * backend.RowPitch() + x];
+					const uint8_t* decoded = &rgb[(static_cast<size_t>(y) * width + x) * 3];
+					pixelsMatch &= (decoded[0] == (pixel & 0xFF) && decoded[1] == ((pixel >> 8) & 0xFF) && decoded[2] == ((pixel >> 16) & 0xFF));
+				}
+			}
+
+			passed &= Check(pixelsMatch, "last PNG matches the drawn frame");
+		}
+	}
+
+	// Live: paced like a 60 Hz game, dropping frames rather than waiting. Only the capture call is timed.
+	vector<double> captureTimes;
+	{
+		const auto frameInterval = chrono::microseconds(1000000 / FramesPerSecond);
+		auto nextFrame = chrono::high_resolution_clock::now();
+		const auto start = nextFrame;
+		FrameCapture::Counters totals;
+		{
+			SoftwareFrameCapture capture(backend, streamPath, FrameCapture::Format::Y4m, FramesPerSecond, FrameCapture::DefaultSlotCount, FrameCapture::QueuePolicy::DropNewest);
+			for (uint32_t frame = 0; frame < frames; ++frame)
+			{
+				DrawFrame(backend, commandList, frame);
+
+				const auto captureStart = chrono::high_resolution_clock::now();
+				capture.CaptureBackBuffer();
+				captureTimes.push_back(Milliseconds(captureStart, chrono::high_resolution_clock::now()));
+
+				nextFrame += frameInterval;
+				this_thread::sleep_until(nextFrame);
+			}
+
+			capture.Flush();
+			totals = capture.Totals();
+		}
+
+		PrintRun("y4m, live at 60 Hz", totals, Milliseconds(start, chrono::high_resolution_clock::now()) / 1000.0);
+		passed &= Check(totals.FramesEncoded + totals.FramesDropped == frames && totals.BlockedReservations == 0, "live capture never blocks");
+	}
+
+	// Unpaced with the drop policy: the encoder falls behind and frames are dropped, but all are accounted for.
+	{
+		const auto start = chrono::high_resolution_clock::now();
+		FrameCapture::Counters totals;
+		{
+			SoftwareFrameCapture capture(backend, prefix, FrameCapture::Format::PngSequence, FramesPerSecond, FrameCapture::DefaultSlotCount,
+				FrameCapture::QueuePolicy::DropNewest);
+			for (uint32_t frame = 0; frame < frames; ++frame)
+			{
+				DrawFrame(backend, commandList, frame);
+				capture.CaptureBackBuffer();
+			}
+
+			capture.Flush();
+			totals = capture.Totals();
+		}
+
+		PrintRun("png, unpaced, dropping", totals, Milliseconds(start, chrono::high_resolution_clock::now()) / 1000.0);
+		passed &= Check(totals.FramesEncoded + totals.FramesDropped == frames && totals.FramesEncoded >= FrameCapture::DefaultSlotCount,
+			"dropping capture accounts for every frame");
+	}
+
+	const double p99 = Percentile(captureTimes, 0.99);
+	printf("\nrender thread cost per live frame: p50 %.4f ms, p99 %.4f ms, max %.4f ms (budget %.1f ms)\n", Percentile(captureTimes, 0.5), p99,
+		Percentile(captureTimes, 1.0), BudgetMilliseconds);
+	if (thread::hardware_concurrency() > 1)
+	{
+		passed &= Check(p99 < BudgetMilliseconds, "live capture stays within the render thread budget");
+	}
+	else
+	{
+		// With one hardware thread, waking the encoder hands it the core in the middle of a capture, so the tail measures
+		// the scheduler rather than the capture.
+		printf("skipped: live capture budget check (one hardware thread)\n");
+	}
+
+	printf("\n%s\n", passed ? "All checks passed." : "Checks FAILED.");
+	return (passed ? 0 : 1);
+}
@@ -0,0 +1,284 @@
+// Checks the frame-time histograms behind the statistics overlay and FrameStatistics.txt, and measures what recording a
+// sample costs. The checks:
+//   - buckets are exact below 64 us, tile every value with no gaps or overlaps, are no wider than 1/32 of their values,
+//     and clamp past the largest;
+//   - for uniform, bimodal (hitching) and log-normal frame times, p50, p90, p99, p99.9 and p100 are the upper bound of
+//     the bucket holding the nearest-rank sample, and the max is exact;
+//   - merging histograms equals recording into one;
+//   - FrameStatistics's sliding window advances once a second and forgets samples older than its ten sub-windows, while
+//     the session keeps them all;
+//   - after a gap of several seconds without frames, the window moves on by as many seconds as passed, stays aligned to
+//     whole seconds, and forgets frames older than ten seconds however long the gap.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared FrameStatisticsTest.cpp ../../Library.Shared/FrameStatistics.cpp ../../Library.Shared/FrameTimeHistogram.cpp ../../Library.Shared/Profiler.cpp ../../Library.Shared/AllocationTracker.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared FrameStatisticsTest.cpp ..\..\Library.Shared\FrameStatistics.cpp ..\..\Library.Shared\FrameTimeHistogram.cpp ..\..\Library.Shared\Profiler.cpp ..\..\Library.Shared\AllocationTracker.cpp
+//
+// Usage: FrameStatisticsTest [samples]
+
+#include "FrameStatistics.h"
+#include "FrameTimeHistogram.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	typedef FrameStatistics::Metric Metric;
+
+	// Percentiles in tenths of a percent, so nearest ranks can be computed in integers.
+	const uint32_t PercentileTenths[] = { 500, 900, 990, 999, 1000 };
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool CheckBuckets()
+	{
+		bool passed = true;
+		for (uint32_t value = 0; value < FrameTimeHistogram::LinearBucketCount; ++value)
+		{
+			passed &= Check(FrameTimeHistogram::BucketIndex(value) == value && FrameTimeHistogram::BucketUpperBound(value) == value, "small values are exact");
+		}
+
+		uint32_t lowerBound = 0;
+		for (uint32_t index = 0; index < FrameTimeHistogram::BucketCount && passed; ++index)
+		{
+			const uint32_t upperBound = FrameTimeHistogram::BucketUpperBound(index);
+			passed &= Check(FrameTimeHistogram::BucketIndex(lowerBound) == index && FrameTimeHistogram::BucketIndex(upperBound) == index, "a bucket holds its range");
+			passed &= Check(index + 1 == FrameTimeHistogram::BucketCount || FrameTimeHistogram::BucketIndex(upperBound + 1) == index + 1, "buckets leave no gaps");
+			passed &= Check(upperBound == lowerBound || static_cast<uint64_t>(upperBound - lowerBound + 1) * FrameTimeHistogram::SubBucketCount <= lowerBound,
+				"buckets keep five significant bits");
+			lowerBound = upperBound + 1;
+		}
+
+		const uint32_t largest = (1U << FrameTimeHistogram::MaxValueBits) - 1;
+		passed &= Check(FrameTimeHistogram::BucketUpperBound(FrameTimeHistogram::BucketCount - 1) == largest, "the last bucket ends at the largest value");
+		passed &= Check(FrameTimeHistogram::BucketIndex(0xFFFFFFFFU) == FrameTimeHistogram::BucketCount - 1, "larger values are clamped");
+		return passed;
+	}
+
+	bool CheckDistribution(const char* name, vector<uint32_t> samples)
+	{
+		FrameTimeHistogram histogram;
+		for (const uint32_t sample : samples)
+		{
+			histogram.Record(sample);
+		}
+
+		sort(samples.begin(), samples.end());
+		const uint64_t count = samples.size();
+
+		bool passed = Check(histogram.Count() == count && histogram.Max() == samples.back(), "the count and max are exact");
+		printf("%-10s", name);
+		for (const uint32_t tenths : PercentileTenths)
+		{
+			const uint64_t rank = max<uint64_t>((tenths * count + 999) / 1000, 1);
+			const uint32_t exact = samples[rank - 1];
+			const uint32_t expected = min(FrameTimeHistogram::BucketUpperBound(FrameTimeHistogram::BucketIndex(exact)), samples.back());
+			const uint32_t reported = histogram.ValueAtPercentile(tenths / 10.0);
+
+			passed &= Check(reported == expected, "a percentile is the nearest-rank sample's bucket");
+			passed &= Check(reported >= exact && reported - exact <= exact / FrameTimeHistogram::SubBucketCount, "a percentile is within 1/32 of the sample");
+			printf("  p%g %.3f ms", tenths / 10.0, reported / 1000.0);
+		}
+
+		printf("  max %.3f ms\n", histogram.Max() / 1000.0);
+		return passed;
+	}
+
+	bool CheckDistributions(uint32_t sampleCount)
+	{
+		mt19937 generator(27);
+
+		vector<uint32_t> uniform(sampleCount);
+		uniform_int_distribution<uint32_t> uniformDistribution(1, 33333);
+		generate(uniform.begin(), uniform.end(), [&]() { return uniformDistribution(generator); });
+
+		// 60 Hz frames with one in a hundred hitching to 50 ms.
+		vector<uint32_t> bimodal(sampleCount);
+		normal_distribution<double> frameDistribution(16667.0, 300.0);
+		uniform_int_distribution<uint32_t> hitchDistribution(0, 99);
+		generate(bimodal.begin(), bimodal.end(), [&]() { return hitchDistribution(generator) == 0 ? 50000U : static_cast<uint32_t>(max(frameDistribution(generator), 0.0)); });
+
+		vector<uint32_t> logNormal(sampleCount);
+		lognormal_distribution<double> logNormalDistribution(log(8000.0), 0.6);
+		generate(logNormal.begin(), logNormal.end(), [&]() { return static_cast<uint32_t>(min(logNormalDistribution(generator), 1e9)); });
+
+		bool passed = CheckDistribution("uniform", uniform);
+		passed &= CheckDistribution("bimodal", bimodal);
+		passed &= CheckDistribution("lognormal", logNormal);
+
+		FrameTimeHistogram merged;
+		FrameTimeHistogram whole;
+		FrameTimeHistogram half;
+		for (size_t i = 0; i < logNormal.size(); ++i)
+		{
+			whole.Record(logNormal[i]);
+			(i % 2 == 0 ? merged : half).Record(logNormal[i]);
+		}
+
+		merged.Add(half);
+		bool mergedMatches = (merged.Count() == whole.Count() && merged.Max() == whole.Max());
+		for (const uint32_t tenths : PercentileTenths)
+		{
+			mergedMatches &= (merged.ValueAtPercentile(tenths / 10.0) == whole.ValueAtPercentile(tenths / 10.0));
+		}
+
+		passed &= Check(mergedMatches, "merged histograms equal one histogram");
+
+		whole.Clear();
+		passed &= Check(whole.Count() == 0 && whole.Max() == 0 && whole.ValueAtPercentile(50.0) == 0, "a cleared histogram is empty");
+		return passed;
+	}
+
+	bool CheckSlidingWindow()
+	{
+		FrameStatistics statistics;
+		const int64_t second = Profiler::TimestampFrequency();
+		const int64_t millisecond = second / 1000;
+		const int64_t origin = Profiler::Timestamp();
+
+		// One second of 2 ms frames, then twelve seconds of 10 ms frames, with timestamps made up rather than waited for. The
+		// last frame ends thirteen seconds in. Durations are whole ticks, so a 10 ms frame may measure a microsecond short.
+		int64_t now = origin;
+		uint32_t frames = 0;
+		bool passed = true;
+		bool stillRemembered = true;
+		for (; now + 2 * millisecond < origin + second; now += 2 * millisecond, ++frames)
+		{
+			statistics.Record(Metric::Frame, now, now + 2 * millisecond);
+		}
+
+		for (uint32_t generation = statistics.WindowGeneration(); now < origin + 13 * second; now += 10 * millisecond, ++frames)
+		{
+			statistics.Record(Metric::Frame, now, now + 10 * millisecond);
+
+			// Nothing expires until the window has moved on ten times, which drops the fast frames' second.
+			if (statistics.WindowGeneration() != generation)
+			{
+				generation = statistics.WindowGeneration();
+				const FrameStatistics::Summary summary = statistics.WindowSummary(Metric::Frame);
+				if (generation < FrameStatistics::WindowCount)
+				{
+					stillRemembered &= (summary.Count == frames + 1);
+				}
+				else if (generation == FrameStatistics::WindowCount)
+				{
+					stillRemembered &= (summary.Count < frames + 1 && summary.P50 >= 9.9);
+				}
+			}
+		}
+
+		const FrameStatistics::Summary window = statistics.WindowSummary(Metric::Frame);
+		const FrameStatistics::Summary session = statistics.SessionSummary(Metric::Frame);
+
+		passed &= Check(stillRemembered, "the window keeps its ten seconds and no more");
+		passed &= Check(statistics.WindowGeneration() == 13, "the window advances once a second");
+		passed &= Check(window.Count < frames && window.Count >= 9 * 100 && window.Count <= 10 * 100 + 1, "the window holds its last ten seconds");
+		passed &= Check(window.P50 >= 9.9 && window.P50 < 10.4, "expired frames leave the window's percentiles");
+		passed &= Check(session.Count == frames && session.P50 >= 9.9 && session.P50 < 10.4, "the session keeps every frame");
+		passed &= Check(statistics.SessionSummary(Metric::Render).Count == 0, "metrics are kept apart");
+		passed &= Check(fabs(session.Max - 10.0) < 0.01, "the session max is exact");
+		return passed;
+	}
+
+	bool CheckGap()
+	{
+		FrameStatistics statistics;
+		const int64_t second = Profiler::TimestampFrequency();
+		const int64_t millisecond = second / 1000;
+		const int64_t origin = Profiler::Timestamp();
+		bool passed = true;
+
+		// A 50 ms frame in the first second, then 3.5 seconds of nothing, as when the game is suspended.
+		statistics.Record(Metric::Frame, origin, origin + 50 * millisecond);
+		int64_t now = origin + 4 * second + 500 * millisecond;
+		statistics.Record(Metric::Frame, now, now + millisecond);
+		passed &= Check(statistics.WindowGeneration() == 4, "a gap advances the window once for every second in it");
+		passed &= Check(statistics.WindowSummary(Metric::Frame).Count == 2, "frames before a short gap stay in the window");
+
+		// The next second starts five seconds after the first, not a second after the late frame.
+		now = origin + 5 * second + 100 * millisecond;
+		statistics.Record(Metric::Frame, now, now + millisecond);
+		passed &= Check(statistics.WindowGeneration() == 5, "windows stay aligned to whole seconds after a gap");
+
+		// The 50 ms frame is now more than ten seconds old and must leave the window and its max.
+		now = origin + 9 * second + 100 * millisecond;
+		statistics.Record(Metric::Frame, now, now + millisecond);
+		const FrameStatistics::Summary beforeExpiry = statistics.WindowSummary(Metric::Frame);
+		now = origin + 10 * second + 100 * millisecond;
+		statistics.Record(Metric::Frame, now, now + millisecond);
+		const FrameStatistics::Summary afterExpiry = statistics.WindowSummary(Metric::Frame);
+		passed &= Check(beforeExpiry.Count == 4 && beforeExpiry.Max >= 49.9, "frames stay in the window for ten seconds");
+		passed &= Check(afterExpiry.Count == 4 && afterExpiry.Max < 1.1, "frames older than ten seconds leave the window after a gap");
+
+		// A gap longer than the whole window leaves only the frame after it.
+		now = origin + 60 * second + 500 * millisecond;
+		statistics.Record(Metric::Frame, now, now + 2 * millisecond);
+		const FrameStatistics::Summary afterLongGap = statistics.WindowSummary(Metric::Frame);
+		passed &= Check(statistics.WindowGeneration() == 60 && afterLongGap.Count == 1 && afterLongGap.Max < 2.1, "a gap longer than the window empties it");
+		passed &= Check(statistics.SessionSummary(Metric::Frame).Count == 6, "the session keeps frames from before a gap");
+		return passed;
+	}
+
+	void Benchmark(uint32_t sampleCount)
+	{
+		mt19937 generator(1);
+		lognormal_distribution<double> distribution(log(8000.0), 0.6);
+		vector<uint32_t> samples(sampleCount);
+		generate(samples.begin(), samples.end(), [&]() { return static_cast<uint32_t>(min(distribution(generator), 1e9)); });
+
+		FrameTimeHistogram histogram;
+		const chrono::steady_clock::time_point histogramStart = chrono::steady_clock::now();
+		for (const uint32_t sample : samples)
+		{
+			histogram.Record(sample);
+		}
+		const chrono::duration<double, nano> histogramTime = chrono::steady_clock::now() - histogramStart;
+
+		// Durations as FrameStatistics receives them, one sample per call.
+		FrameStatistics statistics;
+		const int64_t microsecond = max<int64_t>(Profiler::TimestampFrequency() / 1000000, 1);
+		int64_t now = Profiler::Timestamp();
+		const chrono::steady_clock::time_point statisticsStart = chrono::steady_clock::now();
+		for (const uint32_t sample : samples)
+		{
+			statistics.Record(Metric::Frame, now, now + sample * microsecond);
+			now += sample * microsecond;
+		}
+		const chrono::duration<double, nano> statisticsTime = chrono::steady_clock::now() - statisticsStart;
+
+		printf("FrameTimeHistogram::Record %.1f ns/sample, FrameStatistics::Record %.1f ns/sample (%u samples, p99 %.3f ms)\n",
+			histogramTime.count() / sampleCount, statisticsTime.count() / sampleCount, sampleCount, histogram.ValueAtPercentile(99.0) / 1000.0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t sampleCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 1000000);
+
+	bool passed = CheckBuckets();
+	passed &= CheckDistributions(max(sampleCount / 10, 1000U));
+	passed &= CheckSlidingWindow();
+	passed &= CheckGap();
+
+	Benchmark(sampleCount);
+
+	printf(passed ? "checks passed\n" : "checks FAILED\n");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
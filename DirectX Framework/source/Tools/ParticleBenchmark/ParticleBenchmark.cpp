@@ -0,0 +1,363 @@
+// Measures the ParticleSystem from a thousand to a million live particles and checks it against a plain C++ simulation.
+// Each size is timed for integrating a frame and for writing the frame's instances, the two costs the game pays every
+// frame while particles are alive, and for emitting a combo's worth of bursts. The checks:
+//   - emitting into a full pool drops what doesn't fit, and the counters add up;
+//   - positions, velocities and the fade of radius and alpha match a particle-by-particle simulation, for counts that
+//     aren't a multiple of four;
+//   - particles are retired in the update their life runs out, and only they are;
+//   - a particle without a lifetime is written with no size and retired by the next update;
+//   - the instances drawn through a RenderCommandList into a SoftwareRenderBackend are one draw, blended by their faded
+//     alpha.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared ParticleBenchmark.cpp ../../Library.Shared/ParticleSystem.cpp ../../Library.Shared/RenderCommandList.cpp ../../Library.Shared/SoftwareRenderBackend.cpp ../../Library.Shared/SpriteBatch.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared ParticleBenchmark.cpp ..\..\Library.Shared\ParticleSystem.cpp ..\..\Library.Shared\RenderCommandList.cpp ..\..\Library.Shared\SoftwareRenderBackend.cpp ..\..\Library.Shared\SpriteBatch.cpp
+// Add -DDX_PARTICLE_SYSTEM_SCALAR (/DDX_PARTICLE_SYSTEM_SCALAR) to time the plain C++ paths instead of SSE2 or NEON.
+//
+// Usage: ParticleBenchmark [largest particle count]
+// Defaults to 1000000.
+
+#include "ParticleSystem.h"
+#include "RenderCommandList.h"
+#include "SoftwareRenderBackend.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	const float StepSeconds = 1.0f / 60.0f;
+	const float Pi = 3.14159265f;
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool Near(float actual, float expected, float tolerance)
+	{
+		return fabs(actual - expected) <= tolerance * max(1.0f, fabs(expected));
+	}
+
+	ParticleBurst Burst(float x, float y, uint32_t count, float lifetime, uint32_t color)
+	{
+		ParticleBurst burst = {};
+		burst.Position[0] = x;
+		burst.Position[1] = y;
+		burst.Count = count;
+		burst.Spread = 2.0f * Pi;
+		burst.MinSpeed = 10.0f;
+		burst.MaxSpeed = 40.0f;
+		burst.MinLifetime = lifetime;
+		burst.MaxLifetime = lifetime;
+		burst.Radius = 0.5f;
+		burst.Color = color;
+		return burst;
+	}
+
+	bool CheckEmission()
+	{
+		bool passed = true;
+		ParticleSystem particles(100);
+		passed &= Check(particles.Emit(Burst(0.0f, 0.0f, 60, 1.0f, 0xFFFFFFFF)) == 60, "a burst that fits is emitted whole");
+		passed &= Check(particles.Emit(Burst(0.0f, 0.0f, 60, 1.0f, 0xFFFFFFFF)) == 40, "a burst into a nearly full pool is cut short");
+		passed &= Check(particles.LiveCount() == 100, "the pool fills to its capacity");
+
+		particles.Update(StepSeconds);
+		const ParticleSystem::Counters& last = particles.LastUpdate();
+		passed &= Check(last.Updates == 1 && last.Emitted == 100 && last.Dropped == 20 && last.Expired == 0 && last.Live == 100, "the update's counters include the emits before it");
+
+		particles.Update(StepSeconds);
+		passed &= Check(particles.LastUpdate().Emitted == 0 && particles.Totals().Emitted == 100 && particles.Totals().Updates == 2 && particles.Totals().Live == 200, "totals add up over updates");
+
+		particles.Clear();
+		passed &= Check(particles.LiveCount() == 0 && particles.Emit(Burst(0.0f, 0.0f, 5, 1.0f, 0xFFFFFFFF)) == 5, "clearing empties the pool");
+		return passed;
+	}
+
+	// One particle per burst, each with its own direction, speed and lifetime, simulated alongside the system one
+	// operation at a time.
+	bool CheckIntegration(uint32_t count)
+	{
+		struct Reference
+		{
+			float X, Y, VelocityX, VelocityY, Life, Lifetime;
+		};
+
+		const float gravity[2] = { 3.0f, -50.0f };
+		const float drag = 0.5f;
+		ParticleSystem particles(count);
+		particles.SetGravity(gravity[0], gravity[1]);
+		particles.SetDrag(drag);
+
+		vector<Reference> references(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			ParticleBurst burst = Burst(static_cast<float>(i % 17) - 8.0f, static_cast<float>(i % 5), 1, 2.0f + static_cast<float>(i % 7) * 0.25f, (i & 0xFFFFFF) | 0xC8000000);
+			burst.Direction = static_cast<float>(i) * 0.37f;
+			burst.Spread = 0.0f;
+			burst.MinSpeed = burst.MaxSpeed = 5.0f + static_cast<float>(i % 11);
+			burst.Radius = 1.0f + static_cast<float>(i % 3);
+			particles.Emit(burst);
+
+			const Reference reference = { burst.Position[0], burst.Position[1], cos(burst.Direction) * burst.MinSpeed, sin(burst.Direction) * burst.MinSpeed, burst.MinLifetime, burst.MinLifetime };
+			references[i] = reference;
+		}
+
+		const float damping = 1.0f - drag * StepSeconds;
+		for (uint32_t step = 0; step < 90; ++step)
+		{
+			particles.Update(StepSeconds);
+			for (Reference& reference : references)
+			{
+				reference.VelocityX = reference.VelocityX * damping + gravity[0] * StepSeconds;
+				reference.VelocityY = reference.VelocityY * damping + gravity[1] * StepSeconds;
+				reference.X += reference.VelocityX * StepSeconds;
+				reference.Y += reference.VelocityY * StepSeconds;
+				reference.Life -= StepSeconds;
+			}
+		}
+
+		vector<ParticleInstance> instances(count);
+		const uint32_t written = particles.WriteInstances(instances.data(), count);
+		bool positions = (written == count);
+		bool fades = positions;
+		for (uint32_t i = 0; i < written; ++i)
+		{
+			const ParticleInstance& instance = instances[i];
+			const uint32_t index = instance.Color & 0xFFFFFF;
+			if (index >= count)
+			{
+				positions = false;
+				break;
+			}
+
+			const Reference& reference = references[index];
+			positions &= Near(instance.Position[0], reference.X, 1e-5f) && Near(instance.Position[1], reference.Y, 1e-5f);
+
+			const float fraction = reference.Life / reference.Lifetime;
+			const float radius = (1.0f + static_cast<float>(index % 3)) * fraction;
+			const float alpha = 200.0f * fraction;
+			fades &= Near(instance.Radius, radius, 1e-5f) && fabs(static_cast<float>(instance.Color >> 24) - alpha) <= 0.51f;
+		}
+
+		bool passed = Check(positions, "positions match a particle-by-particle simulation");
+		passed &= Check(fades, "radius and alpha fade with the life left");
+		return passed;
+	}
+
+	bool CheckRetirement()
+	{
+		// Four interleaved groups that die in the updates after 0.125, 0.225, 0.325 and 0.425 seconds; tagged in red.
+		const float step = 0.05f;
+		const uint32_t perGroup = 37;
+		ParticleSystem particles(perGroup * 4);
+		for (uint32_t i = 0; i < perGroup; ++i)
+		{
+			for (uint32_t group = 0; group < 4; ++group)
+			{
+				particles.Emit(Burst(0.0f, 0.0f, 1, 0.125f + 0.1f * static_cast<float>(group), 0xFF000000 | group));
+			}
+		}
+
+		bool passed = true;
+		const uint32_t expectedGroups[10] = { 4, 4, 3, 3, 2, 2, 1, 1, 0, 0 };
+		vector<ParticleInstance> instances(perGroup * 4);
+		uint64_t expired = 0;
+		for (uint32_t update = 0; update < 10; ++update)
+		{
+			particles.Update(step);
+			expired += particles.LastUpdate().Expired;
+
+			// The live groups are the latest ones, each whole.
+			const uint32_t firstLiveGroup = 4 - expectedGroups[update];
+			uint32_t perGroupLive[4] = {};
+			const uint32_t written = particles.WriteInstances(instances.data(), static_cast<uint32_t>(instances.size()));
+			for (uint32_t i = 0; i < written; ++i)
+			{
+				++perGroupLive[instances[i].Color & 3];
+			}
+
+			bool groups = (particles.LiveCount() == expectedGroups[update] * perGroup);
+			for (uint32_t group = 0; group < 4; ++group)
+			{
+				groups &= (perGroupLive[group] == (group >= firstLiveGroup ? perGroup : 0));
+			}
+
+			passed &= Check(groups, "particles retire in the update their life runs out");
+		}
+
+		passed &= Check(expired == perGroup * 4 && particles.Totals().Expired == expired, "every particle expires once");
+
+		ParticleSystem instant(8);
+		instant.Emit(Burst(0.0f, 0.0f, 3, 0.0f, 0xFFFFFFFF));
+		ParticleInstance written[3];
+		passed &= Check(instant.WriteInstances(written, 3) == 3 && written[0].Radius == 0.0f && (written[0].Color >> 24) == 0, "a particle without a lifetime has no size");
+		instant.Update(StepSeconds);
+		passed &= Check(instant.LiveCount() == 0 && instant.LastUpdate().Expired == 3, "a particle without a lifetime is retired by the next update");
+		return passed;
+	}
+
+	// The mesh and pipeline ParticleManager uses: a quad from -1 to 1 in strip order, drawn with the instance's radius
+	// as scale and color, alpha blended.
+	bool CheckDraw()
+	{
+		const uint32_t size = 128;
+		SoftwareRenderBackend backend(size, size);
+		const PipelineHandle pipeline = backend.CreatePipeline({ SoftwareRenderBackend::ShaderType::ColorInstanced, SoftwareRenderBackend::PrimitiveType::TriangleStrip, true });
+		const float quad[4][4] = { { -1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 0.0f, 1.0f }, { -1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, -1.0f, 0.0f, 1.0f } };
+		const MeshHandle mesh = backend.CreateMesh({ quad, 4, sizeof(quad[0]), 64, sizeof(ParticleInstance) });
+
+		// Two long-lived particles that don't move, one opaque red and one half transparent green, in a y-up world one
+		// unit per pixel.
+		ParticleSystem particles(64);
+		ParticleBurst red = Burst(32.0f, 96.0f, 1, 1000.0f, 0xFF0000FF);
+		red.MinSpeed = red.MaxSpeed = 0.0f;
+		red.Radius = 8.0f;
+		ParticleBurst green = red;
+		green.Position[0] = 96.0f;
+		green.Position[1] = 32.0f;
+		green.Color = 0x8000FF00;
+		particles.Emit(red);
+		particles.Emit(green);
+
+		ParticleInstance instances[64];
+		const uint32_t count = particles.WriteInstances(instances, 64);
+
+		const float projection[16] = { 2.0f / size, 0.0f, 0.0f, -1.0f, 0.0f, 2.0f / size, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+		static const float Black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		RenderCommandList commandList;
+		commandList.ClearRenderTarget(Black);
+		commandList.SetPipeline(pipeline);
+		commandList.SetMesh(mesh);
+		commandList.SetConstants(ShaderStage::Vertex, projection);
+		commandList.UpdateInstances(instances, count);
+		commandList.DrawInstanced(4, count);
+		backend.Execute(commandList);
+
+		// The world is y up, so row 0 of the target is y = 128.
+		const uint32_t* pixels = backend.Pixels();
+		const uint32_t pitch = backend.RowPitch();
+		const uint32_t redCenter = pixels[(size - 96) * pitch + 32];
+		const uint32_t greenCenter = pixels[(size - 32) * pitch + 96];
+		const uint32_t outside = pixels[(size - 64) * pitch + 64];
+
+		bool passed = Check(commandList.DrawCount() == 1 && backend.Totals().Draws == 1, "every particle goes out in one draw");
+		passed &= Check((redCenter & 0x00FFFFFF) == 0x0000FF, "an opaque particle covers its quad");
+		const uint32_t greenChannel = (greenCenter >> 8) & 0xFF;
+		passed &= Check((greenCenter & 0xFF00FF) == 0 && greenChannel >= 126 && greenChannel <= 130, "a half transparent particle is blended by its alpha");
+		passed &= Check((outside & 0x00FFFFFF) == 0, "nothing is drawn outside the quads");
+		passed &= Check(backend.Totals().PixelsShaded == 2 * 16 * 16, "each quad covers its radius on both sides, front facing");
+		return passed;
+	}
+
+	double Seconds(chrono::steady_clock::time_point start)
+	{
+		return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+
+	void Benchmark(uint32_t count)
+	{
+		ParticleSystem particles(count, 7);
+		particles.SetGravity(0.0f, -30.0f);
+		particles.SetDrag(0.5f);
+
+		// Lifetimes long enough that none expire while timed, so every update moves all of them.
+		ParticleBurst burst = Burst(0.0f, 50.0f, 1000, 1000.0f, 0xFF40C0FF);
+		burst.MinLifetime = 500.0f;
+		while (particles.LiveCount() < count)
+		{
+			particles.Emit(burst);
+		}
+
+		// At most ten simulated seconds: over minutes, drag would slow the sideways velocities into denormals, which no
+		// particle lives long enough to reach in the game.
+		vector<ParticleInstance> instances(count);
+		const uint32_t frames = min<uint32_t>(600, max<uint32_t>(10, 20000000 / count));
+		auto start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			particles.Update(StepSeconds);
+		}
+		const double updateSeconds = Seconds(start) / frames;
+
+		uint32_t written = 0;
+		start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			written += particles.WriteInstances(instances.data(), count);
+		}
+		const double writeSeconds = Seconds(start) / frames;
+
+		printf("%8u live: update %8.3f ms (%5.2f ns/particle), write instances %8.3f ms (%5.2f ns/particle)\n", count, updateSeconds * 1e3,
+			updateSeconds * 1e9 / count, writeSeconds * 1e3, writeSeconds * 1e9 / count);
+
+		if (written != count * frames)
+		{
+			fprintf(stderr, "unexpected instance count\n");
+		}
+	}
+
+	// A frame in which a combo breaks 20 bricks at once, each emitting a brick break's 24 particles, while the pool
+	// keeps a steady population of particles that live about a second.
+	void BenchmarkCombo()
+	{
+		ParticleSystem particles(4096, 11);
+		particles.SetGravity(0.0f, -30.0f);
+		ParticleBurst brick = Burst(0.0f, 90.0f, 24, 0.6f, 0xFF3050FF);
+		brick.MaxLifetime = 1.2f;
+
+		const uint32_t frames = 20000;
+		auto start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			if (frame % 30 == 0)
+			{
+				for (uint32_t i = 0; i < 20; ++i)
+				{
+					brick.Position[0] = -45.0f + 4.5f * static_cast<float>(i);
+					particles.Emit(brick);
+				}
+			}
+
+			particles.Update(StepSeconds);
+		}
+
+		const double seconds = Seconds(start);
+		const ParticleSystem::Counters& totals = particles.Totals();
+		printf("combo every half second: %.2f us per frame, %.0f live on average, %llu emitted, %llu dropped\n", seconds * 1e6 / frames,
+			static_cast<double>(totals.Live) / static_cast<double>(totals.Updates), static_cast<unsigned long long>(totals.Emitted), static_cast<unsigned long long>(totals.Dropped));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t largest = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 1000000);
+
+	bool passed = CheckEmission();
+	passed &= CheckIntegration(1003);
+	passed &= CheckIntegration(7);
+	passed &= CheckRetirement();
+	passed &= CheckDraw();
+
+	for (uint32_t count = 1000; count <= largest; count *= 10)
+	{
+		Benchmark(count);
+	}
+
+	BenchmarkCombo();
+
+	printf(passed ? "checks passed\n" : "checks FAILED\n");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,647 @@
+// Monte Carlo balance analyzer for the powerup odds in PowerupManager and the effect sizes in BallManager and BarManager.
+//
+// Plays many seeded, headless games per parameter set, steered by the same closed-form landing prediction as
+// BarAutopilot, and reports the loss rate and the time-to-clear and max ball speed distributions. Every combination of
+// the comma-separated values given on the command line is analyzed in one run. Sessions are spread over all hardware
+// threads; each thread folds its games into fixed-size histograms, which are merged at the end, so memory does not grow
+// with the session count. Session N uses the same seed under every parameter set, so differences between sets are not
+// drowned out by the luck of the draw.
+//
+// The rules, the step of play and the autopilot are the game's own, from GameRules, which BatchEnvironment steps by too.
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -pthread -I../../Game.Universal PowerupBalanceAnalyzer.cpp ../../Game.Universal/GameRules.cpp
+//   cl /O2 /EHsc /I..\..\Game.Universal PowerupBalanceAnalyzer.cpp ..\..\Game.Universal\GameRules.cpp
+//
+// Usage: PowerupBalanceAnalyzer [options]
+//   --sessions N           games per parameter set (default 100000)
+//   --threads N            worker threads (default: one per hardware thread)
+//   --seed N               base seed (default 1)
+//   --max-seconds S        game time after which an unfinished game counts as timed out (default 600)
+//   --spawn-chance a,b,..  chance that a broken chunk spawns a powerup (default 0.25)
+//   --ball-step a,b,..     per-axis ball speed change of FasterBall and SlowerBall (default 5)
+//   --bar-increase a,b,..  bar speed change of FasterBar (default 30)
+//   --bar-decrease a,b,..  bar speed change of SlowerBar (default 5)
+//   --weights w,w,..       relative odds FasterBall:SlowerBall:SlowerBar:FasterBar, e.g. 1:1:1:1 (the default)
+//   --report path          also write the report to a tab-separated file
+
+#include "GameRules.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace DirectXGame;
+
+namespace
+{
+	enum PowerupType
+	{
+		FasterBall,
+		SlowerBall,
+		SlowerBar,
+		FasterBar,
+		PowerupTypeCount
+	};
+
+	const char* const PowerupNames[PowerupTypeCount] = { "FasterBall", "SlowerBall", "SlowerBar", "FasterBar" };
+
+	struct Parameters
+	{
+		float SpawnChance;
+		float BallStep;
+		float BarIncrease;
+		float BarDecrease;
+		uint32_t Weights[PowerupTypeCount];
+	};
+
+	enum class Outcome
+	{
+		Cleared,
+		Lost,
+		TimedOut
+	};
+
+	struct SessionResult
+	{
+		Outcome Result;
+		uint32_t Ticks;
+		uint32_t ChunksBroken;
+		float MaxBallSpeed;
+		uint32_t PowerupsSpawned;
+		uint32_t PowerupsCaught[PowerupTypeCount];
+	};
+
+	// splitmix64, used both to derive session seeds and as the session's generator.
+	class Random final
+	{
+	public:
+		explicit Random(uint64_t seed) :
+			mState(seed)
+		{
+		}
+
+		uint64_t Next()
+		{
+			uint64_t z = (mState += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+
+		// Uniform in [0, 1).
+		float NextFloat()
+		{
+			return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f);
+		}
+
+		uint32_t NextBelow(uint32_t bound)
+		{
+			return static_cast<uint32_t>(((Next() >> 32) * bound) >> 32);
+		}
+
+	private:
+		uint64_t mState;
+	};
+
+	// Fixed-width bins over [0, BinCount * BinWidth); larger values land in the last bin.
+	class Histogram final
+	{
+	public:
+		Histogram(uint32_t binCount, float binWidth) :
+			mBins(binCount), mBinWidth(binWidth), mCount(0), mMax(0.0f)
+		{
+		}
+
+		void Add(float value)
+		{
+			const uint32_t bin = min(static_cast<uint32_t>(max(value, 0.0f) / mBinWidth), static_cast<uint32_t>(mBins.size()) - 1);
+			++mBins[bin];
+			++mCount;
+			mMax = max(mMax, value);
+		}
+
+		void Merge(const Histogram& other)
+		{
+			for (size_t i = 0; i < mBins.size(); ++i)
+			{
+				mBins[i] += other.mBins[i];
+			}
+
+			mCount += other.mCount;
+			mMax = max(mMax, other.mMax);
+		}
+
+		uint64_t Count() const
+		{
+			return mCount;
+		}
+
+		float Max() const
+		{
+			return mMax;
+		}
+
+		// Interpolates linearly within the bin that holds the requested rank.
+		float Percentile(float percentile) const
+		{
+			if (mCount == 0)
+			{
+				return 0.0f;
+			}
+
+			const double rank = percentile / 100.0 * static_cast<double>(mCount);
+			uint64_t below = 0;
+			for (size_t i = 0; i < mBins.size(); ++i)
+			{
+				if (mBins[i] > 0 && static_cast<double>(below + mBins[i]) >= rank)
+				{
+					const double fraction = (rank - static_cast<double>(below)) / static_cast<double>(mBins[i]);
+					return min(static_cast<float>((static_cast<double>(i) + fraction) * mBinWidth), mMax);
+				}
+
+				below += mBins[i];
+			}
+
+			return mMax;
+		}
+
+	private:
+		vector<uint64_t> mBins;
+		float mBinWidth;
+		uint64_t mCount;
+		float mMax;
+	};
+
+	struct Statistics
+	{
+		uint64_t Sessions;
+		uint64_t Cleared;
+		uint64_t Lost;
+		uint64_t TimedOut;
+		uint64_t ChunksBroken;
+		uint64_t PowerupsSpawned;
+		uint64_t PowerupsCaught[PowerupTypeCount];
+		Histogram ClearSeconds;
+		Histogram MaxBallSpeed;
+
+		explicit Statistics(uint32_t maxSeconds) :
+			Sessions(0), Cleared(0), Lost(0), TimedOut(0), ChunksBroken(0), PowerupsSpawned(0), PowerupsCaught(),
+			ClearSeconds(maxSeconds * 4, 0.25f), MaxBallSpeed(512, 0.5f)
+		{
+		}
+
+		void Add(const SessionResult& result)
+		{
+			++Sessions;
+			ChunksBroken += result.ChunksBroken;
+			PowerupsSpawned += result.PowerupsSpawned;
+			for (uint32_t type = 0; type < PowerupTypeCount; ++type)
+			{
+				PowerupsCaught[type] += result.PowerupsCaught[type];
+			}
+
+			switch (result.Result)
+			{
+			case Outcome::Cleared:
+				++Cleared;
+				ClearSeconds.Add(static_cast<float>(result.Ticks) * GameRules::StepSeconds);
+				break;
+
+			case Outcome::Lost:
+				++Lost;
+				break;
+
+			case Outcome::TimedOut:
+				++TimedOut;
+				break;
+			}
+
+			MaxBallSpeed.Add(result.MaxBallSpeed);
+		}
+
+		void Merge(const Statistics& other)
+		{
+			Sessions += other.Sessions;
+			Cleared += other.Cleared;
+			Lost += other.Lost;
+			TimedOut += other.TimedOut;
+			ChunksBroken += other.ChunksBroken;
+			PowerupsSpawned += other.PowerupsSpawned;
+			for (uint32_t type = 0; type < PowerupTypeCount; ++type)
+			{
+				PowerupsCaught[type] += other.PowerupsCaught[type];
+			}
+
+			ClearSeconds.Merge(other.ClearSeconds);
+			MaxBallSpeed.Merge(other.MaxBallSpeed);
+		}
+	};
+
+	// Plays one game with the rules of the shipping game: PowerupManager updates first, then the bar moves, then the ball.
+	SessionResult PlaySession(const Parameters& parameters, uint64_t seed, uint32_t maxTicks)
+	{
+		struct FallingPowerup
+		{
+			float X;
+			float Y;
+			PowerupType Type;
+			bool Activated;
+		};
+
+		Random random(seed);
+
+		uint32_t totalWeight = 0;
+		for (uint32_t type = 0; type < PowerupTypeCount; ++type)
+		{
+			totalWeight += parameters.Weights[type];
+		}
+
+		SessionResult result = {};
+		result.Result = Outcome::TimedOut;
+		result.Ticks = maxTicks;
+
+		GameRules::PlayState state = { GameRules::BallStartX, GameRules::BallStartY, GameRules::BallLaunchSpeed, GameRules::BallLaunchSpeed,
+			GameRules::BarStartX, GameRules::BarStartSpeed };
+		uint64_t chunkMask = (static_cast<uint64_t>(1) << GameRules::ChunkCount) - 1;
+
+		// Every chunk spawns at most one powerup.
+		FallingPowerup powerups[GameRules::ChunkCount];
+		uint32_t powerupCount = 0;
+
+		result.MaxBallSpeed = sqrt(state.BallVelocityX * state.BallVelocityX + state.BallVelocityY * state.BallVelocityY);
+
+		// Bounces off the bar only ever flip the ball's direction, so a bar that always catches dead center settles into a
+		// loop that never reaches some chunks. A new random aim point after every catch stands in for a player's imprecision.
+		const float aimRange = GameRules::BarCatchWidth - 2.0f * GameRules::BallRadius;
+		float aimX = GameRules::BallRadius + random.NextFloat() * aimRange;
+
+		for (uint32_t tick = 0; tick < maxTicks; ++tick)
+		{
+			// PowerupManager::Update
+			for (uint32_t i = 0; i < powerupCount; ++i)
+			{
+				FallingPowerup& powerup = powerups[i];
+				powerup.Y -= GameRules::PowerupFallSpeed * GameRules::StepSeconds;
+
+				const float centerX = powerup.X + GameRules::PowerupWidth / 2.0f;
+				if (!powerup.Activated && powerup.Y + GameRules::PowerupHeight <= GameRules::BarY && state.BarX <= centerX && centerX <= state.BarX + GameRules::BarCatchWidth)
+				{
+					powerup.Activated = true;
+					++result.PowerupsCaught[powerup.Type];
+
+					switch (powerup.Type)
+					{
+					case FasterBar:
+						state.BarVelocityX += parameters.BarIncrease;
+						break;
+
+					case SlowerBar:
+						state.BarVelocityX -= parameters.BarDecrease;
+						break;
+
+					case FasterBall:
+					case SlowerBall:
+					{
+						// BallManager::IncreaseBallVelocity and DecreaseBallVelocity work per axis, away from or toward zero.
+						const float step = (powerup.Type == FasterBall ? parameters.BallStep : -parameters.BallStep);
+						state.BallVelocityX += (state.BallVelocityX < 0.0f ? -step : (state.BallVelocityX > 0.0f ? step : 0.0f));
+						state.BallVelocityY += (state.BallVelocityY < 0.0f ? -step : (state.BallVelocityY > 0.0f ? step : 0.0f));
+						break;
+					}
+
+					default:
+						break;
+					}
+				}
+
+				if (powerup.Y <= 0.0f)
+				{
+					powerup.Activated = true;
+				}
+			}
+
+			// The bar, then the ball. The autopilot lines the landing point up with aimX rather than the middle of the bar.
+			const GameRules::AutopilotState autopilot = { state.BallX, state.BallY, state.BallVelocityX, state.BallVelocityY, GameRules::BallRadius,
+				state.BarX, aimX, GameRules::CatchY, GameRules::FieldLeft, GameRules::FieldRight, GameRules::FieldTop };
+
+			GameRules::StepBar(state, GameRules::DecideAutopilot(autopilot));
+			const GameRules::BallStepResult step = GameRules::StepBall(state);
+			if (step.Caught)
+			{
+				aimX = GameRules::BallRadius + random.NextFloat() * aimRange;
+			}
+
+			if (step.InChunkZone)
+			{
+				const int32_t chunk = GameRules::StepChunks(state, chunkMask);
+				if (chunk != GameRules::NoChunk)
+				{
+					++result.ChunksBroken;
+
+					// PowerupManager::PowerupSpawnCheck and SpawnPowerup
+					if (random.NextFloat() < parameters.SpawnChance && totalWeight > 0)
+					{
+						uint32_t pick = random.NextBelow(totalWeight);
+						uint32_t type = 0;
+						while (pick >= parameters.Weights[type])
+						{
+							pick -= parameters.Weights[type];
+							++type;
+						}
+
+						const uint32_t row = static_cast<uint32_t>(chunk) / GameRules::ChunkColumns;
+						const uint32_t column = static_cast<uint32_t>(chunk) % GameRules::ChunkColumns;
+
+						FallingPowerup& powerup = powerups[powerupCount++];
+						powerup.X = GameRules::ChunkLeft + static_cast<float>(column) * GameRules::ChunkWidth + GameRules::PowerupSpawnOffsetX;
+						powerup.Y = GameRules::ChunkTopRowY - static_cast<float>(row) * GameRules::ChunkHeight - GameRules::ChunkHeight;
+						powerup.Type = static_cast<PowerupType>(type);
+						powerup.Activated = false;
+						++result.PowerupsSpawned;
+					}
+				}
+			}
+
+			result.MaxBallSpeed = max(result.MaxBallSpeed, sqrt(state.BallVelocityX * state.BallVelocityX + state.BallVelocityY * state.BallVelocityY));
+
+			if (step.Lost)
+			{
+				result.Result = Outcome::Lost;
+				result.Ticks = tick + 1;
+				break;
+			}
+
+			if (chunkMask == 0)
+			{
+				result.Result = Outcome::Cleared;
+				result.Ticks = tick + 1;
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	uint64_t SessionSeed(uint64_t baseSeed, uint64_t session)
+	{
+		Random random(baseSeed ^ (session * 0xD1B54A32D192ED03ULL));
+		return random.Next();
+	}
+
+	template <typename T>
+	bool ParseList(const char* text, vector<T>& values, T (*parse)(const string&))
+	{
+		values.clear();
+		stringstream stream(text);
+		string item;
+		while (getline(stream, item, ','))
+		{
+			if (item.empty())
+			{
+				return false;
+			}
+
+			values.push_back(parse(item));
+		}
+
+		return !values.empty();
+	}
+
+	float ParseFloat(const string& text)
+	{
+		return static_cast<float>(atof(text.c_str()));
+	}
+
+	// "a:b:c:d" with one weight per PowerupType.
+	vector<uint32_t> ParseWeights(const string& text)
+	{
+		vector<uint32_t> weights;
+		stringstream stream(text);
+		string item;
+		while (getline(stream, item, ':'))
+		{
+			weights.push_back(static_cast<uint32_t>(strtoul(item.c_str(), nullptr, 10)));
+		}
+
+		return weights;
+	}
+
+	void WriteReport(ostream& stream, const vector<Parameters>& parameterSets, const vector<Statistics>& statistics)
+	{
+		stream << "SpawnChance\tBallStep\tBarIncrease\tBarDecrease\tWeights\tSessions\tCleared%\tLost%\tTimedOut%"
+			"\tClearP10\tClearP50\tClearP90\tChunksPerGame\tMaxSpeedP50\tMaxSpeedP90\tMaxSpeedP99\tMaxSpeedMax\tPowerupsPerGame";
+		for (uint32_t type = 0; type < PowerupTypeCount; ++type)
+		{
+			stream << '\t' << PowerupNames[type] << "Caught";
+		}
+		stream << '\n';
+
+		for (size_t i = 0; i < parameterSets.size(); ++i)
+		{
+			const Parameters& parameters = parameterSets[i];
+			const Statistics& result = statistics[i];
+			const double sessions = static_cast<double>(max(result.Sessions, static_cast<uint64_t>(1)));
+
+			char line[512];
+			snprintf(line, sizeof(line), "%.3f\t%.2f\t%.2f\t%.2f\t%u:%u:%u:%u\t%llu\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.3f",
+				parameters.SpawnChance, parameters.BallStep, parameters.BarIncrease, parameters.BarDecrease,
+				parameters.Weights[0], parameters.Weights[1], parameters.Weights[2], parameters.Weights[3],
+				static_cast<unsigned long long>(result.Sessions),
+				100.0 * static_cast<double>(result.Cleared) / sessions,
+				100.0 * static_cast<double>(result.Lost) / sessions,
+				100.0 * static_cast<double>(result.TimedOut) / sessions,
+				result.ClearSeconds.Percentile(10.0f), result.ClearSeconds.Percentile(50.0f), result.ClearSeconds.Percentile(90.0f),
+				static_cast<double>(result.ChunksBroken) / sessions,
+				result.MaxBallSpeed.Percentile(50.0f), result.MaxBallSpeed.Percentile(90.0f), result.MaxBallSpeed.Percentile(99.0f),
+				result.MaxBallSpeed.Max(),
+				static_cast<double>(result.PowerupsSpawned) / sessions);
+			stream << line;
+
+			for (uint32_t type = 0; type < PowerupTypeCount; ++type)
+			{
+				snprintf(line, sizeof(line), "\t%.3f", static_cast<double>(result.PowerupsCaught[type]) / sessions);
+				stream << line;
+			}
+			stream << '\n';
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	uint64_t sessionCount = 100000;
+	uint32_t threadCount = 0;
+	uint64_t seed = 1;
+	uint32_t maxSeconds = 600;
+	vector<float> spawnChances = { 0.25f };
+	vector<float> ballSteps = { GameRules::PowerupBallSpeedStep };
+	vector<float> barIncreases = { GameRules::PowerupBarSpeedIncrease };
+	vector<float> barDecreases = { GameRules::PowerupBarSpeedDecrease };
+	vector<vector<uint32_t>> weightSets = { { 1, 1, 1, 1 } };
+	string reportPath;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc ? argv[i + 1] : nullptr);
+		bool valid = (value != nullptr);
+
+		if (valid && strcmp(option, "--sessions") == 0)
+		{
+			sessionCount = strtoull(value, nullptr, 10);
+		}
+		else if (valid && strcmp(option, "--threads") == 0)
+		{
+			threadCount = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+		}
+		else if (valid && strcmp(option, "--seed") == 0)
+		{
+			seed = strtoull(value, nullptr, 10);
+		}
+		else if (valid && strcmp(option, "--max-seconds") == 0)
+		{
+			maxSeconds = max(static_cast<uint32_t>(strtoul(value, nullptr, 10)), 1U);
+		}
+		else if (valid && strcmp(option, "--spawn-chance") == 0)
+		{
+			valid = ParseList(value, spawnChances, ParseFloat);
+		}
+		else if (valid && strcmp(option, "--ball-step") == 0)
+		{
+			valid = ParseList(value, ballSteps, ParseFloat);
+		}
+		else if (valid && strcmp(option, "--bar-increase") == 0)
+		{
+			valid = ParseList(value, barIncreases, ParseFloat);
+		}
+		else if (valid && strcmp(option, "--bar-decrease") == 0)
+		{
+			valid = ParseList(value, barDecreases, ParseFloat);
+		}
+		else if (valid && strcmp(option, "--weights") == 0)
+		{
+			valid = ParseList(value, weightSets, ParseWeights);
+			for (const auto& weights : weightSets)
+			{
+				valid = valid && (weights.size() == PowerupTypeCount);
+			}
+		}
+		else if (valid && strcmp(option, "--report") == 0)
+		{
+			reportPath = value;
+		}
+		else
+		{
+			valid = false;
+		}
+
+		if (!valid)
+		{
+			fprintf(stderr, "Invalid option: %s (see the comment at the top of PowerupBalanceAnalyzer.cpp)\n", option);
+			return 1;
+		}
+
+		++i;
+	}
+
+	if (threadCount == 0)
+	{
+		threadCount = max(thread::hardware_concurrency(), 1U);
+	}
+
+	vector<Parameters> parameterSets;
+	for (float spawnChance : spawnChances)
+	{
+		for (float ballStep : ballSteps)
+		{
+			for (float barIncrease : barIncreases)
+			{
+				for (float barDecrease : barDecreases)
+				{
+					for (const auto& weights : weightSets)
+					{
+						Parameters parameters = { spawnChance, ballStep, barIncrease, barDecrease, { weights[0], weights[1], weights[2], weights[3] } };
+						parameterSets.push_back(parameters);
+					}
+				}
+			}
+		}
+	}
+
+	// Work is handed out in batches of sessions from a shared counter. Each thread reduces into its own statistics,
+	// one per parameter set, and the threads' statistics are merged once at the end.
+	const uint64_t BatchSize = 256;
+	const uint64_t batchesPerSet = (sessionCount + BatchSize - 1) / BatchSize;
+	const uint64_t batchCount = batchesPerSet * parameterSets.size();
+	const uint32_t maxTicks = maxSeconds * 60;
+
+	atomic<uint64_t> nextBatch(0);
+	vector<vector<Statistics>> threadStatistics(threadCount, vector<Statistics>(parameterSets.size(), Statistics(maxSeconds)));
+
+	auto worker = [&](uint32_t threadIndex)
+	{
+		vector<Statistics>& statistics = threadStatistics[threadIndex];
+		for (uint64_t batch = nextBatch++; batch < batchCount; batch = nextBatch++)
+		{
+			const size_t set = static_cast<size_t>(batch / batchesPerSet);
+			const uint64_t begin = (batch % batchesPerSet) * BatchSize;
+			const uint64_t end = min(begin + BatchSize, sessionCount);
+
+			for (uint64_t session = begin; session < end; ++session)
+			{
+				statistics[set].Add(PlaySession(parameterSets[set], SessionSeed(seed, session), maxTicks));
+			}
+		}
+	};
+
+	const auto start = chrono::steady_clock::now();
+
+	vector<thread> threads;
+	for (uint32_t i = 1; i < threadCount; ++i)
+	{
+		threads.emplace_back(worker, i);
+	}
+
+	worker(0);
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	vector<Statistics> statistics(parameterSets.size(), Statistics(maxSeconds));
+	for (const auto& perThread : threadStatistics)
+	{
+		for (size_t set = 0; set < parameterSets.size(); ++set)
+		{
+			statistics[set].Merge(perThread[set]);
+		}
+	}
+
+	WriteReport(cout, parameterSets, statistics);
+
+	if (!reportPath.empty())
+	{
+		ofstream file(reportPath);
+		WriteReport(file, parameterSets, statistics);
+	}
+
+	const double games = static_cast<double>(sessionCount) * static_cast<double>(parameterSets.size());
+	fprintf(stderr, "%zu parameter sets x %llu sessions on %u threads in %.2f s (%.0f games/s)\n", parameterSets.size(),
+		static_cast<unsigned long long>(sessionCount), threadCount, seconds, games / seconds);
+
+	return 0;
+}
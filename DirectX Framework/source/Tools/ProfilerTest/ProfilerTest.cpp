@@ -0,0 +1,188 @@
+// Checks the profiler's zones and trace export, and that a profiling zone stays cheap enough to leave in the game loop.
+// The checks:
+//   - timestamps never go backwards and a 20 ms sleep measures as 20 ms or a little more;
+//   - Profiler::MeasureZoneOverhead, the cost of one ProfileZone with its allocation attribution, is under 50 ns, and the
+//     calibration zones are left out of the trace;
+//   - the trace is valid trace-event JSON with one complete event per retained zone, names escaped, and each thread's ring
+//     keeping only its newest ZonesPerThread zones;
+//   - zones recorded on another thread are exported under their own thread id, and a zone counts the allocations made
+//     inside it.
+//
+// Build with allocation tracking on, as debug builds of the game run, so zones pay for their allocation counts.
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -pthread -DDX_ALLOCATION_TRACKING_ENABLED=1 -I../../Library.Shared ProfilerTest.cpp ../../Library.Shared/Profiler.cpp ../../Library.Shared/AllocationTracker.cpp
+//   cl /O2 /EHsc /DDX_ALLOCATION_TRACKING_ENABLED=1 /I..\..\Library.Shared ProfilerTest.cpp ..\..\Library.Shared\Profiler.cpp ..\..\Library.Shared\AllocationTracker.cpp
+//
+// Usage: ProfilerTest [trace file]
+
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	// The bound the game loop budgets for one zone.
+	const double MaxZoneOverheadNanoseconds = 50.0;
+	const uint32_t OverheadRuns = 5;
+
+	// Keeps the compiler from pairing up and removing the test allocation.
+	int* volatile sAllocation = nullptr;
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	string ReadFile(const string& filename)
+	{
+		ifstream stream(filename);
+		return string(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+	}
+
+	uint32_t CountOccurrences(const string& text, const string& pattern)
+	{
+		uint32_t count = 0;
+		for (size_t position = text.find(pattern); position != string::npos; position = text.find(pattern, position + pattern.size()))
+		{
+			++count;
+		}
+
+		return count;
+	}
+
+	bool CheckTimestamps()
+	{
+		bool passed = Check(Profiler::TimestampFrequency() > 0, "the timestamp frequency is positive");
+
+		int64_t previous = Profiler::Timestamp();
+		bool monotonic = true;
+		for (uint32_t i = 0; i < 100000; ++i)
+		{
+			const int64_t now = Profiler::Timestamp();
+			monotonic &= (now >= previous);
+			previous = now;
+		}
+
+		passed &= Check(monotonic, "timestamps never go backwards");
+
+		const int64_t start = Profiler::Timestamp();
+		this_thread::sleep_for(chrono::milliseconds(20));
+		const double milliseconds = static_cast<double>(Profiler::Timestamp() - start) * 1000.0 / static_cast<double>(Profiler::TimestampFrequency());
+		passed &= Check(milliseconds >= 19.5 && milliseconds < 200.0, "a 20 ms sleep measures as 20 ms");
+		return passed;
+	}
+
+	// Best of several runs, so a preempted run doesn't fail the bound.
+	bool CheckZoneOverhead(const wstring& traceFile, const string& narrowTraceFile)
+	{
+		double best = 1e9;
+		for (uint32_t run = 0; run < OverheadRuns; ++run)
+		{
+			best = min(best, Profiler::MeasureZoneOverhead());
+		}
+
+		printf("zone overhead: %.1f ns (bound %.0f ns)\n", best, MaxZoneOverheadNanoseconds);
+		bool passed = Check(best > 0.0 && best < MaxZoneOverheadNanoseconds, "a profiling zone costs under 50 ns");
+
+		Profiler::Clear();
+		{
+			ProfileZone zone("Kept");
+		}
+
+		Profiler::MeasureZoneOverhead(1000);
+		passed &= Check(Profiler::WriteChromeTrace(traceFile), "the trace is written");
+		const string trace = ReadFile(narrowTraceFile);
+		passed &= Check(trace.find("Profiler::MeasureZoneOverhead") == string::npos, "calibration zones are left out of the trace");
+		return passed;
+	}
+
+	bool CheckTrace(const wstring& traceFile, const string& narrowTraceFile)
+	{
+		Profiler::Clear();
+
+		// Overfill this thread's ring; the oldest zones are overwritten.
+		const uint32_t overflow = 100;
+		const int64_t base = Profiler::Timestamp();
+		Profiler::RecordZone("Dropped", base, base + 1);
+		for (uint32_t i = 1; i < Profiler::ZonesPerThread + overflow; ++i)
+		{
+			Profiler::RecordZone(i + 1 == Profiler::ZonesPerThread + overflow ? "Quoted \"name\"" : "Main", base + i, base + i + 1);
+		}
+
+		// An allocation inside a zone is attributed to it.
+		{
+			ProfileZone zone("Allocating");
+			sAllocation = new int(0);
+			delete sAllocation;
+		}
+
+		thread worker([]()
+		{
+			ProfileZone zone("Worker");
+			this_thread::sleep_for(chrono::milliseconds(1));
+		});
+		worker.join();
+
+		bool passed = Check(Profiler::WriteChromeTrace(traceFile), "the trace is written");
+		const string trace = ReadFile(narrowTraceFile);
+
+		const size_t begin = trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+		passed &= Check(begin == 0 && trace.size() > 4 && trace.compare(trace.size() - 4, 4, "\n]}\n") == 0, "the trace is one JSON object");
+		passed &= Check(CountOccurrences(trace, "\"ph\":\"X\"") == Profiler::ZonesPerThread + 1, "one event per retained zone");
+		passed &= Check(trace.find("\"Dropped\"") == string::npos, "overwritten zones are dropped");
+		passed &= Check(trace.find("\"name\":\"Quoted \\\"name\\\"\"") != string::npos, "names are escaped");
+		passed &= Check(trace.find("\"name\":\"Allocating\",\"ph\":\"X\"") != string::npos, "zones are complete events");
+
+#if DX_ALLOCATION_TRACKING_ENABLED
+		const size_t allocating = trace.find("\"name\":\"Allocating\"");
+		passed &= Check(allocating != string::npos && trace.find("\"args\":{\"allocations\":1}", allocating) < trace.find('\n', allocating),
+			"a zone counts the allocations made inside it");
+#endif
+
+		// The worker's zone is the only event under its thread id.
+		const size_t workerEvent = trace.find("\"name\":\"Worker\"");
+		const size_t mainEvent = trace.find("\"name\":\"Main\"");
+		passed &= Check(workerEvent != string::npos && mainEvent != string::npos, "every thread's zones are exported");
+		if (workerEvent != string::npos && mainEvent != string::npos)
+		{
+			const size_t workerTid = trace.find("\"tid\":", workerEvent);
+			const size_t mainTid = trace.find("\"tid\":", mainEvent);
+			const string workerId = trace.substr(workerTid, trace.find(',', workerTid) - workerTid);
+			const string mainId = trace.substr(mainTid, trace.find(',', mainTid) - mainTid);
+			passed &= Check(workerId != mainId && CountOccurrences(trace, workerId + ",") == 1, "each thread has its own id");
+		}
+
+		Profiler::Clear();
+		return passed;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const string narrowTraceFile = (argc > 1 ? argv[1] : "ProfilerTest.json");
+	const wstring traceFile(narrowTraceFile.begin(), narrowTraceFile.end());
+
+	bool passed = CheckTimestamps();
+	passed &= CheckZoneOverhead(traceFile, narrowTraceFile);
+	passed &= CheckTrace(traceFile, narrowTraceFile);
+
+	remove(narrowTraceFile.c_str());
+
+	printf(passed ? "checks passed\n" : "checks FAILED\n");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
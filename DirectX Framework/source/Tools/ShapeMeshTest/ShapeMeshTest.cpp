@@ -0,0 +1,290 @@
+// Checks the compile-time circle and rounded rectangle meshes of ShapeMeshes and reports the vertices the game's shapes
+// draw with at common screen sizes. The checks:
+//   - the meshes are constants: their vertices are tested with static_assert;
+//   - every circle vertex is the point of the unit circle its strip position names, to float precision;
+//   - rounded rectangle vertices lie on their corner arcs, or on the corners for the square level;
+//   - drawn as triangle strips through a SoftwareRenderBackend with a y-up camera, no triangle is culled and the covered
+//     pixels match each outline's area;
+//   - the level picked for a screen radius is the coarsest within the tolerance, and never coarser for a larger radius;
+//   - a RenderCommandList counts the vertices of its draws and instances, and a DrawSorter keeps the count.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O2 -std=c++14 -pthread -I../../Library.Shared ShapeMeshTest.cpp ../../Library.Shared/ShapeMeshes.cpp ../../Library.Shared/SoftwareRenderBackend.cpp ../../Library.Shared/RenderCommandList.cpp ../../Library.Shared/SpriteBatch.cpp ../../Library.Shared/DrawSorter.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared ShapeMeshTest.cpp ..\..\Library.Shared\ShapeMeshes.cpp ..\..\Library.Shared\SoftwareRenderBackend.cpp ..\..\Library.Shared\RenderCommandList.cpp ..\..\Library.Shared\SpriteBatch.cpp ..\..\Library.Shared\DrawSorter.cpp
+//
+// Usage: ShapeMeshTest
+
+#include "DrawSorter.h"
+#include "RenderCommandList.h"
+#include "ShapeMeshes.h"
+#include "SoftwareRenderBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	typedef SoftwareRenderBackend::ShaderType ShaderType;
+	typedef SoftwareRenderBackend::PrimitiveType PrimitiveType;
+
+	// The game's shapes: a ball of radius 1.5, and the bar's and powerups' rectangles with corners of 0.75, all scaled
+	// by 1.5, seen by a camera 100 units high.
+	const float BallRadius = 1.5f;
+	const float ShapeScale = 1.5f;
+	constexpr float CornerRadius = 0.75f;
+	const float ViewHeight = 100.0f;
+	const uint32_t PreviousShapeVertices = 66;
+
+	constexpr ShapeMeshes::Circles Circles = ShapeMeshes::MakeCircles();
+	constexpr ShapeMeshes::RoundedRects BarRects = ShapeMeshes::MakeRoundedRects(0.0f, -40.0f, 8.0f, -38.0f, CornerRadius);
+
+	// Vertex 0 is the point at angle zero and vertex 1 the last point before it, a step clockwise.
+	static_assert(Circles.Lod0.Vertices[0].Position[0] > 0.9999999f && Circles.Lod0.Vertices[0].Position[1] == 0.0f, "The first circle vertex is (1, 0).");
+	static_assert(Circles.Lod0.Vertices[1].Position[0] > 0.7071f && Circles.Lod0.Vertices[1].Position[0] < 0.7072f && Circles.Lod0.Vertices[1].Position[1] < -0.7071f,
+		"The second circle vertex is a step clockwise.");
+	static_assert(BarRects.Lod0.Vertices[0].Position[0] > 7.9999f && BarRects.Lod0.Vertices[0].Position[1] > -38.0001f, "The square level starts at the top right corner.");
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	const ShapeVertex* CircleVertices(uint32_t lod)
+	{
+		return &Circles.Lod0.Vertices[0] + ShapeMeshes::CircleLod(lod).StartVertex;
+	}
+
+	const ShapeVertex* RoundedRectVertices(const ShapeMeshes::RoundedRects& rects, uint32_t lod)
+	{
+		return &rects.Lod0.Vertices[0] + ShapeMeshes::RoundedRectLod(lod).StartVertex;
+	}
+
+	// The outline point at a strip position: the strip visits 0, N - 1, 1, N - 2, ...
+	uint32_t OutlinePoint(uint32_t vertex, uint32_t count)
+	{
+		return (vertex % 2 == 0 ? vertex / 2 : count - (vertex + 1) / 2);
+	}
+
+	// Shoelace area of the outline the strip covers.
+	double OutlineArea(const ShapeVertex* vertices, uint32_t count)
+	{
+		vector<const ShapeVertex*> outline(count);
+		for (uint32_t vertex = 0; vertex < count; ++vertex)
+		{
+			outline[OutlinePoint(vertex, count)] = &vertices[vertex];
+		}
+
+		double twiceArea = 0.0;
+		for (uint32_t point = 0; point < count; ++point)
+		{
+			const float* a = outline[point]->Position;
+			const float* b = outline[(point + 1) % count]->Position;
+			twiceArea += static_cast<double>(a[0]) * b[1] - static_cast<double>(b[0]) * a[1];
+		}
+
+		return 0.5 * twiceArea;
+	}
+
+	bool CheckCircles()
+	{
+		bool passed = true;
+		for (uint32_t lod = 0; lod < ShapeMeshes::LodCount; ++lod)
+		{
+			const ShapeLod shapeLod = ShapeMeshes::CircleLod(lod);
+			const ShapeVertex* vertices = CircleVertices(lod);
+			float worst = 0.0f;
+			for (uint32_t vertex = 0; vertex < shapeLod.VertexCount; ++vertex)
+			{
+				const double angle = 2.0 * 3.14159265358979323846 * OutlinePoint(vertex, shapeLod.VertexCount) / shapeLod.VertexCount;
+				const float* position = vertices[vertex].Position;
+				worst = max(worst, static_cast<float>(max(fabs(position[0] - cos(angle)), fabs(position[1] - sin(angle)))));
+				passed &= Check(position[2] == 0.0f && position[3] == 1.0f, "shape vertices are points in the xy plane");
+			}
+
+			passed &= Check(worst < 1e-6f, "circle vertices match cos and sin");
+			passed &= Check(OutlineArea(vertices, shapeLod.VertexCount) > 0.0, "circle outlines run counterclockwise");
+		}
+
+		passed &= Check(ShapeMeshes::CircleLod(0).StartVertex == 0 && ShapeMeshes::CircleLod(3).StartVertex == 8 + 16 + 32 && ShapeMeshes::CircleLod(3).VertexCount == 64,
+			"circle levels lie back to back");
+		return passed;
+	}
+
+	bool CheckRoundedRects()
+	{
+		const float left = 0.0f;
+		const float bottom = -40.0f;
+		const float right = 8.0f;
+		const float top = -38.0f;
+		const float corners[4][2] = { { right, top }, { left, top }, { left, bottom }, { right, bottom } };
+		const float centers[4][2] = { { right - CornerRadius, top - CornerRadius }, { left + CornerRadius, top - CornerRadius }, { left + CornerRadius, bottom + CornerRadius },
+			{ right - CornerRadius, bottom + CornerRadius } };
+		const uint32_t cornerSegments[ShapeMeshes::LodCount] = { 0, 2, 4, 8 };
+
+		bool passed = true;
+		for (uint32_t lod = 0; lod < ShapeMeshes::LodCount; ++lod)
+		{
+			const ShapeLod shapeLod = ShapeMeshes::RoundedRectLod(lod);
+			const ShapeVertex* vertices = RoundedRectVertices(BarRects, lod);
+			passed &= Check(shapeLod.VertexCount == 4 * (cornerSegments[lod] + 1), "a rounded rectangle has its corners' points");
+
+			bool onCorners = true;
+			for (uint32_t vertex = 0; vertex < shapeLod.VertexCount; ++vertex)
+			{
+				const uint32_t corner = OutlinePoint(vertex, shapeLod.VertexCount) / (cornerSegments[lod] + 1);
+				const float* position = vertices[vertex].Position;
+				if (cornerSegments[lod] == 0)
+				{
+					onCorners &= (fabs(position[0] - corners[corner][0]) < 1e-5f && fabs(position[1] - corners[corner][1]) < 1e-5f);
+				}
+				else
+				{
+					const float distance = hypot(position[0] - centers[corner][0], position[1] - centers[corner][1]);
+					onCorners &= (fabs(distance - CornerRadius) < 1e-5f);
+				}
+
+				onCorners &= (position[0] >= left - 1e-5f && position[0] <= right + 1e-5f && position[1] >= bottom - 1e-5f && position[1] <= top + 1e-5f);
+			}
+
+			passed &= Check(onCorners, "rounded rectangle vertices lie on their corners' arcs");
+			passed &= Check(OutlineArea(vertices, shapeLod.VertexCount) > 0.0, "rounded rectangle outlines run counterclockwise");
+		}
+
+		const double roundedArea = (right - left) * (top - bottom) - (4.0 - 3.14159265358979323846) * CornerRadius * CornerRadius;
+		passed &= Check(fabs(OutlineArea(RoundedRectVertices(BarRects, 3), 36) - roundedArea) < 0.01 * roundedArea, "the finest level has the rounded rectangle's area");
+		return passed;
+	}
+
+	// Draws a mesh as a triangle strip, scale pixels per unit around the middle of the target, with y up.
+	bool CheckRasterized(const ShapeVertex* vertices, uint32_t count, float scale, float centerX, float centerY, const char* description)
+	{
+		const uint32_t size = 512;
+		SoftwareRenderBackend backend(size, size);
+		const PipelineHandle pipeline = backend.CreatePipeline({ ShaderType::SolidColor, PrimitiveType::TriangleStrip, false });
+		const MeshHandle mesh = backend.CreateMesh({ vertices, count, sizeof(ShapeVertex), 0, 0 });
+
+		const float projection[16] = { 2.0f * scale / size, 0.0f, 0.0f, 2.0f * (size * 0.5f - centerX * scale) / size - 1.0f, 0.0f, 2.0f * scale / size, 0.0f,
+			2.0f * (size * 0.5f - centerY * scale) / size - 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+		const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+		RenderCommandList commandList;
+		commandList.SetPipeline(pipeline);
+		commandList.SetMesh(mesh);
+		commandList.SetConstants(ShaderStage::Vertex, projection);
+		commandList.SetConstants(ShaderStage::Pixel, white);
+		commandList.Draw(count);
+		backend.Execute(commandList);
+
+		const SoftwareRenderBackend::Counters& totals = backend.Totals();
+		const double expected = OutlineArea(vertices, count) * scale * scale;
+		const double perimeterPixels = 4.0 * sqrt(expected);
+		bool passed = Check(totals.CulledTriangles == 0 && totals.Triangles == count - 2, description);
+		passed &= Check(fabs(static_cast<double>(totals.PixelsShaded) - expected) <= 0.01 * expected + perimeterPixels * 0.05, description);
+		return passed;
+	}
+
+	bool CheckRasterization()
+	{
+		bool passed = true;
+		for (uint32_t lod = 0; lod < ShapeMeshes::LodCount; ++lod)
+		{
+			passed &= CheckRasterized(CircleVertices(lod), ShapeMeshes::CircleLod(lod).VertexCount, 200.0f, 0.0f, 0.0f, "circle strips are front facing and cover their area");
+			passed &= CheckRasterized(RoundedRectVertices(BarRects, lod), ShapeMeshes::RoundedRectLod(lod).VertexCount, 50.0f, 4.0f, -39.0f,
+				"rounded rectangle strips are front facing and cover their area");
+		}
+
+		return passed;
+	}
+
+	bool CheckLodSelection()
+	{
+		bool passed = true;
+		uint32_t previousCircle = 0;
+		uint32_t previousRect = 0;
+		for (float radius = 0.0f; radius <= 4000.0f; radius += 0.25f)
+		{
+			const uint32_t circle = ShapeMeshes::SelectCircleLod(radius);
+			const uint32_t rect = ShapeMeshes::SelectRoundedRectLod(radius);
+			const float tolerance = ShapeMeshes::DefaultTolerance;
+
+			passed &= Check(circle == ShapeMeshes::LodCount - 1 || ShapeMeshes::CircleError(circle, radius) <= tolerance, "the circle level is within the tolerance");
+			passed &= Check(circle == 0 || ShapeMeshes::CircleError(circle - 1, radius) > tolerance, "the circle level is the coarsest within the tolerance");
+			passed &= Check(rect == ShapeMeshes::LodCount - 1 || ShapeMeshes::RoundedRectError(rect, radius) <= tolerance, "the corner level is within the tolerance");
+			passed &= Check(rect == 0 || ShapeMeshes::RoundedRectError(rect - 1, radius) > tolerance, "the corner level is the coarsest within the tolerance");
+			passed &= Check(circle >= previousCircle && rect >= previousRect, "larger shapes never get coarser levels");
+			previousCircle = circle;
+			previousRect = rect;
+
+			if (!passed)
+			{
+				break;
+			}
+		}
+
+		// Against the exact sagitta of a 16-gon.
+		passed &= Check(fabs(ShapeMeshes::CircleError(1, 100.0f) - 100.0f * (1.0f - cos(3.14159265f / 16.0f))) < 1e-4f, "circle errors are the chords' sagitta");
+		return passed;
+	}
+
+	bool CheckVertexCounts()
+	{
+		RenderCommandList commandList;
+		commandList.SetPipeline(1);
+		commandList.SetMesh(2);
+		commandList.Draw(16);
+		commandList.DrawInstanced(4, 60);
+		commandList.SetLayer(1);
+		commandList.Draw(20, 16);
+
+		DrawSorter sorter;
+		RenderCommandList sorted;
+		sorter.Sort(commandList, sorted);
+
+		bool passed = Check(commandList.VertexCount() == 16 + 4 * 60 + 20, "a command list counts its draws' vertices and instances");
+		passed &= Check(sorted.VertexCount() == commandList.VertexCount() && sorted.DrawCount() == commandList.DrawCount(), "sorting keeps the vertex count");
+
+		commandList.Clear();
+		passed &= Check(commandList.VertexCount() == 0, "clearing resets the vertex count");
+		return passed;
+	}
+
+	void Report()
+	{
+		printf("%-10s  %-14s  %-14s  %-14s  %s\n", "height", "ball", "bar", "powerup", "vertices per frame (was)");
+		const uint32_t heights[] = { 480, 720, 1080, 1440, 2160 };
+		for (const uint32_t height : heights)
+		{
+			const float pixelsPerUnit = static_cast<float>(height) / ViewHeight;
+			const ShapeLod ball = ShapeMeshes::CircleLod(ShapeMeshes::SelectCircleLod(BallRadius * pixelsPerUnit));
+			const ShapeLod rect = ShapeMeshes::RoundedRectLod(ShapeMeshes::SelectRoundedRectLod(CornerRadius * ShapeScale * pixelsPerUnit));
+
+			// The ball, the bar and a falling powerup.
+			const uint32_t vertices = ball.VertexCount + 2 * rect.VertexCount;
+			printf("%-10u  %3u vertices   %3u vertices   %3u vertices   %u (%u)\n", height, ball.VertexCount, rect.VertexCount, rect.VertexCount, vertices, 3 * PreviousShapeVertices);
+		}
+	}
+}
+
+int main()
+{
+	bool passed = CheckCircles();
+	passed &= CheckRoundedRects();
+	passed &= CheckRasterization();
+	passed &= CheckLodSelection();
+	passed &= CheckVertexCounts();
+
+	Report();
+
+	printf(passed ? "checks passed\n" : "checks FAILED\n");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
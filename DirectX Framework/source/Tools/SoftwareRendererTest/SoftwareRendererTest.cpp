@@ -0,0 +1,786 @@
+// Checks the SoftwareRenderBackend against golden images and measures how fast it draws the game's frame. The stock
+// scene is recorded the way the game's components record it: the field's line strip, the brick wall as one instanced
+// draw, then the bar, ball and powerup from the ShapeMeshes levels of detail their managers select for the target's size.
+// The golden stock scene uses the levels selected at 1920x1080, the 20-vertex rounded rectangles and the 16-vertex
+// circle, so its small image covers the meshes the game draws at full HD. The sprite scene draws a procedural sprite
+// sheet through a SpriteBatch with rotation, scaling and alpha. Both are compared against the images in Golden/ (binary
+// PPM, alpha dropped); a mismatch writes <name>.actual.ppm next to the golden image for inspection.
+// Analytic checks cover exact coverage of pixel-aligned rectangles, shared edges, back-face culling and sprite sampling,
+// and frames rendered on several threads must hash the same as frames rendered on one. Finally the stock scene and the
+// sprite scene are timed at 1920x1080 and 3840x2160 on 1, 2, 4... threads up to the hardware thread count.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared SoftwareRendererTest.cpp ../../Library.Shared/SoftwareRenderBackend.cpp ../../Library.Shared/RenderCommandList.cpp ../../Library.Shared/SpriteBatch.cpp ../../Library.Shared/ShapeMeshes.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared SoftwareRendererTest.cpp ..\..\Library.Shared\SoftwareRenderBackend.cpp ..\..\Library.Shared\RenderCommandList.cpp ..\..\Library.Shared\SpriteBatch.cpp ..\..\Library.Shared\ShapeMeshes.cpp
+// Add -DDX_SOFTWARE_RASTERIZER_SCALAR to check the plain C++ path against the same images.
+//
+// Usage: SoftwareRendererTest [--update] [golden directory] [frames] [threads]
+// Defaults to ./Golden, 60 timed frames per measurement, up to one thread per hardware thread. --update rewrites the
+// golden images instead of comparing.
+
+#include "RenderCommandList.h"
+#include "ShapeMeshes.h"
+#include "SoftwareRenderBackend.h"
+#include "SpriteBatch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	const uint32_t GoldenWidth = 320;
+	const uint32_t GoldenHeight = 180;
+	const uint32_t GoldenLodHeight = 1080;			// Screen height the golden stock scene selects levels of detail for
+	const uint32_t PaletteSize = 8;
+	const float ViewSize = 100.0f;					// OrthographicCamera's default view width and height
+	const float ShapeRadius = 1.5f;					// Bar::Radius, Ball::Radius and Powerup::Radius
+	constexpr float CornerRadius = 0.75f;				// Of BarManager's and PowerupManager's rounded rectangles
+
+	// The vertex buffers of BarManager, PowerupManager and BallManager.
+	constexpr ShapeMeshes::RoundedRects BarMeshes = ShapeMeshes::MakeRoundedRects(0.0f, -40.0f, 8.0f, -38.0f, CornerRadius);
+	constexpr ShapeMeshes::RoundedRects PowerupMeshes = ShapeMeshes::MakeRoundedRects(0.0f, -40.0f, 3.0f, -38.0f, CornerRadius);
+	constexpr ShapeMeshes::Circles BallMeshes = ShapeMeshes::MakeCircles();
+	const uint32_t GoldenTolerance = 2;				// Per channel, for compilers that contract the texture coordinate math
+
+	typedef SoftwareRenderBackend::ShaderType ShaderType;
+	typedef SoftwareRenderBackend::PrimitiveType PrimitiveType;
+
+	struct Vertex
+	{
+		float Position[4];
+	};
+
+	// Mirrors ChunkManager::ChunkInstance.
+	struct ChunkInstance
+	{
+		float Offset[2];
+		float Scale;
+		uint32_t PaletteIndex;
+	};
+
+	struct Matrix
+	{
+		float M[16];
+	};
+
+	// Mirrors ShapeRendererInstancedVS's CBufferPerFrame.
+	struct InstancedConstants
+	{
+		Matrix ViewProjection;
+		float Palette[PaletteSize][4];
+	};
+
+	struct Color
+	{
+		float RGBA[4];
+	};
+
+	const Color AntiqueWhite = { { 0.980f, 0.922f, 0.843f, 1.0f } };
+	const Color CornflowerBlue = { { 0.392f, 0.584f, 0.929f, 1.0f } };
+	const Color PeachPuff = { { 1.0f, 0.855f, 0.725f, 1.0f } };
+	const Color Gold = { { 1.0f, 0.843f, 0.0f, 1.0f } };
+	const Color ChunkColors[] =
+	{
+		{ { 1.0f, 0.412f, 0.706f, 1.0f } },		// HotPink
+		{ { 1.0f, 0.0f, 0.0f, 1.0f } },			// Red
+		{ { 1.0f, 0.647f, 0.0f, 1.0f } },		// Orange
+		{ { 1.0f, 1.0f, 0.0f, 1.0f } },			// Yellow
+		{ { 0.486f, 0.988f, 0.0f, 1.0f } },		// LawnGreen
+		{ { 0.529f, 0.808f, 0.980f, 1.0f } }	// LightSkyBlue
+	};
+
+	// Uniform scale and a translation, then the camera's projection of the 100x100 view, stored transposed like the
+	// constants the components upload.
+	Matrix WorldViewProjection(float scale, float x, float y)
+	{
+		Matrix matrix = {};
+		const float projection = 2.0f / ViewSize;
+		matrix.M[0] = scale * projection;
+		matrix.M[3] = x * projection;
+		matrix.M[5] = scale * projection;
+		matrix.M[7] = y * projection;
+		matrix.M[10] = 1.0f;
+		matrix.M[15] = 1.0f;
+		return matrix;
+	}
+
+	// Pixel coordinates (y down) of a width x height target to clip space.
+	Matrix PixelProjection(uint32_t width, uint32_t height)
+	{
+		Matrix matrix = {};
+		matrix.M[0] = 2.0f / static_cast<float>(width);
+		matrix.M[3] = -1.0f;
+		matrix.M[5] = -2.0f / static_cast<float>(height);
+		matrix.M[7] = 1.0f;
+		matrix.M[10] = 1.0f;
+		matrix.M[15] = 1.0f;
+		return matrix;
+	}
+
+	// ChunkManager's quad: top left, top right, bottom left, bottom right.
+	vector<Vertex> CreateQuad(float width)
+	{
+		const vector<Vertex> vertices =
+		{
+			{ { 0.0f, -38.0f, 0.0f, 1.0f } },
+			{ { width, -38.0f, 0.0f, 1.0f } },
+			{ { 0.0f, -40.0f, 0.0f, 1.0f } },
+			{ { width, -40.0f, 0.0f, 1.0f } }
+		};
+
+		return vertices;
+	}
+
+	// The game's frame, with the pipelines and meshes each component creates. Levels of detail are selected as the
+	// managers select them, from how many pixels a world unit covers on screen.
+	class StockScene final
+	{
+	public:
+		StockScene(SoftwareRenderBackend& backend, uint32_t lodHeight) :
+			mBackend(backend)
+		{
+			const float pixelsPerWorldUnit = static_cast<float>(lodHeight) / ViewSize;
+			mRectLod = ShapeMeshes::RoundedRectLod(ShapeMeshes::SelectRoundedRectLod(CornerRadius * ShapeRadius * pixelsPerWorldUnit));
+			mCircleLod = ShapeMeshes::CircleLod(ShapeMeshes::SelectCircleLod(ShapeRadius * pixelsPerWorldUnit));
+
+			mShapePipeline = backend.CreatePipeline({ ShaderType::SolidColor, PrimitiveType::TriangleStrip, false });
+			mFieldPipeline = backend.CreatePipeline({ ShaderType::SolidColor, PrimitiveType::LineStrip, false });
+			mChunkPipeline = backend.CreatePipeline({ ShaderType::PaletteInstanced, PrimitiveType::TriangleStrip, false });
+
+			const vector<Vertex> field =
+			{
+				{ { -45.0f, 40.0f, 0.0f, 1.0f } },
+				{ { 45.0f, 40.0f, 0.0f, 1.0f } },
+				{ { 45.0f, 20.0f, 0.0f, 1.0f } },
+				{ { -45.0f, 20.0f, 0.0f, 1.0f } }
+			};
+			mFieldMesh = CreateMesh(field, 0);
+			mBarMesh = CreateShapeMesh(BarMeshes);
+			mPowerupMesh = CreateShapeMesh(PowerupMeshes);
+			mBallMesh = CreateShapeMesh(BallMeshes);
+			mChunkMesh = CreateMesh(CreateQuad(6.0f), 60);
+
+			// ChunkManager::InitializeChunks: six rows of ten bricks, colored by row.
+			for (uint32_t i = 0; i < 60; ++i)
+			{
+				const uint32_t row = i / 10;
+				mChunks.push_back({ { -45.0f + 9.0f * static_cast<float>(i % 10), 97.0f - 3.0f * static_cast<float>(row) }, 1.5f, row % 6 });
+			}
+
+			mConstants.ViewProjection = WorldViewProjection(1.0f, 0.0f, 0.0f);
+			memset(mConstants.Palette, 0, sizeof(mConstants.Palette));
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				memcpy(mConstants.Palette[i], ChunkColors[i].RGBA, sizeof(mConstants.Palette[i]));
+			}
+		}
+
+		StockScene(const StockScene&) = delete;
+		StockScene& operator=(const StockScene&) = delete;
+
+		// Moves the ball and bar a little each frame so timed frames aren't identical.
+		void Record(RenderCommandList& commandList, uint32_t frame)
+		{
+			static const float Black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			const float phase = static_cast<float>(frame % 120) / 120.0f;
+
+			commandList.ClearRenderTarget(Black);
+
+			commandList.SetPipeline(mFieldPipeline);
+			commandList.SetMesh(mFieldMesh);
+			commandList.SetConstants(ShaderStage::Vertex, WorldViewProjection(1.0f, 0.0f, 0.0f));
+			commandList.SetConstants(ShaderStage::Pixel, AntiqueWhite);
+			commandList.Draw(4);
+
+			commandList.SetPipeline(mChunkPipeline);
+			commandList.SetMesh(mChunkMesh);
+			commandList.SetConstants(ShaderStage::Vertex, mConstants);
+			commandList.UpdateInstances(mChunks.data(), static_cast<uint32_t>(mChunks.size()));
+			commandList.DrawInstanced(4, static_cast<uint32_t>(mChunks.size()));
+
+			commandList.SetPipeline(mShapePipeline);
+			commandList.SetMesh(mBarMesh);
+			commandList.SetConstants(ShaderStage::Vertex, WorldViewProjection(ShapeRadius, -6.0f + 20.0f * phase, 15.0f));
+			commandList.SetConstants(ShaderStage::Pixel, CornflowerBlue);
+			commandList.Draw(mRectLod.VertexCount, mRectLod.StartVertex);
+
+			commandList.SetMesh(mBallMesh);
+			commandList.SetConstants(ShaderStage::Vertex, WorldViewProjection(ShapeRadius, -10.0f + 30.0f * phase, -10.0f + 15.0f * phase));
+			commandList.SetConstants(ShaderStage::Pixel, PeachPuff);
+			commandList.Draw(mCircleLod.VertexCount, mCircleLod.StartVertex);
+
+			commandList.SetMesh(mPowerupMesh);
+			commandList.SetConstants(ShaderStage::Vertex, WorldViewProjection(ShapeRadius, 20.0f, 60.0f - 20.0f * phase));
+			commandList.SetConstants(ShaderStage::Pixel, Gold);
+			commandList.Draw(mRectLod.VertexCount, mRectLod.StartVertex);
+		}
+
+		ShapeLod RectLod() const
+		{
+			return mRectLod;
+		}
+
+		ShapeLod CircleLod() const
+		{
+			return mCircleLod;
+		}
+
+	private:
+		MeshHandle CreateMesh(const vector<Vertex>& vertices, uint32_t instanceCapacity)
+		{
+			return mBackend.CreateMesh({ vertices.data(), static_cast<uint32_t>(vertices.size()), sizeof(Vertex), instanceCapacity, sizeof(ChunkInstance) });
+		}
+
+		// A whole set of levels in one vertex buffer, as the managers upload it.
+		template <typename Meshes>
+		MeshHandle CreateShapeMesh(const Meshes& meshes)
+		{
+			return mBackend.CreateMesh({ &meshes, static_cast<uint32_t>(sizeof(Meshes) / sizeof(ShapeVertex)), sizeof(ShapeVertex), 0, sizeof(ChunkInstance) });
+		}
+
+		SoftwareRenderBackend& mBackend;
+		PipelineHandle mShapePipeline;
+		PipelineHandle mFieldPipeline;
+		PipelineHandle mChunkPipeline;
+		MeshHandle mFieldMesh;
+		MeshHandle mBarMesh;
+		MeshHandle mPowerupMesh;
+		MeshHandle mBallMesh;
+		MeshHandle mChunkMesh;
+		ShapeLod mRectLod;
+		ShapeLod mCircleLod;
+		vector<ChunkInstance> mChunks;
+		InstancedConstants mConstants;
+	};
+
+	// A 2x2 sheet of 32x32 cells: discs with soft edges over transparent corners, each with its own color and stripes.
+	SpriteTextureHandle CreateSpriteSheet(SoftwareRenderBackend& backend)
+	{
+		const uint32_t size = 64;
+		vector<uint8_t> pixels(size * size * 4);
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				const uint32_t cell = (y / 32) * 2 + (x / 32);
+				const float dx = static_cast<float>(x % 32) + 0.5f - 16.0f;
+				const float dy = static_cast<float>(y % 32) + 0.5f - 16.0f;
+				const float distance = sqrt(dx * dx + dy * dy);
+				const float coverage = min(max(15.0f - distance, 0.0f), 1.0f);
+				const bool stripe = (((x + y) / 4) % 2) == 0;
+
+				uint8_t* pixel = &pixels[(y * size + x) * 4];
+				pixel[0] = static_cast<uint8_t>((cell & 1) != 0 ? 240 : (stripe ? 200 : 60));
+				pixel[1] = static_cast<uint8_t>((cell & 2) != 0 ? 220 : (stripe ? 120 : 30));
+				pixel[2] = static_cast<uint8_t>(cell == 3 ? 40 : (stripe ? 250 : 90));
+				pixel[3] = static_cast<uint8_t>(coverage * 255.0f + 0.5f);
+			}
+		}
+
+		return backend.CreateTexture(size, size, pixels.data(), size * 4);
+	}
+
+	// Overlapping sprites in rows of 25 spread over the view, each cell of the sheet at a different size and angle.
+	void DrawSprites(SpriteBatch& batch, SoftwareRenderBackend& backend, SpriteTextureHandle sheet, uint32_t count, uint32_t frame)
+	{
+		batch.Begin(backend);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t cell = i % 4;
+			const float column = static_cast<float>(i % 25);
+			const float row = static_cast<float>(i / 25);
+			const float scale = 2.0f + static_cast<float>(i % 5) * 0.5f;
+
+			SpriteInstance sprite;
+			sprite.Position[0] = -48.0f + column * 4.0f;
+			sprite.Position[1] = 45.0f - row * 90.0f / static_cast<float>(max((count + 24) / 25 - 1, 1U));
+			sprite.Scale[0] = scale;
+			sprite.Scale[1] = scale;
+			sprite.UVRect[0] = static_cast<float>(cell & 1) * 0.5f;
+			sprite.UVRect[1] = static_cast<float>(cell >> 1) * 0.5f;
+			sprite.UVRect[2] = sprite.UVRect[0] + 0.5f;
+			sprite.UVRect[3] = sprite.UVRect[1] + 0.5f;
+			sprite.Rotation = static_cast<float>(i) * 0.37f + static_cast<float>(frame) * 0.01f;
+			batch.Draw(sheet, sprite);
+		}
+
+		batch.End();
+	}
+
+	struct Image
+	{
+		uint32_t Width;
+		uint32_t Height;
+		vector<uint8_t> RGB;
+	};
+
+	Image Capture(const SoftwareRenderBackend& backend)
+	{
+		Image image = { backend.Width(), backend.Height(), vector<uint8_t>(static_cast<size_t>(backend.Width()) * backend.Height() * 3) };
+		for (uint32_t y = 0; y < image.Height; ++y)
+		{
+			const uint32_t* row = backend.Pixels() + static_cast<size_t>(y) * backend.RowPitch();
+			for (uint32_t x = 0; x < image.Width; ++x)
+			{
+				uint8_t* pixel = &image.RGB[(static_cast<size_t>(y) * image.Width + x) * 3];
+				pixel[0] = static_cast<uint8_t>(row[x] & 0xFF);
+				pixel[1] = static_cast<uint8_t>((row[x] >> 8) & 0xFF);
+				pixel[2] = static_cast<uint8_t>((row[x] >> 16) & 0xFF);
+			}
+		}
+
+		return image;
+	}
+
+	bool WritePpm(const string& path, const Image& image)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		fprintf(file, "P6\n%u %u\n255\n", image.Width, image.Height);
+		const bool written = (fwrite(image.RGB.data(), 1, image.RGB.size(), file) == image.RGB.size());
+		fclose(file);
+		return written;
+	}
+
+	bool ReadPpm(const string& path, Image& image)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		unsigned int width = 0;
+		unsigned int height = 0;
+		unsigned int maximum = 0;
+		bool read = (fscanf(file, "P6 %u %u %u", &width, &height, &maximum) == 3 && maximum == 255 && fgetc(file) != EOF);
+		if (read)
+		{
+			image.Width = width;
+			image.Height = height;
+			image.RGB.resize(static_cast<size_t>(width) * height * 3);
+			read = (fread(image.RGB.data(), 1, image.RGB.size(), file) == image.RGB.size());
+		}
+
+		fclose(file);
+		return read;
+	}
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool CompareWithGolden(const string& directory, const char* name, const Image& actual, bool update)
+	{
+		const string path = directory + "/" + name + ".ppm";
+		if (update)
+		{
+			const bool written = WritePpm(path, actual);
+			printf("%-24s %s\n", name, written ? "updated" : "can't write");
+			return written;
+		}
+
+		Image golden;
+		if (!ReadPpm(path, golden))
+		{
+			printf("%-24s can't read %s\n", name, path.c_str());
+			return false;
+		}
+
+		uint32_t mismatches = 0;
+		uint32_t largest = 0;
+		if (golden.Width == actual.Width && golden.Height == actual.Height)
+		{
+			for (size_t i = 0; i < actual.RGB.size(); i += 3)
+			{
+				uint32_t difference = 0;
+				for (size_t channel = 0; channel < 3; ++channel)
+				{
+					difference = max(difference, static_cast<uint32_t>(abs(actual.RGB[i + channel] - golden.RGB[i + channel])));
+				}
+
+				largest = max(largest, difference);
+				mismatches += (difference > GoldenTolerance ? 1 : 0);
+			}
+		}
+		else
+		{
+			mismatches = actual.Width * actual.Height;
+		}
+
+		const bool matched = (mismatches == 0);
+		printf("%-24s %s (largest difference %u, %u pixels over %u)\n", name, matched ? "matches" : "DIFFERS", largest, mismatches, GoldenTolerance);
+		if (!matched)
+		{
+			WritePpm(directory + "/" + name + ".actual.ppm", actual);
+		}
+
+		return matched;
+	}
+
+	uint32_t CountPixels(const SoftwareRenderBackend& backend, uint32_t color)
+	{
+		uint32_t count = 0;
+		for (uint32_t y = 0; y < backend.Height(); ++y)
+		{
+			const uint32_t* row = backend.Pixels() + static_cast<size_t>(y) * backend.RowPitch();
+			count += static_cast<uint32_t>(count_if(row, row + backend.Width(), [color](uint32_t pixel) { return pixel == color; }));
+		}
+
+		return count;
+	}
+
+	// Rectangles with pixel-aligned corners cover exactly their pixels, however they are split into triangles; reversed
+	// winding covers nothing.
+	bool CheckCoverage()
+	{
+		SoftwareRenderBackend backend(GoldenWidth, GoldenHeight);
+		const PipelineHandle strip = backend.CreatePipeline({ ShaderType::SolidColor, PrimitiveType::TriangleStrip, false });
+		const PipelineHandle list = backend.CreatePipeline({ ShaderType::SolidColor, PrimitiveType::TriangleList, false });
+
+		const Vertex rectangle[] =
+		{
+			{ { 13.0f, 21.0f, 0.0f, 1.0f } },
+			{ { 77.0f, 21.0f, 0.0f, 1.0f } },
+			{ { 13.0f, 60.0f, 0.0f, 1.0f } },
+			{ { 77.0f, 60.0f, 0.0f, 1.0f } }
+		};
+		const Vertex reversed[] = { rectangle[1], rectangle[0], rectangle[3], rectangle[2] };
+
+		// A fan of thin triangles around an off-center point, exercising every edge orientation.
+		vector<Vertex> fan;
+		const float fanCorners[][2] = { { 100.0f, 10.0f }, { 173.0f, 10.0f }, { 173.0f, 90.0f }, { 100.0f, 90.0f } };
+		for (uint32_t side = 0; side < 4; ++side)
+		{
+			const float* from = fanCorners[side];
+			const float* to = fanCorners[(side + 1) % 4];
+			for (uint32_t step = 0; step < 7; ++step)
+			{
+				const float t0 = static_cast<float>(step) / 7.0f;
+				const float t1 = static_cast<float>(step + 1) / 7.0f;
+				fan.push_back({ { from[0] + (to[0] - from[0]) * t0, from[1] + (to[1] - from[1]) * t0, 0.0f, 1.0f } });
+				fan.push_back({ { from[0] + (to[0] - from[0]) * t1, from[1] + (to[1] - from[1]) * t1, 0.0f, 1.0f } });
+				fan.push_back({ { 131.3f, 47.7f, 0.0f, 1.0f } });
+			}
+		}
+
+		const MeshHandle rectangleMesh = backend.CreateMesh({ rectangle, 4, sizeof(Vertex), 0, 0 });
+		const MeshHandle reversedMesh = backend.CreateMesh({ reversed, 4, sizeof(Vertex), 0, 0 });
+		const MeshHandle fanMesh = backend.CreateMesh({ fan.data(), static_cast<uint32_t>(fan.size()), sizeof(Vertex), 0, 0 });
+		const Color green = { { 0.0f, 1.0f, 0.0f, 1.0f } };
+
+		RenderCommandList commandList;
+		commandList.SetPipeline(strip);
+		commandList.SetConstants(ShaderStage::Vertex, PixelProjection(GoldenWidth, GoldenHeight));
+		commandList.SetConstants(ShaderStage::Pixel, green);
+		commandList.SetMesh(rectangleMesh);
+		commandList.Draw(4);
+		commandList.SetMesh(reversedMesh);
+		commandList.Draw(4);
+		commandList.SetPipeline(list);
+		commandList.SetConstants(ShaderStage::Vertex, PixelProjection(GoldenWidth, GoldenHeight));
+		commandList.SetConstants(ShaderStage::Pixel, green);
+		commandList.SetMesh(fanMesh);
+		commandList.Draw(static_cast<uint32_t>(fan.size()));
+		backend.Execute(commandList);
+
+		const uint32_t expected = 64 * 39 + 73 * 80;
+		const SoftwareRenderBackend::Counters& totals = backend.Totals();
+		bool passed = Check(CountPixels(backend, 0xFF00FF00) == expected, "pixel-aligned rectangles cover exactly their pixels");
+		passed &= Check(totals.PixelsShaded == expected, "shared edges shade each pixel once");
+		passed &= Check(totals.CulledTriangles == 2, "reversed winding is culled");
+		return passed;
+	}
+
+	// Half-transparent triangles meeting along shared edges: a seam would show as a pixel blended twice or not at all.
+	bool CheckBlendedSeams()
+	{
+		SoftwareRenderBackend backend(GoldenWidth, GoldenHeight);
+		const PipelineHandle pipeline = backend.CreatePipeline({ ShaderType::SolidColor, PrimitiveType::TriangleStrip, true });
+		const MeshHandle mesh = backend.CreateMesh({ &BallMeshes, static_cast<uint32_t>(sizeof(BallMeshes) / sizeof(ShapeVertex)), sizeof(ShapeVertex), 0, 0 });
+		const ShapeLod lod = ShapeMeshes::CircleLod(2);
+
+		// The ball's 32-sided level, scaled up and placed off the pixel grid. Its strip zigzags across the circle, so every
+		// triangle shares its inner edges with two others.
+		const Color white = { { 1.0f, 1.0f, 1.0f, 0.5f } };
+		Matrix transform = PixelProjection(GoldenWidth, GoldenHeight);
+		transform.M[0] *= 61.7f;
+		transform.M[5] *= -61.7f;
+		transform.M[3] += 160.3f * 2.0f / GoldenWidth;
+		transform.M[7] -= 90.6f * 2.0f / GoldenHeight;
+
+		RenderCommandList commandList;
+		commandList.SetPipeline(pipeline);
+		commandList.SetMesh(mesh);
+		commandList.SetConstants(ShaderStage::Vertex, transform);
+		commandList.SetConstants(ShaderStage::Pixel, white);
+		commandList.Draw(lod.VertexCount, lod.StartVertex);
+		backend.Execute(commandList);
+
+		const uint32_t once = 0x80808080;
+		uint32_t blendedOnce = 0;
+		uint32_t other = 0;
+		for (uint32_t y = 0; y < backend.Height(); ++y)
+		{
+			const uint32_t* row = backend.Pixels() + static_cast<size_t>(y) * backend.RowPitch();
+			for (uint32_t x = 0; x < backend.Width(); ++x)
+			{
+				blendedOnce += (row[x] == once ? 1 : 0);
+				other += (row[x] != once && row[x] != 0 ? 1 : 0);
+			}
+		}
+
+		// Area of the 32-gon with circumradius 61.7 is about 11,850 pixels.
+		bool passed = Check(other == 0, "blended triangles leave no seams or overlaps");
+		passed &= Check(blendedOnce > 11700 && blendedOnce < 12000, "blended circle covers its area");
+		return passed;
+	}
+
+	// A sprite drawn texel for texel reproduces its texture; transparent texels leave the background alone.
+	bool CheckSpriteSampling()
+	{
+		SoftwareRenderBackend backend(GoldenWidth, GoldenHeight);
+		const uint32_t size = 16;
+		vector<uint8_t> pixels(size * size * 4);
+		for (uint32_t i = 0; i < size * size; ++i)
+		{
+			pixels[i * 4 + 0] = static_cast<uint8_t>(i * 7);
+			pixels[i * 4 + 1] = static_cast<uint8_t>(255 - i);
+			pixels[i * 4 + 2] = static_cast<uint8_t>(i * 13);
+			pixels[i * 4 + 3] = 255;
+		}
+
+		const SpriteTextureHandle texture = backend.CreateTexture(size, size, pixels.data(), size * 4);
+
+		// Pixel coordinates with y up, as the world is, so the sprite keeps its winding: x 32..48, rows 22..38 from the top.
+		Matrix projection = PixelProjection(GoldenWidth, GoldenHeight);
+		projection.M[5] = -projection.M[5];
+		projection.M[7] = -projection.M[7];
+		backend.SetSpriteViewProjection(projection.M);
+
+		SpriteBatch batch;
+		batch.Begin(backend);
+		SpriteInstance sprite = { { 40.0f, static_cast<float>(GoldenHeight) - 30.0f }, { 8.0f, 8.0f }, { 0.0f, 0.0f, 1.0f, 1.0f }, 0.0f };
+		batch.Draw(texture, sprite);
+		batch.End();
+
+		uint32_t largest = 0;
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			const uint32_t* row = backend.Pixels() + static_cast<size_t>(22 + y) * backend.RowPitch() + 32;
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				const uint8_t* texel = &pixels[(y * size + x) * 4];
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					largest = max(largest, static_cast<uint32_t>(abs(static_cast<int>((row[x] >> (channel * 8)) & 0xFF) - texel[channel])));
+				}
+			}
+		}
+
+		bool passed = Check(largest <= 1, "texel-aligned sprite reproduces its texture");
+		passed &= Check(backend.Totals().PixelsShaded == size * size, "sprite covers exactly its pixels");
+		return passed;
+	}
+
+	uint64_t HashPixels(const SoftwareRenderBackend& backend)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (uint32_t y = 0; y < backend.Height(); ++y)
+		{
+			const uint32_t* row = backend.Pixels() + static_cast<size_t>(y) * backend.RowPitch();
+			for (uint32_t x = 0; x < backend.Width(); ++x)
+			{
+				hash = (hash ^ row[x]) * 1099511628211ULL;
+			}
+		}
+
+		return hash;
+	}
+
+	// Renders a few frames of both scenes at a size that leaves partial tiles on the right and bottom, and hashes each.
+	vector<uint64_t> RenderFrameHashes(uint32_t threadCount, uint64_t& pixelsShaded)
+	{
+		const uint32_t width = 1000;
+		const uint32_t height = 650;
+		vector<uint64_t> hashes;
+
+		SoftwareRenderBackend backend(width, height, threadCount);
+		StockScene scene(backend, height);
+		const SpriteTextureHandle sheet = CreateSpriteSheet(backend);
+		backend.SetSpriteViewProjection(WorldViewProjection(1.0f, 0.0f, 0.0f).M);
+		SpriteBatch batch;
+		RenderCommandList commandList;
+
+		for (uint32_t frame = 0; frame < 4; ++frame)
+		{
+			commandList.Clear();
+			scene.Record(commandList, frame * 7);
+			backend.Execute(commandList);
+			hashes.push_back(HashPixels(backend));
+
+			DrawSprites(batch, backend, sheet, 150, frame);
+			hashes.push_back(HashPixels(backend));
+		}
+
+		pixelsShaded = backend.Totals().PixelsShaded;
+		return hashes;
+	}
+
+	bool CheckDeterminism(uint32_t maxThreads)
+	{
+		uint64_t expectedPixels = 0;
+		const vector<uint64_t> expected = RenderFrameHashes(1, expectedPixels);
+
+		bool passed = true;
+		for (uint32_t threadCount : { 2U, 3U, 8U, max(maxThreads, 1U) })
+		{
+			uint64_t pixels = 0;
+			passed &= Check(RenderFrameHashes(threadCount, pixels) == expected, "frames match the single-threaded frames");
+			passed &= Check(pixels == expectedPixels, "pixel counts match the single-threaded counts");
+		}
+
+		return passed;
+	}
+
+	template <typename Frame>
+	double FramesPerSecond(uint32_t frames, Frame frame)
+	{
+		frame(0);
+		const auto start = chrono::high_resolution_clock::now();
+		for (uint32_t i = 1; i <= frames; ++i)
+		{
+			frame(i);
+		}
+
+		const double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+		return static_cast<double>(frames) / seconds;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int argument = 1;
+	const bool update = (argc > 1 && strcmp(argv[1], "--update") == 0);
+	argument += (update ? 1 : 0);
+
+	const string goldenDirectory = (argc > argument ? argv[argument] : "Golden");
+	const uint32_t frames = (argc > argument + 1 ? static_cast<uint32_t>(strtoul(argv[argument + 1], nullptr, 10)) : 60);
+	uint32_t maxThreads = (argc > argument + 2 ? static_cast<uint32_t>(strtoul(argv[argument + 2], nullptr, 10)) : 0);
+	if (maxThreads == 0)
+	{
+		maxThreads = max(thread::hardware_concurrency(), 1U);
+	}
+
+#if defined(DX_SOFTWARE_RASTERIZER_SCALAR)
+	printf("scalar rasterizer\n\n");
+#else
+	printf("vectorized rasterizer\n\n");
+#endif
+
+	// Golden images are checked with one thread and with several, and only written from the single-threaded frame.
+	bool passed = true;
+	for (uint32_t threadCount : { 1U, 4U })
+	{
+		const bool write = (update && threadCount == 1);
+		{
+			SoftwareRenderBackend backend(GoldenWidth, GoldenHeight, threadCount);
+			StockScene scene(backend, GoldenLodHeight);
+			RenderCommandList commandList;
+			scene.Record(commandList, 30);
+			backend.Execute(commandList);
+			passed &= Check(scene.RectLod().VertexCount == 20 && scene.CircleLod().VertexCount == 16, "the golden stock scene draws the full HD levels of detail");
+			passed &= CompareWithGolden(goldenDirectory, "StockScene", Capture(backend), write);
+		}
+
+		{
+			SoftwareRenderBackend backend(GoldenWidth, GoldenHeight, threadCount);
+			const SpriteTextureHandle sheet = CreateSpriteSheet(backend);
+			backend.SetSpriteViewProjection(WorldViewProjection(1.0f, 0.0f, 0.0f).M);
+			SpriteBatch batch;
+			DrawSprites(batch, backend, sheet, 200, 0);
+			passed &= CompareWithGolden(goldenDirectory, "SpriteScene", Capture(backend), write);
+		}
+	}
+
+	passed &= CheckCoverage();
+	passed &= CheckBlendedSeams();
+	passed &= CheckSpriteSampling();
+	passed &= CheckDeterminism(maxThreads);
+
+	vector<uint32_t> threadCounts;
+	for (uint32_t threadCount = 1; threadCount < maxThreads; threadCount *= 2)
+	{
+		threadCounts.push_back(threadCount);
+	}
+
+	threadCounts.push_back(maxThreads);
+
+	const uint32_t spriteCount = 200;
+	const uint32_t sizes[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+	for (const auto& size : sizes)
+	{
+		printf("\n%ux%u, %u frames per measurement\n", size[0], size[1], frames);
+		printf("threads  stock frames/s  speedup  %u sprites frames/s  speedup  sprite frame: tiles  bin entries  stolen tiles\n", spriteCount);
+
+		double stockBaseline = 0.0;
+		double spriteBaseline = 0.0;
+		for (uint32_t threadCount : threadCounts)
+		{
+			SoftwareRenderBackend backend(size[0], size[1], threadCount);
+			StockScene scene(backend, size[1]);
+			RenderCommandList commandList;
+			const double stockFps = FramesPerSecond(frames, [&](uint32_t frame)
+			{
+				commandList.Clear();
+				scene.Record(commandList, frame);
+				backend.Execute(commandList);
+			});
+
+			const SpriteTextureHandle sheet = CreateSpriteSheet(backend);
+			backend.SetSpriteViewProjection(WorldViewProjection(1.0f, 0.0f, 0.0f).M);
+			SpriteBatch batch;
+			const Color black = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+			RenderCommandList clear;
+			clear.ClearRenderTarget(black.RGBA);
+
+			backend.ResetCounters();
+			const double spriteFps = FramesPerSecond(frames, [&](uint32_t frame)
+			{
+				backend.Execute(clear);
+				DrawSprites(batch, backend, sheet, spriteCount, frame);
+			});
+
+			stockBaseline = (stockBaseline > 0.0 ? stockBaseline : stockFps);
+			spriteBaseline = (spriteBaseline > 0.0 ? spriteBaseline : spriteFps);
+			const SoftwareRenderBackend::Counters& totals = backend.Totals();
+			const double executions = static_cast<double>(totals.Executions);
+			printf("%-8u %-15.1f %-8.2f %-19.1f %-8.2f %-20.0f %-12.0f %.1f\n", threadCount, stockFps, stockFps / stockBaseline, spriteFps,
+				spriteFps / spriteBaseline, static_cast<double>(totals.TilesRasterized) / executions, static_cast<double>(totals.BinEntries) / executions,
+				static_cast<double>(totals.StolenTiles) / executions);
+		}
+	}
+
+	printf("\n%s\n", passed ? "All checks passed." : "Checks FAILED.");
+	return (passed ? 0 : 1);
+}
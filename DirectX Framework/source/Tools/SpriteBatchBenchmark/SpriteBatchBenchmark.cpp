@@ -0,0 +1,343 @@
+// Compares the CPU cost of submitting a sprite grid one draw per sprite (world-view-projection and texture transform
+// constants per sprite, as SpriteDemoManager used to) against the SpriteBatch, which writes instances into mapped storage
+// and draws each run of same-texture sprites at once. The batch writes into a ring buffer sized like
+// D3D11SpriteBatchTarget's, and the results are checked against the sprites that were submitted.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -I../../Library.Shared SpriteBatchBenchmark.cpp ../../Library.Shared/SpriteBatch.cpp ../../Library.Shared/RenderCommandList.cpp ../../Library.Shared/RecordingRenderBackend.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared SpriteBatchBenchmark.cpp ..\..\Library.Shared\SpriteBatch.cpp ..\..\Library.Shared\RenderCommandList.cpp ..\..\Library.Shared\RecordingRenderBackend.cpp
+//
+// Usage: SpriteBatchBenchmark [sprite count...]
+// Defaults to 8, 64, 1024, 16384, 262144 and 1048576 sprites.
+
+#include "RecordingRenderBackend.h"
+#include "RenderCommandList.h"
+#include "SpriteBatch.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	const uint32_t RingCapacity = 64 * 1024;	// D3D11SpriteBatchTarget::DefaultInstanceCapacity
+	const uint32_t SheetColumns = 8;
+	const uint32_t SheetRows = 4;
+
+	struct Matrix
+	{
+		float M[4][4];
+	};
+
+	struct PerSpriteConstants
+	{
+		Matrix WorldViewProjection;
+		Matrix TextureTransform;
+	};
+
+	struct Sprite
+	{
+		float X;
+		float Y;
+		float Rotation;
+		uint32_t Column;
+		uint32_t Mood;
+		SpriteTextureHandle Texture;
+	};
+
+	Matrix Multiply(const Matrix& lhs, const Matrix& rhs)
+	{
+		Matrix result;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				result.M[row][column] = lhs.M[row][0] * rhs.M[0][column] + lhs.M[row][1] * rhs.M[1][column] +
+					lhs.M[row][2] * rhs.M[2][column] + lhs.M[row][3] * rhs.M[3][column];
+			}
+		}
+
+		return result;
+	}
+
+	Matrix Transpose(const Matrix& matrix)
+	{
+		Matrix result;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				result.M[row][column] = matrix.M[column][row];
+			}
+		}
+
+		return result;
+	}
+
+	// A grid laid out like SpriteDemoManager::InitializeSprites. Sprites are grouped into textureCount equal runs.
+	vector<Sprite> CreateGrid(uint32_t spriteCount, uint32_t textureCount)
+	{
+		vector<Sprite> sprites(spriteCount);
+		const uint32_t columns = 256;
+		for (uint32_t i = 0; i < spriteCount; ++i)
+		{
+			sprites[i].X = 6.0f * static_cast<float>(i % columns);
+			sprites[i].Y = 6.0f * static_cast<float>(i / columns);
+			sprites[i].Rotation = 0.0f;
+			sprites[i].Column = i % SheetColumns;
+			sprites[i].Mood = (i / SheetColumns) % SheetRows;
+			sprites[i].Texture = static_cast<SpriteTextureHandle>(static_cast<uint64_t>(i) * textureCount / spriteCount);
+		}
+
+		return sprites;
+	}
+
+	// Stands in for D3D11SpriteBatchTarget: a ring of instances that starts over when it wraps, and a record of the draws.
+	class MemoryTarget final : public SpriteBatchTarget
+	{
+	public:
+		explicit MemoryTarget(uint32_t capacity) :
+			mRing(capacity), mWriteOffset(capacity)
+		{
+		}
+
+		virtual SpriteInstance* Map(uint32_t& capacity, uint32_t& firstInstance) override
+		{
+			if (mWriteOffset >= mRing.size())
+			{
+				mWriteOffset = 0;
+			}
+
+			capacity = static_cast<uint32_t>(mRing.size()) - mWriteOffset;
+			firstInstance = mWriteOffset;
+			return mRing.data() + mWriteOffset;
+		}
+
+		virtual void Unmap(uint32_t instanceCount) override
+		{
+			mWriteOffset += instanceCount;
+		}
+
+		virtual void DrawBatch(SpriteTextureHandle texture, uint32_t firstInstance, uint32_t instanceCount) override
+		{
+			mDraws.push_back(Draw{ texture, firstInstance, instanceCount });
+		}
+
+		struct Draw
+		{
+			SpriteTextureHandle Texture;
+			uint32_t FirstInstance;
+			uint32_t InstanceCount;
+		};
+
+		vector<SpriteInstance> mRing;
+		uint32_t mWriteOffset;
+		vector<Draw> mDraws;
+	};
+
+	SpriteInstance MakeInstance(const Sprite& sprite)
+	{
+		const float uvWidth = 1.0f / SheetColumns;
+		const float uvHeight = 1.0f / SheetRows;
+		const float left = uvWidth * static_cast<float>(sprite.Column);
+		const float top = uvHeight * static_cast<float>(sprite.Mood);
+		const SpriteInstance instance = { { sprite.X, sprite.Y }, { 3.0f, 3.0f }, { left, top, left + uvWidth, top + uvHeight }, sprite.Rotation };
+		return instance;
+	}
+
+	// What SpriteDemoManager::DrawSprite did per sprite: build the world matrix, multiply it by the view-projection, transpose
+	// it and the texture transform into a constant buffer and draw the indexed quad.
+	void RecordPerSprite(RenderCommandList& commandList, const vector<Sprite>& sprites, const Matrix& viewProjection)
+	{
+		commandList.Clear();
+		commandList.SetPipeline(0);
+		commandList.SetMesh(0);
+
+		PerSpriteConstants constants;
+		for (const Sprite& sprite : sprites)
+		{
+			const float cosine = cos(sprite.Rotation);
+			const float sine = sin(sprite.Rotation);
+			const Matrix world = { { { 3.0f * cosine, 3.0f * sine, 0, 0 }, { -3.0f * sine, 3.0f * cosine, 0, 0 }, { 0, 0, 1, 0 }, { sprite.X, sprite.Y, 0, 1 } } };
+			constants.WorldViewProjection = Transpose(Multiply(world, viewProjection));
+
+			const SpriteInstance instance = MakeInstance(sprite);
+			const Matrix textureTransform = { { { instance.UVRect[2] - instance.UVRect[0], 0, 0, 0 }, { 0, instance.UVRect[3] - instance.UVRect[1], 0, 0 }, { 0, 0, 0, 0 }, { instance.UVRect[0], instance.UVRect[1], 0, 1 } } };
+			constants.TextureTransform = Transpose(textureTransform);
+
+			commandList.SetConstants(ShaderStage::Vertex, constants);
+			commandList.Draw(6);
+		}
+	}
+
+	void RecordBatched(SpriteBatch& spriteBatch, MemoryTarget& target, const vector<Sprite>& sprites)
+	{
+		target.mDraws.clear();
+		spriteBatch.Begin(target);
+		for (const Sprite& sprite : sprites)
+		{
+			spriteBatch.Draw(sprite.Texture, MakeInstance(sprite));
+		}
+
+		spriteBatch.End();
+	}
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	// Every sprite must be drawn exactly once, in order, with its own instance data and texture.
+	bool Validate(const MemoryTarget& target, const vector<Sprite>& sprites, const vector<vector<SpriteInstance>>& snapshots)
+	{
+		bool passed = true;
+		size_t next = 0;
+		for (size_t d = 0; d < target.mDraws.size() && passed; ++d)
+		{
+			const MemoryTarget::Draw& draw = target.mDraws[d];
+			const vector<SpriteInstance>& ring = snapshots[d];
+			for (uint32_t i = 0; i < draw.InstanceCount && passed; ++i, ++next)
+			{
+				const SpriteInstance expected = MakeInstance(sprites[next]);
+				const SpriteInstance& actual = ring[draw.FirstInstance + i];
+				passed &= Check(draw.Texture == sprites[next].Texture, "batch texture");
+				passed &= Check(actual.Position[0] == expected.Position[0] && actual.Position[1] == expected.Position[1] &&
+					actual.UVRect[0] == expected.UVRect[0] && actual.UVRect[3] == expected.UVRect[3], "instance data");
+			}
+		}
+
+		passed &= Check(next == sprites.size(), "every sprite drawn once");
+		return passed;
+	}
+
+	// Wraps a MemoryTarget and snapshots the ring at each draw, since later maps may overwrite it.
+	class SnapshotTarget final : public SpriteBatchTarget
+	{
+	public:
+		explicit SnapshotTarget(MemoryTarget& target) :
+			mTarget(target)
+		{
+		}
+
+		virtual SpriteInstance* Map(uint32_t& capacity, uint32_t& firstInstance) override
+		{
+			return mTarget.Map(capacity, firstInstance);
+		}
+
+		virtual void Unmap(uint32_t instanceCount) override
+		{
+			mTarget.Unmap(instanceCount);
+		}
+
+		virtual void DrawBatch(SpriteTextureHandle texture, uint32_t firstInstance, uint32_t instanceCount) override
+		{
+			mTarget.DrawBatch(texture, firstInstance, instanceCount);
+			mSnapshots.push_back(mTarget.mRing);
+		}
+
+		MemoryTarget& mTarget;
+		vector<vector<SpriteInstance>> mSnapshots;
+	};
+
+	template <typename Function>
+	double NanosecondsPerFrame(Function function, uint32_t spriteCount)
+	{
+		// Enough frames for about four million sprites, and at least three.
+		const uint32_t frameCount = (spriteCount >= 4 * 1024 * 1024 / 3 ? 3 : 4 * 1024 * 1024 / spriteCount);
+		function();
+
+		const auto start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			function();
+		}
+
+		return chrono::duration<double>(chrono::steady_clock::now() - start).count() / frameCount * 1.0e9;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	vector<uint32_t> spriteCounts;
+	for (int i = 1; i < argc; ++i)
+	{
+		spriteCounts.push_back(static_cast<uint32_t>(strtoul(argv[i], nullptr, 10)));
+	}
+
+	if (spriteCounts.empty())
+	{
+		spriteCounts = { 8, 64, 1024, 16384, 262144, 1048576 };
+	}
+
+	const Matrix viewProjection = { { { 0.02f, 0, 0, 0 }, { 0, 0.02f, 0, 0 }, { 0, 0, 0.001f, 0 }, { 0, -0.5f, 0.5f, 1 } } };
+
+	printf("Times are CPU ns per frame; batch ring of %u instances (%zu bytes each)\n\n", RingCapacity, sizeof(SpriteInstance));
+	printf("%9s  %9s %14s %12s  %9s %12s %10s %8s\n", "sprites", "draws", "per-sprite ns", "ns/sprite", "draws", "batched ns", "ns/sprite", "speedup");
+
+	bool passed = true;
+	for (uint32_t spriteCount : spriteCounts)
+	{
+		if (spriteCount == 0)
+		{
+			continue;
+		}
+
+		const vector<Sprite> sprites = CreateGrid(spriteCount, 1);
+
+		RenderCommandList commandList;
+		RecordingRenderBackend backend;
+		const double perSprite = NanosecondsPerFrame([&]() { RecordPerSprite(commandList, sprites, viewProjection); backend.Execute(commandList); }, spriteCount);
+		const uint64_t perSpriteDraws = backend.LastExecution().Draws;
+
+		SpriteBatch spriteBatch;
+		MemoryTarget target(RingCapacity);
+		const double batched = NanosecondsPerFrame([&]() { RecordBatched(spriteBatch, target, sprites); }, spriteCount);
+		const uint64_t batchedDraws = spriteBatch.LastStatistics().Draws;
+
+		passed &= Check(perSpriteDraws == spriteCount, "per-sprite path draws every sprite");
+		passed &= Check(spriteBatch.LastStatistics().Sprites == spriteCount, "batch counts every sprite");
+
+		// A single texture only splits where the ring fills or wraps.
+		passed &= Check(batchedDraws <= (spriteCount + RingCapacity - 1) / RingCapacity + 1, "single-texture batch draws");
+
+		printf("%9u  %9llu %14.0f %12.1f  %9llu %12.0f %10.2f %7.1fx\n", spriteCount, static_cast<unsigned long long>(perSpriteDraws), perSprite,
+			perSprite / spriteCount, static_cast<unsigned long long>(batchedDraws), batched, batched / spriteCount, perSprite / batched);
+	}
+
+	// Correctness, with four textures so batches also split on texture changes.
+	for (uint32_t spriteCount : { 8u, 1000u, RingCapacity + 1000u, 3 * RingCapacity })
+	{
+		const vector<Sprite> sprites = CreateGrid(spriteCount, 4);
+		SpriteBatch spriteBatch;
+		MemoryTarget memory(RingCapacity);
+		SnapshotTarget target(memory);
+
+		// Two frames, so the second starts partway through the ring.
+		for (int frame = 0; frame < 2 && passed; ++frame)
+		{
+			memory.mDraws.clear();
+			target.mSnapshots.clear();
+			spriteBatch.Begin(target);
+			for (const Sprite& sprite : sprites)
+			{
+				spriteBatch.Draw(sprite.Texture, MakeInstance(sprite));
+			}
+
+			spriteBatch.End();
+			passed &= Validate(memory, sprites, target.mSnapshots);
+			passed &= Check(spriteBatch.LastStatistics().Draws >= 4 && spriteBatch.LastStatistics().Draws <= 4 + 2 * (spriteCount / RingCapacity + 1), "grouped texture batch draws");
+		}
+	}
+
+	printf("\n%s\n", (passed ? "checks passed" : "checks FAILED"));
+	return (passed ? 0 : 1);
+}
@@ -0,0 +1,431 @@
+// Converts PNG textures to DDS files with a full mip chain, block compressed to BC1 or BC3, so the game uploads them
+// as they are instead of decoding PNGs at startup: a BC3 texture with mips takes a third more memory than its top level
+// alone in BC3, and a quarter of the memory of R8G8B8A8 without mips. Mips are filtered in linear light with
+// TextureProcessor; the DDS files are written with DdsTexture, which the game reads them with. The game's sprite atlas
+// is converted with:
+//   TextureConverter ../../Game.Universal/Content/Textures/snoods_atlas.png ../../Game.Universal/Content/Textures/snoods_atlas.dds
+//
+// With --benchmark, converts a generated test image (and the sprite atlas, when run from this directory) and reports
+// throughput and PSNR against the source. The checks:
+//   - mip chains run down to 1 x 1, for odd and non-square sizes too;
+//   - filtering is in linear light: black and white average to sRGB 188, not 128; transparent texels don't tint their
+//     neighbors; a constant image stays constant;
+//   - blocks of one or two representable colors and alphas round-trip exactly, and BC1 keeps transparent texels;
+//   - the output doesn't depend on the thread count;
+//   - DDS files round-trip through DdsTexture, and truncated ones are refused.
+//
+// Needs libpng, e.g. from this directory on Linux:
+//   g++ -O3 -std=c++14 -pthread -I../../Library.Shared TextureConverter.cpp ../../Library.Shared/TextureProcessor.cpp ../../Library.Shared/DdsTexture.cpp -lpng
+//
+// Usage: TextureConverter [--format bc1|bc3|rgba] [--linear] [--no-mips] [--threads N] input.png output.dds
+//        TextureConverter --benchmark [image size]
+// Defaults to BC3, sRGB filtering, a full mip chain and one thread per hardware thread; the benchmark image is 2048 x 2048.
+
+#include "DdsTexture.h"
+#include "TextureProcessor.h"
+#include <png.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	const char* const SpriteAtlasPath = "../../Game.Universal/Content/Textures/snoods_atlas.png";
+
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	bool ReadPng(const string& path, TextureProcessor::Image& image)
+	{
+		png_image png;
+		memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+		if (!png_image_begin_read_from_file(&png, path.c_str()))
+		{
+			return false;
+		}
+
+		png.format = PNG_FORMAT_RGBA;
+		image.Width = png.width;
+		image.Height = png.height;
+		image.Pixels.resize(PNG_IMAGE_SIZE(png));
+		if (!png_image_finish_read(&png, nullptr, image.Pixels.data(), 0, nullptr))
+		{
+			png_image_free(&png);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool WriteFile(const string& path, const vector<uint8_t>& data)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const bool written = (fwrite(data.data(), 1, data.size(), file) == data.size());
+		return (fclose(file) == 0 && written);
+	}
+
+	// Compresses (or copies) every level in the format, for DdsTexture::Serialize.
+	void EncodeMips(const vector<TextureProcessor::Image>& mips, uint32_t format, uint32_t threadCount, vector<vector<uint8_t>>& encoded)
+	{
+		encoded.assign(mips.size(), vector<uint8_t>());
+		for (size_t i = 0; i < mips.size(); ++i)
+		{
+			if (format == DdsTexture::BC1UNorm)
+			{
+				TextureProcessor::CompressBC1(mips[i], encoded[i], threadCount);
+			}
+			else if (format == DdsTexture::BC3UNorm)
+			{
+				TextureProcessor::CompressBC3(mips[i], encoded[i], threadCount);
+			}
+			else
+			{
+				encoded[i] = mips[i].Pixels;
+			}
+		}
+	}
+
+	int Convert(const string& input, const string& output, uint32_t format, bool srgb, bool mipChain, uint32_t threadCount)
+	{
+		TextureProcessor::Image source;
+		if (!ReadPng(input, source))
+		{
+			printf("Can't read %s\n", input.c_str());
+			return 1;
+		}
+
+		const auto start = chrono::steady_clock::now();
+		vector<TextureProcessor::Image> mips;
+		TextureProcessor::GenerateMips(source.Pixels.data(), source.Width, source.Height, srgb, mips);
+		if (!mipChain)
+		{
+			mips.resize(1);
+		}
+
+		vector<vector<uint8_t>> encoded;
+		EncodeMips(mips, format, threadCount, encoded);
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		const vector<uint8_t> file = DdsTexture::Serialize(format, source.Width, source.Height, encoded);
+		if (!WriteFile(output, file))
+		{
+			printf("Can't write %s\n", output.c_str());
+			return 1;
+		}
+
+		TextureProcessor::Image decoded = source;
+		if (format == DdsTexture::BC1UNorm)
+		{
+			TextureProcessor::DecompressBC1(encoded[0].data(), source.Width, source.Height, decoded);
+		}
+		else if (format == DdsTexture::BC3UNorm)
+		{
+			TextureProcessor::DecompressBC3(encoded[0].data(), source.Width, source.Height, decoded);
+		}
+
+		printf("%s: %u x %u, %zu levels, %zu bytes (%.1f%% of R8G8B8A8 without mips), converted in %.1f ms, PSNR %.2f dB color, %.2f dB alpha\n",
+			output.c_str(), source.Width, source.Height, mips.size(), file.size(), 100.0 * static_cast<double>(file.size()) / static_cast<double>(source.Pixels.size()),
+			seconds * 1.0e3, TextureProcessor::Psnr(source, decoded, false), TextureProcessor::Psnr(source, decoded, true));
+		return 0;
+	}
+
+	// Smooth gradients with noise, and soft-edged shapes in alpha, like sprite art.
+	TextureProcessor::Image TestImage(uint32_t size)
+	{
+		TextureProcessor::Image image = { size, size, vector<uint8_t>(static_cast<size_t>(size) * size * 4) };
+		mt19937 random(3);
+		uniform_int_distribution<int32_t> noise(-6, 6);
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				uint8_t* pixel = &image.Pixels[(static_cast<size_t>(y) * size + x) * 4];
+				const float u = static_cast<float>(x) / static_cast<float>(size);
+				const float v = static_cast<float>(y) / static_cast<float>(size);
+				const float cellU = fmod(u * 8.0f, 1.0f) - 0.5f;
+				const float cellV = fmod(v * 8.0f, 1.0f) - 0.5f;
+				const float distance = sqrt(cellU * cellU + cellV * cellV);
+				pixel[0] = static_cast<uint8_t>(min(max(static_cast<int32_t>(u * 255.0f) + noise(random), 0), 255));
+				pixel[1] = static_cast<uint8_t>(min(max(static_cast<int32_t>(v * 200.0f) + noise(random), 0), 255));
+				pixel[2] = static_cast<uint8_t>(min(max(static_cast<int32_t>((1.0f - distance) * 180.0f) + noise(random), 0), 255));
+				pixel[3] = static_cast<uint8_t>(min(max((0.45f - distance) * 2000.0f, 0.0f), 255.0f));
+			}
+		}
+
+		return image;
+	}
+
+	TextureProcessor::Image SolidImage(uint32_t width, uint32_t height, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+	{
+		TextureProcessor::Image image = { width, height, vector<uint8_t>(static_cast<size_t>(width) * height * 4) };
+		for (size_t i = 0; i < image.Pixels.size(); i += 4)
+		{
+			image.Pixels[i] = r;
+			image.Pixels[i + 1] = g;
+			image.Pixels[i + 2] = b;
+			image.Pixels[i + 3] = a;
+		}
+
+		return image;
+	}
+
+	bool Checks()
+	{
+		bool passed = true;
+
+		vector<TextureProcessor::Image> mips;
+		TextureProcessor::Image odd = SolidImage(37, 5, 10, 200, 30, 77);
+		TextureProcessor::GenerateMips(odd.Pixels.data(), odd.Width, odd.Height, true, mips);
+		bool constant = true;
+		for (const TextureProcessor::Image& mip : mips)
+		{
+			for (size_t i = 0; i < mip.Pixels.size(); i += 4)
+			{
+				constant &= (mip.Pixels[i] == 10 && mip.Pixels[i + 1] == 200 && mip.Pixels[i + 2] == 30 && mip.Pixels[i + 3] == 77);
+			}
+		}
+
+		passed &= Check(mips.size() == 6 && mips.back().Width == 1 && mips.back().Height == 1 && mips[1].Width == 18 && mips[1].Height == 2, "an odd, non-square chain runs down to 1 x 1");
+		passed &= Check(constant, "a constant image stays constant");
+
+		// Black and white in a checkerboard average to half the light, which is 188 in sRGB.
+		TextureProcessor::Image checker = SolidImage(2, 2, 0, 0, 0, 255);
+		memset(&checker.Pixels[4], 255, 3);
+		memset(&checker.Pixels[8], 255, 3);
+		TextureProcessor::GenerateMips(checker.Pixels.data(), 2, 2, true, mips);
+		passed &= Check(mips[1].Pixels[0] == 188 && mips[1].Pixels[3] == 255, "sRGB black and white average in linear light");
+		TextureProcessor::GenerateMips(checker.Pixels.data(), 2, 2, false, mips);
+		passed &= Check(mips[1].Pixels[0] == 128, "linear black and white average as they are");
+
+		// One opaque red texel among transparent green ones: the average is red, a quarter opaque.
+		TextureProcessor::Image edge = SolidImage(2, 2, 0, 255, 0, 0);
+		edge.Pixels[0] = 255;
+		edge.Pixels[1] = 0;
+		edge.Pixels[3] = 255;
+		TextureProcessor::GenerateMips(edge.Pixels.data(), 2, 2, true, mips);
+		passed &= Check(mips[1].Pixels[0] >= 250 && mips[1].Pixels[1] <= 8 && mips[1].Pixels[3] == 64, "transparent texels don't tint opaque ones");
+
+		// Two representable colors and two alphas in a block round-trip exactly.
+		TextureProcessor::Image twoColors = SolidImage(8, 4, 255, 0, 0, 255);
+		for (uint32_t i = 0; i < 32; i += 3)
+		{
+			twoColors.Pixels[i * 4] = 0;
+			twoColors.Pixels[i * 4 + 2] = 255;
+			twoColors.Pixels[i * 4 + 3] = 20;
+		}
+
+		vector<uint8_t> blocks;
+		TextureProcessor::Image decoded;
+		TextureProcessor::CompressBC3(twoColors, blocks, 1);
+		TextureProcessor::DecompressBC3(blocks.data(), twoColors.Width, twoColors.Height, decoded);
+		passed &= Check(blocks.size() == 32 && decoded.Pixels == twoColors.Pixels, "two colors and two alphas round-trip through BC3");
+
+		for (uint32_t i = 0; i < 32; i += 3)
+		{
+			twoColors.Pixels[i * 4] = 0;
+			twoColors.Pixels[i * 4 + 1] = 0;
+			twoColors.Pixels[i * 4 + 2] = 0;
+			twoColors.Pixels[i * 4 + 3] = 0;
+		}
+
+		TextureProcessor::CompressBC1(twoColors, blocks, 1);
+		TextureProcessor::DecompressBC1(blocks.data(), twoColors.Width, twoColors.Height, decoded);
+		passed &= Check(blocks.size() == 16 && decoded.Pixels == twoColors.Pixels, "BC1 keeps transparent texels");
+
+		TextureProcessor::Image partial = SolidImage(6, 3, 0, 255, 255, 255);
+		TextureProcessor::CompressBC1(partial, blocks, 1);
+		TextureProcessor::DecompressBC1(blocks.data(), partial.Width, partial.Height, decoded);
+		passed &= Check(blocks.size() == 16 && decoded.Pixels == partial.Pixels, "partial blocks at the edges");
+
+		// DDS round trip of a BC3 chain, and a truncated file.
+		TextureProcessor::Image image = TestImage(64);
+		TextureProcessor::GenerateMips(image.Pixels.data(), image.Width, image.Height, true, mips);
+		vector<vector<uint8_t>> encoded;
+		EncodeMips(mips, DdsTexture::BC3UNorm, 1, encoded);
+		vector<uint8_t> file = DdsTexture::Serialize(DdsTexture::BC3UNorm, image.Width, image.Height, encoded);
+		DdsTexture::Description description;
+		bool roundTrip = DdsTexture::Parse(file.data(), file.size(), description) && description.Format == DdsTexture::BC3UNorm && description.Mips.size() == mips.size();
+		for (size_t i = 0; i < mips.size() && roundTrip; ++i)
+		{
+			const DdsTexture::MipLevel& level = description.Mips[i];
+			roundTrip = (level.Width == mips[i].Width && level.Height == mips[i].Height && level.SlicePitch == encoded[i].size() &&
+				memcmp(file.data() + level.Offset, encoded[i].data(), level.SlicePitch) == 0);
+		}
+
+		passed &= Check(roundTrip && description.Mips.back().Offset + description.Mips.back().SlicePitch == file.size(), "DDS files round-trip");
+		passed &= Check(!DdsTexture::Parse(file.data(), file.size() - 1, description) && !DdsTexture::Parse(file.data(), 100, description), "truncated DDS files are refused");
+
+		return passed;
+	}
+
+	void Benchmark(const string& name, const TextureProcessor::Image& source, bool& passed, double minimumColorPsnr, double minimumAlphaPsnr)
+	{
+		const uint32_t hardwareThreads = max(thread::hardware_concurrency(), 1u);
+		const double megapixels = static_cast<double>(source.Width) * source.Height / 1.0e6;
+		const uint32_t runs = 3;
+
+		vector<TextureProcessor::Image> mips;
+		auto start = chrono::steady_clock::now();
+		for (uint32_t run = 0; run < runs; ++run)
+		{
+			TextureProcessor::GenerateMips(source.Pixels.data(), source.Width, source.Height, true, mips);
+		}
+
+		const double mipSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / runs;
+		printf("%s, %u x %u: mips %.1f MPix/s\n", name.c_str(), source.Width, source.Height, megapixels / mipSeconds);
+
+		const char* formatNames[2] = { "BC1", "BC3" };
+		for (uint32_t f = 0; f < 2; ++f)
+		{
+			vector<uint8_t> blocks;
+			vector<uint8_t> threadedBlocks;
+			double seconds[2] = {};
+			const uint32_t threadCounts[2] = { 1, hardwareThreads };
+			for (uint32_t t = 0; t < 2; ++t)
+			{
+				start = chrono::steady_clock::now();
+				for (uint32_t run = 0; run < runs; ++run)
+				{
+					if (f == 0)
+					{
+						TextureProcessor::CompressBC1(source, (t == 0 ? blocks : threadedBlocks), threadCounts[t]);
+					}
+					else
+					{
+						TextureProcessor::CompressBC3(source, (t == 0 ? blocks : threadedBlocks), threadCounts[t]);
+					}
+				}
+
+				seconds[t] = chrono::duration<double>(chrono::steady_clock::now() - start).count() / runs;
+			}
+
+			vector<uint8_t> manyThreadBlocks;
+			if (f == 0)
+			{
+				TextureProcessor::CompressBC1(source, manyThreadBlocks, 7);
+			}
+			else
+			{
+				TextureProcessor::CompressBC3(source, manyThreadBlocks, 7);
+			}
+
+			passed &= Check(blocks == threadedBlocks && blocks == manyThreadBlocks, "the output doesn't depend on the thread count");
+
+			TextureProcessor::Image decoded;
+			if (f == 0)
+			{
+				TextureProcessor::DecompressBC1(blocks.data(), source.Width, source.Height, decoded);
+			}
+			else
+			{
+				TextureProcessor::DecompressBC3(blocks.data(), source.Width, source.Height, decoded);
+			}
+
+			const double colorPsnr = TextureProcessor::Psnr(source, decoded, false);
+			const double alphaPsnr = TextureProcessor::Psnr(source, decoded, true);
+			// BC1's one-bit alpha can't follow soft edges, so only BC3 is held to a quality bar.
+			passed &= Check(f == 0 || colorPsnr >= minimumColorPsnr, "BC3 color PSNR");
+			passed &= Check(f == 0 || alphaPsnr >= minimumAlphaPsnr, "BC3 alpha PSNR");
+			printf("  %s: %.1f MPix/s on 1 thread, %.1f MPix/s on %u, PSNR %.2f dB color, %.2f dB alpha\n", formatNames[f], megapixels / seconds[0],
+				megapixels / seconds[1], hardwareThreads, colorPsnr, alphaPsnr);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+	{
+		const uint32_t size = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 2048);
+		bool passed = Checks();
+		Benchmark("test image", TestImage(size), passed, 36.0, 36.0);
+
+		TextureProcessor::Image atlas;
+		if (access(SpriteAtlasPath, R_OK) == 0 && ReadPng(SpriteAtlasPath, atlas))
+		{
+			Benchmark("sprite atlas", atlas, passed, 28.0, 40.0);
+		}
+
+		printf("%s\n", (passed ? "checks passed" : "checks FAILED"));
+		return (passed ? 0 : 1);
+	}
+
+	uint32_t format = DdsTexture::BC3UNorm;
+	bool srgb = true;
+	bool mipChain = true;
+	uint32_t threadCount = 0;
+	int argument = 1;
+	for (; argument < argc && strncmp(argv[argument], "--", 2) == 0; ++argument)
+	{
+		if (strcmp(argv[argument], "--linear") == 0)
+		{
+			srgb = false;
+		}
+		else if (strcmp(argv[argument], "--no-mips") == 0)
+		{
+			mipChain = false;
+		}
+		else if (strcmp(argv[argument], "--threads") == 0 && argument + 1 < argc)
+		{
+			threadCount = static_cast<uint32_t>(strtoul(argv[++argument], nullptr, 10));
+		}
+		else if (strcmp(argv[argument], "--format") == 0 && argument + 1 < argc)
+		{
+			const string name = argv[++argument];
+			if (name == "bc1")
+			{
+				format = DdsTexture::BC1UNorm;
+			}
+			else if (name == "bc3")
+			{
+				format = DdsTexture::BC3UNorm;
+			}
+			else if (name == "rgba")
+			{
+				format = DdsTexture::R8G8B8A8UNorm;
+			}
+			else
+			{
+				printf("Unknown format %s\n", name.c_str());
+				return 1;
+			}
+		}
+		else
+		{
+			printf("Unknown option %s\n", argv[argument]);
+			return 1;
+		}
+	}
+
+	if (argc - argument != 2)
+	{
+		printf("Usage: TextureConverter [--format bc1|bc3|rgba] [--linear] [--no-mips] [--threads N] input.png output.dds\n       TextureConverter --benchmark [image size]\n");
+		return 1;
+	}
+
+	return Convert(argv[argument], argv[argument + 1], format, srgb, mipChain, threadCount);
+}
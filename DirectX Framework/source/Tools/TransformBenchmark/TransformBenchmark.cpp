@@ -0,0 +1,266 @@
+// Measures what the shape managers' per-object matrices cost per frame, and checks Transform2D's cached world matrices.
+// Each object's constants are computed the way the managers do: scaling by the radius * world * view-projection. The
+// per-frame cost is measured for:
+//   - recomputing every world matrix and multiplying the camera's view and projection for every object, as before;
+//   - cached matrices with nothing moved;
+//   - everything moved, with each world matrix recomputed when it's read;
+//   - everything moved, or a tenth of it, with Transform2D::UpdateWorldMatrices recomputing the dirty ones first.
+// The checks:
+//   - a cached world matrix matches scaling * rotation * translation;
+//   - the setters mark the matrix dirty, and reading it or a batch update clears that;
+//   - a batch update recomputes exactly the dirty transforms, including a partial batch of fewer than four, and gives
+//     the same matrices, bit for bit, as reading them one at a time, whether it is given the transforms or pointers to
+//     them as the managers hold them.
+//
+// Standalone; builds with any C++14 compiler that has DirectXMath (header-only; it ships with the Windows SDK, and its
+// open-source release also builds with GCC and Clang given a sal.h), e.g. from this directory:
+//   cl /O2 /EHsc /I..\..\Library.Shared TransformBenchmark.cpp ..\..\Library.Shared\Transform2D.cpp
+//   g++ -O3 -std=c++14 -I<DirectXMath>/Inc -I../../Library.Shared TransformBenchmark.cpp ../../Library.Shared/Transform2D.cpp
+//
+// Usage: TransformBenchmark [objects] [frames]
+// Defaults to 100000 objects and 100 frames.
+//
+// Results: none recorded yet. The per-frame matrix cost at 100000 objects, cached against recomputed, still has to be
+// measured with the real DirectXMath and written here; until then the caching is unbenchmarked.
+
+#include "Transform2D.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+using namespace DX;
+
+namespace
+{
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	float LargestDifference(CXMMATRIX left, CXMMATRIX right)
+	{
+		XMFLOAT4X4 a;
+		XMFLOAT4X4 b;
+		XMStoreFloat4x4(&a, left);
+		XMStoreFloat4x4(&b, right);
+
+		float difference = 0.0f;
+		for (uint32_t row = 0; row < 4; ++row)
+		{
+			for (uint32_t column = 0; column < 4; ++column)
+			{
+				difference = fmax(difference, fabs(a.m[row][column] - b.m[row][column]));
+			}
+		}
+
+		return difference;
+	}
+
+	XMMATRIX ReferenceWorldMatrix(const Transform2D& transform)
+	{
+		return transform.ScalingMatrix() * transform.RotationMatrix() * transform.TranslationMatrix();
+	}
+
+	// Stands in for the camera: an orthographic projection of a 100 x 100 view one unit behind the field.
+	struct CameraMatrices
+	{
+		XMFLOAT4X4 View;
+		XMFLOAT4X4 Projection;
+		XMFLOAT4X4 ViewProjection;
+	};
+
+	// What the managers upload per object. The sum keeps the compiler from dropping the work.
+	float StoreConstants(CXMMATRIX world, float radius, CXMMATRIX viewProjection, XMFLOAT4X4& wvp)
+	{
+		XMStoreFloat4x4(&wvp, XMMatrixTranspose(XMMatrixScaling(radius, radius, radius) * world * viewProjection));
+		return wvp._11 + wvp._44;
+	}
+
+	void Move(vector<Transform2D>& transforms, uint32_t frame, uint32_t stride)
+	{
+		for (size_t i = 0; i < transforms.size(); i += stride)
+		{
+			XMFLOAT2 position = transforms[i].Position();
+			position.x += (frame & 1 ? 0.01f : -0.01f);
+			transforms[i].SetPosition(position);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t objectCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 100000);
+	const uint32_t frameCount = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 100);
+
+	mt19937 random(42);
+	uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+	uniform_real_distribution<float> angle(-XM_2PI, XM_2PI);
+	uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+	vector<Transform2D> transforms;
+	vector<float> radii;
+	transforms.reserve(objectCount);
+	radii.reserve(objectCount);
+	for (uint32_t i = 0; i < objectCount; ++i)
+	{
+		transforms.emplace_back(XMFLOAT2(coordinate(random), coordinate(random)), angle(random), XMFLOAT2(scale(random), scale(random)));
+		radii.push_back(scale(random));
+	}
+
+	CameraMatrices camera;
+	XMStoreFloat4x4(&camera.View, XMMatrixTranslation(0.0f, 0.0f, -1.0f));
+	XMStoreFloat4x4(&camera.Projection, XMMatrixScaling(0.02f, 0.02f, -0.0001f));
+	XMStoreFloat4x4(&camera.ViewProjection, XMLoadFloat4x4(&camera.View) * XMLoadFloat4x4(&camera.Projection));
+
+	// Correctness.
+	bool passed = true;
+	float largestDifference = 0.0f;
+	for (const Transform2D& transform : transforms)
+	{
+		passed &= Check(!transform.WorldMatrixDirty(), "a new transform's world matrix is computed");
+		largestDifference = fmax(largestDifference, LargestDifference(transform.WorldMatrix(), ReferenceWorldMatrix(transform)));
+	}
+
+	passed &= Check(largestDifference < 1.0e-4f, "cached world matrices match scaling * rotation * translation");
+
+	{
+		Transform2D transform(XMFLOAT2(1.0f, 2.0f), 0.5f, XMFLOAT2(2.0f, 3.0f));
+		transform.SetPosition(4.0f, 5.0f);
+		passed &= Check(transform.WorldMatrixDirty(), "SetPosition marks the world matrix dirty");
+		passed &= Check(LargestDifference(transform.WorldMatrix(), ReferenceWorldMatrix(transform)) < 1.0e-4f && !transform.WorldMatrixDirty(),
+			"reading the world matrix recomputes it");
+		transform.SetRotation(1.5f);
+		passed &= Check(transform.WorldMatrixDirty(), "SetRotation marks the world matrix dirty");
+		passed &= Check(LargestDifference(transform.WorldMatrix(), ReferenceWorldMatrix(transform)) < 1.0e-4f, "rotation is applied");
+		transform.SetScale(XMFLOAT2(0.5f, 7.0f));
+		passed &= Check(transform.WorldMatrixDirty(), "SetScale marks the world matrix dirty");
+		passed &= Check(LargestDifference(transform.WorldMatrix(), ReferenceWorldMatrix(transform)) < 1.0e-4f, "scale is applied");
+		passed &= Check(LargestDifference(Transform2D::Identity.WorldMatrix(), ReferenceWorldMatrix(Transform2D::Identity)) == 0.0f, "the identity transform");
+	}
+
+	// Dirty every third transform, recompute them in batches (the last one partial) and compare against reading them
+	// one at a time.
+	{
+		vector<Transform2D> batched(transforms.begin(), transforms.begin() + (objectCount < 1003 ? objectCount : 1003));
+		size_t dirtyCount = 0;
+		for (size_t i = 0; i < batched.size(); i += 3)
+		{
+			batched[i].SetRotation(batched[i].Rotation() + 0.25f);
+			++dirtyCount;
+		}
+
+		vector<Transform2D> single(batched);
+		vector<Transform2D> pointed(batched);
+		const size_t updated = Transform2D::UpdateWorldMatrices(batched.data(), batched.size());
+		passed &= Check(updated == dirtyCount, "a batch update recomputes exactly the dirty transforms");
+		passed &= Check(Transform2D::UpdateWorldMatrices(batched.data(), batched.size()) == 0, "a second batch update has nothing to do");
+
+		vector<const Transform2D*> pointers;
+		for (const Transform2D& transform : pointed)
+		{
+			pointers.push_back(&transform);
+		}
+
+		passed &= Check(Transform2D::UpdateWorldMatrices(pointers.data(), pointers.size()) == dirtyCount, "a batch update through pointers recomputes the dirty transforms");
+
+		bool identical = true;
+		for (size_t i = 0; i < batched.size(); ++i)
+		{
+			identical &= (!batched[i].WorldMatrixDirty() && !pointed[i].WorldMatrixDirty());
+			const XMMATRIX left = batched[i].WorldMatrix();
+			const XMMATRIX right = single[i].WorldMatrix();
+			XMFLOAT4X4 a;
+			XMFLOAT4X4 b;
+			XMFLOAT4X4 c;
+			XMStoreFloat4x4(&a, left);
+			XMStoreFloat4x4(&b, right);
+			XMStoreFloat4x4(&c, pointed[i].WorldMatrix());
+			identical &= (memcmp(&a, &b, sizeof(a)) == 0 && memcmp(&a, &c, sizeof(a)) == 0);
+		}
+
+		passed &= Check(identical, "batched and single world matrices are identical");
+	}
+
+	// Timing.
+	XMFLOAT4X4 wvp;
+	float sink = 0.0f;
+	const double frames = static_cast<double>(frameCount > 0 ? frameCount : 1);
+
+	auto start = chrono::steady_clock::now();
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		Move(transforms, frame, 1);
+		for (size_t i = 0; i < transforms.size(); ++i)
+		{
+			const XMMATRIX viewProjection = XMMatrixMultiply(XMLoadFloat4x4(&camera.View), XMLoadFloat4x4(&camera.Projection));
+			sink += StoreConstants(ReferenceWorldMatrix(transforms[i]), radii[i], viewProjection, wvp);
+		}
+	}
+
+	const double uncachedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+	Transform2D::UpdateWorldMatrices(transforms.data(), transforms.size());
+
+	start = chrono::steady_clock::now();
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		for (size_t i = 0; i < transforms.size(); ++i)
+		{
+			sink += StoreConstants(transforms[i].WorldMatrix(), radii[i], XMLoadFloat4x4(&camera.ViewProjection), wvp);
+		}
+	}
+
+	const double staticSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+
+	start = chrono::steady_clock::now();
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		Move(transforms, frame, 1);
+		for (size_t i = 0; i < transforms.size(); ++i)
+		{
+			sink += StoreConstants(transforms[i].WorldMatrix(), radii[i], XMLoadFloat4x4(&camera.ViewProjection), wvp);
+		}
+	}
+
+	const double lazySeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+
+	double batchSeconds[2] = {};
+	const uint32_t strides[2] = { 1, 10 };
+	for (uint32_t pass = 0; pass < 2; ++pass)
+	{
+		start = chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			Move(transforms, frame, strides[pass]);
+			Transform2D::UpdateWorldMatrices(transforms.data(), transforms.size());
+			for (size_t i = 0; i < transforms.size(); ++i)
+			{
+				sink += StoreConstants(transforms[i].WorldMatrix(), radii[i], XMLoadFloat4x4(&camera.ViewProjection), wvp);
+			}
+		}
+
+		batchSeconds[pass] = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+	}
+
+	const double perObject = 1.0e9 / static_cast<double>(objectCount > 0 ? objectCount : 1);
+	printf("%u objects, %u frames (checksum %g)\n", objectCount, frameCount, static_cast<double>(sink));
+	printf("%-40s %10s %12s\n", "per frame", "ms", "ns/object");
+	printf("%-40s %10.3f %12.2f\n", "uncached (all moved)", uncachedSeconds * 1.0e3, uncachedSeconds * perObject);
+	printf("%-40s %10.3f %12.2f\n", "cached, none moved", staticSeconds * 1.0e3, staticSeconds * perObject);
+	printf("%-40s %10.3f %12.2f\n", "cached, all moved, recomputed on read", lazySeconds * 1.0e3, lazySeconds * perObject);
+	printf("%-40s %10.3f %12.2f\n", "cached, all moved, batch update", batchSeconds[0] * 1.0e3, batchSeconds[0] * perObject);
+	printf("%-40s %10.3f %12.2f\n", "cached, a tenth moved, batch update", batchSeconds[1] * 1.0e3, batchSeconds[1] * perObject);
+
+	printf("%s\n", (passed ? "checks passed" : "checks FAILED"));
+	return (passed ? 0 : 1);
+}
@@ -0,0 +1,190 @@
+// Measures the ViewCuller on a large world and checks it against testing every object. The world is a square field of
+// randomly placed and sized objects, like a large level of bricks or a sprite grid; a camera-sized view pans across it
+// at several zoom levels. The checks:
+//   - every cull returns exactly the objects a brute-force test of every object finds, each once;
+//   - views that miss the world, or cover all of it, return nothing or everything;
+//   - a grid of identical touching objects, as the brick wall and sprite grid are laid out, culls exactly;
+//   - the counters add up.
+//
+// Standalone; builds with any C++14 compiler, e.g. from this directory:
+//   g++ -O3 -std=c++14 -I../../Library.Shared ViewCullBenchmark.cpp ../../Library.Shared/ViewCuller.cpp
+//   cl /O2 /EHsc /I..\..\Library.Shared ViewCullBenchmark.cpp ..\..\Library.Shared\ViewCuller.cpp
+//
+// Usage: ViewCullBenchmark [objects] [views per zoom level]
+// Defaults to 1000000 objects and 200 views.
+
+#include "ViewCuller.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace DX;
+
+namespace
+{
+	bool Check(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAILED: %s\n", description);
+		}
+
+		return condition;
+	}
+
+	void CullBruteForce(const vector<CullBounds>& objects, const CullBounds& view, vector<uint32_t>& visible)
+	{
+		visible.clear();
+		for (uint32_t i = 0; i < objects.size(); ++i)
+		{
+			const CullBounds& object = objects[i];
+			if (object.Left <= view.Right && object.Right >= view.Left && object.Bottom <= view.Top && object.Top >= view.Bottom)
+			{
+				visible.push_back(i);
+			}
+		}
+	}
+
+	bool SameObjects(vector<uint32_t> culled, const vector<uint32_t>& expected)
+	{
+		sort(culled.begin(), culled.end());
+		return (culled == expected);
+	}
+
+	CullBounds View(float centerX, float centerY, float width, float height)
+	{
+		const CullBounds view = { centerX - width * 0.5f, centerY - height * 0.5f, centerX + width * 0.5f, centerY + height * 0.5f };
+		return view;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t objectCount = (argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 1000000);
+	const uint32_t viewCount = (argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 200);
+
+	// Objects of 1 to 20 units in a world sized for about one object per 100 square units.
+	const float worldSize = sqrt(static_cast<float>(objectCount) * 100.0f);
+	mt19937 random(7);
+	uniform_real_distribution<float> coordinate(-worldSize * 0.5f, worldSize * 0.5f);
+	uniform_real_distribution<float> size(1.0f, 20.0f);
+	vector<CullBounds> objects(objectCount);
+	for (CullBounds& object : objects)
+	{
+		object.Left = coordinate(random);
+		object.Bottom = coordinate(random);
+		object.Right = object.Left + size(random);
+		object.Top = object.Bottom + size(random);
+	}
+
+	ViewCuller culler;
+	auto start = chrono::steady_clock::now();
+	culler.Build(objects.data(), objectCount);
+	const double buildSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	bool passed = true;
+	vector<uint32_t> visible;
+	vector<uint32_t> expected;
+
+	// Views that pan across the world, at a camera's 100 wide and zoomed out to a tenth of the world and to all of its width.
+	const float viewSizes[3] = { 100.0f, worldSize * 0.1f, worldSize };
+	vector<CullBounds> views;
+	for (const float viewSize : viewSizes)
+	{
+		for (uint32_t i = 0; i < viewCount; ++i)
+		{
+			views.push_back(View(coordinate(random), coordinate(random), viewSize, viewSize * 0.5625f));
+		}
+	}
+
+	const uint32_t checkedViews = min<uint32_t>(viewCount, 20);
+	for (uint32_t level = 0; level < 3; ++level)
+	{
+		for (uint32_t i = 0; i < checkedViews; ++i)
+		{
+			const CullBounds& view = views[level * viewCount + i];
+			culler.Cull(view, visible);
+			CullBruteForce(objects, view, expected);
+			passed &= Check(SameObjects(visible, expected), "culled objects match a brute-force test");
+		}
+	}
+
+	culler.Cull(View(worldSize * 2.0f, 0.0f, 100.0f, 100.0f), visible);
+	passed &= Check(visible.empty(), "a view beside the world sees nothing");
+	culler.Cull(View(0.0f, 0.0f, worldSize * 2.0f, worldSize * 2.0f), visible);
+	passed &= Check(visible.size() == objectCount && culler.LastCull().ObjectsTested == 0, "a view around the world sees everything without testing objects");
+
+	{
+		// The brick wall's layout: touching 9 x 3 bricks. Views that end exactly on a brick's edge include it.
+		vector<CullBounds> bricks;
+		for (uint32_t row = 0; row < 40; ++row)
+		{
+			for (uint32_t column = 0; column < 50; ++column)
+			{
+				const float left = static_cast<float>(column) * 9.0f;
+				const float bottom = static_cast<float>(row) * 3.0f;
+				const CullBounds brick = { left, bottom, left + 9.0f, bottom + 3.0f };
+				bricks.push_back(brick);
+			}
+		}
+
+		ViewCuller brickCuller(8);
+		brickCuller.Build(bricks.data(), static_cast<uint32_t>(bricks.size()));
+		const CullBounds brickViews[4] = { { 18.0f, 6.0f, 36.0f, 12.0f }, { 100.0f, 50.0f, 200.0f, 90.0f }, { -5.0f, -5.0f, 0.0f, 0.0f }, { 449.5f, 119.5f, 500.0f, 200.0f } };
+		for (const CullBounds& view : brickViews)
+		{
+			brickCuller.Cull(view, visible);
+			CullBruteForce(bricks, view, expected);
+			passed &= Check(SameObjects(visible, expected), "a brick wall culls exactly");
+		}
+
+		const CullBounds lineBounds[3] = { { 0.0f, 0.0f, 1.0f, 1.0f }, { 0.0f, 5.0f, 1.0f, 6.0f }, { 0.0f, 10.0f, 1.0f, 11.0f } };
+		ViewCuller lineCuller;
+		lineCuller.Build(lineBounds, 3);
+		lineCuller.Cull(CullBounds{ 0.5f, 4.0f, 2.0f, 7.0f }, visible);
+		passed &= Check(visible.size() == 1 && visible[0] == 1, "objects in a single column cull");
+	}
+
+	// Timing.
+	culler.ResetCounters();
+	printf("%u objects in %u cells, built in %.2f ms\n", objectCount, culler.CellCount(), buildSeconds * 1.0e3);
+	printf("%-22s %10s %12s %14s %12s %16s\n", "view", "visible", "cull us", "ns/object", "brute us", "objects tested");
+	const char* names[3] = { "camera (100 x 56)", "tenth of the world", "world-sized" };
+	for (uint32_t level = 0; level < 3; ++level)
+	{
+		const ViewCuller::Counters before = culler.Totals();
+		start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < viewCount; ++i)
+		{
+			culler.Cull(views[level * viewCount + i], visible);
+		}
+
+		const double cullSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / viewCount;
+		const ViewCuller::Counters& after = culler.Totals();
+		const double visibleMean = static_cast<double>(after.Visible - before.Visible) / viewCount;
+		const double testedMean = static_cast<double>(after.ObjectsTested - before.ObjectsTested) / viewCount;
+
+		const uint32_t bruteViews = min<uint32_t>(viewCount, 10);
+		start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < bruteViews; ++i)
+		{
+			CullBruteForce(objects, views[level * viewCount + i], expected);
+		}
+
+		const double bruteSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / bruteViews;
+		printf("%-22s %10.0f %12.1f %14.3f %12.1f %16.0f\n", names[level], visibleMean, cullSeconds * 1.0e6, cullSeconds * 1.0e9 / objectCount,
+			bruteSeconds * 1.0e6, testedMean);
+	}
+
+	const ViewCuller::Counters& totals = culler.Totals();
+	passed &= Check(totals.Culls == 3ull * viewCount && totals.Objects == totals.Culls * objectCount, "cull counters");
+	passed &= Check(totals.CellsInside <= totals.CellsTested && totals.ObjectsTested <= totals.Objects, "cell counters");
+	printf("visible/total %.4f%%\n", 100.0 * static_cast<double>(totals.Visible) / static_cast<double>(totals.Objects > 0 ? totals.Objects : 1));
+
+	printf("%s\n", (passed ? "checks passed" : "checks FAILED"));
+	return (passed ? 0 : 1);
+}